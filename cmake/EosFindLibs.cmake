@@ -53,6 +53,7 @@ if(NOT PACKAGEONLY)
   find_package(isal_crypto)
   find_package(isal)
   find_package(xxhash)
+  find_package(uring)
   find_package(libbfd)
   find_package(richacl)
   find_package(davix)
@@ -154,4 +155,5 @@ else()
   add_library(ISAL::ISAL                   STATIC IMPORTED)
   add_library(ISAL::ISAL_CRYPTO            STATIC IMPORTED)
   add_library(XXHASH::XXHASH               STATIC IMPORTED)
+  add_library(URING::URING                 INTERFACE IMPORTED)
 endif()
@@ -49,6 +49,7 @@ message(STATUS "grpc-build    : ${GRPC_FOUND}")
 message(STATUS "isa-l_crypto  : ${ISAL_CRYPTO_FOUND}")
 message(STATUS "isa-l         : ${ISAL_FOUND}")
 message(STATUS "xxhash        : ${XXHASH_FOUND}")
+message(STATUS "liburing      : ${URING_FOUND}")
 message(STATUS "davix         : ${DAVIX_FOUND}")
 message( STATUS "................................................." )
 message( STATUS "C Compiler    : " ${CMAKE_C_COMPILER} )
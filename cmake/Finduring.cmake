@@ -0,0 +1,39 @@
+# Try to find liburing (devel)
+# Once done, this will define
+#
+# URING_FOUND          - system has liburing
+# URING_INCLUDE_DIRS   - liburing include directories
+# URING_LIBRARIES      - liburing libraries directories
+#
+# and the following imported target
+#
+# URING::URING
+
+find_path(URING_INCLUDE_DIR
+  NAMES liburing.h
+  HINTS ${URING_ROOT}
+  PATH_SUFFIXES include)
+
+find_library(URING_LIBRARY
+  NAME uring
+  HINTS ${URING_ROOT}
+  PATH_SUFFIXES ${CMAKE_INSTALL_LIBDIR})
+
+include(FindPackageHandleStandardArgs)
+find_package_handle_standard_args(uring
+  REQUIRED_VARS URING_LIBRARY URING_INCLUDE_DIR)
+mark_as_advanced(URING_LIBRARY URING_INCLUDE_DIR)
+
+if (URING_FOUND AND NOT TARGET URING::URING)
+  add_library(URING::URING UNKNOWN IMPORTED)
+  set_target_properties(URING::URING PROPERTIES
+    IMPORTED_LOCATION "${URING_LIBRARY}"
+    INTERFACE_INCLUDE_DIRECTORIES "${URING_INCLUDE_DIR}")
+  target_compile_definitions(URING::URING INTERFACE URING_FOUND)
+else()
+  message(WARNING "Notice: liburing not found, no io_uring support")
+  add_library(URING::URING INTERFACE IMPORTED)
+endif()
+
+unset(URING_INCLUDE_DIRS)
+unset(URING_LIBRARIES)
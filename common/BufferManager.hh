@@ -26,49 +26,100 @@
 #include "common/Logging.hh"
 #include "common/StringConversion.hh"
 #include <memory>
-#include <mutex>
+#include <new>
 #include <vector>
-#include <list>
 #include <atomic>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <sys/mman.h>
 
 EOSCOMMONNAMESPACE_BEGIN
 
 //------------------------------------------------------------------------------
-//! Class Buffer
+//! Class Buffer - page aligned memory block, usable for O_DIRECT. Buffers of
+//! at least a huge page are mmap-ed and marked as candidates for transparent
+//! huge pages. The pages are only faulted in when first written, therefore
+//! with the default first-touch policy they end up on the NUMA node of the
+//! thread using the buffer and not of the one that happened to allocate it.
 //------------------------------------------------------------------------------
 class Buffer
 {
   friend class BufferManager;
 public:
+  static constexpr uint64_t sPageSize = 4096;
+  static constexpr uint64_t sHugePageSize = 2 * 1024 * 1024;
+
   //----------------------------------------------------------------------------
   //! Constructor
+  //!
+  //! @param size size of the buffer
+  //!
+  //! @throws std::bad_alloc if the memory can not be allocated
   //----------------------------------------------------------------------------
   Buffer(uint64_t size):
-    mCapacity(size),
-    mData(size, '\0')
-  {}
+    mCapacity(size), mLength(0), mData(nullptr), mMapped(false)
+  {
+    uint64_t alloc_sz = std::max(size, (uint64_t)1);
+
+    if (alloc_sz >= sHugePageSize) {
+      void* ptr = mmap(nullptr, alloc_sz, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+      if (ptr != MAP_FAILED) {
+#ifdef MADV_HUGEPAGE
+        (void) madvise(ptr, alloc_sz, MADV_HUGEPAGE);
+#endif
+        mData = static_cast<char*>(ptr);
+        mMapped = true;
+        return;
+      }
+    }
+
+    if (posix_memalign((void**)&mData, sPageSize, alloc_sz)) {
+      throw std::bad_alloc();
+    }
+
+    (void) memset(mData, '\0', alloc_sz);
+  }
 
   //----------------------------------------------------------------------------
   //! Get pointer to underlying data
   //----------------------------------------------------------------------------
   inline char* GetDataPtr()
   {
-    return &mData.front();
+    return mData;
   }
 
   //----------------------------------------------------------------------------
   //! Destructor
   //----------------------------------------------------------------------------
-  ~Buffer() = default;
+  ~Buffer()
+  {
+    if (mMapped) {
+      (void) munmap(mData, std::max(mCapacity, (uint64_t)1));
+    } else {
+      free(mData);
+    }
+  }
+
+  Buffer(const Buffer&) = delete;
+  Buffer& operator =(const Buffer&) = delete;
 
   uint64_t mCapacity; ///< Available size of the buffer
   uint64_t mLength; ///< Length of the useful data
-  std::vector<char> mData; ///< Buffer holding the data
+
+private:
+  char* mData; ///< Buffer holding the data
+  bool mMapped; ///< Mark if the memory is mmap-ed
 };
 
 
 //------------------------------------------------------------------------------
-//! Class BufferSlot
+//! Class BufferSlot - lock-free pool of buffers of the same size. Available
+//! buffers are kept in a bounded multi-producer multi-consumer ring, each
+//! cell carries a sequence number telling whether it is ready to be written
+//! or read for the current turn, so both ends only need one CAS.
 //------------------------------------------------------------------------------
 class BufferSlot
 {
@@ -78,58 +129,47 @@ public:
   //! Constructor
   //!
   //! @param size size of buffers allocated by the current slot
+  //! @param max_cached maximum number of buffers kept in the slot
+  //! @param total_size size accounted for all slots of the buffer manager
   //----------------------------------------------------------------------------
-  BufferSlot(uint64_t size):
-    mBuffSize(size), mNumBuffers(0)
-  {}
-
-  //----------------------------------------------------------------------------
-  //! Destructor
-  //----------------------------------------------------------------------------
-  ~BufferSlot()
+  BufferSlot(uint64_t size, uint64_t max_cached,
+             std::atomic<uint64_t>& total_size):
+    mBuffSize(size), mNumBuffers(0), mTotalSize(total_size)
   {
-    std::unique_lock<std::mutex> lock(mSlotMutex);
-    mAvailableBuffers.clear();
-  }
+    uint64_t capacity = 1;
 
-  //----------------------------------------------------------------------------
-  //! Move assignment operator
-  //----------------------------------------------------------------------------
-  BufferSlot& operator =(BufferSlot&& other) noexcept
-  {
-    if (this != &other) {
-      mBuffSize = other.mBuffSize;
-      mNumBuffers.store(other.mNumBuffers);
-      mAvailableBuffers = other.mAvailableBuffers;
-      other.mAvailableBuffers.clear();
+    while ((capacity < max_cached) && (capacity < sMaxCells)) {
+      capacity <<= 1;
     }
 
-    return *this;
+    mMask = capacity - 1;
+    mCells.reset(new Cell[capacity]);
+
+    for (uint64_t i = 0; i < capacity; ++i) {
+      mCells[i].mSeq.store(i, std::memory_order_relaxed);
+    }
   }
 
   //----------------------------------------------------------------------------
-  //! Move constructor
+  //! Destructor
   //----------------------------------------------------------------------------
-  BufferSlot(BufferSlot&& other) noexcept
-  {
-    *this = std::move(other);
-  }
+  ~BufferSlot() = default;
 
   //----------------------------------------------------------------------------
   //! Get buffer
   //----------------------------------------------------------------------------
   std::shared_ptr<Buffer> GetBuffer()
   {
-    std::unique_lock<std::mutex> lock(mSlotMutex);
+    std::shared_ptr<Buffer> buff;
 
-    if (!mAvailableBuffers.empty()) {
-      auto buff =  mAvailableBuffers.front();
-      mAvailableBuffers.pop_front();
+    if (Dequeue(buff)) {
       return buff;
     }
 
+    buff = std::make_shared<Buffer>(mBuffSize);
     ++mNumBuffers;
-    return std::make_shared<Buffer>(mBuffSize);
+    mTotalSize += mBuffSize;
+    return buff;
   }
 
   //----------------------------------------------------------------------------
@@ -140,11 +180,9 @@ public:
   //----------------------------------------------------------------------------
   void Recycle(std::shared_ptr<Buffer> buffer, bool keep)
   {
-    if (keep) {
-      std::unique_lock<std::mutex> lock(mSlotMutex);
-      mAvailableBuffers.push_back(buffer);
-    } else {
+    if (!keep || !Enqueue(buffer)) {
       --mNumBuffers;
+      mTotalSize -= mBuffSize;
     }
   }
 
@@ -153,19 +191,102 @@ public:
   //----------------------------------------------------------------------------
   void Pop()
   {
-    std::unique_lock<std::mutex> lock(mSlotMutex);
+    std::shared_ptr<Buffer> buff;
 
-    if (!mAvailableBuffers.empty()) {
-      mAvailableBuffers.pop_front();
+    if (Dequeue(buff)) {
       --mNumBuffers;
+      mTotalSize -= mBuffSize;
     }
   }
 
+  //----------------------------------------------------------------------------
+  //! Get size of all the buffers allocated by the slot
+  //----------------------------------------------------------------------------
+  uint64_t GetAllocatedSize() const
+  {
+    return mNumBuffers.load() * mBuffSize;
+  }
+
 private:
-  std::mutex mSlotMutex;
-  std::list<std::shared_ptr<Buffer>> mAvailableBuffers;
-  std::atomic<uint64_t> mNumBuffers;
-  uint64_t mBuffSize;
+  //! Upper limit for the number of cells in the ring
+  static constexpr uint64_t sMaxCells = 1 << 16;
+
+  struct Cell {
+    std::atomic<uint64_t> mSeq;
+    std::shared_ptr<Buffer> mBuffer;
+  };
+
+  //----------------------------------------------------------------------------
+  //! Add buffer to the ring
+  //!
+  //! @return true if successful, false if ring is full
+  //----------------------------------------------------------------------------
+  bool Enqueue(std::shared_ptr<Buffer>& buffer)
+  {
+    Cell* cell;
+    uint64_t pos = mTail.load(std::memory_order_relaxed);
+
+    while (true) {
+      cell = &mCells[pos & mMask];
+      uint64_t seq = cell->mSeq.load(std::memory_order_acquire);
+      int64_t diff = (int64_t)seq - (int64_t)pos;
+
+      if (diff == 0) {
+        if (mTail.compare_exchange_weak(pos, pos + 1,
+                                        std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = mTail.load(std::memory_order_relaxed);
+      }
+    }
+
+    cell->mBuffer = std::move(buffer);
+    cell->mSeq.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Take buffer from the ring
+  //!
+  //! @return true if successful, false if ring is empty
+  //----------------------------------------------------------------------------
+  bool Dequeue(std::shared_ptr<Buffer>& buffer)
+  {
+    Cell* cell;
+    uint64_t pos = mHead.load(std::memory_order_relaxed);
+
+    while (true) {
+      cell = &mCells[pos & mMask];
+      uint64_t seq = cell->mSeq.load(std::memory_order_acquire);
+      int64_t diff = (int64_t)seq - (int64_t)(pos + 1);
+
+      if (diff == 0) {
+        if (mHead.compare_exchange_weak(pos, pos + 1,
+                                        std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = mHead.load(std::memory_order_relaxed);
+      }
+    }
+
+    buffer = std::move(cell->mBuffer);
+    cell->mSeq.store(pos + mMask + 1, std::memory_order_release);
+    return true;
+  }
+
+  uint64_t mBuffSize; ///< Size of buffers handled by the slot
+  std::atomic<uint64_t> mNumBuffers; ///< Buffers allocated, in use or cached
+  std::atomic<uint64_t>& mTotalSize; ///< Size accounted by the manager
+  uint64_t mMask; ///< Ring size - 1
+  std::unique_ptr<Cell[]> mCells; ///< Ring of available buffers
+  alignas(64) std::atomic<uint64_t> mTail {0}; ///< Producer position
+  alignas(64) std::atomic<uint64_t> mHead {0}; ///< Consumer position
 };
 
 
@@ -188,10 +309,13 @@ public:
   //----------------------------------------------------------------------------
   BufferManager(uint64_t max_size = 256 * 1024 * 1024 , uint32_t slots = 2,
                 uint64_t slot_base_sz = 1024 * 1024):
-    mMaxSize(max_size), mNumSlots(slots)
+    mMaxSize(max_size), mNumSlots(slots), mSlotBaseSz(slot_base_sz),
+    mTotalSize(0ull)
   {
     for (uint32_t i = 0u; i <= mNumSlots; ++i) {
-      mSlots.emplace_back((1 << i) * slot_base_sz);
+      uint64_t buff_sz = (1ull << i) * mSlotBaseSz;
+      mSlots.emplace_back(new BufferSlot(buff_sz, mMaxSize / buff_sz + 1,
+                                         mTotalSize));
     }
   }
 
@@ -209,22 +333,14 @@ public:
   //----------------------------------------------------------------------------
   std::shared_ptr<Buffer> GetBuffer(uint64_t size)
   {
-    uint32_t slot {UINT32_MAX};
-
-    // Find appropriate slot for the given size
-    for (uint32_t i = 0; i <= mNumSlots; ++i) {
-      if (size <= (1 << (i + 20))) {
-        slot = i;
-        break;
-      }
-    }
+    uint32_t slot = GetSlotForSize(size);
 
     // Can not provide a buffer big enough for the required size
-    if (slot == UINT32_MAX) {
+    if (slot > mNumSlots) {
       return nullptr;
     }
 
-    return mSlots[slot].GetBuffer();
+    return mSlots[slot]->GetBuffer();
   }
 
   //----------------------------------------------------------------------------
@@ -238,51 +354,47 @@ public:
       return;
     }
 
-    uint32_t slot {UINT32_MAX};
-
-    // Find appropriate slot for given buffer
-    for (uint32_t i = 0; i <= mNumSlots; ++i) {
-      if (buffer->mCapacity == (1 << (i + 20))) {
-        slot = i;
-        break;
-      }
-    }
+    uint32_t slot = GetSlotForSize(buffer->mCapacity);
 
     // Not a buffer allocated by us
-    if (slot == UINT32_MAX) {
+    if ((slot > mNumSlots) || (mSlots[slot]->mBuffSize != buffer->mCapacity)) {
       return;
     }
 
-    uint64_t total_size {0ull};
-    auto sorted_slots = GetSortedSlotSizes(total_size);
-    bool keep = (total_size <= mMaxSize);
+    bool keep = (mTotalSize.load() <= mMaxSize);
 
     if (!keep) {
       eos_debug("msg=\"buffer pool is full\" max_size=%s",
                 eos::common::StringConversion::GetPrettySize(mMaxSize).c_str());
+      // Perform clean up in the other slot holding most memory
+      uint32_t victim {UINT32_MAX};
+      uint64_t victim_sz {0ull};
 
-      // Perform clean up for rest of slots depending on their size
-      for (auto it = sorted_slots.rbegin(); it != sorted_slots.rend(); ++it) {
-        if (it->first > slot) {
-          mSlots[it->first].Pop();
-          break;
+      for (uint32_t i = 0; i <= mNumSlots; ++i) {
+        uint64_t sz = mSlots[i]->GetAllocatedSize();
+
+        if ((i != slot) && ((victim == UINT32_MAX) || (sz >= victim_sz))) {
+          victim = i;
+          victim_sz = sz;
         }
+      }
 
-        if (it->first < slot) {
+      if (victim != UINT32_MAX) {
+        if (victim > slot) {
+          mSlots[victim]->Pop();
+        } else {
           // Free the equivalent of a block from the current slot
-          int free_blocks = 1 << (slot - it->first);
+          int free_blocks = 1 << (slot - victim);
 
           while (free_blocks) {
-            mSlots[it->first].Pop();
+            mSlots[victim]->Pop();
             --free_blocks;
           }
-
-          break;
         }
       }
     }
 
-    mSlots[slot].Recycle(buffer, keep);
+    mSlots[slot]->Recycle(buffer, keep);
   }
 
   //----------------------------------------------------------------------------
@@ -300,8 +412,7 @@ public:
     total_size = 0ull;
 
     for (uint32_t i = 0; i <= mNumSlots; ++i) {
-      elem.push_back(std::make_pair(i,
-                                    (mSlots[i].mNumBuffers * (1 << i) * 1024 * 1024)));
+      elem.push_back(std::make_pair(i, mSlots[i]->GetAllocatedSize()));
       total_size += elem.rbegin()->second;
     }
 
@@ -313,6 +424,14 @@ public:
     return elem;
   }
 
+  //----------------------------------------------------------------------------
+  //! Get total size of the buffers allocated, either in use or cached
+  //----------------------------------------------------------------------------
+  uint64_t GetTotalSize() const
+  {
+    return mTotalSize.load();
+  }
+
   //----------------------------------------------------------------------------
   //! Get number of slots handled by the current buffer manager
   //----------------------------------------------------------------------------
@@ -330,9 +449,25 @@ public:
   }
 
 private:
+  //----------------------------------------------------------------------------
+  //! Get slot index for the given size i.e. ceil(log2(size / base size)),
+  //! which is bigger than the number of slots if size is too big
+  //----------------------------------------------------------------------------
+  uint32_t GetSlotForSize(uint64_t size) const
+  {
+    if (size <= mSlotBaseSz) {
+      return 0;
+    }
+
+    uint64_t num_blocks = (size + mSlotBaseSz - 1) / mSlotBaseSz;
+    return 64 - __builtin_clzll(num_blocks - 1);
+  }
+
   std::atomic<uint64_t> mMaxSize;
   std::atomic<uint32_t> mNumSlots;
-  std::vector<BufferSlot> mSlots;
+  uint64_t mSlotBaseSz; ///< Size of the buffers in the first slot
+  std::atomic<uint64_t> mTotalSize; ///< Size of all allocated buffers
+  std::vector<std::unique_ptr<BufferSlot>> mSlots;
 };
 
 EOSCOMMONNAMESPACE_END
@@ -222,6 +222,21 @@ NewfindHelper::ParseCommand(const char* arg)
       } else {
         return false;
       }
+    } else if (s1 == "--threads") {
+      if (!subtokenizer.NextToken(token)) {
+        return false;
+      }
+      if (token.length() > 0) {
+        try {
+          find->set_threads(std::stoul(token));
+        } catch (std::logic_error& error) {
+          return false;
+        }
+      } else {
+        return false;
+      }
+    } else if (s1 == "--unordered") {
+      find->set_unordered(true);
     } else if (s1 == "--purge") {
       std::string versions = subtokenizer.GetToken();
 
@@ -668,6 +683,9 @@ void com_newfind_help()
       << "\t              --count : just print global counters for files/dirs found\n"
       << "\t         --childcount : print the number of children in each directory\n"
       << "\t                        The research is way faster than with `--count`, but will only apply the `--maxdepth` filter (if set)\n"
+      << "Traversal: [--threads <n>] [--unordered]\n"
+      << "\t        --threads <n> : explore the namespace using <n> threads on the MGM (QuarkDB namespace only)\n"
+      << "\t          --unordered : with --threads, print the entries as they are found instead of in depth-first order\n"
       << "Output Mod: [--xurl] [-p <key>] [--nrep] [--nunlink] [--size] [--online] [--hosts] [--partition] [--fid] [--fs] [--checksum] [--ctime] [--mtime] [--uid] [--gid]\n"
 //      << "                   -s :  run in silent mode"
       << "\t                      : print out the requested meta data as key value pairs\n"
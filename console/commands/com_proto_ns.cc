@@ -540,7 +540,7 @@ void com_ns_help()
       << "    -d         : control the directory cache" << std::endl
       << "    -f         : control the file cache" << std::endl
       << "    <max_num>  : max number of entries" << std::endl
-      << "    <max_size> : max size of the cache - not implemented yet"
+      << "    <max_size> : max size of the cache in bytes, by default not limited"
       << std::endl
       << std::endl
       << "  ns cache drop-single-file <id of file to drop>" << std::endl
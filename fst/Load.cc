@@ -24,8 +24,17 @@
 #include "fst/Load.hh"
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <utmpx.h>
 #include <sys/stat.h>
+#ifdef __APPLE__
+#include <sys/sysctl.h>
+#else
+#include <sys/sysinfo.h>
+#endif
 #include "XrdOuc/XrdOucString.hh"
 
 EOSFSTNAMESPACE_BEGIN
@@ -148,6 +157,15 @@ Load::GetNetRate(const char* dev, const char* tag)
   return val;
 }
 
+//------------------------------------------------------------------------------
+// Get the system statistics of the last measurement
+//------------------------------------------------------------------------------
+SysStat::Snapshot
+Load::GetSysStat()
+{
+  return fSysStat.GetSnapshot();
+}
+
 //------------------------------------------------------------------------------
 // Method run by scrubber thread to  measurement both disk and network values
 // on regular intervals.
@@ -166,6 +184,10 @@ Load::Measure()
       fprintf(stderr, "error: cannot get network IO statistic\n");
     }
 
+    if (!fSysStat.Measure()) {
+      fprintf(stderr, "error: cannot get system statistic\n");
+    }
+
     XrdSysThread::SetCancelOn();
     sleep(mInterval);
   }
@@ -189,6 +211,11 @@ bool
 Load::Monitor()
 {
   int rc = 0;
+  const char* ptr = getenv("EOS_FST_LOAD_INTERVAL");
+
+  if (ptr && (strtoul(ptr, nullptr, 10) > 0)) {
+    mInterval = strtoul(ptr, nullptr, 10);
+  }
 
   if ((rc = XrdSysThread::Run(&mTid, Load::StartLoadThread,
                               static_cast<void*>(this),
@@ -477,4 +504,261 @@ NetStat::Measure()
   }
 }
 
+//------------------------------------------------------------------------------
+//                                 SysStat Class
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+SysStat::SysStat()
+{
+  // /proc/net/sockstat and /proc/net/route are small files
+  mBuffer.reserve(4096);
+}
+
+//------------------------------------------------------------------------------
+// Get system measurement values
+//------------------------------------------------------------------------------
+bool
+SysStat::Measure()
+{
+  unsigned long long uptime = 0;
+  double load[3] = {0.0, 0.0, 0.0};
+#ifdef __APPLE__
+  struct timeval boottime;
+  size_t len = sizeof(boottime);
+
+  if (sysctlbyname("kern.boottime", &boottime, &len, nullptr, 0) ||
+      (getloadavg(load, 3) != 3)) {
+    return false;
+  }
+
+  uptime = time(nullptr) - boottime.tv_sec;
+#else
+  struct sysinfo info;
+
+  if (sysinfo(&info)) {
+    return false;
+  }
+
+  uptime = info.uptime;
+
+  for (int i = 0; i < 3; ++i) {
+    load[i] = (double) info.loads[i] / (1 << SI_LOAD_SHIFT);
+  }
+
+#endif
+  // Count user sessions the same way as the uptime command
+  unsigned int users = 0;
+  struct utmpx* entry = nullptr;
+  setutxent();
+
+  while ((entry = getutxent())) {
+    if ((entry->ut_type == USER_PROCESS) && entry->ut_user[0]) {
+      ++users;
+    }
+  }
+
+  endutxent();
+  XrdSysMutexHelper scope_lock(mMutex);
+  unsigned long long sockets = 0;
+
+  if (!ReadFile("/proc/net/sockstat", mBuffer) ||
+      !ParseSockstat(mBuffer, sockets)) {
+    sockets = 0;
+  }
+
+  mSnapshot.mTimestamp = time(nullptr);
+  mSnapshot.mUptime = FormatUptime(mSnapshot.mTimestamp, uptime, users, load);
+  mSnapshot.mTcpSockets = sockets;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Get the values of the last measurement
+//------------------------------------------------------------------------------
+SysStat::Snapshot
+SysStat::GetSnapshot()
+{
+  {
+    XrdSysMutexHelper scope_lock(mMutex);
+
+    if (mSnapshot.mTimestamp) {
+      return mSnapshot;
+    }
+  }
+
+  (void) Measure();
+  XrdSysMutexHelper scope_lock(mMutex);
+  return mSnapshot;
+}
+
+//------------------------------------------------------------------------------
+// Get speed of a network interface from sysfs
+//------------------------------------------------------------------------------
+unsigned long long
+SysStat::GetNetSpeed(std::string netdev)
+{
+  std::string buffer;
+
+  if (netdev.empty()) {
+    if (!ReadFile("/proc/net/route", buffer)) {
+      return 0;
+    }
+
+    netdev = ParseDefaultRoute(buffer);
+
+    if (netdev.empty()) {
+      return 0;
+    }
+  }
+
+  std::string path = "/sys/class/net/" + netdev + "/speed";
+
+  if (!ReadFile(path.c_str(), buffer)) {
+    return 0;
+  }
+
+  // Value in Mb/s, negative if the link is down or the speed unknown
+  long long speed = strtoll(buffer.c_str(), nullptr, 10);
+  return (speed > 0) ? (unsigned long long) speed * 1000000 : 0;
+}
+
+//------------------------------------------------------------------------------
+// Read the content of a file into the given buffer
+//------------------------------------------------------------------------------
+bool
+SysStat::ReadFile(const char* path, std::string& buffer)
+{
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+
+  if (fd < 0) {
+    return false;
+  }
+
+  // Files in /proc report a size of 0, read until the end
+  size_t len = 0;
+  buffer.resize(buffer.capacity() ? buffer.capacity() : 4096);
+
+  while (true) {
+    if (len == buffer.size()) {
+      buffer.resize(2 * buffer.size());
+    }
+
+    ssize_t nread = read(fd, &buffer[len], buffer.size() - len);
+
+    if (nread < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+
+      (void) close(fd);
+      return false;
+    }
+
+    if (nread == 0) {
+      break;
+    }
+
+    len += nread;
+  }
+
+  (void) close(fd);
+  buffer.resize(len);
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Parse /proc/net/sockstat content
+//------------------------------------------------------------------------------
+bool
+SysStat::ParseSockstat(const std::string& data, unsigned long long& sockets)
+{
+  // e.g. "TCP: inuse 27 orphan 0 tw 3 alloc 31 mem 2"
+  size_t pos = data.find("\nTCP: ");
+
+  if (pos == std::string::npos) {
+    if (data.compare(0, 5, "TCP: ")) {
+      return false;
+    }
+
+    pos = 0;
+  } else {
+    ++pos;
+  }
+
+  unsigned long long inuse = 0;
+  unsigned long long orphan = 0;
+  unsigned long long tw = 0;
+
+  if (sscanf(data.c_str() + pos, "TCP: inuse %llu orphan %llu tw %llu",
+             &inuse, &orphan, &tw) != 3) {
+    return false;
+  }
+
+  sockets = inuse + tw;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Parse /proc/net/route content to get the interface of the default route
+//------------------------------------------------------------------------------
+std::string
+SysStat::ParseDefaultRoute(const std::string& data)
+{
+  char iface[64];
+  char destination[64];
+  size_t pos = data.find('\n');
+
+  // Skip the header line
+  while (pos != std::string::npos) {
+    ++pos;
+
+    if ((sscanf(data.c_str() + pos, "%63s %63s", iface, destination) == 2) &&
+        (strcmp(destination, "00000000") == 0)) {
+      return iface;
+    }
+
+    pos = data.find('\n', pos);
+  }
+
+  return "";
+}
+
+//------------------------------------------------------------------------------
+// Format uptime like the uptime command does
+//------------------------------------------------------------------------------
+std::string
+SysStat::FormatUptime(time_t now, unsigned long long uptime,
+                      unsigned int users, const double load[3])
+{
+  struct tm tm_now;
+  char buff[256];
+  std::string out;
+  localtime_r(&now, &tm_now);
+  strftime(buff, sizeof(buff), " %H:%M:%S up ", &tm_now);
+  out = buff;
+  unsigned long long days = uptime / 86400;
+  unsigned long long hours = (uptime / 3600) % 24;
+  unsigned long long minutes = (uptime / 60) % 60;
+
+  if (days) {
+    snprintf(buff, sizeof(buff), "%llu day%s, ", days, (days > 1) ? "s" : "");
+    out += buff;
+  }
+
+  if (hours) {
+    snprintf(buff, sizeof(buff), "%2llu:%02llu, ", hours, minutes);
+  } else {
+    snprintf(buff, sizeof(buff), "%llu min, ", minutes);
+  }
+
+  out += buff;
+  snprintf(buff, sizeof(buff), " %u user%s,  load average: %.2f, %.2f, %.2f",
+           users, (users == 1) ? "" : "s", load[0], load[1], load[2]);
+  out += buff;
+  return out;
+}
+
 EOSFSTNAMESPACE_END
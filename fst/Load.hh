@@ -30,6 +30,7 @@
 #include <map>
 #include <string>
 #include <sys/time.h>
+#include <ctime>
 
 EOSFSTNAMESPACE_BEGIN
 
@@ -121,6 +122,110 @@ private:
   XrdSysRWLock mMutexRW; ///< RW mutex for protecting accces to the rates map
 };
 
+//------------------------------------------------------------------------------
+//! Class collecting system wide statistics like uptime, load and number of
+//! TCP sockets directly from the kernel (sysinfo, /proc, sysfs) without
+//! forking any helper process
+//------------------------------------------------------------------------------
+class SysStat
+{
+public:
+  //! Values of the last measurement
+  struct Snapshot {
+    std::string mUptime; ///< Uptime in the format of the uptime command
+    unsigned long long mTcpSockets = 0; ///< Number of IPv4 TCP sockets
+    time_t mTimestamp = 0; ///< Time of the measurement, 0 if never measured
+  };
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //----------------------------------------------------------------------------
+  SysStat();
+
+  //----------------------------------------------------------------------------
+  //! Destructor
+  //----------------------------------------------------------------------------
+  virtual ~SysStat() {};
+
+  //----------------------------------------------------------------------------
+  //! Get system measurement values
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  bool Measure();
+
+  //----------------------------------------------------------------------------
+  //! Get the values of the last measurement, measures first if there was
+  //! none so far
+  //----------------------------------------------------------------------------
+  Snapshot GetSnapshot();
+
+  //----------------------------------------------------------------------------
+  //! Get speed of a network interface from sysfs
+  //!
+  //! @param netdev network interface, if empty the interface of the default
+  //!        route is used
+  //!
+  //! @return speed in bits per second or 0 if not known
+  //----------------------------------------------------------------------------
+  static unsigned long long GetNetSpeed(std::string netdev = "");
+
+#ifdef IN_TEST_HARNESS
+public:
+#else
+private:
+#endif
+  //----------------------------------------------------------------------------
+  //! Read the content of a (proc) file into the given buffer whose capacity
+  //! is kept between calls
+  //!
+  //! @param path file path
+  //! @param buffer buffer holding the file content
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  static bool ReadFile(const char* path, std::string& buffer);
+
+  //----------------------------------------------------------------------------
+  //! Parse /proc/net/sockstat content to get the number of TCP sockets as
+  //! listed in /proc/net/tcp i.e. in use and in time wait state
+  //!
+  //! @param data content of /proc/net/sockstat
+  //! @param sockets number of sockets
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  static bool ParseSockstat(const std::string& data,
+                            unsigned long long& sockets);
+
+  //----------------------------------------------------------------------------
+  //! Parse /proc/net/route content to get the interface of the default route
+  //!
+  //! @param data content of /proc/net/route
+  //!
+  //! @return interface name or empty string if there is no default route
+  //----------------------------------------------------------------------------
+  static std::string ParseDefaultRoute(const std::string& data);
+
+  //----------------------------------------------------------------------------
+  //! Format uptime like the uptime command does
+  //!
+  //! @param now current time
+  //! @param uptime uptime in seconds
+  //! @param users number of logged in users
+  //! @param load load average over 1, 5 and 15 minutes
+  //!
+  //! @return formatted uptime
+  //----------------------------------------------------------------------------
+  static std::string FormatUptime(time_t now, unsigned long long uptime,
+                                  unsigned int users, const double load[3]);
+
+private:
+  std::string mBuffer; ///< Buffer reused for reading /proc files
+  Snapshot mSnapshot; ///< Values of the last measurement
+  XrdSysMutex mMutex; ///< Mutex protecting the snapshot and buffer
+};
+
 //------------------------------------------------------------------------------
 //! Class Load
 //------------------------------------------------------------------------------
@@ -148,15 +253,16 @@ public:
   virtual ~Load();
 
   //----------------------------------------------------------------------------
-  //! Start scrubber thread
+  //! Start scrubber thread. The sampling interval in seconds can be
+  //! overridden with the EOS_FST_LOAD_INTERVAL environment variable.
   //!
   //! @return true if thread started successfully, otherwise false
   //----------------------------------------------------------------------------
   bool Monitor();
 
   //----------------------------------------------------------------------------
-  //! Method run by scurbber thread to  measurement both disk and network values
-  //! on regular intervals.
+  //! Method run by scurbber thread to  measurement disk, network and system
+  //! values on regular intervals.
   //----------------------------------------------------------------------------
   void Measure();
 
@@ -180,6 +286,11 @@ public:
   //----------------------------------------------------------------------------
   double GetNetRate(const char* dev, const char* tag);
 
+  //----------------------------------------------------------------------------
+  //! Get the system statistics of the last measurement
+  //----------------------------------------------------------------------------
+  SysStat::Snapshot GetSysStat();
+
   //----------------------------------------------------------------------------
   //! Static method used to start the scrubber thread
   //----------------------------------------------------------------------------
@@ -190,6 +301,7 @@ private:
   unsigned int mInterval; ///< Sampling interval for the monitor thread
   DiskStat fDiskStat; ///< Disk statistics
   NetStat fNetStat; ///< Network statistics
+  SysStat fSysStat; ///< System statistics
 };
 
 EOSFSTNAMESPACE_END
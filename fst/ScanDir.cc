@@ -852,12 +852,11 @@ ScanDir::ScanFileLoadAware(const std::unique_ptr<eos::fst::FileIo>& io,
       }
 
       if (blockXS && (blockxs_err == false)) {
-        if (!blockXS->CheckBlockSum(offset, mBuffer, nread)) {
+        // Verify the blocks and update the file checksum in the same pass
+        if (!blockXS->CheckBlockSum(offset, mBuffer, nread, comp_file_xs)) {
           blockxs_err = true;
         }
-      }
-
-      if (comp_file_xs) {
+      } else if (comp_file_xs) {
         comp_file_xs->Add(mBuffer, nread, offset);
       }
 
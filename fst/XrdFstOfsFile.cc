@@ -34,6 +34,7 @@
 #include "fst/checksum/ChecksumPlugins.hh"
 #include "fst/storage/FileSystem.hh"
 #include "XrdOss/XrdOssApi.hh"
+#include "XrdSfs/XrdSfsAio.hh"
 #include "fst/io/FileIoPluginCommon.hh"
 #include "namespace/utils/Etag.hh"
 
@@ -569,8 +570,9 @@ XrdFstOfsFile::open(const char* path, XrdSfsFileOpenMode open_mode,
       }
     }
 
-    // Preset with the last known checksum
-    if (mCheckSum && mIsRW && !IsChunkedUpload()) {
+    // Preset with the last known checksum if it matches the current size
+    if (mCheckSum && mIsRW && !IsChunkedUpload() &&
+        ((unsigned long long) openSize == mFmd->mProtoFmd.size())) {
       eos_info("msg=\"checksum reset init\" file-xs=%s",
                mFmd->mProtoFmd.checksum().c_str());
       mCheckSum->ResetInit(0, openSize, mFmd->mProtoFmd.checksum().c_str());
@@ -643,13 +645,35 @@ XrdFstOfsFile::read(XrdSfsFileOffset fileOffset, XrdSfsXferSize amount)
 }
 
 //------------------------------------------------------------------------------
-// Read AIO - not supported
+// Read AIO - plain layout reads complete from the io_uring queue when it is
+// enabled for the file, everything else is read synchronously
 //------------------------------------------------------------------------------
 int
 XrdFstOfsFile::read(XrdSfsAio* aioparm)
 {
-  return gOFS.Emsg("read_aio", error, ENOTSUP, "read aio - operation not "
-                   "supported");
+  XrdSfsFileOffset offset = aioparm->sfsAio.aio_offset;
+  XrdSfsXferSize length = aioparm->sfsAio.aio_nbytes;
+  char* buffer = (char*) aioparm->sfsAio.aio_buf;
+  FileIo* io = (mLayout ? mLayout->GetFileIo() : nullptr);
+
+  // Checksum maintenance, TPC and IO error simulation need the synchronous
+  // read of the layout
+  if (io && !mIsDevNull && !mCheckSum && (mTpcFlag != kTpcSrcRead) &&
+      !gOFS.mSimIoReadErr &&
+      (eos::common::LayoutId::GetLayoutType(mLid) ==
+       eos::common::LayoutId::kPlain)) {
+    io->fileReadAsync(offset, buffer, length, [aioparm](int64_t retc) {
+      aioparm->Result = retc;
+      aioparm->doneRead();
+    });
+    return SFS_OK;
+  }
+
+  XrdSfsXferSize rc = read(offset, buffer, length);
+  aioparm->Result = ((rc >= 0) ? rc :
+                     -(error.getErrInfo() ? error.getErrInfo() : EIO));
+  aioparm->doneRead();
+  return SFS_OK;
 }
 
 //------------------------------------------------------------------------------
@@ -680,8 +704,14 @@ XrdFstOfsFile::read(XrdSfsFileOffset fileOffset, char* buffer,
    * but the read + append case can be supported in "Add" */
   if ((rc > 0) && (mCheckSum) && (!mHasWrite)) {
     XrdSysMutexHelper cLock(mChecksumMutex);
-    mCheckSum->Add(buffer, static_cast<size_t>(rc),
-                   static_cast<off_t>(fileOffset));
+
+    // Data already accounted for e.g. by the checksum preset at open is not
+    // added again since overlapping pieces can not be combined
+    if (!mCheckSum->SupportsOutOfOrder() ||
+        (fileOffset + rc > mCheckSum->GetMaxOffset())) {
+      mCheckSum->Add(buffer, static_cast<size_t>(rc),
+                     static_cast<off_t>(fileOffset));
+    }
   }
 
   if (rc > 0) {
@@ -762,9 +792,11 @@ XrdFstOfsFile::write(XrdSfsFileOffset fileOffset, const char* buffer,
     return buffer_size;
   }
 
-  // if the write position moves the checksum is dirty
+  // if the write position moves the checksum is dirty unless it can combine
+  // out of order pieces in which case only overlaps make it dirty
   if (mCheckSum) {
-    if (mWritePosition != (unsigned long long)fileOffset) {
+    if ((mWritePosition != (unsigned long long)fileOffset) &&
+        !mCheckSum->SupportsOutOfOrder()) {
       mCheckSum->Reset();
       mCheckSum->SetDirty();
     }
@@ -773,6 +805,11 @@ XrdFstOfsFile::write(XrdSfsFileOffset fileOffset, const char* buffer,
     mWritePosition = fileOffset + buffer_size;
   }
 
+  // The block checksum of the local replica is computed in the Oss write of
+  // the same buffer which then also updates the file checksum in one pass
+  ChecksumPlugins::FusedWriteScope xs_scope(mCheckSum.get(), &mChecksumMutex,
+      static_cast<off_t>(fileOffset), buffer,
+      static_cast<size_t>(buffer_size));
   int rc = mLayout->Write(fileOffset, const_cast<char*>(buffer), buffer_size);
 
   // If we see a remote IO error, we don't fail, we just call repair afterwards,
@@ -785,9 +822,16 @@ XrdFstOfsFile::write(XrdSfsFileOffset fileOffset, const char* buffer,
     rc = buffer_size;
   }
 
+  if (xs_scope.Used() && (rc != buffer_size)) {
+    // The whole buffer went into the file checksum but not to the file
+    XrdSysMutexHelper cLock(mChecksumMutex);
+    mCheckSum->Reset();
+    mCheckSum->SetDirty();
+  }
+
   // Evt. add checksum
   if (rc > 0) {
-    if (mCheckSum) {
+    if (mCheckSum && !xs_scope.Used()) {
       XrdSysMutexHelper cLock(mChecksumMutex);
       mCheckSum->Add(buffer, static_cast<size_t>(rc),
                      static_cast<off_t>(fileOffset));
@@ -875,13 +919,19 @@ XrdFstOfsFile::write(XrdSfsFileOffset fileOffset, const char* buffer,
 }
 
 //------------------------------------------------------------------------------
-// Write AIO - no supported
+// Write AIO - the write is done synchronously since it has to update the
+// checksum and the layout state in order
 //------------------------------------------------------------------------------
 int
 XrdFstOfsFile::write(XrdSfsAio* aioparm)
 {
-  return gOFS.Emsg("write_aio", error, ENOTSUP, "write aio - operation not "
-                   "supported");
+  XrdSfsXferSize rc = write(aioparm->sfsAio.aio_offset,
+                            (const char*) aioparm->sfsAio.aio_buf,
+                            aioparm->sfsAio.aio_nbytes);
+  aioparm->Result = ((rc >= 0) ? rc :
+                     -(error.getErrInfo() ? error.getErrInfo() : EIO));
+  aioparm->doneWrite();
+  return SFS_OK;
 }
 
 //------------------------------------------------------------------------------
@@ -1888,7 +1938,6 @@ XrdFstOfsFile::readofs(XrdSfsFileOffset fileOffset, char* buffer,
                        XrdSfsXferSize buffer_size)
 {
   gettimeofday(&cTime, &tz);
-  rCalls++;
   int rc = XrdOfsFile::read(fileOffset, buffer, buffer_size);
   eos_debug("read %llu %llu %i rc=%d", this, fileOffset, buffer_size, rc);
 
@@ -1907,6 +1956,20 @@ XrdFstOfsFile::readofs(XrdSfsFileOffset fileOffset, char* buffer,
     }
   }
 
+  AccountRead(fileOffset, rc);
+  gettimeofday(&lrTime, &tz);
+  AddReadTime();
+  return rc;
+}
+
+//------------------------------------------------------------------------------
+// Account a low-level read for monitoring
+//------------------------------------------------------------------------------
+void
+XrdFstOfsFile::AccountRead(XrdSfsFileOffset fileOffset, XrdSfsXferSize nread)
+{
+  rCalls++;
+
   // Account seeks for monitoring
   if (rOffset != static_cast<unsigned long long>(fileOffset)) {
     if (rOffset < static_cast<unsigned long long>(fileOffset)) {
@@ -1931,18 +1994,14 @@ XrdFstOfsFile::readofs(XrdSfsFileOffset fileOffset, char* buffer,
     }
   }
 
-  if (rc > 0) {
+  if (nread > 0) {
     if (mLayout->IsEntryServer() || eos::common::LayoutId::IsRain(mLid)) {
       XrdSysMutexHelper vecLock(vecMutex);
-      rvec.push_back(rc);
+      rvec.push_back(nread);
     }
 
-    rOffset = fileOffset + rc;
+    rOffset = fileOffset + nread;
   }
-
-  gettimeofday(&lrTime, &tz);
-  AddReadTime();
-  return rc;
 }
 
 //------------------------------------------------------------------------------
@@ -414,6 +414,15 @@ public:
   XrdSfsXferSize readofs(XrdSfsFileOffset fileOffset, char* buffer,
                          XrdSfsXferSize buffer_size);
 
+  //----------------------------------------------------------------------------
+  //! Account a low-level read for monitoring, done by readofs and by the
+  //! local IO object for reads bypassing the XrdOfs plugin
+  //!
+  //! @param fileOffset read offset
+  //! @param nread number of bytes read
+  //----------------------------------------------------------------------------
+  void AccountRead(XrdSfsFileOffset fileOffset, XrdSfsXferSize nread);
+
   //----------------------------------------------------------------------------
   //! Low-level vector read calling the default XrdOfs plugin
   //----------------------------------------------------------------------------
@@ -482,7 +482,8 @@ XrdFstOssFile::Write(const void* buffer, off_t offset, size_t length)
 
   if (mBlockXs) {
     XrdSysRWLockHelper wr_lock(mRWLockXs, 0);
-    mBlockXs->AddBlockSum(offset, static_cast<const char*>(buffer), length);
+    ChecksumPlugins::FusedWriteScope::AddBlockSum(mBlockXs, offset,
+        static_cast<const char*>(buffer), length);
   }
 
   do {
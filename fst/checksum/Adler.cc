@@ -23,63 +23,71 @@
 
 /*----------------------------------------------------------------------------*/
 #include "fst/checksum/Adler.hh"
-
-#ifdef ISAL_FOUND
-#include <isa-l.h>
-#endif
+#include "fst/checksum/ChecksumKernels.hh"
+#include <cstdlib>
+#include <cstring>
 
 EOSFSTNAMESPACE_BEGIN
 
+/*----------------------------------------------------------------------------*/
+Adler::Adler () : CheckSum("adler"), mRanges(&Adler32Combine)
+{
+  Reset();
+}
+
 /*----------------------------------------------------------------------------*/
 bool
 Adler::Add (const char* buffer, size_t length, off_t offset)
 {
-  if (offset != adleroffset)
-    needsRecalculation = true;
-
   if (finalized)                /* handle read/append case, no problem in this case */
       finalized = false;
 
-  adler = adler32(0L, Z_NULL, 0);
-  Chunk currChunk;
+  /* sequential data continues the adler of the range it extends, data written
+     out of order gets its own range which is combined with its neighbours */
+  auto update = [buffer, length](uint32_t value) {
+    return Adler32Update(value, buffer, length);
+  };
+
+  if (!mRanges.Append(offset, length, update) &&
+      !mRanges.Insert(offset, length, update(adler32(0L, Z_NULL, 0)))) {
+    /* overlapping data, the combined value is not known anymore */
+    needsRecalculation = true;
+  }
 
-#ifdef ISAL_FOUND
-  adler = isal_adler32(adler, (const unsigned char*) buffer, length);
-#else
-  adler = adler32(adler, (const Bytef*) buffer, length);
-#endif
   adleroffset = offset + length;
   if (adleroffset > maxoffset)
   {
     maxoffset = adleroffset;
   }
-  currChunk.offset = offset;
-  currChunk.length = length;
-  currChunk.adler = adler;
-
-  map = AddElementToMap(map, currChunk);
 
   return true;
 }
 
 /*----------------------------------------------------------------------------*/
-MapChunks&
-Adler::AddElementToMap (MapChunks& map, Chunk& chunk)
+void
+Adler::ResetInit (off_t offsetInit, size_t lengthInit,
+                  const char* checksumInitHex)
 {
-  off_t offEndChunk = chunk.offset + chunk.length;
-  IterMap iter = map.find(offEndChunk);
+  mRanges.Clear();
+  maxoffset = 0;
+  adleroffset = offsetInit + lengthInit;
+  needsRecalculation = false;
+  finalized = false;
 
-  if (iter != map.end())
-  {
-    map.erase(iter);
-    map.insert(std::pair<off_t, Chunk > (offEndChunk, chunk));
+  // Check if this is actually a valid pointer or a filled string
+  if ( (checksumInitHex == NULL) || (!strlen(checksumInitHex))) {
+    return;
   }
-  else
-  {
-    map.insert(std::pair<off_t, Chunk > (offEndChunk, chunk));
+
+  // if a file is truncated we get 0,0,<some checksum> => reset to 0
+  if (lengthInit != 0) {
+    adler = strtoul(checksumInitHex, 0, 16);
+    mRanges.Insert(offsetInit, lengthInit, adler);
+  } else {
+    adler = adler32(0L, Z_NULL, 0);
   }
 
-  return map;
+  maxoffset = (offsetInit + lengthInit);
 }
 
 /*----------------------------------------------------------------------------*/
@@ -101,108 +109,21 @@ Adler::GetBinChecksum (int &len)
 }
 
 /*----------------------------------------------------------------------------*/
-
-/* compute the adler value of the map if we have the full map
- * (starts from 0 and there are no holes)
- */
 void
-Adler::ValidateAdlerMap ()
+Adler::Finalize ()
 {
-  unsigned int value;
-  adler = adler32(0L, Z_NULL, 0);
-
-  if (map.begin() == map.end())
-  {
-    adler = adler32(0L, Z_NULL, 0);
-    return;
-  }
-
-  IterMap iter1 = map.begin();
-  IterMap iter2 = iter1;
-
-  value = iter1->second.adler;
-
-  IterMap iter3;
-  //  for (iter3= map.begin(); iter3!= map.end(); iter3++) {
-  //    fprintf(stderr,"ADLER VALIDATE %llu %llu %llu %x\n", iter3->first,iter3->second.offset, iter3->second.length, iter3->second.adler);
-  //  } 
-
-  if (iter1->second.offset != 0)
-  {
-    // the first chunk is not at the beginning
-    needsRecalculation = true;
-    adler = adler32(0L, Z_NULL, 0);
-    return;
-  }
-
-  if (map.begin() == map.end())
-  {
-    //we have no chunk
-    adler = adler32(0L, Z_NULL, 0);
-    return;
-  }
-
-  needsRecalculation = false;
-
-  iter2++;
-
-  if (iter2 == map.end())
-  {
-    if ((iter1->first) != maxoffset)
-    {
-      // there was probably some overwrite
-      needsRecalculation = true;
-    }
-    else
-    {
-      if (iter1->second.offset != 0)
-      {
-        needsRecalculation = true;
-      }
-    }
-    //we have one chunk
-    adler = value;
-    return;
-  }
-
-  off_t appliedoffset = 0;
+  if (!finalized) {
+    uint32_t value = 0;
 
-  for (; iter2 != map.end(); iter1++, iter2++)
-  {
-    appliedoffset = iter2->first;
-    value = adler32_combine(value, iter2->second.adler, iter2->second.length);
-    if (iter1->first != iter2->second.offset)
-    {
+    /* the ranges have to cover the whole file without any overlap */
+    if (!needsRecalculation &&
+        mRanges.GetValue(maxoffset, value, adler32(0L, Z_NULL, 0))) {
+      adler = value;
+    } else {
       needsRecalculation = true;
-      break;
+      adler = adler32(0L, Z_NULL, 0);
     }
-  }
 
-  if (appliedoffset != maxoffset)
-  {
-    // there was probably some overwrite
-    needsRecalculation = true;
-  }
-
-  if (!needsRecalculation)
-  {
-    adler = value;
-  }
-  else
-  {
-    adler = adler32(0L, Z_NULL, 0);
-  }
-
-  fflush(stdout);
-  return;
-}
-
-/*----------------------------------------------------------------------------*/
-void
-Adler::Finalize ()
-{
-  if (!finalized) {
-    ValidateAdlerMap();
     finalized = true;
   }
 }
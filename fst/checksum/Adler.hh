@@ -26,43 +26,23 @@
 
 #include "fst/Namespace.hh"
 #include "fst/checksum/CheckSum.hh"
+#include "fst/checksum/ChecksumRanges.hh"
 #include "XrdOuc/XrdOucEnv.hh"
 #include "XrdOuc/XrdOucString.hh"
 #include <zlib.h>
-#include <map>
 
 EOSFSTNAMESPACE_BEGIN
 
-struct ltoff_t {
-
-  bool operator()(off_t s1, off_t s2) const
-  {
-    return (s1 < s2);
-  }
-};
-
-typedef struct {
-  off_t offset;
-  size_t length;
-  unsigned int adler;
-} Chunk;
-
-typedef std::map<off_t, Chunk, ltoff_t> MapChunks;
-typedef std::map<off_t, Chunk, ltoff_t>::iterator IterMap;
-
 class Adler : public CheckSum
 {
 private:
   off_t adleroffset;
   off_t maxoffset;
   unsigned int adler;
-  MapChunks map;
+  ChecksumRanges mRanges; ///< Adler32 of the contiguous ranges added so far
 
 public:
-  Adler() : CheckSum("adler")
-  {
-    Reset();
-  }
+  Adler();
 
   unsigned int GetAdler()
   {
@@ -70,7 +50,6 @@ public:
   }
 
   bool Add(const char* buffer, size_t length, off_t offset);
-  MapChunks& AddElementToMap(MapChunks& map, Chunk& chunk);
 
   off_t
   GetLastOffset()
@@ -84,12 +63,17 @@ public:
     return maxoffset;
   }
 
+  bool
+  SupportsOutOfOrder() const
+  {
+    return true;
+  }
+
   int
   GetCheckSumLen()
   {
     return sizeof(unsigned int);
   }
-  void ValidateAdlerMap();
 
   const char* GetHexChecksum();
   const char* GetBinChecksum(int& len);
@@ -99,7 +83,7 @@ public:
   void
   Reset()
   {
-    map.clear();
+    mRanges.Clear();
     adleroffset = 0;
     adler = adler32(0L, Z_NULL, 0);
     needsRecalculation = false;
@@ -107,36 +91,8 @@ public:
     finalized = false;
   }
 
-  void
-  ResetInit(off_t offsetInit, size_t lengthInit, const char* checksumInitHex)
-  {
-    Chunk currChunk;
-    maxoffset = 0;
-    adleroffset = offsetInit + lengthInit;
-
-    // Theck if this is actually a valid pointer or a filled string
-    if ( (checksumInitHex == NULL) || (!strlen(checksumInitHex))) {
-      return;
-    }
-
-    int checksumInitBin = strtol(checksumInitHex, 0, 16);
-
-    // if a file is truncated we get 0,0,<some checksum => reset to 0
-    if (lengthInit != 0) {
-      adler = checksumInitBin;
-    } else {
-      adler = adler32(0L, Z_NULL, 0);
-    }
-
-    fprintf(stderr, "adler is %x\n", adler);
-    currChunk.offset = offsetInit;
-    currChunk.length = lengthInit;
-    currChunk.adler = adler;
-    map.clear();
-    map = AddElementToMap(map, currChunk);
-    maxoffset = (offsetInit + lengthInit);
-    needsRecalculation = false;
-  }
+  void ResetInit(off_t offsetInit, size_t lengthInit,
+                 const char* checksumInitHex);
 
   virtual
   ~Adler() { };
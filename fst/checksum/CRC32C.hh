@@ -27,6 +27,8 @@
 /*----------------------------------------------------------------------------*/
 #include "fst/Namespace.hh"
 #include "fst/checksum/CheckSum.hh"
+#include "fst/checksum/ChecksumKernels.hh"
+#include "fst/checksum/ChecksumRanges.hh"
 #include "common/crc32c/crc32c.h"
 /*----------------------------------------------------------------------------*/
 #include "XrdOuc/XrdOucEnv.hh"
@@ -34,10 +36,8 @@
 #include "XrdSys/XrdSysPthread.hh"
 /*----------------------------------------------------------------------------*/
 #include <zlib.h>
-
-#ifdef ISAL_FOUND
-#include <isa-l.h>
-#endif
+#include <cstdlib>
+#include <cstring>
 
 /*----------------------------------------------------------------------------*/
 
@@ -47,12 +47,14 @@ class CRC32C : public CheckSum
 {
 private:
   off_t crc32coffset;
+  off_t maxoffset;
   uint32_t crcsum;
   bool finalized;
+  ChecksumRanges mRanges; ///< CRC32C of the contiguous ranges added so far
 
 public:
 
-  CRC32C() : CheckSum("crc32c")
+  CRC32C() : CheckSum("crc32c"), mRanges(&Crc32cCombine)
   {
     Reset();
   }
@@ -63,26 +65,39 @@ public:
     return crc32coffset;
   }
 
+  off_t
+  GetMaxOffset()
+  {
+    return maxoffset;
+  }
+
+  bool
+  SupportsOutOfOrder() const
+  {
+    return true;
+  }
+
   bool
   Add(const char* buffer, size_t length, off_t offset)
   {
-    if (offset != crc32coffset) {
+    finalized = false;          /* handle read + append case */
+    // The ranges keep final CRC32C values so that they can be combined
+    auto update = [buffer, length](uint32_t value) {
+      return checksum::crc32cFinish(Crc32cUpdate(~value, buffer, length));
+    };
+
+    if (!mRanges.Append(offset, length, update) &&
+        !mRanges.Insert(offset, length, update(0))) {
+      // Overlapping data, the combined value is not known anymore
       needsRecalculation = true;
-      return false;
     }
 
-    if (finalized) {                /* handle read + append case, a little hackish. Alternative: set needsRecalculation */
-        crcsum = ~crcsum;           /* undo what Finalize did under the hood */
-        finalized = false;
-    }
+    crc32coffset = offset + length;
 
-#ifdef ISAL_FOUND
-    crcsum = crc32_iscsi( (unsigned char*) buffer, length, crcsum);
-#else 
-    crcsum = checksum::crc32c(crcsum, (const Bytef*) buffer, length);
-#endif
+    if (crc32coffset > maxoffset) {
+      maxoffset = crc32coffset;
+    }
 
-    crc32coffset += length;
     return true;
   }
 
@@ -119,17 +134,42 @@ public:
   void
   Reset()
   {
-    crcsum = checksum::crc32cInit();
+    mRanges.Clear();
+    crcsum = 0;
     crc32coffset = 0;
+    maxoffset = 0;
     needsRecalculation = 0;
     finalized = false;
   }
 
+  void
+  ResetInit(off_t offsetInit, size_t lengthInit, const char* checksumInitHex)
+  {
+    Reset();
+    crc32coffset = offsetInit + lengthInit;
+
+    if ((checksumInitHex == NULL) || (!strlen(checksumInitHex))) {
+      return;
+    }
+
+    // A truncated file comes with 0,0,<some checksum>
+    if (lengthInit != 0) {
+      mRanges.Insert(offsetInit, lengthInit, strtoul(checksumInitHex, 0, 16));
+    }
+
+    maxoffset = offsetInit + lengthInit;
+  }
+
   void
   Finalize()
   {
     if (!finalized) {
-      crcsum = checksum::crc32cFinish(crcsum);
+      // The ranges have to cover the whole file without any overlap
+      if (needsRecalculation || !mRanges.GetValue(maxoffset, crcsum, 0)) {
+        needsRecalculation = true;
+        crcsum = 0;
+      }
+
       finalized = true;
     }
   }
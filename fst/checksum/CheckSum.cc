@@ -36,6 +36,7 @@
 #include <sys/time.h>
 #include <sys/mman.h>
 #include <fcntl.h>
+#include <algorithm>
 #include <thread>
 #include "common/XattrCompat.hh"
 
@@ -49,6 +50,12 @@
 
 EOSFSTNAMESPACE_BEGIN
 
+/*----------------------------------------------------------------------------*/
+// Size of the pieces handled by the fused block and file checksum pass, small
+// enough to stay in the L2 cache between the two checksums
+/*----------------------------------------------------------------------------*/
+static const size_t sFusedPieceSize = 256 * 1024;
+
 /*----------------------------------------------------------------------------*/
 // Static variable + sig handler to deal with SIGBUS error
 /*----------------------------------------------------------------------------*/
@@ -263,7 +270,9 @@ CheckSum::ScanFile(const char* path, off_t offsetInit, size_t lengthInit,
   }
 
   int nread = 0;
-  off_t offset = 0;
+  // Data is added at its real offset so that it continues the initial range
+  const off_t startoffset = offsetInit + lengthInit;
+  off_t offset = startoffset;
   char* buffer = (char*) malloc(buffersize);
 
   if (!buffer) {
@@ -289,7 +298,7 @@ CheckSum::ScanFile(const char* path, off_t offsetInit, size_t lengthInit,
       gettimeofday(&currenttime, &tz);
       scantime = (((currenttime.tv_sec - opentime.tv_sec) * 1000.0) + ((
                     currenttime.tv_usec - opentime.tv_usec) / 1000.0));
-      float expecttime = (1.0 * offset / rate) / 1000.0;
+      float expecttime = (1.0 * (offset - startoffset) / rate) / 1000.0;
 
       if (expecttime > scantime) {
         usleep(1000.0 * (expecttime - scantime));
@@ -300,7 +309,7 @@ CheckSum::ScanFile(const char* path, off_t offsetInit, size_t lengthInit,
   gettimeofday(&currenttime, &tz);
   scantime = (((currenttime.tv_sec - opentime.tv_sec) * 1000.0) + ((
                 currenttime.tv_usec - opentime.tv_usec) / 1000.0));
-  scansize = (unsigned long long) offset;
+  scansize = (unsigned long long)(offset - startoffset);
   Finalize();
   close(fd);
   free(buffer);
@@ -692,6 +701,70 @@ CheckSum::CheckBlockSum(off_t offset, const char* buffer, size_t len)
   return true;
 }
 
+/*----------------------------------------------------------------------------*/
+bool
+CheckSum::AddBlockSum(off_t offset, const char* buffer, size_t len,
+                      CheckSum* file_xs)
+{
+  if (!file_xs) {
+    return AddBlockSum(offset, buffer, len);
+  }
+
+  return FusedBlockSum(offset, buffer, len, file_xs, false);
+}
+
+/*----------------------------------------------------------------------------*/
+bool
+CheckSum::CheckBlockSum(off_t offset, const char* buffer, size_t len,
+                        CheckSum* file_xs)
+{
+  if (!file_xs) {
+    return CheckBlockSum(offset, buffer, len);
+  }
+
+  return FusedBlockSum(offset, buffer, len, file_xs, true);
+}
+
+/*----------------------------------------------------------------------------*/
+bool
+CheckSum::FusedBlockSum(off_t offset, const char* buffer, size_t len,
+                        CheckSum* file_xs, bool verify)
+{
+  // Pieces are cut at block boundaries so that every block is handled by a
+  // single piece and the block map is the same as for the whole buffer
+  size_t piece_size = std::max(BlockSize, sFusedPieceSize);
+
+  if (BlockSize) {
+    piece_size -= piece_size % BlockSize;
+  }
+
+  bool retc = true;
+  size_t pos = 0;
+
+  while (pos < len) {
+    off_t end = offset + pos + piece_size;
+
+    if (BlockSize) {
+      end -= end % BlockSize;
+    }
+
+    size_t sz = std::min(len - pos, (size_t)(end - (offset + pos)));
+
+    if (retc) {
+      if (verify) {
+        retc = CheckBlockSum(offset + pos, buffer + pos, sz);
+      } else {
+        retc = AddBlockSum(offset + pos, buffer + pos, sz);
+      }
+    }
+
+    file_xs->Add(buffer + pos, sz, offset + pos);
+    pos += sz;
+  }
+
+  return retc;
+}
+
 /*----------------------------------------------------------------------------*/
 bool
 CheckSum::SetXSMap(off_t offset)
@@ -130,6 +130,18 @@ public:
   {
     return GetLastOffset();
   }
+
+  //----------------------------------------------------------------------------
+  //! Check if data can be added in any order i.e. the checksums of disjoint
+  //! pieces are combined and the checksum is only recomputed from disk if
+  //! pieces overlap or some data is missing
+  //----------------------------------------------------------------------------
+  virtual bool
+  SupportsOutOfOrder() const
+  {
+    return false;
+  }
+
   virtual int GetCheckSumLen() = 0;
 
   const char*
@@ -215,6 +227,38 @@ public:
                              size_t buffersizem); // this only verifies the checksum on full blocks, not matching edge is not calculated
   virtual bool AddBlockSumHoles(int fd);
 
+  //----------------------------------------------------------------------------
+  //! Compute the block checksums of the buffer and add the same data to the
+  //! file checksum in a single pass. The buffer is processed in block aligned
+  //! pieces which are still in the CPU cache when the file checksum walks
+  //! over them. The result is identical to AddBlockSum followed by
+  //! file_xs->Add for the whole buffer.
+  //!
+  //! @param offset file offset of the buffer
+  //! @param buffer data buffer
+  //! @param len length of the buffer
+  //! @param file_xs file checksum object, if null this is AddBlockSum
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  bool AddBlockSum(off_t offset, const char* buffer, size_t len,
+                   CheckSum* file_xs);
+
+  //----------------------------------------------------------------------------
+  //! Verify the block checksums of the buffer and add the same data to the
+  //! file checksum in a single pass. The whole buffer is added to the file
+  //! checksum even if a block checksum mismatch is detected.
+  //!
+  //! @param offset file offset of the buffer
+  //! @param buffer data buffer
+  //! @param len length of the buffer
+  //! @param file_xs file checksum object, if null this is CheckBlockSum
+  //!
+  //! @return true if all the block checksums match, otherwise false
+  //----------------------------------------------------------------------------
+  bool CheckBlockSum(off_t offset, const char* buffer, size_t len,
+                     CheckSum* file_xs);
+
   virtual const char*
   MakeBlockXSPath(const char* filepath)
   {
@@ -314,6 +358,21 @@ public:
 private:
   virtual bool SetXSMap(off_t offset);
 
+  //----------------------------------------------------------------------------
+  //! Run the block checksum computation or verification and the file
+  //! checksum update piece by piece
+  //!
+  //! @param offset file offset of the buffer
+  //! @param buffer data buffer
+  //! @param len length of the buffer
+  //! @param file_xs file checksum object
+  //! @param verify if true verify the block checksums, otherwise store them
+  //!
+  //! @return true if all block operations were successful, otherwise false
+  //----------------------------------------------------------------------------
+  bool FusedBlockSum(off_t offset, const char* buffer, size_t len,
+                     CheckSum* file_xs, bool verify);
+
   unsigned int mNumRd; ///< number of reader references
   unsigned int mNumWr; ///< number of writer references
 };
@@ -0,0 +1,466 @@
+//------------------------------------------------------------------------------
+//! @file ChecksumKernels.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2021 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "fst/checksum/ChecksumKernels.hh"
+#include "common/crc32c/crc32c.h"
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <zlib.h>
+
+#ifdef ISAL_FOUND
+#include <isa-l.h>
+#elif defined(__x86_64__)
+#include <immintrin.h>
+#define EOS_CHECKSUM_X86 1
+#endif
+
+EOSFSTNAMESPACE_BEGIN
+
+namespace
+{
+using Adler32Func = uint32_t (*)(uint32_t, const unsigned char*, size_t);
+using Crc32cFunc = uint32_t (*)(uint32_t, const unsigned char*, size_t);
+
+//------------------------------------------------------------------------------
+// zlib adler32, the length argument of zlib is only 32-bit wide
+//------------------------------------------------------------------------------
+uint32_t
+Adler32Zlib(uint32_t adler, const unsigned char* buf, size_t len)
+{
+  while (len) {
+    uInt sz = static_cast<uInt>(std::min<size_t>(len, UINT_MAX));
+    adler = adler32(adler, buf, sz);
+    buf += sz;
+    len -= sz;
+  }
+
+  return adler;
+}
+
+//------------------------------------------------------------------------------
+// Default CRC32C implementation from common/crc32c
+//------------------------------------------------------------------------------
+uint32_t
+Crc32cDefault(uint32_t crc, const unsigned char* buf, size_t len)
+{
+  return checksum::crc32c(crc, buf, len);
+}
+
+#ifdef ISAL_FOUND
+//------------------------------------------------------------------------------
+// ISA-L implementations
+//------------------------------------------------------------------------------
+uint32_t
+Adler32Isal(uint32_t adler, const unsigned char* buf, size_t len)
+{
+  while (len) {
+    uint64_t sz = std::min<size_t>(len, UINT_MAX);
+    adler = isal_adler32(adler, buf, sz);
+    buf += sz;
+    len -= sz;
+  }
+
+  return adler;
+}
+
+uint32_t
+Crc32cIsal(uint32_t crc, const unsigned char* buf, size_t len)
+{
+  while (len) {
+    int sz = static_cast<int>(std::min<size_t>(len, INT_MAX));
+    crc = crc32_iscsi(const_cast<unsigned char*>(buf), sz, crc);
+    buf += sz;
+    len -= sz;
+  }
+
+  return crc;
+}
+#endif
+
+#ifdef EOS_CHECKSUM_X86
+//! Adler32 modulus
+constexpr uint32_t kAdlerBase = 65521;
+//! Largest n such that 255n(n+1)/2 + (n+1)(kAdlerBase-1) fits in 32 bits
+constexpr size_t kAdlerNmax = 5552;
+//! Bytes per AVX2 adler32 iteration
+constexpr size_t kAdlerBlock = 32;
+//! Length of the three streams processed in parallel by the CRC32C kernel
+//! for large and small buffers
+constexpr size_t kCrcLongStream = 1024;
+constexpr size_t kCrcShortStream = 128;
+
+//------------------------------------------------------------------------------
+// Horizontal sum of the 32-bit lanes
+//------------------------------------------------------------------------------
+__attribute__((target("avx2"))) inline uint32_t
+HorizontalSum(__m256i val)
+{
+  __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(val),
+                              _mm256_extracti128_si256(val, 1));
+  sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+  sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+  return static_cast<uint32_t>(_mm_cvtsi128_si32(sum));
+}
+
+//------------------------------------------------------------------------------
+// AVX2 adler32, for a block of 32 bytes s1 is the sum of the bytes and s2
+// gets 32 * s1_prev plus the bytes weighted by 32 ... 1. The modulo is only
+// applied every kAdlerNmax bytes.
+//------------------------------------------------------------------------------
+__attribute__((target("avx2"))) uint32_t
+Adler32Avx2(uint32_t adler, const unsigned char* buf, size_t len)
+{
+  uint32_t s1 = adler & 0xffff;
+  uint32_t s2 = adler >> 16;
+  size_t num_blocks = len / kAdlerBlock;
+  len -= num_blocks * kAdlerBlock;
+  const __m256i taps = _mm256_set_epi8(1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12,
+                                       13, 14, 15, 16, 17, 18, 19, 20, 21, 22,
+                                       23, 24, 25, 26, 27, 28, 29, 30, 31, 32);
+  const __m256i ones = _mm256_set1_epi16(1);
+  const __m256i zero = _mm256_setzero_si256();
+
+  while (num_blocks) {
+    size_t n = std::min(num_blocks, kAdlerNmax / kAdlerBlock);
+    num_blocks -= n;
+    // Sum of the previous s1 values, the initial one counts n times
+    __m256i v_ps = _mm256_set_epi32(0, 0, 0, 0, 0, 0, 0, s1 * n);
+    __m256i v_s1 = zero;
+    __m256i v_s2 = _mm256_set_epi32(0, 0, 0, 0, 0, 0, 0, s2);
+
+    do {
+      const __m256i bytes = _mm256_loadu_si256((const __m256i*) buf);
+      v_ps = _mm256_add_epi32(v_ps, v_s1);
+      v_s1 = _mm256_add_epi32(v_s1, _mm256_sad_epu8(bytes, zero));
+      v_s2 = _mm256_add_epi32(v_s2, _mm256_madd_epi16(
+                                _mm256_maddubs_epi16(bytes, taps), ones));
+      buf += kAdlerBlock;
+    } while (--n);
+
+    v_s2 = _mm256_add_epi32(v_s2, _mm256_slli_epi32(v_ps, 5));
+    s1 = (s1 + HorizontalSum(v_s1)) % kAdlerBase;
+    s2 = HorizontalSum(v_s2) % kAdlerBase;
+  }
+
+  while (len--) {
+    s1 += *buf++;
+    s2 += s1;
+  }
+
+  return (s1 % kAdlerBase) | ((s2 % kAdlerBase) << 16);
+}
+
+//------------------------------------------------------------------------------
+// Multiply a bit reflected polynomial by x modulo the CRC32C polynomial
+//------------------------------------------------------------------------------
+inline uint32_t
+MultiplyX(uint32_t val)
+{
+  return (val >> 1) ^ ((val & 1) ? 0x82f63b78 : 0);
+}
+
+//------------------------------------------------------------------------------
+// Constant used to shift a CRC32C register over len zero bytes, it is
+// x^(8 * len - 33) since the carry-less multiplication of two bit reflected
+// values adds a factor x and the crc32 instruction another x^32.
+//------------------------------------------------------------------------------
+uint32_t
+ShiftConstant(size_t len)
+{
+  uint32_t val = 0x80000000; // x^0
+
+  for (size_t i = 0; i < 8 * len - 33; ++i) {
+    val = MultiplyX(val);
+  }
+
+  return val;
+}
+
+//! Shift constants for the streams of the CRC32C kernel
+struct CrcShift {
+  uint32_t mOne; ///< shift over one stream
+  uint32_t mTwo; ///< shift over two streams
+};
+
+const CrcShift&
+GetLongShift()
+{
+  static const CrcShift sShift {ShiftConstant(kCrcLongStream),
+                                ShiftConstant(2 * kCrcLongStream)};
+  return sShift;
+}
+
+const CrcShift&
+GetShortShift()
+{
+  static const CrcShift sShift {ShiftConstant(kCrcShortStream),
+                                ShiftConstant(2 * kCrcShortStream)};
+  return sShift;
+}
+
+//------------------------------------------------------------------------------
+// Shift the CRC32C register by the given constant and reduce it
+//------------------------------------------------------------------------------
+__attribute__((target("sse4.2,pclmul"))) inline uint64_t
+ShiftCrc(uint64_t crc, uint32_t constant)
+{
+  return _mm_cvtsi128_si64(_mm_clmulepi64_si128(
+                             _mm_cvtsi32_si128(static_cast<uint32_t>(crc)),
+                             _mm_cvtsi32_si128(constant), 0));
+}
+
+//------------------------------------------------------------------------------
+// Process the data in rounds of three streams of the given length, the
+// streams are independent so the crc32 instructions are pipelined. At the end
+// of a round the first two registers are shifted over the remaining streams
+// and folded into the last one.
+//------------------------------------------------------------------------------
+__attribute__((target("sse4.2,pclmul"))) uint64_t
+Crc32cStreams(uint64_t crc, const unsigned char*& buf, size_t& len,
+              size_t stream_len, const CrcShift& shift)
+{
+  while (len >= 3 * stream_len) {
+    uint64_t crc1 = 0;
+    uint64_t crc2 = 0;
+    const unsigned char* end = buf + stream_len;
+
+    do {
+      uint64_t val0, val1, val2;
+      memcpy(&val0, buf, sizeof(val0));
+      memcpy(&val1, buf + stream_len, sizeof(val1));
+      memcpy(&val2, buf + 2 * stream_len, sizeof(val2));
+      crc = _mm_crc32_u64(crc, val0);
+      crc1 = _mm_crc32_u64(crc1, val1);
+      crc2 = _mm_crc32_u64(crc2, val2);
+      buf += sizeof(uint64_t);
+    } while (buf < end);
+
+    crc = crc2 ^ _mm_crc32_u64(0, ShiftCrc(crc, shift.mTwo) ^
+                               ShiftCrc(crc1, shift.mOne));
+    buf += 2 * stream_len;
+    len -= 3 * stream_len;
+  }
+
+  return crc;
+}
+
+//------------------------------------------------------------------------------
+// SSE4.2 + PCLMUL CRC32C
+//------------------------------------------------------------------------------
+__attribute__((target("sse4.2,pclmul"))) uint32_t
+Crc32cPclmul(uint32_t crc32, const unsigned char* buf, size_t len)
+{
+  uint64_t crc = crc32;
+
+  // Align the input to 8 bytes
+  while (len && (reinterpret_cast<uintptr_t>(buf) & 7)) {
+    crc = _mm_crc32_u8(static_cast<uint32_t>(crc), *buf++);
+    --len;
+  }
+
+  crc = Crc32cStreams(crc, buf, len, kCrcLongStream, GetLongShift());
+  crc = Crc32cStreams(crc, buf, len, kCrcShortStream, GetShortShift());
+
+  for (; len >= sizeof(uint64_t); len -= sizeof(uint64_t)) {
+    uint64_t val;
+    memcpy(&val, buf, sizeof(val));
+    crc = _mm_crc32_u64(crc, val);
+    buf += sizeof(uint64_t);
+  }
+
+  while (len--) {
+    crc = _mm_crc32_u8(static_cast<uint32_t>(crc), *buf++);
+  }
+
+  return static_cast<uint32_t>(crc);
+}
+#endif
+
+//------------------------------------------------------------------------------
+//! Select adler32 implementation for the current CPU
+//------------------------------------------------------------------------------
+std::pair<Adler32Func, const char*>
+SelectAdler32Implementation()
+{
+#ifdef ISAL_FOUND
+  return {&Adler32Isal, "isa-l"};
+#else
+#ifdef EOS_CHECKSUM_X86
+  __builtin_cpu_init();
+
+  if (__builtin_cpu_supports("avx2")) {
+    return {&Adler32Avx2, "avx2"};
+  }
+
+#endif
+  return {&Adler32Zlib, "zlib"};
+#endif
+}
+
+//------------------------------------------------------------------------------
+//! Select CRC32C implementation for the current CPU
+//------------------------------------------------------------------------------
+std::pair<Crc32cFunc, const char*>
+SelectCrc32cImplementation()
+{
+#ifdef ISAL_FOUND
+  return {&Crc32cIsal, "isa-l"};
+#else
+#ifdef EOS_CHECKSUM_X86
+  __builtin_cpu_init();
+
+  if (__builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("pclmul")) {
+    // Make sure the constants are not computed on the data path
+    (void) GetLongShift();
+    (void) GetShortShift();
+    return {&Crc32cPclmul, "sse4.2+pclmul"};
+  }
+
+#endif
+  return {&Crc32cDefault, "default"};
+#endif
+}
+
+//! CRC32C polynomial in reflected bit order
+constexpr uint32_t kCrc32cPoly = 0x82f63b78;
+
+//------------------------------------------------------------------------------
+//! Multiply two polynomials modulo the CRC32C polynomial, both in reflected
+//! bit order i.e. x^0 is the most significant bit
+//------------------------------------------------------------------------------
+uint32_t
+MultiplyModP(uint32_t a, uint32_t b)
+{
+  uint32_t prod = 0;
+
+  for (uint32_t mask = 0x80000000; mask; mask >>= 1) {
+    if (a & mask) {
+      prod ^= b;
+    }
+
+    b = (b & 1) ? ((b >> 1) ^ kCrc32cPoly) : (b >> 1);
+  }
+
+  return prod;
+}
+
+//! Table of x^(2^k) modulo the CRC32C polynomial for k = 0..66 i.e. enough
+//! to shift by any 64-bit number of bytes
+struct CrcPowerTable {
+  uint32_t mPower[67];
+
+  CrcPowerTable()
+  {
+    mPower[0] = 0x40000000; // x^1
+
+    for (size_t i = 1; i < sizeof(mPower) / sizeof(mPower[0]); ++i) {
+      mPower[i] = MultiplyModP(mPower[i - 1], mPower[i - 1]);
+    }
+  }
+};
+
+const CrcPowerTable&
+GetCrcPowerTable()
+{
+  static const CrcPowerTable sTable;
+  return sTable;
+}
+
+const std::pair<Adler32Func, const char*>&
+GetAdler32Impl()
+{
+  static const std::pair<Adler32Func, const char*> sImpl =
+    SelectAdler32Implementation();
+  return sImpl;
+}
+
+const std::pair<Crc32cFunc, const char*>&
+GetCrc32cImpl()
+{
+  static const std::pair<Crc32cFunc, const char*> sImpl =
+    SelectCrc32cImplementation();
+  return sImpl;
+}
+}
+
+//------------------------------------------------------------------------------
+// Update an adler32 value
+//------------------------------------------------------------------------------
+uint32_t
+Adler32Update(uint32_t adler, const char* buffer, size_t len)
+{
+  return GetAdler32Impl().first(adler, (const unsigned char*) buffer, len);
+}
+
+//------------------------------------------------------------------------------
+// Update a CRC32C register
+//------------------------------------------------------------------------------
+uint32_t
+Crc32cUpdate(uint32_t crc, const char* buffer, size_t len)
+{
+  return GetCrc32cImpl().first(crc, (const unsigned char*) buffer, len);
+}
+
+//------------------------------------------------------------------------------
+// Combine adler32 values of two contiguous pieces
+//------------------------------------------------------------------------------
+uint32_t
+Adler32Combine(uint32_t adler1, uint32_t adler2, uint64_t len2)
+{
+  return adler32_combine(adler1, adler2, (z_off_t) len2);
+}
+
+//------------------------------------------------------------------------------
+// Combine CRC32C values of two contiguous pieces
+//------------------------------------------------------------------------------
+uint32_t
+Crc32cCombine(uint32_t crc1, uint32_t crc2, uint64_t len2)
+{
+  // crc1 * x^(8 * len2) mod P, the power is built from x^(2^k) with k >= 3
+  const CrcPowerTable& table = GetCrcPowerTable();
+  uint32_t shift = 0x80000000; // x^0
+
+  for (size_t k = 3; len2; len2 >>= 1, ++k) {
+    if (len2 & 1) {
+      shift = MultiplyModP(table.mPower[k], shift);
+    }
+  }
+
+  return MultiplyModP(shift, crc1) ^ crc2;
+}
+
+//------------------------------------------------------------------------------
+// Get description of the checksum kernels selected for the current CPU
+//------------------------------------------------------------------------------
+const char*
+GetChecksumKernelImplementation()
+{
+  static const std::string sDescription =
+    std::string("adler32=") + GetAdler32Impl().second + " crc32c=" +
+    GetCrc32cImpl().second;
+  return sDescription.c_str();
+}
+
+EOSFSTNAMESPACE_END
@@ -0,0 +1,90 @@
+//------------------------------------------------------------------------------
+//! @file ChecksumKernels.hh
+//! @brief Vectorized adler32 and CRC32C kernels selected at runtime
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2021 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+#include "fst/Namespace.hh"
+#include <cstddef>
+#include <cstdint>
+
+EOSFSTNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Update an adler32 value with the given data. Same convention as the zlib
+//! adler32 function i.e. the initial value is 1. When ISA-L is available its
+//! implementation is used, otherwise the implementation is selected at
+//! runtime depending on the CPU capabilities (AVX2, zlib).
+//!
+//! @param adler current adler32 value
+//! @param buffer data buffer
+//! @param len length of the data
+//!
+//! @return updated adler32 value
+//------------------------------------------------------------------------------
+uint32_t Adler32Update(uint32_t adler, const char* buffer, size_t len);
+
+//------------------------------------------------------------------------------
+//! Update a CRC32C register with the given data. Same convention as
+//! checksum::crc32c i.e. the register is initialized with crc32cInit and the
+//! final value is obtained with crc32cFinish. Without ISA-L the data is split
+//! in three streams processed in parallel by the SSE4.2 crc32 instruction
+//! which are then folded together using carry-less multiplication (PCLMUL).
+//!
+//! @param crc current CRC32C register
+//! @param buffer data buffer
+//! @param len length of the data
+//!
+//! @return updated CRC32C register
+//------------------------------------------------------------------------------
+uint32_t Crc32cUpdate(uint32_t crc, const char* buffer, size_t len);
+
+//------------------------------------------------------------------------------
+//! Combine the adler32 values of two contiguous pieces of data
+//!
+//! @param adler1 adler32 of the first piece
+//! @param adler2 adler32 of the second piece
+//! @param len2 length of the second piece
+//!
+//! @return adler32 of the concatenation
+//------------------------------------------------------------------------------
+uint32_t Adler32Combine(uint32_t adler1, uint32_t adler2, uint64_t len2);
+
+//------------------------------------------------------------------------------
+//! Combine the CRC32C values of two contiguous pieces of data. The values are
+//! final CRC32C values i.e. after crc32cFinish. The first one is shifted by
+//! the length of the second piece using multiplication modulo the CRC
+//! polynomial, the cost is logarithmic in len2.
+//!
+//! @param crc1 CRC32C of the first piece
+//! @param crc2 CRC32C of the second piece
+//! @param len2 length of the second piece
+//!
+//! @return CRC32C of the concatenation
+//------------------------------------------------------------------------------
+uint32_t Crc32cCombine(uint32_t crc1, uint32_t crc2, uint64_t len2);
+
+//------------------------------------------------------------------------------
+//! Get description of the checksum kernels selected for the current CPU
+//------------------------------------------------------------------------------
+const char* GetChecksumKernelImplementation();
+
+EOSFSTNAMESPACE_END
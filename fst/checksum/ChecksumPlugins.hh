@@ -32,6 +32,7 @@
 #include "fst/checksum/SHA1.hh"
 #include "fst/checksum/CRC64.hh"
 #include "fst/checksum/SHA256.hh"
+#include "XrdSys/XrdSysPthread.hh"
 
 #ifdef XXHASH_FOUND
 #include "fst/checksum/XXHASH64.hh"
@@ -109,6 +110,98 @@ public:
                             eos::common::LayoutId::GetChecksum(layoutid));
     return std::unique_ptr<CheckSum>(GetXsObj(xs_type));
   }
+
+  //----------------------------------------------------------------------------
+  //! Hand the file checksum of an Ofs write down to the Oss write of the same
+  //! buffer so that the block and the file checksum are computed in a single
+  //! pass by CheckSum::AddBlockSum(offset, buffer, len, file_xs). The scope is
+  //! thread local and only matches an Oss write with the very same buffer,
+  //! offset and length, any other write (e.g. RAIN stripes) is not fused.
+  //----------------------------------------------------------------------------
+  class FusedWriteScope
+  {
+  public:
+    //--------------------------------------------------------------------------
+    //! Constructor
+    //!
+    //! @param file_xs file checksum object, if null the scope is inactive
+    //! @param mutex mutex protecting the file checksum object
+    //! @param offset file offset of the write
+    //! @param buffer data buffer of the write
+    //! @param len length of the write
+    //--------------------------------------------------------------------------
+    FusedWriteScope(CheckSum* file_xs, XrdSysMutex* mutex, off_t offset,
+                    const char* buffer, size_t len):
+      mFileXs(file_xs), mMutex(mutex), mOffset(offset), mBuffer(buffer),
+      mLength(len), mUsed(false), mPrev(tlScope)
+    {
+      if (mFileXs) {
+        tlScope = this;
+      }
+    }
+
+    //--------------------------------------------------------------------------
+    //! Destructor
+    //--------------------------------------------------------------------------
+    ~FusedWriteScope()
+    {
+      if (mFileXs) {
+        tlScope = mPrev;
+      }
+    }
+
+    FusedWriteScope(const FusedWriteScope&) = delete;
+    FusedWriteScope& operator=(const FusedWriteScope&) = delete;
+
+    //--------------------------------------------------------------------------
+    //! Compute the block checksums of the buffer and, if the current thread
+    //! is inside a matching scope, add the buffer to its file checksum too
+    //!
+    //! @param block_xs block checksum object
+    //! @param offset file offset of the buffer
+    //! @param buffer data buffer
+    //! @param len length of the buffer
+    //!
+    //! @return true if successful, otherwise false
+    //--------------------------------------------------------------------------
+    static bool
+    AddBlockSum(CheckSum* block_xs, off_t offset, const char* buffer,
+                size_t len)
+    {
+      FusedWriteScope* scope = tlScope;
+
+      if (!scope || scope->mUsed || (scope->mOffset != offset) ||
+          (scope->mBuffer != buffer) || (scope->mLength != len)) {
+        return block_xs->AddBlockSum(offset, buffer, len);
+      }
+
+      scope->mUsed = true;
+      XrdSysMutexHelper lock(*scope->mMutex);
+      return block_xs->AddBlockSum(offset, buffer, len, scope->mFileXs);
+    }
+
+    //--------------------------------------------------------------------------
+    //! Check if the file checksum was already updated by the Oss write
+    //--------------------------------------------------------------------------
+    inline bool
+    Used() const
+    {
+      return mUsed;
+    }
+
+  private:
+    static thread_local FusedWriteScope* tlScope;
+    CheckSum* mFileXs; ///< File checksum object
+    XrdSysMutex* mMutex; ///< Mutex protecting the file checksum object
+    off_t mOffset; ///< Offset of the write
+    const char* mBuffer; ///< Buffer of the write
+    size_t mLength; ///< Length of the write
+    bool mUsed; ///< True if the file checksum was updated
+    FusedWriteScope* mPrev; ///< Enclosing scope of the same thread
+  };
 };
 
+inline thread_local ChecksumPlugins::FusedWriteScope*
+ChecksumPlugins::FusedWriteScope::tlScope = nullptr;
+
 EOSFSTNAMESPACE_END
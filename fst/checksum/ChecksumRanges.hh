@@ -0,0 +1,279 @@
+//------------------------------------------------------------------------------
+//! @file ChecksumRanges.hh
+//! @brief Checksums of disjoint file ranges combined as soon as they become
+//!        contiguous
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2021 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+#include "fst/Namespace.hh"
+#include <cstdint>
+#include <iterator>
+#include <map>
+#include <sys/types.h>
+
+EOSFSTNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Class ChecksumRanges - keeps the checksum of every contiguous range of a
+//! file written so far. The checksum algorithm has to provide a combine
+//! function giving the checksum of the concatenation of two pieces from their
+//! checksums and the length of the second one (e.g. adler32_combine). This
+//! way data added out of order, for example by parallel streams, yields the
+//! checksum of the whole file once all the holes are filled.
+//!
+//! The range starting at offset 0 is kept outside of the map since for
+//! sequential writes it is the only one and extending it is allocation free.
+//------------------------------------------------------------------------------
+class ChecksumRanges
+{
+public:
+  //! Combine checksums of two contiguous pieces
+  using CombineFunc = uint32_t (*)(uint32_t first, uint32_t second,
+                                   uint64_t second_len);
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param combine combine function of the checksum algorithm
+  //----------------------------------------------------------------------------
+  explicit ChecksumRanges(CombineFunc combine):
+    mCombine(combine), mHeadLength(-1), mHeadValue(0)
+  {}
+
+  //----------------------------------------------------------------------------
+  //! Remove all ranges
+  //----------------------------------------------------------------------------
+  void Clear()
+  {
+    mHeadLength = -1;
+    mHeadValue = 0;
+    mRanges.clear();
+  }
+
+  //----------------------------------------------------------------------------
+  //! Extend the range ending at the given offset by continuing its checksum
+  //! computation over the new data, this avoids a combine for sequential
+  //! writes.
+  //!
+  //! @param offset offset of the new data
+  //! @param length length of the new data
+  //! @param update function computing the checksum of the range extended by
+  //!        the new data given the checksum of the range
+  //!
+  //! @return true if extended, false if there is no range ending at the
+  //!         given offset or the new data overlaps the next range
+  //----------------------------------------------------------------------------
+  template <typename UpdateFunc>
+  bool Append(off_t offset, uint64_t length, UpdateFunc&& update)
+  {
+    if (length == 0) {
+      return true;
+    }
+
+    if (mHeadLength == offset) {
+      if (Overlaps(offset, length)) {
+        return false;
+      }
+
+      mHeadValue = update(mHeadValue);
+      mHeadLength += length;
+      MergeRight(mHeadLength, mHeadLength, mHeadValue);
+      return true;
+    }
+
+    auto it = mRanges.lower_bound(offset);
+
+    if (it == mRanges.begin()) {
+      return false;
+    }
+
+    --it;
+
+    if ((it->first + (off_t) it->second.mLength != offset) ||
+        Overlaps(offset, length)) {
+      return false;
+    }
+
+    it->second.mValue = update(it->second.mValue);
+    it->second.mLength += length;
+    off_t end = it->first + it->second.mLength;
+    MergeRight(end, it->second.mLength, it->second.mValue);
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Add range with its own checksum and combine it with the neighbouring
+  //! ranges
+  //!
+  //! @param offset offset of the range
+  //! @param length length of the range
+  //! @param value checksum of the range alone
+  //!
+  //! @return true if added, false if the range overlaps existing data in
+  //!         which case the combined checksum can not be computed anymore
+  //----------------------------------------------------------------------------
+  bool Insert(off_t offset, uint64_t length, uint32_t value)
+  {
+    if (length == 0) {
+      return true;
+    }
+
+    if (Overlaps(offset, length)) {
+      return false;
+    }
+
+    if (offset == 0) {
+      mHeadLength = length;
+      mHeadValue = value;
+      MergeRight(mHeadLength, mHeadLength, mHeadValue);
+      return true;
+    }
+
+    if (mHeadLength == offset) {
+      mHeadValue = mCombine(mHeadValue, value, length);
+      mHeadLength += length;
+      MergeRight(mHeadLength, mHeadLength, mHeadValue);
+      return true;
+    }
+
+    auto it = mRanges.lower_bound(offset);
+
+    if (it != mRanges.begin()) {
+      auto prev = std::prev(it);
+
+      if (prev->first + (off_t) prev->second.mLength == offset) {
+        prev->second.mValue = mCombine(prev->second.mValue, value, length);
+        prev->second.mLength += length;
+        off_t end = prev->first + prev->second.mLength;
+        MergeRight(end, prev->second.mLength, prev->second.mValue);
+        return true;
+      }
+    }
+
+    auto& range = mRanges[offset];
+    range.mLength = length;
+    range.mValue = value;
+    MergeRight(offset + length, range.mLength, range.mValue);
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get checksum of the file if the ranges cover exactly [0, length)
+  //!
+  //! @param length expected length of the file
+  //! @param value checksum of the file
+  //! @param empty_value checksum of an empty file
+  //!
+  //! @return true if the checksum is known, otherwise false
+  //----------------------------------------------------------------------------
+  bool GetValue(off_t length, uint32_t& value, uint32_t empty_value) const
+  {
+    if (!mRanges.empty()) {
+      return false;
+    }
+
+    if (mHeadLength == -1) {
+      if (length == 0) {
+        value = empty_value;
+        return true;
+      }
+
+      return false;
+    }
+
+    if (mHeadLength != length) {
+      return false;
+    }
+
+    value = mHeadValue;
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get number of disjoint ranges
+  //----------------------------------------------------------------------------
+  size_t GetNumRanges() const
+  {
+    return mRanges.size() + ((mHeadLength == -1) ? 0 : 1);
+  }
+
+private:
+  //! Range not starting at offset 0
+  struct Range {
+    uint64_t mLength;
+    uint32_t mValue;
+  };
+
+  //----------------------------------------------------------------------------
+  //! Check if the given piece overlaps any existing range
+  //----------------------------------------------------------------------------
+  bool Overlaps(off_t offset, uint64_t length) const
+  {
+    off_t end = offset + (off_t) length;
+
+    if ((mHeadLength > 0) && (offset < mHeadLength)) {
+      return true;
+    }
+
+    auto it = mRanges.lower_bound(offset);
+
+    if ((it != mRanges.end()) && (it->first < end)) {
+      return true;
+    }
+
+    if (it != mRanges.begin()) {
+      --it;
+
+      if (it->first + (off_t) it->second.mLength > offset) {
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Merge the range starting at the given offset, if any, into the range
+  //! ending there
+  //!
+  //! @param end end offset of the left range
+  //! @param length length of the left range, updated
+  //! @param value checksum of the left range, updated
+  //----------------------------------------------------------------------------
+  template <typename LengthT>
+  void MergeRight(off_t end, LengthT& length, uint32_t& value)
+  {
+    auto it = mRanges.find(end);
+
+    if (it != mRanges.end()) {
+      value = mCombine(value, it->second.mValue, it->second.mLength);
+      length += it->second.mLength;
+      mRanges.erase(it);
+    }
+  }
+
+  CombineFunc mCombine;
+  off_t mHeadLength; ///< Length of the range starting at 0, -1 if none
+  uint32_t mHeadValue; ///< Checksum of the range starting at 0
+  std::map<off_t, Range> mRanges; ///< Other ranges indexed by start offset
+};
+
+EOSFSTNAMESPACE_END
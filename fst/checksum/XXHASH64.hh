@@ -37,6 +37,12 @@
 
 EOSFSTNAMESPACE_BEGIN
 
+//------------------------------------------------------------------------------
+//! Class XXHASH64 - there is no vectorized kernel for it in ChecksumKernels,
+//! the four-lane XXH64 loop of libxxhash is a chain of dependent 64-bit
+//! multiplies which does not gain from SIMD. It is used as is and only
+//! profits from the single pass of CheckSum::AddBlockSum with a file_xs.
+//------------------------------------------------------------------------------
 class XXHASH64 : public CheckSum
 {
 private:
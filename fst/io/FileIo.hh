@@ -31,6 +31,7 @@
 #include "fst/XrdFstOfsFile.hh"
 #include <string>
 #include <list>
+#include <functional>
 #include <future>
 
 EOSFSTNAMESPACE_BEGIN
@@ -135,6 +136,54 @@ public:
   virtual int64_t fileReadAsync(XrdSfsFileOffset offset, char* buffer,
                                 XrdSfsXferSize length, uint16_t timeout = 0) = 0;
 
+  //----------------------------------------------------------------------------
+  //! Read from file - async
+  //!
+  //! @param buffer where the data is read
+  //! @param offset offset in file
+  //! @param length read length
+  //! @param timeout timeout value
+  //!
+  //! @return future holding the status response, reading less than length
+  //!         bytes is reported as an error
+  //! @note The default implementation does a synchronous read
+  //----------------------------------------------------------------------------
+  virtual std::future<XrdCl::XRootDStatus>
+  fileReadAsync(char* buffer, XrdSfsFileOffset offset, XrdSfsXferSize length,
+                uint16_t timeout)
+  {
+    std::promise<XrdCl::XRootDStatus> rd_promise;
+
+    if (fileRead(offset, buffer, length, timeout) == length) {
+      rd_promise.set_value(XrdCl::XRootDStatus());
+    } else {
+      rd_promise.set_value(XrdCl::XRootDStatus(XrdCl::stError,
+                           XrdCl::errOSError, EIO));
+    }
+
+    return rd_promise.get_future();
+  }
+
+  //----------------------------------------------------------------------------
+  //! Read from file - async with completion callback
+  //!
+  //! @param offset offset in file
+  //! @param buffer where the data is read
+  //! @param length read length
+  //! @param cb callback receiving the number of bytes read or -errno, it can
+  //!        run in a different thread
+  //!
+  //! @note The default implementation does a synchronous read and runs the
+  //!       callback before returning
+  //----------------------------------------------------------------------------
+  virtual void
+  fileReadAsync(XrdSfsFileOffset offset, char* buffer, XrdSfsXferSize length,
+                std::function<void(int64_t)> cb)
+  {
+    int64_t nread = fileRead(offset, buffer, length);
+    cb((nread < 0) ? -(errno ? errno : EIO) : nread);
+  }
+
   //----------------------------------------------------------------------------
   //! Vector read - sync
   //!
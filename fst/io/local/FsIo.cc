@@ -23,6 +23,10 @@
 
 #include "fst/XrdFstOfsFile.hh"
 #include "fst/io/local/FsIo.hh"
+#include "fst/io/local/UringQueue.hh"
+#include "fst/io/AsyncMetaHandler.hh"
+#include "fst/io/ChunkHandler.hh"
+#include "fst/io/VectChunkHandler.hh"
 #include "common/XattrCompat.hh"
 
 #ifndef __APPLE__
@@ -30,6 +34,7 @@
 #endif
 #undef __USE_FILE_OFFSET64
 #include <fts.h>
+#include <atomic>
 
 EOSFSTNAMESPACE_BEGIN
 
@@ -37,16 +42,21 @@ EOSFSTNAMESPACE_BEGIN
 // Constructor
 //------------------------------------------------------------------------------
 FsIo::FsIo(std::string path) :
-  FileIo(path, "FsIo"), mFd(-1)
-{
-}
+  FsIo(path, "FsIo")
+{}
 
 //------------------------------------------------------------------------------
 // Constructor
 //------------------------------------------------------------------------------
 FsIo::FsIo(std::string path, std::string iotype) :
-  FileIo(path, iotype), mFd(-1)
+  FileIo(path, iotype), mFd(-1), mRingFd(-1), mUseUring(false),
+  mMetaHandler(nullptr)
 {
+  if (UringQueue::IsEnabledFor(mFilePath) &&
+      UringQueue::Instance().IsAvailable()) {
+    mUseUring = true;
+    mMetaHandler = new AsyncMetaHandler();
+  }
 }
 
 //------------------------------------------------------------------------------
@@ -57,6 +67,8 @@ FsIo::~FsIo()
   if (mFd != -1) {
     fileClose(mFd);
   }
+
+  delete mMetaHandler;
 }
 
 //------------------------------------------------------------------------------
@@ -69,6 +81,7 @@ FsIo::fileOpen(XrdSfsFileOpenMode flags, mode_t mode, const std::string& opaque,
   mFd = ::open(mFilePath.c_str(), flags, mode);
 
   if (mFd > 0) {
+    EnableRing(mFd);
     return 0;
   } else {
     mFd = -1;
@@ -83,6 +96,11 @@ int64_t
 FsIo::fileRead(XrdSfsFileOffset offset, char* buffer, XrdSfsXferSize length,
                uint16_t timeout)
 {
+  // Read after write, the data of the writes in flight has to be there
+  if (fileWaitAsyncIO()) {
+    return SFS_ERROR;
+  }
+
   return ::pread(mFd, buffer, length, offset);
 }
 
@@ -97,13 +115,72 @@ FsIo::fileReadPrefetch(XrdSfsFileOffset offset, char* buffer,
 }
 
 //------------------------------------------------------------------------------
-// Read from file asynchronously - falls back to synchronous mode
+// Read from file asynchronously - without io_uring falls back to synchronous
+// mode
 //------------------------------------------------------------------------------
 int64_t
 FsIo::fileReadAsync(XrdSfsFileOffset offset, char* buffer,
                     XrdSfsXferSize length, uint16_t timeout)
 {
-  return fileRead(offset, buffer, length, timeout);
+  if (mRingFd < 0) {
+    return fileRead(offset, buffer, length, timeout);
+  }
+
+  ChunkHandler* handler = mMetaHandler->Register(offset, length, buffer,
+                          false);
+
+  if (!handler) {
+    return SFS_ERROR;
+  }
+
+  UringQueue::Instance().Submit(UringQueue::Request{
+    false, mRingFd, buffer, static_cast<uint32_t>(length), offset,
+    [handler, offset, buffer](int64_t retc) {
+      XrdCl::XRootDStatus* status = new XrdCl::XRootDStatus();
+      XrdCl::AnyObject* response = nullptr;
+
+      if (retc < 0) {
+        *status = XrdCl::XRootDStatus(XrdCl::stError, XrdCl::errOSError, -retc);
+      } else {
+        response = new XrdCl::AnyObject();
+        response->Set(new XrdCl::ChunkInfo(offset, retc, buffer));
+      }
+
+      handler->HandleResponse(status, response);
+    }
+  });
+  return length;
+}
+
+//------------------------------------------------------------------------------
+// Read from file asynchronously with completion callback
+//------------------------------------------------------------------------------
+void
+FsIo::fileReadAsync(XrdSfsFileOffset offset, char* buffer,
+                    XrdSfsXferSize length, std::function<void(int64_t)> cb)
+{
+  if (mRingFd < 0) {
+    FileIo::fileReadAsync(offset, buffer, length, std::move(cb));
+    return;
+  }
+
+  // Registered only so that close waits for it, a failure is reported just
+  // to the callback
+  ChunkHandler* handler = mMetaHandler->Register(offset, length, buffer,
+                          false);
+
+  if (!handler) {
+    cb(-EIO);
+    return;
+  }
+
+  UringQueue::Instance().Submit(UringQueue::Request{
+    false, mRingFd, buffer, static_cast<uint32_t>(length), offset,
+    [handler, cb](int64_t retc) {
+      cb(retc);
+      handler->HandleResponse(new XrdCl::XRootDStatus(), nullptr);
+    }
+  });
 }
 
 //------------------------------------------------------------------------------
@@ -117,13 +194,50 @@ FsIo::fileWrite(XrdSfsFileOffset offset, const char* buffer,
 }
 
 //------------------------------------------------------------------------------
-// Write to file async - falls back on synchronous mode
+// Write to file async - without io_uring falls back on synchronous mode
 //------------------------------------------------------------------------------
 int64_t
 FsIo::fileWriteAsync(XrdSfsFileOffset offset, const char* buffer,
                      XrdSfsXferSize length, uint16_t timeout)
 {
-  return fileWrite(offset, buffer, length, timeout);
+  if (mRingFd < 0) {
+    return fileWrite(offset, buffer, length, timeout);
+  }
+
+  // The caller is free to reuse its buffer once we return so the data is
+  // copied, preferably into a buffer registered with the ring. Otherwise the
+  // handler keeps its own copy.
+  UringQueue& queue = UringQueue::Instance();
+  char* fixed_buff = nullptr;
+  int fixed_index = queue.AcquireFixedBuffer(length, fixed_buff);
+  ChunkHandler* handler = mMetaHandler->Register(offset, length,
+                          fixed_buff ? fixed_buff : (char*)buffer,
+                          fixed_buff == nullptr);
+
+  // If previous write requests failed then we won't get a new handler
+  if (!handler) {
+    queue.ReleaseFixedBuffer(fixed_index);
+    return SFS_ERROR;
+  }
+
+  if (fixed_buff) {
+    memcpy(fixed_buff, buffer, length);
+  }
+
+  queue.Submit(UringQueue::Request{
+    true, mRingFd, handler->GetBuffer(), static_cast<uint32_t>(length), offset,
+    [handler, length](int64_t retc) {
+      XrdCl::XRootDStatus* status = new XrdCl::XRootDStatus();
+
+      if (retc != length) {
+        *status = XrdCl::XRootDStatus(XrdCl::stError, XrdCl::errOSError,
+                                      (retc < 0) ? -retc : EIO);
+      }
+
+      handler->HandleResponse(status, nullptr);
+    }, fixed_index
+  });
+  return length;
 }
 
 //----------------------------------------------------------------------------
@@ -133,26 +247,149 @@ std::future<XrdCl::XRootDStatus>
 FsIo::fileWriteAsync(const char* buffer, XrdSfsFileOffset offset,
                      XrdSfsXferSize length)
 {
-  std::promise<XrdCl::XRootDStatus> wr_promise;
-  std::future<XrdCl::XRootDStatus> wr_future = wr_promise.get_future();
+  auto wr_promise = std::make_shared<std::promise<XrdCl::XRootDStatus>>();
+  std::future<XrdCl::XRootDStatus> wr_future = wr_promise->get_future();
+
+  if (mRingFd >= 0) {
+    // The caller keeps the buffer alive until the future is ready so the
+    // handler does not copy it, it just makes close wait for the write and
+    // report its failure like for the other async writes
+    ChunkHandler* handler = mMetaHandler->Register(offset, length,
+                            const_cast<char*>(buffer), false);
+
+    if (!handler) {
+      wr_promise->set_value(XrdCl::XRootDStatus(XrdCl::stError,
+                            XrdCl::errUnknown, EIO, "failed write"));
+      return wr_future;
+    }
+
+    UringQueue::Instance().Submit(UringQueue::Request{
+      true, mRingFd, const_cast<char*>(buffer), static_cast<uint32_t>(length),
+      offset, [wr_promise, handler, length](int64_t retc) {
+        XrdCl::XRootDStatus* status = new XrdCl::XRootDStatus();
+
+        if (retc != length) {
+          *status = XrdCl::XRootDStatus(XrdCl::stError, XrdCl::errOSError,
+                                        (retc < 0) ? -retc : EIO);
+          wr_promise->set_value(XrdCl::XRootDStatus(XrdCl::stError,
+                                XrdCl::errUnknown, EIO, "failed write"));
+        } else {
+          wr_promise->set_value(XrdCl::XRootDStatus(XrdCl::stOK, ""));
+        }
+
+        handler->HandleResponse(status, nullptr);
+      }
+    });
+    return wr_future;
+  }
+
   int64_t nwrite = fileWrite(offset, buffer, length);
 
   if (nwrite != length) {
-    wr_promise.set_value(XrdCl::XRootDStatus(XrdCl::stError, XrdCl::errUnknown,
-                         EIO, "failed write"));
+    wr_promise->set_value(XrdCl::XRootDStatus(XrdCl::stError, XrdCl::errUnknown,
+                          EIO, "failed write"));
   } else {
-    wr_promise.set_value(XrdCl::XRootDStatus(XrdCl::stOK, ""));
+    wr_promise->set_value(XrdCl::XRootDStatus(XrdCl::stOK, ""));
   }
 
   return wr_future;
 }
 
+//------------------------------------------------------------------------------
+// Vector read - async, all the chunks are submitted as one batch
+//------------------------------------------------------------------------------
+int64_t
+FsIo::fileReadVAsync(XrdCl::ChunkList& chunkList, uint16_t timeout)
+{
+  if (mRingFd < 0) {
+    errno = EOPNOTSUPP;
+    return SFS_ERROR;
+  }
+
+  VectChunkHandler* vhandler = mMetaHandler->Register(chunkList, NULL, false);
+
+  if (!vhandler) {
+    return SFS_ERROR;
+  }
+
+  //! State shared by the chunks of the same vector request
+  struct VectState {
+    std::atomic<uint32_t> mRemaining;
+    std::atomic<uint64_t> mNumBytes {0};
+    std::atomic<int> mErrno {0};
+  };
+
+  auto state = std::make_shared<VectState>();
+  state->mRemaining = chunkList.size();
+  int64_t nread = vhandler->GetLength();
+  std::vector<UringQueue::Request> batch;
+  batch.reserve(chunkList.size());
+
+  for (const auto& chunk : chunkList) {
+    batch.push_back(UringQueue::Request{
+      false, mRingFd, static_cast<char*>(chunk.buffer), chunk.length,
+      static_cast<off_t>(chunk.offset),
+      [state, vhandler](int64_t retc) {
+        if (retc < 0) {
+          state->mErrno = -retc;
+        } else {
+          state->mNumBytes += retc;
+        }
+
+        if (--state->mRemaining) {
+          return;
+        }
+
+        XrdCl::XRootDStatus* status = new XrdCl::XRootDStatus();
+        XrdCl::AnyObject* response = nullptr;
+
+        if (state->mErrno) {
+          *status = XrdCl::XRootDStatus(XrdCl::stError, XrdCl::errOSError,
+                                        state->mErrno);
+        } else {
+          XrdCl::VectorReadInfo* vrd_info = new XrdCl::VectorReadInfo();
+          vrd_info->SetSize(state->mNumBytes);
+          response = new XrdCl::AnyObject();
+          response->Set(vrd_info);
+        }
+
+        vhandler->HandleResponse(status, response);
+      }
+    });
+  }
+
+  UringQueue::Instance().Submit(batch);
+  return nread;
+}
+
+//------------------------------------------------------------------------------
+// Wait for async IO - also called before any synchronous operation on the
+// file descriptor, so that it sees the io_uring requests in flight and fails
+// if any of them failed
+//------------------------------------------------------------------------------
+int
+FsIo::fileWaitAsyncIO()
+{
+  if (mMetaHandler && (mMetaHandler->WaitOK() != XrdCl::errNone)) {
+    eos_err("error=async requests failed for file path=%s", mFilePath.c_str());
+    errno = EIO;
+    return SFS_ERROR;
+  }
+
+  return SFS_OK;
+}
+
 //------------------------------------------------------------------------------
 // Truncate file
 //------------------------------------------------------------------------------
 int
 FsIo::fileTruncate(XrdSfsFileOffset offset, uint16_t timeout)
 {
+  // A write in flight could otherwise extend the file again
+  if (fileWaitAsyncIO()) {
+    return SFS_ERROR;
+  }
+
   return ::ftruncate(mFd, offset);
 }
 
@@ -239,6 +476,10 @@ FsIo::fileFdeallocate(XrdSfsFileOffset fromOffset,
 int
 FsIo::fileSync(uint16_t timeout)
 {
+  if (fileWaitAsyncIO()) {
+    return SFS_ERROR;
+  }
+
   return ::fsync(mFd);
 }
 
@@ -249,6 +490,11 @@ int
 FsIo::fileStat(struct stat* buf, uint16_t timeout)
 {
   if (mFd > 0) {
+    // The size has to include the writes in flight
+    if (fileWaitAsyncIO()) {
+      return SFS_ERROR;
+    }
+
     return ::fstat(mFd, buf);
   } else {
     return ::stat(mFilePath.c_str(), buf);
@@ -261,9 +507,12 @@ FsIo::fileStat(struct stat* buf, uint16_t timeout)
 int
 FsIo::fileClose(uint16_t timeout)
 {
+  // Requests in flight still reference the file descriptor
+  int async_rc = fileWaitAsyncIO();
+  mRingFd = -1;
   int rc = ::close(mFd);
   mFd = -1;
-  return rc;
+  return (rc ? rc : async_rc);
 }
 
 //------------------------------------------------------------------------------
@@ -297,7 +546,7 @@ FsIo::fileExists()
 void*
 FsIo::fileGetAsyncHandler()
 {
-  return NULL;
+  return static_cast<void*>(mMetaHandler);
 }
 
 //------------------------------------------------------------------------------
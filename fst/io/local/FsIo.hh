@@ -28,6 +28,8 @@
 #include "fst/io/FileIo.hh"
 
 EOSFSTNAMESPACE_BEGIN
+
+class AsyncMetaHandler;
 //------------------------------------------------------------------------------
 //! Class used for doing local IO operations
 //------------------------------------------------------------------------------
@@ -93,10 +95,26 @@ public:
   //! @param timeout timeout value
   //!
   //! @return number of bytes read or -1 if error
+  //! @note When io_uring is enabled the buffer is not neccessarily populated
+  //!       with any meaningful data when this function returns. The user
+  //!       should call fileWaitAsyncIO to enforce this guarantee.
   //----------------------------------------------------------------------------
   virtual int64_t fileReadAsync(XrdSfsFileOffset offset, char* buffer,
                                 XrdSfsXferSize length, uint16_t timeout = 0);
 
+  //----------------------------------------------------------------------------
+  //! Read from file - async with completion callback
+  //!
+  //! @param offset offset in file
+  //! @param buffer where the data is read
+  //! @param length read length
+  //! @param cb callback receiving the number of bytes read or -errno, with
+  //!        io_uring it runs in the thread reaping the completions
+  //----------------------------------------------------------------------------
+  virtual void fileReadAsync(XrdSfsFileOffset offset, char* buffer,
+                             XrdSfsXferSize length,
+                             std::function<void(int64_t)> cb);
+
   //----------------------------------------------------------------------------
   //! Read from file with prefetching
   //!
@@ -147,13 +165,10 @@ public:
   //! @param timeout timeout value
   //!
   //! @return 0(SFS_OK) if request successfully sent, otherwise -1 (SFS_ERROR)
+  //! @note Only supported when io_uring is enabled for the file
   //----------------------------------------------------------------------------
   virtual int64_t fileReadVAsync(XrdCl::ChunkList& chunkList,
-                                 uint16_t timeout = 0)
-  {
-    errno = EOPNOTSUPP;
-    return -1;
-  }
+                                 uint16_t timeout = 0);
 
   //----------------------------------------------------------------------------
   //! Write to file - async
@@ -183,6 +198,14 @@ public:
   fileWriteAsync(const char* buffer, XrdSfsFileOffset offset,
                  XrdSfsXferSize length);
 
+  //----------------------------------------------------------------------------
+  //! Wait for all async IO, fileRead, fileStat, fileSync and fileTruncate
+  //! do this first as well
+  //!
+  //! @return global return code of async IO
+  //----------------------------------------------------------------------------
+  virtual int fileWaitAsyncIO();
+
   //----------------------------------------------------------------------------
   //! Truncate
   //!
@@ -418,8 +441,42 @@ public:
   //----------------------------------------------------------------------------
   virtual int ftsClose(FileIo::FtsHandle* fts_handle);
 
+protected:
+  //----------------------------------------------------------------------------
+  //! Send the async requests through the io_uring queue using the given file
+  //! descriptor, no-op unless io_uring is enabled for the file path
+  //----------------------------------------------------------------------------
+  void EnableRing(int fd)
+  {
+    if (mUseUring) {
+      mRingFd = fd;
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  //! Stop sending async requests through the io_uring queue, the requests
+  //! in flight have to be waited for with fileWaitAsyncIO
+  //----------------------------------------------------------------------------
+  void DisableRing()
+  {
+    mRingFd = -1;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Check if the async requests go through the io_uring queue
+  //----------------------------------------------------------------------------
+  bool IsRingEnabled() const
+  {
+    return (mRingFd >= 0);
+  }
+
 private:
   int mFd; //< file descriptor to filesystem file
+  int mRingFd; //< file descriptor used by the io_uring requests or -1
+  //! Mark if io_uring is enabled for the file path
+  bool mUseUring;
+  //! Async requests meta handler, only used together with io_uring
+  AsyncMetaHandler* mMetaHandler;
 
   //----------------------------------------------------------------------------
   //! Disable copy constructor
@@ -25,6 +25,8 @@
 #include "fst/io/local/LocalIo.hh"
 #include "fst/io/local/FsIo.hh"
 #include "common/XattrCompat.hh"
+#include "common/LayoutId.hh"
+#include "XrdOuc/XrdOucEnv.hh"
 
 #ifndef __APPLE__
 #include <xfs/xfs.h>
@@ -75,6 +77,22 @@ LocalIo::fileOpen(XrdSfsFileOpenMode flags, mode_t mode,
     eos_err("error= openofs failed errno=%d retc=%d", errno, retc);
   } else {
     mIsOpen = true;
+    // Async reads can bypass the OSS layer and go through io_uring unless
+    // the OSS file verifies block checksums or uses direct IO which needs
+    // aligned buffers
+    XrdOucEnv env(opaque.c_str());
+    const char* val = env.Get("mgm.lid");
+    unsigned long lid = (val ? strtoul(val, nullptr, 10) : 0ul);
+    val = env.Get("mgm.ioflag");
+
+    if ((eos::common::LayoutId::GetBlockChecksum(lid) ==
+         eos::common::LayoutId::kNone) && !(val && !strcmp(val, "direct"))) {
+      XrdOucErrInfo error;
+
+      if (mLogicalFile->XrdOfsFile::fctl(SFS_FCTL_GETFD, 0, error) == SFS_OK) {
+        EnableRing(error.getErrInfo());
+      }
+    }
   }
 
   return retc;
@@ -104,13 +122,29 @@ LocalIo::fileReadPrefetch(XrdSfsFileOffset offset, char* buffer,
 }
 
 //------------------------------------------------------------------------------
-// Read from file asynchronously - falls back to sync mode
+// Read from file asynchronously - without io_uring falls back to sync mode
 //------------------------------------------------------------------------------
 int64_t
 LocalIo::fileReadAsync(XrdSfsFileOffset offset, char* buffer,
                        XrdSfsXferSize length, uint16_t timeout)
 {
-  return fileRead(offset, buffer, length, timeout);
+  return FsIo::fileReadAsync(offset, buffer, length, timeout);
+}
+
+//------------------------------------------------------------------------------
+// Read from file asynchronously with completion callback
+//------------------------------------------------------------------------------
+void
+LocalIo::fileReadAsync(XrdSfsFileOffset offset, char* buffer,
+                       XrdSfsXferSize length, std::function<void(int64_t)> cb)
+{
+  // The read bypasses readofs so it's accounted here, without io_uring the
+  // synchronous fallback goes through readofs
+  if (IsRingEnabled()) {
+    mLogicalFile->AccountRead(offset, length);
+  }
+
+  FsIo::fileReadAsync(offset, buffer, length, std::move(cb));
 }
 
 //------------------------------------------------------------------------------
@@ -135,11 +169,15 @@ LocalIo::fileReadV(XrdCl::ChunkList& chunkList, uint16_t timeout)
 }
 
 //--------------------------------------------------------------------------
-// Vector read - async - in this case it is the same as the sync one
+// Vector read - async - without io_uring it is the same as the sync one
 //--------------------------------------------------------------------------
 int64_t
 LocalIo::fileReadVAsync(XrdCl::ChunkList& chunkList, uint16_t timeout)
 {
+  if (IsRingEnabled()) {
+    return FsIo::fileReadVAsync(chunkList, timeout);
+  }
+
   return fileReadV(chunkList, timeout);
 }
 
@@ -329,8 +367,12 @@ LocalIo::fileExists()
 int
 LocalIo::fileClose(uint16_t timeout)
 {
+  // Requests in flight use the file descriptor owned by the OSS file
+  int async_rc = fileWaitAsyncIO();
+  DisableRing();
   mIsOpen = false;
-  return mLogicalFile->closeofs();
+  int rc = mLogicalFile->closeofs();
+  return (rc ? rc : async_rc);
 }
 
 //------------------------------------------------------------------------------
@@ -96,6 +96,17 @@ public:
   int64_t fileReadAsync(XrdSfsFileOffset offset, char* buffer,
                         XrdSfsXferSize length, uint16_t timeout = 0);
 
+  //----------------------------------------------------------------------------
+  //! Read from file - async with completion callback
+  //!
+  //! @param offset offset in file
+  //! @param buffer where the data is read
+  //! @param length read length
+  //! @param cb callback receiving the number of bytes read or -errno
+  //----------------------------------------------------------------------------
+  void fileReadAsync(XrdSfsFileOffset offset, char* buffer,
+                     XrdSfsXferSize length, std::function<void(int64_t)> cb);
+
   //----------------------------------------------------------------------------
   //! Read from file with prefetching
   //!
@@ -126,8 +137,8 @@ public:
   //! @param chunkList list of chunks for the vector read
   //! @param timeout timeout value
   //!
-  //! @return number of bytes read of -1 if error; this actually calls the
-  //!         ReadV sync method
+  //! @return number of bytes read of -1 if error; without io_uring this
+  //!         actually calls the ReadV sync method
   //------------------------------------------------------------------------------
   virtual int64_t fileReadVAsync(XrdCl::ChunkList& chunkList,
                                  uint16_t timeout = 0);
@@ -229,7 +240,7 @@ public:
   //----------------------------------------------------------------------------
   void* fileGetAsyncHandler()
   {
-    return 0;
+    return FsIo::fileGetAsyncHandler();
   }
 
   //----------------------------------------------------------------------------
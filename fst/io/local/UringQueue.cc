@@ -0,0 +1,448 @@
+//------------------------------------------------------------------------------
+//! @file UringQueue.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2021 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "fst/io/local/UringQueue.hh"
+#include "common/Logging.hh"
+#include "common/StringConversion.hh"
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+
+EOSFSTNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+// Get the process wide queue
+//------------------------------------------------------------------------------
+UringQueue&
+UringQueue::Instance()
+{
+  static UringQueue sQueue;
+  return sQueue;
+}
+
+//------------------------------------------------------------------------------
+// Check if io_uring should be used for the given file path
+//------------------------------------------------------------------------------
+bool
+UringQueue::IsEnabledFor(const std::string& path)
+{
+  static const std::vector<std::string> sPrefixes = []() {
+    std::vector<std::string> prefixes;
+    const char* ptr = getenv("EOS_FST_IO_URING");
+
+    if (ptr) {
+      eos::common::StringConversion::Tokenize(ptr, prefixes, ",");
+    }
+
+    return prefixes;
+  }();
+
+  for (const auto& prefix : sPrefixes) {
+    if ((prefix == "1") || (path.find(prefix) == 0)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+UringQueue::UringQueue(uint32_t depth, bool use_uring):
+  mDepth(depth), mAvailable(false),
+  mBuffMgr(kNumFixedBuffers * kFixedBufferSize, 0, kFixedBufferSize)
+{
+#ifdef URING_FOUND
+
+  if (!use_uring) {
+    return;
+  }
+
+  int retc = io_uring_queue_init(mDepth, &mRing, 0);
+
+  if (retc < 0) {
+    eos_static_err("msg=\"failed to set up io_uring, using synchronous IO\" "
+                   "depth=%u errc=%i", mDepth, -retc);
+    return;
+  }
+
+  mAvailable = true;
+  RegisterFixedBuffers();
+  mReaper = std::thread(&UringQueue::ReapCompletions, this);
+#endif
+}
+
+//------------------------------------------------------------------------------
+// Destructor
+//------------------------------------------------------------------------------
+UringQueue::~UringQueue()
+{
+#ifdef URING_FOUND
+
+  if (!mAvailable) {
+    return;
+  }
+
+  {
+    // Wait for all requests in flight and then push the stop marker which
+    // is the only request without any payload
+    std::unique_lock<std::mutex> lock(mSqMutex);
+    mCvSlot.wait(lock, [&]() {
+      return (mInFlight.load() == 0);
+    });
+    struct io_uring_sqe* sqe = io_uring_get_sqe(&mRing);
+
+    if (sqe) {
+      io_uring_prep_nop(sqe);
+      io_uring_sqe_set_data(sqe, nullptr);
+      io_uring_submit(&mRing);
+    }
+  }
+
+  mReaper.join();
+
+  if (!mFixedBuffers.empty()) {
+    (void) io_uring_unregister_buffers(&mRing);
+  }
+
+  io_uring_queue_exit(&mRing);
+
+  for (auto& buff : mFixedBuffers) {
+    mBuffMgr.Recycle(std::move(buff));
+  }
+
+#endif
+}
+
+//------------------------------------------------------------------------------
+// Register the fixed buffers with the ring
+//------------------------------------------------------------------------------
+void
+UringQueue::RegisterFixedBuffers()
+{
+#ifdef URING_FOUND
+  std::vector<struct iovec> iovs;
+
+  for (uint32_t i = 0; i < kNumFixedBuffers; ++i) {
+    std::shared_ptr<eos::common::Buffer> buff =
+      mBuffMgr.GetBuffer(kFixedBufferSize);
+
+    if (buff == nullptr) {
+      break;
+    }
+
+    iovs.push_back({buff->GetDataPtr(), kFixedBufferSize});
+    mFixedBuffers.push_back(std::move(buff));
+  }
+
+  int retc = (iovs.empty() ? -ENOMEM :
+              io_uring_register_buffers(&mRing, iovs.data(), iovs.size()));
+
+  if (retc < 0) {
+    // Not fatal, the requests just don't use fixed buffers
+    eos_static_warning("msg=\"failed to register io_uring buffers\" "
+                       "num=%zu errc=%i", iovs.size(), -retc);
+
+    for (auto& buff : mFixedBuffers) {
+      mBuffMgr.Recycle(std::move(buff));
+    }
+
+    mFixedBuffers.clear();
+    return;
+  }
+
+  for (int i = (int) mFixedBuffers.size() - 1; i >= 0; --i) {
+    mFreeFixed.push_back(i);
+  }
+
+#endif
+}
+
+//------------------------------------------------------------------------------
+// Get one of the buffers registered with the ring
+//------------------------------------------------------------------------------
+int
+UringQueue::AcquireFixedBuffer(uint32_t length, char*& buffer)
+{
+  if (length > kFixedBufferSize) {
+    return -1;
+  }
+
+  std::unique_lock<std::mutex> lock(mFixedMutex);
+
+  if (mFreeFixed.empty()) {
+    return -1;
+  }
+
+  int index = mFreeFixed.back();
+  mFreeFixed.pop_back();
+  buffer = mFixedBuffers[index]->GetDataPtr();
+  return index;
+}
+
+//------------------------------------------------------------------------------
+// Give back a registered buffer
+//------------------------------------------------------------------------------
+void
+UringQueue::ReleaseFixedBuffer(int index)
+{
+  if (index < 0) {
+    return;
+  }
+
+  std::unique_lock<std::mutex> lock(mFixedMutex);
+  mFreeFixed.push_back(index);
+}
+
+//------------------------------------------------------------------------------
+// Submit a single request
+//------------------------------------------------------------------------------
+void
+UringQueue::Submit(Request&& req)
+{
+  std::vector<Request> batch;
+  batch.push_back(std::move(req));
+  Submit(batch);
+}
+
+//------------------------------------------------------------------------------
+// Submit a batch of requests
+//------------------------------------------------------------------------------
+void
+UringQueue::Submit(std::vector<Request>& batch)
+{
+  if (!mAvailable) {
+    for (auto& req : batch) {
+      ExecuteSync(req);
+      ReleaseFixedBuffer(req.mBufIndex);
+    }
+
+    return;
+  }
+
+#ifdef URING_FOUND
+  uint32_t num_queued = 0;
+  std::unique_lock<std::mutex> lock(mSqMutex);
+
+  auto submit = [&]() {
+    int retc;
+
+    do {
+      retc = io_uring_submit(&mRing);
+    } while ((retc == -EINTR) || (retc == -EAGAIN) || (retc == -EBUSY));
+
+    if (retc < 0) {
+      // The entries stay in the submission queue and go out with the next
+      // successful submit call
+      eos_static_err("msg=\"io_uring submit failed\" errc=%i", -retc);
+    }
+
+    mNumSubmitCalls.fetch_add(1, std::memory_order_relaxed);
+    num_queued = 0;
+  };
+
+  for (auto& req : batch) {
+    if (mInFlight.load() >= mDepth) {
+      // Hand what we have to the kernel before waiting for a free slot
+      if (num_queued) {
+        submit();
+      }
+
+      mCvSlot.wait(lock, [&]() {
+        return (mInFlight.load() < mDepth);
+      });
+    }
+
+    struct io_uring_sqe* sqe = io_uring_get_sqe(&mRing);
+
+    if (sqe == nullptr) {
+      submit();
+      sqe = io_uring_get_sqe(&mRing);
+
+      if (sqe == nullptr) {
+        lock.unlock();
+        ExecuteSync(req);
+        ReleaseFixedBuffer(req.mBufIndex);
+        lock.lock();
+        continue;
+      }
+    }
+
+    Request* payload = new Request(std::move(req));
+
+    if (payload->mBufIndex >= 0) {
+      if (payload->mIsWrite) {
+        io_uring_prep_write_fixed(sqe, payload->mFd, payload->mBuffer,
+                                  payload->mLength, payload->mOffset,
+                                  payload->mBufIndex);
+      } else {
+        io_uring_prep_read_fixed(sqe, payload->mFd, payload->mBuffer,
+                                 payload->mLength, payload->mOffset,
+                                 payload->mBufIndex);
+      }
+    } else if (payload->mIsWrite) {
+      io_uring_prep_write(sqe, payload->mFd, payload->mBuffer, payload->mLength,
+                          payload->mOffset);
+    } else {
+      io_uring_prep_read(sqe, payload->mFd, payload->mBuffer, payload->mLength,
+                         payload->mOffset);
+    }
+
+    io_uring_sqe_set_data(sqe, payload);
+    mInFlight.fetch_add(1);
+    ++num_queued;
+  }
+
+  if (num_queued) {
+    submit();
+  }
+
+#endif
+}
+
+//------------------------------------------------------------------------------
+// Read asynchronously
+//------------------------------------------------------------------------------
+std::future<int64_t>
+UringQueue::Read(int fd, char* buffer, uint32_t length, off_t offset)
+{
+  auto promise = std::make_shared<std::promise<int64_t>>();
+  std::future<int64_t> future = promise->get_future();
+  Submit(Request{false, fd, buffer, length, offset, [promise](int64_t retc) {
+      promise->set_value(retc);
+    }
+  });
+  return future;
+}
+
+//------------------------------------------------------------------------------
+// Write asynchronously
+//------------------------------------------------------------------------------
+std::future<int64_t>
+UringQueue::Write(int fd, const char* buffer, uint32_t length, off_t offset)
+{
+  auto promise = std::make_shared<std::promise<int64_t>>();
+  std::future<int64_t> future = promise->get_future();
+  Submit(Request{true, fd, const_cast<char*>(buffer), length, offset,
+                 [promise](int64_t retc) {
+                   promise->set_value(retc);
+                 }
+                });
+  return future;
+}
+
+//------------------------------------------------------------------------------
+// Execute request synchronously and run its callback
+//------------------------------------------------------------------------------
+void
+UringQueue::ExecuteSync(Request& req)
+{
+  int64_t total = 0;
+
+  while (total < req.mLength) {
+    ssize_t nbytes = req.mIsWrite ?
+                     ::pwrite(req.mFd, req.mBuffer + total, req.mLength - total,
+                              req.mOffset + total) :
+                     ::pread(req.mFd, req.mBuffer + total, req.mLength - total,
+                             req.mOffset + total);
+
+    if (nbytes < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+
+      total = -errno;
+      break;
+    }
+
+    if (nbytes == 0) {
+      break;
+    }
+
+    total += nbytes;
+  }
+
+  if (req.mCallback) {
+    req.mCallback(total);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Loop reaping completions and running the callbacks
+//------------------------------------------------------------------------------
+void
+UringQueue::ReapCompletions()
+{
+#ifdef URING_FOUND
+
+  while (true) {
+    struct io_uring_cqe* cqe = nullptr;
+    int retc = io_uring_wait_cqe(&mRing, &cqe);
+
+    if (retc < 0) {
+      if (retc != -EINTR) {
+        eos_static_err("msg=\"io_uring wait failed\" errc=%i", -retc);
+      }
+
+      continue;
+    }
+
+    Request* req = static_cast<Request*>(io_uring_cqe_get_data(cqe));
+    int64_t res = cqe->res;
+    io_uring_cqe_seen(&mRing, cqe);
+
+    if (req == nullptr) {
+      break;
+    }
+
+    if ((res > 0) && (res < req->mLength)) {
+      // Short transfer - complete the rest synchronously, for reads this
+      // also detects the end of file
+      Request rest {req->mIsWrite, req->mFd, req->mBuffer + res,
+                    static_cast<uint32_t>(req->mLength - res),
+                    static_cast<off_t>(req->mOffset + res),
+                    [&res](int64_t retc) {
+                      res = (retc < 0) ? retc : res + retc;
+                    }
+                   };
+      ExecuteSync(rest);
+    }
+
+    if (req->mCallback) {
+      req->mCallback(res);
+    }
+
+    ReleaseFixedBuffer(req->mBufIndex);
+    delete req;
+    {
+      std::unique_lock<std::mutex> lock(mSqMutex);
+      mInFlight.fetch_sub(1);
+    }
+    mCvSlot.notify_all();
+  }
+
+#endif
+}
+
+EOSFSTNAMESPACE_END
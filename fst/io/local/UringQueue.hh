@@ -0,0 +1,219 @@
+//------------------------------------------------------------------------------
+//! @file UringQueue.hh
+//! @brief Shared io_uring submission ring used by the local IO objects
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2021 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+#include "fst/Namespace.hh"
+#include "common/BufferManager.hh"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/types.h>
+
+#ifdef URING_FOUND
+#include <liburing.h>
+#endif
+
+EOSFSTNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Class UringQueue - io_uring submission ring shared by all the local file
+//! objects of the process. Requests are queued under a mutex and handed to
+//! the kernel with a single io_uring_submit call per batch, completions are
+//! reaped by a dedicated thread which runs the callback of each request.
+//!
+//! A fixed set of buffers taken from a BufferManager pool is registered with
+//! the ring, requests staged in one of them use the fixed buffer opcodes and
+//! spare the kernel from pinning the user pages for every request.
+//!
+//! If io_uring support is not compiled in or the ring can not be set up (old
+//! kernel, seccomp, memlock limits) every request is executed synchronously
+//! using pread/pwrite and the callback is run in the caller's thread.
+//------------------------------------------------------------------------------
+class UringQueue
+{
+public:
+  //! Callback receiving the number of bytes transferred or -errno
+  using Callback = std::function<void(int64_t)>;
+
+  //----------------------------------------------------------------------------
+  //! Description of one request
+  //----------------------------------------------------------------------------
+  struct Request {
+    bool mIsWrite;
+    int mFd;
+    char* mBuffer;
+    uint32_t mLength;
+    off_t mOffset;
+    Callback mCallback;
+    //! Index of the registered buffer holding mBuffer or -1, the buffer is
+    //! released by the queue once the callback returned
+    int mBufIndex {-1};
+  };
+
+  //! Number and size of the buffers registered with the ring
+  static constexpr uint32_t kNumFixedBuffers = 32;
+  static constexpr uint32_t kFixedBufferSize = 1024 * 1024;
+
+  //----------------------------------------------------------------------------
+  //! Get the process wide queue
+  //----------------------------------------------------------------------------
+  static UringQueue& Instance();
+
+  //----------------------------------------------------------------------------
+  //! Check if io_uring should be used for the given file path. This is
+  //! controlled by the EOS_FST_IO_URING environment variable which can be
+  //! either "1" (all files) or a comma separated list of path prefixes i.e.
+  //! the filesystem mount points which should use io_uring.
+  //!
+  //! @param path file path
+  //!
+  //! @return true if io_uring is enabled for the file, otherwise false
+  //----------------------------------------------------------------------------
+  static bool IsEnabledFor(const std::string& path);
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param depth number of submission queue entries i.e. maximum number of
+  //!        requests in flight
+  //! @param use_uring if false requests are always executed synchronously
+  //----------------------------------------------------------------------------
+  explicit UringQueue(uint32_t depth = 256, bool use_uring = true);
+
+  //----------------------------------------------------------------------------
+  //! Destructor - waits for all requests in flight
+  //----------------------------------------------------------------------------
+  ~UringQueue();
+
+  //----------------------------------------------------------------------------
+  //! Check if requests go through io_uring or the synchronous fallback
+  //----------------------------------------------------------------------------
+  bool IsAvailable() const
+  {
+    return mAvailable;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get one of the buffers registered with the ring, never blocks
+  //!
+  //! @param length minimum size of the buffer
+  //! @param buffer set to the start of the registered buffer
+  //!
+  //! @return buffer index to be set in the request or -1 if there is no free
+  //!         registered buffer big enough
+  //----------------------------------------------------------------------------
+  int AcquireFixedBuffer(uint32_t length, char*& buffer);
+
+  //----------------------------------------------------------------------------
+  //! Give back a registered buffer which is not submitted with a request
+  //!
+  //! @param index buffer index, -1 is ignored
+  //----------------------------------------------------------------------------
+  void ReleaseFixedBuffer(int index);
+
+  //----------------------------------------------------------------------------
+  //! Submit a batch of requests with a single system call. The buffers must
+  //! stay valid until the corresponding callback is executed.
+  //!
+  //! @param batch list of requests
+  //----------------------------------------------------------------------------
+  void Submit(std::vector<Request>& batch);
+
+  //----------------------------------------------------------------------------
+  //! Submit a single request
+  //----------------------------------------------------------------------------
+  void Submit(Request&& req);
+
+  //----------------------------------------------------------------------------
+  //! Read asynchronously
+  //!
+  //! @return future holding the number of bytes read or -errno
+  //----------------------------------------------------------------------------
+  std::future<int64_t> Read(int fd, char* buffer, uint32_t length,
+                            off_t offset);
+
+  //----------------------------------------------------------------------------
+  //! Write asynchronously
+  //!
+  //! @return future holding the number of bytes written or -errno
+  //----------------------------------------------------------------------------
+  std::future<int64_t> Write(int fd, const char* buffer, uint32_t length,
+                             off_t offset);
+
+  //----------------------------------------------------------------------------
+  //! Get number of requests in flight
+  //----------------------------------------------------------------------------
+  uint64_t GetInFlight() const
+  {
+    return mInFlight.load(std::memory_order_relaxed);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get number of submit system calls, together with the number of requests
+  //! this gives the average batch size
+  //----------------------------------------------------------------------------
+  uint64_t GetNumSubmitCalls() const
+  {
+    return mNumSubmitCalls.load(std::memory_order_relaxed);
+  }
+
+private:
+  //----------------------------------------------------------------------------
+  //! Execute request synchronously and run its callback
+  //----------------------------------------------------------------------------
+  static void ExecuteSync(Request& req);
+
+  //----------------------------------------------------------------------------
+  //! Loop reaping completions and running the callbacks
+  //----------------------------------------------------------------------------
+  void ReapCompletions();
+
+  //----------------------------------------------------------------------------
+  //! Register the fixed buffers with the ring
+  //----------------------------------------------------------------------------
+  void RegisterFixedBuffers();
+
+  uint32_t mDepth; ///< Max number of requests in flight
+  bool mAvailable; ///< Mark if the io_uring ring is usable
+  std::atomic<uint64_t> mInFlight {0};
+  std::atomic<uint64_t> mNumSubmitCalls {0};
+  std::mutex mSqMutex; ///< Serialize access to the submission queue
+  std::condition_variable mCvSlot; ///< Notify when a slot is released
+  eos::common::BufferManager mBuffMgr; ///< Pool of the registered buffers
+  std::vector<std::shared_ptr<eos::common::Buffer>> mFixedBuffers;
+  std::mutex mFixedMutex; ///< Protect the list of free registered buffers
+  std::vector<int> mFreeFixed; ///< Indices of free registered buffers
+#ifdef URING_FOUND
+  struct io_uring mRing;
+#endif
+  std::thread mReaper;
+};
+
+EOSFSTNAMESPACE_END
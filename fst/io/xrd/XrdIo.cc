@@ -683,6 +683,37 @@ XrdIo::fileWriteAsync(const char* buffer, XrdSfsFileOffset offset,
   return wr_future;
 }
 
+//------------------------------------------------------------------------------
+// Read from file - async returning a future
+//------------------------------------------------------------------------------
+std::future<XrdCl::XRootDStatus>
+XrdIo::fileReadAsync(char* buffer, XrdSfsFileOffset offset,
+                     XrdSfsXferSize length, uint16_t timeout)
+{
+  eos_static_debug("offset=%llu length=%i", offset, length);
+  std::promise<XrdCl::XRootDStatus> rd_promise;
+  std::future<XrdCl::XRootDStatus> rd_future = rd_promise.get_future();
+
+  if (!mXrdFile) {
+    errno = EIO;
+    rd_promise.set_value(XrdCl::XRootDStatus(XrdCl::stError, XrdCl::errOSError,
+                         EIO));
+    return rd_future;
+  }
+
+  XrdIoHandler* rd_handler = new XrdIoHandler(std::move(rd_promise),
+      XrdIoHandler::OpType::Read, static_cast<uint32_t>(length));
+  XrdCl::XRootDStatus status = mXrdFile->Read(static_cast<uint64_t>(offset),
+                               static_cast<uint32_t>(length),
+                               buffer, rd_handler, timeout);
+
+  if (!status.IsOK()) {
+    rd_handler->HandleResponse(new XrdCl::XRootDStatus(status), nullptr);
+  }
+
+  return rd_future;
+}
+
 //------------------------------------------------------------------------------
 // Wait for async IO
 //------------------------------------------------------------------------------
@@ -275,6 +275,21 @@ public:
   int64_t fileReadAsync(XrdSfsFileOffset offset, char* buffer,
                         XrdSfsXferSize length, uint16_t timeout = 0);
 
+  //----------------------------------------------------------------------------
+  //! Read from file - async
+  //!
+  //! @param buffer where the data is read
+  //! @param offset offset in file
+  //! @param length read length
+  //! @param timeout timeout value
+  //!
+  //! @return future holding the status response, reading less than length
+  //!         bytes is reported as an error
+  //----------------------------------------------------------------------------
+  std::future<XrdCl::XRootDStatus>
+  fileReadAsync(char* buffer, XrdSfsFileOffset offset, XrdSfsXferSize length,
+                uint16_t timeout);
+
   //----------------------------------------------------------------------------
   //! Read from file with prefetching
   //!
@@ -687,6 +702,7 @@ class XrdIoHandler: public XrdCl::ResponseHandler
 public:
   enum class OpType {
     None,
+    Read,
     Write,
     Truncate
   };
@@ -695,10 +711,12 @@ public:
   //! Constructor
   //!
   //! @param wr_promise write promise used to notify when the answer arrives
+  //! @param op type of operation
+  //! @param length expected length of a read operation
   //----------------------------------------------------------------------------
   XrdIoHandler(std::promise<XrdCl::XRootDStatus>&& wr_promise,
-               OpType op):
-    mPromise(std::move(wr_promise)), mOperationType(op)
+               OpType op, uint32_t length = 0):
+    mPromise(std::move(wr_promise)), mOperationType(op), mLength(length)
   {}
 
   //----------------------------------------------------------------------------
@@ -711,6 +729,19 @@ public:
                               XrdCl::AnyObject* pResponse)
   {
     if (pStatus) {
+      if ((mOperationType == OpType::Read) && pStatus->IsOK()) {
+        XrdCl::ChunkInfo* chunk = nullptr;
+
+        if (pResponse) {
+          pResponse->Get(chunk);
+        }
+
+        // Short reads are reported as errors
+        if ((chunk == nullptr) || (chunk->length != mLength)) {
+          *pStatus = XrdCl::XRootDStatus(XrdCl::stError, XrdCl::errOSError, EIO);
+        }
+      }
+
       mPromise.set_value(*pStatus);
       delete pStatus;
     }
@@ -725,6 +756,7 @@ public:
 private:
   std::promise<XrdCl::XRootDStatus> mPromise;
   OpType mOperationType;
+  uint32_t mLength; ///< Expected length for read operations
 };
 
 EOSFSTNAMESPACE_END
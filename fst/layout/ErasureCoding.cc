@@ -0,0 +1,431 @@
+//------------------------------------------------------------------------------
+//! @file ErasureCoding.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2021 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "fst/layout/ErasureCoding.hh"
+#include "fst/layout/jerasure/include/jerasure.h"
+#include "fst/layout/jerasure/include/cauchy.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define EOS_XOR_X86 1
+#endif
+
+EOSFSTNAMESPACE_BEGIN
+
+namespace
+{
+//! Size of the sub-blocks in which packets are processed so that all the
+//! sources of a schedule pass stay in the CPU cache
+constexpr size_t kScheduleBlockSize = 4096;
+
+//! Vectorized kernel processing a prefix of the regions, returns the number
+//! of bytes done
+using XorFunc = size_t (*)(char*, const char* const*, size_t, size_t, bool);
+
+//------------------------------------------------------------------------------
+// Portable implementation using 64-bit words starting at the given offset
+//------------------------------------------------------------------------------
+void
+XorRegionsWord(char* dst, const char* const* srcs, size_t num_srcs,
+               size_t pos, size_t len, bool accumulate)
+{
+  for (; pos + sizeof(uint64_t) <= len; pos += sizeof(uint64_t)) {
+    uint64_t acc, val;
+
+    if (accumulate) {
+      memcpy(&acc, dst + pos, sizeof(acc));
+    } else {
+      acc = 0;
+    }
+
+    for (size_t i = 0; i < num_srcs; ++i) {
+      memcpy(&val, srcs[i] + pos, sizeof(val));
+      acc ^= val;
+    }
+
+    memcpy(dst + pos, &acc, sizeof(acc));
+  }
+
+  for (; pos < len; ++pos) {
+    char acc = (accumulate ? dst[pos] : 0);
+
+    for (size_t i = 0; i < num_srcs; ++i) {
+      acc ^= srcs[i][pos];
+    }
+
+    dst[pos] = acc;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Kernel used when no vector extension is available
+//------------------------------------------------------------------------------
+size_t
+XorRegionsNone(char*, const char* const*, size_t, size_t, bool)
+{
+  return 0;
+}
+
+#ifdef EOS_XOR_X86
+//------------------------------------------------------------------------------
+// SSE2 implementation, 4 x 128 bits per iteration
+//------------------------------------------------------------------------------
+__attribute__((target("sse2"))) size_t
+XorRegionsSse2(char* dst, const char* const* srcs, size_t num_srcs,
+               size_t len, bool accumulate)
+{
+  size_t pos = 0;
+
+  for (; pos + 64 <= len; pos += 64) {
+    __m128i a0, a1, a2, a3;
+
+    if (accumulate) {
+      a0 = _mm_loadu_si128((const __m128i*)(dst + pos));
+      a1 = _mm_loadu_si128((const __m128i*)(dst + pos + 16));
+      a2 = _mm_loadu_si128((const __m128i*)(dst + pos + 32));
+      a3 = _mm_loadu_si128((const __m128i*)(dst + pos + 48));
+    } else {
+      a0 = a1 = a2 = a3 = _mm_setzero_si128();
+    }
+
+    for (size_t i = 0; i < num_srcs; ++i) {
+      const char* src = srcs[i] + pos;
+      a0 = _mm_xor_si128(a0, _mm_loadu_si128((const __m128i*)(src)));
+      a1 = _mm_xor_si128(a1, _mm_loadu_si128((const __m128i*)(src + 16)));
+      a2 = _mm_xor_si128(a2, _mm_loadu_si128((const __m128i*)(src + 32)));
+      a3 = _mm_xor_si128(a3, _mm_loadu_si128((const __m128i*)(src + 48)));
+    }
+
+    _mm_storeu_si128((__m128i*)(dst + pos), a0);
+    _mm_storeu_si128((__m128i*)(dst + pos + 16), a1);
+    _mm_storeu_si128((__m128i*)(dst + pos + 32), a2);
+    _mm_storeu_si128((__m128i*)(dst + pos + 48), a3);
+  }
+
+  return pos;
+}
+
+//------------------------------------------------------------------------------
+// AVX2 implementation, 4 x 256 bits per iteration
+//------------------------------------------------------------------------------
+__attribute__((target("avx2"))) size_t
+XorRegionsAvx2(char* dst, const char* const* srcs, size_t num_srcs,
+               size_t len, bool accumulate)
+{
+  size_t pos = 0;
+
+  for (; pos + 128 <= len; pos += 128) {
+    __m256i a0, a1, a2, a3;
+
+    if (accumulate) {
+      a0 = _mm256_loadu_si256((const __m256i*)(dst + pos));
+      a1 = _mm256_loadu_si256((const __m256i*)(dst + pos + 32));
+      a2 = _mm256_loadu_si256((const __m256i*)(dst + pos + 64));
+      a3 = _mm256_loadu_si256((const __m256i*)(dst + pos + 96));
+    } else {
+      a0 = a1 = a2 = a3 = _mm256_setzero_si256();
+    }
+
+    for (size_t i = 0; i < num_srcs; ++i) {
+      const char* src = srcs[i] + pos;
+      a0 = _mm256_xor_si256(a0, _mm256_loadu_si256((const __m256i*)(src)));
+      a1 = _mm256_xor_si256(a1, _mm256_loadu_si256((const __m256i*)(src + 32)));
+      a2 = _mm256_xor_si256(a2, _mm256_loadu_si256((const __m256i*)(src + 64)));
+      a3 = _mm256_xor_si256(a3, _mm256_loadu_si256((const __m256i*)(src + 96)));
+    }
+
+    _mm256_storeu_si256((__m256i*)(dst + pos), a0);
+    _mm256_storeu_si256((__m256i*)(dst + pos + 32), a1);
+    _mm256_storeu_si256((__m256i*)(dst + pos + 64), a2);
+    _mm256_storeu_si256((__m256i*)(dst + pos + 96), a3);
+  }
+
+  return pos;
+}
+
+//------------------------------------------------------------------------------
+// AVX-512 implementation, 4 x 512 bits per iteration
+//------------------------------------------------------------------------------
+__attribute__((target("avx512f"))) size_t
+XorRegionsAvx512(char* dst, const char* const* srcs, size_t num_srcs,
+                 size_t len, bool accumulate)
+{
+  size_t pos = 0;
+
+  for (; pos + 256 <= len; pos += 256) {
+    __m512i a0, a1, a2, a3;
+
+    if (accumulate) {
+      a0 = _mm512_loadu_si512((const void*)(dst + pos));
+      a1 = _mm512_loadu_si512((const void*)(dst + pos + 64));
+      a2 = _mm512_loadu_si512((const void*)(dst + pos + 128));
+      a3 = _mm512_loadu_si512((const void*)(dst + pos + 192));
+    } else {
+      a0 = a1 = a2 = a3 = _mm512_setzero_si512();
+    }
+
+    for (size_t i = 0; i < num_srcs; ++i) {
+      const char* src = srcs[i] + pos;
+      a0 = _mm512_xor_si512(a0, _mm512_loadu_si512((const void*)(src)));
+      a1 = _mm512_xor_si512(a1, _mm512_loadu_si512((const void*)(src + 64)));
+      a2 = _mm512_xor_si512(a2, _mm512_loadu_si512((const void*)(src + 128)));
+      a3 = _mm512_xor_si512(a3, _mm512_loadu_si512((const void*)(src + 192)));
+    }
+
+    _mm512_storeu_si512((void*)(dst + pos), a0);
+    _mm512_storeu_si512((void*)(dst + pos + 64), a1);
+    _mm512_storeu_si512((void*)(dst + pos + 128), a2);
+    _mm512_storeu_si512((void*)(dst + pos + 192), a3);
+  }
+
+  return pos;
+}
+#endif
+
+//------------------------------------------------------------------------------
+//! Select XOR implementation for the current CPU
+//------------------------------------------------------------------------------
+std::pair<XorFunc, const char*>
+SelectXorImplementation()
+{
+#ifdef EOS_XOR_X86
+  __builtin_cpu_init();
+
+  if (__builtin_cpu_supports("avx512f")) {
+    return {&XorRegionsAvx512, "avx512"};
+  }
+
+  if (__builtin_cpu_supports("avx2")) {
+    return {&XorRegionsAvx2, "avx2"};
+  }
+
+  if (__builtin_cpu_supports("sse2")) {
+    return {&XorRegionsSse2, "sse2"};
+  }
+
+#endif
+  return {&XorRegionsNone, "word"};
+}
+
+//------------------------------------------------------------------------------
+//! Get XOR implementation selected for the current CPU
+//------------------------------------------------------------------------------
+const std::pair<XorFunc, const char*>&
+GetXorImpl()
+{
+  static const std::pair<XorFunc, const char*> sXorImpl =
+    SelectXorImplementation();
+  return sXorImpl;
+}
+}
+
+//------------------------------------------------------------------------------
+// XOR a list of regions of the same length
+//------------------------------------------------------------------------------
+void
+XorRegions(char* dst, const char* const* srcs, size_t num_srcs, size_t len,
+           bool accumulate)
+{
+  size_t pos = GetXorImpl().first(dst, srcs, num_srcs, len, accumulate);
+
+  if (pos < len) {
+    XorRegionsWord(dst, srcs, num_srcs, pos, len, accumulate);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Get name of the XOR implementation selected for the current CPU
+//------------------------------------------------------------------------------
+const char*
+GetXorImplementation()
+{
+  return GetXorImpl().second;
+}
+
+//------------------------------------------------------------------------------
+// XorSchedule constructor
+//------------------------------------------------------------------------------
+XorSchedule::XorSchedule(int** schedule):
+  mMaxSrcs(0)
+{
+  for (int op = 0; schedule[op][0] >= 0; ++op) {
+    const int* elem = schedule[op];
+    bool same_dst = (!mOps.empty() && (mOps.back().mDstDev == elem[2]) &&
+                     (mOps.back().mDstPacket == elem[3]));
+
+    // A copy always starts a new operation, an XOR extends the previous one
+    // if it targets the same packet
+    if (!same_dst || !elem[4]) {
+      mOps.push_back(FusedOp{elem[2], elem[3], (elem[4] != 0),
+                             (uint32_t)mSrcs.size(), 0});
+    }
+
+    mSrcs.emplace_back(elem[0], elem[1]);
+    mMaxSrcs = std::max(mMaxSrcs, ++mOps.back().mNumSrcs);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Execute schedule
+//------------------------------------------------------------------------------
+void
+XorSchedule::Execute(char** ptrs, int w, size_t size,
+                     size_t packet_size) const
+{
+  std::vector<const char*> srcs(mMaxSrcs ? mMaxSrcs : 1);
+  const size_t line_sz = w * packet_size;
+
+  for (size_t line_off = 0; line_off < size; line_off += line_sz) {
+    for (size_t blk_off = 0; blk_off < packet_size;
+         blk_off += kScheduleBlockSize) {
+      size_t len = std::min(kScheduleBlockSize, packet_size - blk_off);
+      size_t base = line_off + blk_off;
+
+      for (const auto& op : mOps) {
+        for (uint32_t i = 0; i < op.mNumSrcs; ++i) {
+          const auto& src = mSrcs[op.mFirstSrc + i];
+          srcs[i] = ptrs[src.first] + base + src.second * packet_size;
+        }
+
+        char* dst = ptrs[op.mDstDev] + base + op.mDstPacket * packet_size;
+
+        if (!op.mAccumulate && (op.mNumSrcs == 1)) {
+          memcpy(dst, srcs[0], len);
+        } else {
+          XorRegions(dst, srcs.data(), op.mNumSrcs, len, op.mAccumulate);
+        }
+      }
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Get codec for the given parameters
+//------------------------------------------------------------------------------
+std::shared_ptr<ReedSCodec>
+ReedSCodec::Get(int k, int m, int w)
+{
+  static std::mutex sMutex;
+  static std::map<std::tuple<int, int, int>, std::shared_ptr<ReedSCodec>>
+      sCodecs;
+  // The Jerasure/galois initialization is not thread safe therefore the
+  // construction of the codec is done under the global lock
+  std::lock_guard<std::mutex> lock(sMutex);
+  auto& codec = sCodecs[std::make_tuple(k, m, w)];
+
+  if (codec == nullptr) {
+    codec = std::make_shared<ReedSCodec>(k, m, w);
+  }
+
+  return codec;
+}
+
+//------------------------------------------------------------------------------
+// ReedSCodec constructor
+//------------------------------------------------------------------------------
+ReedSCodec::ReedSCodec(int k, int m, int w):
+  mK(k), mM(m), mW(w), mMatrix(nullptr), mBitmatrix(nullptr)
+{
+  mMatrix = cauchy_good_general_coding_matrix(mK, mM, mW);
+
+  if (mMatrix == nullptr) {
+    throw std::runtime_error("Jerasure initialization failed");
+  }
+
+  mBitmatrix = jerasure_matrix_to_bitmatrix(mK, mM, mW, mMatrix);
+  int** schedule = jerasure_smart_bitmatrix_to_schedule(mK, mM, mW,
+                   mBitmatrix);
+  mEncodeSchedule.reset(new XorSchedule(schedule));
+  jerasure_free_schedule(schedule);
+}
+
+//------------------------------------------------------------------------------
+// ReedSCodec destructor
+//------------------------------------------------------------------------------
+ReedSCodec::~ReedSCodec()
+{
+  free(mMatrix);
+  free(mBitmatrix);
+}
+
+//------------------------------------------------------------------------------
+// Compute coding blocks
+//------------------------------------------------------------------------------
+void
+ReedSCodec::Encode(char** data, char** coding, size_t size,
+                   size_t packet_size) const
+{
+  std::vector<char*> ptrs(data, data + mK);
+  ptrs.insert(ptrs.end(), coding, coding + mM);
+  mEncodeSchedule->Execute(ptrs.data(), mW, size, packet_size);
+}
+
+//------------------------------------------------------------------------------
+// Recover erased blocks
+//------------------------------------------------------------------------------
+bool
+ReedSCodec::Decode(int* erasures, char** data, char** coding, size_t size,
+                   size_t packet_size)
+{
+  std::string key;
+
+  for (int i = 0; erasures[i] != -1; ++i) {
+    key += std::to_string(erasures[i]) + ",";
+  }
+
+  std::shared_ptr<XorSchedule> schedule;
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto it = mDecodeSchedules.find(key);
+
+    if (it != mDecodeSchedules.end()) {
+      schedule = it->second;
+    } else {
+      int** jschedule = jerasure_generate_decoding_schedule(mK, mM, mW,
+                        mBitmatrix, erasures, 1);
+
+      if (jschedule == nullptr) {
+        return false;
+      }
+
+      schedule = std::make_shared<XorSchedule>(jschedule);
+      jerasure_free_schedule(jschedule);
+      mDecodeSchedules[key] = schedule;
+    }
+  }
+  char** ptrs = set_up_ptrs_for_scheduled_decoding(mK, mM, erasures, data,
+                coding);
+
+  if (ptrs == nullptr) {
+    return false;
+  }
+
+  schedule->Execute(ptrs, mW, size, packet_size);
+  free(ptrs);
+  return true;
+}
+
+EOSFSTNAMESPACE_END
@@ -0,0 +1,241 @@
+//------------------------------------------------------------------------------
+//! @file ErasureCoding.hh
+//! @brief Vectorized XOR kernels, cached Reed-Solomon codecs and the group
+//!        recovery pipeline used by the RAIN layouts
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2021 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+#include "fst/Namespace.hh"
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+EOSFSTNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! XOR a list of regions of the same length. The implementation is selected
+//! at runtime depending on the CPU capabilities (AVX-512, AVX2, SSE2, plain
+//! 64-bit words) and every source is streamed once.
+//!
+//! @param dst destination region
+//! @param srcs list of source regions, they must not overlap with dst
+//! @param num_srcs number of source regions
+//! @param len length of the regions
+//! @param accumulate if true dst ^= src[0] ^ ... otherwise dst = src[0] ^ ...
+//------------------------------------------------------------------------------
+void XorRegions(char* dst, const char* const* srcs, size_t num_srcs,
+                size_t len, bool accumulate);
+
+//------------------------------------------------------------------------------
+//! Get name of the XOR implementation selected for the current CPU
+//------------------------------------------------------------------------------
+const char* GetXorImplementation();
+
+//------------------------------------------------------------------------------
+//! Class XorSchedule - Jerasure bit-matrix schedule compiled for execution.
+//!
+//! A Jerasure schedule is a list of packet copy/XOR operations. Consecutive
+//! operations writing the same destination packet are fused so that the
+//! destination is computed in a single pass over all its sources and the
+//! packets are processed in cache sized sub-blocks. Since every operation is
+//! element-wise the result is byte-identical to jerasure_schedule_encode or
+//! jerasure_schedule_decode_lazy for the same schedule.
+//------------------------------------------------------------------------------
+class XorSchedule
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param schedule Jerasure schedule terminated by an entry with -1
+  //----------------------------------------------------------------------------
+  explicit XorSchedule(int** schedule);
+
+  //----------------------------------------------------------------------------
+  //! Execute schedule
+  //!
+  //! @param ptrs device pointers as expected by the schedule
+  //! @param w Jerasure word size
+  //! @param size size of each device region, multiple of w * packet_size
+  //! @param packet_size size of a packet
+  //----------------------------------------------------------------------------
+  void Execute(char** ptrs, int w, size_t size, size_t packet_size) const;
+
+  //----------------------------------------------------------------------------
+  //! Get number of fused operations
+  //----------------------------------------------------------------------------
+  size_t GetNumOps() const
+  {
+    return mOps.size();
+  }
+
+private:
+  //! Operation computing one destination packet from a list of sources
+  struct FusedOp {
+    int mDstDev;
+    int mDstPacket;
+    bool mAccumulate;
+    uint32_t mFirstSrc;
+    uint32_t mNumSrcs;
+  };
+
+  std::vector<FusedOp> mOps;
+  std::vector<std::pair<int, int>> mSrcs; ///< (device, packet) sources
+  uint32_t mMaxSrcs; ///< Max number of sources of one operation
+};
+
+//------------------------------------------------------------------------------
+//! Class ReedSCodec - Cauchy Reed-Solomon codec for a given (k, m, w) shared
+//! by all the files using the same layout parameters. The coding matrices are
+//! built only once and the decoding schedules are cached per erasure pattern.
+//------------------------------------------------------------------------------
+class ReedSCodec
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Get codec for the given parameters, creating it if needed
+  //!
+  //! @param k number of data devices
+  //! @param m number of coding devices
+  //! @param w word size
+  //----------------------------------------------------------------------------
+  static std::shared_ptr<ReedSCodec> Get(int k, int m, int w);
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //----------------------------------------------------------------------------
+  ReedSCodec(int k, int m, int w);
+
+  //----------------------------------------------------------------------------
+  //! Destructor
+  //----------------------------------------------------------------------------
+  ~ReedSCodec();
+
+  ReedSCodec(const ReedSCodec&) = delete;
+  ReedSCodec& operator =(const ReedSCodec&) = delete;
+
+  //----------------------------------------------------------------------------
+  //! Compute coding blocks
+  //!
+  //! @param data k data blocks
+  //! @param coding m coding blocks
+  //! @param size size of a block
+  //! @param packet_size Jerasure packet size
+  //----------------------------------------------------------------------------
+  void Encode(char** data, char** coding, size_t size,
+              size_t packet_size) const;
+
+  //----------------------------------------------------------------------------
+  //! Recover erased blocks
+  //!
+  //! @param erasures list of erased device ids terminated by -1
+  //! @param data k data blocks
+  //! @param coding m coding blocks
+  //! @param size size of a block
+  //! @param packet_size Jerasure packet size
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  bool Decode(int* erasures, char** data, char** coding, size_t size,
+              size_t packet_size);
+
+  //----------------------------------------------------------------------------
+  //! Get coding bit-matrix
+  //----------------------------------------------------------------------------
+  int* GetBitmatrix() const
+  {
+    return mBitmatrix;
+  }
+
+private:
+  int mK;
+  int mM;
+  int mW;
+  int* mMatrix;
+  int* mBitmatrix;
+  std::unique_ptr<XorSchedule> mEncodeSchedule;
+  std::mutex mMutex; ///< Protect the decoding schedules
+  //! Decoding schedules indexed by the erasure pattern
+  std::map<std::string, std::shared_ptr<XorSchedule>> mDecodeSchedules;
+};
+
+//------------------------------------------------------------------------------
+//! Recover a sequence of groups in order while the stripe reads of up to
+//! window groups are in flight. The reads of the following groups are issued
+//! before the oldest group is recovered, so they can complete in any order.
+//! Once a recovery fails no new reads are issued and the groups already
+//! fetched are only drained, so that no read is left in flight.
+//!
+//! @param first iterator to the first group
+//! @param last iterator past the last group
+//! @param window max number of groups with reads in flight
+//! @param fetch functor issuing the reads of a group, it gets the iterator
+//!        to the group and returns a handle to it
+//! @param recover functor recovering a group, it gets the iterator and the
+//!        handle of the group and returns true if successful
+//! @param drain functor waiting for the reads of a group which is not
+//!        recovered, it gets the handle of the group
+//!
+//! @return true if all the groups were recovered, otherwise false
+//------------------------------------------------------------------------------
+template <typename IterT, typename FetchT, typename RecoverT, typename DrainT>
+bool
+RecoverGroupsPipelined(IterT first, IterT last, size_t window, FetchT fetch,
+                       RecoverT recover, DrainT drain)
+{
+  using HandleT = decltype(fetch(first));
+  bool success = true;
+  std::list<HandleT> in_flight;
+  IterT it_fetch = first;
+
+  if (window == 0) {
+    window = 1;
+  }
+
+  for (IterT it = first; it != last; ++it) {
+    while (success && (it_fetch != last) && (in_flight.size() < window)) {
+      in_flight.push_back(fetch(it_fetch));
+      ++it_fetch;
+    }
+
+    if (in_flight.empty()) {
+      break;
+    }
+
+    HandleT handle = std::move(in_flight.front());
+    in_flight.pop_front();
+
+    if (success) {
+      success = recover(it, handle);
+    } else {
+      drain(handle);
+    }
+  }
+
+  return success;
+}
+
+EOSFSTNAMESPACE_END
@@ -23,14 +23,13 @@
 
 #include "fst/layout/RaidDpLayout.hh"
 #include "fst/io/AsyncMetaHandler.hh"
+#include "fst/layout/ErasureCoding.hh"
 #include <cmath>
 #include <map>
 #include <sys/types.h>
 
 EOSFSTNAMESPACE_BEGIN
 
-typedef long v2do __attribute__((vector_size(VECTOR_SIZE)));
-
 //------------------------------------------------------------------------------
 // Constructor
 //------------------------------------------------------------------------------
@@ -59,24 +58,23 @@ bool
 RaidDpLayout::ComputeParity(std::shared_ptr<eos::fst::RainGroup>& grp)
 {
   eos::fst::RainGroup& data_blocks = *grp.get();
+  // Each parity block is computed in a single pass over all its sources
+  std::vector<const char*> srcs;
+  srcs.reserve(mNbDataFiles + 1);
 
   // Compute simple parity
   for (unsigned int i = 0; i < mNbDataFiles; i++) {
     int index_pblock = (i + 1) * mNbDataFiles + 2 * i;
     int current_block = i * (mNbDataFiles + 2); //beginning of current line
-    OperationXOR(data_blocks[current_block](),
-                 data_blocks[current_block + 1](),
-                 data_blocks[index_pblock](),
-                 mStripeWidth);
-    current_block += 2;
+    srcs.clear();
 
     while (current_block < index_pblock) {
-      OperationXOR(data_blocks[index_pblock](),
-                   data_blocks[current_block](),
-                   data_blocks[index_pblock](),
-                   mStripeWidth);
+      srcs.push_back(data_blocks[current_block]());
       current_block++;
     }
+
+    XorRegions(data_blocks[index_pblock](), srcs.data(), srcs.size(),
+               mStripeWidth, false);
   }
 
   // Compute double parity
@@ -91,10 +89,9 @@ RaidDpLayout::ComputeParity(std::shared_ptr<eos::fst::RainGroup>& grp)
   for (unsigned int i = 0; i < mNbDataFiles; i++) {
     unsigned int index_dpblock = (i + 1) * (mNbDataFiles + 1) + i;
     unsigned int next_block = i + jump_blocks;
-    OperationXOR(data_blocks[i](),
-                 data_blocks[next_block](),
-                 data_blocks[index_dpblock](),
-                 mStripeWidth);
+    srcs.clear();
+    srcs.push_back(data_blocks[i]());
+    srcs.push_back(data_blocks[next_block]());
     used_blocks.push_back(i);
     used_blocks.push_back(next_block);
 
@@ -114,52 +111,15 @@ RaidDpLayout::ComputeParity(std::shared_ptr<eos::fst::RainGroup>& grp)
         }
       }
 
-      OperationXOR(data_blocks[index_dpblock](),
-                   data_blocks[next_block](),
-                   data_blocks[index_dpblock](),
-                   mStripeWidth);
+      srcs.push_back(data_blocks[next_block]());
       used_blocks.push_back(next_block);
     }
-  }
-
-  return true;
-}
 
-//------------------------------------------------------------------------------
-// XOR the two blocks using 128 bits and return the result
-//------------------------------------------------------------------------------
-void
-RaidDpLayout::OperationXOR(char* pBlock1, char* pBlock2, char* pResult,
-                           size_t totalBytes)
-{
-  v2do* xor_res;
-  v2do* idx1;
-  v2do* idx2;
-  char* byte_res;
-  char* byte_idx1;
-  char* byte_idx2;
-  long int noPices = -1;
-  idx1 = (v2do*) pBlock1;
-  idx2 = (v2do*) pBlock2;
-  xor_res = (v2do*) pResult;
-  noPices = totalBytes / sizeof(v2do);
-
-  for (unsigned int i = 0; i < noPices; idx1++, idx2++, xor_res++, i++) {
-    *xor_res = *idx1 ^ *idx2;
+    XorRegions(data_blocks[index_dpblock](), srcs.data(), srcs.size(),
+               mStripeWidth, false);
   }
 
-  // If the block does not devide perfectly to 128 ...
-  if (totalBytes % sizeof(v2do) != 0) {
-    byte_res = (char*) xor_res;
-    byte_idx1 = (char*) idx1;
-    byte_idx2 = (char*) idx2;
-
-    for (unsigned int i = noPices * sizeof(v2do);
-         i < totalBytes;
-         byte_res++, byte_idx1++, byte_idx2++, i++) {
-      *byte_res = *byte_idx1 ^ *byte_idx2;
-    }
-  }
+  return true;
 }
 
 //------------------------------------------------------------------------------
@@ -169,7 +129,6 @@ RaidDpLayout::OperationXOR(char* pBlock1, char* pBlock2, char* pResult,
 bool
 RaidDpLayout::RecoverPiecesInGroup(XrdCl::ChunkList& grp_errs)
 {
-  int64_t nread = 0;
   bool ret = true;
   uint64_t offset_local;
   unsigned int stripe_id;
@@ -179,10 +138,9 @@ RaidDpLayout::RecoverPiecesInGroup(XrdCl::ChunkList& grp_errs)
   uint64_t offset = grp_errs.begin()->offset;
   uint64_t offset_group = (offset / mSizeGroup) * mSizeGroup;
   AsyncMetaHandler* phandler = 0;
-  XrdCl::ChunkList found_errs;
   vector<unsigned int> simple_parity = GetSimpleParityIndices();
   vector<unsigned int> double_parity = GetDoubleParityIndices();
-  std::vector<bool> status_blocks(mNbTotalBlocks, false);
+  std::vector<bool> status_blocks(mNbTotalBlocks, true);
   std::shared_ptr<eos::fst::RainGroup> grp = GetGroup(offset_group);
   eos::fst::RainGroup& data_blocks = *grp.get();
 
@@ -197,66 +155,11 @@ RaidDpLayout::RecoverPiecesInGroup(XrdCl::ChunkList& grp_errs)
     }
   }
 
-  // Read the current group of blocks
-  for (unsigned int i = 0; i < mNbTotalBlocks; i++) {
-    status_blocks[i] = true;
-    stripe_id = i % mNbTotalFiles;
-    physical_id = mapLP[stripe_id];
-    offset_local = (offset_group / mSizeLine) * mStripeWidth +
-                   ((i / mNbTotalFiles) * mStripeWidth);
-    offset_local += mSizeHeader;
-
-    // Read data from stripe
-    if (mStripe[physical_id]) {
-      // Enable readahead
-      nread = mStripe[physical_id]->fileReadPrefetch(offset_local, data_blocks[i](),
-              mStripeWidth, mTimeout);
-
-      if (nread != (int64_t)mStripeWidth) {
-        status_blocks[i] = false;
-        corrupt_ids.insert(i);
-      }
-    } else {
-      status_blocks[i] = false;
-      corrupt_ids.insert(i);
-    }
-  }
-
-  // Mark the corrupted blocks
-  for (unsigned int i = 0; i < mStripe.size(); i++) {
-    if (mStripe[i]) {
-      phandler  = static_cast<AsyncMetaHandler*>(mStripe[i]->fileGetAsyncHandler());
-
-      if (phandler) {
-        uint16_t error_type = phandler->WaitOK();
-
-        if (error_type != XrdCl::errNone) {
-          // Get type of error and the errors map
-          found_errs = phandler->GetErrors();
-
-          for (auto chunk = found_errs.begin(); chunk != found_errs.end(); chunk++) {
-            offset_local = chunk->offset - mSizeHeader;
-            int line = ((offset_local % mSizeLine) / mStripeWidth);
-            int index = line * mNbTotalFiles + mapPL[i];
-            status_blocks[index] = false;
-            corrupt_ids.insert(index);
-          }
-
-          found_errs.clear();
-
-          // If timeout error, then disable current file
-          if (error_type == XrdCl::errOperationExpired) {
-            mStripe[i]->fileClose(mTimeout);
-            delete mStripe[i];
-            mStripe[i] = NULL;
-          }
-        }
-
-        if (mStripe[i]) {
-          phandler->Reset();
-        }
-      }
-    }
+  // Read the current group of blocks, the reads might already be in flight
+  // if the group was fetched ahead
+  for (auto id : WaitGroupReads(grp, false)) {
+    status_blocks[id] = false;
+    corrupt_ids.insert(id);
   }
 
   if (corrupt_ids.empty()) {
@@ -277,17 +180,19 @@ RaidDpLayout::RecoverPiecesInGroup(XrdCl::ChunkList& grp_errs)
     corrupt_ids.erase(iter);
 
     if (ValidHorizStripe(horizontal_stripe, status_blocks, id_corrupted)) {
-      data_blocks[id_corrupted].FillWithZeros(true);
+      // The content is fully overwritten, only mark the block as complete
+      data_blocks[id_corrupted].FillWithZeros(false);
+      std::vector<const char*> srcs;
 
       for (unsigned int ind = 0; ind < horizontal_stripe.size(); ind++) {
         if (horizontal_stripe[ind] != id_corrupted) {
-          OperationXOR(data_blocks[id_corrupted](),
-                       data_blocks[horizontal_stripe[ind]](),
-                       data_blocks[id_corrupted](),
-                       mStripeWidth);
+          srcs.push_back(data_blocks[horizontal_stripe[ind]]());
         }
       }
 
+      XorRegions(data_blocks[id_corrupted](), srcs.data(), srcs.size(),
+                 mStripeWidth, false);
+
       // Return recovered block and also write it to the file
       stripe_id = id_corrupted % mNbTotalFiles;
       physical_id = mapLP[stripe_id];
@@ -336,17 +241,19 @@ RaidDpLayout::RecoverPiecesInGroup(XrdCl::ChunkList& grp_errs)
     } else {
       // Try to recover using double parity
       if (ValidDiagStripe(diagonal_stripe, status_blocks, id_corrupted)) {
-        data_blocks[id_corrupted].FillWithZeros(true);
+        // The content is fully overwritten, only mark the block as complete
+        data_blocks[id_corrupted].FillWithZeros(false);
+        std::vector<const char*> srcs;
 
         for (unsigned int ind = 0; ind < diagonal_stripe.size(); ind++) {
           if (diagonal_stripe[ind] != id_corrupted) {
-            OperationXOR(data_blocks[id_corrupted](),
-                         data_blocks[diagonal_stripe[ind]](),
-                         data_blocks[id_corrupted](),
-                         mStripeWidth);
+            srcs.push_back(data_blocks[diagonal_stripe[ind]]());
           }
         }
 
+        XorRegions(data_blocks[id_corrupted](), srcs.data(), srcs.size(),
+                   mStripeWidth, false);
+
         // Return recovered block and also write them to the files
         stripe_id = id_corrupted % mNbTotalFiles;
         physical_id = mapLP[stripe_id];
@@ -412,9 +319,7 @@ RaidDpLayout::RecoverPiecesInGroup(XrdCl::ChunkList& grp_errs)
           ret = false;
 
           if (error_type == XrdCl::errOperationExpired) {
-            mStripe[i]->fileClose(mTimeout);
-            delete mStripe[i];
-            mStripe[i] = NULL;
+            CloseStripe(i);
           }
         }
       }
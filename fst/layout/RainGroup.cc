@@ -90,4 +90,33 @@ RainGroup::WaitAsyncOK()
   return all_ok;
 }
 
+//------------------------------------------------------------------------------
+// Save future of an async read filling the given block
+//------------------------------------------------------------------------------
+void
+RainGroup::StoreReadFuture(unsigned int block_id,
+                           std::future<XrdCl::XRootDStatus>&& future)
+{
+  mHasReads = true;
+  mReadFutures[block_id] = std::move(future);
+}
+
+//------------------------------------------------------------------------------
+// Wait for completion of all the block reads
+//------------------------------------------------------------------------------
+const std::map<unsigned int, XrdCl::XRootDStatus>&
+RainGroup::WaitReads()
+{
+  for (auto& elem : mReadFutures) {
+    XrdCl::XRootDStatus status = elem.second.get();
+
+    if (!status.IsOK()) {
+      mReadErrors[elem.first] = status;
+    }
+  }
+
+  mReadFutures.clear();
+  return mReadErrors;
+}
+
 EOSFSTNAMESPACE_END
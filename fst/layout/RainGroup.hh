@@ -26,6 +26,7 @@
 #include "XrdCl/XrdClXRootDResponses.hh"
 #include <future>
 #include <list>
+#include <map>
 
 EOSFSTNAMESPACE_BEGIN
 
@@ -94,11 +95,41 @@ public:
   //----------------------------------------------------------------------------
   bool WaitAsyncOK();
 
+  //----------------------------------------------------------------------------
+  //! Save future of an async read filling the given block
+  //!
+  //! @param block_id index of the block in the group
+  //! @param future future object
+  //----------------------------------------------------------------------------
+  void StoreReadFuture(unsigned int block_id,
+                       std::future<XrdCl::XRootDStatus>&& future);
+
+  //----------------------------------------------------------------------------
+  //! Check if reads were already issued for the current group
+  //----------------------------------------------------------------------------
+  inline bool HasReads() const
+  {
+    return mHasReads;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Wait for completion of all the block reads. The result is saved so that
+  //! the method can be called several times.
+  //!
+  //! @return map of block ids which failed to their error status
+  //----------------------------------------------------------------------------
+  const std::map<unsigned int, XrdCl::XRootDStatus>& WaitReads();
+
 private:
   uint64_t mOffset; ///< Group offset of the current object
   std::vector<eos::fst::RainBlock> mBlocks;
   //! List of futures for async requests
   std::list<std::future<XrdCl::XRootDStatus>> mFutures;
+  //! Futures of the async reads indexed by block id
+  std::map<unsigned int, std::future<XrdCl::XRootDStatus>> mReadFutures;
+  //! Blocks which could not be read and their error status
+  std::map<unsigned int, XrdCl::XRootDStatus> mReadErrors;
+  bool mHasReads {false}; ///< Mark if reads were issued for the group
   mutable std::mutex mMutex;
 };
 
@@ -27,6 +27,7 @@
 #include <stdint.h>
 #include "common/Timing.hh"
 #include "fst/layout/RainMetaLayout.hh"
+#include "fst/layout/ErasureCoding.hh"
 #include "fst/io/AsyncMetaHandler.hh"
 #include "fst/layout/HeaderCRC.hh"
 
@@ -611,35 +612,22 @@ RainMetaLayout::Read(XrdSfsFileOffset offset, char* buffer,
     }
 
     if (((offset < 0) && (mIsRw)) || ((offset == 0) && mStoreRecovery)) {
-      // Force recover file mode - use first extra block as dummy buffer
-      offset = 0;
-      int64_t len = mFileSize;
-
-      // If file smaller than a group, set the read size to the size of the group
-      if (mFileSize < mSizeGroup) {
-        len = mSizeGroup;
-      }
-
+      // Force recover file mode - use one dummy buffer for all the groups
+      // and recover the whole file in one go so that the stripe reads of the
+      // next groups are done while the current one is decoded
       char* recover_block = new char[mStripeWidth];
 
-      while ((uint64_t)offset < mFileSize) {
+      for (offset = 0; (uint64_t)offset < mFileSize; offset += mSizeGroup) {
         all_errs.push_back(XrdCl::ChunkInfo((uint64_t)offset,
                                             (uint32_t) mStripeWidth,
                                             (void*)recover_block));
+      }
 
-        if (offset % mSizeGroup == 0) {
-          if (!RecoverPieces(all_errs)) {
-            eos_err("msg=\"failed recovery\" offset=%llu length=%d",
-                    offset, length);
-            delete[] recover_block;
-            return SFS_ERROR;
-          } else {
-            all_errs.clear();
-          }
-        }
-
-        len -= mSizeGroup;
-        offset += mSizeGroup;
+      if (!RecoverPieces(all_errs)) {
+        eos_err("msg=\"failed recovery\" file_size=%llu length=%d",
+                mFileSize, length);
+        delete[] recover_block;
+        return SFS_ERROR;
       }
 
       delete[] recover_block;
@@ -1034,30 +1022,31 @@ RainMetaLayout::DoBlockParity(uint64_t grp_off)
 bool
 RainMetaLayout::RecoverPieces(XrdCl::ChunkList& errs)
 {
-  bool success = true;
-  XrdCl::ChunkList grp_errs;
-
-  while (!errs.empty()) {
-    uint64_t group_off = (errs.begin()->offset / mSizeGroup) * mSizeGroup;
+  std::map<uint64_t, XrdCl::ChunkList> map_errs;
 
-    for (auto chunk = errs.begin(); chunk != errs.end(); /**/) {
-      if ((chunk->offset >= group_off) &&
-          (chunk->offset < group_off + mSizeGroup)) {
-        grp_errs.push_back(*chunk);
-        chunk = errs.erase(chunk);
-      } else {
-        ++chunk;
-      }
-    }
-
-    if (!grp_errs.empty()) {
-      success = success && RecoverPiecesInGroup(grp_errs);
-      grp_errs.clear();
-    } else {
-      eos_warning("%s", "msg=\"no elements, although we saw some before\"");
-    }
+  // Split the errors per group
+  for (const auto& chunk : errs) {
+    map_errs[(chunk.offset / mSizeGroup) * mSizeGroup].push_back(chunk);
   }
 
+  errs.clear();
+  // The reads for the next groups are issued while the current group is
+  // being decoded
+  using GroupIter = decltype(map_errs)::iterator;
+  bool success = RecoverGroupsPipelined(map_errs.begin(), map_errs.end(),
+  mRecoveryWindow, [this](GroupIter it) {
+    std::shared_ptr<eos::fst::RainGroup> grp = GetGroup(it->first);
+    FetchGroup(grp, false);
+    return grp;
+  }, [this](GroupIter it, std::shared_ptr<eos::fst::RainGroup>& grp) {
+    // Drop the reference so that the group can be recycled once recovered
+    grp.reset();
+    return RecoverPiecesInGroup(it->second);
+  }, [this](std::shared_ptr<eos::fst::RainGroup>& grp) {
+    // Don't leave reads in flight to buffers which are recycled
+    (void) grp->WaitReads();
+    RecycleGroup(grp);
+  });
   mDoneRecovery = true;
   return success;
 }
@@ -1113,13 +1102,24 @@ RainMetaLayout::MergePieces()
 bool
 RainMetaLayout::ReadGroup(uint64_t grp_off)
 {
-  unsigned int physical_id;
-  uint64_t off_local;
-  bool ret = true;
-  unsigned int id_stripe;
-  int64_t nread = 0;
-  AsyncMetaHandler* phandler = 0;
   std::shared_ptr<RainGroup> grp = GetGroup(grp_off);
+  std::set<unsigned int> failed = WaitGroupReads(grp, true);
+
+  for (auto block_id : failed) {
+    eos_err("msg=\"failed reading data block\" grp_off=%llu block_id=%u",
+            grp_off, block_id);
+  }
+
+  return failed.empty();
+}
+
+//------------------------------------------------------------------------------
+// Wait for the async write requests sent to the stripe files
+//------------------------------------------------------------------------------
+bool
+RainMetaLayout::WaitPendingWrites()
+{
+  AsyncMetaHandler* phandler = 0;
 
   // Collect all the write the responses and reset all the handlers
   for (unsigned int i = 0; i < mStripe.size(); i++) {
@@ -1137,48 +1137,7 @@ RainMetaLayout::ReadGroup(uint64_t grp_off)
     }
   }
 
-  for (unsigned int i = 0; i < mNbDataBlocks; i++) {
-    id_stripe = i % mNbDataFiles;
-    physical_id = mapLP[id_stripe];
-    off_local = ((grp_off / mSizeLine) + (i / mNbDataFiles)) * mStripeWidth;
-    off_local += mSizeHeader;
-
-    if (mStripe[physical_id]) {
-      // Do read operation - chunk info is not interesting at this point
-      // !!!Here we can only do normal async requests without readahead as this
-      // would lead to corruptions in the parity information computed!!!
-      nread = mStripe[physical_id]->fileReadAsync(off_local,
-              (*grp.get())[MapSmallToBig(i)](),
-              mStripeWidth, mTimeout);
-
-      if (nread != (int64_t)mStripeWidth) {
-        eos_err("msg=\"failed reading data block\" stripe=%u", id_stripe);
-        ret = false;
-        break;
-      }
-    } else {
-      eos_err("msg=\"file is null\" stripe_id=%u", id_stripe);
-      ret = false;
-      break;
-    }
-  }
-
-  // Collect read responses only for the data files as we only read from these
-  for (unsigned int i = 0; i < mNbDataFiles; i++) {
-    physical_id = mapLP[i];
-
-    if (mStripe[physical_id]) {
-      phandler = static_cast<AsyncMetaHandler*>
-                 (mStripe[physical_id]->fileGetAsyncHandler());
-
-      if (phandler && (phandler->WaitOK() != XrdCl::errNone)) {
-        eos_err("msg=\"failed reading blocks\" stripe=%u", i);
-        ret = false;
-      }
-    }
-  }
-
-  return ret;
+  return true;
 }
 
 //------------------------------------------------------------------------------
@@ -1264,15 +1223,43 @@ RainMetaLayout::SparseParityComputation(bool force)
   MergePieces();
   GetOffsetGroups(off_grps, force);
 
+  if (off_grps.empty()) {
+    return done;
+  }
+
+  // The data read back must include all the previous writes
+  if (!WaitPendingWrites()) {
+    return false;
+  }
+
+  // Keep the reads of the next groups in flight while the parity of the
+  // current one is computed and written
+  auto it_fetch = off_grps.begin();
+
   for (auto off = off_grps.begin(); off != off_grps.end(); off++) {
-    if (ReadGroup(*off)) {
-      done = DoBlockParity(*off);
+    while (done && (it_fetch != off_grps.end()) &&
+           (std::distance(off, it_fetch) < mRecoveryWindow)) {
+      std::shared_ptr<RainGroup> grp = GetGroup(*it_fetch);
+      FetchGroup(grp, true);
+      ++it_fetch;
+    }
 
-      if (!done) {
-        break;
+    if (done) {
+      if (ReadGroup(*off)) {
+        done = DoBlockParity(*off);
+      } else {
+        done = false;
       }
-    } else {
-      done = false;
+    }
+
+    if (!done) {
+      // Don't leave reads in flight to buffers which are recycled
+      for (auto it = std::next(off); it != it_fetch; ++it) {
+        std::shared_ptr<RainGroup> grp = GetGroup(*it);
+        (void) grp->WaitReads();
+        RecycleGroup(grp);
+      }
+
       break;
     }
   }
@@ -1672,6 +1659,112 @@ RainMetaLayout::GetAllGroupOffsets() const
   return lst;
 }
 
+//------------------------------------------------------------------------------
+// Issue asynchronous reads for the blocks of the given group
+//------------------------------------------------------------------------------
+void
+RainMetaLayout::FetchGroup(std::shared_ptr<eos::fst::RainGroup>& grp,
+                           bool data_only)
+{
+  if (grp->HasReads()) {
+    return;
+  }
+
+  unsigned int block_id;
+  unsigned int stripe_id;
+  uint64_t off_local;
+  uint64_t grp_off = grp->GetGroupOffset();
+  eos::fst::RainGroup& data_blocks = *grp.get();
+  unsigned int num_blocks = (data_only ? mNbDataBlocks : mNbTotalBlocks);
+
+  for (unsigned int i = 0; i < num_blocks; ++i) {
+    if (data_only) {
+      block_id = MapSmallToBig(i);
+      stripe_id = i % mNbDataFiles;
+      off_local = ((grp_off / mSizeLine) + (i / mNbDataFiles)) * mStripeWidth;
+    } else {
+      block_id = i;
+      stripe_id = i % mNbTotalFiles;
+      off_local = ((grp_off / mSizeLine) + (i / mNbTotalFiles)) * mStripeWidth;
+    }
+
+    off_local += mSizeHeader;
+    FileIo* file = mStripe[mapLP[stripe_id]];
+
+    if (file) {
+      grp->StoreReadFuture(block_id, file->fileReadAsync(data_blocks[block_id](),
+                           off_local, mStripeWidth, mTimeout));
+    } else {
+      // File not opened, register it as a read error
+      std::promise<XrdCl::XRootDStatus> promise;
+      promise.set_value(XrdCl::XRootDStatus(XrdCl::stError, XrdCl::errOSError,
+                                            EIO));
+      grp->StoreReadFuture(block_id, promise.get_future());
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Wait for the reads of the given group
+//------------------------------------------------------------------------------
+std::set<unsigned int>
+RainMetaLayout::WaitGroupReads(std::shared_ptr<eos::fst::RainGroup>& grp,
+                               bool data_only)
+{
+  std::set<unsigned int> failed;
+  std::set<unsigned int> expired;
+  FetchGroup(grp, data_only);
+
+  for (const auto& elem : grp->WaitReads()) {
+    unsigned int stripe_id = (elem.first % mNbTotalFiles);
+    eos_debug("msg=\"block read failed\" grp_off=%llu block_id=%u stripe=%u "
+              "err=\"%s\"", grp->GetGroupOffset(), elem.first, stripe_id,
+              elem.second.ToString().c_str());
+    failed.insert(elem.first);
+
+    if (elem.second.code == XrdCl::errOperationExpired) {
+      expired.insert(mapLP[stripe_id]);
+    }
+  }
+
+  // Disable the files which timed out as we assume the server is down
+  for (auto physical_id : expired) {
+    CloseStripe(physical_id);
+  }
+
+  return failed;
+}
+
+//------------------------------------------------------------------------------
+// Close and delete the given stripe file
+//------------------------------------------------------------------------------
+void
+RainMetaLayout::CloseStripe(unsigned int physical_id)
+{
+  if (mStripe[physical_id] == nullptr) {
+    return;
+  }
+
+  // Groups fetched ahead might still have reads in flight to this file
+  std::list<std::shared_ptr<eos::fst::RainGroup>> grps;
+  {
+    std::unique_lock<std::mutex> lock(mMutexGroups);
+
+    for (auto& elem : mMapGroups) {
+      grps.push_back(elem.second);
+    }
+  }
+
+  for (auto& grp : grps) {
+    (void) grp->WaitReads();
+  }
+
+  eos_debug("msg=\"closing stripe file\" physical_id=%u", physical_id);
+  mStripe[physical_id]->fileClose(mTimeout);
+  delete mStripe[physical_id];
+  mStripe[physical_id] = nullptr;
+}
+
 //------------------------------------------------------------------------------
 // Recycle given group by removing the group object from the map if there are
 // no more references to it. It will eventually be deleted and the RainBlocks
@@ -30,6 +30,7 @@
 #include <vector>
 #include <string>
 #include <list>
+#include <set>
 
 class XrdFstOfsFile;
 
@@ -258,6 +259,9 @@ protected:
   std::map<uint64_t, uint32_t> mMapPieces;
   std::string mLastErrMsg; ///< last error messages seen
   uint8_t mMaxGroups {32};
+  //! Max number of groups for which the stripe reads are in flight, the one
+  //! being recovered included, must be smaller than mMaxGroups
+  uint8_t mRecoveryWindow {4};
   mutable std::mutex mMutexGroups;
   std::condition_variable mCvGroups;
   std::map<uint64_t, std::shared_ptr<eos::fst::RainGroup>> mMapGroups;
@@ -276,6 +280,37 @@ protected:
   //----------------------------------------------------------------------------
   std::list<uint64_t> GetAllGroupOffsets() const;
 
+  //----------------------------------------------------------------------------
+  //! Issue asynchronous reads for the blocks of the given group from the
+  //! stripe files. If the reads were already issued then this is a no-op.
+  //!
+  //! @param grp group object
+  //! @param data_only if true read only the data blocks, otherwise read also
+  //!        the parity blocks
+  //----------------------------------------------------------------------------
+  void FetchGroup(std::shared_ptr<eos::fst::RainGroup>& grp, bool data_only);
+
+  //----------------------------------------------------------------------------
+  //! Wait for the reads of the given group, issuing them first if needed.
+  //! Stripe files which timed out are closed.
+  //!
+  //! @param grp group object
+  //! @param data_only if true read only the data blocks, otherwise read also
+  //!        the parity blocks
+  //!
+  //! @return set of block ids which could not be read
+  //----------------------------------------------------------------------------
+  std::set<unsigned int>
+  WaitGroupReads(std::shared_ptr<eos::fst::RainGroup>& grp, bool data_only);
+
+  //----------------------------------------------------------------------------
+  //! Close and delete the given stripe file after waiting for all the group
+  //! reads in flight since these might target the same file
+  //!
+  //! @param physical_id physical index of the stripe file
+  //----------------------------------------------------------------------------
+  void CloseStripe(unsigned int physical_id);
+
   //----------------------------------------------------------------------------
   //! Add new data block to the current group for parity computation. The pice
   //! must already be aligned so that it fits in one block of the group. This
@@ -418,7 +453,8 @@ private:
 
   //----------------------------------------------------------------------------
   //! Non-streaming operation
-  //! Read data from the current group for parity computation
+  //! Read data from the current group for parity computation, the reads
+  //! might have already been issued by FetchGroup
   //!
   //! @param offsetGroup offset of the group about to be read
   //!
@@ -426,6 +462,14 @@ private:
   //----------------------------------------------------------------------------
   bool ReadGroup(uint64_t offsetGroup);
 
+  //----------------------------------------------------------------------------
+  //! Non-streaming operation
+  //! Wait for the async write requests sent to the stripe files
+  //!
+  //! @return true if all writes were successful, otherwise false
+  //----------------------------------------------------------------------------
+  bool WaitPendingWrites();
+
   //----------------------------------------------------------------------------
   //! Convert a global offset (from the inital file) to a local offset within
   //! a stripe data file. The initial block does *NOT* span multiple chunks
@@ -28,11 +28,7 @@
 #include "common/Timing.hh"
 #include "fst/layout/ReedSLayout.hh"
 #include "fst/io/AsyncMetaHandler.hh"
-#include "fst/layout/jerasure/include/jerasure.h"
-#include "fst/layout/jerasure/include/reed_sol.h"
-#include "fst/layout/jerasure/include/galois.h"
-#include "fst/layout/jerasure/include/cauchy.h"
-#include "fst/layout/jerasure/include/liberation.h"
+#include "fst/layout/ErasureCoding.hh"
 
 EOSFSTNAMESPACE_BEGIN
 
@@ -50,7 +46,7 @@ ReedSLayout::ReedSLayout(XrdFstOfsFile* file,
                          std::string bookingOpaque) :
   RainMetaLayout(file, lid, client, outError, path, timeout,
                  storeRecovery, targetSize, bookingOpaque),
-  mPacketSize(0), matrix(0), bitmatrix(0), schedule(0)
+  mPacketSize(0)
 {
   mNbDataBlocks = mNbDataFiles;
   mNbTotalBlocks = mNbDataFiles + mNbParityFiles;
@@ -77,14 +73,9 @@ ReedSLayout::InitialiseJerasure()
     throw std::runtime_error("Jerasure initialization failed");
   }
 
-  // Initialise Jerasure data structures
-  static std::mutex jerasure_init_mutex;
-  std::lock_guard<std::mutex> lock(jerasure_init_mutex);
-  matrix = cauchy_good_general_coding_matrix(mNbDataBlocks, mNbParityFiles, w);
-  bitmatrix = jerasure_matrix_to_bitmatrix(mNbDataBlocks, mNbParityFiles, w,
-              matrix);
-  schedule = jerasure_smart_bitmatrix_to_schedule(mNbDataBlocks, mNbParityFiles,
-             w, bitmatrix);
+  // The Jerasure data structures are shared by all files with the same
+  // layout parameters
+  mCodec = ReedSCodec::Get(mNbDataBlocks, mNbParityFiles, w);
 }
 
 //------------------------------------------------------------------------------
@@ -107,8 +98,7 @@ ReedSLayout::ComputeParity(std::shared_ptr<eos::fst::RainGroup>& grp)
   }
 
   // Encode the blocks
-  jerasure_schedule_encode(mNbDataBlocks, mNbParityFiles, w, schedule, data,
-                           coding, mStripeWidth, mPacketSize);
+  mCodec->Encode(data, coding, mStripeWidth, mPacketSize);
   return true;
 }
 
@@ -120,12 +110,8 @@ bool
 ReedSLayout::RecoverPiecesInGroup(XrdCl::ChunkList& grp_errs)
 {
   bool ret = true;
-  int64_t nread = 0;
   int64_t nwrite = 0;
   unsigned int physical_id;
-  // Use "set" as we might add the same stripe index twice as a result of an early
-  // error detected when sending the request and by the async handler
-  set<unsigned int> invalid_ids;
   uint64_t offset = grp_errs.begin()->offset;
   uint64_t offset_local = (offset / mSizeGroup) * mStripeWidth;
   uint64_t offset_group = (offset / mSizeGroup) * mSizeGroup;
@@ -133,58 +119,8 @@ ReedSLayout::RecoverPiecesInGroup(XrdCl::ChunkList& grp_errs)
   eos::fst::RainGroup& data_blocks = *grp.get();
   AsyncMetaHandler* phandler = 0;
   offset_local += mSizeHeader;
-
-  for (unsigned int i = 0; i < mNbTotalFiles; i++) {
-    physical_id = mapLP[i];
-
-    // Read data from stripe
-    if (mStripe[physical_id]) {
-      phandler = static_cast<AsyncMetaHandler*>
-                 (mStripe[physical_id]->fileGetAsyncHandler());
-
-      if (phandler) {
-        phandler->Reset();
-      }
-
-      // Enable readahead
-      nread = mStripe[physical_id]->fileReadPrefetch(offset_local, data_blocks[i](),
-              mStripeWidth, mTimeout);
-
-      if (nread != (int64_t)mStripeWidth) {
-        eos_debug("msg=\"read block corrupted\" stripe=%u.", i);
-        invalid_ids.insert(i);
-      }
-    } else {
-      // File not opened, register it as an error
-      invalid_ids.insert(i);
-    }
-  }
-
-  // Wait for read responses and mark corrupted blocks
-  for (unsigned int i = 0; i < mStripe.size(); i++) {
-    physical_id = mapLP[i];
-
-    if (mStripe[physical_id]) {
-      phandler = static_cast<AsyncMetaHandler*>
-                 (mStripe[physical_id]->fileGetAsyncHandler());
-
-      if (phandler) {
-        uint16_t error_type = phandler->WaitOK();
-
-        if (error_type != XrdCl::errNone) {
-          std::pair< uint16_t, std::map<uint64_t, uint32_t> > pair_err;
-          eos_debug("msg=\"remote block corrupted\" id=%u", i);
-          invalid_ids.insert(i);
-
-          if (error_type == XrdCl::errOperationExpired) {
-            mStripe[physical_id]->fileClose(mTimeout);
-            delete mStripe[physical_id];
-            mStripe[physical_id] = NULL;
-          }
-        }
-      }
-    }
-  }
+  // The reads might already be in flight if the group was fetched ahead
+  std::set<unsigned int> invalid_ids = WaitGroupReads(grp, false);
 
   if (invalid_ids.size() == 0) {
     RecycleGroup(grp);
@@ -219,13 +155,12 @@ ReedSLayout::RecoverPiecesInGroup(XrdCl::ChunkList& grp_errs)
 
   erasures[invalid_ids.size()] = -1;
   // ******* DECODE ******
-  int decode = jerasure_schedule_decode_lazy(mNbDataBlocks, mNbParityFiles, w,
-               bitmatrix, erasures, data, coding,
-               mStripeWidth, mPacketSize, 1);
+  bool decode = mCodec->Decode(erasures, data, coding, mStripeWidth,
+                               mPacketSize);
   // Free memory
   delete[] erasures;
 
-  if (decode == -1) {
+  if (!decode) {
     eos_err("msg=\"decoding was unsuccessful\"");
     RecycleGroup(grp);
     return false;
@@ -291,9 +226,7 @@ ReedSLayout::RecoverPiecesInGroup(XrdCl::ChunkList& grp_errs)
           ret = false;
 
           if (error_type == XrdCl::errOperationExpired) {
-            mStripe[physical_id]->fileClose(mTimeout);
-            delete mStripe[physical_id];
-            mStripe[physical_id] = NULL;
+            CloseStripe(physical_id);
           }
         }
       }
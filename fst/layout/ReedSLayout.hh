@@ -24,9 +24,12 @@
 
 #pragma once
 #include "fst/layout/RainMetaLayout.hh"
+#include <memory>
 
 EOSFSTNAMESPACE_BEGIN
 
+class ReedSCodec;
+
 //------------------------------------------------------------------------------
 //! Implementation of the Reed-Solomon layout - this uses the Jerasure code
 //! for implementing Cauchy Reed-Solomon
@@ -100,9 +103,8 @@ private:
   //! Values use by Jerasure codes
   unsigned int w;           ///< word size for Jerasure
   unsigned int mPacketSize; ///< packet size for Jerasure
-  int* matrix;
-  int* bitmatrix;
-  int** schedule;
+  std::shared_ptr<ReedSCodec> mCodec; ///< Codec shared by all files with the
+                                      ///< same (k, m, w) parameters
 
   //----------------------------------------------------------------------------
   //! Initialise the Jerasure structures used for encoding and decoding
@@ -198,6 +198,19 @@ int jerasure_schedule_decode_lazy(int k, int m, int w, int *bitmatrix, int *eras
 int jerasure_schedule_decode_cache(int k, int m, int w, int ***scache, int *erasures,
                             char **data_ptrs, char **coding_ptrs, int size, int packetsize);
 
+/* Building blocks of jerasure_schedule_decode_lazy, exported so that the
+   decoding schedules can be cached and executed by the caller:
+   - jerasure_generate_decoding_schedule returns the schedule for the given
+     erasures, to be freed with jerasure_free_schedule.
+   - set_up_ptrs_for_scheduled_decoding returns the device pointers expected
+     by that schedule, to be freed with free(). */
+
+int **jerasure_generate_decoding_schedule(int k, int m, int w, int *bitmatrix,
+                            int *erasures, int smart);
+
+char **set_up_ptrs_for_scheduled_decoding(int k, int m, int *erasures,
+                            char **data_ptrs, char **coding_ptrs);
+
 int jerasure_make_decoding_matrix(int k, int m, int w, int *matrix, int *erased, 
                                   int *decoding_matrix, int *dm_ids);
 
@@ -865,7 +865,7 @@ int jerasure_bitmatrix_decode(int k, int m, int w, int* bitmatrix,
   return 0;
 }
 
-static char** set_up_ptrs_for_scheduled_decoding(int k, int m, int* erasures,
+char** set_up_ptrs_for_scheduled_decoding(int k, int m, int* erasures,
     char** data_ptrs, char** coding_ptrs)
 {
   int ddf, cdf;
@@ -995,7 +995,7 @@ static int set_up_ids_for_scheduled_decoding(int k, int m, int* erasures,
   return 0;
 }
 
-static int** jerasure_generate_decoding_schedule(int k, int m, int w,
+int** jerasure_generate_decoding_schedule(int k, int m, int w,
     int* bitmatrix, int* erasures, int smart)
 {
   int i, j, x, drive, y, index, z;
@@ -29,7 +29,6 @@
 #include "namespace/ns_quarkdb/BackendClient.hh"
 #include "qclient/Formatting.hh"
 #include "common/LinuxStat.hh"
-#include "common/ShellCmd.hh"
 #include "common/Timing.hh"
 #include "common/IntervalStopwatch.hh"
 #include "XrdVersion.hh"
@@ -68,59 +67,26 @@ static std::string HotFilesToString(
 //------------------------------------------------------------------------------
 // Retrieve net speed
 //------------------------------------------------------------------------------
-static uint64_t GetNetSpeed(const std::string& tmpname)
+static uint64_t GetNetSpeed()
 {
   if (getenv("EOS_FST_NETWORK_SPEED")) {
     return strtoull(getenv("EOS_FST_NETWORK_SPEED"), nullptr, 10);
   }
 
-  std::string getNetspeedCommand = SSTR(
-                                     "ip route list | sed -ne '/^default/s/.*dev //p' | cut -d ' ' -f1 |"
-                                     " xargs -i ethtool {} 2>&1 | grep Speed | cut -d ' ' -f2 | cut -d 'M' -f1 > "
-                                     << tmpname);
-  eos::common::ShellCmd scmd1(getNetspeedCommand.c_str());
-  eos::common::cmd_status rc = scmd1.wait(5);
-  unsigned long long netspeed = 1000000000;
-
-  if (rc.exit_code) {
-    eos_static_err("ip route list call failed to get netspeed");
-    return netspeed;
-  }
-
-  FILE* fnetspeed = fopen(tmpname.c_str(), "r");
-
-  if (fnetspeed) {
-    if ((fscanf(fnetspeed, "%llu", &netspeed)) == 1) {
-      // we get MB as a number => convert into bytes
-      netspeed *= 1000000;
-      eos_static_info("ethtool:networkspeed=%.02f GB/s",
-                      1.0 * netspeed / 1000000000.0);
-    }
+  // Speed of the default route interface
+  unsigned long long netspeed = SysStat::GetNetSpeed();
 
-    fclose(fnetspeed);
+  if (netspeed == 0) {
+    eos_static_err("%s", "msg=\"failed to get netspeed of the default route "
+                   "interface\"");
+    return 1000000000;
   }
 
+  eos_static_info("msg=\"netspeed of the default route interface from "
+                  "sysfs\" netspeed=%.02fGb/s", 1.0 * netspeed / 1000000000.0);
   return netspeed;
 }
 
-//------------------------------------------------------------------------------
-// Retrieve uptime
-//------------------------------------------------------------------------------
-static std::string GetUptime(const std::string& tmpname)
-{
-  eos::common::ShellCmd cmd(SSTR("uptime | tr -d \"\n\" > " << tmpname));
-  eos::common::cmd_status rc = cmd.wait(5);
-
-  if (rc.exit_code) {
-    eos_static_err("retrieve uptime call failed");
-    return "N/A";
-  }
-
-  std::string retval;
-  eos::common::StringConversion::LoadFileIntoString(tmpname.c_str(), retval);
-  return retval;
-}
-
 //------------------------------------------------------------------------------
 // Retrieve xrootd version
 //------------------------------------------------------------------------------
@@ -156,34 +122,14 @@ static std::string GetNetworkInterface()
   return "eth0";
 }
 
-//------------------------------------------------------------------------------
-// Retrieve number of TCP sockets in the system
-// TODO: Change return value to integer..
-//------------------------------------------------------------------------------
-static std::string GetNumOfTcpSockets(const std::string& tmpname)
-{
-  std::string command = SSTR("cat /proc/net/tcp | wc -l | tr -d \"\n\" > " <<
-                             tmpname);
-  eos::common::ShellCmd cmd(command.c_str());
-  eos::common::cmd_status rc = cmd.wait(5);
-
-  if (rc.exit_code) {
-    eos_static_err("retrieve #socket call failed");
-  }
-
-  std::string retval;
-  eos::common::StringConversion::LoadFileIntoString(tmpname.c_str(), retval);
-  return retval;
-}
-
 //------------------------------------------------------------------------------
 // Get statistics about this FST, used for publishing
 //------------------------------------------------------------------------------
 std::map<std::string, std::string>
-Storage::GetFstStatistics(const std::string& tmpfile,
-                          unsigned long long netspeed)
+Storage::GetFstStatistics(unsigned long long netspeed)
 {
   eos::common::LinuxStat::linux_stat_t osstat;
+  SysStat::Snapshot sysstat = mFstLoad.GetSysStat();
 
   if (!eos::common::LinuxStat::GetStat(osstat)) {
     eos_crit("failed to get the memory usage information");
@@ -205,9 +151,10 @@ Storage::GetFstStatistics(const std::string& tmpfile,
   // adler32 of keytab
   output["stat.sys.keytab"] = eos::fst::Config::gConfig.KeyTabAdler.c_str();
   // machine uptime
-  output["stat.sys.uptime"] = GetUptime(tmpfile);
+  output["stat.sys.uptime"] = (sysstat.mUptime.empty() ? "N/A" :
+                                sysstat.mUptime);
   // active TCP sockets
-  output["stat.sys.sockets"] = GetNumOfTcpSockets(tmpfile);
+  output["stat.sys.sockets"] = SSTR(sysstat.mTcpSockets);
   // startup time of the FST daemon
   output["stat.sys.eos.start"] = eos::fst::Config::gConfig.StartDate.c_str();
   // FST geotag
@@ -233,25 +180,6 @@ Storage::GetFstStatistics(const std::string& tmpfile,
   return output;
 }
 
-//------------------------------------------------------------------------------
-// open random temporary file in /tmp/
-// Return value: string containing the temporary file. If opening it was
-// not possible, return empty string.
-//------------------------------------------------------------------------------
-std::string makeTemporaryFile()
-{
-  char tmp_name[] = "/tmp/fst.publish.XXXXXX";
-  int tmp_fd = mkstemp(tmp_name);
-
-  if (tmp_fd == -1) {
-    eos_static_crit("failed to create temporary file!");
-    return "";
-  }
-
-  (void) close(tmp_fd);
-  return tmp_name;
-}
-
 //------------------------------------------------------------------------------
 // Insert statfs info into the map
 //------------------------------------------------------------------------------
@@ -415,13 +343,7 @@ Storage::Publish(ThreadAssistant& assistant)
 {
   eos_static_info("%s", "msg=\"publisher activated\"");
   // Get our network speed
-  std::string tmp_name = makeTemporaryFile();
-
-  if (tmp_name.empty()) {
-    return;
-  }
-
-  unsigned long long netspeed = GetNetSpeed(tmp_name);
+  unsigned long long netspeed = GetNetSpeed();
   eos_static_info("msg=\"publish networkspeed=%.02f GB/s\"",
                   1.0 * netspeed / 1000000000.0);
   // The following line acts as a barrier that prevents progress
@@ -462,7 +384,7 @@ Storage::Publish(ThreadAssistant& assistant)
           }
         }
 
-        auto fstStats = GetFstStatistics(tmp_name, netspeed);
+        auto fstStats = GetFstStatistics(netspeed);
         // Set node status values
         common::SharedHashLocator locator =
           Config::gConfig.getNodeHashLocator("Publish");
@@ -488,8 +410,6 @@ Storage::Publish(ThreadAssistant& assistant)
       assistant.wait_for(sleepTime);
     }
   }
-
-  (void) unlink(tmp_name.c_str());
 }
 
 EOSFSTNAMESPACE_END
@@ -225,7 +225,7 @@ private:
   //! Get statistics about this FST, used for publishing
   //----------------------------------------------------------------------------
   std::map<std::string, std::string> GetFstStatistics(
-    const std::string& tmpfile, unsigned long long netspeed);
+    unsigned long long netspeed);
 
   //----------------------------------------------------------------------------
   //! Publish statistics about the given filesystem
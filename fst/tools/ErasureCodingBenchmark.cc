@@ -0,0 +1,184 @@
+//------------------------------------------------------------------------------
+//! @file ErasureCodingBenchmark.cc
+//! @brief Compare the Jerasure schedule execution against the vectorized
+//!        erasure coding used by the RAIN layouts
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2021 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "common/CLI11.hpp"
+#include "fst/layout/ErasureCoding.hh"
+#include "fst/layout/jerasure/include/jerasure.h"
+#include "fst/layout/jerasure/include/cauchy.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+//------------------------------------------------------------------------------
+//! Allocate k + m page aligned blocks filled with random data
+//------------------------------------------------------------------------------
+static std::vector<char*>
+AllocateBlocks(int num, size_t size)
+{
+  std::mt19937_64 gen(42);
+  std::vector<char*> blocks(num, nullptr);
+
+  for (auto& block : blocks) {
+    if (posix_memalign((void**)&block, 4096, size)) {
+      std::cerr << "error: failed to allocate blocks" << std::endl;
+      std::exit(ENOMEM);
+    }
+
+    for (size_t i = 0; i < size; i += sizeof(uint64_t)) {
+      uint64_t val = gen();
+      memcpy(block + i, &val, std::min(sizeof(val), size - i));
+    }
+  }
+
+  return blocks;
+}
+
+//------------------------------------------------------------------------------
+//! Time the given function
+//!
+//! @return duration in microseconds
+//------------------------------------------------------------------------------
+template <typename Func>
+static uint64_t
+Measure(uint32_t iterations, Func&& func)
+{
+  auto start = std::chrono::steady_clock::now();
+
+  for (uint32_t i = 0; i < iterations; ++i) {
+    func();
+  }
+
+  auto duration = std::chrono::duration_cast<std::chrono::microseconds>
+                  (std::chrono::steady_clock::now() - start);
+  return std::max<uint64_t>(1, duration.count());
+}
+
+//------------------------------------------------------------------------------
+// Main programm
+//------------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+  CLI::App app{"Erasure coding benchmark - Jerasure vs vectorized schedule"};
+  std::vector<int> data_blocks {4, 6, 10};
+  std::vector<int> parity_blocks {2, 3, 4};
+  std::vector<uint32_t> block_sizes {64 * 1024, 1024 * 1024};
+  uint32_t iterations = 100;
+  const int w = 8;
+  app.add_option("-k,--data", data_blocks, "number of data blocks");
+  app.add_option("-m,--parity", parity_blocks, "number of parity blocks, "
+                 "one entry per data blocks entry");
+  app.add_option("-b,--block_sz", block_sizes, "block (stripe) sizes");
+  app.add_option("-n,--iterations", iterations, "iterations per test");
+  CLI11_PARSE(app, argc, argv);
+
+  if (data_blocks.size() != parity_blocks.size()) {
+    std::cerr << "error: need one parity entry for each data entry"
+              << std::endl;
+    return EINVAL;
+  }
+
+  std::cout << "xor implementation: " << eos::fst::GetXorImplementation()
+            << std::endl
+            << "k\tm\tblock\tencode_jerasure[MB/s]\tencode_eos[MB/s]\t"
+            << "decode_jerasure[MB/s]\tdecode_eos[MB/s]" << std::endl
+            << std::fixed << std::setprecision(2);
+
+  for (size_t indx = 0; indx < data_blocks.size(); ++indx) {
+    int k = data_blocks[indx];
+    int m = parity_blocks[indx];
+
+    for (auto size : block_sizes) {
+      // Packet size computed the same way as in the ReedSLayout
+      size_t packet_size = size / (w * sizeof(int));
+
+      if ((packet_size == 0) || (size % (packet_size * w))) {
+        std::cerr << "error: block size must be a multiple of "
+                  << w * sizeof(int) << std::endl;
+        return EINVAL;
+      }
+
+      std::vector<char*> blocks = AllocateBlocks(k + m, size);
+      std::vector<char*> ref_blocks = AllocateBlocks(k + m, size);
+      int* matrix = cauchy_good_general_coding_matrix(k, m, w);
+      int* bitmatrix = jerasure_matrix_to_bitmatrix(k, m, w, matrix);
+      int** schedule = jerasure_smart_bitmatrix_to_schedule(k, m, w, bitmatrix);
+      auto codec = eos::fst::ReedSCodec::Get(k, m, w);
+      uint64_t jenc_us = Measure(iterations, [&]() {
+        jerasure_schedule_encode(k, m, w, schedule, ref_blocks.data(),
+                                 ref_blocks.data() + k, size, packet_size);
+      });
+      uint64_t enc_us = Measure(iterations, [&]() {
+        codec->Encode(blocks.data(), blocks.data() + k, size, packet_size);
+      });
+      // Erase the first m data blocks
+      std::vector<int> erasures;
+
+      for (int i = 0; i < std::min(k, m); ++i) {
+        erasures.push_back(i);
+      }
+
+      erasures.push_back(-1);
+      uint64_t jdec_us = Measure(iterations, [&]() {
+        jerasure_schedule_decode_lazy(k, m, w, bitmatrix, erasures.data(),
+                                      ref_blocks.data(), ref_blocks.data() + k,
+                                      size, packet_size, 1);
+      });
+      uint64_t dec_us = Measure(iterations, [&]() {
+        codec->Decode(erasures.data(), blocks.data(), blocks.data() + k,
+                      size, packet_size);
+      });
+
+      for (int i = 0; i < k + m; ++i) {
+        if (memcmp(blocks[i], ref_blocks[i], size)) {
+          std::cerr << "error: output differs from Jerasure for k=" << k
+                    << " m=" << m << " block=" << i << std::endl;
+          return EIO;
+        }
+      }
+
+      double total_bytes = (double)iterations * k * size;
+      std::cout << k << "\t" << m << "\t" << size << "\t"
+                << total_bytes / jenc_us << "\t" << total_bytes / enc_us << "\t"
+                << total_bytes / jdec_us << "\t" << total_bytes / dec_us << std::endl;
+      jerasure_free_schedule(schedule);
+      free(bitmatrix);
+      free(matrix);
+
+      for (auto block : blocks) {
+        free(block);
+      }
+
+      for (auto block : ref_blocks) {
+        free(block);
+      }
+    }
+  }
+
+  return 0;
+}
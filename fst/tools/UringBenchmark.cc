@@ -0,0 +1,259 @@
+//------------------------------------------------------------------------------
+//! @file UringBenchmark.cc
+//! @brief Compare synchronous pread against io_uring reads at different
+//!        queue depths
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2021 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "common/CLI11.hpp"
+#include "fst/io/local/UringQueue.hh"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <fcntl.h>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+//------------------------------------------------------------------------------
+//! Generate the list of block aligned offsets to be read
+//!
+//! @param file_size size of the file
+//! @param block_sz size of a read request
+//! @param num_reqs number of requests
+//! @param random if true generate random offsets, otherwise sequential ones
+//!        wrapping around at the end of the file
+//------------------------------------------------------------------------------
+static std::vector<off_t>
+GenerateOffsets(uint64_t file_size, uint32_t block_sz, uint64_t num_reqs,
+                bool random)
+{
+  uint64_t num_blocks = file_size / block_sz;
+  std::vector<off_t> offsets;
+  offsets.reserve(num_reqs);
+  std::mt19937_64 gen(42);
+  std::uniform_int_distribution<uint64_t> dist(0, num_blocks - 1);
+
+  for (uint64_t i = 0; i < num_reqs; ++i) {
+    offsets.push_back((random ? dist(gen) : (i % num_blocks)) * block_sz);
+  }
+
+  return offsets;
+}
+
+//------------------------------------------------------------------------------
+//! Allocate one aligned buffer per request slot, O_DIRECT needs aligned
+//! buffers
+//------------------------------------------------------------------------------
+static std::vector<char*>
+AllocateBuffers(uint32_t count, uint32_t block_sz)
+{
+  std::vector<char*> buffers(count, nullptr);
+
+  for (auto& buff : buffers) {
+    if (posix_memalign((void**)&buff, 4096, block_sz)) {
+      std::cerr << "error: failed to allocate buffers" << std::endl;
+      std::exit(ENOMEM);
+    }
+  }
+
+  return buffers;
+}
+
+//------------------------------------------------------------------------------
+//! Run the synchronous pread benchmark, the queue depth is given by the
+//! number of threads each one doing blocking reads
+//!
+//! @return duration in microseconds
+//------------------------------------------------------------------------------
+static uint64_t
+RunSync(int fd, const std::vector<off_t>& offsets, uint32_t block_sz,
+        uint32_t qdepth)
+{
+  std::atomic<uint64_t> next {0};
+  std::vector<char*> buffers = AllocateBuffers(qdepth, block_sz);
+  std::vector<std::thread> workers;
+  auto start = std::chrono::steady_clock::now();
+
+  for (uint32_t i = 0; i < qdepth; ++i) {
+    workers.emplace_back([&, i]() {
+      uint64_t indx;
+
+      while ((indx = next++) < offsets.size()) {
+        if (::pread(fd, buffers[i], block_sz, offsets[indx]) < 0) {
+          std::cerr << "error: pread failed errno=" << errno << std::endl;
+          std::exit(errno);
+        }
+      }
+    });
+  }
+
+  for (auto& th : workers) {
+    th.join();
+  }
+
+  auto duration = std::chrono::duration_cast<std::chrono::microseconds>
+                  (std::chrono::steady_clock::now() - start);
+
+  for (auto buff : buffers) {
+    free(buff);
+  }
+
+  return duration.count();
+}
+
+//------------------------------------------------------------------------------
+//! Run the io_uring benchmark from a single thread, keeping qdepth requests
+//! in flight and submitting them in batches
+//!
+//! @return duration in microseconds
+//------------------------------------------------------------------------------
+static uint64_t
+RunUring(int fd, const std::vector<off_t>& offsets, uint32_t block_sz,
+         uint32_t qdepth, uint32_t batch_sz)
+{
+  eos::fst::UringQueue queue(qdepth);
+
+  if (!queue.IsAvailable()) {
+    std::cerr << "error: io_uring is not available" << std::endl;
+    std::exit(ENOTSUP);
+  }
+
+  // Buffers are handed out round-robin, their content is never looked at
+  std::vector<char*> buffers = AllocateBuffers(qdepth, block_sz);
+  std::mutex mutex;
+  std::condition_variable cv;
+  uint64_t num_done = 0;
+  std::vector<eos::fst::UringQueue::Request> batch;
+  batch.reserve(batch_sz);
+  auto start = std::chrono::steady_clock::now();
+
+  for (uint64_t i = 0; i < offsets.size(); ++i) {
+    batch.push_back(eos::fst::UringQueue::Request{
+      false, fd, buffers[i % qdepth], block_sz, offsets[i],
+      [&](int64_t retc) {
+        if (retc < 0) {
+          std::cerr << "error: io_uring read failed errno=" << -retc
+                    << std::endl;
+          std::exit(-retc);
+        }
+
+        std::unique_lock<std::mutex> lock(mutex);
+
+        if (++num_done == offsets.size()) {
+          cv.notify_one();
+        }
+      }
+    });
+
+    if (batch.size() == batch_sz) {
+      queue.Submit(batch);
+      batch.clear();
+    }
+  }
+
+  if (batch.size()) {
+    queue.Submit(batch);
+  }
+
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    cv.wait(lock, [&]() {
+      return (num_done == offsets.size());
+    });
+  }
+
+  auto duration = std::chrono::duration_cast<std::chrono::microseconds>
+                  (std::chrono::steady_clock::now() - start);
+
+  for (auto buff : buffers) {
+    free(buff);
+  }
+
+  return duration.count();
+}
+
+//------------------------------------------------------------------------------
+// Main programm
+//------------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+  CLI::App app{"Local IO benchmark - synchronous pread vs io_uring"};
+  std::string path;
+  uint32_t block_sz = 4096;
+  uint64_t num_reqs = 100000;
+  uint32_t max_qdepth = 128;
+  uint32_t batch_sz = 16;
+  bool direct = false;
+  bool sequential = false;
+  app.add_option("-f,--file", path, "file to read from, e.g. on the "
+                 "filesystem under test")->required();
+  app.add_option("-b,--block_sz", block_sz, "size of a read request");
+  app.add_option("-n,--num_reqs", num_reqs, "number of read requests per run");
+  app.add_option("-q,--max_qdepth", max_qdepth, "max queue depth");
+  app.add_option("-s,--batch_sz", batch_sz, "io_uring submission batch size");
+  app.add_flag("-d,--direct", direct, "use O_DIRECT to bypass the page cache");
+  app.add_flag("--sequential", sequential, "sequential instead of random "
+               "offsets");
+  CLI11_PARSE(app, argc, argv);
+  int fd = ::open(path.c_str(), O_RDONLY | (direct ? O_DIRECT : 0));
+
+  if (fd < 0) {
+    std::cerr << "error: failed to open file " << path << " errno="
+              << errno << std::endl;
+    return errno;
+  }
+
+  struct stat info;
+
+  if (::fstat(fd, &info) || ((uint64_t)info.st_size < block_sz) ||
+      (block_sz == 0) || (batch_sz == 0)) {
+    std::cerr << "error: file needs to be at least one block and block/batch "
+              << "size must be non-zero" << std::endl;
+    ::close(fd);
+    return EINVAL;
+  }
+
+  std::vector<off_t> offsets = GenerateOffsets(info.st_size, block_sz,
+                               num_reqs, !sequential);
+  std::cout << "qdepth\tsync[kIOPS]\tsync[MB/s]\turing[kIOPS]\turing[MB/s]"
+            << std::endl << std::fixed << std::setprecision(2);
+
+  for (uint32_t qd = 1; qd <= max_qdepth; qd *= 2) {
+    uint64_t sync_us = RunSync(fd, offsets, block_sz, qd);
+    uint64_t uring_us = RunUring(fd, offsets, block_sz, qd,
+                                 std::min(batch_sz, qd));
+    std::cout << qd << "\t"
+              << (double)num_reqs * 1000 / sync_us << "\t"
+              << (double)num_reqs * block_sz / sync_us << "\t"
+              << (double)num_reqs * 1000 / uring_us << "\t"
+              << (double)num_reqs * block_sz / uring_us << std::endl;
+  }
+
+  ::close(fd);
+  return 0;
+}
@@ -7,9 +7,14 @@
 #include <dirent.h>
 #include <errno.h>
 #include <sys/types.h>
+#include <sys/resource.h>
+#include <ctype.h>
+#include <string.h>
 #include <vector>
 #include <string>
 #include <set>
+#include <map>
+#include <thread>
 
 #include "common/Timing.hh"
 #include "common/ShellCmd.hh"
@@ -32,6 +37,78 @@
 #define LOOP_18 100
 #define LOOP_19 100
 #define LOOP_20 10
+#define LOOP_21 1000
+#define LOOP_22 10
+#define LOOP_23 256
+#define LOOP_24 100000
+#define LOOP_25 1000
+#define LOOP_26 16
+#define LOOP_27 20
+#define LOOP_28 256
+
+// CPU time in seconds used so far by the eosxd processes of this host
+static double
+eosxd_cputime()
+{
+  double ticks = 0;
+  DIR* proc = opendir("/proc");
+
+  if (!proc) {
+    return 0;
+  }
+
+  struct dirent* entry;
+
+  while ((entry = readdir(proc))) {
+    if (!isdigit(entry->d_name[0])) {
+      continue;
+    }
+
+    std::string path = std::string("/proc/") + entry->d_name + "/stat";
+    FILE* f = fopen(path.c_str(), "r");
+
+    if (!f) {
+      continue;
+    }
+
+    char line[4096];
+    size_t n = fread(line, 1, sizeof(line) - 1, f);
+    fclose(f);
+    line[n] = 0;
+    // the command is in parentheses and can contain blanks
+    char* cmd = strchr(line, '(');
+    char* end = strrchr(line, ')');
+
+    if (!cmd || !end || (std::string(cmd + 1, end - cmd - 1) != "eosxd")) {
+      continue;
+    }
+
+    unsigned long utime = 0;
+    unsigned long stime = 0;
+
+    if (sscanf(end + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu",
+               &utime, &stime) == 2) {
+      ticks += utime + stime;
+    }
+  }
+
+  closedir(proc);
+  return ticks / sysconf(_SC_CLK_TCK);
+}
+
+// CPU time in seconds used so far by this process
+static double
+self_cputime()
+{
+  struct rusage usage;
+
+  if (getrusage(RUSAGE_SELF, &usage)) {
+    return 0;
+  }
+
+  return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec +
+         (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1000000.0;
+}
 
 int main(int argc, char* argv[])
 {
@@ -886,6 +963,387 @@ int main(int argc, char* argv[])
     COMMONTIMING("version-rename-loop", &tm);
   }
 
+  // ------------------------------------------------------------------------ //
+  testno = 21;
+
+  if ((testno >= test_start) && (testno <= test_stop)) {
+    fprintf(stderr, ">>> test %04d\n", testno);
+
+    // 'ls -l' pattern: list a directory and stat every entry - with
+    // readdirplus the attributes come with the listing, without it every
+    // stat which is not cached by the kernel yet is a separate lookup
+    if (mkdir("test-readdirplus", S_IRWXU)) {
+      fprintf(stderr, "[test=%03d] mkdir failed errno=%d\n", testno, errno);
+      exit(testno);
+    }
+
+    for (size_t i = 0; i < LOOP_21; i++) {
+      snprintf(name, sizeof(name), "test-readdirplus/file-%04lu", i);
+      int fd = creat(name, S_IRWXU);
+
+      if (fd < 0) {
+        fprintf(stderr, "[test=%03d] creat failed i=%lu\n", testno, i);
+        exit(testno);
+      }
+
+      close(fd);
+    }
+
+    COMMONTIMING("readdirplus-create-loop", &tm);
+
+    for (size_t i = 0; i < LOOP_22; i++) {
+      DIR* dir = opendir("test-readdirplus");
+
+      if (!dir) {
+        fprintf(stderr, "[test=%03d] opendir failed i=%lu\n", testno, i);
+        exit(testno);
+      }
+
+      size_t nentries = 0;
+      struct dirent* rdir;
+
+      while ((rdir = readdir(dir))) {
+        if (fstatat(dirfd(dir), rdir->d_name, &buf, AT_SYMLINK_NOFOLLOW)) {
+          fprintf(stderr, "[test=%03d] stat failed name=%s i=%lu\n", testno,
+                  rdir->d_name, i);
+          exit(testno);
+        }
+
+        nentries++;
+      }
+
+      closedir(dir);
+
+      if (nentries != (LOOP_21 + 2)) {
+        fprintf(stderr, "[test=%03d] listing incomplete %lu/%d i=%lu\n", testno,
+                nentries, LOOP_21 + 2, i);
+        exit(testno);
+      }
+
+      if (i == 0) {
+        COMMONTIMING("readdir-stat-first", &tm);
+      }
+    }
+
+    COMMONTIMING("readdir-stat-loop", &tm);
+
+    for (size_t i = 0; i < LOOP_21; i++) {
+      snprintf(name, sizeof(name), "test-readdirplus/file-%04lu", i);
+      unlink(name);
+    }
+
+    rmdir("test-readdirplus");
+  }
+
+  // ------------------------------------------------------------------------ //
+  testno = 22;
+
+  if ((testno >= test_start) && (testno <= test_stop)) {
+    fprintf(stderr, ">>> test %04d\n", testno);
+
+    // single stream throughput: write and re-read LOOP_23 MB in 1M blocks.
+    // The kernel page cache of the file is dropped before the re-read, so it
+    // goes through eosxd, and the CPU time spent per GB read is reported.
+    std::vector<char> buffer(1024 * 1024, 'e');
+    int fd = creat("test-stream", S_IRWXU);
+
+    if (fd < 0) {
+      fprintf(stderr, "[test=%03d] creat failed errno=%d\n", testno, errno);
+      exit(testno);
+    }
+
+    eos::common::Timing st("stream");
+    COMMONTIMING("start", &st);
+
+    for (size_t i = 0; i < LOOP_23; i++) {
+      if (write(fd, &buffer[0], buffer.size()) != (ssize_t) buffer.size()) {
+        fprintf(stderr, "[test=%03d] write failed errno=%d i=%lu\n", testno, errno,
+                i);
+        exit(testno);
+      }
+    }
+
+    if (close(fd)) {
+      fprintf(stderr, "[test=%03d] close failed errno=%d\n", testno, errno);
+      exit(testno);
+    }
+
+    COMMONTIMING("write", &st);
+    double wtime = st.RealTime();
+    fd = open("test-stream", O_RDONLY);
+
+    if (fd < 0) {
+      fprintf(stderr, "[test=%03d] open failed errno=%d\n", testno, errno);
+      exit(testno);
+    }
+
+    if (posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED)) {
+      fprintf(stderr, "[test=%03d] fadvise failed errno=%d\n", testno, errno);
+      exit(testno);
+    }
+
+    double daemon_cpu = eosxd_cputime();
+    double self_cpu = self_cputime();
+
+    for (size_t i = 0; i < LOOP_23; i++) {
+      if (read(fd, &buffer[0], buffer.size()) != (ssize_t) buffer.size()) {
+        fprintf(stderr, "[test=%03d] read failed errno=%d i=%lu\n", testno, errno,
+                i);
+        exit(testno);
+      }
+    }
+
+    close(fd);
+    COMMONTIMING("read", &st);
+    double rtime = st.RealTime() - wtime;
+    daemon_cpu = eosxd_cputime() - daemon_cpu;
+    self_cpu = self_cputime() - self_cpu;
+    fprintf(stdout, "stream write = %.02f MB/s read = %.02f MB/s\n",
+            wtime ? LOOP_23 * 1000.0 / wtime : 0, rtime ? LOOP_23 * 1000.0 / rtime : 0);
+    fprintf(stdout, "stream read cpu eosxd = %.03f s/GB benchmark = %.03f s/GB\n",
+            daemon_cpu * 1024 / LOOP_23, self_cpu * 1024 / LOOP_23);
+    unlink("test-stream");
+    COMMONTIMING("stream-write-read", &tm);
+  }
+
+  // ------------------------------------------------------------------------ //
+  testno = 23;
+
+  if ((testno >= test_start) && (testno <= test_stop)) {
+    fprintf(stderr, ">>> test %04d\n", testno);
+
+    // log file pattern: many small appending writes, which the kernel
+    // writeback cache turns into few large ones
+    int fd = open("test-smallwrites", O_CREAT | O_WRONLY | O_APPEND, S_IRWXU);
+
+    if (fd < 0) {
+      fprintf(stderr, "[test=%03d] open failed errno=%d\n", testno, errno);
+      exit(testno);
+    }
+
+    for (size_t i = 0; i < LOOP_24; i++) {
+      snprintf(name, sizeof(name), "line %08lu of a log file\n", i);
+
+      if (write(fd, name, strlen(name)) != (ssize_t) strlen(name)) {
+        fprintf(stderr, "[test=%03d] write failed errno=%d i=%lu\n", testno, errno,
+                i);
+        exit(testno);
+      }
+    }
+
+    if (close(fd)) {
+      fprintf(stderr, "[test=%03d] close failed errno=%d\n", testno, errno);
+      exit(testno);
+    }
+
+    if (stat("test-smallwrites", &buf) ||
+        (buf.st_size != (off_t)(LOOP_24 * strlen(name)))) {
+      fprintf(stderr, "[test=%03d] wrong file size\n", testno);
+      exit(testno);
+    }
+
+    unlink("test-smallwrites");
+    COMMONTIMING("small-append-loop", &tm);
+  }
+
+  // ------------------------------------------------------------------------ //
+  testno = 24;
+
+  if ((testno >= test_start) && (testno <= test_stop)) {
+    fprintf(stderr, ">>> test %04d\n", testno);
+    // parallel lookup/getattr throughput: LOOP_26 threads stat the same
+    // LOOP_25 files LOOP_27 times, each starting at a different file. With
+    // the kernel metadata cache enabled most of them never reach eosxd.
+    mkdir("test-parallel-stat", S_IRWXU);
+
+    for (size_t i = 0; i < LOOP_25; i++) {
+      snprintf(name, sizeof(name), "test-parallel-stat/file-%04lu", i);
+      int fd = creat(name, S_IRWXU);
+
+      if (fd < 0) {
+        fprintf(stderr, "[test=%03d] creat failed i=%lu\n", testno, i);
+        exit(testno);
+      }
+
+      close(fd);
+    }
+
+    COMMONTIMING("parallel-stat-create", &tm);
+    eos::common::Timing st("parallel-stat");
+    COMMONTIMING("start", &st);
+    std::vector<std::thread> workers;
+    std::vector<size_t> errors(LOOP_26);
+
+    for (size_t t = 0; t < LOOP_26; t++) {
+      workers.emplace_back([t, &errors]() {
+        char fname[1024];
+        struct stat fbuf;
+
+        for (size_t n = 0; n < LOOP_27 * LOOP_25; n++) {
+          size_t i = (n + t * LOOP_25 / LOOP_26) % LOOP_25;
+          snprintf(fname, sizeof(fname), "test-parallel-stat/file-%04lu", i);
+
+          if (stat(fname, &fbuf)) {
+            errors[t]++;
+          }
+        }
+      });
+    }
+
+    for (auto& w : workers) {
+      w.join();
+    }
+
+    COMMONTIMING("stat", &st);
+
+    for (size_t t = 0; t < LOOP_26; t++) {
+      if (errors[t]) {
+        fprintf(stderr, "[test=%03d] stat failed %lu times in thread %lu\n", testno,
+                errors[t], t);
+        exit(testno);
+      }
+    }
+
+    fprintf(stdout, "parallel stat threads = %d rate = %.02f kHz\n", LOOP_26,
+            st.RealTime() ? (1.0 * LOOP_26 * LOOP_27 * LOOP_25 / st.RealTime()) : 0);
+
+    for (size_t i = 0; i < LOOP_25; i++) {
+      snprintf(name, sizeof(name), "test-parallel-stat/file-%04lu", i);
+      unlink(name);
+    }
+
+    rmdir("test-parallel-stat");
+    COMMONTIMING("parallel-stat-loop", &tm);
+  }
+
+  // ------------------------------------------------------------------------ //
+  testno = 25;
+
+  if ((testno >= test_start) && (testno <= test_stop)) {
+    fprintf(stderr, ">>> test %04d\n", testno);
+    // read trace replay: replays the reads of the trace file given in
+    // FUSEX_BENCHMARK_TRACE, one '<path> <offset> <length>' per line, in
+    // order and through one open file per path. Without a trace two
+    // interleaved sequential readers and a strided one (ROOT basket like)
+    // read a LOOP_28 MB file.
+    struct trace_read {
+      std::string path;
+      off_t offset;
+      size_t length;
+    };
+    std::vector<trace_read> trace;
+    const char* tracefile = getenv("FUSEX_BENCHMARK_TRACE");
+
+    if (tracefile) {
+      FILE* fp = fopen(tracefile, "r");
+
+      if (!fp) {
+        fprintf(stderr, "[test=%03d] cannot open trace %s errno=%d\n", testno,
+                tracefile, errno);
+        exit(testno);
+      }
+
+      char path[4096];
+      long long offset;
+      unsigned long length;
+
+      while (fscanf(fp, "%4095s %lld %lu", path, &offset, &length) == 3) {
+        trace.push_back(trace_read{path, (off_t) offset, (size_t) length});
+      }
+
+      fclose(fp);
+    } else {
+      std::vector<char> buffer(1024 * 1024, 't');
+      int fd = creat("test-trace", S_IRWXU);
+
+      if (fd < 0) {
+        fprintf(stderr, "[test=%03d] creat failed errno=%d\n", testno, errno);
+        exit(testno);
+      }
+
+      for (size_t i = 0; i < LOOP_28; i++) {
+        if (write(fd, &buffer[0], buffer.size()) != (ssize_t) buffer.size()) {
+          fprintf(stderr, "[test=%03d] write failed errno=%d i=%lu\n", testno, errno,
+                  i);
+          exit(testno);
+        }
+      }
+
+      if (close(fd)) {
+        fprintf(stderr, "[test=%03d] close failed errno=%d\n", testno, errno);
+        exit(testno);
+      }
+
+      // 64k reads through the first and second quarter, 4k every 1M in the
+      // second half
+      off_t quarter = LOOP_28 * 1024ll * 1024ll / 4;
+
+      for (off_t i = 0; i < quarter / 65536; i++) {
+        trace.push_back(trace_read{"test-trace", i * 65536, 65536});
+        trace.push_back(trace_read{"test-trace", quarter + i * 65536, 65536});
+
+        if (!(i % 8)) {
+          trace.push_back(trace_read{"test-trace", 2 * quarter + i / 8 * 1048576, 4096});
+        }
+      }
+
+      COMMONTIMING("trace-write", &tm);
+    }
+
+    std::map<std::string, int> fds;
+
+    for (auto it = trace.begin(); it != trace.end(); ++it) {
+      if (!fds.count(it->path)) {
+        int fd = open(it->path.c_str(), O_RDONLY);
+
+        if (fd < 0) {
+          fprintf(stderr, "[test=%03d] open failed errno=%d path=%s\n", testno,
+                  errno, it->path.c_str());
+          exit(testno);
+        }
+
+        fds[it->path] = fd;
+      }
+    }
+
+    std::vector<char> buffer;
+    size_t total = 0;
+    eos::common::Timing st("trace");
+    COMMONTIMING("start", &st);
+
+    for (auto it = trace.begin(); it != trace.end(); ++it) {
+      if (buffer.size() < it->length) {
+        buffer.resize(it->length);
+      }
+
+      ssize_t nread = pread(fds[it->path], &buffer[0], it->length, it->offset);
+
+      if (nread < 0) {
+        fprintf(stderr, "[test=%03d] read failed errno=%d path=%s offset=%ld\n",
+                testno, errno, it->path.c_str(), (long) it->offset);
+        exit(testno);
+      }
+
+      total += nread;
+    }
+
+    COMMONTIMING("replay", &st);
+
+    for (auto it = fds.begin(); it != fds.end(); ++it) {
+      close(it->second);
+    }
+
+    fprintf(stdout, "trace replay reads = %lu volume = %.02f MB rate = %.02f MB/s\n",
+            trace.size(), total / 1000000.0,
+            st.RealTime() ? total / 1000.0 / st.RealTime() : 0);
+
+    if (!tracefile) {
+      unlink("test-trace");
+    }
+
+    COMMONTIMING("trace-replay", &tm);
+  }
+
   tm.Print();
   fprintf(stdout, "realtime = %.02f\n", tm.RealTime());
 }
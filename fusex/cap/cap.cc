@@ -88,14 +88,17 @@ void
 cap::reset()
 /* -------------------------------------------------------------------------- */
 {
-  XrdSysMutexHelper mLock(capmap);
-  XrdSysMutexHelper rLock(revocationLock);
+  for (size_t i = 0; i < cmap::kShards; ++i) {
+    cmap::shard_t& s = capmap.shard_at(i);
+    XrdSysMutexHelper mLock(s);
+    XrdSysMutexHelper rLock(revocationLock);
 
-  for (auto it : capmap) {
-    revocationset.insert(it.second->authid());
-  }
+    for (auto it : s) {
+      revocationset.insert(it.second->authid());
+    }
 
-  capmap.clear();
+    s.clear();
+  }
 }
 
 /* -------------------------------------------------------------------------- */
@@ -159,12 +162,13 @@ cap::ls()
 /* -------------------------------------------------------------------------- */
 {
   std::string listing;
-  XrdSysMutexHelper mLock(capmap);
+  size_t ncaps = 0;
 
-  for (auto it = capmap.begin(); it != capmap.end(); ++it) {
-    listing += it->second->dump(false);
+  capmap.for_eachTS([&](const std::string & cid, shared_cap & cap) {
+    listing += cap->dump(false);
     listing += "\n";
-  }
+    ncaps++;
+  });
 
   if (listing.size() > (64 * 1000)) {
     listing.resize((64 * 1000));
@@ -172,7 +176,7 @@ cap::ls()
   }
 
   char csize[32];
-  snprintf(csize, sizeof(csize), "# [ %lu caps ]\n", capmap.size());
+  snprintf(csize, sizeof(csize), "# [ %lu caps ]\n", ncaps);
   listing += csize;
   return listing;
 }
@@ -188,10 +192,11 @@ cap::get(fuse_req_t req,
   std::string cid = cap::capx::capid(req, ino);
   std::string clientid = cap::capx::getclientid(req);
   eos_static_debug("inode=%08lx cap-id=%s", ino, cid.c_str());
-  XrdSysMutexHelper mLock(capmap);
+  cmap::shard_t& s = capmap.shard(cid);
+  XrdSysMutexHelper mLock(s);
 
-  if (capmap.count(cid)) {
-    shared_cap cap = capmap[cid];
+  if (s.count(cid)) {
+    shared_cap cap = s[cid];
     return cap;
   } else {
     shared_cap cap = std::make_shared<capx>();
@@ -203,7 +208,7 @@ cap::get(fuse_req_t req,
     cap->set_gid(fuse_req_ctx(req)->gid);
     cap->set_vtime(0);
     cap->set_vtime_ns(0);
-    capmap[cid] = cap;
+    s[cid] = cap;
     return cap;
   }
 }
@@ -216,13 +221,12 @@ cap::get(fuse_ino_t ino, std::string clientid)
 {
   std::string cid = cap::capx::capid(ino, clientid);
   eos_static_debug("inode=%08lx cap-id=%s", ino, cid.c_str());
-  XrdSysMutexHelper mLock(capmap);
+  shared_cap cap;
 
-  if (capmap.count(cid)) {
-    shared_cap cap = capmap[cid];
+  if (capmap.retrieveTS(cid, cap)) {
     return cap;
   } else {
-    shared_cap cap = std::make_shared<capx>();
+    cap = std::make_shared<capx>();
     cap->set_id(0);
     return cap;
   }
@@ -238,10 +242,11 @@ cap::store(fuse_req_t req,
   std::string clientid = cap::capx::getclientid(req);
   uint64_t id = mds->vmaps().forward(icap.id());
   std::string cid = cap::capx::capid(req, id); // cid uses the local inode
-  XrdSysMutexHelper mLock(capmap);
+  cmap::shard_t& s = capmap.shard(cid);
+  XrdSysMutexHelper mLock(s);
 
-  if (capmap.count(cid)) {
-    shared_cap cap = capmap[cid];
+  if (s.count(cid)) {
+    shared_cap cap = s[cid];
     *cap = icap;
     cap->set_id(id);
   } else {
@@ -249,12 +254,40 @@ cap::store(fuse_req_t req,
     cap->set_clientid(clientid);
     *cap = icap;
     cap->set_id(id);
-    capmap[cid] = cap;
+    s[cid] = cap;
   }
 
   eos_static_debug("store inode=[r:%lx l:%lx] capid=%s cap: %s", icap.id(), id,
                    cid.c_str(),
-                   capmap[cid]->dump().c_str());
+                   s[cid]->dump().c_str());
+}
+
+/* -------------------------------------------------------------------------- */
+std::vector<fuse_ino_t>
+/* -------------------------------------------------------------------------- */
+cap::inval_writers(fuse_ino_t ino)
+/* -------------------------------------------------------------------------- */
+{
+  // with the kernel writeback cache, dirty pages of files written under a cap
+  // are only in the kernel - invalidating a file makes the kernel write them
+  // back to us before it drops its cached pages. This has to happen before
+  // the cap is released and the caller has to wait for the resulting
+  // metadata updates to leave the mdqueue, otherwise other clients get the
+  // cap while the size and mtime of these writes are still local.
+  std::vector<fuse_ino_t> inodes;
+
+  if (!EosFuse::Instance().Config().options.writeback_cache) {
+    return inodes;
+  }
+
+  inodes = EosFuse::Instance().datas.writers(ino);
+
+  for (auto it = inodes.begin(); it != inodes.end(); ++it) {
+    eos_static_info("writeback: cap-ino=%#lx flushing ino=%#lx", ino, *it);
+    kernelcache::inval_inode(*it, true);
+  }
+
+  return inodes;
 }
 
 /* -------------------------------------------------------------------------- */
@@ -265,14 +298,15 @@ cap::forget(const std::string& cid)
 {
   fuse_ino_t inode = 0;
   {
-    XrdSysMutexHelper mLock(capmap);
+    cmap::shard_t& s = capmap.shard(cid);
+    XrdSysMutexHelper mLock(s);
 
-    if (capmap.count(cid)) {
+    if (s.count(cid)) {
       eos_static_debug("forget capid=%s cap: %s", cid.c_str(),
-                       capmap[cid]->dump().c_str());
-      shared_cap cap = capmap[cid];
+                       s[cid]->dump().c_str());
+      shared_cap cap = s[cid];
       inode = cap->id();
-      capmap.erase(cid);
+      s.erase(cid);
       XrdSysMutexHelper rLock(revocationLock);
       revocationset.insert(cap->authid());
     } else {
@@ -306,9 +340,8 @@ cap::imply(shared_cap cap,
                          EosFuse::Instance().Config().options.leasetime);
   std::string clientid = cap->clientid();
   std::string cid = capx::capid(ino, clientid);
-  XrdSysMutexHelper mLock(capmap);
   // TODO: deal with the influence of mode to the cap itself
-  capmap[cid] = implied_cap;
+  capmap.insertTS(cid, implied_cap);
   return cid;
 }
 
@@ -350,12 +383,13 @@ cap::acquire(fuse_req_t req,
 
     eos_static_debug("%s", cap->dump().c_str());
   }
-  XrdSysMutexHelper mLock(capmap);
+  cmap::shard_t& s = capmap.shard(cid);
+  XrdSysMutexHelper mLock(s);
   XrdSysMutexHelper mLock2(cap->Locker());
 
   if (try_attach) {
-    if (!capmap.count(cid)) {
-      capmap[cid] = cap;
+    if (!s.count(cid)) {
+      s[cid] = cap;
       cap->set_id(ino);
     }
   }
@@ -526,16 +560,12 @@ cap::capflush(ThreadAssistant& assistant)
 {
   while (!assistant.terminationRequested()) {
     {
-      cmap capdelmap;
+      std::map<std::string, shared_cap> capdelmap;
       cinodes capdelinodes;
 
-      cmap flushcaps;
-
       // avoid keeping two mutexes
-      {
-	XrdSysMutexHelper capLock(capmap);
-	flushcaps = capmap;
-      }
+      std::vector<std::pair<std::string, shared_cap>> flushcaps =
+        capmap.snapshotTS();
 
       for (auto it = flushcaps.begin(); it != flushcaps.end(); ++it) {
         XrdSysMutexHelper cLock(it->second->Locker());
@@ -553,12 +583,22 @@ cap::capflush(ThreadAssistant& assistant)
         }
       }
 
-      {
-	XrdSysMutexHelper capLock(capmap);
-	for (auto it = capdelmap.begin(); it != capdelmap.end(); ++it) {
-	  // remove the expired or invalidated by delete caps
-	  capmap.erase(it->first);
-	}
+      for (auto it = capdelinodes.begin(); it != capdelinodes.end(); ++it) {
+        // the writes cached in the kernel have to be flushed out while the
+        // caps are still there
+        std::vector<fuse_ino_t> flushing = inval_writers(*it);
+        flushing.push_back(*it);
+
+        for (auto fit = flushing.begin(); fit != flushing.end(); ++fit) {
+          while (mds->has_flush(*fit) && !assistant.terminationRequested()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(25));
+          }
+        }
+      }
+
+      for (auto it = capdelmap.begin(); it != capdelmap.end(); ++it) {
+        // remove the expired or invalidated by delete caps
+        capmap.eraseTS(it->first);
       }
 
       for (auto it = capdelinodes.begin(); it != capdelinodes.end(); ++it) {
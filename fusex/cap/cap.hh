@@ -31,10 +31,12 @@
 #include "backend/backend.hh"
 #include "md/md.hh"
 #include "fusex/fusex.pb.h"
+#include "misc/ShardedMap.hh"
 
 #include "XrdSys/XrdSysPthread.hh"
 #include <memory>
 #include <map>
+#include <vector>
 
 
 // extension to permission capabilities
@@ -154,7 +156,7 @@ public:
     shared_quota get(shared_cap cap);
   };
 
-  class cmap : public std::map<std::string, shared_cap>, public XrdSysMutex
+  class cmap : public ShardedMap<std::string, shared_cap>
   //----------------------------------------------------------------------------
   {
   public:
@@ -279,6 +281,10 @@ public:
 
   fuse_ino_t forget(const std::string& capid);
 
+  // write back the kernel cached dirty pages of the files written under the
+  // cap of ino, returns the inodes to wait for in the mdqueue
+  static std::vector<fuse_ino_t> inval_writers(fuse_ino_t ino);
+
   void store(fuse_req_t req,
              eos::fusex::cap cap);
 
@@ -289,8 +295,8 @@ public:
   void reset();
 
   void clear() {
-    capmap.clear();
-    capextionsmap.clear();
+    capmap.clearTS();
+    capextionsmap.clearTS();
     quotamap.clear();  
   }
 
@@ -307,8 +313,7 @@ public:
 
   size_t size()
   {
-    XrdSysMutexHelper mLock(capmap);
-    return capmap.size();
+    return capmap.sizeTS();
   }
 
   revocation_set_t& get_revocationmap()
@@ -59,6 +59,13 @@ public:
     return 0;
   }
 
+  // descriptor of a local file holding the cached data at their file offsets,
+  // which replies can be spliced from - -1 if there is none
+  virtual int splice_fd()
+  {
+    return -1;
+  }
+
   virtual int set_attr(const std::string& key, const std::string& value) = 0;
   virtual int attr(const std::string& key, std::string& value) = 0;
 
@@ -52,7 +52,7 @@ struct cacheconfig {
   uint64_t max_read_ahead_size; // max value for read-ahead block size
   size_t max_read_ahead_blocks; // max  number of read-ahead blocks
   float clean_threshold; // filling percentage of the cache disk when we start to delete
-  std::string read_ahead_strategy; // string values 'none', 'static', 'dynamic'
+  std::string read_ahead_strategy; // string values 'none', 'static', 'dynamic', 'adaptive'
   std::string journal;
   bool clean_on_startup; // indicate that the cache is not reusable after restart
 };
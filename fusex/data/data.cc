@@ -90,38 +90,41 @@ data::get(fuse_req_t req,
           metad::shared_md md)
 /* -------------------------------------------------------------------------- */
 {
-  XrdSysMutexHelper mLock(datamap);
-
-  if (datamap.count(ino)) {
-    shared_data io = datamap[ino];
-    io->attach(); // client ref counting
-    return io;
-  } else {
-    // protect against running out of file descriptors
-    size_t openfiles = datamap.size();
-    size_t openlimit = (EosFuse::Instance().Config().options.fdlimit - 128) / 2;
-
-    while ((openfiles = datamap.size()) > openlimit) {
-      datamap.UnLock();
-      eos_static_warning("open-files=%lu limit=%lu - waiting for release of file descriptors",
-                         openfiles, openlimit);
-      std::this_thread::sleep_for(std::chrono::milliseconds(1000));
-      datamap.Lock();
-    }
+  dmap::shard_t& s = datamap.shard(ino);
+  {
+    XrdSysMutexHelper mLock(s);
 
-    if (datamap.count(ino)) {
-      // might have been created in the meanwhile
-      shared_data io = datamap[ino];
+    if (s.count(ino)) {
+      shared_data io = s[ino];
       io->attach(); // client ref counting
       return io;
-    } else {
-      shared_data io = std::make_shared<datax>(md);
-      io->set_id(ino, req);
-      datamap[(fuse_ino_t) io->id()] = io;
-      io->attach();
-      return io;
     }
   }
+  // protect against running out of file descriptors - the size is summed
+  // over all shards, so this has to run without holding the shard lock
+  size_t openfiles = 0;
+  size_t openlimit = (EosFuse::Instance().Config().options.fdlimit - 128) / 2;
+
+  while ((openfiles = datamap.sizeTS()) > openlimit) {
+    eos_static_warning("open-files=%lu limit=%lu - waiting for release of file descriptors",
+                       openfiles, openlimit);
+    std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+  }
+
+  XrdSysMutexHelper mLock(s);
+
+  if (s.count(ino)) {
+    // might have been created in the meanwhile
+    shared_data io = s[ino];
+    io->attach(); // client ref counting
+    return io;
+  } else {
+    shared_data io = std::make_shared<datax>(md);
+    io->set_id(ino, req);
+    s[(fuse_ino_t) io->id()] = io;
+    io->attach();
+    return io;
+  }
 }
 
 /* -------------------------------------------------------------------------- */
@@ -130,11 +133,12 @@ bool
 data::has(fuse_ino_t ino, bool checkwriteopen)
 /* -------------------------------------------------------------------------- */
 {
-  XrdSysMutexHelper mLock(datamap);
+  dmap::shard_t& s = datamap.shard(ino);
+  XrdSysMutexHelper mLock(s);
 
-  if (datamap.count(ino)) {
+  if (s.count(ino)) {
     if (checkwriteopen) {
-      if (datamap[ino]->flags() & (O_RDWR | O_WRONLY)) {
+      if (s[ino]->flags() & (O_RDWR | O_WRONLY)) {
         return true;
       } else {
         return false;
@@ -153,17 +157,53 @@ data::retrieve_wr_md(fuse_ino_t ino)
 /* -------------------------------------------------------------------------- */
 {
   // return the shared_md  boject if this is a writer
-  XrdSysMutexHelper mLock(datamap);
+  dmap::shard_t& s = datamap.shard(ino);
+  XrdSysMutexHelper mLock(s);
 
-  if (datamap.count(ino)) {
-    if (datamap[ino]->flags() & (O_RDWR | O_WRONLY)) {
-      return datamap[ino]->md();
+  if (s.count(ino)) {
+    if (s[ino]->flags() & (O_RDWR | O_WRONLY)) {
+      return s[ino]->md();
     }
   }
 
   return nullptr;
 }
 
+/* -------------------------------------------------------------------------- */
+std::vector<fuse_ino_t>
+/* -------------------------------------------------------------------------- */
+data::writers(fuse_ino_t ino)
+/* -------------------------------------------------------------------------- */
+{
+  std::vector<fuse_ino_t> inodes;
+  std::vector<std::pair<fuse_ino_t, metad::shared_md>> open_writers;
+
+  datamap.for_eachTS([&](const fuse_ino_t & key, shared_data & io) {
+    if (!(io->flags() & (O_RDWR | O_WRONLY))) {
+      return;
+    }
+
+    open_writers.push_back(std::make_pair(io->id(), io->md()));
+  });
+
+  // the md objects are locked outside of the datamap shard locks, a rename
+  // can change the parent concurrently
+  for (auto it = open_writers.begin(); it != open_writers.end(); ++it) {
+    fuse_ino_t pino = 0;
+
+    if (it->second) {
+      XrdSysMutexHelper mLock(it->second->Locker());
+      pino = it->second->pid();
+    }
+
+    if ((it->first == ino) || (pino == ino)) {
+      inodes.push_back(it->first);
+    }
+  }
+
+  return inodes;
+}
+
 /* -------------------------------------------------------------------------- */
 void
 /* -------------------------------------------------------------------------- */
@@ -171,17 +211,18 @@ data::release(fuse_req_t req,
               fuse_ino_t ino)
 /* -------------------------------------------------------------------------- */
 {
-  XrdSysMutexHelper mLock(datamap);
+  dmap::shard_t& s = datamap.shard(ino);
+  XrdSysMutexHelper mLock(s);
 
-  if (datamap.count(ino)) {
-    shared_data io = datamap[ino];
+  if (s.count(ino)) {
+    shared_data io = s[ino];
     io->detach();
     // the object is cleaned by the flush thread
   }
 
-  if (datamap.count(ino + 0xffffffff)) {
+  if (s.count(ino + 0xffffffff)) {
     // in case this is an unlinked object
-    shared_data io = datamap[ino + 0xffffffff];
+    shared_data io = s[ino + 0xffffffff];
     io->detach();
   }
 }
@@ -191,10 +232,11 @@ void
 data::update_cookie(uint64_t ino, std::string& cookie)
 /* -------------------------------------------------------------------------- */
 {
-  XrdSysMutexHelper mLock(datamap);
+  dmap::shard_t& s = datamap.shard(ino);
+  XrdSysMutexHelper mLock(s);
 
-  if (datamap.count(ino)) {
-    shared_data io = datamap[ino];
+  if (s.count(ino)) {
+    shared_data io = s[ino];
     io->attach(); // client ref counting
     io->store_cookie(cookie);
     io->detach();
@@ -207,10 +249,11 @@ void
 data::invalidate_cache(fuse_ino_t ino)
 /* -------------------------------------------------------------------------- */
 {
-  XrdSysMutexHelper mLock(datamap);
+  dmap::shard_t& s = datamap.shard(ino);
+  XrdSysMutexHelper mLock(s);
 
-  if (datamap.count(ino)) {
-    shared_data io = datamap[ino];
+  if (s.count(ino)) {
+    shared_data io = s[ino];
     io->attach(); // client ref counting
     io->cache_invalidate();
     io->detach();
@@ -225,14 +268,7 @@ data::unlink(fuse_req_t req, fuse_ino_t ino)
 {
   bool has_data = false;
   shared_data datap;
-  {
-    XrdSysMutexHelper mLock(datamap);
-    has_data = datamap.count(ino);
-
-    if (has_data) {
-      datap = datamap[ino];
-    }
-  }
+  has_data = datamap.retrieveTS(ino, datap);
 
   if (has_data) {
     {
@@ -243,12 +279,13 @@ data::unlink(fuse_req_t req, fuse_ino_t ino)
     }
     // put the unlinked inode in a high bucket, will be removed by the flush thread
     {
-      XrdSysMutexHelper mLock(datamap);
+      dmap::shard_t& s = datamap.shard(ino);
+      XrdSysMutexHelper mLock(s);
 
-      if (datamap.count(ino)) {
-        datamap[ino + 0xffffffff] = datamap[ino];
-        datamap.erase(ino);
-        eos_static_info("datacache::unlink size=%lu", datamap.size());
+      if (s.count(ino)) {
+        s[ino + 0xffffffff] = s[ino];
+        s.erase(ino);
+        eos_static_info("datacache::unlink shard-size=%lu", s.size());
       }
     }
   } else {
@@ -2301,10 +2338,73 @@ data::datax::pwrite(fuse_req_t req, const void* buf, size_t count, off_t offset)
 /* -------------------------------------------------------------------------- */
 ssize_t
 /* -------------------------------------------------------------------------- */
-data::datax::peek_pread(fuse_req_t req, char*& buf, size_t count, off_t offset)
+data::datax::peek_pread(fuse_req_t req, char*& buf, size_t count, off_t offset,
+                        int* fd)
 /* -------------------------------------------------------------------------- */
 {
   mLock.Lock();
+
+  if (fd) {
+    ssize_t splice_bytes = peek_splice_nolock(count, offset);
+
+    if (splice_bytes > 0) {
+      eos_info("offset=%llu count=%lu splice=%ld", offset, count, splice_bytes);
+      *fd = mFile->file()->splice_fd();
+      buf = 0;
+      return splice_bytes;
+    }
+
+    *fd = -1;
+  }
+
+  return peek_pread_nolock(req, buf, count, offset);
+}
+
+/* -------------------------------------------------------------------------- */
+ssize_t
+/* -------------------------------------------------------------------------- */
+data::datax::peek_splice_nolock(size_t count, off_t offset)
+/* -------------------------------------------------------------------------- */
+{
+  if (!mFile->file() || (mFile->file()->splice_fd() < 0)) {
+    return 0;
+  }
+
+  if (inline_buffer && inlined()) {
+    return 0;
+  }
+
+  if (mFile->journal() && (mFile->journal()->get_truncatesize() >= 0)) {
+    // truncations stored in the journal are applied by the regular read
+    return 0;
+  }
+
+  // same rule as for reads from the disk cache: it is used if it holds the
+  // complete range or the complete file
+  off_t cached = mFile->file()->size();
+
+  if (cached > mFile->file()->prefetch_size()) {
+    cached = mFile->file()->prefetch_size();
+  }
+
+  if ((off_t)(offset + count) <= cached) {
+    return count;
+  }
+
+  if (!offset && (cached == (off_t) mMd->size())) {
+    return cached;
+  }
+
+  return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+ssize_t
+/* -------------------------------------------------------------------------- */
+data::datax::peek_pread_nolock(fuse_req_t req, char*& buf, size_t count,
+                               off_t offset)
+/* -------------------------------------------------------------------------- */
+{
   eos_info("offset=%llu count=%lu size=%lu", offset, count, mMd->size());
 
   if (mFile->journal()) {
@@ -2471,10 +2571,17 @@ data::datax::peek_pread(fuse_req_t req, char*& buf, size_t count, off_t offset)
 
       proxy = mFile->has_xrdioro(req) ? mFile->xrdioro(req) : mFile->xrdiorw(
                 req); // recovery might change the proxy object
-      status = proxy->Read(offset + br + jr,
-                           count - br - jr,
-                           (char*) buf + br + jr,
-                           bytesRead);
+
+      if (!br && !jr) {
+        // a read covered by one read-ahead chunk is replied from the chunk
+        status = proxy->ReadDirect(offset, count, (char*) buf, bytesRead,
+                                   mDirectChunk);
+      } else {
+        status = proxy->Read(offset + br + jr,
+                             count - br - jr,
+                             (char*) buf + br + jr,
+                             bytesRead);
+      }
 
       if (!status.IsOK()) {
         // read failed
@@ -2511,6 +2618,18 @@ data::datax::peek_pread(fuse_req_t req, char*& buf, size_t count, off_t offset)
     if (status. IsOK()) {
       std::vector<journalcache::chunk_t> chunks;
 
+      if (mDirectChunk) {
+        char* direct = mDirectChunk->buffer() + (offset - mDirectChunk->offset());
+
+        if (mFile->journal() && mFile->journal()->get_chunks(offset, count).size()) {
+          // the journal is overlaid below, the shared chunk stays untouched
+          memcpy(buf, direct, bytesRead);
+          mDirectChunk.reset();
+        } else {
+          buf = direct;
+        }
+      }
+
       if (mFile->journal()) {
         // retrieve all journal chunks matching our range
         chunks = ((mFile->journal()))->get_chunks(offset + br , count - br);
@@ -2577,8 +2696,15 @@ data::datax::release_pread()
 /* -------------------------------------------------------------------------- */
 {
   eos_info("");
-  sBufferManager.put_buffer(buffer);
-  buffer.reset();
+
+  if (buffer) {
+    // spliced replies don't take a buffer
+    sBufferManager.put_buffer(buffer);
+    buffer.reset();
+  }
+
+  mDirectChunk.reset();
+
   mLock.UnLock();
   return;
 }
@@ -2859,11 +2985,7 @@ data::dmap::waitflush(uint64_t seconds)
   // wait that all pending data is flushed for 'seconds'
   // if all is flushed, it returns true, otherwise false
   for (uint64_t i = 0; i < seconds; ++i) {
-    size_t nattached = 0;
-    {
-      XrdSysMutexHelper mLock(this);
-      nattached = this->size();
-    }
+    size_t nattached = this->sizeTS();
 
     if (nattached) {
       eos_static_warning("[ waiting data to be flushed for %03d io objects] [ %d of %d seconds ]",
@@ -2889,16 +3011,12 @@ data::dmap::ioflush(ThreadAssistant& assistant)
     {
       //eos_static_debug("");
       std::vector<shared_data> data;
-      {
-        // avoid mutex contention
-        XrdSysMutexHelper mLock(this);
-
-        for (auto it = this->begin(); it != this->end(); ++it) {
-          if (it->second) {
-            data.push_back(it->second);
-          }
+      // avoid mutex contention
+      this->for_eachTS([&](const fuse_ino_t & ino, shared_data & io) {
+        if (io) {
+          data.push_back(io);
         }
-      }
+      });
 
       for (auto it = data.begin(); it != data.end(); ++it) {
         XrdSysMutexHelper lLock((*it)->Locker());
@@ -3145,7 +3263,8 @@ data::dmap::ioflush(ThreadAssistant& assistant)
             }
           }
         }
-        XrdSysMutexHelper mLock(this);
+        dmap::shard_t& s = this->shard((*it)->id());
+        XrdSysMutexHelper mLock(s);
         XrdSysMutexHelper lLock((*it)->Locker());
 
         // re-check that nobody is attached
@@ -3155,8 +3274,8 @@ data::dmap::ioflush(ThreadAssistant& assistant)
           // here we make the data object unreachable for new clients
           (*it)->detach_nolock();
           cachehandler::instance().rm((*it)->id());
-          this->erase((*it)->id());
-          this->erase((*it)->id() + 0xffffffff);
+          s.erase((*it)->id());
+          s.erase((*it)->id() + 0xffffffff);
         }
       }
 
@@ -35,6 +35,7 @@
 #include "common/AssistedThread.hh"
 #include "common/FileId.hh"
 #include "bufferll.hh"
+#include "misc/ShardedMap.hh"
 #include "llfusexx.hh"
 #include "fusex/fusex.pb.h"
 #include "common/Logging.hh"
@@ -139,7 +140,10 @@ public:
     // IO bridge interface
     ssize_t pread(fuse_req_t req, void* buf, size_t count, off_t offset);
     ssize_t pwrite(fuse_req_t req, const void* buf, size_t count, off_t offset);
-    ssize_t peek_pread(fuse_req_t req, char*& buf, size_t count, off_t offset);
+    // with 'fd' given, a range held completely by the disk cache is not read:
+    // *fd is set to the disk cache file to splice the reply from and buf is 0
+    ssize_t peek_pread(fuse_req_t req, char*& buf, size_t count, off_t offset,
+                       int* fd = 0);
     void release_pread();
     int truncate(fuse_req_t req, off_t offset);
     int sync();
@@ -258,6 +262,12 @@ public:
     const char* Dump(std::string& out);
 
   private:
+    ssize_t peek_pread_nolock(fuse_req_t req, char*& buf, size_t count,
+                              off_t offset);
+    // number of bytes of the range which can be spliced from the disk cache,
+    // 0 if it has to be read
+    ssize_t peek_splice_nolock(size_t count, off_t offset);
+
     XrdSysMutex mLock;
     uint64_t mIno;
     fuse_req_t mReq;
@@ -273,6 +283,8 @@ public:
     std::deque<std::string> mRecoveryStack;
 
     bufferllmanager::shared_buffer buffer;
+    // read-ahead chunk a remote read is replied from, kept until release_pread
+    XrdCl::Proxy::read_handler mDirectChunk;
     bool mSimulateWriteErrorInFlush;
     bool mSimulateWriteErrorInFlusher;
     int mFlags;
@@ -371,8 +383,15 @@ public:
   } data_fh;
 
   //----------------------------------------------------------------------------
+  // unlinked files are moved to ino + 0xffffffff, keep both in the same shard
+  struct dmap_hash {
+    size_t operator()(fuse_ino_t ino) const
+    {
+      return std::hash<fuse_ino_t>()(ino % 0xffffffff);
+    }
+  };
 
-  class dmap : public std::map<fuse_ino_t, shared_data>, public XrdSysMutex
+  class dmap : public ShardedMap<fuse_ino_t, shared_data, dmap_hash>
   //----------------------------------------------------------------------------
   {
   public:
@@ -410,6 +429,10 @@ public:
   bool has(fuse_ino_t ino, bool checkwriteopen = false);
   metad::shared_md retrieve_wr_md(fuse_ino_t ino);
 
+  // inodes of the files open for writing which are covered by the cap of ino,
+  // i.e. the file itself or the files in directory ino
+  std::vector<fuse_ino_t> writers(fuse_ino_t ino);
+
   void release(fuse_req_t req,
                fuse_ino_t ino);
 
@@ -424,8 +447,7 @@ public:
 
   size_t size()
   {
-    XrdSysMutexHelper mLock(datamap);
-    return datamap.size();
+    return datamap.sizeTS();
   }
 
   void set_xoff()
@@ -70,6 +70,11 @@ public:
     return sMaxSize;
   }
 
+  virtual int splice_fd() override
+  {
+    return (fd > 0) ? fd : -1;
+  }
+
 private:
   XrdSysMutex mMutex;
   int location(std::string& path, bool mkpath = true);
@@ -0,0 +1,240 @@
+//------------------------------------------------------------------------------
+//! @file rastreams.cc
+//! @brief detection of sequential and strided read streams for read-ahead
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2021 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "data/rastreams.hh"
+#include <sstream>
+
+/* -------------------------------------------------------------------------- */
+rastreams::rastreams() : mSeq(0), mLatency(0)
+/* -------------------------------------------------------------------------- */
+{
+  mStreams.reserve(kMaxStreams);
+}
+
+/* -------------------------------------------------------------------------- */
+rastreams::stream_t&
+/* -------------------------------------------------------------------------- */
+rastreams::add(off_t offset, uint32_t size, uint64_t now)
+/* -------------------------------------------------------------------------- */
+{
+  mSeq++;
+  stream_t* match = 0;
+
+  // continue the pattern of a stream
+  for (auto it = mStreams.begin(); it != mStreams.end(); ++it) {
+    if (offset == (off_t)(it->offset + it->size)) {
+      it->hits = (it->pattern == SEQUENTIAL) ? it->hits + 1 : 1;
+      it->pattern = SEQUENTIAL;
+      match = &(*it);
+      break;
+    }
+
+    if ((it->pattern == STRIDED) && (offset - it->offset == it->stride)) {
+      it->hits++;
+      match = &(*it);
+      break;
+    }
+  }
+
+  if (!match) {
+    // turn the closest young stream into a strided one
+    for (auto it = mStreams.begin(); it != mStreams.end(); ++it) {
+      if (it->active() || (offset <= it->offset) ||
+          (offset - it->offset > kMaxStride)) {
+        continue;
+      }
+
+      if (!match || (it->offset > match->offset)) {
+        match = &(*it);
+      }
+    }
+
+    if (match) {
+      match->pattern = STRIDED;
+      match->stride = offset - match->offset;
+      match->hits = 1;
+    }
+  }
+
+  if (!match) {
+    // start a new stream
+    if (mStreams.size() < kMaxStreams) {
+      mStreams.resize(mStreams.size() + 1);
+      match = &mStreams.back();
+    } else {
+      match = &mStreams.front();
+
+      for (auto it = mStreams.begin(); it != mStreams.end(); ++it) {
+        if (it->used < match->used) {
+          match = &(*it);
+        }
+      }
+    }
+
+    match->pattern = UNKNOWN;
+    match->stride = 0;
+    match->hits = 0;
+    match->position = 0;
+    match->rate = 0;
+  } else {
+    // measure the read rate of the stream
+    uint64_t dt = (now > match->time) ? (now - match->time) : 1;
+    double rate = 1.0 * size / dt;
+    match->rate = match->rate ? (0.75 * match->rate + 0.25 * rate) : rate;
+  }
+
+  match->offset = offset;
+  match->size = size;
+  match->time = now;
+  match->used = mSeq;
+
+  // restart prefetching after a pattern change
+  if (match->hits == 1) {
+    match->position = 0;
+  }
+
+  return *match;
+}
+
+/* -------------------------------------------------------------------------- */
+void
+/* -------------------------------------------------------------------------- */
+rastreams::add_latency(uint64_t us)
+/* -------------------------------------------------------------------------- */
+{
+  mLatency = mLatency ? (0.875 * mLatency + 0.125 * us) : us;
+}
+
+/* -------------------------------------------------------------------------- */
+size_t
+/* -------------------------------------------------------------------------- */
+rastreams::window(const stream_t& s, size_t min, size_t max) const
+/* -------------------------------------------------------------------------- */
+{
+  size_t w = (size_t)(2 * s.rate * mLatency);
+
+  if (w < min) {
+    w = min;
+  }
+
+  if (w > max) {
+    w = max;
+  }
+
+  return w;
+}
+
+/* -------------------------------------------------------------------------- */
+std::vector<rastreams::request_t>
+/* -------------------------------------------------------------------------- */
+rastreams::plan(stream_t& s, size_t window, uint32_t block,
+                size_t max_requests, off_t max_position)
+/* -------------------------------------------------------------------------- */
+{
+  std::vector<request_t> requests;
+
+  if (!s.active()) {
+    return requests;
+  }
+
+  if (s.pattern == SEQUENTIAL) {
+    off_t end = s.offset + s.size;
+
+    if (s.position < end) {
+      s.position = end;
+    }
+
+    while ((requests.size() < max_requests) &&
+           ((size_t)(s.position - end) < window) &&
+           (s.position < max_position) && block) {
+      off_t len = block;
+
+      if (s.position + len > max_position) {
+        len = max_position - s.position;
+      }
+
+      requests.push_back(request_t{s.position, (uint32_t) len});
+      s.position += len;
+    }
+  }
+
+  if (s.pattern == STRIDED) {
+    if (s.position < s.offset + s.stride) {
+      s.position = s.offset + s.stride;
+    }
+
+    while ((requests.size() < max_requests) &&
+           ((size_t)((s.position - s.offset) / s.stride - 1) * s.size < window) &&
+           (s.position < max_position) && s.size) {
+      off_t len = s.size;
+
+      if (s.position + len > max_position) {
+        len = max_position - s.position;
+      }
+
+      requests.push_back(request_t{s.position, (uint32_t) len});
+      s.position += s.stride;
+    }
+  }
+
+  return requests;
+}
+
+/* -------------------------------------------------------------------------- */
+bool
+/* -------------------------------------------------------------------------- */
+rastreams::wanted(off_t offset, size_t size) const
+/* -------------------------------------------------------------------------- */
+{
+  for (auto it = mStreams.begin(); it != mStreams.end(); ++it) {
+    if ((off_t)(offset + size) <= it->offset) {
+      continue;
+    }
+
+    if ((offset < it->position) || (offset <= (off_t)(it->offset + it->size))) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+/* -------------------------------------------------------------------------- */
+std::string
+/* -------------------------------------------------------------------------- */
+rastreams::dump() const
+/* -------------------------------------------------------------------------- */
+{
+  std::stringstream ss;
+  ss << "latency=" << (uint64_t) mLatency << "us";
+
+  for (auto it = mStreams.begin(); it != mStreams.end(); ++it) {
+    ss << " [" << (it->pattern == SEQUENTIAL ? "seq" :
+                   it->pattern == STRIDED ? "stride" : "-")
+       << " off=" << it->offset << " size=" << it->size
+       << " stride=" << it->stride << " hits=" << it->hits
+       << " pos=" << it->position << " rate=" << it->rate << "]";
+  }
+
+  return ss.str();
+}
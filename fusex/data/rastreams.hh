@@ -0,0 +1,151 @@
+//------------------------------------------------------------------------------
+//! @file rastreams.hh
+//! @brief detection of sequential and strided read streams for read-ahead
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2021 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#ifndef FUSE_RASTREAMS_HH_
+#define FUSE_RASTREAMS_HH_
+
+#include <sys/types.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+//------------------------------------------------------------------------------
+//! Tracks the read streams of an open file for the adaptive read-ahead.
+//!
+//! Every read is assigned to a stream: it continues a sequential stream if it
+//! starts where the last read of the stream ended, a strided stream if it is
+//! one stride after it. Otherwise it turns a young stream into a strided one
+//! or starts a new stream, replacing the least recently used one. A stream is
+//! prefetched once three reads in a row followed its pattern.
+//!
+//! The prefetch window of a stream is what it reads during two fetch
+//! latencies, i.e. its bandwidth-delay product with a safety factor, measured
+//! from the read rate of the application and the latency of the prefetches.
+//!
+//! Not thread-safe, the owner has to serialize the calls.
+//------------------------------------------------------------------------------
+class rastreams
+{
+public:
+
+  static constexpr size_t kMaxStreams = 8;
+  // reads further apart don't form a strided stream
+  static constexpr off_t kMaxStride = 64 * 1024 * 1024;
+
+  enum pattern_t {
+    UNKNOWN = 0,
+    SEQUENTIAL = 1,
+    STRIDED = 2
+  };
+
+  typedef struct stream {
+    pattern_t pattern;
+    off_t offset; // offset of the last read
+    uint32_t size; // size of the last read
+    off_t stride; // distance between the reads of a strided stream
+    size_t hits; // reads in a row following the pattern
+    off_t position; // where prefetching continues
+    uint64_t time; // time of the last read in us
+    double rate; // read rate of the application in bytes/us
+    uint64_t used; // sequence number of the last read
+
+    bool active() const
+    {
+      return hits >= 2;
+    }
+  } stream_t;
+
+  typedef struct request {
+    off_t offset;
+    uint32_t size;
+  } request_t;
+
+  rastreams();
+
+  virtual ~rastreams() { }
+
+  //----------------------------------------------------------------------------
+  //! Account a read at time now (in us)
+  //!
+  //! @return the stream the read belongs to
+  //----------------------------------------------------------------------------
+  stream_t& add(off_t offset, uint32_t size, uint64_t now);
+
+  //----------------------------------------------------------------------------
+  //! Account the latency of a prefetch in us
+  //----------------------------------------------------------------------------
+  void add_latency(uint64_t us);
+
+  //----------------------------------------------------------------------------
+  //! Prefetch window of a stream in bytes, within [min, max]
+  //----------------------------------------------------------------------------
+  size_t window(const stream_t& s, size_t min, size_t max) const;
+
+  //----------------------------------------------------------------------------
+  //! Prefetch requests to have window bytes of the stream ahead of its last
+  //! read. Sequential streams are fetched in blocks, strided ones element by
+  //! element. Only data below max_position is requested.
+  //!
+  //! @return at most max_requests requests, the prefetch position of the
+  //!         stream is moved behind them
+  //----------------------------------------------------------------------------
+  std::vector<request_t> plan(stream_t& s, size_t window, uint32_t block,
+                              size_t max_requests, off_t max_position);
+
+  //----------------------------------------------------------------------------
+  //! Move the prefetch position of a stream back to a request which could
+  //! not be issued
+  //----------------------------------------------------------------------------
+  void rewind(stream_t& s, off_t position)
+  {
+    if (position < s.position) {
+      s.position = position;
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  //! Check if a prefetched chunk is still ahead of a stream: it is not behind
+  //! the last read of the stream and within its prefetch window or holding
+  //! the data following the last read
+  //----------------------------------------------------------------------------
+  bool wanted(off_t offset, size_t size) const;
+
+  uint64_t latency() const
+  {
+    return (uint64_t) mLatency;
+  }
+
+  const std::vector<stream_t>& streams() const
+  {
+    return mStreams;
+  }
+
+  std::string dump() const;
+
+private:
+  std::vector<stream_t> mStreams;
+  uint64_t mSeq;
+  double mLatency; // prefetch latency in us
+};
+
+#endif
@@ -26,6 +26,8 @@
 #include "common/Logging.hh"
 #include "common/Path.hh"
 #include "XrdCl/XrdClXRootDResponses.hh"
+#include "XProtocol/XProtocol.hh"
+#include <algorithm>
 
 using namespace XrdCl;
 
@@ -67,6 +69,35 @@ XrdCl::Proxy::Read(uint64_t offset,
                    uint32_t& bytesRead,
                    uint16_t timeout)
 /* -------------------------------------------------------------------------- */
+{
+  return ReadInternal(offset, size, buffer, bytesRead, 0, timeout);
+}
+
+/* -------------------------------------------------------------------------- */
+XRootDStatus
+/* -------------------------------------------------------------------------- */
+XrdCl::Proxy::ReadDirect(uint64_t offset,
+                         uint32_t size,
+                         void* buffer,
+                         uint32_t& bytesRead,
+                         read_handler& direct,
+                         uint16_t timeout)
+/* -------------------------------------------------------------------------- */
+{
+  direct.reset();
+  return ReadInternal(offset, size, buffer, bytesRead, &direct, timeout);
+}
+
+/* -------------------------------------------------------------------------- */
+XRootDStatus
+/* -------------------------------------------------------------------------- */
+XrdCl::Proxy::ReadInternal(uint64_t offset,
+                           uint32_t size,
+                           void* buffer,
+                           uint32_t& bytesRead,
+                           read_handler* direct,
+                           uint16_t timeout)
+/* -------------------------------------------------------------------------- */
 {
   eos_debug("offset=%lu size=%u", offset, size);
   XRootDStatus status = WaitOpen();
@@ -85,7 +116,10 @@ XrdCl::Proxy::Read(uint64_t offset,
   std::set<uint64_t> delete_chunk;
   void* pbuffer = buffer;
 
-  if (XReadAheadStrategy != NONE) {
+  if (XReadAheadStrategy == ADAPTIVE) {
+    ReadAheadAdaptive(offset, size, current_offset, current_size, buffer,
+                      bytesRead, direct, timeout);
+  } else if (XReadAheadStrategy != NONE) {
     ReadCondVar().Lock();
     XReadAheadBlocksIs = 0;
 
@@ -129,9 +163,15 @@ XrdCl::Proxy::Read(uint64_t offset,
                         it->second->vbuffer().size());
             }
 
-            // just copy what we have
-            memcpy(buffer, it->second->buffer() + match_offset - it->second->offset(),
-                   match_size);
+            if (direct && !bytesRead && (match_size == size)) {
+              // the caller replies from the chunk itself
+              *direct = it->second;
+            } else {
+              // just copy what we have
+              memcpy(buffer, it->second->buffer() + match_offset - it->second->offset(),
+                     match_size);
+            }
+
             bytesRead += match_size;
             mTotalReadAheadHitBytes += match_size;
             buffer = (char*) buffer + match_size;
@@ -337,6 +377,189 @@ XrdCl::Proxy::Read(uint64_t offset,
   return status;
 }
 
+/* -------------------------------------------------------------------------- */
+void
+/* -------------------------------------------------------------------------- */
+XrdCl::Proxy::ReadAheadAdaptive(uint64_t offset,
+                                uint32_t size,
+                                uint64_t& current_offset,
+                                uint32_t& current_size,
+                                void*& buffer,
+                                uint32_t& bytesRead,
+                                read_handler* direct,
+                                uint16_t timeout)
+/* -------------------------------------------------------------------------- */
+{
+  std::set<uint64_t> delete_chunk;
+  chunk_rvector prefetch;
+  XrdSysCondVarHelper lLock(ReadCondVar());
+
+  // copy what is covered by prefetched chunks, chunk after chunk
+  while (current_size && ChunkRMap().size()) {
+    auto it = ChunkRMap().upper_bound(current_offset);
+
+    if (it == ChunkRMap().begin()) {
+      break;
+    }
+
+    --it;
+    read_handler chunk = it->second;
+    off_t match_offset;
+    uint32_t match_size;
+    XrdSysCondVarHelper llLock(chunk->ReadCondVar());
+
+    if (!chunk->matches(current_offset, current_size, match_offset, match_size)) {
+      break;
+    }
+
+    while (!chunk->done()) {
+      chunk->ReadCondVar().WaitMS(25);
+    }
+
+    // the match result can change after the read actually returned
+    if (!chunk->Status().IsOK() ||
+        !chunk->matches(current_offset, current_size, match_offset, match_size)) {
+      break;
+    }
+
+    if (match_offset == chunk->offset()) {
+      // account the latency once per chunk
+      mReadAhead.add_latency(chunk->latency());
+    }
+
+    if (direct && !bytesRead && (match_size == size)) {
+      // the caller replies from the chunk itself
+      *direct = chunk;
+    } else {
+      memcpy(buffer, chunk->buffer() + match_offset - chunk->offset(), match_size);
+    }
+
+    bytesRead += match_size;
+    mTotalReadAheadHitBytes += match_size;
+    buffer = (char*) buffer + match_size;
+    current_offset = match_offset + match_size;
+    current_size -= match_size;
+  }
+
+  uint64_t now = std::chrono::duration_cast<std::chrono::microseconds>
+                 (std::chrono::steady_clock::now().time_since_epoch()).count();
+  rastreams::stream_t& stream = mReadAhead.add(offset, size, now);
+
+  // drop the chunks which no stream is going to read
+  for (auto it = ChunkRMap().begin(); it != ChunkRMap().end(); ++it) {
+    XrdSysCondVarHelper llLock(it->second->ReadCondVar());
+
+    if (it->second->done() && (!it->second->valid() ||
+                               !mReadAhead.wanted(it->second->offset(), it->second->size()))) {
+      delete_chunk.insert(it->first);
+    }
+  }
+
+  for (auto it = delete_chunk.begin(); it != delete_chunk.end(); ++it) {
+    ChunkRMap().erase(*it);
+  }
+
+  rastreams::pattern_t pattern = stream.pattern;
+
+  // a vector read element has to fit into a read-ahead buffer
+  if (stream.active() && !((pattern == rastreams::STRIDED) &&
+                           (stream.size > XReadAheadMax))) {
+    // the window covers the bandwidth-delay product of the stream
+    size_t window = mReadAhead.window(stream, XReadAheadNom,
+                                      XReadAheadMax * XReadAheadBlocksMax);
+    uint32_t block = 0;
+    size_t max_requests = 64; // elements per vector read
+
+    if (pattern == rastreams::SEQUENTIAL) {
+      block = std::min(std::max(window / 4, XReadAheadNom), XReadAheadMax);
+      max_requests = XReadAheadBlocksMax;
+      // continue behind a chunk already covering the stream e.g. the open
+      // prefetch
+      off_t next = std::max(stream.position, (off_t)(stream.offset + stream.size));
+      auto it = ChunkRMap().upper_bound(next);
+
+      if (it != ChunkRMap().begin()) {
+        --it;
+        XrdSysCondVarHelper llLock(it->second->ReadCondVar());
+
+        if (it->second->valid() &&
+            ((off_t)(it->second->offset() + it->second->size()) > next)) {
+          stream.position = it->second->offset() + it->second->size();
+        }
+      }
+    }
+
+    std::vector<rastreams::request_t> requests = mReadAhead.plan(stream, window,
+        block, max_requests, get_readahead_maximum_position());
+
+    for (auto it = requests.begin(); it != requests.end(); ++it) {
+      if (ChunkRMap().count(it->offset)) {
+        continue;
+      }
+
+      read_handler chunk = std::make_shared<ReadAsyncHandler>(this, it->offset,
+                           it->size, false);
+
+      if (!chunk->valid()) {
+        // no buffer available, continue with the next read
+        mReadAhead.rewind(stream, it->offset);
+        break;
+      }
+
+      ChunkRMap()[(uint64_t) it->offset] = chunk;
+      inc_read_chunks_in_flight();
+      mTotalReadAheadBytes += it->size;
+      prefetch.push_back(chunk);
+    }
+
+    if (EOS_LOGS_DEBUG) {
+      eos_debug("----: adaptive window=%lu prefetch=%lu chunks=%lu %s", window,
+                prefetch.size(), ChunkRMap().size(), mReadAhead.dump().c_str());
+    }
+
+    ReadCondVar().Signal();
+  }
+
+  lLock.UnLock();
+
+  if (prefetch.empty()) {
+    return;
+  }
+
+  // the server rejects vector read elements above maxRVdsz, larger strides
+  // are prefetched with single reads
+  bool vector_read = (pattern == rastreams::STRIDED) && (prefetch.size() > 1);
+
+  for (auto it = prefetch.begin(); vector_read && (it != prefetch.end()); ++it) {
+    if ((*it)->size() > (size_t) XrdProto::maxRVdsz) {
+      vector_read = false;
+    }
+  }
+
+  if (vector_read) {
+    PreReadVAsync(prefetch, timeout);
+    return;
+  }
+
+  XRootDStatus status = WaitOpen();
+
+  for (auto it = prefetch.begin(); it != prefetch.end(); ++it) {
+    XRootDStatus rstatus = status;
+
+    if (rstatus.IsOK()) {
+      rstatus = File::Read(static_cast<uint64_t>((*it)->offset()),
+                           static_cast<uint32_t>((*it)->size()),
+                           (void*)(*it)->buffer(), it->get(), timeout);
+    }
+
+    if (!rstatus.IsOK()) {
+      // complete the chunk with the error, a reader waiting for it falls
+      // back to a synchronous read and the next read drops it
+      (*it)->HandleResponse(new XRootDStatus(rstatus), 0);
+    }
+  }
+}
+
 /* -------------------------------------------------------------------------- */
 XRootDStatus
 /* -------------------------------------------------------------------------- */
@@ -1131,6 +1354,8 @@ XrdCl::Proxy::ReadAsyncHandler::HandleResponse(XrdCl::XRootDStatus* status,
       release_buffer();
     }
 
+    mLatency = std::chrono::duration_cast<std::chrono::microseconds>
+               (std::chrono::steady_clock::now() - mStart).count();
     mDone = true;
     delete status;
     mProxy->dec_read_chunks_in_flight();
@@ -1213,6 +1438,75 @@ XrdCl::Proxy::PreReadAsync(uint64_t offset,
   return rstatus;
 }
 
+/* -------------------------------------------------------------------------- */
+XRootDStatus
+/* -------------------------------------------------------------------------- */
+XrdCl::Proxy::PreReadVAsync(chunk_rvector& chunks,
+                            uint16_t timeout)
+/* -------------------------------------------------------------------------- */
+{
+  eos_debug("chunks=%lu", chunks.size());
+  XRootDStatus status = WaitOpen();
+
+  if (status.IsOK()) {
+    // the data goes directly into the chunk buffers
+    XrdCl::ChunkList vchunks;
+
+    for (auto it = chunks.begin(); it != chunks.end(); ++it) {
+      vchunks.push_back(XrdCl::ChunkInfo((*it)->offset(), (*it)->size(),
+                                         (*it)->buffer()));
+    }
+
+    ReadVAsyncHandler* handler = new ReadVAsyncHandler(chunks);
+    status = File::VectorRead(vchunks, 0, handler, timeout);
+
+    if (status.IsOK()) {
+      return status;
+    }
+
+    delete handler;
+  }
+
+  // complete the chunks with the error, they are registered in the
+  // read-ahead map already and readers might wait for them
+  for (auto it = chunks.begin(); it != chunks.end(); ++it) {
+    (*it)->HandleResponse(new XRootDStatus(status), 0);
+  }
+
+  return status;
+}
+
+/* -------------------------------------------------------------------------- */
+void
+/* -------------------------------------------------------------------------- */
+XrdCl::Proxy::ReadVAsyncHandler::HandleResponse(XrdCl::XRootDStatus* status,
+    XrdCl::AnyObject* response)
+/* -------------------------------------------------------------------------- */
+{
+  eos_static_debug("chunks=%lu", mChunks.size());
+  XrdCl::VectorReadInfo* vinfo = 0;
+
+  if (status->IsOK() && response) {
+    response->Get(vinfo);
+  }
+
+  // hand every chunk its own status and response, as for a single read
+  for (size_t i = 0; i < mChunks.size(); ++i) {
+    XrdCl::AnyObject* chunk_response = 0;
+
+    if (vinfo && (i < vinfo->GetChunks().size())) {
+      chunk_response = new XrdCl::AnyObject();
+      chunk_response->Set(new XrdCl::ChunkInfo(vinfo->GetChunks()[i]));
+    }
+
+    mChunks[i]->HandleResponse(new XrdCl::XRootDStatus(*status), chunk_response);
+  }
+
+  delete response;
+  delete status;
+  delete this;
+}
+
 /* -------------------------------------------------------------------------- */
 XRootDStatus
 /* -------------------------------------------------------------------------- */
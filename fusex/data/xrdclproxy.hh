@@ -32,6 +32,7 @@
 #include "llfusexx.hh"
 #include "common/Logging.hh"
 #include "common/Timing.hh"
+#include "data/rastreams.hh"
 #include <memory>
 #include <map>
 #include <string>
@@ -39,6 +40,7 @@
 #include <queue>
 #include <thread>
 #include <atomic>
+#include <chrono>
 #include <mutex>
 
 namespace XrdCl
@@ -552,7 +554,8 @@ public:
   enum READAHEAD_STRATEGY {
     NONE = 0,
     STATIC = 1,
-    DYNAMIC = 2
+    DYNAMIC = 2,
+    ADAPTIVE = 3
   };
 
   void set_readahead_maximum_position(off_t offset)
@@ -576,6 +579,10 @@ public:
       return STATIC;
     }
 
+    if (strategy == "adaptive") {
+      return ADAPTIVE;
+    }
+
     return NONE;
   }
 
@@ -906,9 +913,9 @@ public:
   {
   public:
 
-    ReadAsyncHandler() : mAsyncCond(0) { }
+    ReadAsyncHandler() : mAsyncCond(0), mLatency(0) { }
 
-    ReadAsyncHandler(ReadAsyncHandler* other) : mAsyncCond(0)
+    ReadAsyncHandler(ReadAsyncHandler* other) : mAsyncCond(0), mLatency(0)
     {
       mProxy = other->proxy();
 
@@ -923,8 +930,9 @@ public:
 
     ReadAsyncHandler(Proxy* file, off_t off, uint32_t size,
                      bool blocking = true) : mProxy(file),
-      mAsyncCond(0)
+      mAsyncCond(0), mLatency(0)
     {
+      mStart = std::chrono::steady_clock::now();
       mBuffer = sRaBufferManager.get_buffer(size, blocking);
 
       if (valid()) {
@@ -1050,6 +1058,12 @@ public:
       mProxy = 0;
     }
 
+    // time from the creation of the chunk to its response in us
+    uint64_t latency()
+    {
+      return mLatency;
+    }
+
     virtual void HandleResponse(XrdCl::XRootDStatus* pStatus,
                                 XrdCl::AnyObject* pResponse);
 
@@ -1061,6 +1075,8 @@ public:
     off_t roffset;
     XRootDStatus mStatus;
     XrdSysCondVar mAsyncCond;
+    std::chrono::steady_clock::time_point mStart;
+    uint64_t mLatency;
   };
 
 
@@ -1074,6 +1090,37 @@ public:
   typedef std::vector<write_handler> chunk_vector;
   typedef std::vector<read_handler> chunk_rvector;
 
+  // ---------------------------------------------------------------------- //
+
+  class ReadVAsyncHandler : public XrdCl::ResponseHandler
+  // ---------------------------------------------------------------------- //
+  {
+  public:
+
+    // dispatches the response of a vector read to the handlers of its chunks
+    ReadVAsyncHandler(const chunk_rvector& chunks) : mChunks(chunks) { }
+
+    virtual ~ReadVAsyncHandler() { }
+
+    virtual void HandleResponse(XrdCl::XRootDStatus* pStatus,
+                                XrdCl::AnyObject* pResponse);
+
+  private:
+    chunk_rvector mChunks;
+  };
+
+  // ---------------------------------------------------------------------- //
+  // like Read, but if a single prefetched chunk holds the complete range
+  // nothing is copied into buffer: the chunk is returned in direct and the
+  // data starts at direct->buffer() + offset - direct->offset()
+  // ---------------------------------------------------------------------- //
+  XRootDStatus ReadDirect(uint64_t offset,
+                          uint32_t size,
+                          void* buffer,
+                          uint32_t& bytesRead,
+                          read_handler& direct,
+                          uint16_t timeout = 0);
+
   // ---------------------------------------------------------------------- //
   write_handler WriteAsyncPrepare(uint32_t size, uint64_t offset = 0,
                                   uint16_t timeout = 0);
@@ -1126,6 +1173,10 @@ public:
                             read_handler handler,
                             uint16_t timeout);
 
+  // ---------------------------------------------------------------------- //
+  XRootDStatus PreReadVAsync(chunk_rvector& chunks,
+                             uint16_t timeout);
+
   // ---------------------------------------------------------------------- //
   XRootDStatus WaitRead(read_handler handler);
 
@@ -1318,6 +1369,30 @@ public:
   }
 
 private:
+  // ---------------------------------------------------------------------- //
+  // implementation of Read and ReadDirect, direct is 0 for Read
+  // ---------------------------------------------------------------------- //
+  XRootDStatus ReadInternal(uint64_t offset,
+                            uint32_t size,
+                            void* buffer,
+                            uint32_t& bytesRead,
+                            read_handler* direct,
+                            uint16_t timeout);
+
+  // ---------------------------------------------------------------------- //
+  // adaptive read-ahead: serve the read from prefetched chunks, moving
+  // current_offset, current_size and buffer behind the served data, and
+  // prefetch ahead of the read stream the read belongs to
+  // ---------------------------------------------------------------------- //
+  void ReadAheadAdaptive(uint64_t offset,
+                         uint32_t size,
+                         uint64_t& current_offset,
+                         uint32_t& current_size,
+                         void*& buffer,
+                         uint32_t& bytesRead,
+                         read_handler* direct,
+                         uint16_t timeout);
+
   OPEN_STATE open_state;
   struct timespec open_state_time;
   XRootDStatus XOpenState;
@@ -1361,6 +1436,7 @@ private:
   off_t mTotalReadAheadHitBytes;
   off_t mTotalReadAheadBytes;
   off_t mReadAheadMaximumPosition;
+  rastreams mReadAhead; // streams of the adaptive read-ahead
 
   XrdSysMutex mAttachedMutex;
   size_t mAttached;
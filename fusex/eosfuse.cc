@@ -612,6 +612,14 @@ EosFuse::run(int argc, char* argv[], void* userdata)
         root["options"]["hide-versions"] = 1;
       }
 
+      if (!root["options"].isMember("readdirplus")) {
+        root["options"]["readdirplus"] = 1;
+      }
+
+      if (!root["options"].isMember("writeback-cache")) {
+        root["options"]["writeback-cache"] = 0;
+      }
+
       if (!root["auth"].isMember("krb5")) {
         root["auth"]["krb5"] = 1;
       }
@@ -870,6 +878,9 @@ EosFuse::run(int argc, char* argv[], void* userdata)
       config.options.hide_versions = root["options"]["hide-versions"].asInt();
       config.options.protect_directory_symlink_loops =
         root["options"]["protect-directory-symlink-loops"].asInt();
+      config.options.readdirplus = root["options"]["readdirplus"].asInt();
+      config.options.writeback_cache =
+        root["options"]["writeback-cache"].asInt();
       config.options.cpu_core_affinity = root["options"]["cpu-core-affinity"].asInt();
       config.options.no_xattr = root["options"]["no-xattr"].asInt();
       config.options.no_eos_xattr_listing =
@@ -1130,9 +1141,10 @@ EosFuse::run(int argc, char* argv[], void* userdata)
 
       if ((cconfig.read_ahead_strategy != "none") &&
           (cconfig.read_ahead_strategy != "static") &&
-          (cconfig.read_ahead_strategy != "dynamic")) {
+          (cconfig.read_ahead_strategy != "dynamic") &&
+          (cconfig.read_ahead_strategy != "adaptive")) {
         fprintf(stderr,
-                "error: invalid read-ahead-strategy specified - only 'none' 'static' 'dynamic' allowed\n");
+                "error: invalid read-ahead-strategy specified - only 'none' 'static' 'dynamic' 'adaptive' allowed\n");
         exit(EINVAL);
       }
 
@@ -1579,6 +1591,7 @@ EosFuse::run(int argc, char* argv[], void* userdata)
       fusestat.Add("lookup", 0, 0, 0);
       fusestat.Add("opendir", 0, 0, 0);
       fusestat.Add("readdir", 0, 0, 0);
+      fusestat.Add("readdirplus", 0, 0, 0);
       fusestat.Add("releasedir", 0, 0, 0);
       fusestat.Add("statfs", 0, 0, 0);
       fusestat.Add("mknod", 0, 0, 0);
@@ -1636,7 +1649,7 @@ EosFuse::run(int argc, char* argv[], void* userdata)
         eos_static_warning("sss-keytabfile         := %s", config.ssskeytab.c_str());
       }
 
-      eos_static_warning("options                := backtrace=%d md-cache:%d md-enoent:%.02f md-timeout:%.02f md-put-timeout:%.02f data-cache:%d rename-sync:%d rmdir-sync:%d flush:%d flush-w-open:%d flush-w-open-sz:%ld flush-w-umount:%d locking:%d no-fsync:%s flush-nowait-exec:%s ol-mode:%03o show-tree-size:%d hide-versions:%d protect-symlink-loops:%d core-affinity:%d no-xattr:%d no-eos-xattr-listing: %d no-link:%d nocache-graceperiod:%d rm-rf-protect-level=%d rm-rf-bulk=%d t(lease)=%d t(size-flush)=%d submounts=%d ino(in-mem)=%d flock:%d",
+      eos_static_warning("options                := backtrace=%d md-cache:%d md-enoent:%.02f md-timeout:%.02f md-put-timeout:%.02f data-cache:%d rename-sync:%d rmdir-sync:%d flush:%d flush-w-open:%d flush-w-open-sz:%ld flush-w-umount:%d locking:%d no-fsync:%s flush-nowait-exec:%s ol-mode:%03o show-tree-size:%d hide-versions:%d protect-symlink-loops:%d core-affinity:%d no-xattr:%d no-eos-xattr-listing: %d no-link:%d nocache-graceperiod:%d rm-rf-protect-level=%d rm-rf-bulk=%d t(lease)=%d t(size-flush)=%d submounts=%d ino(in-mem)=%d flock:%d readdirplus:%d writeback-cache:%d",
                          config.options.enable_backtrace,
                          config.options.md_kernelcache,
                          config.options.md_kernelcache_enoent_timeout,
@@ -1667,7 +1680,9 @@ EosFuse::run(int argc, char* argv[], void* userdata)
                          config.options.write_size_flush_interval,
                          config.options.submounts,
                          config.options.inmemory_inodes,
-                         config.options.flock
+                         config.options.flock,
+                         config.options.readdirplus,
+                         config.options.writeback_cache
                         );
       eos_static_warning("cache                  := rh-type:%s rh-nom:%d rh-max:%d rh-blocks:%d max-rh-buffer=%lu max-wr-buffer=%lu tot-size=%ld tot-ino=%ld jc-size=%ld jc-ino=%ld dc-loc:%s jc-loc:%s clean-thrs:%02f%%%",
                          cconfig.read_ahead_strategy.c_str(),
@@ -1878,6 +1893,39 @@ EosFuse::init(void* userdata, struct fuse_conn_info* conn)
 
   conn->want |= FUSE_CAP_EXPORT_SUPPORT | FUSE_CAP_POSIX_LOCKS |
                 FUSE_CAP_BIG_WRITES;
+#ifdef FUSE_SUPPORTS_SPLICE
+  // reads served from the disk cache are spliced into /dev/fuse, without
+  // kernel support libfuse copies them instead
+  conn->want |= conn->capable & (FUSE_CAP_SPLICE_WRITE | FUSE_CAP_SPLICE_MOVE);
+#endif
+#ifdef _FUSE3
+
+  // libfuse enables readdirplus whenever the operation is implemented, the
+  // kernel then decides per listing if it asks for the attributes
+  if (EosFuse::instance().config.options.readdirplus) {
+    conn->want |= conn->capable & (FUSE_CAP_READDIRPLUS |
+                                   FUSE_CAP_READDIRPLUS_AUTO);
+  } else {
+    conn->want &= ~(FUSE_CAP_READDIRPLUS | FUSE_CAP_READDIRPLUS_AUTO);
+  }
+
+  // small writes are collected in the page cache and sent in large chunks
+  // on writeback, close and fsync - the capability is connection-wide, open
+  // bypasses the page cache for writes to files this client did not create
+  // under its cap and the cap release writes back and drops the cached
+  // pages and attributes, see cap::inval_writers and metad::cleanup
+  if (EosFuse::instance().config.options.writeback_cache) {
+    if (conn->capable & FUSE_CAP_WRITEBACK_CACHE) {
+      conn->want |= FUSE_CAP_WRITEBACK_CACHE;
+    } else {
+      eos_static_warning("writeback-cache not supported by the kernel - disabled");
+      EosFuse::instance().config.options.writeback_cache = 0;
+    }
+  }
+
+#else
+  EosFuse::instance().config.options.writeback_cache = 0;
+#endif
 }
 
 void
@@ -2209,6 +2257,9 @@ EosFuse::setattr(fuse_req_t req, fuse_ino_t ino, struct stat* attr, int op,
                || (op & FUSE_SET_ATTR_MTIME)
                || (op & FUSE_SET_ATTR_ATIME_NOW)
                || (op & FUSE_SET_ATTR_MTIME_NOW)
+#ifdef FUSE_SET_ATTR_CTIME
+               || (op & FUSE_SET_ATTR_CTIME)
+#endif
               ) {
       // retrieve cap for write
       pcap = Instance().caps.acquire(req, cap_ino,
@@ -2354,6 +2405,9 @@ EosFuse::setattr(fuse_req_t req, fuse_ino_t ino, struct stat* attr, int op,
         || (op & FUSE_SET_ATTR_MTIME)
         || (op & FUSE_SET_ATTR_ATIME_NOW)
         || (op & FUSE_SET_ATTR_MTIME_NOW)
+#ifdef FUSE_SET_ATTR_CTIME
+        || (op & FUSE_SET_ATTR_CTIME)
+#endif
       ) {
         /*
         EACCES Search permission is denied for one of the directories in
@@ -2410,6 +2464,17 @@ EosFuse::setattr(fuse_req_t req, fuse_ino_t ino, struct stat* attr, int op,
           }
         }
 
+#ifdef FUSE_SET_ATTR_CTIME
+
+        // with the writeback cache the kernel keeps the times of written files
+        // and sends them along with the data
+        if (op & FUSE_SET_ATTR_CTIME) {
+          md->set_ctime(attr->CTIMESPEC.tv_sec);
+          md->set_ctime_ns(attr->CTIMESPEC.tv_nsec);
+        }
+
+#endif
+
         std::string cookie = md->Cookie();
         Instance().datas.update_cookie(md->id(), cookie);
         EXEC_TIMING_END("setattr:utimes");
@@ -2943,6 +3008,71 @@ EBADF  Invalid directory stream descriptor fi->fh
   EXEC_TIMING_BEGIN(__func__);
   int rc = 0;
   fuse_id id(req);
+  rc = readdir_reply(req, size, off, fi, false);
+  EXEC_TIMING_END(__func__);
+  COMMONTIMING("_stop_", &timing);
+  eos_static_notice("t(ms)=%.03f %s", timing.RealTime(),
+                    dump(id, ino, 0, rc).c_str());
+}
+
+#ifdef _FUSE3
+/* -------------------------------------------------------------------------- */
+void
+/* -------------------------------------------------------------------------- */
+EosFuse::readdirplus(fuse_req_t req, fuse_ino_t ino, size_t size, off_t off,
+                     struct fuse_file_info* fi)
+/* -------------------------------------------------------------------------- */
+/*
+EBADF  Invalid directory stream descriptor fi->fh
+ */
+{
+  eos::common::Timing timing(__func__);
+  COMMONTIMING("_start_", &timing);
+  ADD_FUSE_STAT(__func__, req);
+  EXEC_TIMING_BEGIN(__func__);
+  int rc = 0;
+  fuse_id id(req);
+  rc = readdir_reply(req, size, off, fi, true);
+  EXEC_TIMING_END(__func__);
+  COMMONTIMING("_stop_", &timing);
+  eos_static_notice("t(ms)=%.03f %s", timing.RealTime(),
+                    dump(id, ino, 0, rc).c_str());
+}
+#endif
+
+/* -------------------------------------------------------------------------- */
+static size_t
+/* -------------------------------------------------------------------------- */
+add_direntry(fuse_req_t req, char* buf, size_t bufsize, const char* name,
+             const struct stat* stbuf, off_t off,
+             const struct fuse_entry_param* e)
+/* -------------------------------------------------------------------------- */
+{
+#ifdef _FUSE3
+
+  if (e) {
+    struct fuse_entry_param entry = *e;
+
+    if (!entry.ino) {
+      // the kernel only takes inode and type of an entry without attributes
+      entry.attr = *stbuf;
+    }
+
+    return fuse_add_direntry_plus(req, buf, bufsize, name, &entry, off);
+  }
+
+#endif
+  return fuse_add_direntry(req, buf, bufsize, name, stbuf, off);
+}
+
+/* -------------------------------------------------------------------------- */
+int
+/* -------------------------------------------------------------------------- */
+EosFuse::readdir_reply(fuse_req_t req, size_t size, off_t off,
+                       struct fuse_file_info* fi, bool plus)
+/* -------------------------------------------------------------------------- */
+{
+  int rc = 0;
 
   if (!fi->fh) {
     fuse_reply_err(req, EBADF);
@@ -2957,10 +3087,23 @@ EBADF  Invalid directory stream descriptor fi->fh
     rc = readdir_filler(req, md, pmd_mode, pmd_id);
     // only one readdir at a time
     XrdSysMutexHelper lLock(md->items_lock);
-    eos_static_info("off=%lu size-%lu", off, md->pmd_children.size());
+    eos_static_info("off=%lu size-%lu plus=%d", off, md->pmd_children.size(),
+                    plus);
     fuse_ino_t cino = pmd_id;
     struct stat stbuf;
     memset(&stbuf, 0, sizeof(struct stat));
+    // '.' and '..' never carry attributes, ino=0 tells the kernel to skip them
+    struct fuse_entry_param e;
+    memset(&e, 0, sizeof(e));
+    double lifetime = 0;
+
+    if (plus) {
+      // the attributes handed out are valid as long as the ones from a lookup
+      cap::shared_cap pcap = Instance().caps.acquire(req, cino,
+                             Instance().Config().options.x_ok);
+      lifetime = pcap->lifetime();
+    }
+
     md->b.reset();
     // ---------------------------------------------------------------------- //
     // root directory has only . while all the other have . and ..
@@ -2977,8 +3120,8 @@ EBADF  Invalid directory stream descriptor fi->fh
       mode_t mode = pmd_mode;
       stbuf.st_ino = cino;
       stbuf.st_mode = mode;
-      size_t a_size = fuse_add_direntry(req, md->b.ptr, size - md->b.size,
-                                        bname.c_str(), &stbuf, ++off);
+      size_t a_size = add_direntry(req, md->b.ptr, size - md->b.size,
+                                   bname.c_str(), &stbuf, ++off, plus ? &e : 0);
       eos_static_info("name=%s ino=%08lx mode=%#lx bytes=%u/%u",
                       bname.c_str(), cino, mode, a_size, size - md->b.size);
       md->b.ptr += a_size;
@@ -3006,8 +3149,8 @@ EBADF  Invalid directory stream descriptor fi->fh
         eos_static_debug("list: %#lx %s", cino, bname.c_str());
         stbuf.st_ino = cino;
         stbuf.st_mode = mode;
-        size_t a_size = fuse_add_direntry(req, md->b.ptr, size - md->b.size,
-                                          bname.c_str(), &stbuf, ++off);
+        size_t a_size = add_direntry(req, md->b.ptr, size - md->b.size,
+                                     bname.c_str(), &stbuf, ++off, plus ? &e : 0);
         eos_static_info("name=%s ino=%08lx mode=%#lx bytes=%u/%u",
                         bname.c_str(), cino, mode, a_size, size - md->b.size);
         md->b.ptr += a_size;
@@ -3071,8 +3214,18 @@ EBADF  Invalid directory stream descriptor fi->fh
         }
       }
       stbuf.st_mode = mode;
-      size_t a_size = fuse_add_direntry(req, md->b.ptr, size - md->b.size,
-                                        bname.c_str(), &stbuf, ++off);
+
+      if (plus) {
+        // same attributes as a lookup would return, the hard link target has
+        // been fetched above
+        memset(&e, 0, sizeof(e));
+        XrdSysMutexHelper cLock(cmd->Locker());
+        cmd->set_pid(pmd_id);
+        cmd->convert(e, lifetime);
+      }
+
+      size_t a_size = add_direntry(req, md->b.ptr, size - md->b.size,
+                                   bname.c_str(), &stbuf, ++off, plus ? &e : 0);
 
       if (EOS_LOGS_DEBUG) {
         eos_static_debug("name=%s id=%#lx ino=%#lx mode=%#o bytes=%u/%u ",
@@ -3084,6 +3237,12 @@ EBADF  Invalid directory stream descriptor fi->fh
         break;
       }
 
+      if (plus) {
+        // the kernel accounts an entry which made it into the reply like a
+        // lookup and releases it with a forget
+        cmd->lookup_inc();
+      }
+
       md->b.ptr += a_size;
       md->b.size += a_size;
     }
@@ -3098,10 +3257,7 @@ EBADF  Invalid directory stream descriptor fi->fh
                     size, off, md->b.size);
   }
 
-  EXEC_TIMING_END(__func__);
-  COMMONTIMING("_stop_", &timing);
-  eos_static_notice("t(ms)=%.03f %s", timing.RealTime(),
-                    dump(id, ino, 0, rc).c_str());
+  return rc;
 }
 
 /* -------------------------------------------------------------------------- */
@@ -3962,6 +4118,7 @@ EosFuse::open(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info* fi)
           uint64_t md_ino = md->md_ino();
           uint64_t md_pino = md->md_pino();
           std::string cookie = md->Cookie();
+          bool md_creator = md->creator();
 
           if (md->attr().count("sys.file.cache")) {
             cache_flag |= O_CACHE;
@@ -4008,7 +4165,19 @@ EosFuse::open(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info* fi)
           }
 
           fi->direct_io = 0;
-          eos_static_info("%s data-cache=%d", md->dump(e).c_str(), fi->keep_cache);
+
+          // with the kernel writeback cache only files created by this client
+          // under its write cap are written through the page cache - until
+          // the cap is lost nobody else writes them. Writes to all other
+          // files go straight to us, the kernel can't merge them with remote
+          // changes of size and mtime.
+          if ((mode == U_OK) && Instance().Config().options.writeback_cache &&
+              !md_creator) {
+            fi->direct_io = 1;
+          }
+
+          eos_static_info("%s data-cache=%d direct-io=%d", md->dump(e).c_str(),
+                          fi->keep_cache, fi->direct_io);
         }
       }
     }
@@ -4354,6 +4523,25 @@ EosFuse::read(fuse_req_t req, fuse_ino_t ino, size_t size, off_t off,
 
   if (io) {
     char* buf = 0;
+#ifdef FUSE_SUPPORTS_SPLICE
+    int fd = -1;
+
+    if ((res = io->ioctx()->peek_pread(req, buf, size, off, &fd)) == -1) {
+      rc = errno ? errno : EIO;
+    } else if (fd >= 0) {
+      // the range is in the disk cache, reply straight from the cache file
+      eos_static_debug("reply res=%lu splice fd=%d", res, fd);
+      struct fuse_bufvec bufv = FUSE_BUFVEC_INIT(res);
+      bufv.buf[0].flags = (enum fuse_buf_flags)(FUSE_BUF_IS_FD | FUSE_BUF_FD_SEEK);
+      bufv.buf[0].fd = fd;
+      bufv.buf[0].pos = off;
+      fuse_reply_data(req, &bufv, FUSE_BUF_SPLICE_MOVE);
+    } else {
+      eos_static_debug("reply res=%lu", res);
+      fuse_reply_buf(req, buf, res);
+    }
+
+#else
 
     if ((res = io->ioctx()->peek_pread(req, buf, size, off)) == -1) {
       rc = errno ? errno : EIO;
@@ -4362,6 +4550,8 @@ EosFuse::read(fuse_req_t req, fuse_ino_t ino, size_t size, off_t off,
       fuse_reply_buf(req, buf, res);
     }
 
+#endif
+
     io->ioctx()->release_pread();
   } else {
     rc = ENXIO;
@@ -5227,6 +5417,7 @@ EosFuse::setxattr(fuse_req_t req, fuse_ino_t ino, const char* xattr_name,
       cap::shared_cap pcap = Instance().caps.get(req, ino);
 
       if (pcap->id()) {
+        cap::inval_writers(pcap->id());
         Instance().caps.forget(pcap->capid(req, ino));
       }
     }
@@ -97,6 +97,11 @@ public:
   static void readdir(fuse_req_t req, fuse_ino_t ino, size_t size, off_t off,
                       struct fuse_file_info* fi);
 
+#ifdef _FUSE3
+  static void readdirplus(fuse_req_t req, fuse_ino_t ino, size_t size,
+                          off_t off, struct fuse_file_info* fi);
+#endif
+
   static void releasedir(fuse_req_t req, fuse_ino_t ino,
                          struct fuse_file_info* fi);
 
@@ -275,6 +280,8 @@ public:
       std::vector<std::string> no_fsync_suffixes;
       std::vector<std::string> nowait_flush_executables;
       bool protect_directory_symlink_loops;
+      int readdirplus;
+      int writeback_cache;
     } options_t;
 
     typedef struct recovery
@@ -399,6 +406,11 @@ public:
   static int readdir_filler(fuse_req_t req, opendir_t* md,
                             mode_t&pmd_mode, uint64_t&pmd_id);
 
+  // fill and send the reply of a readdir - with 'plus' every entry added
+  // carries its attributes and counts as a lookup for the kernel
+  static int readdir_reply(fuse_req_t req, size_t size, off_t off,
+                           struct fuse_file_info* fi, bool plus);
+
   void getHbStat(eos::fusex::statistics&);
 
   kv* getKV()
@@ -33,6 +33,11 @@
 #pragma message("FUSE_SUPPORTS_FLOCK")
 #endif
 
+#if ( FUSE_MOUNT_VERSION == 290 ) || defined(_FUSE3)
+#define FUSE_SUPPORTS_SPLICE
+#pragma message("FUSE_SUPPORTS_SPLICE")
+#endif
+
 
 #ifndef FUSE_USE_VERSION
 #ifdef __APPLE__
@@ -129,6 +134,9 @@ protected:
     operations.opendir = &T::opendir;
     operations.access = &T::access;
     operations.readdir = &T::readdir;
+#ifdef _FUSE3
+    operations.readdirplus = &T::readdirplus;
+#endif
     operations.mkdir = &T::mkdir;
     operations.unlink = &T::unlink;
     operations.rmdir = &T::rmdir;
@@ -80,8 +80,11 @@ metad::init(backend* _mdbackend)
   std::string mdstream;
   // load the root node
   fuse_req_t req = 0;
-  XrdSysMutexHelper mLock(mdmap);
-  update(req, mdmap[1], "", true);
+  {
+    pshard& s = mdmap.shard(1);
+    XrdSysMutexHelper mLock(s);
+    update(req, s[1], "", true);
+  }
   mdmap.init(EosFuse::Instance().getKV());
   dentrymessaging = false;
   writesizeflush = false;
@@ -1650,6 +1653,8 @@ metad::cleanup(shared_md md)
   std::vector<std::string> inval_entry_name;
   std::vector<fuse_ino_t> inval_files;
   std::vector<fuse_ino_t> inval_dirs;
+  std::vector<fuse_ino_t> inval_cached;
+  bool writeback = EosFuse::Instance().Config().options.writeback_cache;
 
   for (auto it = md->local_children().begin();
        it != md->local_children().end(); ++it) {
@@ -1665,6 +1670,15 @@ metad::cleanup(shared_md md)
           inval_files.push_back(it->second);
           cmd->force_refresh();
         }
+
+        if (writeback) {
+          // in writeback mode the kernel keeps size and mtime of cached
+          // files, drop pages and attributes and the entry, an unused inode
+          // is then evicted and looked up again with the remote size
+          inval_cached.push_back(it->second);
+          inval_entry_name.push_back(it->first);
+          continue;
+        }
       }
 
       if (!dentrymessaging) {
@@ -1684,7 +1698,11 @@ metad::cleanup(shared_md md)
   md->local_enoent().clear();
   md->Locker().UnLock();
 
-  if (EosFuse::Instance().Config().options.md_kernelcache) {
+  for (auto it = inval_cached.begin(); it != inval_cached.end(); ++it) {
+    kernelcache::inval_inode(*it, true);
+  }
+
+  if (EosFuse::Instance().Config().options.md_kernelcache || writeback) {
     for (auto it = inval_entry_name.begin(); it != inval_entry_name.end(); ++it) {
       kernelcache::inval_entry(md->id(), *it);
     }
@@ -1816,8 +1834,9 @@ metad::apply(fuse_req_t req, eos::fusex::container& cont, bool listing)
     md->Locker().UnLock();
 
     if (is_new) {
-      XrdSysMutexHelper mLock(mdmap);
-      mdmap[ino] = md;
+      pshard& s = mdmap.shard(ino);
+      XrdSysMutexHelper mLock(s);
+      s[ino] = md;
       stat.inodes_inc();
       stat.inodes_ever_inc();
     }
@@ -2331,36 +2350,53 @@ metad::mdstackfree(ThreadAssistant& assistant)
 
     // do this ~every 128 seconds
     if (!(cnt % 256)) {
-      XrdSysMutexHelper mLock(mdmap);
+      // go shard by shard: the parent of an inode lives in another shard,
+      // which can't be looked up while holding the lock of this one
+      for (size_t i = 0; i < pmap::kShards; ++i) {
+        pshard& s = mdmap.shard_at(i);
+        std::vector<std::pair<fuse_ino_t, shared_md>> entries;
+        {
+          XrdSysMutexHelper mLock(s);
 
-      for (auto it = mdmap.begin(); it != mdmap.end();) {
-        if (!it->second) {
-          it++;
-          continue;
+          for (auto it = s.begin(); it != s.end(); ++it) {
+            if (it->second) {
+              entries.push_back(*it);
+            }
+          }
         }
 
-        // if the parent is gone, we can remove the child
-        if ((!mdmap.count(it->second->pid())) &&
-            (!S_ISDIR(it->second->mode()) || it->second->deleted())) {
-          eos_static_debug("removing orphaned inode from mdmap ino=%#lx path=%s",
-                           it->first, it->second->fullpath().c_str());
-          mdmap.lru_remove(it->first);
-          it = mdmap.erase(it);
-          stat.inodes_dec();
-        } else {
-          if (it->second->deleted()) {
-            if ( (!has_flush(it->first)) &&
-		 (!EosFuse::Instance().datas.has(it->first)) ) {
-              eos_static_debug("removing deleted inode from mdmap ino=%#lx path=%s",
-                               it->first, it->second->fullpath().c_str());
-              mdmap.lru_remove(it->first);
-              it = mdmap.erase(it);
-              stat.inodes_dec();
-            } else {
-              it++;
-            }
+        for (auto it = entries.begin(); it != entries.end(); ++it) {
+          bool remove = false;
+
+          // if the parent is gone, we can remove the child
+          if ((!mdmap.countTS(it->second->pid())) &&
+              (!S_ISDIR(it->second->mode()) || it->second->deleted())) {
+            eos_static_debug("removing orphaned inode from mdmap ino=%#lx path=%s",
+                             it->first, it->second->fullpath().c_str());
+            remove = true;
           } else {
-            it++;
+            if (it->second->deleted()) {
+              if ((!has_flush(it->first)) &&
+                  (!EosFuse::Instance().datas.has(it->first))) {
+                eos_static_debug("removing deleted inode from mdmap ino=%#lx path=%s",
+                                 it->first, it->second->fullpath().c_str());
+                remove = true;
+              }
+            }
+          }
+
+          if (!remove) {
+            continue;
+          }
+
+          XrdSysMutexHelper mLock(s);
+          auto sit = s.find(it->first);
+
+          // skip if the inode got replaced in the meanwhile
+          if ((sit != s.end()) && (sit->second == it->second)) {
+            mdmap.lru_remove(s, it->first);
+            s.erase(sit);
+            stat.inodes_dec();
           }
         }
       }
@@ -2369,39 +2405,39 @@ metad::mdstackfree(ThreadAssistant& assistant)
     if (!EosFuse::Instance().Config().mdcachedir.empty()) {
       // level the inodes stored in memory and eventually swap out into kv store
       int swap_out_inodes = 0 ;
-      size_t filled = 0;
-      size_t empty = 0;
-      {
-        XrdSysMutexHelper mLock(mdmap);
-
-        for (auto it = mdmap.begin(); it != mdmap.end(); ++it) {
-          if (it->second) {
-            filled++;
-          } else {
-            empty++;
-          }
-        }
-      }
+      // every shard has its own lru list, the oldest inodes of the shards
+      // are swapped out in turn
+      size_t next_shard = 0;
+      size_t empty_shards = 0;
+      // counting the entries locks every shard, take it once per round:
+      // swapped out inodes stay in the map and move to the stacked count
+      size_t mdmap_size = mdmap.sizeTS();
 
       do {
-        swap_out_inodes = mdmap.sizeTS() - max_inodes -
+        swap_out_inodes = mdmap_size - max_inodes -
                           EosFuse::Instance().mds.stats().inodes_stacked();
 
         if (swap_out_inodes > 0) {
           eos_static_info("swap-out %d inodes", swap_out_inodes);
           // grab the last lru inode and swap out
-          mdmap.Lock();
-          mdmap.lru_dump();
-          uint64_t inode_to_swap = mdmap.lru_oldest();
+          pshard& s = mdmap.shard_at(next_shard++ % pmap::kShards);
+          XrdSysMutexHelper mLock(s);
+          mdmap.lru_dump(s);
+          uint64_t inode_to_swap = mdmap.lru_oldest(s);
 
           if (!inode_to_swap) {
-            // nothing in the lru list anymore
-            mdmap.UnLock();
-            break;
+            // nothing in the lru lists anymore
+            if (++empty_shards >= pmap::kShards) {
+              break;
+            }
+
+            continue;
           }
 
-          if (mdmap.count(inode_to_swap)) {
-            shared_md md = mdmap[inode_to_swap];
+          empty_shards = 0;
+
+          if (s.count(inode_to_swap)) {
+            shared_md md = s[inode_to_swap];
 
             if ((md.use_count() > 2) ||
                 (md && md->LockTable().size())) {
@@ -2410,30 +2446,27 @@ metad::mdstackfree(ThreadAssistant& assistant)
                               md.use_count());
 
               if (md) {
-                mdmap.lru_update(inode_to_swap, md);
+                mdmap.lru_update(s, inode_to_swap, md);
               }
 
-              mdmap.UnLock();
               continue;
             }
 
-            mdmap.lru_remove(inode_to_swap);
+            mdmap.lru_remove(s, inode_to_swap);
 
             if (md) {
               eos_static_info("swap-out lru-removed ino=%#llx oldest=%#llx", inode_to_swap,
-                              mdmap.lru_oldest());
-	      mdmap.lru_remove(inode_to_swap);
-              mdmap[inode_to_swap] = 0;
+                              mdmap.lru_oldest(s));
+	      mdmap.lru_remove(s, inode_to_swap);
+              s[inode_to_swap] = 0;
 
               if (mdmap.swap_out(md)) {
                 eos_static_err("swap-out failed for ino=%#llx", inode_to_swap);
               }
             }
           } else {
-            mdmap.lru_remove(inode_to_swap);
+            mdmap.lru_remove(s, inode_to_swap);
           }
-
-          mdmap.UnLock();
         }
       } while ((swap_out_inodes > 0) &&
                (!assistant.terminationRequested()));
@@ -2829,12 +2862,25 @@ metad::mdcommunicate(ThreadAssistant& assistant)
 
               if (ino && mdmap.retrieveTS(ino, check_md)) {
                 std::string capid = cap::capx::capid(ino, rsp.lease_().clientid());
+                // first make the kernel write back what it cached for the
+                // files under this cap, then wait that these inodes and the
+                // cap inode are flushed out of the mdqueue and only then
+                // release the cap
+                std::vector<fuse_ino_t> flushing = cap::inval_writers(ino);
+                flushing.push_back(ino);
 
-                // wait that the inode is flushed out of the mdqueue
                 do {
                   mdflush.Lock();
+                  bool queued = false;
 
-                  if (mdqueue.count(ino)) {
+                  for (auto it = flushing.begin(); it != flushing.end(); ++it) {
+                    if (mdqueue.count(*it)) {
+                      queued = true;
+                      break;
+                    }
+                  }
+
+                  if (queued) {
                     mdflush.UnLock();
                     eos_static_info("lease: delaying cap-release remote-ino=%#lx ino=%#lx clientid=%s authid=%s",
                                     md_ino, ino, rsp.lease_().clientid().c_str(), authid.c_str());
@@ -2876,6 +2922,11 @@ metad::mdcommunicate(ThreadAssistant& assistant)
                 // still we want to remove the cap entry
                 std::string capid = cap::capx::capid(ino, rsp.lease_().clientid());
                 eos_static_debug("");
+
+                if (ino) {
+                  cap::inval_writers(ino);
+                }
+
                 EosFuse::Instance().getCap().forget(capid);
               }
             }
@@ -3235,28 +3286,21 @@ metad::vmap::backward(fuse_ino_t lookup)
 }
 
 
-/* -------------------------------------------------------------------------- */
-size_t
-metad::pmap::sizeTS()
-{
-  XrdSysMutexHelper mLock(this);
-  return size();
-}
-
 /* -------------------------------------------------------------------------- */
 bool
 metad::pmap::retrieveOrCreateTS(fuse_ino_t ino, shared_md& ret)
 {
-  XrdSysMutexHelper mLock(this);
+  pshard& s = shard(ino);
+  XrdSysMutexHelper mLock(s);
 
-  if (this->retrieve(ino, ret)) {
+  if (this->retrieve(s, ino, ret)) {
     return false;
   }
 
   ret = std::make_shared<mdx>();
 
   if (ino) {
-    (*this)[ino] = ret;
+    s[ino] = ret;
   }
 
   return true;
@@ -3266,17 +3310,18 @@ metad::pmap::retrieveOrCreateTS(fuse_ino_t ino, shared_md& ret)
 bool
 metad::pmap::retrieveTS(fuse_ino_t ino, shared_md& ret)
 {
-  XrdSysMutexHelper mLock(this);
-  return this->retrieve(ino, ret);
+  pshard& s = shard(ino);
+  XrdSysMutexHelper mLock(s);
+  return this->retrieve(s, ino, ret);
 }
 
 /* -------------------------------------------------------------------------- */
 bool
-metad::pmap::retrieve(fuse_ino_t ino, shared_md& ret)
+metad::pmap::retrieve(pshard& s, fuse_ino_t ino, shared_md& ret)
 {
-  auto it = this->find(ino);
+  auto it = s.find(ino);
 
-  if (it == this->end()) {
+  if (it == s.end()) {
     if (!ret) {
       ret = std::make_shared<mdx>();
       ret->set_err(ENOENT);
@@ -3298,58 +3343,58 @@ metad::pmap::retrieve(fuse_ino_t ino, shared_md& ret)
     }
 
     // attach the new object
-    (*this)[ino] = ret;
+    s[ino] = ret;
     // add to the lru list
-    lru_add(ino, ret);
+    lru_add(s, ino, ret);
   }
 
   // update lru entry whenever we retrieve something
-  lru_update(ino, ret);
+  lru_update(s, ino, ret);
   return true;
 }
 
 /* -------------------------------------------------------------------------- */
 uint64_t
-metad::pmap::lru_oldest() const
+metad::pmap::lru_oldest(const pshard& s) const
 {
-  return lru_last;
+  return s.lru_last;
 }
 
 /* -------------------------------------------------------------------------- */
 void
-metad::pmap::lru_add(fuse_ino_t ino, shared_md md)
+metad::pmap::lru_add(pshard& s, fuse_ino_t ino, shared_md md)
 {
   if (ino == 1) {
     return;
   }
 
-  md->set_lru_prev(lru_first);
+  md->set_lru_prev(s.lru_first);
   md->set_lru_next(0);
 
   // lru list insert with outside lock handling
-  if (this->count(lru_first)) {
-    if ((*this)[lru_first]) {
+  if (s.count(s.lru_first)) {
+    if (s[s.lru_first]) {
       // connect the new inode to the head of the lru list
-      (*this)[lru_first]->set_lru_next(ino);
+      s[s.lru_first]->set_lru_next(ino);
     } else {
       // points to swapped-out entry
-      lru_last = ino;
+      s.lru_last = ino;
     }
   }
 
-  lru_first = ino;
+  s.lru_first = ino;
 
-  if (!lru_last) {
-    lru_last = ino;
+  if (!s.lru_last) {
+    s.lru_last = ino;
   }
 
   eos_static_info("ino=%#llx first=%#llx last=%#llx prev=%llx next=%#llx", ino,
-                  lru_first, lru_last, md->lru_prev(), md->lru_next());
+                  s.lru_first, s.lru_last, md->lru_prev(), md->lru_next());
 }
 
 /* -------------------------------------------------------------------------- */
 void
-metad::pmap::lru_remove(fuse_ino_t ino)
+metad::pmap::lru_remove(pshard& s, fuse_ino_t ino)
 {
   if (ino == 1) {
     return;
@@ -3360,101 +3405,101 @@ metad::pmap::lru_remove(fuse_ino_t ino)
 
   if (EOS_LOGS_DEBUG)
     eos_static_debug("ino=%#llx first=%#llx last=%#llx", ino,
-                     lru_first, lru_last);
+                     s.lru_first, s.lru_last);
 
   // lru list handling with outside lock handling
-  if (this->count(ino)) {
-    shared_md smd = (*this)[ino];
+  if (s.count(ino)) {
+    shared_md smd = s[ino];
 
     if (smd) {
-      prev = (*this)[ino]->lru_prev();
-      next = (*this)[ino]->lru_next();
+      prev = s[ino]->lru_prev();
+      next = s[ino]->lru_next();
 
-      if (this->count(prev) && (*this)[prev]) {
-        (*this)[prev]->set_lru_next(next);
+      if (s.count(prev) && s[prev]) {
+        s[prev]->set_lru_next(next);
       } else {
         // this is the tail of the LRU list
-        lru_last = next;
+        s.lru_last = next;
       }
 
-      if (this->count(next) && (*this)[next]) {
-        (*this)[next]->set_lru_prev(prev);
+      if (s.count(next) && s[next]) {
+        s[next]->set_lru_prev(prev);
       } else {
         // this is the head of the LRU list
-        lru_first = prev;
+        s.lru_first = prev;
       }
     }
 
     if (EOS_LOGS_DEBUG) {
-      eos_static_debug("last:%#llx => %#llx (prev=%#llx)", lru_last, next, prev);
+      eos_static_debug("last:%#llx => %#llx (prev=%#llx)", s.lru_last, next, prev);
     }
   }
 
   if (EOS_LOGS_DEBUG)
     eos_static_debug("ino=%#llx first=%#llx last=%#llx prev=%#llx next=%#llx", ino,
-                     lru_first, lru_last, prev, next);
+                     s.lru_first, s.lru_last, prev, next);
 }
 
 /* -------------------------------------------------------------------------- */
 void
-metad::pmap::lru_update(fuse_ino_t ino, shared_md md)
+metad::pmap::lru_update(pshard& s, fuse_ino_t ino, shared_md md)
 {
   if (ino == 1) {
     return;
   }
 
-  if (lru_first == ino) {
+  if (s.lru_first == ino) {
     return;
   }
 
   if (EOS_LOGS_DEBUG)
     eos_static_debug("ino=%#llx first=%#llx last=%#llx", ino,
-                     lru_first, lru_last);
+                     s.lru_first, s.lru_last);
 
   // move an lru item to the head of the list
   uint64_t prev = md->lru_prev();
   uint64_t next = md->lru_next();
 
-  if (this->count(prev) && (*this)[prev]) {
-    (*this)[prev]->set_lru_next(next);
+  if (s.count(prev) && s[prev]) {
+    s[prev]->set_lru_next(next);
   } else {
     if (next) {
-      lru_last = next;
+      s.lru_last = next;
     } else {
-      lru_last = ino;
+      s.lru_last = ino;
     }
   }
 
-  if (this->count(next) && (*this)[next]) {
-    (*this)[next]->set_lru_prev(prev);
+  if (s.count(next) && s[next]) {
+    s[next]->set_lru_prev(prev);
   }
 
-  if (this->count(lru_first) && (*this)[lru_first]) {
-    (*this)[lru_first]->set_lru_next(ino);
-    md->set_lru_prev(lru_first);
+  if (s.count(s.lru_first) && s[s.lru_first]) {
+    s[s.lru_first]->set_lru_next(ino);
+    md->set_lru_prev(s.lru_first);
     md->set_lru_next(0);
-    lru_first = ino;
+    s.lru_first = ino;
   }
 
   if (EOS_LOGS_DEBUG)
     eos_static_debug("ino=%#llx first=%#llx last=%#llx prev=%#llx next=%#llx", ino,
-                     lru_first, lru_last, prev, next);
+                     s.lru_first, s.lru_last, prev, next);
 }
 
 /* -------------------------------------------------------------------------- */
 void
-metad::pmap::lru_dump()
+metad::pmap::lru_dump(pshard& s)
 {
   if (!EOS_LOGS_DEBUG) {
     return;
   }
 
-  uint64_t start = lru_first;
+  uint64_t start = s.lru_first;
   std::stringstream ss;
 
   do {
-    if (this->count(start)) {
-      shared_md md = (*this)[start];
+    if (s.count(start)) {
+      shared_md md = s[start];
       ss << start << "[" << md->lru_next() << ".." << md->lru_prev() << "]" <<
          std::endl;
 
@@ -3471,7 +3516,7 @@ metad::pmap::lru_dump()
 
   eos_static_debug("%s", ss.str().c_str());
   eos_static_debug("first=%#llx last=%#llx",
-                   lru_first, lru_last);
+                   s.lru_first, s.lru_last);
 }
 
 /* -------------------------------------------------------------------------- */
@@ -3643,29 +3688,31 @@ metad::pmap::swap_rm(fuse_ino_t ino)
 void
 metad::pmap::insertTS(fuse_ino_t ino, shared_md& md)
 {
-  XrdSysMutexHelper mLock(this);
-  bool exists = this->count(ino);
-  (*this)[ino] = md;
+  pshard& s = shard(ino);
+  XrdSysMutexHelper mLock(s);
+  bool exists = s.count(ino);
+  s[ino] = md;
   // lru list handling
 
   if (!exists) {
-    lru_add(ino, md);
+    lru_add(s, ino, md);
   }
 
-  lru_dump();
+  lru_dump(s);
 }
 
 /* -------------------------------------------------------------------------- */
 bool
 metad::pmap::eraseTS(fuse_ino_t ino)
 {
-  XrdSysMutexHelper mLock(this);
+  pshard& s = shard(ino);
+  XrdSysMutexHelper mLock(s);
   // lru list handling
-  lru_remove(ino);
+  lru_remove(s, ino);
   bool exists = false;
-  auto it = this->find(ino);
+  auto it = s.find(ino);
 
-  if ((it != this->end()) && it->first) {
+  if ((it != s.end()) && it->first) {
     exists = true;
   }
 
@@ -3675,40 +3722,66 @@ metad::pmap::eraseTS(fuse_ino_t ino)
   }
 
   if (exists) {
-    this->erase(it);
+    s.erase(it);
   }
 
   swap_rm(ino); // ignore return code
   return exists;
 }
 
+/* -------------------------------------------------------------------------- */
+void
+metad::pmap::resetTS(shared_md root)
+{
+  // drop everything but the root inode
+  for (size_t i = 0; i < kShards; ++i) {
+    pshard& s = shard_at(i);
+    XrdSysMutexHelper mLock(s);
+    s.clear();
+    s.lru_first = 0;
+    s.lru_last = 0;
+
+    if (&s == &shard(1)) {
+      s[1] = root;
+    }
+  }
+}
+
 /* -------------------------------------------------------------------------- */
 void
 metad::pmap::retrieveWithParentTS(fuse_ino_t ino, shared_md& md, shared_md& pmd)
 {
-  // Atomically retrieve md objects for an inode, and its parent.
+  // Retrieve md objects for an inode, and its parent, with the parent id
+  // read under the md lock.
+  fuse_ino_t pid = 0;
+
   while (true) {
-    // In this particular case, we need to first lock mdmap, and then
+    // In this particular case, we need to first lock the shard, and then
     // md.. The following algorithm is meant to avoid deadlocks with code
     // which locks md first, and then mdmap.
     md.reset();
     pmd.reset();
-    XrdSysMutexHelper mLock(this);
+    pshard& s = shard(ino);
+    XrdSysMutexHelper mLock(s);
 
-    if (!retrieve(ino, md)) {
+    if (!retrieve(s, ino, md)) {
       return; // ino not there, nothing to do
     }
 
     // md has been found. Can we lock it?
     if (md->Locker().CondLock()) {
       // Success!
-      retrieve(md->pid(), pmd);
+      pid = md->pid();
       md->Locker().UnLock();
-      return;
+      break;
     }
 
-    // Nope, unlock mdmap and try again.
+    // Nope, unlock the shard and try again.
     mLock.UnLock();
     std::this_thread::sleep_for(std::chrono::milliseconds(1));
   }
+
+  // the parent lives in another shard, which must not be locked together
+  // with the one of ino
+  retrieveTS(pid, pmd);
 }
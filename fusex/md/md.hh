@@ -36,6 +36,7 @@
 #include "common/AssistedThread.hh"
 #include "kv/kv.hh"
 #include "misc/FuseId.hh"
+#include "misc/ShardedMap.hh"
 #include "XrdSys/XrdSysPthread.hh"
 #include <memory>
 #include <map>
@@ -405,15 +406,29 @@ public:
     XrdSysMutex mMutex;
   };
 
-  class pmap : public std::map<fuse_ino_t, shared_md>, public XrdSysMutex
-  //----------------------------------------------------------------------------
+  // every shard of the inode map keeps the lru list of its own inodes
+  class pshard : public ShardedMapShard<fuse_ino_t, shared_md>
   {
   public:
 
-    pmap()
+    pshard()
     {
       lru_first = 0;
       lru_last = 0;
+    }
+
+    uint64_t lru_first;
+    uint64_t lru_last;
+  };
+
+  class pmap : public ShardedMap<fuse_ino_t, shared_md,
+    std::hash<fuse_ino_t>, pshard>
+  //----------------------------------------------------------------------------
+  {
+  public:
+
+    pmap()
+    {
       store = 0 ;
     }
 
@@ -426,28 +441,28 @@ public:
 
     // TS stands for "thread-safe"
 
-    size_t sizeTS();
-
     bool retrieveOrCreateTS(fuse_ino_t ino, shared_md& ret);
     bool retrieveTS(fuse_ino_t ino, shared_md& ret);
-    bool retrieve(fuse_ino_t ino, shared_md& ret);
     void insertTS(fuse_ino_t ino, shared_md& md);
     bool eraseTS(fuse_ino_t ino);
     void retrieveWithParentTS(fuse_ino_t ino, shared_md& md, shared_md& pmd);
+    void resetTS(shared_md root);
 
-    uint64_t lru_oldest() const;
-    void lru_add(fuse_ino_t ino, shared_md md);
-    void lru_remove(fuse_ino_t ino);
-    void lru_update(fuse_ino_t ino, shared_md md);
-    void lru_dump();
+    // the following require the lock of the shard s, which has to be the
+    // shard of ino
+    bool retrieve(pshard& s, fuse_ino_t ino, shared_md& ret);
+
+    uint64_t lru_oldest(const pshard& s) const;
+    void lru_add(pshard& s, fuse_ino_t ino, shared_md md);
+    void lru_remove(pshard& s, fuse_ino_t ino);
+    void lru_update(pshard& s, fuse_ino_t ino, shared_md md);
+    void lru_dump(pshard& s);
 
     int swap_out(shared_md md);
     int swap_in(fuse_ino_t ino, shared_md md);
     int swap_rm(fuse_ino_t ino);
 
   private:
-    uint64_t lru_first;
-    uint64_t lru_last;
     kv* store;
   };
 
@@ -666,12 +681,11 @@ public:
   }
 
   void mdreset() {
-    XrdSysMutexHelper lock(mdmap);
-    shared_md md1 = mdmap[1];
+    shared_md md1;
+    mdmap.retrieveTS(1, md1);
     md1->set_type(md1->MD);
     md1->force_refresh();
-    mdmap.clear();
-    mdmap[1] = md1;
+    mdmap.resetTS(md1);
     uint64_t i_root = inomap.backward(1);
     inomap.clear();
     inomap.insert(i_root,1);
@@ -0,0 +1,190 @@
+//------------------------------------------------------------------------------
+//! @file ShardedMap.hh
+//! @brief Hash map split into shards with a mutex per shard
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2021 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#ifndef FUSE_SHARDEDMAP_HH_
+#define FUSE_SHARDEDMAP_HH_
+
+#include "XrdSys/XrdSysPthread.hh"
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+//------------------------------------------------------------------------------
+//! One shard of a ShardedMap, it has to be locked for any access
+//------------------------------------------------------------------------------
+template<typename K, typename V>
+class ShardedMapShard : public std::unordered_map<K, V>, public XrdSysMutex
+{
+};
+
+//------------------------------------------------------------------------------
+//! Map from K to V split into kShards hash maps, each with its own mutex, so
+//! that threads working on different keys don't serialize on a single lock.
+//!
+//! Simple operations come as thread-safe methods (TS suffix). Compound
+//! operations lock the shard of the key and work on it directly:
+//!
+//!   auto& s = map.shard(key);
+//!   XrdSysMutexHelper lock(s);
+//!   ...
+//!
+//! A shard lock must not be held while locking another shard, and none of
+//! the TS methods may be called with a shard lock held. Iterations go
+//! through one shard at a time, they only see a consistent view of a shard
+//! and not of the whole map.
+//!
+//! H selects the shard of a key, keys which have to be updated together must
+//! end up in the same shard. S can extend the shard with per-shard state.
+//------------------------------------------------------------------------------
+template < typename K, typename V, typename H = std::hash<K>,
+           typename S = ShardedMapShard<K, V> >
+class ShardedMap
+{
+public:
+  static constexpr size_t kShards = 64;
+  typedef S shard_t;
+
+  ShardedMap() { }
+
+  virtual ~ShardedMap() { }
+
+  //----------------------------------------------------------------------------
+  //! Get the shard holding key
+  //----------------------------------------------------------------------------
+  S& shard(const K& key)
+  {
+    return mShards[index(key)];
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get shard by index, 0 <= i < kShards
+  //----------------------------------------------------------------------------
+  S& shard_at(size_t i)
+  {
+    return mShards[i];
+  }
+
+  //----------------------------------------------------------------------------
+  //! Index of the shard holding key. std::hash of integers is the identity,
+  //! the hash gets mixed so that inodes with a common stride spread evenly.
+  //----------------------------------------------------------------------------
+  static size_t index(const K& key)
+  {
+    static_assert(kShards == 64, "the shard index takes the top 6 bits");
+    uint64_t h = (uint64_t) H()(key);
+    return (h * 0x9e3779b97f4a7c15ull) >> 58;
+  }
+
+  bool retrieveTS(const K& key, V& val)
+  {
+    S& s = shard(key);
+    XrdSysMutexHelper mLock(s);
+    auto it = s.find(key);
+
+    if (it == s.end()) {
+      return false;
+    }
+
+    val = it->second;
+    return true;
+  }
+
+  void insertTS(const K& key, const V& val)
+  {
+    S& s = shard(key);
+    XrdSysMutexHelper mLock(s);
+    s[key] = val;
+  }
+
+  bool eraseTS(const K& key)
+  {
+    S& s = shard(key);
+    XrdSysMutexHelper mLock(s);
+    return s.erase(key);
+  }
+
+  bool countTS(const K& key)
+  {
+    S& s = shard(key);
+    XrdSysMutexHelper mLock(s);
+    return s.count(key);
+  }
+
+  size_t sizeTS()
+  {
+    size_t n = 0;
+
+    for (auto& s : mShards) {
+      XrdSysMutexHelper mLock(s);
+      n += s.size();
+    }
+
+    return n;
+  }
+
+  void clearTS()
+  {
+    for (auto& s : mShards) {
+      XrdSysMutexHelper mLock(s);
+      s.clear();
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  //! Call f(key, value) for every entry, holding the lock of its shard
+  //----------------------------------------------------------------------------
+  template<typename F>
+  void for_eachTS(F f)
+  {
+    for (auto& s : mShards) {
+      XrdSysMutexHelper mLock(s);
+
+      for (auto it = s.begin(); it != s.end(); ++it) {
+        f(it->first, it->second);
+      }
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  //! Copy of all entries, to iterate without holding any lock
+  //----------------------------------------------------------------------------
+  std::vector<std::pair<K, V>> snapshotTS()
+  {
+    std::vector<std::pair<K, V>> entries;
+
+    for (auto& s : mShards) {
+      XrdSysMutexHelper mLock(s);
+      entries.insert(entries.end(), s.begin(), s.end());
+    }
+
+    return entries;
+  }
+
+private:
+  std::array<S, kShards> mShards;
+};
+
+#endif
@@ -0,0 +1,146 @@
+//------------------------------------------------------------------------------
+// File: ra-streams.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2021 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "fusex/data/rastreams.hh"
+#include "gtest/gtest.h"
+
+TEST(RaStreams, Sequential)
+{
+  rastreams ra;
+  uint64_t now = 0;
+
+  for (off_t off = 0; off < 3 * 4096; off += 4096) {
+    ra.add(off, 4096, now += 100);
+  }
+
+  ASSERT_EQ(ra.streams().size(), 1u);
+  rastreams::stream_t s = ra.streams()[0];
+  ASSERT_EQ(s.pattern, rastreams::SEQUENTIAL);
+  ASSERT_TRUE(s.active());
+  auto reqs = ra.plan(s, 1024 * 1024, 256 * 1024, 16, 1ll << 40);
+  ASSERT_EQ(reqs.size(), 4u);
+  ASSERT_EQ(reqs[0].offset, 3 * 4096);
+  ASSERT_EQ(reqs[0].size, 256u * 1024);
+  ASSERT_EQ(reqs[3].offset, 3 * 4096 + 3 * 256 * 1024);
+  // the window is already covered
+  ASSERT_TRUE(ra.plan(s, 1024 * 1024, 256 * 1024, 16, 1ll << 40).empty());
+  // no prefetching past the end of the file
+  rastreams::stream_t t = ra.streams()[0];
+  reqs = ra.plan(t, 1024 * 1024, 256 * 1024, 16, 100000);
+  ASSERT_EQ(reqs.size(), 1u);
+  ASSERT_EQ(reqs[0].size, 100000u - 3 * 4096);
+}
+
+TEST(RaStreams, Strided)
+{
+  rastreams ra;
+  uint64_t now = 0;
+
+  ra.add(0, 1000, now += 100);
+  ra.add(100000, 1000, now += 100);
+  rastreams::stream_t& s = ra.add(200000, 1000, now += 100);
+  ASSERT_EQ(ra.streams().size(), 1u);
+  ASSERT_EQ(s.pattern, rastreams::STRIDED);
+  ASSERT_EQ(s.stride, 100000);
+  ASSERT_TRUE(s.active());
+  auto reqs = ra.plan(s, 10000, 0, 64, 1ll << 40);
+  ASSERT_EQ(reqs.size(), 10u);
+
+  for (size_t i = 0; i < reqs.size(); ++i) {
+    ASSERT_EQ(reqs[i].offset, (off_t)(300000 + i * 100000));
+    ASSERT_EQ(reqs[i].size, 1000u);
+  }
+
+  ASSERT_TRUE(ra.wanted(300000, 1000));
+  ASSERT_FALSE(ra.wanted(0, 1000));
+}
+
+TEST(RaStreams, Wanted)
+{
+  rastreams ra;
+  ra.add(0, 4096, 100);
+  // the chunk prefetched at open holds the next read of a young stream
+  ASSERT_TRUE(ra.wanted(0, 1024 * 1024));
+  ASSERT_TRUE(ra.wanted(4096, 65536));
+  ASSERT_FALSE(ra.wanted(8192, 65536));
+  ra.add(1024 * 1024, 4096, 200);
+  ASSERT_FALSE(ra.wanted(0, 4096));
+}
+
+TEST(RaStreams, Interleaved)
+{
+  // two sequential readers and a strided one on the same file
+  rastreams ra;
+  uint64_t now = 0;
+
+  for (off_t i = 0; i < 10; ++i) {
+    ra.add(i * 65536, 65536, now += 10);
+    ra.add((1ll << 30) + i * 65536, 65536, now += 10);
+    ra.add((1ll << 32) + i * 1000000, 4096, now += 10);
+  }
+
+  ASSERT_EQ(ra.streams().size(), 3u);
+  ASSERT_EQ(ra.streams()[0].pattern, rastreams::SEQUENTIAL);
+  ASSERT_EQ(ra.streams()[0].hits, 9u);
+  ASSERT_EQ(ra.streams()[1].pattern, rastreams::SEQUENTIAL);
+  ASSERT_EQ(ra.streams()[1].hits, 9u);
+  ASSERT_EQ(ra.streams()[2].pattern, rastreams::STRIDED);
+  ASSERT_EQ(ra.streams()[2].stride, 1000000);
+  ASSERT_EQ(ra.streams()[2].hits, 9u);
+}
+
+TEST(RaStreams, Random)
+{
+  rastreams ra;
+  uint64_t now = 0;
+  srand(1);
+
+  for (size_t i = 0; i < 1000; ++i) {
+    rastreams::stream_t& s = ra.add(((off_t) rand() % 100000) * 4096, 4096,
+                                    now += 10);
+    ASSERT_TRUE(ra.plan(s, 1024 * 1024, 65536, 16, 1ll << 40).empty());
+  }
+
+  ASSERT_EQ(ra.streams().size(), rastreams::kMaxStreams);
+}
+
+TEST(RaStreams, Window)
+{
+  rastreams ra;
+  uint64_t now = 0;
+  rastreams::stream_t* s = 0;
+
+  // 1 MB/ms read rate and 10 ms latency
+  for (off_t i = 0; i < 10; ++i) {
+    s = &ra.add(i * 1048576, 1048576, now += 1000);
+  }
+
+  ASSERT_EQ(ra.window(*s, 4096, 1ll << 30), 4096u);
+
+  for (size_t i = 0; i < 10; ++i) {
+    ra.add_latency(10000);
+  }
+
+  ASSERT_EQ(ra.latency(), 10000u);
+  ASSERT_EQ(ra.window(*s, 4096, 1ll << 30), 2 * 10 * 1048576u);
+  ASSERT_EQ(ra.window(*s, 4096, 1048576), 1048576u);
+}
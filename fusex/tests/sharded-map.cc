@@ -0,0 +1,116 @@
+//------------------------------------------------------------------------------
+// File: sharded-map.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2021 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "fusex/misc/ShardedMap.hh"
+#include "gtest/gtest.h"
+#include <memory>
+#include <string>
+#include <thread>
+
+TEST(ShardedMap, BasicSanity)
+{
+  ShardedMap<uint64_t, std::string> map;
+  std::string val;
+  ASSERT_FALSE(map.retrieveTS(1, val));
+  map.insertTS(1, "one");
+  map.insertTS(2, "two");
+  ASSERT_TRUE(map.retrieveTS(1, val));
+  ASSERT_EQ(val, "one");
+  ASSERT_TRUE(map.countTS(2));
+  ASSERT_EQ(map.sizeTS(), 2u);
+  ASSERT_TRUE(map.eraseTS(2));
+  ASSERT_FALSE(map.eraseTS(2));
+  ASSERT_FALSE(map.countTS(2));
+  map.insertTS(3, "three");
+  auto entries = map.snapshotTS();
+  ASSERT_EQ(entries.size(), 2u);
+  size_t n = 0;
+  map.for_eachTS([&](const uint64_t & key, std::string & value) {
+    ASSERT_TRUE(key == 1 || key == 3);
+    n++;
+  });
+  ASSERT_EQ(n, 2u);
+  map.clearTS();
+  ASSERT_EQ(map.sizeTS(), 0u);
+}
+
+TEST(ShardedMap, Distribution)
+{
+  typedef ShardedMap<uint64_t, int> map_t;
+  // inodes with a large common stride must not end up in a few shards
+  std::vector<size_t> count(map_t::kShards);
+
+  for (uint64_t fid = 1; fid <= 64 * 1000; ++fid) {
+    count[map_t::index(fid << 28)]++;
+  }
+
+  for (auto c : count) {
+    ASSERT_GT(c, 900u);
+    ASSERT_LT(c, 1100u);
+  }
+}
+
+TEST(ShardedMap, ShardHash)
+{
+  struct same_hash {
+    size_t operator()(uint64_t key) const
+    {
+      return std::hash<uint64_t>()(key % 0xffffffff);
+    }
+  };
+  typedef ShardedMap<uint64_t, int, same_hash> map_t;
+  map_t map;
+
+  for (uint64_t ino = 1; ino < 100000; ino += 7) {
+    ASSERT_EQ(&map.shard(ino), &map.shard(ino + 0xffffffff));
+  }
+}
+
+TEST(ShardedMap, Concurrency)
+{
+  ShardedMap<uint64_t, std::shared_ptr<uint64_t>> map;
+  std::vector<std::thread> workers;
+  const size_t nthreads = 8;
+  const uint64_t nkeys = 10000;
+
+  for (size_t t = 0; t < nthreads; ++t) {
+    workers.emplace_back([&map, t, nthreads]() {
+      for (uint64_t i = 0; i < nkeys; ++i) {
+        uint64_t key = i * nthreads + t;
+        std::shared_ptr<uint64_t> val;
+        map.insertTS(key, std::make_shared<uint64_t>(key));
+        ASSERT_TRUE(map.retrieveTS(key, val));
+        ASSERT_EQ(*val, key);
+
+        if (i % 2) {
+          ASSERT_TRUE(map.eraseTS(key));
+        }
+      }
+    });
+  }
+
+  for (auto& w : workers) {
+    w.join();
+  }
+
+  ASSERT_EQ(map.sizeTS(), nthreads * nkeys / 2);
+}
@@ -696,6 +696,164 @@ TEST(XrdClProxy, ReadAheadDynamic)
   ASSERT_TRUE(status.IsOK());
 }
 
+TEST(XrdClProxy, ReadAheadAdaptive)
+{
+  eos::common::ShellCmd xrd("xrootd -p 21234 -n proxytest");
+  XrdSysTimer sleeper;
+  sleeper.Snooze(1);
+  std::vector<int> buffer;
+  buffer.resize(64 * 1024 * 1024);
+
+  for (size_t i = 0; i < buffer.size(); i++) {
+    buffer[i] = i;
+  }
+
+  XrdCl::Proxy file;
+  XrdCl::OpenFlags::Flags targetFlags = XrdCl::OpenFlags::Update |
+                                        XrdCl::OpenFlags::Delete;
+  XrdCl::Access::Mode mode = XrdCl::Access::UR | XrdCl::Access::UW |
+                             XrdCl::Access::UX;
+  fprintf(stderr, "[01] open)\n");
+  XrdCl::XRootDStatus status =
+    file.Open("root://localhost:21234//tmp/xrdclproxytest", targetFlags, mode, 300);
+  ASSERT_TRUE(status.IsOK());
+  fprintf(stderr, "[02] waitopen)\n");
+  status = file.WaitOpen();
+  ASSERT_TRUE(status.IsOK());
+  status = file.Truncate(0);
+  ASSERT_TRUE(status.IsOK());
+  fprintf(stderr, "\n[03] write-async \n");
+
+  for (size_t i = 0; i < 64; ++i) {
+    fprintf(stderr, ".");
+    XrdCl::Proxy::write_handler handler = file.WriteAsyncPrepare(4 * 1024 * 1024);
+    status = file.WriteAsync(4 * i * 1024 * 1024, 4 * 1024 * 1024,
+                             &buffer[i * 1024 * 1024], handler, (uint16_t) 300);
+    ASSERT_TRUE(status.IsOK());
+  }
+
+  status = file.CollectWrites();
+  ASSERT_TRUE(status.IsOK());
+  fprintf(stderr, "\n[04] zero \n");
+
+  for (size_t i = 0; i < 64 * 1024 * 1024; i++) {
+    buffer[i] = 0;
+  }
+
+  file.set_readahead_strategy(XrdCl::Proxy::ADAPTIVE, 4096, 1 * 1024 * 1024,
+                              8 * 1024 * 1024, 2);
+  file.set_readahead_maximum_position(4 * 1024 * 1024 * 64);
+  fprintf(stderr, "\n[05] read-ahead adaptive 4k 1M 8M \n");
+  ssize_t total_bytes = 0;
+
+  for (size_t i = 0; i < 330; ++i) {
+    uint32_t bytesRead = 0;
+    fprintf(stderr, ".");
+    status = file.Read(4 * i * 200 * 1024, 4 * 200 * 1024, &buffer[i * 200 * 1024],
+                       bytesRead, (uint16_t) 300);
+    total_bytes += bytesRead;
+    ASSERT_TRUE(status.IsOK());
+  }
+
+  ASSERT_EQ(total_bytes, (4 * 1024 * 1024 * 64));
+  fprintf(stderr, "\n[06] comparing \n");
+
+  for (ssize_t i = 0; i < 64 * 1024 * 1024; i++) {
+    if (buffer[i] != (int) i) {
+      ASSERT_EQ(buffer[i], (int) i);
+    }
+  }
+
+  fprintf(stderr, "\n[07] ra-efficiency=%f\n", file.get_readahead_efficiency());
+  // only the reads before the stream is detected are synchronous
+  ASSERT_GT(file.get_readahead_efficiency(), 98.0);
+  file.Collect();
+  status = file.Close((uint16_t) 0);
+  ASSERT_TRUE(status.IsOK());
+}
+
+TEST(XrdClProxy, ReadAheadAdaptiveStrided)
+{
+  eos::common::ShellCmd xrd("xrootd -p 21234 -n proxytest");
+  XrdSysTimer sleeper;
+  sleeper.Snooze(1);
+  std::vector<int> buffer;
+  buffer.resize(64 * 1024 * 1024);
+
+  for (size_t i = 0; i < buffer.size(); i++) {
+    buffer[i] = i;
+  }
+
+  XrdCl::Proxy file;
+  XrdCl::OpenFlags::Flags targetFlags = XrdCl::OpenFlags::Update |
+                                        XrdCl::OpenFlags::Delete;
+  XrdCl::Access::Mode mode = XrdCl::Access::UR | XrdCl::Access::UW |
+                             XrdCl::Access::UX;
+  fprintf(stderr, "[01] open)\n");
+  XrdCl::XRootDStatus status =
+    file.Open("root://localhost:21234//tmp/xrdclproxytest", targetFlags, mode, 300);
+  ASSERT_TRUE(status.IsOK());
+  fprintf(stderr, "[02] waitopen)\n");
+  status = file.WaitOpen();
+  ASSERT_TRUE(status.IsOK());
+  status = file.Truncate(0);
+  ASSERT_TRUE(status.IsOK());
+  fprintf(stderr, "\n[03] write-async \n");
+
+  for (size_t i = 0; i < 64; ++i) {
+    fprintf(stderr, ".");
+    XrdCl::Proxy::write_handler handler = file.WriteAsyncPrepare(4 * 1024 * 1024);
+    status = file.WriteAsync(4 * i * 1024 * 1024, 4 * 1024 * 1024,
+                             &buffer[i * 1024 * 1024], handler, (uint16_t) 300);
+    ASSERT_TRUE(status.IsOK());
+  }
+
+  status = file.CollectWrites();
+  ASSERT_TRUE(status.IsOK());
+  fprintf(stderr, "\n[04] zero \n");
+
+  for (size_t i = 0; i < 64 * 1024 * 1024; i++) {
+    buffer[i] = 0;
+  }
+
+  file.set_readahead_strategy(XrdCl::Proxy::ADAPTIVE, 4096, 1 * 1024 * 1024,
+                              4 * 1024 * 1024, 2);
+  file.set_readahead_maximum_position(4 * 1024 * 1024 * 64);
+  fprintf(stderr, "\n[05] read-ahead adaptive strided 800k every 1600k \n");
+  ssize_t total_bytes = 0;
+
+  for (size_t i = 0; i < 330; i += 2) {
+    uint32_t bytesRead = 0;
+    fprintf(stderr, ".");
+    status = file.Read(4 * i * 200 * 1024, 4 * 200 * 1024, &buffer[i * 200 * 1024],
+                       bytesRead, (uint16_t) 300);
+    total_bytes += bytesRead;
+    ASSERT_TRUE(status.IsOK());
+  }
+
+  fprintf(stderr, "total_bytes = %lu\n", total_bytes);
+  ASSERT_EQ(total_bytes, 134348800);
+  fprintf(stderr, "\n[06] comparing \n");
+
+  for (size_t k = 0; k < 330; k += 2)
+    for (size_t l = 0; l < 200 * 1024; l++) {
+      size_t i = (k * 200 * 1024) + l;
+
+      if (i < 67108864) {
+        if (buffer[i] != (int) i) {
+          ASSERT_EQ(buffer[i], (int) i);
+        }
+      }
+    }
+
+  fprintf(stderr, "\n[07] ra-efficiency=%f\n", file.get_readahead_efficiency());
+  // the strides are prefetched with vector reads
+  ASSERT_GT(file.get_readahead_efficiency(), 95.0);
+  file.Collect();
+  status = file.Close((uint16_t) 0);
+  ASSERT_TRUE(status.IsOK());
+}
+
 TEST(XrdClProxy, ScheduleWrite)
 {
   eos::common::ShellCmd xrd("xrootd -p 21234 -n proxytest");
@@ -25,6 +25,7 @@
 #include "mgm/Access.hh"
 #include "mgm/FsView.hh"
 #include "common/StringConversion.hh"
+#include <algorithm>
 
 EOSMGMNAMESPACE_BEGIN
 
@@ -82,6 +83,11 @@ std::map<gid_t, std::string> Access::gGroupRedirection;
 //! global rw mutex protecting all static singletons
 eos::common::RWMutex Access::gAccessMutex;
 
+//! compiled stall state
+std::shared_ptr<const Access::StallState> Access::gStallState =
+  std::make_shared<const Access::StallState>();
+std::atomic<bool> Access::gHasRateRules {false};
+
 /*----------------------------------------------------------------------------*/
 //! constant used in the configuration store
 const char* Access::gUserKey = "BanUsers";
@@ -139,6 +145,8 @@ Access::Reset(bool skip_stall_redirect)
     Access::gStallGlobal = Access::gStallRead =
                              Access::gStallWrite = Access::gStallUserGroup = false;
   }
+
+  CompileStallState();
 }
 
 /*----------------------------------------------------------------------------*/
@@ -307,6 +315,8 @@ Access::ApplyAccessConfig(bool applyredirectandstall)
       }
     }
   }
+
+  CompileStallState();
 }
 
 /*----------------------------------------------------------------------------*/
@@ -448,6 +458,7 @@ Access::StoreAccessConfig()
   ok &= FsView::gFsView.SetGlobalConfig(dakey, domainaval);
   ok &= FsView::gFsView.SetGlobalConfig(gStallKey, stall);
   ok &= FsView::gFsView.SetGlobalConfig(gRedirectionKey, redirect);
+  CompileStallState();
 
   if (!ok) {
     eos_static_err("unable to store <access> configuration");
@@ -538,6 +549,7 @@ Access::SetStallRule(const StallInfo& new_stall, StallInfo& old_stall)
   }
 
   Access::gStallGlobal = new_stall.mIsGlobal;
+  CompileStallState();
 }
 
 //------------------------------------------------------------------------------
@@ -553,6 +565,7 @@ Access::SetSlaveToMasterRules()
   Access::gRedirectionRules.erase(std::string("ENOENT:*"));
   Access::gStallRules.erase(std::string("w:*"));
   Access::gStallWrite = false;
+  CompileStallState();
 }
 
 //----------------------------------------------------------------------------
@@ -584,6 +597,8 @@ Access::SetMasterToSlaveRules(const std::string& other_master_id)
     Access::gStallWrite = false;
     Access::gStallGlobal = false;
   }
+
+  CompileStallState();
 }
 
 //------------------------------------------------------------------------------
@@ -602,6 +617,247 @@ Access::RemoveStallRule(const std::string& key)
   } else if (key.find("*") == 0) {
     Access::gStallGlobal = false;
   }
+
+  CompileStallState();
+}
+
+//------------------------------------------------------------------------------
+// Get the bucket of the given uid/gid
+//------------------------------------------------------------------------------
+Access::RateBucket*
+Access::RateLimitRule::GetBucket(uint32_t id, bool claim) const
+{
+  const uint64_t key = static_cast<uint64_t>(id) + 1;
+  const size_t mask = mNumBuckets - 1;
+  const size_t home = (id * 0x9E3779B1u) & mask;
+
+  for (size_t probe = 0; probe < std::min(kMaxProbes, mNumBuckets); ++probe) {
+    RateBucket& bucket = mBuckets[(home + probe) & mask];
+    uint64_t owner = bucket.mKey.load(std::memory_order_acquire);
+
+    if (owner == key) {
+      return &bucket;
+    }
+
+    if (owner == 0) {
+      if (!claim) {
+        return nullptr;
+      }
+
+      if (bucket.mKey.compare_exchange_strong(owner, key,
+                                              std::memory_order_acq_rel) ||
+          (owner == key)) {
+        return &bucket;
+      }
+    }
+  }
+
+  return (claim ? &mBuckets[home] : nullptr);
+}
+
+//------------------------------------------------------------------------------
+// Account requests of the given uid/gid against the rate
+//------------------------------------------------------------------------------
+void
+Access::RateLimitRule::Charge(uint32_t id, uint64_t count, int64_t now_ns) const
+{
+  RateBucket* bucket = GetBucket(id, true);
+  // The debt is capped so that a client stays stalled for at most one burst
+  // window once it is back under the rate
+  const int64_t max_tat = now_ns + 2 * kBurstNs;
+  count = std::min<uint64_t>(count, (2 * kBurstNs) / mIntervalNs + 1);
+  int64_t tat = bucket->mTat.load(std::memory_order_relaxed);
+  int64_t new_tat;
+
+  do {
+    new_tat = std::min(std::max(tat, now_ns) +
+                       static_cast<int64_t>(count) * mIntervalNs, max_tat);
+  } while (!bucket->mTat.compare_exchange_weak(tat, new_tat,
+           std::memory_order_relaxed));
+}
+
+//------------------------------------------------------------------------------
+// Check if the given uid/gid is above the rate
+//------------------------------------------------------------------------------
+bool
+Access::RateLimitRule::Exceeded(uint32_t id, int64_t now_ns) const
+{
+  RateBucket* bucket = GetBucket(id, false);
+  return (bucket &&
+          (bucket->mTat.load(std::memory_order_relaxed) - now_ns > kBurstNs));
+}
+
+//------------------------------------------------------------------------------
+// Get rules applicable to the given uid and gid in evaluation order
+//------------------------------------------------------------------------------
+std::vector<const Access::RateLimitRule*>
+Access::RateLimitRules::GetRules(uid_t uid, gid_t gid) const
+{
+  std::vector<const RateLimitRule*> rules;
+  FindRule(uid, gid, [&rules](const RateLimitRule * rule) {
+    rules.push_back(rule);
+    return false;
+  });
+  return rules;
+}
+
+//------------------------------------------------------------------------------
+// Rebuild the stall state
+//------------------------------------------------------------------------------
+void
+Access::CompileStallState()
+{
+  static const std::string user_prefix = "rate:user:";
+  static const std::string group_prefix = "rate:group:";
+  auto state = std::make_shared<StallState>();
+  state->mBannedUsers.insert(gBannedUsers.begin(), gBannedUsers.end());
+  state->mBannedGroups.insert(gBannedGroups.begin(), gBannedGroups.end());
+  state->mBannedHosts.insert(gBannedHosts.begin(), gBannedHosts.end());
+  state->mBannedDomains.insert(gBannedDomains.begin(), gBannedDomains.end());
+  state->mHasRules = !gStallRules.empty();
+  state->mStallGlobal = gStallGlobal;
+  state->mStallRead = gStallRead;
+  state->mStallWrite = gStallWrite;
+  state->mStallUserGroup = gStallUserGroup;
+  auto get_rule = [](const std::string & key, int& delay, std::string & comment) {
+    auto it = gStallRules.find(key);
+
+    if (it == gStallRules.end()) {
+      return false;
+    }
+
+    delay = atoi(it->second.c_str());
+    auto it_comment = gStallComment.find(key);
+
+    if (it_comment != gStallComment.end()) {
+      comment = it_comment->second;
+    }
+
+    return true;
+  };
+  state->mHasGlobalRule = get_rule("*", state->mGlobalDelay,
+                                   state->mGlobalComment);
+  get_rule("r:*", state->mReadDelay, state->mReadComment);
+  get_rule("w:*", state->mWriteDelay, state->mWriteComment);
+  RateLimitRules& rules = state->mRateRules;
+  size_t order = 0;
+
+  for (const auto& elem : gStallRules) {
+    const std::string& key = elem.first;
+    bool is_user = (key.find(user_prefix) == 0);
+
+    if (!is_user && (key.find(group_prefix) != 0)) {
+      continue;
+    }
+
+    // Key format is rate:<user|group>:<name>:<cmd>
+    size_t name_start = (is_user ? user_prefix.length() : group_prefix.length());
+    size_t name_end = key.find(':', name_start);
+
+    if (name_end == std::string::npos) {
+      eos_static_warning("msg=\"skip malformed rate rule\" key=\"%s\"",
+                         key.c_str());
+      continue;
+    }
+
+    std::unique_ptr<RateLimitRule> rule(new RateLimitRule());
+    size_t eosxd_pos = key.rfind("Eosxd");
+    rule->mCmd = (eosxd_pos != std::string::npos) ? key.substr(eosxd_pos) :
+                 key.substr(key.rfind(':') + 1);
+
+    // Find limits are not rates, see GetFindLimits
+    if ((rule->mCmd == "FindFiles") || (rule->mCmd == "FindDirs")) {
+      continue;
+    }
+
+    std::string name = key.substr(name_start, name_end - name_start);
+    rule->mIsWildcard = (name == "*");
+
+    if (!rule->mIsWildcard) {
+      // Names are resolved once here, the requests are matched by id
+      int errc = 0;
+      rule->mId = (is_user ? eos::common::Mapping::UserNameToUid(name, errc) :
+                   eos::common::Mapping::GroupNameToGid(name, errc));
+
+      if (errc) {
+        eos_static_warning("msg=\"skip rate rule of unknown %s\" key=\"%s\"",
+                           is_user ? "user" : "group", key.c_str());
+        continue;
+      }
+    }
+
+    rule->mOrder = order++;
+    rule->mKey = key;
+    rule->mIsUser = is_user;
+    rule->mIsEosxd = (rule->mCmd.substr(0, 5) == "Eosxd");
+    rule->mStallId = "Stall::" + rule->mCmd;
+    rule->mCutoff = strtod(elem.second.c_str(), 0) * 1.33;
+    // A zero cutoff stalls any request, same as a rate that is always above
+    rule->mIntervalNs = (rule->mCutoff > 0) ?
+                        static_cast<int64_t>(1e9 / rule->mCutoff) :
+                        RateLimitRule::kBurstNs + 1;
+    rule->mNumBuckets = (rule->mIsWildcard ?
+                         RateLimitRule::kNumWildcardBuckets : 1);
+    rule->mBuckets.reset(new RateBucket[rule->mNumBuckets]);
+    auto it_comment = gStallComment.find(key);
+
+    if (it_comment != gStallComment.end()) {
+      rule->mComment = it_comment->second;
+    }
+
+    const RateLimitRule* ptr = rule.get();
+
+    if (rule->mIsWildcard) {
+      rules.mWildcard.push_back(ptr);
+    } else if (is_user) {
+      rules.mUser[rule->mId].push_back(ptr);
+    } else {
+      rules.mGroup[rule->mId].push_back(ptr);
+    }
+
+    rules.mByCmd[rule->mCmd].push_back(ptr);
+    rules.mRules.push_back(std::move(rule));
+  }
+
+  gHasRateRules = !rules.mRules.empty();
+  std::atomic_store(&gStallState,
+                    std::shared_ptr<const StallState>(std::move(state)));
+}
+
+//------------------------------------------------------------------------------
+// Get the current stall state
+//------------------------------------------------------------------------------
+std::shared_ptr<const Access::StallState>
+Access::GetStallState()
+{
+  return std::atomic_load(&gStallState);
+}
+
+//------------------------------------------------------------------------------
+// Account requests against the rate rules limiting the given tag
+//------------------------------------------------------------------------------
+void
+Access::ChargeRateLimits(const char* tag, uid_t uid, gid_t gid,
+                         uint64_t count)
+{
+  if (!gHasRateRules.load(std::memory_order_relaxed)) {
+    return;
+  }
+
+  auto state = GetStallState();
+  auto it = state->mRateRules.mByCmd.find(tag);
+
+  if (it == state->mRateRules.mByCmd.end()) {
+    return;
+  }
+
+  int64_t now_ns = RateClockNs();
+
+  for (const auto* rule : it->second) {
+    if (rule->Matches(uid, gid)) {
+      rule->Charge(rule->mIsUser ? uid : gid, count, now_ns);
+    }
+  }
 }
 
 EOSMGMNAMESPACE_END
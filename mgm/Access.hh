@@ -35,6 +35,11 @@
 #include <vector>
 #include <string>
 #include <set>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
 
 EOSMGMNAMESPACE_BEGIN
 
@@ -172,6 +177,201 @@ public:
     {}
   };
 
+  //----------------------------------------------------------------------------
+  //! Token bucket of a rate rule for one uid/gid, kept as the theoretical
+  //! arrival time of the next request (GCRA) so that it can be updated with
+  //! a single compare-and-swap
+  //----------------------------------------------------------------------------
+  struct RateBucket {
+    std::atomic<uint64_t> mKey {0}; ///< uid/gid + 1 owning the bucket, 0 if free
+    std::atomic<int64_t> mTat {0}; ///< Theoretical arrival time in ns
+  };
+
+  //----------------------------------------------------------------------------
+  //! Single "rate:<user|group>:<name>:<cmd>" rule in compiled form
+  //----------------------------------------------------------------------------
+  struct RateLimitRule {
+    //! Requests above the rate are absorbed during this time window
+    static constexpr int64_t kBurstNs = 5000000000ll;
+    //! Buckets of a wildcard rule, a named rule has a single one
+    static constexpr size_t kNumWildcardBuckets = 1024;
+    //! Max number of slots probed for a free bucket
+    static constexpr size_t kMaxProbes = 8;
+
+    size_t mOrder = 0; ///< Position in gStallRules, the first exceeded rule wins
+    bool mIsUser = false; ///< Rule applies to the uid or the gid rates
+    bool mIsWildcard = false; ///< Rule applies to every uid or gid
+    bool mIsEosxd = false; ///< Eosxd rules only apply to the matching function
+    uint32_t mId = 0; ///< uid/gid of a named rule
+    double mCutoff = 0; ///< Rate cutoff in Hz including the tolerance
+    std::string mKey; ///< Key of the rule in gStallRules
+    int64_t mIntervalNs = 0; ///< Time between two requests at the cutoff rate
+    std::string mCmd; ///< Statistics tag the rate refers to
+    std::string mStallId; ///< Statistics tag accounting the stalls
+    std::string mComment; ///< Stall message comment
+    size_t mNumBuckets = 1; ///< Number of token buckets, a power of 2
+    std::unique_ptr<RateBucket[]> mBuckets; ///< Token buckets per uid/gid
+    mutable std::atomic<uint64_t> mThrottled {0}; ///< Requests stalled by the rule
+
+    //--------------------------------------------------------------------------
+    //! Check if the rule applies to the given uid and gid
+    //--------------------------------------------------------------------------
+    bool Matches(uid_t uid, gid_t gid) const
+    {
+      return mIsWildcard || (mId == (mIsUser ? uid : gid));
+    }
+
+    //--------------------------------------------------------------------------
+    //! Account requests of the given uid/gid against the rate
+    //!
+    //! @param id uid or gid depending on the rule type
+    //! @param count number of requests
+    //! @param now_ns current steady clock time in ns
+    //--------------------------------------------------------------------------
+    void Charge(uint32_t id, uint64_t count, int64_t now_ns) const;
+
+    //--------------------------------------------------------------------------
+    //! Check if the given uid/gid is above the rate
+    //!
+    //! @param id uid or gid depending on the rule type
+    //! @param now_ns current steady clock time in ns
+    //--------------------------------------------------------------------------
+    bool Exceeded(uint32_t id, int64_t now_ns) const;
+
+  private:
+    //--------------------------------------------------------------------------
+    //! Get the bucket of the given uid/gid
+    //!
+    //! @param id uid or gid
+    //! @param claim if true a free bucket is taken if there is none yet
+    //!
+    //! @return bucket or null if there is none and claim is false. If all
+    //!         probed buckets are taken the home bucket is shared.
+    //--------------------------------------------------------------------------
+    RateBucket* GetBucket(uint32_t id, bool claim) const;
+  };
+
+  //----------------------------------------------------------------------------
+  //! Rate stall rules compiled into lookup tables keyed by uid/gid and by
+  //! statistics tag. Every list is in gStallRules order already, so the
+  //! rules of a request are merged without sorting.
+  //----------------------------------------------------------------------------
+  struct RateLimitRules {
+    std::vector<std::unique_ptr<RateLimitRule>> mRules; ///< Owns the rules
+    std::vector<const RateLimitRule*> mWildcard; ///< rate:user:* and rate:group:*
+    std::unordered_map<uid_t, std::vector<const RateLimitRule*>> mUser;
+    std::unordered_map<gid_t, std::vector<const RateLimitRule*>> mGroup;
+    //! Rules by the statistics tag they limit
+    std::unordered_map<std::string, std::vector<const RateLimitRule*>> mByCmd;
+
+    //--------------------------------------------------------------------------
+    //! Find the first rule applicable to the given uid and gid, in evaluation
+    //! order, for which the predicate is true
+    //!
+    //! @return rule or null if there is none
+    //--------------------------------------------------------------------------
+    template<typename Predicate>
+    const RateLimitRule*
+    FindRule(uid_t uid, gid_t gid, Predicate pred) const
+    {
+      static const std::vector<const RateLimitRule*> sEmpty;
+      auto it_user = mUser.find(uid);
+      auto it_group = mGroup.find(gid);
+      const std::vector<const RateLimitRule*>* lists[3] = {
+        &mWildcard,
+        (it_user == mUser.end()) ? &sEmpty : &it_user->second,
+        (it_group == mGroup.end()) ? &sEmpty : &it_group->second
+      };
+      size_t pos[3] = {0, 0, 0};
+
+      while (true) {
+        const RateLimitRule* next = nullptr;
+        size_t next_list = 0;
+
+        for (size_t i = 0; i < 3; ++i) {
+          if ((pos[i] < lists[i]->size()) &&
+              (!next || ((*lists[i])[pos[i]]->mOrder < next->mOrder))) {
+            next = (*lists[i])[pos[i]];
+            next_list = i;
+          }
+        }
+
+        if (!next) {
+          return nullptr;
+        }
+
+        ++pos[next_list];
+
+        if (pred(next)) {
+          return next;
+        }
+      }
+    }
+
+    //--------------------------------------------------------------------------
+    //! Get rules applicable to the given uid and gid in evaluation order
+    //--------------------------------------------------------------------------
+    std::vector<const RateLimitRule*> GetRules(uid_t uid, gid_t gid) const;
+  };
+
+  //----------------------------------------------------------------------------
+  //! Immutable copy of the access rules used by XrdMgmOfs::ShouldStall, so
+  //! that the per-request check does not take gAccessMutex. Rebuilt whenever
+  //! the rules change.
+  //----------------------------------------------------------------------------
+  struct StallState {
+    std::unordered_set<uid_t> mBannedUsers;
+    std::unordered_set<gid_t> mBannedGroups;
+    std::unordered_set<std::string> mBannedHosts;
+    std::unordered_set<std::string> mBannedDomains;
+    bool mHasRules = false; ///< gStallRules is not empty
+    bool mHasGlobalRule = false; ///< gStallRules has a "*" entry
+    bool mStallGlobal = false;
+    bool mStallRead = false;
+    bool mStallWrite = false;
+    bool mStallUserGroup = false;
+    int mGlobalDelay = 0; ///< Delay of the "*" rule
+    int mReadDelay = 0; ///< Delay of the "r:*" rule
+    int mWriteDelay = 0; ///< Delay of the "w:*" rule
+    std::string mGlobalComment;
+    std::string mReadComment;
+    std::string mWriteComment;
+    RateLimitRules mRateRules;
+  };
+
+  //----------------------------------------------------------------------------
+  //! Rebuild the stall state from the banned sets, gStallRules and
+  //! gStallComment. The caller must hold at least a read lock on
+  //! gAccessMutex and call it after every change of these.
+  //----------------------------------------------------------------------------
+  static void CompileStallState();
+
+  //----------------------------------------------------------------------------
+  //! Get the current stall state, never null
+  //----------------------------------------------------------------------------
+  static std::shared_ptr<const StallState> GetStallState();
+
+  //----------------------------------------------------------------------------
+  //! Account requests against the rate rules limiting the given tag. Called
+  //! for every statistics update, does nothing if there are no rate rules.
+  //!
+  //! @param tag statistics tag
+  //! @param uid user id
+  //! @param gid group id
+  //! @param count number of requests
+  //----------------------------------------------------------------------------
+  static void ChargeRateLimits(const char* tag, uid_t uid, gid_t gid,
+                               uint64_t count);
+
+  //----------------------------------------------------------------------------
+  //! Get current steady clock time in ns used by the rate buckets
+  //----------------------------------------------------------------------------
+  static int64_t RateClockNs()
+  {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>
+           (std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
   //----------------------------------------------------------------------------
   //! Reset/clear all access rules
   //!
@@ -230,6 +430,12 @@ public:
   //! @param key stall rule key
   //----------------------------------------------------------------------------
   static void RemoveStallRule(const std::string& key);
+
+private:
+  //! Compiled stall state, accessed through std::atomic_load/store
+  static std::shared_ptr<const StallState> gStallState;
+  //! Set if the stall state has rate rules, checked by ChargeRateLimits
+  static std::atomic<bool> gHasRateRules;
 };
 
 EOSMGMNAMESPACE_END
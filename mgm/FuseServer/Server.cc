@@ -44,6 +44,8 @@
 #include "namespace/interface/IFileMD.hh"
 #include "namespace/interface/IContainerMD.hh"
 #include "namespace/interface/ContainerIterators.hh"
+#include "namespace/ns_quarkdb/NamespaceGroup.hh"
+#include "namespace/ns_quarkdb/persistency/ContainerListing.hh"
 #include "namespace/Prefetcher.hh"
 
 #include "common/Logging.hh"
@@ -66,6 +68,16 @@ USE_EOSFUSESERVERNAMESPACE
 
 const char* Server::cident = "fxserver";
 
+//------------------------------------------------------------------------------
+// Get the QuarkDB client of the namespace
+//------------------------------------------------------------------------------
+static qclient::QClient*
+GetQClient()
+{
+  return static_cast<eos::QuarkNamespaceGroup*>
+         (gOFS->namespaceGroup.get())->getQClient();
+}
+
 
 //------------------------------------------------------------------------------
 // Constructor
@@ -341,7 +353,29 @@ Server::FillContainerMD(uint64_t id, eos::fusex::md& dir,
   eos::common::RWMutexReadLock rd_ns_lock(gOFS->eosViewRWMutex, __FUNCTION__,
                                           __LINE__, __FILE__);
   try {
-    cmd = gOFS->eosDirectoryService->getContainerMD(id, &clock);
+    uint64_t num_children = 0;
+    bool paged = false;
+
+    if ((dir.operation() == dir.LS) && gOFS->mListingPagedThreshold &&
+        gOFS->NsInQDB) {
+      // Large directories are listed in pages without loading them
+      eos::ContainerListing::LargeContainer large =
+        eos::ContainerListing::getLargeContainer(*GetQClient(),
+            eos::ContainerIdentifier(id), gOFS->mListingPagedThreshold).get();
+
+      if (large.container) {
+        cmd = large.container;
+        clock = cmd->getClock();
+        num_children = large.numFiles + large.numContainers;
+        paged = true;
+      }
+    }
+
+    if (!paged) {
+      cmd = gOFS->eosDirectoryService->getContainerMD(id, &clock);
+      num_children = cmd->getNumContainers() + cmd->getNumFiles();
+    }
+
     rd_ns_lock.Release();
     cmd->getCTime(ctime);
     cmd->getMTime(mtime);
@@ -386,7 +420,7 @@ Server::FillContainerMD(uint64_t id, eos::fusex::md& dir,
       }
     }
 
-    dir.set_nchildren(cmd->getNumContainers() + cmd->getNumFiles());
+    dir.set_nchildren(num_children);
 
     if (dir.operation() == dir.LS) {
       // we put a hard-coded listing limit for service protection
@@ -398,15 +432,35 @@ Server::FillContainerMD(uint64_t id, eos::fusex::md& dir,
         }
       }
 
-      for (auto it = eos::FileMapIterator(cmd); it.valid(); it.next()) {
-        std::string key = eos::common::StringConversion::EncodeInvalidUTF8(it.key());
-        (*dir.mutable_children())[key] =
-          eos::common::FileId::FidToInode(it.value());
-      }
+      if (paged) {
+        std::string cursor;
+
+        do {
+          eos::ContainerListing::Page page = eos::ContainerListing::getPage(
+                                               *GetQClient(), eos::ContainerIdentifier(id), cursor).get();
+
+          for (const auto& entry : page.entries) {
+            std::string key = eos::common::StringConversion::EncodeInvalidUTF8(
+                                entry.name);
+            (*dir.mutable_children())[key] = entry.id.isFile() ?
+                                             eos::common::FileId::FidToInode(
+                                               entry.id.toFileIdentifier().getUnderlyingUInt64()) :
+                                             entry.id.toContainerIdentifier().getUnderlyingUInt64();
+          }
 
-      for (auto it = ContainerMapIterator(cmd); it.valid(); it.next()) {
-        std::string key = eos::common::StringConversion::EncodeInvalidUTF8(it.key());
-        (*dir.mutable_children())[key] = it.value();
+          cursor = std::move(page.cursor);
+        } while (!cursor.empty());
+      } else {
+        for (auto it = eos::FileMapIterator(cmd); it.valid(); it.next()) {
+          std::string key = eos::common::StringConversion::EncodeInvalidUTF8(it.key());
+          (*dir.mutable_children())[key] =
+            eos::common::FileId::FidToInode(it.value());
+        }
+
+        for (auto it = ContainerMapIterator(cmd); it.valid(); it.next()) {
+          std::string key = eos::common::StringConversion::EncodeInvalidUTF8(it.key());
+          (*dir.mutable_children())[key] = it.value();
+        }
       }
 
       // indicate that this MD record contains children information
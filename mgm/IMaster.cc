@@ -50,6 +50,26 @@ void IMaster::fillNamespaceCacheConfig(IConfigEngine *configEngine,
 
   namespaceConfig[constants::sMaxNumCacheFiles] = std::to_string(nfiles);
   namespaceConfig[constants::sMaxNumCacheDirs] = std::to_string(ndirs);
+
+  // Size limits in bytes are optional, 0 means no limit
+  std::string sizeStr;
+  uint64_t size = 0;
+
+  if(configEngine->get("ns", "cache-size-bytes-files", sizeStr)) {
+    if(common::ParseUInt64(sizeStr, size)) {
+      namespaceConfig[constants::sMaxSizeCacheFiles] = std::to_string(size);
+    } else {
+      eos_static_crit("Could not parse 'cache-size-bytes-files' configuration value");
+    }
+  }
+
+  if(configEngine->get("ns", "cache-size-bytes-dirs", sizeStr)) {
+    if(common::ParseUInt64(sizeStr, size)) {
+      namespaceConfig[constants::sMaxSizeCacheDirs] = std::to_string(size);
+    } else {
+      eos_static_crit("Could not parse 'cache-size-bytes-dirs' configuration value");
+    }
+  }
 }
 
 EOSMGMNAMESPACE_END
@@ -437,6 +437,8 @@ Master::Supervisor()
             }
           }
         }
+
+        Access::CompileStallState();
       }
     }
 
@@ -473,10 +475,12 @@ Master::Supervisor()
         pStallSetting = Access::gStallRules[std::string("w:*")];
         Access::gStallRules[std::string("w:*")] = "60";
         Access::gStallWrite = true;
+        Access::CompileStallState();
       } else {
         MasterLog(eos_log(LOG_NOTICE, "status=\"disk space ok - removed stall\" "
                           "path=%s freebyte=%s", gOFS->MgmMetaLogDir.c_str(),
                           sizestring.c_str()));
+        eos::common::RWMutexWriteLock lock(Access::gAccessMutex);
 
         if (pStallSetting.length()) {
           // Put back the original stall setting
@@ -488,6 +492,7 @@ Master::Supervisor()
           Access::gStallWrite = false;
         }
 
+        Access::CompileStallState();
         pStallSetting = "";
       }
 
@@ -1595,6 +1600,8 @@ Master::MasterRO2Slave()
       Access::gStallRules[std::string("*")] = "60";
       Access::gStallGlobal = true;
     }
+
+    Access::CompileStallState();
   }
   {
     // Convert the namespace
@@ -1743,6 +1750,18 @@ Master::BootNamespace()
     namespaceConfig["qdb_password"] = gOFS->mQdbPassword;
     namespaceConfig["qdb_flusher_md"] = SSTR(instance_id << "_md");
     namespaceConfig["qdb_flusher_quota"] = SSTR(instance_id << "_quota");
+
+    if (getenv("EOS_NS_QDB_FLUSHER_COALESCE_MS")) {
+      namespaceConfig["qdb_flusher_coalesce_ms"] =
+        getenv("EOS_NS_QDB_FLUSHER_COALESCE_MS");
+    }
+
+    // Names in directories listed in pages are looked up without loading them
+    if (gOFS->mListingPagedThreshold) {
+      namespaceConfig["large_container_threshold"] =
+        std::to_string(gOFS->mListingPagedThreshold);
+    }
+
     fillNamespaceCacheConfig(gOFS->ConfEngine, namespaceConfig);
 
     // Forbid running as slave with the QDB namespace when the legacy master-
@@ -102,6 +102,32 @@ QdbMaster::BootNamespace()
   namespaceConfig["qdb_password"] = gOFS->mQdbPassword;
   namespaceConfig["qdb_flusher_md"] = SSTR(instance_id << "_md");
   namespaceConfig["qdb_flusher_quota"] = SSTR(instance_id << "_quota");
+
+  if (getenv("EOS_NS_QDB_FLUSHER_COALESCE_MS")) {
+    namespaceConfig["qdb_flusher_coalesce_ms"] =
+      getenv("EOS_NS_QDB_FLUSHER_COALESCE_MS");
+  }
+
+  // Snapshot of the hot metadata cache entries used for the warm-up
+  namespaceConfig["cache_snapshot_path"] =
+    SSTR("/var/eos/md/ns-cache-snapshot." << gOFS->ManagerPort);
+
+  if (getenv("EOS_NS_CACHE_SNAPSHOT_PATH")) {
+    namespaceConfig["cache_snapshot_path"] =
+      getenv("EOS_NS_CACHE_SNAPSHOT_PATH");
+  }
+
+  if (getenv("EOS_NS_CACHE_SNAPSHOT_INTERVAL")) {
+    namespaceConfig["cache_snapshot_interval"] =
+      getenv("EOS_NS_CACHE_SNAPSHOT_INTERVAL");
+  }
+
+  // Names in directories listed in pages are looked up without loading them
+  if (gOFS->mListingPagedThreshold) {
+    namespaceConfig["large_container_threshold"] =
+      std::to_string(gOFS->mListingPagedThreshold);
+  }
+
   fillNamespaceCacheConfig(gOFS->ConfEngine, namespaceConfig);
 
   if (!gOFS->namespaceGroup->initialize(&gOFS->eosViewRWMutex, namespaceConfig,
@@ -345,6 +371,8 @@ QdbMaster::SlaveToMaster()
 
   Quota::LoadNodes();
   EnableNsCaching();
+  // Warm up the caches in the background while serving requests
+  gOFS->namespaceGroup->startCacheWarmer();
   WFE::MoveFromRBackToQ();
   // Notify all the nodes about the new master identity
   FsView::gFsView.BroadcastMasterId(GetMasterId());
@@ -388,6 +416,8 @@ QdbMaster::MasterToSlave()
       std::chrono::milliseconds(100));
   // We are the slave, we just listen and don't broadcast anything
   gOFS->ObjectManager.EnableBroadCast(false);
+  // Snapshot the hot set before the caches are dropped
+  gOFS->namespaceGroup->stopCacheWarmer();
   DisableNsCaching();
 
   // When we boot the first time also load the config
@@ -24,23 +24,89 @@
 #include "common/Mapping.hh"
 #include "common/table_formatter/TableFormatterBase.hh"
 #include "mgm/Stat.hh"
+#include "mgm/Access.hh"
 #include "mgm/FsView.hh"
 #include "mgm/XrdMgmOfs.hh"
 #include "mq/XrdMqSharedObject.hh"
 #include "mgm/Quota.hh"
 #include "XrdOuc/XrdOucString.hh"
+#include <algorithm>
 
 EOSMGMNAMESPACE_BEGIN
 
+std::atomic<uint64_t> Stat::sInstanceCounter {0};
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+Stat::Stat():
+  mInstanceId(++sInstanceCounter)
+{}
+
+//------------------------------------------------------------------------------
+// Get the slab of the calling thread, register a new one if needed
+//------------------------------------------------------------------------------
+StatSlab*
+Stat::GetThreadSlab()
+{
+  // Usually there is only one Stat instance so this is a single entry
+  thread_local std::vector<std::pair<uint64_t, std::shared_ptr<StatSlab>>>
+      tl_slabs;
+
+  for (const auto& elem : tl_slabs) {
+    if (elem.first == mInstanceId) {
+      return elem.second.get();
+    }
+  }
+
+  auto slab = std::make_shared<StatSlab>();
+  {
+    std::unique_lock<std::mutex> lock(mSlabsMutex);
+    mSlabs.push_back(slab);
+  }
+  tl_slabs.emplace_back(mInstanceId, slab);
+  return slab.get();
+}
+
+//------------------------------------------------------------------------------
+// Get the id of the given tag, interning it if needed
+//------------------------------------------------------------------------------
+uint32_t
+Stat::GetTagId(StatSlab* slab, const char* tag)
+{
+  auto it = slab->mTagCache.find(tag);
+
+  if (it != slab->mTagCache.end()) {
+    return it->second;
+  }
+
+  uint32_t id = 0;
+  {
+    std::unique_lock<std::mutex> lock(mTagMutex);
+    auto res = mTagIds.emplace(tag, (uint32_t) mTagNames.size());
+
+    if (res.second) {
+      mTagNames.push_back(tag);
+    }
+
+    id = res.first->second;
+  }
+  slab->mTagCache.emplace(tag, id);
+  return id;
+}
+
 /*----------------------------------------------------------------------------*/
 void
 Stat::Add(const char* tag, uid_t uid, gid_t gid, unsigned long val)
 {
-  XrdSysMutexHelper lock(mMutex);
-  StatsUid[tag][uid] += val;
-  StatsGid[tag][gid] += val;
-  StatAvgUid[tag][uid].Add(val);
-  StatAvgGid[tag][gid].Add(val);
+  StatSlab* slab = GetThreadSlab();
+  StatSlab::Key key {GetTagId(slab, tag), uid, gid};
+  {
+    std::unique_lock<std::mutex> lock(slab->mMutex);
+    slab->mAdd[key] += val;
+  }
+  // Rate stall rules are enforced on the requests as they are accounted
+  Access::ChargeRateLimits(tag, uid, gid, val);
 }
 
 /*----------------------------------------------------------------------------*/
@@ -48,27 +114,137 @@ void
 Stat::AddExt(const char* tag, uid_t uid, gid_t gid, unsigned long nsample,
              const double& avgv, const double& minv, const double& maxv)
 {
-  XrdSysMutexHelper lock(mMutex);
-  StatExtUid[tag][uid].Insert(nsample, avgv, minv, maxv);
-  StatExtGid[tag][gid].Insert(nsample, avgv, minv, maxv);
+  StatSlab* slab = GetThreadSlab();
+  StatSlab::Key key {GetTagId(slab, tag), uid, gid};
+  std::unique_lock<std::mutex> lock(slab->mMutex);
+  StatSlab::ExtSample& ext = slab->mExt[key];
+  ext.mN += nsample;
+  ext.mSum += avgv * nsample;
+  ext.mMin = std::min(ext.mMin, minv);
+  ext.mMax = std::max(ext.mMax, maxv);
 }
 
 /*----------------------------------------------------------------------------*/
 void
 Stat::AddExec(const char* tag, float exectime)
 {
-  XrdSysMutexHelper lock(mMutex);
-  StatExec[tag].push_back(exectime);
+  StatSlab* slab = GetThreadSlab();
+  uint32_t tag_id = GetTagId(slab, tag);
+  std::unique_lock<std::mutex> lock(slab->mMutex);
+  std::deque<float>& samples = slab->mExec[tag_id];
+  samples.push_back(exectime);
 
   // we average over 100 entries
-  if (StatExec[tag].size() > 100) {
-    StatExec[tag].pop_front();
+  if (samples.size() > 100) {
+    samples.pop_front();
+  }
+}
+
+//------------------------------------------------------------------------------
+// Fold the updates accumulated in the per-thread slabs into the global maps
+//------------------------------------------------------------------------------
+void
+Stat::FoldThreadSlabs()
+{
+  std::vector<std::shared_ptr<StatSlab>> slabs;
+  {
+    std::unique_lock<std::mutex> lock(mSlabsMutex);
+    slabs = mSlabs;
   }
+  decltype(StatSlab::mAdd) add;
+  decltype(StatSlab::mExt) ext;
+  std::vector<std::pair<uint32_t, float>> exec;
+
+  // Writers are blocked only for the time it takes to grab their updates
+  for (const auto& slab : slabs) {
+    decltype(StatSlab::mAdd) slab_add;
+    decltype(StatSlab::mExt) slab_ext;
+    decltype(StatSlab::mExec) slab_exec;
+    {
+      std::unique_lock<std::mutex> lock(slab->mMutex);
+      std::swap(slab_add, slab->mAdd);
+      std::swap(slab_ext, slab->mExt);
+      std::swap(slab_exec, slab->mExec);
+    }
+
+    for (const auto& elem : slab_add) {
+      add[elem.first] += elem.second;
+    }
+
+    for (const auto& elem : slab_ext) {
+      StatSlab::ExtSample& sample = ext[elem.first];
+      sample.mN += elem.second.mN;
+      sample.mSum += elem.second.mSum;
+      sample.mMin = std::min(sample.mMin, elem.second.mMin);
+      sample.mMax = std::max(sample.mMax, elem.second.mMax);
+    }
+
+    for (const auto& elem : slab_exec) {
+      for (const auto& val : elem.second) {
+        exec.emplace_back(elem.first, val);
+      }
+    }
+  }
+
+  std::vector<std::string> tag_names;
+  {
+    std::unique_lock<std::mutex> lock(mTagMutex);
+    tag_names = mTagNames;
+  }
+  {
+    XrdSysMutexHelper lock(mMutex);
+
+    for (const auto& elem : add) {
+      const std::string& tag = tag_names[elem.first.mTagId];
+      StatsUid[tag][elem.first.mUid] += elem.second;
+      StatsGid[tag][elem.first.mGid] += elem.second;
+      StatAvgUid[tag][elem.first.mUid].Add(elem.second);
+      StatAvgGid[tag][elem.first.mGid].Add(elem.second);
+    }
+
+    for (const auto& elem : ext) {
+      const std::string& tag = tag_names[elem.first.mTagId];
+      double avg = (elem.second.mN ? elem.second.mSum / elem.second.mN : 0);
+      StatExtUid[tag][elem.first.mUid].Insert(elem.second.mN, avg,
+                                              elem.second.mMin, elem.second.mMax);
+      StatExtGid[tag][elem.first.mGid].Insert(elem.second.mN, avg,
+                                              elem.second.mMin, elem.second.mMax);
+    }
+
+    for (const auto& elem : exec) {
+      std::deque<float>& samples = StatExec[tag_names[elem.first]];
+      samples.push_back(elem.second);
+
+      // we average over 100 entries
+      if (samples.size() > 100) {
+        samples.pop_front();
+      }
+    }
+  }
+  // Drop the slabs of threads which exited, they were folded above and
+  // nobody else can write into them anymore
+  std::unique_lock<std::mutex> lock(mSlabsMutex);
+  slabs.clear();
+  mSlabs.erase(std::remove_if(mSlabs.begin(), mSlabs.end(),
+  [](const std::shared_ptr<StatSlab>& slab) {
+    return (slab.use_count() == 1);
+  }), mSlabs.end());
 }
 
 /*----------------------------------------------------------------------------*/
 unsigned long long
 Stat::GetTotal(const char* tag)
+{
+  FoldThreadSlabs();
+  XrdSysMutexHelper lock(mMutex);
+  return GetTotalNoLock(tag);
+}
+
+/*----------------------------------------------------------------------------*/
+// warning: you have to lock the mutex if directly used
+
+unsigned long long
+Stat::GetTotalNoLock(const char* tag)
 {
   google::sparse_hash_map<uid_t, unsigned long long>::const_iterator it;
   unsigned long long val = 0;
@@ -416,11 +592,20 @@ Stat::GetTotalMaxExt60(const char* tag)
 }
 
 
+/*----------------------------------------------------------------------------*/
+double
+Stat::GetTotalAvg5(const char* tag)
+{
+  FoldThreadSlabs();
+  XrdSysMutexHelper lock(mMutex);
+  return GetTotalAvg5NoLock(tag);
+}
+
 /*----------------------------------------------------------------------------*/
 // warning: you have to lock the mutex if directly used
 
 double
-Stat::GetTotalAvg5(const char* tag)
+Stat::GetTotalAvg5NoLock(const char* tag)
 {
   google::sparse_hash_map<uid_t, StatAvg>::iterator it;
   double val = 0;
@@ -608,6 +793,7 @@ Stat::GetTotalExec(double& deviation)
 void
 Stat::Clear()
 {
+  FoldThreadSlabs();
   XrdSysMutexHelper lock(mMutex);
 
   for (auto ittag = StatsUid.begin(); ittag != StatsUid.end(); ittag++) {
@@ -629,6 +815,7 @@ void
 Stat::PrintOutTotal(XrdOucString& out, bool details, bool monitoring,
                     bool numerical)
 {
+  FoldThreadSlabs();
   mMutex.Lock();
   std::vector<std::string> tags, tags_ext;
   std::vector<std::string>::iterator it;
@@ -711,8 +898,8 @@ Stat::PrintOutTotal(XrdOucString& out, bool details, bool monitoring,
     }
 
     table_data.back().push_back(TableCell(tag, format_cmd));
-    table_data.back().push_back(TableCell(GetTotal(tag), format_l));
-    table_data.back().push_back(TableCell(GetTotalAvg5(tag), format_f));
+    table_data.back().push_back(TableCell(GetTotalNoLock(tag), format_l));
+    table_data.back().push_back(TableCell(GetTotalAvg5NoLock(tag), format_f));
     table_data.back().push_back(TableCell(GetTotalAvg60(tag), format_f));
     table_data.back().push_back(TableCell(GetTotalAvg300(tag), format_f));
     table_data.back().push_back(TableCell(GetTotalAvg3600(tag), format_f));
@@ -1219,6 +1406,7 @@ Stat::Circulate(ThreadAssistant& assistant) noexcept
     l1 = l1tmp;
     l2 = l2tmp;
     l3 = l3tmp;
+    FoldThreadSlabs();
     XrdSysMutexHelper lock(mMutex);
     time_t now = time(NULL);
 
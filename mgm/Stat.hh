@@ -31,6 +31,12 @@
 #include <map>
 #include <string>
 #include <deque>
+#include <mutex>
+#include <memory>
+#include <atomic>
+#include <chrono>
+#include <unordered_map>
+#include <limits>
 #include <math.h>
 
 EOSMGMNAMESPACE_BEGIN
@@ -476,15 +482,55 @@ public:
 };
 
 
-#define EXEC_TIMING_BEGIN(__ID__)               \
-  struct timeval start__ID__;                   \
-  struct timeval stop__ID__;                    \
-  struct timezone tz__ID__;                     \
-  gettimeofday(&start__ID__, &tz__ID__);
+#define EXEC_TIMING_BEGIN(__ID__)                                       \
+  auto start__ID__ = std::chrono::steady_clock::now();
 
 #define EXEC_TIMING_END(__ID__)                                         \
-  gettimeofday(&stop__ID__, &tz__ID__);                                 \
-  gOFS->MgmStats.AddExec(__ID__, ((stop__ID__.tv_sec-start__ID__.tv_sec)*1000.0) + ((stop__ID__.tv_usec-start__ID__.tv_usec)/1000.0) );
+  gOFS->MgmStats.AddExec(__ID__, std::chrono::duration<float, std::milli> \
+                         (std::chrono::steady_clock::now() - start__ID__).count());
+
+//------------------------------------------------------------------------------
+//! Per-thread staging area for statistics updates. Only the owning thread
+//! writes into it, the mutex is contended only by the thread folding the
+//! slabs into the global maps.
+//------------------------------------------------------------------------------
+struct alignas(64) StatSlab {
+  //! Key made of tag id, uid and gid
+  struct Key {
+    uint32_t mTagId;
+    uid_t mUid;
+    gid_t mGid;
+
+    bool operator==(const Key& other) const
+    {
+      return ((mTagId == other.mTagId) && (mUid == other.mUid) &&
+              (mGid == other.mGid));
+    }
+  };
+
+  struct KeyHash {
+    size_t operator()(const Key& key) const
+    {
+      return std::hash<uint64_t>()((((uint64_t)key.mUid) << 32) | key.mGid) ^
+             (((size_t)key.mTagId) * 0x9e3779b97f4a7c15ull);
+    }
+  };
+
+  //! Accumulated extended samples
+  struct ExtSample {
+    unsigned long mN {0};
+    double mSum {0};
+    double mMin {std::numeric_limits<double>::max()};
+    double mMax {std::numeric_limits<double>::lowest()};
+  };
+
+  std::mutex mMutex; ///< Protects the containers below
+  std::unordered_map<Key, unsigned long, KeyHash> mAdd;
+  std::unordered_map<Key, ExtSample, KeyHash> mExt;
+  std::unordered_map<uint32_t, std::deque<float>> mExec;
+  //! Tag name to id cache accessed only by the owning thread
+  std::unordered_map<std::string, uint32_t> mTagCache;
+};
 
 class Stat
 {
@@ -506,6 +552,16 @@ public:
   StatExtGid;
   google::sparse_hash_map<std::string, std::deque<float> > StatExec;
 
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //----------------------------------------------------------------------------
+  Stat();
+
+  //----------------------------------------------------------------------------
+  //! Add/AddExt/AddExec only update the per-thread slab of the caller and
+  //! never take mMutex. The updates become visible in the maps above once
+  //! they are folded by FoldThreadSlabs.
+  //----------------------------------------------------------------------------
   void Add(const char* tag, uid_t uid, gid_t gid, unsigned long val);
 
   void AddExt(const char* tag, uid_t uid, gid_t gid, unsigned long nsample,
@@ -513,7 +569,15 @@ public:
 
   void AddExec(const char* tag, float exectime);
 
+  //----------------------------------------------------------------------------
+  //! Fold the updates accumulated in all the per-thread slabs into the maps
+  //! protected by mMutex. Called periodically by Circulate and before
+  //! printing out the statistics.
+  //----------------------------------------------------------------------------
+  void FoldThreadSlabs();
+
   unsigned long long GetTotal(const char* tag);
+  unsigned long long GetTotalNoLock(const char* tag);
 
   // warning: you have to lock the mutex if directly used
   double GetTotalAvg3600(const char* tag);
@@ -536,8 +600,9 @@ public:
   double GetTotalMinExt60(const char* tag);
   double GetTotalMaxExt60(const char* tag);
 
-  // warning: you have to lock the mutex if directly used
   double GetTotalAvg5(const char* tag);
+  // warning: you have to lock the mutex if directly used
+  double GetTotalAvg5NoLock(const char* tag);
   double GetTotalNExt5(const char* tag);
   double GetTotalAvgExt5(const char* tag);
   double GetTotalMinExt5(const char* tag);
@@ -557,6 +622,25 @@ public:
   void Circulate(ThreadAssistant& assistant) noexcept;
 
   ~Stat() = default;
+
+private:
+  //----------------------------------------------------------------------------
+  //! Get the slab of the calling thread, register a new one if needed
+  //----------------------------------------------------------------------------
+  StatSlab* GetThreadSlab();
+
+  //----------------------------------------------------------------------------
+  //! Get the id of the given tag, interning it if needed
+  //----------------------------------------------------------------------------
+  uint32_t GetTagId(StatSlab* slab, const char* tag);
+
+  static std::atomic<uint64_t> sInstanceCounter; ///< Used to tell instances apart
+  const uint64_t mInstanceId; ///< Id of the current instance
+  std::mutex mSlabsMutex; ///< Protects the list of slabs
+  std::vector<std::shared_ptr<StatSlab>> mSlabs; ///< Slabs of all threads
+  std::mutex mTagMutex; ///< Protects the tag interning tables
+  std::unordered_map<std::string, uint32_t> mTagIds; ///< Tag name to id
+  std::vector<std::string> mTagNames; ///< Tag id to name
 };
 
 EOSMGMNAMESPACE_END
@@ -43,6 +43,7 @@
 #include "namespace/utils/Checksum.hh"
 #include "namespace/utils/RenameSafetyCheck.hh"
 #include "namespace/utils/Attributes.hh"
+#include "namespace/utils/HierarchicalLockManager.hh"
 #include "grpc/GrpcServer.hh"
 #include "mgm/AdminSocket.hh"
 #include "mgm/Stat.hh"
@@ -313,6 +314,11 @@ XrdMgmOfs::XrdMgmOfs(XrdSysError* ep):
     mGRPCPort = strtol(getenv("EOS_MGM_GRPC_PORT"), 0, 10);
   }
 
+  if (getenv("EOS_MGM_LISTING_PAGED_THRESHOLD")) {
+    mListingPagedThreshold = strtoull(getenv("EOS_MGM_LISTING_PAGED_THRESHOLD"),
+                                      0, 10);
+  }
+
   if (getenv("EOS_MGM_FUSE_BOOKING_SIZE")) {
     mFusePlacementBooking = strtol(getenv("EOS_MGM_FUSE_BOOKING_SIZE"), 0, 10);
   } else {
@@ -367,6 +373,7 @@ XrdMgmOfs::OrderlyShutdown()
     eos_warning("%s", "msg=\"set stall rule of all ns operations\"");
     eos::common::RWMutexWriteLock lock(Access::gAccessMutex);
     Access::gStallRules[std::string("*")] = "300";
+    Access::CompileStallState();
   }
   gOFS->mTracker.SetAcceptingRequests(false);
   gOFS->mTracker.SpinUntilNoRequestsInFlight(true,
@@ -487,6 +494,8 @@ XrdMgmOfs::OrderlyShutdown()
   }
 
   if (gOFS->mNamespaceState == NamespaceState::kBooted) {
+    eos_warning("%s", "msg=\"saving the namespace cache snapshot\"");
+    gOFS->namespaceGroup->stopCacheWarmer();
     eos_warning("%s", "msg=\"finalizing namespace views\"");
 
     try {
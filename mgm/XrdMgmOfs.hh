@@ -1857,6 +1857,9 @@ public:
   int mHttpdPort; ///< port of the http server, default 8000
   int mFusexPort; ///< port of the FUSEX broadcast MQZ, default 1100
   int mGRPCPort; ///< port of the GRPC server, default 50051
+  //! Directories in QuarkDB with at least this many entries are listed in
+  //! pages without loading them into the metadata cache, 0 disables it
+  uint64_t mListingPagedThreshold {0};
   eos::common::XrdConnPool mXrdConnPool; ///< XRD connection pool
   //! Tracker for requests which are currently executing MGM code
   eos::mgm::InFlightTracker mTracker;
@@ -110,6 +110,11 @@ XrdMgmOfs::_mkdir(const char* path,
   eos::common::Path cPath(path);
   bool noParent = false;
   std::shared_ptr<eos::IContainerMD> dir;
+  // With a per-container lock manager the creation only needs the namespace
+  // read lock plus the exclusive lock of the parent container, so mkdirs in
+  // different directories no longer serialize on the namespace mutex
+  eos::HierarchicalLockManager* cont_locks =
+    gOFS->namespaceGroup->getContainerLockManager();
   eos::IContainerMD::XAttrMap attrmap;
   {
     eos::Prefetcher::prefetchContainerMDAndWait(gOFS->eosView, cPath.GetParentPath());
@@ -334,14 +339,26 @@ XrdMgmOfs::_mkdir(const char* path,
       eos::common::Path tmp_path("");
 
       for (j = i + 1; j < (int) cPath.GetSubPathSize(); ++j) {
-        eos::common::RWMutexWriteLock lock(gOFS->eosViewRWMutex, __FUNCTION__, __LINE__,
-                                           __FILE__);
+        eos::common::RWMutexWriteLock ns_wr_lock;
+        eos::common::RWMutexReadLock ns_rd_lock;
+        eos::HierarchicalLockManager::PathLock cont_lock;
+
+        if (cont_locks) {
+          ns_rd_lock.Grab(gOFS->eosViewRWMutex, __FUNCTION__, __LINE__, __FILE__);
+        } else {
+          ns_wr_lock.Grab(gOFS->eosViewRWMutex, __FUNCTION__, __LINE__, __FILE__);
+        }
 
         try {
           errno = 0;
           eos_debug("creating path %s", cPath.GetSubPath(j));
           tmp_path.Init(cPath.GetSubPath(j));
           dir = eosView->getContainer(tmp_path.GetParentPath());
+
+          if (cont_locks) {
+            cont_lock = cont_locks->writeLock(dir->getId());
+          }
+
           newdir = eosView->createContainer(cPath.GetSubPath(j), recurse);
           newdir->setCUid(vid.uid);
           newdir->setCGid(vid.gid);
@@ -371,7 +388,9 @@ XrdMgmOfs::_mkdir(const char* path,
           eos::ContainerIdentifier nd_id = newdir->getIdentifier();
           eos::ContainerIdentifier d_id = dir->getIdentifier();
           eos::ContainerIdentifier d_pid = dir->getParentIdentifier();
-          lock.Release();
+          cont_lock.release();
+          ns_rd_lock.Release();
+          ns_wr_lock.Release();
           gOFS->FuseXCastContainer(nd_id);
           gOFS->FuseXCastContainer(d_id);
           gOFS->FuseXCastRefresh(d_id, d_pid);
@@ -399,12 +418,24 @@ XrdMgmOfs::_mkdir(const char* path,
     return Emsg(epname, error, errno, "mkdir", path);
   }
 
-  eos::common::RWMutexWriteLock lock(gOFS->eosViewRWMutex, __FUNCTION__, __LINE__,
-                                     __FILE__);
+  eos::common::RWMutexWriteLock ns_wr_lock;
+  eos::common::RWMutexReadLock ns_rd_lock;
+  eos::HierarchicalLockManager::PathLock cont_lock;
+
+  if (cont_locks) {
+    ns_rd_lock.Grab(gOFS->eosViewRWMutex, __FUNCTION__, __LINE__, __FILE__);
+  } else {
+    ns_wr_lock.Grab(gOFS->eosViewRWMutex, __FUNCTION__, __LINE__, __FILE__);
+  }
 
   try {
     errno = 0;
     dir = eosView->getContainer(cPath.GetParentPath());
+
+    if (cont_locks) {
+      cont_lock = cont_locks->writeLock(dir->getId());
+    }
+
     newdir = eosView->createContainer(path);
     newdir->setCUid(vid.uid);
     newdir->setCGid(vid.gid);
@@ -444,7 +475,9 @@ XrdMgmOfs::_mkdir(const char* path,
     eos::ContainerIdentifier nd_id = newdir->getIdentifier();
     eos::ContainerIdentifier d_id = dir->getIdentifier();
     eos::ContainerIdentifier d_pid = dir->getParentIdentifier();
-    lock.Release();
+    cont_lock.release();
+    ns_rd_lock.Release();
+    ns_wr_lock.Release();
     gOFS->FuseXCastContainer(nd_id);
     gOFS->FuseXCastContainer(d_id);
     gOFS->FuseXCastRefresh(d_id, d_pid);
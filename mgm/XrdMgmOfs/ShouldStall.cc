@@ -48,12 +48,13 @@ XrdMgmOfs::ShouldStall(const char* function,
     stall = false;
   }
 
-  eos::common::RWMutexReadLock lock(Access::gAccessMutex);
+  // The rules are read from an immutable copy, no lock is taken per request
+  auto state = Access::GetStallState();
   std::string stallid = "Stall";
 
   if (stall) {
     if ((vid.uid > 3)) {
-      if (Access::gBannedUsers.count(vid.uid)) {
+      if (state->mBannedUsers.count(vid.uid)) {
         smsg = "operate - you are banned in this instance - contact an administrator";
 
         // fuse clients don't get stalled by a booted namespace, they get EACCES
@@ -64,7 +65,7 @@ XrdMgmOfs::ShouldStall(const char* function,
 
         // BANNED USER
         stalltime = 300;
-      } else if (Access::gBannedGroups.count(vid.gid)) {
+      } else if (state->mBannedGroups.count(vid.gid)) {
         smsg = "operate - your group is banned in this instance - contact an administrator";
 
         // fuse clients don't get stalled by a booted namespace, they get EACCES
@@ -75,120 +76,56 @@ XrdMgmOfs::ShouldStall(const char* function,
 
         // BANNED GROUP
         stalltime = 300;
-      } else if (Access::gBannedHosts.count(vid.host)) {
+      } else if (state->mBannedHosts.count(vid.host)) {
         smsg = "operate - your client host is banned in this instance - contact an administrator";
         // BANNED HOST
         stalltime = 300;
-      } else if (Access::gBannedDomains.count(vid.domain)) {
+      } else if (state->mBannedDomains.count(vid.domain)) {
         smsg = "operate - your client domain is banned in this instance - contact an administrator";
         // BANNED DOMAINS
         stalltime = 300;
-      } else if (Access::gStallRules.size() && (Access::gStallGlobal)) {
+      } else if (state->mHasRules && state->mStallGlobal) {
         // GLOBAL STALL
-        stalltime = atoi(Access::gStallRules[std::string("*")].c_str());
-        smsg = Access::gStallComment[std::string("*")];
-      } else if ((IS_ACCESSMODE_R && (Access::gStallRead)) ||
-                 (IS_ACCESSMODE_R_MASTER && (Access::gStallRead))) {
+        stalltime = state->mGlobalDelay;
+        smsg = state->mGlobalComment;
+      } else if ((IS_ACCESSMODE_R && (state->mStallRead)) ||
+                 (IS_ACCESSMODE_R_MASTER && (state->mStallRead))) {
         // READ STALL
-        stalltime = atoi(Access::gStallRules[std::string("r:*")].c_str());
-        smsg = Access::gStallComment[std::string("r:*")];
-      } else if (IS_ACCESSMODE_W && (Access::gStallWrite)) {
-        stalltime = atoi(Access::gStallRules[std::string("w:*")].c_str());
-        smsg = Access::gStallComment[std::string("w:*")];
-      } else if (Access::gStallUserGroup) {
-        std::string usermatch = "rate:user:";
-        usermatch += vid.uid_string;
-        std::string groupmatch = "rate:group:";
-        groupmatch += vid.gid_string;
-        std::string userwildcardmatch = "rate:user:*";
-        std::string groupwildcardmatch = "rate:group:*";
-        std::map<std::string, std::string>::const_iterator it;
-
+        stalltime = state->mReadDelay;
+        smsg = state->mReadComment;
+      } else if (IS_ACCESSMODE_W && (state->mStallWrite)) {
+        stalltime = state->mWriteDelay;
+        smsg = state->mWriteComment;
+      } else if (state->mStallUserGroup) {
         if ((functionname != "stat") &&  // never stall stats
             (vid.app != "fuse::restic")) {
-          for (it = Access::gStallRules.begin();
-               it != Access::gStallRules.end();
-               it++) {
-            stallid = "Stall";
-            auto eosxd_pos = it->first.rfind("Eosxd");
-            auto pos = it->first.rfind(":");
-            std::string cmd = (eosxd_pos != std::string::npos) ?
-                              it->first.substr(eosxd_pos) : it->first.substr(pos + 1);
-            stallid += "::";
-            stallid += cmd;
-
+          int64_t now_ns = Access::RateClockNs();
+          const Access::RateLimitRule* rule = state->mRateRules.FindRule(vid.uid,
+          vid.gid, [&](const Access::RateLimitRule * candidate) {
             if (EOS_LOGS_DEBUG) {
-              eos_static_debug("rule=%s function=%s", cmd.c_str(), function);
+              eos_static_debug("rule=%s function=%s", candidate->mCmd.c_str(),
+                               function);
             }
 
             // only Eosxd rates can be fine-grained by function
-            if (cmd.substr(0, 5) == "Eosxd") {
-              if (cmd != function) {
-                continue;
-              }
+            if (candidate->mIsEosxd && (candidate->mCmd != functionname)) {
+              return false;
             }
 
-            double cutoff = strtod(it->second.c_str(), 0) * 1.33;
-
-            if ((it->first.find(userwildcardmatch) == 0)) {
-              // catch all rule = global user rate cut
-              XrdSysMutexHelper statLock(gOFS->MgmStats.mMutex);
-
-              if (gOFS->MgmStats.StatAvgUid.count(cmd) &&
-                  gOFS->MgmStats.StatAvgUid[cmd].count(vid.uid) &&
-                  (gOFS->MgmStats.StatAvgUid[cmd][vid.uid].GetAvg5() > cutoff)) {
-                if (!stalltime) {
-                  stalltime = 5;
-                }
-
-                smsg = Access::gStallComment[it->first];
-                break;
-              }
-            } else if ((it->first.find(groupwildcardmatch) == 0)) {
-              // catch all rule = global user rate cut
-              XrdSysMutexHelper statLock(gOFS->MgmStats.mMutex);
-
-              if (gOFS->MgmStats.StatAvgGid.count(cmd) &&
-                  gOFS->MgmStats.StatAvgGid[cmd].count(vid.gid) &&
-                  (gOFS->MgmStats.StatAvgGid[cmd][vid.gid].GetAvg5() > cutoff)) {
-                if (!stalltime) {
-                  stalltime = 5;
-                }
-
-                smsg = Access::gStallComment[it->first];
-                break;
-              }
-            } else if ((it->first.find(usermatch) == 0)) {
-              // check user rule
-              XrdSysMutexHelper statLock(gOFS->MgmStats.mMutex);
-
-              if (gOFS->MgmStats.StatAvgUid.count(cmd) &&
-                  gOFS->MgmStats.StatAvgUid[cmd].count(vid.uid) &&
-                  (gOFS->MgmStats.StatAvgUid[cmd][vid.uid].GetAvg5() > cutoff)) {
-                // rate exceeded
-                if (!stalltime) {
-                  stalltime = 5;
-                }
-
-                smsg = Access::gStallComment[it->first];
-                break;
-              }
-            } else if ((it->first.find(groupmatch) == 0)) {
-              // check group rule
-              XrdSysMutexHelper statLock(gOFS->MgmStats.mMutex);
-
-              if (gOFS->MgmStats.StatAvgGid.count(cmd) &&
-                  gOFS->MgmStats.StatAvgGid[cmd].count(vid.gid) &&
-                  (gOFS->MgmStats.StatAvgGid[cmd][vid.gid].GetAvg5() > cutoff)) {
-                // rate exceeded
-                if (!stalltime) {
-                  stalltime = 5;
-                }
-
-                smsg = Access::gStallComment[it->first];
-                break;
-              }
+            return candidate->Exceeded(candidate->mIsUser ? vid.uid : vid.gid,
+                                       now_ns);
+          });
+
+          if (rule) {
+            // rate exceeded
+            ++rule->mThrottled;
+
+            if (!stalltime) {
+              stalltime = 5;
             }
+
+            stallid = rule->mStallId;
+            smsg = rule->mComment;
           }
         }
       }
@@ -208,13 +145,12 @@ XrdMgmOfs::ShouldStall(const char* function,
         return true;
       }
     } else {
-      if (Access::gStallRules.size() &&
-          Access::gStallRules.count(std::string("*"))) {
+      if (state->mHasGlobalRule) {
         if ((vid.host != "localhost.localdomain") &&
             (vid.host != "localhost")) {
           // admin/root is only stalled for global stalls not,
           // for write-only or read-only stalls
-          stalltime = atoi(Access::gStallRules[std::string("*")].c_str());
+          stalltime = state->mGlobalDelay;
           stallmsg = "Attention: you are currently hold in this instance and each"
                      " request is stalled for ";
           stallmsg += (int) stalltime;
@@ -34,6 +34,9 @@
 #include "namespace/interface/IView.hh"
 #include "namespace/Prefetcher.hh"
 #include "namespace/interface/ContainerIterators.hh"
+#include "namespace/ns_quarkdb/NamespaceGroup.hh"
+#include "namespace/ns_quarkdb/persistency/ContainerListing.hh"
+#include "namespace/ns_quarkdb/persistency/MetadataFetcher.hh"
 #include "XrdOuc/XrdOucEnv.hh"
 
 #ifdef __APPLE__
@@ -129,6 +132,42 @@ XrdMgmOfsDirectory::open(const char* inpath,
   return _open(path, vid, ininfo);
 }
 
+//------------------------------------------------------------------------------
+// Get the metadata, without the entries, of a directory to be listed in pages
+//------------------------------------------------------------------------------
+static std::shared_ptr<eos::IContainerMD>
+GetLargeContainer(eos::common::Path& cPath, uint64_t& num_entries)
+{
+  if (!gOFS->mListingPagedThreshold || !gOFS->NsInQDB ||
+      !strcmp(cPath.GetPath(), "/")) {
+    return nullptr;
+  }
+
+  auto* qdb_group = static_cast<eos::QuarkNamespaceGroup*>
+                    (gOFS->namespaceGroup.get());
+  qclient::QClient& qcl = *qdb_group->getQClient();
+
+  try {
+    eos::IContainerMD::id_t parent_id;
+    {
+      eos::common::RWMutexReadLock lock(gOFS->eosViewRWMutex, __FUNCTION__,
+                                        __LINE__, __FILE__);
+      parent_id = gOFS->eosView->getContainer(cPath.GetParentPath())->getId();
+    }
+    // Point query, the parent knows the id without loading the directory
+    eos::ContainerIdentifier id = eos::MetadataFetcher::getContainerIDFromName(
+                                    qcl, eos::ContainerIdentifier(parent_id), cPath.GetName()).get();
+    eos::ContainerListing::LargeContainer large =
+      eos::ContainerListing::getLargeContainer(qcl, id,
+          gOFS->mListingPagedThreshold).get();
+    num_entries = large.numFiles + large.numContainers;
+    return large.container;
+  } catch (eos::MDException& e) {
+    // Let the regular lookup handle e.g. symbolic links and report errors
+    return nullptr;
+  }
+}
+
 //------------------------------------------------------------------------------
 // Open a directory - low-level interface
 //------------------------------------------------------------------------------
@@ -155,17 +194,30 @@ XrdMgmOfsDirectory::_open(const char* dir_path,
   XrdOucEnv env(info);
   // Open the directory
   bool permok = false;
-  eos::Prefetcher::prefetchContainerMDWithChildrenAndWait(gOFS->eosView,
-      cPath.GetPath());
+  uint64_t num_entries = 0;
+  // Large directories are listed in pages without loading them
+  std::shared_ptr<eos::IContainerMD> dh = GetLargeContainer(cPath, num_entries);
+
+  if (!dh) {
+    eos::Prefetcher::prefetchContainerMDWithChildrenAndWait(gOFS->eosView,
+        cPath.GetPath());
+  }
+
   //----------------------------------------------------------------------------
-  std::shared_ptr<eos::IContainerMD> dh;
   eos::common::RWMutexReadLock lock(gOFS->eosViewRWMutex, __FUNCTION__, __LINE__, __FILE__);
 
   std::string cacheentry;
 
   try {
     eos::IContainerMD::XAttrMap attrmap;
-    dh = gOFS->eosView->getContainer(cPath.GetPath());
+
+    if (dh) {
+      mPagedId = dh->getId();
+    } else {
+      dh = gOFS->eosView->getContainer(cPath.GetPath());
+      num_entries = dh->getNumContainers() + dh->getNumFiles();
+    }
+
     eos::IFileMD::ctime_t mtime;
     dh->getMTime(mtime);
 
@@ -192,12 +244,28 @@ XrdMgmOfsDirectory::_open(const char* dir_path,
 
     if (permok) {
       // Add all the files and subdirectories
-      gOFS->MgmStats.Add("OpenDir-Entry", vid.uid, vid.gid,
-                         dh->getNumContainers() + dh->getNumFiles());
+      gOFS->MgmStats.Add("OpenDir-Entry", vid.uid, vid.gid, num_entries);
       std::unique_lock<std::mutex> scope_lock(mDirLsMutex);
 
-      // try to get the listing from the cache
-      if (!use_cache || !dirCache.tryGet(cacheentry, dh_list)) {
+      if (mPagedId) {
+        // Only the dot entries are kept in dh_list, the rest is fetched in
+        // pages by nextEntry
+        mPagedFiles = !env.Get("ls.skip.files");
+        mPagedDirs = !env.Get("ls.skip.directories");
+        mPageCursor.clear();
+        mPageMore = mPagedFiles || mPagedDirs;
+        mPage.clear();
+        mPagePos = 0;
+        dh_list = std::make_shared<listing_t>();
+
+        if (mPagedDirs) {
+          dh_list->insert(".");
+
+          if (strcmp(dir_path, "/")) {
+            dh_list->insert("..");
+          }
+        }
+      } else if (!use_cache || !dirCache.tryGet(cacheentry, dh_list)) {
 	dh_list = std::make_shared<listing_t>();
 	if (!env.Get("ls.skip.files")) {
 	  // Collect all file names
@@ -220,7 +288,7 @@ XrdMgmOfsDirectory::_open(const char* dir_path,
       }
 
       dh_it = dh_list->begin();
-      if (use_cache) {
+      if (use_cache && !mPagedId) {
 	dirCache.insert(cacheentry, dh_list); // cache listing
       }
     }
@@ -265,16 +333,98 @@ XrdMgmOfsDirectory::nextEntry()
 {
   std::unique_lock<std::mutex> scope_lock(mDirLsMutex);
 
-  if ( (!dh_list) ||
-       (dh_list->empty()) ||
-       (dh_it == dh_list->end()) ) {
+  if (!dh_list) {
+    return (const char*) 0;
+  }
+
+  if (dh_it != dh_list->end()) {
+    const char* name = dh_it->c_str();
+    ++dh_it;
+    mLastId = eos::FileOrContainerIdentifier();
+    return name;
+  }
+
+  if (!mPagedId) {
     // No more entries
     return (const char*) 0;
   }
 
-  const char* name = dh_it->c_str();
-  ++dh_it;
-  return name;
+  while (mPagePos == mPage.size()) {
+    if (!mPageMore || !fetchPage()) {
+      return (const char*) 0;
+    }
+  }
+
+  const auto& entry = mPage[mPagePos++];
+  mLastId = entry.second;
+  return entry.first.c_str();
+}
+
+//------------------------------------------------------------------------------
+// Skip the directory entries up to the given name
+//------------------------------------------------------------------------------
+void
+XrdMgmOfsDirectory::seekAfter(const std::string& name)
+{
+  std::unique_lock<std::mutex> scope_lock(mDirLsMutex);
+
+  if (!dh_list) {
+    return;
+  }
+
+  dh_it = dh_list->upper_bound(name);
+
+  if (mPagedId) {
+    mPageCursor = eos::ContainerListing::encodeCursor(name);
+    mPageMore = mPagedFiles || mPagedDirs;
+    mPage.clear();
+    mPagePos = 0;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Get identifier of the entry last returned by nextEntry
+//------------------------------------------------------------------------------
+eos::FileOrContainerIdentifier
+XrdMgmOfsDirectory::lastEntryId()
+{
+  std::unique_lock<std::mutex> scope_lock(mDirLsMutex);
+  return mLastId;
+}
+
+//------------------------------------------------------------------------------
+// Fetch the next page of a directory listed in pages
+//------------------------------------------------------------------------------
+bool
+XrdMgmOfsDirectory::fetchPage()
+{
+  auto* qdb_group = static_cast<eos::QuarkNamespaceGroup*>
+                    (gOFS->namespaceGroup.get());
+
+  try {
+    eos::ContainerListing::Page page = eos::ContainerListing::getPage(
+                                         *qdb_group->getQClient(), eos::ContainerIdentifier(mPagedId),
+                                         mPageCursor, eos::ContainerListing::kDefaultPageSize,
+                                         mPagedFiles, mPagedDirs).get();
+    mPage.clear();
+    mPagePos = 0;
+
+    for (auto& entry : page.entries) {
+      mPage.emplace_back(std::move(entry.name), entry.id);
+    }
+
+    mPageCursor = std::move(page.cursor);
+    mPageMore = !mPageCursor.empty();
+  } catch (eos::MDException& e) {
+    mPageMore = false;
+    error.setErrInfo(e.getErrno(), e.getMessage().str().c_str());
+    eos_err("msg=\"failed to fetch listing page\" id=%llu ec=%d emsg=\"%s\"",
+            (unsigned long long) mPagedId, e.getErrno(),
+            e.getMessage().str().c_str());
+    return false;
+  }
+
+  return true;
 }
 
 //------------------------------------------------------------------------------
@@ -285,6 +435,8 @@ XrdMgmOfsDirectory::close()
 {
   std::unique_lock<std::mutex> scope_lock(mDirLsMutex);
   dh_list = nullptr;
+  mPagedId = 0;
+  mPage.clear();
   return SFS_OK;
 }
 
@@ -29,10 +29,12 @@
 #include "XrdOuc/XrdOucErrInfo.hh"
 #include "XrdSec/XrdSecEntity.hh"
 #include "XrdSfs/XrdSfsInterface.hh"
+#include "namespace/interface/Identifiers.hh"
 #include <dirent.h>
 #include <string>
 #include <set>
 #include <mutex>
+#include <vector>
 
 //! Forward declaration
 namespace eos
@@ -66,7 +68,9 @@ public:
   //! @return SFS_OK otherwise SFS_ERROR
   //!
   //! @note We create during the open the full directory listing which then is
-  //! retrieved via nextEntry() and cleaned up with close().
+  //! retrieved via nextEntry() and cleaned up with close(). Directories in
+  //! QuarkDB above the paged listing threshold are instead fetched in pages
+  //! while nextEntry() walks through them.
   //----------------------------------------------------------------------------
   int open(const char* dirName, const XrdSecClientName* client = 0,
            const char* opaque = 0);
@@ -96,6 +100,23 @@ public:
   // ---------------------------------------------------------------------------
   const char* nextEntry();
 
+  //----------------------------------------------------------------------------
+  //! Skip the directory entries up to the given name, the following calls to
+  //! nextEntry return only the entries sorting after it
+  //!
+  //! @param name entry name, not necessarily existing
+  //----------------------------------------------------------------------------
+  void seekAfter(const std::string& name);
+
+  //----------------------------------------------------------------------------
+  //! Get identifier of the entry last returned by nextEntry. It is known only
+  //! for directories listed in pages, which saves the caller a lookup by path
+  //! loading the whole directory.
+  //!
+  //! @return identifier, empty if not known
+  //----------------------------------------------------------------------------
+  eos::FileOrContainerIdentifier lastEntryId();
+
   //----------------------------------------------------------------------------
   //! Create an error message
   //!
@@ -146,4 +167,22 @@ private:
   shared_ptr<listing_t> dh_list;
   listing_t::const_iterator dh_it;
   std::mutex mDirLsMutex; ///< Mutex protecting access to dh_list
+  //! Id of the directory if its entries are listed in pages, otherwise 0
+  uint64_t mPagedId {0};
+  bool mPagedFiles {true}; ///< Paged listing includes files
+  bool mPagedDirs {true}; ///< Paged listing includes subdirectories
+  //! Cursor of the next page, empty for the first one
+  std::string mPageCursor;
+  bool mPageMore {false}; ///< There are pages left to fetch
+  //! Entries of the current page, returned after the ones in dh_list
+  std::vector<std::pair<std::string, eos::FileOrContainerIdentifier>> mPage;
+  size_t mPagePos {0}; ///< Position of the next entry in the current page
+  eos::FileOrContainerIdentifier mLastId; ///< Id of the last entry returned
+
+  //----------------------------------------------------------------------------
+  //! Fetch the next page of a directory listed in pages
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  bool fetchPage();
 };
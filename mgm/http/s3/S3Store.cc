@@ -27,6 +27,8 @@
 #include "mgm/XrdMgmOfs.hh"
 #include "mgm/XrdMgmOfsDirectory.hh"
 #include "namespace/interface/IView.hh"
+#include "namespace/interface/IFileMDSvc.hh"
+#include "namespace/interface/IContainerMDSvc.hh"
 #include "namespace/utils/Checksum.hh"
 #include "common/http/PlainHttpResponse.hh"
 #include "common/Logging.hh"
@@ -318,6 +320,22 @@ S3Store::ListBucket(const std::string& bucket, const std::string& query)
   if (!listrc) {
     const char* name = 0;
 
+    // Start right after the marker instead of going through the entries
+    // before it, which matters for directories listed in pages
+    if (!marker_reached &&
+        (marker.compare(0, lPrefix.length(), lPrefix.c_str()) == 0)) {
+      std::string after = marker.substr(lPrefix.length());
+
+      if (after.length() && (after.back() == '/')) {
+        after.pop_back();
+      }
+
+      if (after.length() && (after.find('/') == std::string::npos)) {
+        bucketdir.seekAfter(after);
+        marker_reached = true;
+      }
+    }
+
     // loop over the directory contents
     while ((name = bucketdir.nextEntry())) {
       std::string entry = "";
@@ -355,8 +373,20 @@ S3Store::ListBucket(const std::string& bucket, const std::string& query)
         std::shared_ptr<eos::IFileMD> fmd;
         int errc = 0;
 
+        // Known for directories listed in pages, where a lookup by path
+        // would load the whole directory
+        eos::FileOrContainerIdentifier ident = bucketdir.lastEntryId();
+
         try {
-          fmd = gOFS->eosView->getFile(fullname);
+          if (ident.isFile()) {
+            fmd = gOFS->eosFileService->getFileMD(
+                    ident.toFileIdentifier().getUnderlyingUInt64());
+          } else if (ident.empty()) {
+            fmd = gOFS->eosView->getFile(fullname);
+          } else {
+            throw_mdexception(ENOENT, "No such file: " << fullname);
+          }
+
           entry = "<Contents>";
           entry += "<Key>";
           entry += objectname.c_str();
@@ -405,7 +435,13 @@ S3Store::ListBucket(const std::string& bucket, const std::string& query)
         if (!fmd) {
           // attempt container metadata retrieval
           try {
-            cmd = gOFS->eosView->getContainer(fullname);
+            if (ident.isContainer()) {
+              cmd = gOFS->eosDirectoryService->getContainerMD(
+                      ident.toContainerIdentifier().getUnderlyingUInt64());
+            } else {
+              cmd = gOFS->eosView->getContainer(fullname);
+            }
+
             entry = "<Contents>";
             entry += "<Key>";
             entry += objectname.c_str();
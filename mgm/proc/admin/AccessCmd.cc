@@ -372,6 +372,14 @@ void AccessCmd::LsSubcmd(const eos::console::AccessProto_LsProto& ls,
   }
 
   if (!Access::gStallRules.empty()) {
+    // Requests stalled so far by each rate rule
+    std::map<std::string, uint64_t> throttled;
+    auto stall_state = Access::GetStallState();
+
+    for (const auto& rule : stall_state->mRateRules.mRules) {
+      throttled[rule->mKey] = rule->mThrottled;
+    }
+
     if (!ls.monitoring()) {
       std_out <<
               "# ....................................................................................\n";
@@ -404,6 +412,13 @@ void AccessCmd::LsSubcmd(const eos::console::AccessProto_LsProto& ls,
                 "\"";
       }
 
+      auto it_throttled = throttled.find(itred->first);
+
+      if (it_throttled != throttled.end()) {
+        std_out << (ls.monitoring() ? " " : "\t") << "throttled="
+                << it_throttled->second;
+      }
+
       std_out << '\n';
     }
   }
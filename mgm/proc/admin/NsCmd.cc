@@ -32,6 +32,7 @@
 #include "namespace/interface/IView.hh"
 #include "namespace/interface/ContainerIterators.hh"
 #include "namespace/ns_quarkdb/Constants.hh"
+#include "namespace/ns_quarkdb/accounting/ContainerAccounting.hh"
 #include "namespace/ns_quarkdb/explorer/NamespaceExplorer.hh"
 #include "namespace/ns_quarkdb/BackendClient.hh"
 #include "namespace/ns_quarkdb/utils/QuotaRecomputer.hh"
@@ -334,6 +335,45 @@ NsCmd::StatSubcmd(const eos::console::NsProto_StatProto& stat,
   CacheStatistics fileCacheStats = gOFS->eosFileService->getCacheStatistics();
   CacheStatistics containerCacheStats =
     gOFS->eosDirectoryService->getCacheStatistics();
+  PathCacheStatistics pathCacheStats =
+    gOFS->eosDirectoryService->getPathCacheStatistics();
+  CacheWarmUpStatistics warmUpStats =
+    gOFS->namespaceGroup->getCacheWarmUpStatistics();
+  auto* tree_accounting = dynamic_cast<eos::QuarkContainerAccounting*>
+                          (gOFS->eosContainerAccounting);
+  eos::QuarkContainerAccounting::Stats treeStats;
+
+  if (tree_accounting) {
+    treeStats = tree_accounting->GetStats();
+  }
+
+  auto hit_rate = [](const CacheStatistics & stats) {
+    uint64_t lookups = stats.hits + stats.misses;
+    return (lookups ? (100.0 * stats.hits / lookups) : 0.0);
+  };
+  // Hit rate of the requests served since the warm-up started
+  auto warm_up_hit_rate = [&]() {
+    uint64_t hits = fileCacheStats.hits + containerCacheStats.hits;
+    uint64_t misses = fileCacheStats.misses + containerCacheStats.misses;
+
+    if ((hits < warmUpStats.startHits) || (misses < warmUpStats.startMisses)) {
+      return 0.0;
+    }
+
+    hits -= warmUpStats.startHits;
+    misses -= warmUpStats.startMisses;
+    return ((hits + misses) ? (100.0 * hits / (hits + misses)) : 0.0);
+  };
+  auto readable_size = [](uint64_t size) {
+    std::string sizestring;
+    StringConversion::GetReadableSizeString(sizestring, size, "B");
+    return sizestring;
+  };
+  auto percentage = [](double value) {
+    char buff[32];
+    snprintf(buff, sizeof(buff), "%.2f%%", value);
+    return std::string(buff);
+  };
   common::MutexLatencyWatcher::LatencySpikes viewLatency =
     gOFS->mViewMutexWatcher.getLatencySpikes();
 
@@ -353,6 +393,74 @@ NsCmd::StatSubcmd(const eos::console::NsProto_StatProto& stat,
         << std::endl
         << "uid=all gid=all ns.cache.containers.occupancy=" <<
         containerCacheStats.occupancy << std::endl
+        << "uid=all gid=all ns.cache.files.maxbytes=" << fileCacheStats.maxSize
+        << std::endl
+        << "uid=all gid=all ns.cache.files.bytes=" << fileCacheStats.sizeBytes
+        << std::endl
+        << "uid=all gid=all ns.cache.files.hits=" << fileCacheStats.hits
+        << std::endl
+        << "uid=all gid=all ns.cache.files.misses=" << fileCacheStats.misses
+        << std::endl
+        << "uid=all gid=all ns.cache.files.evictions=" << fileCacheStats.evictions
+        << std::endl
+        << "uid=all gid=all ns.cache.files.hitrate=" << hit_rate(fileCacheStats)
+        << std::endl
+        << "uid=all gid=all ns.cache.files.lookups_per_s="
+        << (uint64_t) fileCacheStats.lookupRate << std::endl
+        << "uid=all gid=all ns.cache.containers.maxbytes="
+        << containerCacheStats.maxSize << std::endl
+        << "uid=all gid=all ns.cache.containers.bytes="
+        << containerCacheStats.sizeBytes << std::endl
+        << "uid=all gid=all ns.cache.containers.hits=" << containerCacheStats.hits
+        << std::endl
+        << "uid=all gid=all ns.cache.containers.misses="
+        << containerCacheStats.misses << std::endl
+        << "uid=all gid=all ns.cache.containers.evictions="
+        << containerCacheStats.evictions << std::endl
+        << "uid=all gid=all ns.cache.containers.hitrate="
+        << hit_rate(containerCacheStats) << std::endl
+        << "uid=all gid=all ns.cache.containers.lookups_per_s="
+        << (uint64_t) containerCacheStats.lookupRate << std::endl
+        << "uid=all gid=all ns.cache.paths.maxsize=" << pathCacheStats.maxNum
+        << std::endl
+        << "uid=all gid=all ns.cache.paths.occupancy="
+        << pathCacheStats.occupancy << std::endl
+        << "uid=all gid=all ns.cache.paths.negative="
+        << pathCacheStats.negative << std::endl
+        << "uid=all gid=all ns.cache.paths.hits=" << pathCacheStats.hits
+        << std::endl
+        << "uid=all gid=all ns.cache.paths.negative_hits="
+        << pathCacheStats.negativeHits << std::endl
+        << "uid=all gid=all ns.cache.paths.misses=" << pathCacheStats.misses
+        << std::endl
+        << "uid=all gid=all ns.cache.paths.invalidations="
+        << pathCacheStats.invalidations << std::endl
+        << "uid=all gid=all ns.cache.warmup.status=" << warmUpStats.status
+        << std::endl
+        << "uid=all gid=all ns.cache.warmup.total=" << warmUpStats.total
+        << std::endl
+        << "uid=all gid=all ns.cache.warmup.loaded=" << warmUpStats.loaded
+        << std::endl
+        << "uid=all gid=all ns.cache.warmup.failed=" << warmUpStats.failed
+        << std::endl
+        << "uid=all gid=all ns.cache.warmup.duration_s="
+        << (uint64_t) warmUpStats.durationSec << std::endl
+        << "uid=all gid=all ns.cache.warmup.hitrate=" << warm_up_hit_rate()
+        << std::endl
+        << "uid=all gid=all ns.cache.warmup.snapshot.entries="
+        << warmUpStats.snapshotEntries << std::endl
+        << "uid=all gid=all ns.cache.warmup.snapshot.time="
+        << warmUpStats.lastSnapshot << std::endl
+        << "uid=all gid=all ns.accounting.tree.queue_depth="
+        << treeStats.queueDepth << std::endl
+        << "uid=all gid=all ns.accounting.tree.pending=" << treeStats.pending
+        << std::endl
+        << "uid=all gid=all ns.accounting.tree.lag_ms=" << treeStats.lastLagMs
+        << std::endl
+        << "uid=all gid=all ns.accounting.tree.maxlag_ms=" << treeStats.maxLagMs
+        << std::endl
+        << "uid=all gid=all ns.accounting.tree.applied=" << treeStats.applied
+        << std::endl
         << "uid=all gid=all ns.total.files.changelog.size="
         << StringConversion::GetSizeString(clfsize, (unsigned long long) statf.st_size)
         << std::endl
@@ -539,12 +647,77 @@ NsCmd::StatSubcmd(const eos::console::NsProto_StatProto& stat,
           << std::endl
           << "ALL      In-flight FileMD                 " << fileCacheStats.inFlight
           << std::endl
+          << "ALL      File cache max size              "
+          << (fileCacheStats.maxSize ?
+              readable_size(fileCacheStats.maxSize) : "unlimited")
+          << std::endl
+          << "ALL      File cache size                  "
+          << readable_size(fileCacheStats.sizeBytes) << std::endl
+          << "ALL      File cache hit rate              "
+          << percentage(hit_rate(fileCacheStats)) << std::endl
+          << "ALL      File cache lookups               "
+          << (uint64_t) fileCacheStats.lookupRate << " Hz" << std::endl
+          << "ALL      File cache evictions             " << fileCacheStats.evictions
+          << std::endl
           << "ALL      Container cache max num          " << containerCacheStats.maxNum
           << std::endl
           << "ALL      Container cache occupancy        " << containerCacheStats.occupancy
           << std::endl
           << "ALL      In-flight ContainerMD            " << containerCacheStats.inFlight
           << std::endl
+          << "ALL      Container cache max size         "
+          << (containerCacheStats.maxSize ?
+              readable_size(containerCacheStats.maxSize) : "unlimited")
+          << std::endl
+          << "ALL      Container cache size             "
+          << readable_size(containerCacheStats.sizeBytes) << std::endl
+          << "ALL      Container cache hit rate         "
+          << percentage(hit_rate(containerCacheStats)) << std::endl
+          << "ALL      Container cache lookups          "
+          << (uint64_t) containerCacheStats.lookupRate << " Hz" << std::endl
+          << "ALL      Container cache evictions        "
+          << containerCacheStats.evictions << std::endl
+          << line << std::endl;
+    }
+
+    if (pathCacheStats.enabled) {
+      uint64_t path_lookups = pathCacheStats.hits + pathCacheStats.negativeHits +
+                              pathCacheStats.misses;
+      oss << "ALL      Path cache max num               " << pathCacheStats.maxNum
+          << std::endl
+          << "ALL      Path cache occupancy             " << pathCacheStats.occupancy
+          << " (" << pathCacheStats.negative << " negative)" << std::endl
+          << "ALL      Path cache hit rate              "
+          << percentage(path_lookups ? (100.0 * (pathCacheStats.hits +
+                                        pathCacheStats.negativeHits) / path_lookups) : 0.0)
+          << " (" << pathCacheStats.negativeHits << " negative hits)" << std::endl
+          << "ALL      Path cache invalidations         "
+          << pathCacheStats.invalidations << std::endl
+          << line << std::endl;
+    }
+
+    if (warmUpStats.enabled) {
+      oss << "ALL      Cache warm-up                    " << warmUpStats.status
+          << " (" << warmUpStats.loaded << "/" << warmUpStats.total
+          << " entries, " << warmUpStats.failed << " failed, "
+          << (uint64_t) warmUpStats.durationSec << " s)" << std::endl
+          << "ALL      Cache hit rate since warm-up     "
+          << percentage(warm_up_hit_rate()) << std::endl
+          << "ALL      Cache snapshot entries           "
+          << warmUpStats.snapshotEntries;
+
+      if (warmUpStats.lastSnapshot) {
+        oss << " (" << (time(NULL) - warmUpStats.lastSnapshot) << " s ago)";
+      }
+
+      oss << std::endl << line << std::endl;
+    }
+
+    if (tree_accounting) {
+      oss << "ALL      Tree size queue depth            " << treeStats.queueDepth
+          << " (" << treeStats.pending << " pending)" << std::endl
+          << "ALL      Tree size propagation lag        " << treeStats.lastLagMs
+          << "ms (last) " << treeStats.maxLagMs << "ms (max)" << std::endl
           << line << std::endl;
     }
 
@@ -1001,6 +1174,8 @@ NsCmd::CacheSubcmd(const eos::console::NsProto_CacheProto& cache,
       map_cfg[sMaxSizeCacheFiles] = std::to_string(cache.max_size());
       gOFS->ConfEngine->SetConfigValue("ns", "cache-size-nfiles",
                                        std::to_string(cache.max_num()).c_str());
+      gOFS->ConfEngine->SetConfigValue("ns", "cache-size-bytes-files",
+                                       std::to_string(cache.max_size()).c_str());
       gOFS->eosFileService->configure(map_cfg);
     }
   } else if (cache.op() == NsProto_CacheProto::SET_DIR) {
@@ -1009,6 +1184,8 @@ NsCmd::CacheSubcmd(const eos::console::NsProto_CacheProto& cache,
       map_cfg[sMaxSizeCacheDirs] = std::to_string(cache.max_size());
       gOFS->ConfEngine->SetConfigValue("ns", "cache-size-ndirs",
                                        std::to_string(cache.max_num()).c_str());
+      gOFS->ConfEngine->SetConfigValue("ns", "cache-size-bytes-dirs",
+                                       std::to_string(cache.max_size()).c_str());
       gOFS->eosDirectoryService->configure(map_cfg);
     }
   } else if (cache.op() == NsProto_CacheProto::DROP_FILE) {
@@ -658,8 +658,10 @@ public:
   // QDB: Initialize NamespaceExplorer
   //----------------------------------------------------------------------------
   FindResultProvider(qclient::QClient* qc, const std::string& target, const uint32_t depthlimit, const bool ignore_files,
-                     const eos::common::VirtualIdentity& v)
-    : qcl(qc), path(target), depthlimit(depthlimit), ignore_files(ignore_files), vid(v)
+                     const eos::common::VirtualIdentity& v, const uint32_t threads = 0,
+                     const bool ordered = true)
+    : qcl(qc), path(target), depthlimit(depthlimit), ignore_files(ignore_files), vid(v),
+      threads(std::min(threads, kMaxThreads)), ordered(ordered)
   {
     restart();
   }
@@ -675,6 +677,8 @@ public:
       options.view = gOFS->eosView;
       options.depthLimit = depthlimit;
       options.ignoreFiles = ignore_files;
+      options.numWorkers = threads;
+      options.orderedOutput = ordered;
       explorer.reset(new NamespaceExplorer(path, options, *qcl,
                                            static_cast<QuarkNamespaceGroup*>(gOFS->namespaceGroup.get())->getExecutor()));
     }
@@ -780,6 +784,19 @@ public:
     return true;
   }
 
+  //----------------------------------------------------------------------------
+  // QDB: Get exploration statistics
+  //----------------------------------------------------------------------------
+  bool getStats(ExplorationStats& stats) const
+  {
+    if (!explorer) {
+      return false;
+    }
+
+    stats = explorer->getStats();
+    return true;
+  }
+
   bool next(FindResult& res)
   {
     if (found) {
@@ -813,6 +830,9 @@ private:
   bool ignore_files;
   std::unique_ptr<NamespaceExplorer> explorer;
   eos::common::VirtualIdentity vid;
+  static constexpr uint32_t kMaxThreads = 32;
+  uint32_t threads = 0;
+  bool ordered = true;
 };
 
 //------------------------------------------------------------------------------
@@ -897,7 +917,8 @@ NewfindCmd::ProcessRequest() noexcept
                         eos::common::Path::MAX_LEVELS : cPath.GetSubPathSize() + findRequest.maxdepth();
     findResultProvider.reset(new FindResultProvider(
                                eos::BackendClient::getInstance(gOFS->mQdbContactDetails, "find"),
-                               findRequest.path(), depthlimit, findRequest.childcount(), mVid));
+                               findRequest.path(), depthlimit, findRequest.childcount(), mVid,
+                               findRequest.threads(), !findRequest.unordered()));
   }
 
   uint64_t childcount_aggregate_dircounter = 0;
@@ -1055,6 +1076,17 @@ NewfindCmd::ProcessRequest() noexcept
 //  EXEC_TIMING_END("Newfind");
   std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
   gOFS->MgmStats.AddExec("Newfind", std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count() );
+  ExplorationStats explorationStats;
+
+  if (findResultProvider->getStats(explorationStats)) {
+    eos_static_info("msg=\"find exploration done\" path=\"%s\" threads=%u "
+                    "containers=%llu files=%llu fetch_sec=%.3f total_sec=%.3f "
+                    "containers_per_sec=%.1f files_per_sec=%.1f",
+                    findRequest.path().c_str(), findRequest.threads(),
+                    explorationStats.containers, explorationStats.files,
+                    explorationStats.fetchSeconds, explorationStats.totalSeconds,
+                    explorationStats.containerRate(), explorationStats.fileRate());
+  }
 
   gOFS->MgmStats.Add("Newfind", mVid.uid, mVid.gid, 1);
   gOFS->MgmStats.Add("NewfindEntries", mVid.uid, mVid.gid, filecounter);
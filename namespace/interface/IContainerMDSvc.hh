@@ -179,6 +179,14 @@ public:
   //----------------------------------------------------------------------------
   virtual CacheStatistics getCacheStatistics() = 0;
 
+  //----------------------------------------------------------------------------
+  //! Retrieve path lookup cache statistics
+  //----------------------------------------------------------------------------
+  virtual PathCacheStatistics getPathCacheStatistics()
+  {
+    return PathCacheStatistics();
+  }
+
   //----------------------------------------------------------------------------
   //! Blacklist IDs below the given threshold
   //----------------------------------------------------------------------------
@@ -23,6 +23,7 @@
 
 #pragma once
 #include "namespace/Namespace.hh"
+#include "namespace/interface/Misc.hh"
 #include <map>
 #include <string>
 
@@ -42,6 +43,7 @@ class IFsView;
 class IContainerMDChangeListener;
 class IQuotaStats;
 class IFileMDChangeListener;
+class HierarchicalLockManager;
 
 //------------------------------------------------------------------------------
 //! Interface object to hold ownership of all namespace objects.
@@ -99,6 +101,17 @@ public:
   //----------------------------------------------------------------------------
   virtual IQuotaStats* getQuotaStats() = 0;
 
+  //----------------------------------------------------------------------------
+  //! Provide the per-container lock manager. Namespaces which return one
+  //! allow mutations of a single container to run under the shared namespace
+  //! lock, provided they hold the exclusive lock of that container. Returns
+  //! nullptr if every mutation needs the exclusive namespace lock.
+  //----------------------------------------------------------------------------
+  virtual HierarchicalLockManager* getContainerLockManager()
+  {
+    return nullptr;
+  }
+
   //----------------------------------------------------------------------------
   //! Is this in-memory namespace?
   //----------------------------------------------------------------------------
@@ -109,6 +122,22 @@ public:
   //----------------------------------------------------------------------------
   virtual void startCacheRefreshListener() = 0;
 
+  //----------------------------------------------------------------------------
+  //! Start warming up the metadata cache from the snapshot of its hot set,
+  //! then snapshot it periodically
+  //----------------------------------------------------------------------------
+  virtual void startCacheWarmer() = 0;
+
+  //----------------------------------------------------------------------------
+  //! Stop the cache warmer, writing a last snapshot
+  //----------------------------------------------------------------------------
+  virtual void stopCacheWarmer() = 0;
+
+  //----------------------------------------------------------------------------
+  //! Get cache warm-up statistics
+  //----------------------------------------------------------------------------
+  virtual CacheWarmUpStatistics getCacheWarmUpStatistics() = 0;
+
 protected:
   //----------------------------------------------------------------------------
   //! Global namespace mutex - no ownership
@@ -25,6 +25,9 @@
 #define EOS_NS_MISC_H
 
 #include "namespace/Namespace.hh"
+#include <cstdint>
+#include <ctime>
+#include <string>
 
 EOSNSNAMESPACE_BEGIN
 
@@ -36,6 +39,44 @@ struct CacheStatistics {
   uint64_t maxNum = 0;
   uint64_t occupancy = 0;
   uint64_t inFlight = 0;
+  uint64_t maxSize = 0; ///< Limit in bytes, 0 if unlimited
+  uint64_t sizeBytes = 0; ///< Estimated size of the cached entries
+  uint64_t hits = 0;
+  uint64_t misses = 0;
+  uint64_t evictions = 0;
+  double lookupRate = 0; ///< Lookups per second since the previous query
+};
+
+//------------------------------------------------------------------------------
+//! Struct to retrieve information about the path lookup cache
+//------------------------------------------------------------------------------
+struct PathCacheStatistics {
+  bool enabled = false;
+  uint64_t maxNum = 0;
+  uint64_t occupancy = 0;
+  uint64_t negative = 0; ///< Entries for paths which don't exist
+  uint64_t hits = 0;
+  uint64_t negativeHits = 0;
+  uint64_t misses = 0;
+  uint64_t invalidations = 0;
+};
+
+//------------------------------------------------------------------------------
+//! Struct to retrieve information about the metadata cache warm-up
+//------------------------------------------------------------------------------
+struct CacheWarmUpStatistics {
+  bool enabled = false;
+  std::string status = "idle"; ///< idle, running, done, aborted or failed,
+  ///< the latter when the snapshot is unreadable
+  uint64_t total = 0; ///< Entries of the snapshot to prefetch
+  uint64_t loaded = 0; ///< Entries prefetched so far
+  uint64_t failed = 0; ///< Entries which could not be fetched e.g. deleted
+  double durationSec = 0; ///< Time spent warming up
+  //! Cache hits and misses of files and containers when the warm-up started
+  uint64_t startHits = 0;
+  uint64_t startMisses = 0;
+  time_t lastSnapshot = 0; ///< Time of the last snapshot written, 0 if none
+  uint64_t snapshotEntries = 0; ///< Entries in the last snapshot written
 };
 
 EOSNSNAMESPACE_END
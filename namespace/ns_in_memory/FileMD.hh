@@ -26,6 +26,7 @@
 
 #include "namespace/interface/IFileMD.hh"
 #include "namespace/interface/IFileMDSvc.hh"
+#include "common/SharedMutexWrapper.hh"
 #include <stdint.h>
 #include <cstring>
 #include <string>
@@ -678,6 +679,7 @@ protected:
   Buffer              pChecksum;
   XAttrMap            pXAttrs;
   IFileMDSvc*         pFileMDSvc;
+  mutable std::shared_timed_mutex mMutex;
 };
 
 EOSNSNAMESPACE_END
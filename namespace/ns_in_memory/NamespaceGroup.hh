@@ -109,6 +109,24 @@ public:
   //----------------------------------------------------------------------------
   virtual void startCacheRefreshListener() override final {}
 
+  //----------------------------------------------------------------------------
+  //! Start cache warmer - no-op for in-memory namespace
+  //----------------------------------------------------------------------------
+  virtual void startCacheWarmer() override final {}
+
+  //----------------------------------------------------------------------------
+  //! Stop cache warmer - no-op for in-memory namespace
+  //----------------------------------------------------------------------------
+  virtual void stopCacheWarmer() override final {}
+
+  //----------------------------------------------------------------------------
+  //! Get cache warm-up statistics - disabled for in-memory namespace
+  //----------------------------------------------------------------------------
+  virtual CacheWarmUpStatistics getCacheWarmUpStatistics() override final
+  {
+    return CacheWarmUpStatistics();
+  }
+
 
 private:
   //----------------------------------------------------------------------------
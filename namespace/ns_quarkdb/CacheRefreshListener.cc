@@ -19,6 +19,7 @@
 #include "namespace/ns_quarkdb/CacheRefreshListener.hh"
 #include "namespace/interface/Identifiers.hh"
 #include "namespace/ns_quarkdb/persistency/MetadataProvider.hh"
+#include "namespace/ns_quarkdb/PathLookupCache.hh"
 #include "namespace/ns_quarkdb/Constants.hh"
 #include "common/ParseUtils.hh"
 #include <functional>
@@ -31,8 +32,9 @@ EOSNSNAMESPACE_BEGIN
 //------------------------------------------------------------------------------
 // Constructor
 //------------------------------------------------------------------------------
-CacheRefreshListener::CacheRefreshListener(const QdbContactDetails &cd, MetadataProvider *provider)
-: mContactDetails(cd), mMetadataProvider(provider),
+CacheRefreshListener::CacheRefreshListener(const QdbContactDetails &cd, MetadataProvider *provider,
+  PathLookupCache *pathCache)
+: mContactDetails(cd), mMetadataProvider(provider), mPathCache(pathCache),
   mSubscriber(cd.members, cd.constructSubscriptionOptions()) {
 
   mFidSubscription = mSubscriber.subscribe(constants::sCacheInvalidationFidChannel);
@@ -73,6 +75,10 @@ void CacheRefreshListener::processIncomingCidInvalidation(qclient::Message &&msg
 
   if(common::ParseUInt64(msg.getPayload(), cid)) {
     mMetadataProvider->dropCachedContainerID(ContainerIdentifier(cid));
+
+    if(mPathCache) {
+      mPathCache->invalidateContainer(cid);
+    }
   }
 }
 
@@ -32,6 +32,7 @@
 EOSNSNAMESPACE_BEGIN
 
 class MetadataProvider;
+class PathLookupCache;
 
 //------------------------------------------------------------------------------
 //! Class to listen for notifications (typically issued by eos-ns-inspect)
@@ -42,7 +43,8 @@ public:
   //----------------------------------------------------------------------------
   //! Constructor
   //----------------------------------------------------------------------------
-  CacheRefreshListener(const QdbContactDetails &cd, MetadataProvider *provider);
+  CacheRefreshListener(const QdbContactDetails &cd, MetadataProvider *provider,
+    PathLookupCache *pathCache = nullptr);
 
   //----------------------------------------------------------------------------
   //! Destructor
@@ -63,6 +65,7 @@ private:
 
   QdbContactDetails mContactDetails;
   MetadataProvider* mMetadataProvider;
+  PathLookupCache* mPathCache;
   qclient::Subscriber mSubscriber;
 
   std::unique_ptr<qclient::Subscription> mFidSubscription;
@@ -0,0 +1,469 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2021 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "namespace/ns_quarkdb/CacheWarmer.hh"
+#include "namespace/ns_quarkdb/persistency/MetadataProvider.hh"
+#include "namespace/MDException.hh"
+#include "common/Logging.hh"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <fcntl.h>
+#include <unistd.h>
+
+EOSNSNAMESPACE_BEGIN
+
+namespace
+{
+//! Identifies the snapshot format
+const std::string kMagic = "EOSHOT01";
+
+//------------------------------------------------------------------------------
+// Append an unsigned integer encoded as a varint
+//------------------------------------------------------------------------------
+void AppendVarint(std::string& out, uint64_t value)
+{
+  while (value >= 0x80) {
+    out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+    value >>= 7;
+  }
+
+  out.push_back(static_cast<char>(value));
+}
+
+//------------------------------------------------------------------------------
+// Read a varint at the given position, advancing it
+//------------------------------------------------------------------------------
+bool ReadVarint(const std::string& data, size_t& pos, uint64_t& value)
+{
+  value = 0;
+
+  for (int shift = 0; shift < 64; shift += 7) {
+    if (pos >= data.size()) {
+      return false;
+    }
+
+    uint8_t byte = static_cast<uint8_t>(data[pos++]);
+    value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+
+    if ((byte & 0x80) == 0) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+//------------------------------------------------------------------------------
+// Append a list of ids sorted by id
+//------------------------------------------------------------------------------
+void AppendIds(std::string& out,
+               std::vector<std::pair<uint64_t, uint8_t>> ids)
+{
+  std::sort(ids.begin(), ids.end());
+  AppendVarint(out, ids.size());
+  uint64_t prev = 0;
+
+  for (const auto& entry : ids) {
+    AppendVarint(out, entry.first - prev);
+    out.push_back(static_cast<char>(entry.second));
+    prev = entry.first;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Read a list of ids and order it hottest first
+//------------------------------------------------------------------------------
+bool ReadIds(const std::string& data, size_t& pos,
+             std::vector<std::pair<uint64_t, uint8_t>>& ids)
+{
+  uint64_t count;
+
+  // Every entry takes at least two bytes
+  if (!ReadVarint(data, pos, count) || (count > (data.size() - pos) / 2)) {
+    return false;
+  }
+
+  ids.clear();
+  ids.reserve(count);
+  uint64_t id = 0;
+
+  for (uint64_t i = 0; i < count; ++i) {
+    uint64_t delta;
+
+    if (!ReadVarint(data, pos, delta) || (pos >= data.size())) {
+      return false;
+    }
+
+    id += delta;
+    ids.emplace_back(id, static_cast<uint8_t>(data[pos++]));
+  }
+
+  std::stable_sort(ids.begin(), ids.end(),
+                   [](const std::pair<uint64_t, uint8_t>& a,
+  const std::pair<uint64_t, uint8_t>& b) {
+    return a.second > b.second;
+  });
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Write the data to a new file and sync it to disk, errno is set on failure
+//------------------------------------------------------------------------------
+bool WriteFileSync(const std::string& path, const std::string& data)
+{
+  int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+
+  if (fd < 0) {
+    return false;
+  }
+
+  size_t pos = 0;
+
+  while (pos < data.size()) {
+    ssize_t nwrite = ::write(fd, data.data() + pos, data.size() - pos);
+
+    if ((nwrite < 0) && (errno == EINTR)) {
+      continue;
+    }
+
+    if (nwrite <= 0) {
+      errno = (nwrite ? errno : EIO);
+      break;
+    }
+
+    pos += nwrite;
+  }
+
+  bool ok = (pos == data.size()) && (::fsync(fd) == 0);
+  int errnoSave = errno;
+
+  if (::close(fd) && ok) {
+    return false;
+  }
+
+  errno = errnoSave;
+  return ok;
+}
+
+//------------------------------------------------------------------------------
+// Wait for a batch of lookups and account the results
+//------------------------------------------------------------------------------
+template<typename FutureT>
+void WaitBatch(std::vector<FutureT>& batch, uint64_t& loaded,
+               uint64_t& failed)
+{
+  for (auto& fut : batch) {
+    fut.wait();
+
+    if (fut.hasException()) {
+      ++failed;
+    } else {
+      ++loaded;
+    }
+  }
+
+  batch.clear();
+}
+
+//------------------------------------------------------------------------------
+// Number of entries which still fit into a cache
+//------------------------------------------------------------------------------
+uint64_t FreeSlots(const CacheStatistics& stats)
+{
+  return (stats.maxNum > stats.occupancy) ? (stats.maxNum - stats.occupancy) :
+         0;
+}
+}
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+CacheWarmer::CacheWarmer(MetadataProvider* provider, const std::string& path,
+                         std::chrono::seconds interval)
+  : mProvider(provider), mPath(path), mInterval(interval)
+{
+  mStats.enabled = true;
+}
+
+//------------------------------------------------------------------------------
+// Destructor
+//------------------------------------------------------------------------------
+CacheWarmer::~CacheWarmer()
+{
+  mThread.join();
+}
+
+//------------------------------------------------------------------------------
+// Start the warm-up from the snapshot followed by the periodic snapshots
+//------------------------------------------------------------------------------
+void CacheWarmer::start()
+{
+  mThread.reset(&CacheWarmer::run, this);
+  mThread.setName("CacheWarmer");
+}
+
+//------------------------------------------------------------------------------
+// Stop the background thread and write a last snapshot
+//------------------------------------------------------------------------------
+void CacheWarmer::stop()
+{
+  mThread.join();
+  std::string status = getStatistics().status;
+
+  if ((status == "done") || (status == "failed")) {
+    std::string err;
+
+    if (!saveSnapshot(err)) {
+      eos_static_err("msg=\"failed to save cache snapshot\" err=\"%s\"",
+                     err.c_str());
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Background thread: warm-up followed by the periodic snapshots
+//------------------------------------------------------------------------------
+void CacheWarmer::run(ThreadAssistant& assistant)
+{
+  HotSet hot;
+  std::string err;
+
+  if (loadSnapshot(hot, err)) {
+    eos_static_notice("msg=\"warming up metadata cache\" path=\"%s\" "
+                      "containers=%llu files=%llu", mPath.c_str(),
+                      (unsigned long long) hot.containers.size(),
+                      (unsigned long long) hot.files.size());
+    warmUp(hot, assistant);
+  } else {
+    eos_static_err("msg=\"failed to load cache snapshot\" err=\"%s\"",
+                   err.c_str());
+    std::lock_guard<std::mutex> lock(mMutex);
+    mStats.status = "failed";
+  }
+
+  while (!assistant.terminationRequested()) {
+    assistant.wait_for(mInterval);
+
+    if (assistant.terminationRequested()) {
+      break;
+    }
+
+    if (!saveSnapshot(err)) {
+      eos_static_err("msg=\"failed to save cache snapshot\" err=\"%s\"",
+                     err.c_str());
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Prefetch the given entries
+//------------------------------------------------------------------------------
+void CacheWarmer::warmUp(const HotSet& hot, ThreadAssistant& assistant)
+{
+  // Don't prefetch more than fits, it would evict the hottest entries
+  CacheStatistics fileStats = mProvider->getFileMDCacheStats();
+  CacheStatistics containerStats = mProvider->getContainerMDCacheStats();
+  uint64_t numContainers = std::min<uint64_t>(hot.containers.size(),
+                           FreeSlots(containerStats));
+  uint64_t numFiles = std::min<uint64_t>(hot.files.size(),
+                                         FreeSlots(fileStats));
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mStats.status = "running";
+    mStats.total = numContainers + numFiles;
+    mStats.loaded = 0;
+    mStats.failed = 0;
+    mStats.durationSec = 0;
+    mStats.startHits = fileStats.hits + containerStats.hits;
+    mStats.startMisses = fileStats.misses + containerStats.misses;
+  }
+  auto start = std::chrono::steady_clock::now();
+  uint64_t loaded = 0;
+  uint64_t failed = 0;
+  auto update = [&]() {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mStats.loaded = loaded;
+    mStats.failed = failed;
+    mStats.durationSec = std::chrono::duration<double>
+                         (std::chrono::steady_clock::now() - start).count();
+  };
+  // Containers first, path lookups go through them
+  std::vector<folly::Future<IContainerMDPtr>> containerBatch;
+
+  for (uint64_t i = 0; (i < numContainers) &&
+       !assistant.terminationRequested(); i += kBatchSize) {
+    for (uint64_t j = i; j < std::min<uint64_t>(i + kBatchSize, numContainers);
+         ++j) {
+      containerBatch.emplace_back(mProvider->retrieveContainerMD(
+                                    ContainerIdentifier(hot.containers[j].first), false));
+    }
+
+    WaitBatch(containerBatch, loaded, failed);
+    update();
+  }
+
+  std::vector<folly::Future<IFileMDPtr>> fileBatch;
+
+  for (uint64_t i = 0; (i < numFiles) && !assistant.terminationRequested();
+       i += kBatchSize) {
+    for (uint64_t j = i; j < std::min<uint64_t>(i + kBatchSize, numFiles); ++j) {
+      fileBatch.emplace_back(mProvider->retrieveFileMD(
+                               FileIdentifier(hot.files[j].first), false));
+    }
+
+    WaitBatch(fileBatch, loaded, failed);
+    update();
+  }
+
+  std::lock_guard<std::mutex> lock(mMutex);
+  mStats.status = assistant.terminationRequested() ? "aborted" : "done";
+  eos_static_notice("msg=\"metadata cache warm-up %s\" loaded=%llu "
+                    "failed=%llu duration=%.1fs", mStats.status.c_str(),
+                    (unsigned long long) loaded, (unsigned long long) failed,
+                    mStats.durationSec);
+}
+
+//------------------------------------------------------------------------------
+// Collect the hot set of the caches and write it to the snapshot file
+//------------------------------------------------------------------------------
+bool CacheWarmer::saveSnapshot(std::string& err)
+{
+  HotSet hot;
+
+  for (const auto& entry : mProvider->getHotContainerIds(UINT64_MAX)) {
+    hot.containers.emplace_back(entry.first.getUnderlyingUInt64(),
+                                entry.second);
+  }
+
+  for (const auto& entry : mProvider->getHotFileIds(UINT64_MAX)) {
+    hot.files.emplace_back(entry.first.getUnderlyingUInt64(), entry.second);
+  }
+
+  // Keep the previous snapshot rather than replacing it with nothing, e.g.
+  // right after a failover
+  if (hot.size() == 0) {
+    return true;
+  }
+
+  std::string data = serialize(hot);
+  std::string tmpPath = mPath + ".tmp";
+  std::lock_guard<std::mutex> snapshotLock(mSnapshotMutex);
+
+  // The data has to be on disk before the rename, otherwise a crash can
+  // leave an empty or partial snapshot in place of the previous one
+  if (!WriteFileSync(tmpPath, data)) {
+    err = SSTR("failed to write " << tmpPath << ": " << strerror(errno));
+    (void) ::unlink(tmpPath.c_str());
+    return false;
+  }
+
+  // Replace the previous snapshot atomically
+  if (::rename(tmpPath.c_str(), mPath.c_str())) {
+    err = SSTR("failed to rename " << tmpPath << ": " << strerror(errno));
+    return false;
+  }
+
+  // Persist the rename itself
+  size_t pos = mPath.rfind('/');
+  std::string dirPath = (pos == std::string::npos) ? "." :
+                        ((pos == 0) ? "/" : mPath.substr(0, pos));
+  int dirFd = ::open(dirPath.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+
+  if ((dirFd < 0) || ::fsync(dirFd)) {
+    eos_static_warning("msg=\"failed to sync snapshot directory\" path=%s "
+                       "errno=%d", dirPath.c_str(), errno);
+  }
+
+  if (dirFd >= 0) {
+    (void) ::close(dirFd);
+  }
+
+  std::lock_guard<std::mutex> lock(mMutex);
+  mStats.lastSnapshot = time(nullptr);
+  mStats.snapshotEntries = hot.size();
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Read the snapshot file
+//------------------------------------------------------------------------------
+bool CacheWarmer::loadSnapshot(HotSet& hot, std::string& err) const
+{
+  std::ifstream file(mPath, std::ios::binary);
+
+  // Nothing to warm up from e.g. on the first boot
+  if (!file && (errno == ENOENT)) {
+    hot = HotSet();
+    return true;
+  }
+
+  if (!file) {
+    err = SSTR("failed to open " << mPath << ": " << strerror(errno));
+    return false;
+  }
+
+  std::stringstream buffer;
+  buffer << file.rdbuf();
+
+  if (!deserialize(buffer.str(), hot)) {
+    err = SSTR("corrupted snapshot " << mPath);
+    return false;
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Get warm-up statistics
+//------------------------------------------------------------------------------
+CacheWarmUpStatistics CacheWarmer::getStatistics() const
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mStats;
+}
+
+//------------------------------------------------------------------------------
+// Serialize a hot set
+//------------------------------------------------------------------------------
+std::string CacheWarmer::serialize(const HotSet& hot)
+{
+  std::string out = kMagic;
+  AppendIds(out, hot.containers);
+  AppendIds(out, hot.files);
+  return out;
+}
+
+//------------------------------------------------------------------------------
+// Deserialize a hot set
+//------------------------------------------------------------------------------
+bool CacheWarmer::deserialize(const std::string& data, HotSet& hot)
+{
+  if (data.compare(0, kMagic.size(), kMagic) != 0) {
+    return false;
+  }
+
+  size_t pos = kMagic.size();
+  return ReadIds(data, pos, hot.containers) && ReadIds(data, pos, hot.files) &&
+         (pos == data.size());
+}
+
+EOSNSNAMESPACE_END
@@ -0,0 +1,149 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2021 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+//------------------------------------------------------------------------------
+//! @brief Persist the hot set of the metadata cache and warm the cache up
+//!        from it after a restart or a slave to master transition
+//------------------------------------------------------------------------------
+
+#pragma once
+#include "namespace/Namespace.hh"
+#include "namespace/interface/Misc.hh"
+#include "common/AssistedThread.hh"
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+EOSNSNAMESPACE_BEGIN
+
+class MetadataProvider;
+
+//------------------------------------------------------------------------------
+//! Ids of the hot cache entries with their score, see LRU::get_hot_ids
+//------------------------------------------------------------------------------
+struct HotSet {
+  std::vector<std::pair<uint64_t, uint8_t>> containers;
+  std::vector<std::pair<uint64_t, uint8_t>> files;
+
+  uint64_t size() const
+  {
+    return containers.size() + files.size();
+  }
+};
+
+//------------------------------------------------------------------------------
+//! Periodically writes the ids of the hot entries of the metadata cache to a
+//! local file. When started, it first prefetches the entries of the previous
+//! snapshot from QuarkDB so that a freshly promoted master does not serve
+//! its first requests from a cold cache. The warm-up runs in the background
+//! while requests are served, in pipelined batches of kBatchSize lookups
+//! spread over the connections of the MetadataProvider, the hottest entries
+//! first. Its lookups are not accounted in the cache statistics.
+//------------------------------------------------------------------------------
+class CacheWarmer
+{
+public:
+  //! Number of lookups in flight during the warm-up
+  static constexpr size_t kBatchSize = 2000;
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param provider metadata provider owning the caches
+  //! @param path location of the snapshot
+  //! @param interval time between two snapshots
+  //----------------------------------------------------------------------------
+  CacheWarmer(MetadataProvider* provider, const std::string& path,
+              std::chrono::seconds interval);
+
+  //----------------------------------------------------------------------------
+  //! Destructor
+  //----------------------------------------------------------------------------
+  ~CacheWarmer();
+
+  //----------------------------------------------------------------------------
+  //! Start the warm-up from the snapshot followed by the periodic snapshots
+  //----------------------------------------------------------------------------
+  void start();
+
+  //----------------------------------------------------------------------------
+  //! Stop the background thread and write a last snapshot, unless the
+  //! warm-up did not complete and the cache only holds part of the hot set.
+  //! Must be called before the caches get dropped.
+  //----------------------------------------------------------------------------
+  void stop();
+
+  //----------------------------------------------------------------------------
+  //! Collect the hot set of the caches and write it to the snapshot file
+  //!
+  //! @return true if successful, otherwise false and err is filled in
+  //----------------------------------------------------------------------------
+  bool saveSnapshot(std::string& err);
+
+  //----------------------------------------------------------------------------
+  //! Read the snapshot file, a missing one gives an empty hot set
+  //!
+  //! @return true if successful, otherwise false and err is filled in
+  //----------------------------------------------------------------------------
+  bool loadSnapshot(HotSet& hot, std::string& err) const;
+
+  //----------------------------------------------------------------------------
+  //! Prefetch the given entries, stopping early if termination is requested
+  //! or the caches are full
+  //----------------------------------------------------------------------------
+  void warmUp(const HotSet& hot, ThreadAssistant& assistant);
+
+  //----------------------------------------------------------------------------
+  //! Get warm-up statistics
+  //----------------------------------------------------------------------------
+  CacheWarmUpStatistics getStatistics() const;
+
+  //----------------------------------------------------------------------------
+  //! Serialize a hot set: the ids are sorted and delta encoded as varints,
+  //! followed by their score, which takes 2 to 3 bytes per entry for ids
+  //! allocated close to each other
+  //----------------------------------------------------------------------------
+  static std::string serialize(const HotSet& hot);
+
+  //----------------------------------------------------------------------------
+  //! Deserialize a hot set, the entries come out hottest first and in
+  //! ascending id order for the same score
+  //!
+  //! @return false if the data is corrupted
+  //----------------------------------------------------------------------------
+  static bool deserialize(const std::string& data, HotSet& hot);
+
+private:
+  //----------------------------------------------------------------------------
+  //! Background thread: warm-up followed by the periodic snapshots
+  //----------------------------------------------------------------------------
+  void run(ThreadAssistant& assistant);
+
+  MetadataProvider* mProvider; // no ownership
+  std::string mPath;
+  std::chrono::seconds mInterval;
+  std::mutex mSnapshotMutex; ///< Serializes the snapshot writes
+  mutable std::mutex mMutex; ///< Protects mStats
+  CacheWarmUpStatistics mStats;
+  AssistedThread mThread;
+};
+
+EOSNSNAMESPACE_END
@@ -86,6 +86,7 @@ void QuarkContainerMD::setServices(IFileMDSvc* file_svc,
 
   pQcl = impl_cont_svc->pQcl;
   pFlusher = impl_cont_svc->pFlusher;
+  pPathCache = &impl_cont_svc->mPathCache;
 }
 
 //------------------------------------------------------------------------------
@@ -108,6 +109,7 @@ QuarkContainerMD::QuarkContainerMD(const QuarkContainerMD& other)
   pQcl     = other.pQcl;
   mClock   = other.mClock;
   pFlusher = other.pFlusher;
+  pPathCache = other.pPathCache;
   pDirsKey = other.pDirsKey;
   pFilesKey = other.pFilesKey;
 }
@@ -226,10 +228,16 @@ QuarkContainerMD::removeContainer(const std::string& name)
     throw e;
   }
 
+  IContainerMD::id_t id = it->second;
   mSubcontainers->erase(it);
   // mSubcontainers->resize(0);
   // Delete container also from KV backend
   pFlusher->hdel(pDirsKey, name);
+
+  if (pPathCache) {
+    pPathCache->invalidateName(mCont.id(), name);
+    pPathCache->invalidateContainer(id);
+  }
 }
 
 //------------------------------------------------------------------------------
@@ -271,6 +279,10 @@ QuarkContainerMD::addContainer(IContainerMD* container)
                                 container->getId()));
   // Add to new container to KV backend
   pFlusher->hset(pDirsKey, container->getName(), stringify(container->getId()));
+
+  if (pPathCache) {
+    pPathCache->invalidateName(mCont.id(), container->getName());
+  }
 }
 
 //------------------------------------------------------------------------------
@@ -345,6 +357,11 @@ QuarkContainerMD::addFile(IFileMD* file)
   file->setContainerId(mCont.id());
   (void)mFiles->insert(std::make_pair(file->getName(), file->getId()));
   pFlusher->hset(pFilesKey, file->getName(), std::to_string(file->getId()));
+
+  if (pPathCache) {
+    pPathCache->invalidateName(mCont.id(), file->getName());
+  }
+
   lock.unlock();
 
   if (file->getSize() != 0u) {
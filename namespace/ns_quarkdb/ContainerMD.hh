@@ -39,6 +39,7 @@ EOSNSNAMESPACE_BEGIN
 
 class IContainerMDSvc;
 class IFileMDSvc;
+class PathLookupCache;
 
 //------------------------------------------------------------------------------
 //! Class holding the metadata information concerning a single container
@@ -571,6 +572,7 @@ private:
   IContainerMDSvc* pContSvc = nullptr;  ///< Container metadata service
   IFileMDSvc* pFileSvc = nullptr;       ///< File metadata service
   MetadataFlusher* pFlusher = nullptr;  ///< Metadata flusher object
+  PathLookupCache* pPathCache = nullptr; ///< Cache of path translations
   qclient::QClient* pQcl;               ///< QClient object
   std::string pFilesKey;                ///< Map files key
   std::string pDirsKey;                 ///< Map dir key
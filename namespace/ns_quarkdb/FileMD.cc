@@ -16,6 +16,7 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
  ************************************************************************/
 
+#include <algorithm>
 #include <sstream>
 #include <chrono>
 #include "common/Logging.hh"
@@ -35,19 +36,26 @@ EOSNSNAMESPACE_BEGIN
 //------------------------------------------------------------------------------
 // Empty constructor
 //------------------------------------------------------------------------------
-QuarkFileMD::QuarkFileMD()
+QuarkFileMD::QuarkFileMD():
+  pFileMDSvc(nullptr), mId(0), mContId(0), mSize(0), mCloneId(0), mClock(0),
+  mUid(0), mGid(0), mLayoutId(0), mFlags(0), mTimeMask(0)
 {
-  pFileMDSvc = nullptr;
+  for (int i = 0; i < kNumTimes; ++i) {
+    mTimeSec[i].store(0, std::memory_order_relaxed);
+    mTimeNsec[i].store(0, std::memory_order_relaxed);
+  }
 }
 
 //------------------------------------------------------------------------------
 // Constructor
 //------------------------------------------------------------------------------
 QuarkFileMD::QuarkFileMD(IFileMD::id_t id, IFileMDSvc* fileMDSvc):
-  pFileMDSvc(fileMDSvc)
+  QuarkFileMD()
 {
-  mFile.set_id(id);
-  mClock = std::chrono::high_resolution_clock::now().time_since_epoch().count();
+  pFileMDSvc = fileMDSvc;
+  mId.store(id, std::memory_order_relaxed);
+  mClock.store(std::chrono::high_resolution_clock::now().time_since_epoch().count(),
+               std::memory_order_relaxed);
 }
 
 //------------------------------------------------------------------------------
@@ -56,14 +64,14 @@ QuarkFileMD::QuarkFileMD(IFileMD::id_t id, IFileMDSvc* fileMDSvc):
 QuarkFileMD*
 QuarkFileMD::clone() const
 {
-  std::unique_lock<std::shared_timed_mutex> lock(mMutex);
   return new QuarkFileMD(*this);
 }
 
 //------------------------------------------------------------------------------
 // Copy constructor
 //------------------------------------------------------------------------------
-QuarkFileMD::QuarkFileMD(const QuarkFileMD& other)
+QuarkFileMD::QuarkFileMD(const QuarkFileMD& other):
+  QuarkFileMD()
 {
   *this = other;
 }
@@ -74,13 +82,85 @@ QuarkFileMD::QuarkFileMD(const QuarkFileMD& other)
 QuarkFileMD&
 QuarkFileMD::operator = (const QuarkFileMD& other)
 {
-  std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-  mFile = other.mFile;
-  mClock = other.mClock;
+  if (this == &other) {
+    return *this;
+  }
+
+  std::unique_lock<std::shared_timed_mutex> lock(getMutex(), std::defer_lock);
+
+  if (&getMutex() == &other.getMutex()) {
+    // Both objects map to the same lock stripe
+    lock.lock();
+    copyNoLock(other);
+  } else {
+    std::shared_lock<std::shared_timed_mutex> other_lock(other.getMutex(),
+        std::defer_lock);
+    std::lock(lock, other_lock);
+    copyNoLock(other);
+  }
+
   pFileMDSvc   = 0;
   return *this;
 }
 
+//------------------------------------------------------------------------------
+// Get the mutex protecting this object
+//------------------------------------------------------------------------------
+std::shared_timed_mutex&
+QuarkFileMD::getMutex() const
+{
+  static std::shared_timed_mutex sLockStripes[kNumLockStripes];
+  uint64_t addr = reinterpret_cast<uintptr_t>(this);
+  return sLockStripes[((addr >> 4) * 0x9e3779b97f4a7c15ull) >>
+                      (64 - kLockStripeBits)];
+}
+
+//------------------------------------------------------------------------------
+// Copy the contents of the given object
+//------------------------------------------------------------------------------
+void
+QuarkFileMD::copyNoLock(const QuarkFileMD& other)
+{
+  SeqLock::WriteGuard wguard(mTimeSeq);
+  mId.store(other.mId.load(std::memory_order_relaxed),
+            std::memory_order_relaxed);
+  mContId.store(other.mContId.load(std::memory_order_relaxed),
+                std::memory_order_relaxed);
+  mSize.store(other.mSize.load(std::memory_order_relaxed),
+              std::memory_order_relaxed);
+  mCloneId.store(other.mCloneId.load(std::memory_order_relaxed),
+                 std::memory_order_relaxed);
+  mClock.store(other.mClock.load(std::memory_order_relaxed),
+               std::memory_order_relaxed);
+  mUid.store(other.mUid.load(std::memory_order_relaxed),
+             std::memory_order_relaxed);
+  mGid.store(other.mGid.load(std::memory_order_relaxed),
+             std::memory_order_relaxed);
+  mLayoutId.store(other.mLayoutId.load(std::memory_order_relaxed),
+                  std::memory_order_relaxed);
+  mFlags.store(other.mFlags.load(std::memory_order_relaxed),
+               std::memory_order_relaxed);
+
+  for (int i = 0; i < kNumTimes; ++i) {
+    mTimeSec[i].store(other.mTimeSec[i].load(std::memory_order_relaxed),
+                      std::memory_order_relaxed);
+    mTimeNsec[i].store(other.mTimeNsec[i].load(std::memory_order_relaxed),
+                       std::memory_order_relaxed);
+  }
+
+  mTimeMask.store(other.mTimeMask.load(std::memory_order_relaxed),
+                  std::memory_order_relaxed);
+  mStrings = other.mStrings;
+  mLocations = other.mLocations;
+  mUnlinkedLocations = other.mUnlinkedLocations;
+
+  if (other.mXAttrs) {
+    mXAttrs.reset(new XAttrVector(*other.mXAttrs));
+  } else {
+    mXAttrs.reset();
+  }
+}
+
 //------------------------------------------------------------------------------
 // Set name
 //------------------------------------------------------------------------------
@@ -92,8 +172,8 @@ void QuarkFileMD::setName(const std::string& name)
     throw_mdexception(EINVAL, "Bug, detected slashes in file name: " << name);
   }
 
-  std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-  mFile.set_name(name);
+  std::unique_lock<std::shared_timed_mutex> lock(getMutex());
+  mStrings.set(kName, name);
 }
 
 //------------------------------------------------------------------------------
@@ -102,13 +182,13 @@ void QuarkFileMD::setName(const std::string& name)
 void
 QuarkFileMD::addLocation(location_t location)
 {
-  std::unique_lock<std::shared_timed_mutex> lock(mMutex);
+  std::unique_lock<std::shared_timed_mutex> lock(getMutex());
 
   if (hasLocationNoLock(location)) {
     return;
   }
 
-  mFile.add_locations(location);
+  mLocations.push_back(location);
   lock.unlock();
   IFileMDChangeListener::Event e(this, IFileMDChangeListener::LocationAdded,
                                  location);
@@ -121,12 +201,12 @@ QuarkFileMD::addLocation(location_t location)
 void
 QuarkFileMD::removeLocation(location_t location)
 {
-  std::unique_lock<std::shared_timed_mutex> lock(mMutex);
+  std::unique_lock<std::shared_timed_mutex> lock(getMutex());
 
-  for (auto it = mFile.mutable_unlink_locations()->cbegin();
-       it != mFile.mutable_unlink_locations()->cend(); ++it) {
+  for (auto it = mUnlinkedLocations.begin();
+       it != mUnlinkedLocations.end(); ++it) {
     if (*it == location) {
-      it = mFile.mutable_unlink_locations()->erase(it);
+      it = mUnlinkedLocations.erase(it);
       lock.unlock();
       IFileMDChangeListener::Event
       e(this, IFileMDChangeListener::LocationRemoved, location);
@@ -143,10 +223,10 @@ void
 QuarkFileMD::removeAllLocations()
 {
   while (true) {
-    std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-    auto it = mFile.unlink_locations().cbegin();
+    std::unique_lock<std::shared_timed_mutex> lock(getMutex());
+    auto it = mUnlinkedLocations.begin();
 
-    if (it == mFile.unlink_locations().cend()) {
+    if (it == mUnlinkedLocations.end()) {
       return;
     }
 
@@ -162,18 +242,17 @@ QuarkFileMD::removeAllLocations()
 void
 QuarkFileMD::unlinkLocation(location_t location)
 {
-  std::unique_lock<std::shared_timed_mutex> lock(mMutex);
+  std::unique_lock<std::shared_timed_mutex> lock(getMutex());
 
-  for (auto it = mFile.mutable_locations()->cbegin();
-       it != mFile.mutable_locations()->cend(); ++it) {
+  for (auto it = mLocations.begin(); it != mLocations.end(); ++it) {
     if (*it == location) {
 
       // If location is already unlink, skip adding it
       if (!hasUnlinkedLocationNoLock(location)) {
-        mFile.add_unlink_locations(*it);
+        mUnlinkedLocations.push_back(*it);
       }
 
-      it = mFile.mutable_locations()->erase(it);
+      it = mLocations.erase(it);
       lock.unlock();
       IFileMDChangeListener::Event
       e(this, IFileMDChangeListener::LocationUnlinked, location);
@@ -190,10 +269,10 @@ void
 QuarkFileMD::unlinkAllLocations()
 {
   while (true) {
-    std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-    auto it = mFile.locations().cbegin();
+    std::unique_lock<std::shared_timed_mutex> lock(getMutex());
+    auto it = mLocations.begin();
 
-    if (it == mFile.locations().cend()) {
+    if (it == mLocations.end()) {
       return;
     }
 
@@ -209,10 +288,10 @@ QuarkFileMD::unlinkAllLocations()
 void
 QuarkFileMD::getEnv(std::string& env, bool escapeAnd)
 {
-  std::shared_lock<std::shared_timed_mutex> lock(mMutex);
+  std::shared_lock<std::shared_timed_mutex> lock(getMutex());
   env = "";
   std::ostringstream oss;
-  std::string saveName = mFile.name();
+  std::string saveName = mStrings.get(kName);
 
   if (escapeAnd) {
     if (!saveName.empty()) {
@@ -232,37 +311,38 @@ QuarkFileMD::getEnv(std::string& env, bool escapeAnd)
   ctime_t mtime;
   (void) getCTimeNoLock(ctime);
   (void) getMTimeNoLock(mtime);
-  oss << "name=" << saveName << "&id=" << mFile.id()
+  oss << "name=" << saveName << "&id=" << getId()
       << "&ctime=" << ctime.tv_sec << "&ctime_ns=" << ctime.tv_nsec
       << "&mtime=" << mtime.tv_sec << "&mtime_ns=" << mtime.tv_nsec
-      << "&size=" << mFile.size() << "&cid=" << mFile.cont_id()
-      << "&uid=" << mFile.uid() << "&gid=" << mFile.gid()
-      << "&lid=" << mFile.layout_id() << "&flags=" << mFile.flags()
-      << "&link=" << mFile.link_name();
+      << "&size=" << getSize() << "&cid=" << getContainerId()
+      << "&uid=" << getCUid() << "&gid=" << getCGid()
+      << "&lid=" << getLayoutId() << "&flags=" << getFlags()
+      << "&link=" << mStrings.get(kLinkName);
   env += oss.str();
   env += "&location=";
   char locs[16];
 
-  for (const auto& elem : mFile.locations()) {
+  for (const auto& elem : mLocations) {
     snprintf(static_cast<char*>(locs), sizeof(locs), "%u", elem);
     env += static_cast<char*>(locs);
     env += ",";
   }
 
-  for (const auto& elem : mFile.unlink_locations()) {
+  for (const auto& elem : mUnlinkedLocations) {
     snprintf(static_cast<char*>(locs), sizeof(locs), "!%u", elem);
     env += static_cast<char*>(locs);
     env += ",";
   }
 
   env += "&checksum=";
-  uint8_t size = mFile.checksum().size();
+  uint8_t size = mStrings.length(kChecksum);
+  const char* checksum = mStrings.data(kChecksum);
 
   for (uint8_t i = 0; i < size; i++) {
     char hx[3];
     hx[0] = 0;
     snprintf(static_cast<char*>(hx), sizeof(hx), "%02x",
-             *(unsigned char*)(mFile.checksum().data() + i));
+             *(unsigned char*)(checksum + i));
     env += static_cast<char*>(hx);
   }
 }
@@ -273,11 +353,16 @@ QuarkFileMD::getEnv(std::string& env, bool escapeAnd)
 void
 QuarkFileMD::serialize(eos::Buffer& buffer)
 {
-  std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-  // Increase clock to mark that metadata file has suffered updates
-  mClock = std::chrono::high_resolution_clock::now().time_since_epoch().count();
+  eos::ns::FileMdProto proto;
+  {
+    std::shared_lock<std::shared_timed_mutex> lock(getMutex());
+    // Increase clock to mark that metadata file has suffered updates
+    mClock.store(std::chrono::high_resolution_clock::now().time_since_epoch().count(),
+                 std::memory_order_relaxed);
+    toProtoNoLock(proto);
+  }
   // Align the buffer to 4 bytes to efficiently compute the checksum
-  size_t obj_size = mFile.ByteSizeLong();
+  size_t obj_size = proto.ByteSizeLong();
   uint32_t align_size = (obj_size + 3) >> 2 << 2;
   size_t sz = sizeof(align_size);
   size_t msg_size = align_size + 2 * sz;
@@ -287,7 +372,7 @@ QuarkFileMD::serialize(eos::Buffer& buffer)
   const char* ptr = buffer.getDataPtr() + 2 * sz;
   google::protobuf::io::ArrayOutputStream aos((void*)ptr, align_size);
 
-  if (!mFile.SerializeToZeroCopyStream(&aos)) {
+  if (!proto.SerializeToZeroCopyStream(&aos)) {
     MDException ex(EIO);
     ex.getMessage() << "Failed while serializing buffer";
     throw ex;
@@ -309,8 +394,8 @@ QuarkFileMD::serialize(eos::Buffer& buffer)
 void
 QuarkFileMD::initialize(eos::ns::FileMdProto&& proto)
 {
-  std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-  mFile = std::move(proto);
+  std::unique_lock<std::shared_timed_mutex> lock(getMutex());
+  fromProtoNoLock(proto);
 }
 
 //------------------------------------------------------------------------------
@@ -319,17 +404,138 @@ QuarkFileMD::initialize(eos::ns::FileMdProto&& proto)
 void
 QuarkFileMD::deserialize(const eos::Buffer& buffer)
 {
-  std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-  Serialization::deserializeFile(buffer, mFile);
+  eos::ns::FileMdProto proto;
+  Serialization::deserializeFile(buffer, proto);
+  std::unique_lock<std::shared_timed_mutex> lock(getMutex());
+  fromProtoNoLock(proto);
 }
 
 //----------------------------------------------------------------------------
-// Get reference to underlying protobuf object
+// Get protobuf representation of the object
 //----------------------------------------------------------------------------
-const eos::ns::FileMdProto&
+eos::ns::FileMdProto
 QuarkFileMD::getProto() const
 {
-  return mFile;
+  eos::ns::FileMdProto proto;
+  std::shared_lock<std::shared_timed_mutex> lock(getMutex());
+  toProtoNoLock(proto);
+  return proto;
+}
+
+//------------------------------------------------------------------------------
+// Build the protobuf representation, no locks
+//------------------------------------------------------------------------------
+void
+QuarkFileMD::toProtoNoLock(eos::ns::FileMdProto& proto) const
+{
+  proto.set_id(mId.load(std::memory_order_relaxed));
+  proto.set_cont_id(mContId.load(std::memory_order_relaxed));
+  proto.set_uid(mUid.load(std::memory_order_relaxed));
+  proto.set_gid(mGid.load(std::memory_order_relaxed));
+  proto.set_size(mSize.load(std::memory_order_relaxed));
+  proto.set_layout_id(mLayoutId.load(std::memory_order_relaxed));
+  proto.set_flags(mFlags.load(std::memory_order_relaxed));
+  proto.set_name(mStrings.data(kName), mStrings.length(kName));
+  proto.set_link_name(mStrings.data(kLinkName), mStrings.length(kLinkName));
+  proto.set_checksum(mStrings.data(kChecksum), mStrings.length(kChecksum));
+  proto.set_clonefst(mStrings.data(kCloneFst), mStrings.length(kCloneFst));
+  proto.set_cloneid(mCloneId.load(std::memory_order_relaxed));
+  uint8_t mask = mTimeMask.load(std::memory_order_relaxed);
+  ctime_t ts;
+
+  if (mask & (1 << kCTime)) {
+    ts = loadTime(kCTime);
+    proto.set_ctime(&ts, sizeof(ts));
+  }
+
+  if (mask & (1 << kMTime)) {
+    ts = loadTime(kMTime);
+    proto.set_mtime(&ts, sizeof(ts));
+  }
+
+  if (mask & (1 << kSTime)) {
+    ts = loadTime(kSTime);
+    proto.set_stime(&ts, sizeof(ts));
+  }
+
+  for (const auto& elem : mLocations) {
+    proto.add_locations(elem);
+  }
+
+  for (const auto& elem : mUnlinkedLocations) {
+    proto.add_unlink_locations(elem);
+  }
+
+  if (mXAttrs) {
+    auto* xattrs = proto.mutable_xattrs();
+
+    for (const auto& elem : *mXAttrs) {
+      (*xattrs)[*elem.first] = elem.second.get(0);
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Load the protobuf representation
+//------------------------------------------------------------------------------
+void
+QuarkFileMD::fromProtoNoLock(const eos::ns::FileMdProto& proto)
+{
+  mId.store(proto.id(), std::memory_order_relaxed);
+  mContId.store(proto.cont_id(), std::memory_order_relaxed);
+  mUid.store(proto.uid(), std::memory_order_relaxed);
+  mGid.store(proto.gid(), std::memory_order_relaxed);
+  mSize.store(proto.size(), std::memory_order_relaxed);
+  mLayoutId.store(proto.layout_id(), std::memory_order_relaxed);
+  mFlags.store(proto.flags(), std::memory_order_relaxed);
+  mCloneId.store(proto.cloneid(), std::memory_order_relaxed);
+  mStrings.clear();
+  mStrings.set(kName, proto.name());
+  mStrings.set(kLinkName, proto.link_name());
+  mStrings.set(kChecksum, proto.checksum());
+  mStrings.set(kCloneFst, proto.clonefst());
+  {
+    SeqLock::WriteGuard wguard(mTimeSeq);
+    const std::string* times[kNumTimes] = {
+      &proto.ctime(), &proto.mtime(), &proto.stime()
+    };
+    mTimeMask.store(0, std::memory_order_relaxed);
+
+    for (int i = 0; i < kNumTimes; ++i) {
+      ctime_t ts {0, 0};
+
+      if (times[i]->empty()) {
+        mTimeSec[i].store(0, std::memory_order_relaxed);
+        mTimeNsec[i].store(0, std::memory_order_relaxed);
+        continue;
+      }
+
+      (void) memcpy(&ts, times[i]->data(),
+                    std::min(times[i]->size(), sizeof(ts)));
+      storeTime((TimeIndex) i, ts);
+    }
+  }
+  mLocations.assign(proto.locations().begin(), proto.locations().end());
+  mUnlinkedLocations.assign(proto.unlink_locations().begin(),
+                            proto.unlink_locations().end());
+
+  if (proto.xattrs().empty()) {
+    mXAttrs.reset();
+  } else {
+    mXAttrs.reset(new XAttrVector());
+    mXAttrs->reserve(proto.xattrs().size());
+    StringInterner& names = StringInterner::attributeNames();
+
+    for (const auto& elem : proto.xattrs()) {
+      mXAttrs->emplace_back(names.intern(elem.first), PackedStrings<1>());
+      mXAttrs->back().second.set(0, elem.second);
+    }
+
+    std::sort(mXAttrs->begin(), mXAttrs->end(),
+    [](const XAttrVector::value_type & a, const XAttrVector::value_type & b) {
+      return *a.first < *b.first;
+    });
+  }
 }
 
 //------------------------------------------------------------------------------
@@ -338,9 +544,10 @@ QuarkFileMD::getProto() const
 void
 QuarkFileMD::setSize(uint64_t size)
 {
-  std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-  int64_t sizeChange = (size & 0x0000ffffffffffff) - mFile.size();
-  mFile.set_size(size & 0x0000ffffffffffff);
+  std::unique_lock<std::shared_timed_mutex> lock(getMutex());
+  int64_t sizeChange = (size & 0x0000ffffffffffff) -
+                       mSize.load(std::memory_order_relaxed);
+  mSize.store(size & 0x0000ffffffffffff, std::memory_order_relaxed);
   lock.unlock();
   IFileMDChangeListener::Event e(this, IFileMDChangeListener::SizeChange, 0,
                                  sizeChange);
@@ -353,7 +560,9 @@ QuarkFileMD::setSize(uint64_t size)
 void
 QuarkFileMD::getCTimeNoLock(ctime_t& ctime) const
 {
-  (void) memcpy(&ctime, mFile.ctime().data(), sizeof(ctime_t));
+  ctime = mTimeSeq.read([&]() {
+    return loadTime(kCTime);
+  });
 }
 
 //------------------------------------------------------------------------------
@@ -362,7 +571,6 @@ QuarkFileMD::getCTimeNoLock(ctime_t& ctime) const
 void
 QuarkFileMD::getCTime(ctime_t& ctime) const
 {
-  std::shared_lock<std::shared_timed_mutex> lock(mMutex);
   getCTimeNoLock(ctime);
 }
 
@@ -372,8 +580,9 @@ QuarkFileMD::getCTime(ctime_t& ctime) const
 void
 QuarkFileMD::setCTime(ctime_t ctime)
 {
-  std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-  mFile.set_ctime(&ctime, sizeof(ctime));
+  std::unique_lock<std::shared_timed_mutex> lock(getMutex());
+  SeqLock::WriteGuard wguard(mTimeSeq);
+  storeTime(kCTime, ctime);
 }
 
 //----------------------------------------------------------------------------
@@ -400,7 +609,9 @@ QuarkFileMD::setCTimeNow()
 void
 QuarkFileMD::getMTimeNoLock(ctime_t& mtime) const
 {
-  (void) memcpy(&mtime, mFile.mtime().data(), sizeof(ctime_t));
+  mtime = mTimeSeq.read([&]() {
+    return loadTime(kMTime);
+  });
 }
 
 //------------------------------------------------------------------------------
@@ -409,7 +620,6 @@ QuarkFileMD::getMTimeNoLock(ctime_t& mtime) const
 void
 QuarkFileMD::getMTime(ctime_t& mtime) const
 {
-  std::shared_lock<std::shared_timed_mutex> lock(mMutex);
   getMTimeNoLock(mtime);
 }
 
@@ -419,8 +629,9 @@ QuarkFileMD::getMTime(ctime_t& mtime) const
 void
 QuarkFileMD::setMTime(ctime_t mtime)
 {
-  std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-  mFile.set_mtime(&mtime, sizeof(mtime));
+  std::unique_lock<std::shared_timed_mutex> lock(getMutex());
+  SeqLock::WriteGuard wguard(mTimeSeq);
+  storeTime(kMTime, mtime);
 }
 
 //------------------------------------------------------------------------------
@@ -455,9 +666,15 @@ QuarkFileMD::setMTimeNow()
 void
 QuarkFileMD::getSyncTimeNoLock(ctime_t& stime) const
 {
-  (void) memcpy(&stime, mFile.stime().data(), sizeof(stime));
-  if (stime.tv_sec == 0)    /* fall back to mtime if default */
-      (void) memcpy(&stime, mFile.mtime().data(), sizeof(stime));
+  stime = mTimeSeq.read([&]() {
+    ctime_t ts = loadTime(kSTime);
+
+    if (ts.tv_sec == 0) {  /* fall back to mtime if default */
+      ts = loadTime(kMTime);
+    }
+
+    return ts;
+  });
 }
 
 //------------------------------------------------------------------------------
@@ -466,7 +683,6 @@ QuarkFileMD::getSyncTimeNoLock(ctime_t& stime) const
 void
 QuarkFileMD::getSyncTime(ctime_t& stime) const
 {
-  std::shared_lock<std::shared_timed_mutex> lock(mMutex);
   getSyncTimeNoLock(stime);
 }
 
@@ -476,8 +692,33 @@ QuarkFileMD::getSyncTime(ctime_t& stime) const
 void
 QuarkFileMD::setSyncTime(ctime_t stime)
 {
-  std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-  mFile.set_stime(&stime, sizeof(stime));
+  std::unique_lock<std::shared_timed_mutex> lock(getMutex());
+  SeqLock::WriteGuard wguard(mTimeSeq);
+  storeTime(kSTime, stime);
+}
+
+//------------------------------------------------------------------------------
+// Get timestamp
+//------------------------------------------------------------------------------
+IFileMD::ctime_t
+QuarkFileMD::loadTime(TimeIndex idx) const
+{
+  ctime_t ts;
+  ts.tv_sec = mTimeSec[idx].load(std::memory_order_relaxed);
+  ts.tv_nsec = mTimeNsec[idx].load(std::memory_order_relaxed);
+  return ts;
+}
+
+//------------------------------------------------------------------------------
+// Set timestamp
+//------------------------------------------------------------------------------
+void
+QuarkFileMD::storeTime(TimeIndex idx, const ctime_t& value)
+{
+  mTimeSec[idx].store(value.tv_sec, std::memory_order_relaxed);
+  mTimeNsec[idx].store(value.tv_nsec, std::memory_order_relaxed);
+  mTimeMask.store(mTimeMask.load(std::memory_order_relaxed) | (1 << idx),
+                  std::memory_order_relaxed);
 }
 
 //------------------------------------------------------------------------------
@@ -497,21 +738,98 @@ QuarkFileMD::setSyncTimeNow()
 eos::IFileMD::XAttrMap
 QuarkFileMD::getAttributes() const
 {
-  std::shared_lock<std::shared_timed_mutex> lock(mMutex);
+  std::shared_lock<std::shared_timed_mutex> lock(getMutex());
   std::map<std::string, std::string> xattrs;
 
-  for (const auto& elem : mFile.xattrs()) {
-    xattrs.insert(elem);
+  if (mXAttrs) {
+    // Already sorted, insert with hint at the end
+    for (const auto& elem : *mXAttrs) {
+      xattrs.emplace_hint(xattrs.end(), *elem.first, elem.second.get(0));
+    }
   }
 
   return xattrs;
 }
 
+//------------------------------------------------------------------------------
+// Add extended attribute
+//------------------------------------------------------------------------------
+void
+QuarkFileMD::setAttribute(const std::string& name, const std::string& value)
+{
+  std::unique_lock<std::shared_timed_mutex> lock(getMutex());
+
+  if (!mXAttrs) {
+    mXAttrs.reset(new XAttrVector());
+  }
+
+  auto it = std::lower_bound(mXAttrs->begin(), mXAttrs->end(), name,
+  [](const XAttrVector::value_type & elem, const std::string & key) {
+    return *elem.first < key;
+  });
+
+  if ((it != mXAttrs->end()) && (*it->first == name)) {
+    it->second.set(0, value);
+  } else {
+    it = mXAttrs->emplace(it, StringInterner::attributeNames().intern(name),
+                          PackedStrings<1>());
+    it->second.set(0, value);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Remove attribute
+//------------------------------------------------------------------------------
+void
+QuarkFileMD::removeAttribute(const std::string& name)
+{
+  std::unique_lock<std::shared_timed_mutex> lock(getMutex());
+
+  if (!mXAttrs) {
+    return;
+  }
+
+  auto it = std::lower_bound(mXAttrs->begin(), mXAttrs->end(), name,
+  [](const XAttrVector::value_type & elem, const std::string & key) {
+    return *elem.first < key;
+  });
+
+  if ((it != mXAttrs->end()) && (*it->first == name)) {
+    mXAttrs->erase(it);
+
+    if (mXAttrs->empty()) {
+      mXAttrs.reset();
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Find attribute value, no locks
+//------------------------------------------------------------------------------
+const PackedStrings<1>*
+QuarkFileMD::findAttributeNoLock(const std::string& name) const
+{
+  if (!mXAttrs) {
+    return nullptr;
+  }
+
+  auto it = std::lower_bound(mXAttrs->begin(), mXAttrs->end(), name,
+  [](const XAttrVector::value_type & elem, const std::string & key) {
+    return *elem.first < key;
+  });
+
+  if ((it != mXAttrs->end()) && (*it->first == name)) {
+    return &it->second;
+  }
+
+  return nullptr;
+}
+
 //------------------------------------------------------------------------------
 // Test the unlinked location
 //------------------------------------------------------------------------------
 bool QuarkFileMD::hasUnlinkedLocation(IFileMD::location_t location) {
-  std::shared_lock<std::shared_timed_mutex> lock(mMutex);
+  std::shared_lock<std::shared_timed_mutex> lock(getMutex());
   return hasUnlinkedLocationNoLock(location);
 }
 
@@ -519,8 +837,8 @@ bool QuarkFileMD::hasUnlinkedLocation(IFileMD::location_t location) {
 // Test the unlinked location, no locks
 //------------------------------------------------------------------------------
 bool QuarkFileMD::hasUnlinkedLocationNoLock(location_t location) const {
-  for (int i = 0; i < mFile.unlink_locations_size(); ++i) {
-    if (mFile.unlink_locations()[i] == location) {
+  for (const auto& elem : mUnlinkedLocations) {
+    if (elem == location) {
       return true;
     }
   }
@@ -27,7 +27,12 @@
 #include "common/SharedMutexWrapper.hh"
 #include "namespace/interface/IFileMD.hh"
 #include "namespace/ns_quarkdb/persistency/FileMDSvc.hh"
+#include "namespace/utils/InlineVector.hh"
+#include "namespace/utils/PackedStrings.hh"
+#include "namespace/utils/SeqLock.hh"
+#include "namespace/utils/StringInterner.hh"
 #include "proto/FileMd.pb.h"
+#include <atomic>
 #include <cstdint>
 #include <sys/time.h>
 
@@ -42,6 +47,16 @@ class IContainerMD;
 
 //------------------------------------------------------------------------------
 //! Class holding the metadata information concerning a single file
+//!
+//! The metadata is kept in a compact form instead of the protobuf object,
+//! which is only built for serialization: fixed size fields are atomics, the
+//! strings share a single allocation, the locations are stored inline and the
+//! extended attribute names are interned. Fixed size fields are read without
+//! any lock, the timestamps through a sequence lock. Writers hold the object
+//! mutex exclusively and readers of variable length fields hold it shared.
+//! The mutex is not a member but one of a fixed set of stripes picked by the
+//! address of the object, a reader-writer lock being bigger than the rest of
+//! the object.
 //------------------------------------------------------------------------------
 class QuarkFileMD : public IFileMD
 {
@@ -129,8 +144,7 @@ public:
   inline IFileMD::id_t
   getId() const override
   {
-    std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    return mFile.id();
+    return mId.load(std::memory_order_relaxed);
   }
 
   //----------------------------------------------------------------------------
@@ -138,8 +152,7 @@ public:
   //----------------------------------------------------------------------------
   inline FileIdentifier getIdentifier() const override
   {
-    std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    return FileIdentifier(mFile.id());
+    return FileIdentifier(mId.load(std::memory_order_relaxed));
   }
 
   //----------------------------------------------------------------------------
@@ -148,8 +161,7 @@ public:
   inline uint64_t
   getSize() const override
   {
-    std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    return mFile.size();
+    return mSize.load(std::memory_order_relaxed);
   }
 
   //----------------------------------------------------------------------------
@@ -163,8 +175,7 @@ public:
   inline uint64_t
   getCloneId() const override
   {
-    std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    return mFile.cloneid();
+    return mCloneId.load(std::memory_order_relaxed);
   }
 
   //----------------------------------------------------------------------------
@@ -172,8 +183,8 @@ public:
   //----------------------------------------------------------------------------
   void setCloneId(uint64_t id) override
   {
-    std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    mFile.set_cloneid(id);
+    std::unique_lock<std::shared_timed_mutex> lock(getMutex());
+    mCloneId.store(id, std::memory_order_relaxed);
   }
 
   //----------------------------------------------------------------------------
@@ -182,8 +193,8 @@ public:
   const std::string
   getCloneFST() const override
   {
-    std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    return mFile.clonefst();
+    std::shared_lock<std::shared_timed_mutex> lock(getMutex());
+    return mStrings.get(kCloneFst);
   }
 
   //----------------------------------------------------------------------------
@@ -191,8 +202,8 @@ public:
   //----------------------------------------------------------------------------
   void setCloneFST(const std::string& data) override
   {
-    std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    mFile.set_clonefst(data);
+    std::unique_lock<std::shared_timed_mutex> lock(getMutex());
+    mStrings.set(kCloneFst, data);
   }
 
   //----------------------------------------------------------------------------
@@ -201,8 +212,7 @@ public:
   inline IContainerMD::id_t
   getContainerId() const override
   {
-    std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    return mFile.cont_id();
+    return mContId.load(std::memory_order_relaxed);
   }
 
   //----------------------------------------------------------------------------
@@ -211,8 +221,8 @@ public:
   void
   setContainerId(IContainerMD::id_t containerId) override
   {
-    std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-    mFile.set_cont_id(containerId);
+    std::unique_lock<std::shared_timed_mutex> lock(getMutex());
+    mContId.store(containerId, std::memory_order_relaxed);
   }
 
   //----------------------------------------------------------------------------
@@ -221,9 +231,9 @@ public:
   inline const Buffer
   getChecksum() const override
   {
-    std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    Buffer buff(mFile.checksum().size());
-    buff.putData((void*)mFile.checksum().data(), mFile.checksum().size());
+    std::shared_lock<std::shared_timed_mutex> lock(getMutex());
+    Buffer buff(mStrings.length(kChecksum));
+    buff.putData((void*)mStrings.data(kChecksum), mStrings.length(kChecksum));
     return buff;
   }
 
@@ -233,8 +243,8 @@ public:
   void
   setChecksum(const Buffer& checksum) override
   {
-    std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-    mFile.set_checksum(checksum.getDataPtr(), checksum.getSize());
+    std::unique_lock<std::shared_timed_mutex> lock(getMutex());
+    mStrings.set(kChecksum, checksum.getDataPtr(), checksum.getSize());
   }
 
   //----------------------------------------------------------------------------
@@ -243,8 +253,8 @@ public:
   void
   clearChecksum(uint8_t size = 20) override
   {
-    std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-    mFile.clear_checksum();
+    std::unique_lock<std::shared_timed_mutex> lock(getMutex());
+    mStrings.set(kChecksum, "", 0);
   }
 
   //----------------------------------------------------------------------------
@@ -256,8 +266,8 @@ public:
   void
   setChecksum(const void* checksum, uint8_t size) override
   {
-    std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-    mFile.set_checksum(checksum, size);
+    std::unique_lock<std::shared_timed_mutex> lock(getMutex());
+    mStrings.set(kChecksum, static_cast<const char*>(checksum), size);
   }
 
   //----------------------------------------------------------------------------
@@ -266,8 +276,8 @@ public:
   inline const std::string
   getName() const override
   {
-    std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    return mFile.name();
+    std::shared_lock<std::shared_timed_mutex> lock(getMutex());
+    return mStrings.get(kName);
   }
 
   //----------------------------------------------------------------------------
@@ -285,8 +295,8 @@ public:
   //----------------------------------------------------------------------------
   inline LocationVector getLocations() const override
   {
-    std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    LocationVector locations(mFile.locations().begin(), mFile.locations().end());
+    std::shared_lock<std::shared_timed_mutex> lock(getMutex());
+    LocationVector locations(mLocations.begin(), mLocations.end());
     return locations;
   }
 
@@ -296,10 +306,10 @@ public:
   location_t
   getLocation(unsigned int index) override
   {
-    std::shared_lock<std::shared_timed_mutex> lock(mMutex);
+    std::shared_lock<std::shared_timed_mutex> lock(getMutex());
 
-    if (index < (unsigned int)mFile.locations_size()) {
-      return mFile.locations(index);
+    if (index < mLocations.size()) {
+      return mLocations[index];
     }
 
     return 0;
@@ -321,8 +331,8 @@ public:
   void
   clearLocations() override
   {
-    std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-    mFile.clear_locations();
+    std::unique_lock<std::shared_timed_mutex> lock(getMutex());
+    mLocations.clear();
   }
 
   //----------------------------------------------------------------------------
@@ -331,8 +341,8 @@ public:
   bool
   hasLocationNoLock(location_t location)
   {
-    for (int i = 0; i < mFile.locations_size(); i++) {
-      if (mFile.locations(i) == location) {
+    for (const auto& elem : mLocations) {
+      if (elem == location) {
         return true;
       }
     }
@@ -346,7 +356,7 @@ public:
   bool
   hasLocation(location_t location) override
   {
-    std::shared_lock<std::shared_timed_mutex> lock(mMutex);
+    std::shared_lock<std::shared_timed_mutex> lock(getMutex());
     return hasLocationNoLock(location);
   }
 
@@ -356,8 +366,8 @@ public:
   inline size_t
   getNumLocation() const override
   {
-    std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    return mFile.locations_size();
+    std::shared_lock<std::shared_timed_mutex> lock(getMutex());
+    return mLocations.size();
   }
 
   //----------------------------------------------------------------------------
@@ -365,9 +375,9 @@ public:
   //----------------------------------------------------------------------------
   inline LocationVector getUnlinkedLocations() const override
   {
-    std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    LocationVector unlinked_locations(mFile.unlink_locations().begin(),
-                                      mFile.unlink_locations().end());
+    std::shared_lock<std::shared_timed_mutex> lock(getMutex());
+    LocationVector unlinked_locations(mUnlinkedLocations.begin(),
+                                      mUnlinkedLocations.end());
     return unlinked_locations;
   }
 
@@ -387,8 +397,8 @@ public:
   inline void
   clearUnlinkedLocations() override
   {
-    std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-    mFile.clear_unlink_locations();
+    std::unique_lock<std::shared_timed_mutex> lock(getMutex());
+    mUnlinkedLocations.clear();
   }
 
   //----------------------------------------------------------------------------
@@ -403,8 +413,8 @@ public:
   inline size_t
   getNumUnlinkedLocation() const override
   {
-    std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    return mFile.unlink_locations_size();
+    std::shared_lock<std::shared_timed_mutex> lock(getMutex());
+    return mUnlinkedLocations.size();
   }
 
   //----------------------------------------------------------------------------
@@ -413,8 +423,7 @@ public:
   inline uid_t
   getCUid() const override
   {
-    std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    return mFile.uid();
+    return mUid.load(std::memory_order_relaxed);
   }
 
   //----------------------------------------------------------------------------
@@ -423,8 +432,8 @@ public:
   inline void
   setCUid(uid_t uid) override
   {
-    std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-    mFile.set_uid(uid);
+    std::unique_lock<std::shared_timed_mutex> lock(getMutex());
+    mUid.store(uid, std::memory_order_relaxed);
   }
 
   //----------------------------------------------------------------------------
@@ -433,8 +442,7 @@ public:
   inline gid_t
   getCGid() const override
   {
-    std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    return mFile.gid();
+    return mGid.load(std::memory_order_relaxed);
   }
 
   //----------------------------------------------------------------------------
@@ -443,8 +451,8 @@ public:
   inline void
   setCGid(gid_t gid) override
   {
-    std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-    mFile.set_gid(gid);
+    std::unique_lock<std::shared_timed_mutex> lock(getMutex());
+    mGid.store(gid, std::memory_order_relaxed);
   }
 
   //----------------------------------------------------------------------------
@@ -453,8 +461,7 @@ public:
   inline layoutId_t
   getLayoutId() const override
   {
-    std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    return mFile.layout_id();
+    return mLayoutId.load(std::memory_order_relaxed);
   }
 
   //----------------------------------------------------------------------------
@@ -463,8 +470,8 @@ public:
   inline void
   setLayoutId(layoutId_t layoutId) override
   {
-    std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-    mFile.set_layout_id(layoutId);
+    std::unique_lock<std::shared_timed_mutex> lock(getMutex());
+    mLayoutId.store(layoutId, std::memory_order_relaxed);
   }
 
   //----------------------------------------------------------------------------
@@ -473,8 +480,7 @@ public:
   inline uint16_t
   getFlags() const override
   {
-    std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    return mFile.flags();
+    return mFlags.load(std::memory_order_relaxed);
   }
 
   //----------------------------------------------------------------------------
@@ -483,8 +489,7 @@ public:
   inline bool
   getFlag(uint8_t n) override
   {
-    std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    return (bool)(mFile.flags() & (0x0001 << n));
+    return (bool)(mFlags.load(std::memory_order_relaxed) & (0x0001 << n));
   }
 
   //----------------------------------------------------------------------------
@@ -493,8 +498,8 @@ public:
   inline void
   setFlags(uint16_t flags) override
   {
-    std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-    mFile.set_flags(flags);
+    std::unique_lock<std::shared_timed_mutex> lock(getMutex());
+    mFlags.store(flags, std::memory_order_relaxed);
   }
 
   //----------------------------------------------------------------------------
@@ -503,12 +508,13 @@ public:
   void
   setFlag(uint8_t n, bool flag) override
   {
-    std::unique_lock<std::shared_timed_mutex> lock(mMutex);
+    std::unique_lock<std::shared_timed_mutex> lock(getMutex());
+    uint32_t flags = mFlags.load(std::memory_order_relaxed);
 
     if (flag) {
-      mFile.set_flags(mFile.flags() | (1 << n));
+      mFlags.store(flags | (1 << n), std::memory_order_relaxed);
     } else {
-      mFile.set_flags(mFile.flags() & (~(1 << n)));
+      mFlags.store(flags & (~(1 << n)), std::memory_order_relaxed);
     }
   }
 
@@ -523,7 +529,7 @@ public:
   inline void
   setFileMDSvc(IFileMDSvc* fileMDSvc) override
   {
-    std::unique_lock<std::shared_timed_mutex> lock(mMutex);
+    std::unique_lock<std::shared_timed_mutex> lock(getMutex());
     pFileMDSvc = static_cast<QuarkFileMDSvc*>(fileMDSvc);
   }
 
@@ -533,7 +539,7 @@ public:
   inline virtual IFileMDSvc*
   getFileMDSvc() override
   {
-    std::shared_lock<std::shared_timed_mutex> lock(mMutex);
+    std::shared_lock<std::shared_timed_mutex> lock(getMutex());
     return pFileMDSvc;
   }
 
@@ -543,8 +549,8 @@ public:
   inline std::string
   getLink() const override
   {
-    std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    return mFile.link_name();
+    std::shared_lock<std::shared_timed_mutex> lock(getMutex());
+    return mStrings.get(kLinkName);
   }
 
   //----------------------------------------------------------------------------
@@ -553,8 +559,8 @@ public:
   inline void
   setLink(std::string link_name) override
   {
-    std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-    mFile.set_link_name(link_name);
+    std::unique_lock<std::shared_timed_mutex> lock(getMutex());
+    mStrings.set(kLinkName, link_name);
   }
 
   //----------------------------------------------------------------------------
@@ -563,41 +569,27 @@ public:
   bool
   isLink() const override
   {
-    std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    return !mFile.link_name().empty();
+    std::shared_lock<std::shared_timed_mutex> lock(getMutex());
+    return (mStrings.length(kLinkName) != 0);
   }
 
   //----------------------------------------------------------------------------
   //! Add extended attribute
   //----------------------------------------------------------------------------
-  void
-  setAttribute(const std::string& name, const std::string& value) override
-  {
-    std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-    (*mFile.mutable_xattrs())[name] = value;
-  }
+  void setAttribute(const std::string& name, const std::string& value) override;
 
   //----------------------------------------------------------------------------
   //! Remove attribute
   //----------------------------------------------------------------------------
-  void
-  removeAttribute(const std::string& name) override
-  {
-    std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-    auto it = mFile.xattrs().find(name);
-
-    if (it != mFile.xattrs().end()) {
-      mFile.mutable_xattrs()->erase(it->first);
-    }
-  }
+  void removeAttribute(const std::string& name) override;
 
   //----------------------------------------------------------------------------
   //! Remove all attributes
   //----------------------------------------------------------------------------
   void clearAttributes() override
   {
-    std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-    mFile.clear_xattrs();
+    std::unique_lock<std::shared_timed_mutex> lock(getMutex());
+    mXAttrs.reset();
   }
 
   //----------------------------------------------------------------------------
@@ -606,8 +598,8 @@ public:
   bool
   hasAttribute(const std::string& name) const override
   {
-    std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    return (mFile.xattrs().find(name) != mFile.xattrs().end());
+    std::shared_lock<std::shared_timed_mutex> lock(getMutex());
+    return (findAttributeNoLock(name) != nullptr);
   }
 
   //----------------------------------------------------------------------------
@@ -616,8 +608,8 @@ public:
   inline size_t
   numAttributes() const override
   {
-    std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    return mFile.xattrs().size();
+    std::shared_lock<std::shared_timed_mutex> lock(getMutex());
+    return (mXAttrs ? mXAttrs->size() : 0);
   }
 
   //----------------------------------------------------------------------------
@@ -626,16 +618,16 @@ public:
   std::string
   getAttribute(const std::string& name) const override
   {
-    std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    auto it = mFile.xattrs().find(name);
+    std::shared_lock<std::shared_timed_mutex> lock(getMutex());
+    const PackedStrings<1>* value = findAttributeNoLock(name);
 
-    if (it == mFile.xattrs().end()) {
+    if (value == nullptr) {
       MDException e(ENOENT);
       e.getMessage() << "Attribute: " << name << " not found";
       throw e;
     }
 
-    return it->second;
+    return value->get(0);
   }
 
   //----------------------------------------------------------------------------
@@ -661,17 +653,16 @@ public:
   void deserialize(const Buffer& buffer) override;
 
   //----------------------------------------------------------------------------
-  //! Get reference to underlying protobuf object
+  //! Get protobuf representation of the object, built on demand
   //----------------------------------------------------------------------------
-  const eos::ns::FileMdProto& getProto() const;
+  eos::ns::FileMdProto getProto() const;
 
   //----------------------------------------------------------------------------
   //! Get value tracking changes to the metadata object
   //----------------------------------------------------------------------------
   virtual uint64_t getClock() const override
   {
-    std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    return mClock;
+    return mClock.load(std::memory_order_relaxed);
   };
 
 protected:
@@ -680,6 +671,34 @@ protected:
 private:
   FRIEND_TEST(VariousTests, EtagFormatting);
 
+  //! Number of lock stripes shared by all the objects
+  static constexpr uint32_t kLockStripeBits = 12;
+  static constexpr uint32_t kNumLockStripes = (1u << kLockStripeBits);
+
+  //! Indices of the strings stored in mStrings
+  enum StringIndex { kName = 0, kLinkName, kChecksum, kCloneFst, kNumStrings };
+  //! Indices of the timestamps
+  enum TimeIndex { kCTime = 0, kMTime, kSTime, kNumTimes };
+  //! Extended attributes sorted by name, the names are interned
+  using XAttrVector =
+    std::vector<std::pair<StringInterner::Ptr, PackedStrings<1>>>;
+
+  //----------------------------------------------------------------------------
+  //! Get the mutex protecting this object, no method may call into another
+  //! object while holding it since the two can share the same stripe
+  //----------------------------------------------------------------------------
+  std::shared_timed_mutex& getMutex() const;
+
+  //----------------------------------------------------------------------------
+  //! Get timestamp, no locks but to be called within a sequence lock read
+  //----------------------------------------------------------------------------
+  ctime_t loadTime(TimeIndex idx) const;
+
+  //----------------------------------------------------------------------------
+  //! Set timestamp, to be called with the mutex held exclusively
+  //----------------------------------------------------------------------------
+  void storeTime(TimeIndex idx, const ctime_t& value);
+
   //----------------------------------------------------------------------------
   //! Get modification time, no locks
   //----------------------------------------------------------------------------
@@ -700,9 +719,48 @@ private:
   //----------------------------------------------------------------------------
   bool hasUnlinkedLocationNoLock(location_t location) const;
 
+  //----------------------------------------------------------------------------
+  //! Find attribute value, no locks
+  //!
+  //! @return pointer to the value or nullptr if not found
+  //----------------------------------------------------------------------------
+  const PackedStrings<1>* findAttributeNoLock(const std::string& name) const;
+
+  //----------------------------------------------------------------------------
+  //! Build the protobuf representation, no locks
+  //----------------------------------------------------------------------------
+  void toProtoNoLock(eos::ns::FileMdProto& proto) const;
+
+  //----------------------------------------------------------------------------
+  //! Load the protobuf representation, to be called with the mutex held
+  //! exclusively
+  //----------------------------------------------------------------------------
+  void fromProtoNoLock(const eos::ns::FileMdProto& proto);
+
+  //----------------------------------------------------------------------------
+  //! Copy the contents of the given object, to be called with this mutex
+  //! held exclusively and the other one at least shared
+  //----------------------------------------------------------------------------
+  void copyNoLock(const QuarkFileMD& other);
 
-  eos::ns::FileMdProto mFile; ///< Protobuf file representation
-  uint64_t mClock; ///< Value tracking metadata changes
+  std::atomic<uint64_t> mId; ///< File id
+  std::atomic<uint64_t> mContId; ///< Parent container id
+  std::atomic<uint64_t> mSize; ///< File size
+  std::atomic<uint64_t> mCloneId; ///< Clone id
+  std::atomic<uint64_t> mClock; ///< Value tracking metadata changes
+  std::atomic<int64_t> mTimeSec[kNumTimes]; ///< Seconds of the timestamps
+  std::atomic<uint32_t> mTimeNsec[kNumTimes]; ///< Nanoseconds of timestamps
+  std::atomic<uint32_t> mUid; ///< Owner uid
+  std::atomic<uint32_t> mGid; ///< Owner gid
+  std::atomic<uint32_t> mLayoutId; ///< Layout id
+  std::atomic<uint32_t> mFlags; ///< File flags
+  std::atomic<uint8_t> mTimeMask; ///< Bit per timestamp which is set
+  SeqLock mTimeSeq; ///< Sequence lock protecting the timestamps
+  //! Name, link name, checksum and clone FST in one allocation
+  PackedStrings<kNumStrings> mStrings;
+  InlineVector<location_t, 4> mLocations; ///< Locations
+  InlineVector<location_t, 2> mUnlinkedLocations; ///< Unlinked locations
+  std::unique_ptr<XAttrVector> mXAttrs; ///< Extended attributes, if any
 };
 
 EOSNSNAMESPACE_END
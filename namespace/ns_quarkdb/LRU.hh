@@ -18,7 +18,7 @@
 
 //------------------------------------------------------------------------------
 //! @author Elvin-Alin Sindrilaru <esindril@cern.ch>
-//! @brief LRU cache for namespace objects making sure we never evict an entry
+//! @brief Cache for namespace objects making sure we never evict an entry
 //!        which is still referenced in other parts of the program.
 //------------------------------------------------------------------------------
 
@@ -30,11 +30,17 @@
 #include "common/Murmur3.hh"
 #include "namespace/Namespace.hh"
 #include <google/dense_hash_map>
+#include <algorithm>
+#include <atomic>
 #include <cstdint>
+#include <deque>
 #include <list>
+#include <functional>
 #include <map>
 #include <memory>
 #include <mutex>
+#include <utility>
+#include <vector>
 
 EOSNSNAMESPACE_BEGIN
 
@@ -64,18 +70,49 @@ struct hasGetId {
 };
 
 //------------------------------------------------------------------------------
-//! LRU cache for namespace entries
+//! Cache for namespace entries
+//!
+//! Despite the name, the eviction policy is S3-FIFO rather than LRU: new
+//! entries go to a small FIFO queue and are only promoted to the main queue
+//! if they are accessed again before reaching its head. Entries evicted from
+//! the small queue are remembered in a ghost queue so that they are admitted
+//! directly to the main queue when they come back. Entries in the main queue
+//! get a second chance for each access (up to 3) instead of being moved on
+//! every hit. This way a single scan over the namespace (find, fsck, dump)
+//! can not flush the working set and a cache hit only bumps a counter.
+//!
+//! The cache is split into stripes, each with its own lock and a proportional
+//! share of the limits, to reduce contention between concurrent lookups.
+//! The limits can be expressed both in number of entries and in bytes, the
+//! cost of an entry being given by a user supplied function.
 //------------------------------------------------------------------------------
 template <typename IdT, typename EntryT>
 class LRU
 {
 public:
+  //! Function estimating the memory cost of an entry in bytes
+  using CostFunction = std::function<std::uint64_t(const EntryT&)>;
+
+  //----------------------------------------------------------------------------
+  //! Cache statistics
+  //----------------------------------------------------------------------------
+  struct Statistics {
+    std::uint64_t mHits {0}; ///< Number of successful lookups
+    std::uint64_t mMisses {0}; ///< Number of failed lookups
+    std::uint64_t mEvictions {0}; ///< Number of entries evicted
+    std::uint64_t mBytes {0}; ///< Estimated size of the cached entries
+  };
+
   //----------------------------------------------------------------------------
   //! Constructor
   //!
-  //! @param maxSize maximum number of entries in the cache
+  //! @param max_num maximum number of entries in the cache
+  //! @param num_stripes number of independently locked stripes
+  //! @param cost function estimating the size of an entry, if empty then
+  //!        sizeof(EntryT) is used
   //----------------------------------------------------------------------------
-  LRU(std::uint64_t maxSize);
+  LRU(std::uint64_t max_num, std::uint32_t num_stripes = 1,
+      CostFunction cost = CostFunction());
 
   //----------------------------------------------------------------------------
   //! Destructor
@@ -86,10 +123,12 @@ public:
   //! Get entry
   //!
   //! @param id entry id
+  //! @param count_stats if false, the lookup is not accounted in the hit and
+  //!        miss counters e.g. when retrying a lookup that just missed
   //!
   //! @return shared ptr to requested object or nullptr if not found
   //----------------------------------------------------------------------------
-  std::shared_ptr<EntryT> get(IdT id);
+  std::shared_ptr<EntryT> get(IdT id, bool count_stats = true);
 
   //----------------------------------------------------------------------------
   //! Put entry
@@ -97,9 +136,10 @@ public:
   //! @param id entry id
   //! @param entry entry object
   //!
-  //! @return true if successfully added to the cache, false otherwise. If
-  //!         cache is full then the least recently used entry is evicted
-  //!         provided that it's not referenced anywhere else in the program.
+  //! @return the cached object for the given id, which is the existing one
+  //!         if the id was already present. If the cache is full then some
+  //!         entries are evicted provided that they're not referenced
+  //!         anywhere else in the program.
   //----------------------------------------------------------------------------
   typename
   std::enable_if<hasGetId<EntryT>::value, std::shared_ptr<EntryT>>::type
@@ -119,12 +159,7 @@ public:
   //!
   //! @return cache size
   //----------------------------------------------------------------------------
-  inline std::uint64_t
-  size() const
-  {
-    std::unique_lock<std::mutex> lock(mMutex);
-    return mMap.size();
-  }
+  std::uint64_t size() const;
 
   //----------------------------------------------------------------------------
   //! Get maximim number of entries in the cache
@@ -134,32 +169,54 @@ public:
   inline std::uint64_t
   get_max_num() const
   {
-    std::unique_lock<std::mutex> lock(mMutex);
     return mMaxNum;
   }
 
   //----------------------------------------------------------------------------
-  //! Set max num entries
+  //! Get maximum size of the cache in bytes
   //!
-  //! @param max_num new maximum number of entries, if 0 then just drop the
-  //!                the current cache
+  //! @return maximum cache size, 0 if unlimited
   //----------------------------------------------------------------------------
-  inline void
-  set_max_num(const std::uint64_t max_num)
+  inline std::uint64_t
+  get_max_size() const
   {
-    std::unique_lock<std::mutex> lock(mMutex);
-
-    if (max_num == 0ull) {
-      // Flush and disable cache
-      Purge(0.0);
-      mMaxNum = 0ull;
-    } else if (max_num == UINT64_MAX) {
-      Purge(0.0); // Flush cache
-    } else {
-      mMaxNum = max_num;
-    }
+    return mMaxSize;
   }
 
+  //----------------------------------------------------------------------------
+  //! Set max num entries
+  //!
+  //! @param max_num new maximum number of entries, if 0 then drop the current
+  //!        cache and disable it, if UINT64_MAX then just drop the cache
+  //----------------------------------------------------------------------------
+  void set_max_num(const std::uint64_t max_num);
+
+  //----------------------------------------------------------------------------
+  //! Set max size in bytes
+  //!
+  //! @param max_size new maximum size, if 0 then the size is not limited, if
+  //!        UINT64_MAX then the limit is not changed
+  //----------------------------------------------------------------------------
+  void set_max_size(const std::uint64_t max_size);
+
+  //----------------------------------------------------------------------------
+  //! Get cache statistics
+  //----------------------------------------------------------------------------
+  Statistics get_stats() const;
+
+  //----------------------------------------------------------------------------
+  //! Get the ids of the hot entries, i.e. the ones in the main queue or
+  //! accessed since their insertion, with a score from 1 to 7 ranking them:
+  //! the access count (up to 3), plus 4 if the entry is in the main queue
+  //!
+  //! @param max_num maximum number of ids to return, the best scored ones
+  //!        are kept if there are more
+  //!
+  //! @return ids and their scores, in no particular order
+  //----------------------------------------------------------------------------
+  std::vector<std::pair<IdT, std::uint8_t>>
+  get_hot_ids(std::uint64_t max_num) const;
+
   //----------------------------------------------------------------------------
   //! Forbid copying or moving LRU objects
   //----------------------------------------------------------------------------
@@ -169,6 +226,41 @@ public:
   LRU& operator=(LRU&& other) = delete;
 
 private:
+  //----------------------------------------------------------------------------
+  //! Cached entry
+  //----------------------------------------------------------------------------
+  struct Node {
+    IdT mId;
+    std::shared_ptr<EntryT> mEntry;
+    std::uint64_t mCost;
+    std::uint8_t mFreq; ///< Accesses since insertion or last second chance
+    bool mInMain; ///< True if in the main queue, otherwise in the small one
+  };
+
+  using QueueT = std::list<Node>;
+  using MapT = google::dense_hash_map<IdT, typename QueueT::iterator,
+        Murmur3::MurmurHasher<IdT>>;
+  using GhostMapT = google::dense_hash_map<IdT, std::uint64_t,
+        Murmur3::MurmurHasher<IdT>>;
+  //! Batch of evicted entries handed over to the cleaner thread
+  using BatchT = std::vector<std::shared_ptr<EntryT>>;
+
+  //----------------------------------------------------------------------------
+  //! Independently locked part of the cache
+  //----------------------------------------------------------------------------
+  struct Stripe {
+    mutable std::mutex mMutex;
+    MapT mMap; ///< Map pointing to the entry in one of the queues
+    QueueT mSmall; ///< Newly inserted entries, oldest at the front
+    QueueT mMain; ///< Entries accessed while in the small queue
+    //! Ids recently evicted from the small queue, an id might also be
+    //! present in the queue after leaving the ghost map
+    std::deque<IdT> mGhost;
+    GhostMapT mGhostMap; ///< Ghost id to its sequence number in the queue
+    std::uint64_t mGhostSeq {0}; ///< Sequence number of the last ghost
+    std::uint64_t mBytes {0};
+    Statistics mStats;
+  };
 
   //----------------------------------------------------------------------------
   //! Cleaner job taking care of deallocating entries that are passed through
@@ -177,44 +269,112 @@ private:
   void CleanerJob(ThreadAssistant& assistant);
 
   //----------------------------------------------------------------------------
-  //! Purge entries until stop ratio is achieved
+  //! Get stripe responsible for the given id
+  //----------------------------------------------------------------------------
+  inline Stripe&
+  GetStripe(IdT id)
+  {
+    // Use the upper bits, the lower ones are used by the stripe's hash map
+    uint64_t hash = Murmur3::MurmurHasher<IdT>()(id);
+    return *mStripes[(hash >> 32) % mStripes.size()];
+  }
+
+  //----------------------------------------------------------------------------
+  //! Check if the stripe is above the given fraction of its limits
+  //!
+  //! @param ratio fraction of the limits
+  //! @param extra bytes about to be added to the stripe
+  //!
+  //! @note Must be called with the stripe mutex locked.
+  //----------------------------------------------------------------------------
+  bool IsAbove(const Stripe& stripe, double ratio, std::uint64_t extra) const;
+
+  //----------------------------------------------------------------------------
+  //! Evict entries until the stripe is below the given fraction of its limits
+  //! or only referenced entries are left
   //!
   //! @param stop_ratio stop purge ratio
-  //! @note This method must be called with the mutex protecting the map and
-  //! the list locked.
+  //! @param extra bytes about to be added to the stripe
+  //!
+  //! @note Must be called with the stripe mutex locked.
   //----------------------------------------------------------------------------
-  void Purge(double stop_ratio);
+  void Purge(Stripe& stripe, double stop_ratio, std::uint64_t extra = 0);
+
+  //----------------------------------------------------------------------------
+  //! Evict one entry from the small queue, promoting the accessed ones
+  //!
+  //! @return true if an entry was evicted
+  //----------------------------------------------------------------------------
+  bool EvictSmall(Stripe& stripe, std::uint64_t& budget, BatchT& batch);
+
+  //----------------------------------------------------------------------------
+  //! Evict one entry from the main queue, giving a second chance to the
+  //! accessed ones
+  //!
+  //! @return true if an entry was evicted
+  //----------------------------------------------------------------------------
+  bool EvictMain(Stripe& stripe, std::uint64_t& budget, BatchT& batch);
+
+  //----------------------------------------------------------------------------
+  //! Drop entry from the stripe and add it to the batch for the cleaner
+  //----------------------------------------------------------------------------
+  void Evict(Stripe& stripe, QueueT& queue, typename QueueT::iterator it,
+             BatchT& batch);
+
+  //----------------------------------------------------------------------------
+  //! Hand over a batch of evicted entries to the cleaner thread
+  //----------------------------------------------------------------------------
+  void Release(BatchT& batch);
+
+  //----------------------------------------------------------------------------
+  //! Drop all entries which are not referenced anywhere else
+  //----------------------------------------------------------------------------
+  void Flush(Stripe& stripe);
 
   //! Percentage at which the cache purging stops
   static constexpr double sPurgeStopRatio = 0.9;
-  using ListT = std::list<std::shared_ptr<EntryT>>;
-  typename std::list<std::shared_ptr<EntryT>>::iterator ListIterT;
-  //using MapT = std::map<IdT, decltype(ListIterT)>;
-  using MapT = google::dense_hash_map<IdT, decltype(ListIterT),
-        Murmur3::MurmurHasher<IdT>>;
-  MapT mMap;   ///< Internal map pointing to obj in list
-  ListT mList; ///< Internal list of objects where new/used objects are at the
-  ///< end of the list
-  //! Mutext to protect access to the map and list
-  mutable std::mutex mMutex;
-  std::uint64_t mMaxNum; ///< Maximum number of entries
-  eos::common::ConcurrentQueue< std::shared_ptr<EntryT> > mToDelete;
+  //! Fraction of the stripe limits given to the small queue
+  static constexpr double sSmallRatio = 0.1;
+  std::vector<std::unique_ptr<Stripe>> mStripes;
+  CostFunction mCost; ///< Entry cost estimation
+  std::atomic<std::uint64_t> mMaxNum; ///< Maximum number of entries
+  std::atomic<std::uint64_t> mMaxSize {0}; ///< Maximum size in bytes, 0 unlimited
+  eos::common::ConcurrentQueue<BatchT> mToDelete;
   AssistedThread mCleanerThread; ///< Thread doing the deallocations
 };
 
 // Definition of class static member
 template <typename IdT, typename EntryT>
 constexpr double LRU<IdT, EntryT>::sPurgeStopRatio;
+template <typename IdT, typename EntryT>
+constexpr double LRU<IdT, EntryT>::sSmallRatio;
 
 //------------------------------------------------------------------------------
 // Constructor
 //------------------------------------------------------------------------------
 template <typename IdT, typename EntryT>
-LRU<IdT, EntryT>::LRU(std::uint64_t max_num) :
-  mMap(), mList(), mMutex(), mMaxNum(max_num), mToDelete()
+LRU<IdT, EntryT>::LRU(std::uint64_t max_num, std::uint32_t num_stripes,
+                      CostFunction cost) :
+  mCost(cost), mMaxNum(max_num), mToDelete()
 {
-  mMap.set_empty_key(IdT(UINT64_MAX - 1));
-  mMap.set_deleted_key(IdT(UINT64_MAX));
+  if (num_stripes == 0) {
+    num_stripes = 1;
+  }
+
+  if (!mCost) {
+    mCost = [](const EntryT&) -> std::uint64_t {
+      return sizeof(EntryT);
+    };
+  }
+
+  for (std::uint32_t i = 0; i < num_stripes; ++i) {
+    mStripes.emplace_back(new Stripe());
+    mStripes.back()->mMap.set_empty_key(IdT(UINT64_MAX - 1));
+    mStripes.back()->mMap.set_deleted_key(IdT(UINT64_MAX));
+    mStripes.back()->mGhostMap.set_empty_key(IdT(UINT64_MAX - 1));
+    mStripes.back()->mGhostMap.set_deleted_key(IdT(UINT64_MAX));
+  }
+
   mCleanerThread.reset(&LRU::CleanerJob, this);
 }
 
@@ -224,13 +384,17 @@ LRU<IdT, EntryT>::LRU(std::uint64_t max_num) :
 template <typename IdT, typename EntryT>
 LRU<IdT, EntryT>::~LRU()
 {
-  std::shared_ptr<EntryT> sentinel(nullptr);
+  BatchT sentinel;
   mCleanerThread.stop();
   mToDelete.push(sentinel);
   mCleanerThread.join();
-  std::unique_lock<std::mutex> lock(mMutex);
-  mMap.clear();
-  mList.clear();
+
+  for (auto& stripe : mStripes) {
+    std::unique_lock<std::mutex> lock(stripe->mMutex);
+    stripe->mMap.clear();
+    stripe->mSmall.clear();
+    stripe->mMain.clear();
+  }
 }
 
 //------------------------------------------------------------------------------
@@ -238,20 +402,32 @@ LRU<IdT, EntryT>::~LRU()
 //------------------------------------------------------------------------------
 template <typename IdT, typename EntryT>
 std::shared_ptr<EntryT>
-LRU<IdT, EntryT>::get(IdT id)
+LRU<IdT, EntryT>::get(IdT id, bool count_stats)
 {
-  std::unique_lock<std::mutex> lock(mMutex);
-  auto iter_map = mMap.find(id);
+  Stripe& stripe = GetStripe(id);
+  std::unique_lock<std::mutex> lock(stripe.mMutex);
+  auto iter_map = stripe.mMap.find(id);
+
+  if (iter_map == stripe.mMap.end()) {
+    if (count_stats) {
+      ++stripe.mStats.mMisses;
+    }
 
-  if (iter_map == mMap.end()) {
     return nullptr;
   }
 
-  // Move object to the end of the list i.e. recently accessed
-  auto iter_new = mList.insert(mList.end(), *iter_map->second);
-  mList.erase(iter_map->second);
-  iter_map->second = iter_new;
-  return *iter_new;
+  if (count_stats) {
+    ++stripe.mStats.mHits;
+  }
+
+  // Only record the access, the queues are left untouched
+  Node& node = *iter_map->second;
+
+  if (node.mFreq < 3) {
+    ++node.mFreq;
+  }
+
+  return node.mEntry;
 }
 
 //------------------------------------------------------------------------------
@@ -261,27 +437,39 @@ template <typename IdT, typename EntryT>
 typename std::enable_if<hasGetId<EntryT>::value, std::shared_ptr<EntryT>>::type
     LRU<IdT, EntryT>::put(IdT id, std::shared_ptr<EntryT> obj)
 {
-  std::unique_lock<std::mutex> lock(mMutex);
-
   if (mMaxNum == 0ull) {
     return obj;
   }
 
-  auto iter_map = mMap.find(id);
+  // Compute the cost outside the lock, it might need to lock the entry
+  std::uint64_t cost = mCost(*obj);
+  Stripe& stripe = GetStripe(id);
+  std::unique_lock<std::mutex> lock(stripe.mMutex);
+  auto iter_map = stripe.mMap.find(id);
 
-  if (iter_map != mMap.end()) {
-    return *(iter_map->second);
+  if (iter_map != stripe.mMap.end()) {
+    return iter_map->second->mEntry;
   }
 
-  // Check if map full and purge some entries if necessary 10% of max size
-  if (mMap.size() >= mMaxNum) {
-    Purge(sPurgeStopRatio);
+  // Check if the stripe is full and purge some entries if necessary
+  if ((stripe.mMap.size() + 1 > (double) mMaxNum / mStripes.size()) ||
+      IsAbove(stripe, 1.0, cost)) {
+    Purge(stripe, sPurgeStopRatio, cost);
   }
 
-  // @todo (esindril): add time based and for a fixed number of entries purging
-  auto iter = mList.insert(mList.end(), obj);
-  mMap[id] = iter;
-  return *iter;
+  // Entries evicted recently from the small queue go directly to main
+  auto iter_ghost = stripe.mGhostMap.find(id);
+  bool in_main = (iter_ghost != stripe.mGhostMap.end());
+
+  if (in_main) {
+    stripe.mGhostMap.erase(iter_ghost);
+  }
+
+  QueueT& queue = (in_main ? stripe.mMain : stripe.mSmall);
+  auto iter = queue.insert(queue.end(), Node{id, obj, cost, 0, in_main});
+  stripe.mMap[id] = iter;
+  stripe.mBytes += cost;
+  return obj;
 }
 
 //------------------------------------------------------------------------------
@@ -291,18 +479,143 @@ template <typename IdT, typename EntryT>
 bool
 LRU<IdT, EntryT>::remove(IdT id)
 {
-  std::unique_lock<std::mutex> lock(mMutex);
-  auto iter_map = mMap.find(id);
+  Stripe& stripe = GetStripe(id);
+  std::unique_lock<std::mutex> lock(stripe.mMutex);
+  auto iter_map = stripe.mMap.find(id);
 
-  if (iter_map == mMap.end()) {
+  if (iter_map == stripe.mMap.end()) {
     return false;
   }
 
-  (void)mList.erase(iter_map->second);
-  mMap.erase(iter_map);
+  auto iter = iter_map->second;
+  stripe.mBytes -= iter->mCost;
+  (iter->mInMain ? stripe.mMain : stripe.mSmall).erase(iter);
+  stripe.mMap.erase(iter_map);
   return true;
 }
 
+//------------------------------------------------------------------------------
+// Get cache size
+//------------------------------------------------------------------------------
+template <typename IdT, typename EntryT>
+std::uint64_t
+LRU<IdT, EntryT>::size() const
+{
+  std::uint64_t total = 0;
+
+  for (const auto& stripe : mStripes) {
+    std::unique_lock<std::mutex> lock(stripe->mMutex);
+    total += stripe->mMap.size();
+  }
+
+  return total;
+}
+
+//------------------------------------------------------------------------------
+// Set max num entries
+//------------------------------------------------------------------------------
+template <typename IdT, typename EntryT>
+void
+LRU<IdT, EntryT>::set_max_num(const std::uint64_t max_num)
+{
+  if (max_num == 0ull) {
+    // Flush and disable cache
+    mMaxNum = 0ull;
+
+    for (auto& stripe : mStripes) {
+      std::unique_lock<std::mutex> lock(stripe->mMutex);
+      Flush(*stripe);
+    }
+  } else if (max_num == UINT64_MAX) {
+    // Flush cache
+    for (auto& stripe : mStripes) {
+      std::unique_lock<std::mutex> lock(stripe->mMutex);
+      Flush(*stripe);
+    }
+  } else {
+    mMaxNum = max_num;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Set max size in bytes
+//------------------------------------------------------------------------------
+template <typename IdT, typename EntryT>
+void
+LRU<IdT, EntryT>::set_max_size(const std::uint64_t max_size)
+{
+  if (max_size == UINT64_MAX) {
+    return;
+  }
+
+  mMaxSize = max_size;
+
+  for (auto& stripe : mStripes) {
+    std::unique_lock<std::mutex> lock(stripe->mMutex);
+
+    if (IsAbove(*stripe, 1.0, 0)) {
+      Purge(*stripe, sPurgeStopRatio);
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Get cache statistics
+//------------------------------------------------------------------------------
+template <typename IdT, typename EntryT>
+typename LRU<IdT, EntryT>::Statistics
+LRU<IdT, EntryT>::get_stats() const
+{
+  Statistics total;
+
+  for (const auto& stripe : mStripes) {
+    std::unique_lock<std::mutex> lock(stripe->mMutex);
+    total.mHits += stripe->mStats.mHits;
+    total.mMisses += stripe->mStats.mMisses;
+    total.mEvictions += stripe->mStats.mEvictions;
+    total.mBytes += stripe->mBytes;
+  }
+
+  return total;
+}
+
+//------------------------------------------------------------------------------
+// Get the ids of the hot entries with their score
+//------------------------------------------------------------------------------
+template <typename IdT, typename EntryT>
+std::vector<std::pair<IdT, std::uint8_t>>
+LRU<IdT, EntryT>::get_hot_ids(std::uint64_t max_num) const
+{
+  std::vector<std::pair<IdT, std::uint8_t>> hot;
+
+  for (const auto& stripe : mStripes) {
+    std::unique_lock<std::mutex> lock(stripe->mMutex);
+
+    for (const QueueT* queue : {
+           &stripe->mMain, &stripe->mSmall
+         }) {
+      for (const auto& node : *queue) {
+        std::uint8_t score = node.mFreq + (node.mInMain ? 4 : 0);
+
+        if (score) {
+          hot.emplace_back(node.mId, score);
+        }
+      }
+    }
+  }
+
+  if (hot.size() > max_num) {
+    std::nth_element(hot.begin(), hot.begin() + max_num, hot.end(),
+    [](const std::pair<IdT, std::uint8_t>& a,
+       const std::pair<IdT, std::uint8_t>& b) {
+      return a.second > b.second;
+    });
+    hot.resize(max_num);
+  }
+
+  return hot;
+}
+
 //----------------------------------------------------------------------------
 // Cleaner job taking care of deallocating entries that are passed through
 // the queue to delete
@@ -311,44 +624,194 @@ template <typename IdT, typename EntryT>
 void
 LRU<IdT, EntryT>::CleanerJob(ThreadAssistant& assistant)
 {
-  std::shared_ptr<EntryT> tmp;
+  BatchT tmp;
 
   while (!assistant.terminationRequested()) {
     while (true) {
       mToDelete.wait_pop(tmp);
 
-      if (tmp == nullptr) {
+      if (tmp.empty()) {
         break;
       } else {
-        tmp.reset();
+        tmp.clear();
       }
     }
   }
 }
 
 //------------------------------------------------------------------------------
-// Purge entries until stop ratio is achieved
+// Check if the stripe is above the given fraction of its limits
+//------------------------------------------------------------------------------
+template <typename IdT, typename EntryT>
+bool
+LRU<IdT, EntryT>::IsAbove(const Stripe& stripe, double ratio,
+                          std::uint64_t extra) const
+{
+  const double num_stripes = mStripes.size();
+  const std::uint64_t max_size = mMaxSize;
+
+  if (stripe.mMap.size() > ratio * mMaxNum / num_stripes) {
+    return true;
+  }
+
+  return (max_size && (stripe.mBytes + extra > ratio * max_size / num_stripes));
+}
+
+//------------------------------------------------------------------------------
+// Evict entries until the stripe is below the given fraction of its limits
 //------------------------------------------------------------------------------
 template <typename IdT, typename EntryT>
 void
-LRU<IdT, EntryT>::Purge(double stop_ratio)
+LRU<IdT, EntryT>::Purge(Stripe& stripe, double stop_ratio, std::uint64_t extra)
 {
-  auto iter = mList.begin();
+  // Every entry can be skipped a few times because it's referenced or was
+  // accessed, bound the work in case everything is pinned
+  std::uint64_t budget = 8 * (stripe.mMap.size() + 1);
+  BatchT batch;
+
+  while (IsAbove(stripe, stop_ratio, extra) && budget) {
+    bool evicted = false;
+
+    if ((stripe.mSmall.size() > sSmallRatio * stripe.mMap.size()) ||
+        stripe.mMain.empty()) {
+      evicted = EvictSmall(stripe, budget, batch);
+    }
+
+    if (!evicted && !EvictMain(stripe, budget, batch) &&
+        stripe.mSmall.empty()) {
+      break;
+    }
+  }
+
+  // Bound the ghost queue to the number of cached entries
+  while (stripe.mGhost.size() > stripe.mMap.size()) {
+    auto iter_ghost = stripe.mGhostMap.find(stripe.mGhost.front());
+
+    // Skip ids readmitted or evicted again since this queue entry was added
+    if ((iter_ghost != stripe.mGhostMap.end()) &&
+        (iter_ghost->second == stripe.mGhostSeq - stripe.mGhost.size() + 1)) {
+      stripe.mGhostMap.erase(iter_ghost);
+    }
+
+    stripe.mGhost.pop_front();
+  }
+
+  stripe.mMap.resize(0); // compact after deletion
+  Release(batch);
+}
+
+//------------------------------------------------------------------------------
+// Evict one entry from the small queue, promoting the accessed ones
+//------------------------------------------------------------------------------
+template <typename IdT, typename EntryT>
+bool
+LRU<IdT, EntryT>::EvictSmall(Stripe& stripe, std::uint64_t& budget,
+                             BatchT& batch)
+{
+  while (!stripe.mSmall.empty() && budget) {
+    --budget;
+    auto iter = stripe.mSmall.begin();
+
+    // Entries accessed or still referenced move to the main queue
+    if (iter->mFreq || (iter->mEntry.use_count() > 1)) {
+      iter->mFreq = 0;
+      iter->mInMain = true;
+      stripe.mMain.splice(stripe.mMain.end(), stripe.mSmall, iter);
+      continue;
+    }
+
+    stripe.mGhost.push_back(iter->mId);
+    stripe.mGhostMap[iter->mId] = ++stripe.mGhostSeq;
+    Evict(stripe, stripe.mSmall, iter, batch);
+    return true;
+  }
+
+  return false;
+}
+
+//------------------------------------------------------------------------------
+// Evict one entry from the main queue, giving a second chance to the
+// accessed ones
+//------------------------------------------------------------------------------
+template <typename IdT, typename EntryT>
+bool
+LRU<IdT, EntryT>::EvictMain(Stripe& stripe, std::uint64_t& budget,
+                            BatchT& batch)
+{
+  while (!stripe.mMain.empty() && budget) {
+    --budget;
+    auto iter = stripe.mMain.begin();
 
-  while ((iter != mList.end()) &&
-         (mMap.size() > stop_ratio * mMaxNum)) {
     // If object is referenced also by someone else then skip it
-    if (iter->use_count() > 1) {
-      ++iter;
+    if (iter->mFreq || (iter->mEntry.use_count() > 1)) {
+      if (iter->mFreq) {
+        --iter->mFreq;
+      }
+
+      stripe.mMain.splice(stripe.mMain.end(), stripe.mMain, iter);
       continue;
     }
 
-    mMap.erase(IdT((*iter)->getId()));
-    mToDelete.push(*iter);
-    iter = mList.erase(iter);
+    Evict(stripe, stripe.mMain, iter, batch);
+    return true;
+  }
+
+  return false;
+}
+
+//------------------------------------------------------------------------------
+// Drop entry from the stripe and add it to the batch for the cleaner
+//------------------------------------------------------------------------------
+template <typename IdT, typename EntryT>
+void
+LRU<IdT, EntryT>::Evict(Stripe& stripe, QueueT& queue,
+                        typename QueueT::iterator iter, BatchT& batch)
+{
+  stripe.mMap.erase(iter->mId);
+  stripe.mBytes -= iter->mCost;
+  ++stripe.mStats.mEvictions;
+  batch.push_back(std::move(iter->mEntry));
+  queue.erase(iter);
+}
+
+//------------------------------------------------------------------------------
+// Hand over a batch of evicted entries to the cleaner thread
+//------------------------------------------------------------------------------
+template <typename IdT, typename EntryT>
+void
+LRU<IdT, EntryT>::Release(BatchT& batch)
+{
+  // An empty batch is the signal for the cleaner thread to stop
+  if (!batch.empty()) {
+    mToDelete.emplace(std::move(batch));
+  }
+}
+
+//------------------------------------------------------------------------------
+// Drop all entries which are not referenced anywhere else
+//------------------------------------------------------------------------------
+template <typename IdT, typename EntryT>
+void
+LRU<IdT, EntryT>::Flush(Stripe& stripe)
+{
+  BatchT batch;
+
+  for (auto* queue : {&stripe.mSmall, &stripe.mMain}) {
+    auto iter = queue->begin();
+
+    while (iter != queue->end()) {
+      auto current = iter++;
+
+      if (current->mEntry.use_count() == 1) {
+        Evict(stripe, *queue, current, batch);
+      }
+    }
   }
 
-  mMap.resize(0); // compact after deletion
+  stripe.mGhost.clear();
+  stripe.mGhostMap.clear();
+  stripe.mMap.resize(0);
+  Release(batch);
 }
 
 EOSNSNAMESPACE_END
@@ -31,7 +31,9 @@
 #include "namespace/ns_quarkdb/accounting/QuotaStats.hh"
 #include "namespace/ns_quarkdb/accounting/ContainerAccounting.hh"
 #include "namespace/ns_quarkdb/CacheRefreshListener.hh"
+#include "namespace/ns_quarkdb/CacheWarmer.hh"
 #include "namespace/ns_quarkdb/VersionEnforcement.hh"
+#include "common/ParseUtils.hh"
 #include <folly/executors/IOThreadPoolExecutor.h>
 
 EOSNSNAMESPACE_BEGIN
@@ -49,6 +51,7 @@ QuarkNamespaceGroup::QuarkNamespaceGroup()
 //------------------------------------------------------------------------------
 QuarkNamespaceGroup::~QuarkNamespaceGroup()
 {
+  mCacheWarmer.reset();
   mCacheRefreshListener.reset();
   mSyncAccounting.reset();
   mContainerAccounting.reset();
@@ -122,6 +125,56 @@ bool QuarkNamespaceGroup::initialize(eos::common::RWMutex* nsMtx,
   }
 
   flusherQuotaTag = it->second;
+  // Optional configuration: qdb_flusher_coalesce_ms
+  it = config.find("qdb_flusher_coalesce_ms");
+
+  if (it != config.end()) {
+    uint64_t window_ms = 0;
+
+    if (!eos::common::ParseUInt64(it->second, window_ms)) {
+      err = "could not parse qdb_flusher_coalesce_ms!";
+      return false;
+    }
+
+    flusherCoalesceWindow = std::chrono::milliseconds(window_ms);
+  }
+
+  // Optional configuration: cache_snapshot_path
+  it = config.find("cache_snapshot_path");
+
+  if (it != config.end()) {
+    cacheSnapshotPath = it->second;
+  }
+
+  // Optional configuration: cache_snapshot_interval, 0 disables the warm-up
+  it = config.find("cache_snapshot_interval");
+
+  if (it != config.end()) {
+    uint64_t interval_sec = 0;
+
+    if (!eos::common::ParseUInt64(it->second, interval_sec)) {
+      err = "could not parse cache_snapshot_interval!";
+      return false;
+    }
+
+    if (interval_sec == 0) {
+      cacheSnapshotPath.clear();
+    } else {
+      cacheSnapshotInterval = std::chrono::seconds(interval_sec);
+    }
+  }
+
+  // Optional configuration: large_container_threshold, 0 disables the point
+  // lookups in large containers
+  it = config.find("large_container_threshold");
+
+  if (it != config.end()) {
+    if (!eos::common::ParseUInt64(it->second, largeContainerThreshold)) {
+      err = "could not parse large_container_threshold!";
+      return false;
+    }
+  }
+
   mPerfMonitor = std::make_shared<eos::QClPerfMonitor>();
 
   if (!enforceQuarkDBVersion(getQClient())) {
@@ -192,6 +245,7 @@ IView* QuarkNamespaceGroup::getHierarchicalView()
                             getQuotaFlusher()));
     mHierarchicalView->setFileMDSvc(getFileService());
     mHierarchicalView->setContainerMDSvc(getContainerService());
+    mHierarchicalView->setLargeContainerThreshold(largeContainerThreshold);
   }
 
   return mHierarchicalView.get();
@@ -222,7 +276,7 @@ IFileMDChangeListener* QuarkNamespaceGroup::getContainerAccountingView()
 
   if (!mContainerAccounting) {
     mContainerAccounting.reset(new QuarkContainerAccounting(getContainerService(),
-                               mNsMutex));
+                               mNsMutex, 5, &mContainerLocks));
     getFileService()->addChangeListener(mContainerAccounting.get());
     getContainerService()->setContainerAccounting(mContainerAccounting.get());
   }
@@ -263,7 +317,8 @@ MetadataFlusher* QuarkNamespaceGroup::getMetadataFlusher()
 
   if (!mMetadataFlusher) {
     std::string path = SSTR(queuePath << "/" << flusherMDTag);
-    mMetadataFlusher.reset(new MetadataFlusher(path, contactDetails));
+    mMetadataFlusher.reset(new MetadataFlusher(path, contactDetails,
+                           flusherCoalesceWindow));
   }
 
   return mMetadataFlusher.get();
@@ -278,7 +333,8 @@ MetadataFlusher* QuarkNamespaceGroup::getQuotaFlusher()
 
   if (!mQuotaFlusher) {
     std::string path = SSTR(queuePath << "/" << flusherQuotaTag);
-    mQuotaFlusher.reset(new MetadataFlusher(path, contactDetails));
+    mQuotaFlusher.reset(new MetadataFlusher(path, contactDetails,
+                        flusherCoalesceWindow));
   }
 
   return mQuotaFlusher.get();
@@ -319,8 +375,55 @@ void QuarkNamespaceGroup::startCacheRefreshListener()
 
   if (!mCacheRefreshListener) {
     mCacheRefreshListener.reset(new CacheRefreshListener(contactDetails,
-                                mFileService->getMetadataProvider()));
+                                mFileService->getMetadataProvider(),
+                                &mContainerService->getPathLookupCache()));
+  }
+}
+
+//------------------------------------------------------------------------------
+// Start warming up the metadata cache, then snapshot it periodically
+//------------------------------------------------------------------------------
+void QuarkNamespaceGroup::startCacheWarmer()
+{
+  std::lock_guard<std::recursive_mutex> lock(mMutex);
+
+  if (cacheSnapshotPath.empty()) {
+    return;
   }
+
+  if (!mCacheWarmer) {
+    mCacheWarmer.reset(new CacheWarmer(mFileService->getMetadataProvider(),
+                                       cacheSnapshotPath,
+                                       cacheSnapshotInterval));
+  }
+
+  mCacheWarmer->start();
+}
+
+//------------------------------------------------------------------------------
+// Stop the cache warmer, writing a last snapshot
+//------------------------------------------------------------------------------
+void QuarkNamespaceGroup::stopCacheWarmer()
+{
+  std::lock_guard<std::recursive_mutex> lock(mMutex);
+
+  if (mCacheWarmer) {
+    mCacheWarmer->stop();
+  }
+}
+
+//------------------------------------------------------------------------------
+// Get cache warm-up statistics
+//------------------------------------------------------------------------------
+CacheWarmUpStatistics QuarkNamespaceGroup::getCacheWarmUpStatistics()
+{
+  std::lock_guard<std::recursive_mutex> lock(mMutex);
+
+  if (mCacheWarmer) {
+    return mCacheWarmer->getStatistics();
+  }
+
+  return CacheWarmUpStatistics();
 }
 
 //------------------------------------------------------------------------------
@@ -26,6 +26,8 @@
 #include "namespace/interface/INamespaceGroup.hh"
 #include "namespace/ns_quarkdb/QdbContactDetails.hh"
 #include "namespace/ns_quarkdb/QClPerformance.hh"
+#include "namespace/utils/HierarchicalLockManager.hh"
+#include <chrono>
 #include <mutex>
 #include <memory>
 
@@ -50,6 +52,7 @@ class QuarkSyncTimeAccounting;
 class QuarkQuotaStats;
 class MetadataFlusher;
 class CacheRefreshListener;
+class CacheWarmer;
 
 //------------------------------------------------------------------------------
 //! Class to hold ownership of all QuarkDB-namespace objects.
@@ -112,6 +115,14 @@ public:
   //----------------------------------------------------------------------------
   virtual IQuotaStats* getQuotaStats() override final;
 
+  //----------------------------------------------------------------------------
+  //! Provide the per-container lock manager
+  //----------------------------------------------------------------------------
+  virtual HierarchicalLockManager* getContainerLockManager() override final
+  {
+    return &mContainerLocks;
+  }
+
   //----------------------------------------------------------------------------
   //! Is this in-memory namespace?
   //----------------------------------------------------------------------------
@@ -150,6 +161,22 @@ public:
   //----------------------------------------------------------------------------
   void startCacheRefreshListener() override final;
 
+  //----------------------------------------------------------------------------
+  //! Start warming up the metadata cache from the snapshot of its hot set,
+  //! then snapshot it periodically - no-op if no snapshot path is configured
+  //----------------------------------------------------------------------------
+  void startCacheWarmer() override final;
+
+  //----------------------------------------------------------------------------
+  //! Stop the cache warmer, writing a last snapshot
+  //----------------------------------------------------------------------------
+  void stopCacheWarmer() override final;
+
+  //----------------------------------------------------------------------------
+  //! Get cache warm-up statistics
+  //----------------------------------------------------------------------------
+  CacheWarmUpStatistics getCacheWarmUpStatistics() override final;
+
 private:
   //----------------------------------------------------------------------------
   // Configuration
@@ -158,6 +185,15 @@ private:
   std::string queuePath;            //< Namespace queue path
   std::string flusherMDTag;         //< Tag for MD flusher
   std::string flusherQuotaTag;      //< Tag for quota flusher
+  //! Time window for coalescing updates in the flushers, 0 disables it
+  std::chrono::milliseconds flusherCoalesceWindow {10};
+  //! Location of the cache hot set snapshot, empty disables the warm-up
+  std::string cacheSnapshotPath;
+  //! Time between two snapshots of the cache hot set
+  std::chrono::seconds cacheSnapshotInterval {300};
+  //! Min number of entries of a container in which names are looked up with
+  //! point queries instead of loading it, 0 disables it
+  uint64_t largeContainerThreshold {0};
 
   //----------------------------------------------------------------------------
   // Initialize file and container services
@@ -165,6 +201,7 @@ private:
   void initializeFileAndContainerServices();
 
   std::recursive_mutex mMutex;
+  HierarchicalLockManager mContainerLocks; ///< Per-container lock manager
 
   //----------------------------------------------------------------------------
   //! CAUTION: The folly Executor must outlive qclient! If a continuation is
@@ -190,6 +227,7 @@ private:
   std::unique_ptr<QuarkContainerAccounting> mContainerAccounting;
   std::unique_ptr<QuarkSyncTimeAccounting> mSyncAccounting;
   std::unique_ptr<CacheRefreshListener> mCacheRefreshListener;
+  std::unique_ptr<CacheWarmer> mCacheWarmer;
   std::shared_ptr<QClPerfMonitor> mPerfMonitor; ///< QCl performance monitor
 };
 
@@ -0,0 +1,395 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2021 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "namespace/ns_quarkdb/PathLookupCache.hh"
+#include <vector>
+
+EOSNSNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+PathLookupCache::PathLookupCache()
+{
+  for (size_t i = 0; i < kNumNameStripes; ++i) {
+    mNameGenerations[i].store(0);
+  }
+
+  mIndex[1].mPath = "/";
+}
+
+//------------------------------------------------------------------------------
+// Set the max number of entries
+//------------------------------------------------------------------------------
+void
+PathLookupCache::setMaxEntries(uint64_t max_entries)
+{
+  std::lock_guard<std::mutex> lock(mIndexMutex);
+  mMaxEntries.store(max_entries);
+
+  if ((max_entries == 0) || (mNumEntries.load() > max_entries)) {
+    clearLocked();
+  }
+}
+
+//------------------------------------------------------------------------------
+// Build the canonical path made of the given chunks
+//------------------------------------------------------------------------------
+bool
+PathLookupCache::buildPath(const std::deque<std::string>& chunks,
+                           std::string& path)
+{
+  path.clear();
+
+  for (const auto& chunk : chunks) {
+    if (chunk.empty() || (chunk == ".") || (chunk == "..")) {
+      return false;
+    }
+
+    path += '/';
+    path += chunk;
+  }
+
+  return !path.empty();
+}
+
+//------------------------------------------------------------------------------
+// Append a name to a canonical path
+//------------------------------------------------------------------------------
+std::string
+PathLookupCache::join(const std::string& path, const std::string& name)
+{
+  if (path == "/") {
+    return path + name;
+  }
+
+  return path + "/" + name;
+}
+
+//------------------------------------------------------------------------------
+// Find the longest cached prefix of a canonical path
+//------------------------------------------------------------------------------
+PathLookupCache::Result
+PathLookupCache::lookup(const std::string& path)
+{
+  Result result;
+
+  if (!isEnabled()) {
+    return result;
+  }
+
+  std::vector<size_t> ends;
+
+  for (size_t i = 1; i <= path.size(); ++i) {
+    if ((i == path.size()) || (path[i] == '/')) {
+      ends.push_back(i);
+    }
+  }
+
+  // Probe from the longest prefix, a stat of an entry in a cached directory
+  // takes two probes.
+  for (size_t depth = ends.size(); depth > 0; --depth) {
+    std::string prefix = path.substr(0, ends[depth - 1]);
+    Shard& shard = getShard(prefix);
+    std::lock_guard<std::mutex> lock(shard.mMutex);
+    auto it = shard.mEntries.find(prefix);
+
+    if (it != shard.mEntries.end()) {
+      result.negative = (it->second.id == 0);
+      result.id = it->second.id;
+      result.depth = depth;
+      result.length = prefix.size();
+      ++(result.negative ? mNegativeHits : mHits);
+      return result;
+    }
+  }
+
+  ++mMisses;
+  return result;
+}
+
+//------------------------------------------------------------------------------
+// Get the token to use for inserting the given name
+//------------------------------------------------------------------------------
+PathLookupCache::Token
+PathLookupCache::getToken(IContainerMD::id_t parent_id,
+                          const std::string& name) const
+{
+  Token token;
+  token.global = mGlobalGeneration.load();
+  token.name = mNameGenerations[getNameStripe(parent_id, name)].load();
+  return token;
+}
+
+//------------------------------------------------------------------------------
+// Insert the result of looking up a name in a cached container
+//------------------------------------------------------------------------------
+bool
+PathLookupCache::insert(const std::string& path, IContainerMD::id_t parent_id,
+                        IContainerMD::id_t id, const Token& token)
+{
+  if (!isEnabled()) {
+    return false;
+  }
+
+  size_t pos = path.rfind('/');
+
+  if ((pos == std::string::npos) || (pos + 1 == path.size())) {
+    return false;
+  }
+
+  std::string name = path.substr(pos + 1);
+  std::lock_guard<std::mutex> lock(mIndexMutex);
+
+  if ((token.global != mGlobalGeneration.load()) ||
+      (token.name != mNameGenerations[getNameStripe(parent_id, name)].load())) {
+    return false;
+  }
+
+  auto it_parent = mIndex.find(parent_id);
+
+  if ((it_parent == mIndex.end()) ||
+      (join(it_parent->second.mPath, name) != path)) {
+    return false;
+  }
+
+  if (id != 0) {
+    auto it_node = mIndex.find(id);
+
+    if (it_node != mIndex.end()) {
+      return (it_node->second.mPath == path);
+    }
+  }
+
+  if (mNumEntries.load() >= mMaxEntries.load()) {
+    clearLocked();
+    return false;
+  }
+
+  {
+    Shard& shard = getShard(path);
+    std::lock_guard<std::mutex> shard_lock(shard.mMutex);
+
+    if (!shard.mEntries.emplace(path, Entry{id, parent_id}).second) {
+      return true;
+    }
+  }
+
+  it_parent->second.mChildren.insert(name);
+  ++mNumEntries;
+
+  if (id == 0) {
+    ++mNumNegative;
+  } else {
+    mIndex[id].mPath = path;
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Invalidate a name added to or removed from a container
+//------------------------------------------------------------------------------
+void
+PathLookupCache::invalidateName(IContainerMD::id_t parent_id,
+                                const std::string& name)
+{
+  if (!isEnabled()) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(mIndexMutex);
+  ++mNameGenerations[getNameStripe(parent_id, name)];
+  auto it = mIndex.find(parent_id);
+
+  if ((it == mIndex.end()) || (it->second.mChildren.erase(name) == 0)) {
+    return;
+  }
+
+  ++mInvalidations;
+  IContainerMD::id_t id = eraseEntry(join(it->second.mPath, name));
+
+  if (id != 0) {
+    eraseSubtree(id);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Invalidate a container and everything cached below it
+//------------------------------------------------------------------------------
+void
+PathLookupCache::invalidateContainer(IContainerMD::id_t id)
+{
+  if (!isEnabled()) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(mIndexMutex);
+  // Lookups in progress below the container may have resolved paths which
+  // are not valid anymore
+  ++mGlobalGeneration;
+
+  if (id == 1) {
+    ++mInvalidations;
+    clearLocked();
+    return;
+  }
+
+  auto it = mIndex.find(id);
+
+  if (it == mIndex.end()) {
+    return;
+  }
+
+  ++mInvalidations;
+  const std::string& path = it->second.mPath;
+  std::string name = path.substr(path.rfind('/') + 1);
+  IContainerMD::id_t parent_id = 0;
+  {
+    Shard& shard = getShard(path);
+    std::lock_guard<std::mutex> shard_lock(shard.mMutex);
+    auto it_entry = shard.mEntries.find(path);
+
+    if (it_entry != shard.mEntries.end()) {
+      parent_id = it_entry->second.parent;
+      shard.mEntries.erase(it_entry);
+      --mNumEntries;
+    }
+  }
+  auto it_parent = mIndex.find(parent_id);
+
+  if (it_parent != mIndex.end()) {
+    it_parent->second.mChildren.erase(name);
+  }
+
+  eraseSubtree(id);
+}
+
+//------------------------------------------------------------------------------
+// Drop all the entries
+//------------------------------------------------------------------------------
+void
+PathLookupCache::clear()
+{
+  std::lock_guard<std::mutex> lock(mIndexMutex);
+  clearLocked();
+}
+
+//------------------------------------------------------------------------------
+// Get statistics
+//------------------------------------------------------------------------------
+PathCacheStatistics
+PathLookupCache::getStatistics() const
+{
+  PathCacheStatistics stats;
+  stats.enabled = isEnabled();
+  stats.maxNum = mMaxEntries.load();
+  stats.occupancy = mNumEntries.load();
+  stats.negative = mNumNegative.load();
+  stats.hits = mHits.load();
+  stats.negativeHits = mNegativeHits.load();
+  stats.misses = mMisses.load();
+  stats.invalidations = mInvalidations.load();
+  return stats;
+}
+
+//------------------------------------------------------------------------------
+// Get the stripe of the generation counter of a name
+//------------------------------------------------------------------------------
+size_t
+PathLookupCache::getNameStripe(IContainerMD::id_t parent_id,
+                               const std::string& name)
+{
+  return (std::hash<std::string>()(name) ^ (parent_id * 0x9e3779b97f4a7c15ull))
+         % kNumNameStripes;
+}
+
+//------------------------------------------------------------------------------
+// Erase an entry from its shard, return its container id
+//------------------------------------------------------------------------------
+IContainerMD::id_t
+PathLookupCache::eraseEntry(const std::string& path)
+{
+  Shard& shard = getShard(path);
+  std::lock_guard<std::mutex> lock(shard.mMutex);
+  auto it = shard.mEntries.find(path);
+
+  if (it == shard.mEntries.end()) {
+    return 0;
+  }
+
+  IContainerMD::id_t id = it->second.id;
+  shard.mEntries.erase(it);
+  --mNumEntries;
+
+  if (id == 0) {
+    --mNumNegative;
+  }
+
+  return id;
+}
+
+//------------------------------------------------------------------------------
+// Erase the entries below a container and the container from the index
+//------------------------------------------------------------------------------
+void
+PathLookupCache::eraseSubtree(IContainerMD::id_t id)
+{
+  std::vector<IContainerMD::id_t> pending {id};
+
+  while (!pending.empty()) {
+    IContainerMD::id_t current = pending.back();
+    pending.pop_back();
+    auto it = mIndex.find(current);
+
+    if (it == mIndex.end()) {
+      continue;
+    }
+
+    for (const auto& name : it->second.mChildren) {
+      IContainerMD::id_t child = eraseEntry(join(it->second.mPath, name));
+
+      if (child != 0) {
+        pending.push_back(child);
+      }
+    }
+
+    mIndex.erase(it);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Drop all the entries, the index mutex must be locked
+//------------------------------------------------------------------------------
+void
+PathLookupCache::clearLocked()
+{
+  ++mGlobalGeneration;
+
+  for (auto& shard : mShards) {
+    std::lock_guard<std::mutex> lock(shard.mMutex);
+    shard.mEntries.clear();
+  }
+
+  mIndex.clear();
+  mIndex[1].mPath = "/";
+  mNumEntries.store(0);
+  mNumNegative.store(0);
+}
+
+EOSNSNAMESPACE_END
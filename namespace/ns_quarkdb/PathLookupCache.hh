@@ -0,0 +1,226 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2021 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+//------------------------------------------------------------------------------
+//! @brief Cache of path to container id translations
+//------------------------------------------------------------------------------
+
+#pragma once
+#include "namespace/Namespace.hh"
+#include "namespace/interface/IContainerMD.hh"
+#include "namespace/interface/Misc.hh"
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+EOSNSNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Caches the container id of canonical paths i.e. paths without "." or ".."
+//! components and not traversing symlinks, together with negative entries
+//! for names which don't exist in a cached container. A negative entry
+//! makes the lookup of any path below it fail with ENOENT.
+//!
+//! Lookups only lock one of the shards holding the entries. Inserts and
+//! invalidations are serialized through an index of the cached containers,
+//! used to drop whole subtrees when a container is removed or renamed.
+//!
+//! The cache is kept consistent by the container objects, which invalidate
+//! the names they add or remove after updating their maps. A lookup takes a
+//! token before reading a container map and its result is only inserted if
+//! no overlapping invalidation happened in between.
+//------------------------------------------------------------------------------
+class PathLookupCache
+{
+public:
+  static constexpr uint64_t kDefaultMaxEntries = 1000000;
+
+  //----------------------------------------------------------------------------
+  //! Snapshot of the invalidations affecting an insert
+  //----------------------------------------------------------------------------
+  struct Token {
+    uint64_t global = 0;
+    uint64_t name = 0;
+  };
+
+  //----------------------------------------------------------------------------
+  //! Longest cached prefix of a path
+  //----------------------------------------------------------------------------
+  struct Result {
+    bool negative = false; ///< Path does not exist
+    IContainerMD::id_t id = 0; ///< Container id, 0 if nothing is cached
+    size_t depth = 0; ///< Number of components of the cached prefix
+    size_t length = 0; ///< Length of the cached prefix
+  };
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //----------------------------------------------------------------------------
+  PathLookupCache();
+
+  //----------------------------------------------------------------------------
+  //! Set the max number of entries, 0 disables the cache. Exceeding the
+  //! limit drops all the entries.
+  //----------------------------------------------------------------------------
+  void setMaxEntries(uint64_t max_entries);
+
+  //----------------------------------------------------------------------------
+  //! Check if the cache is enabled
+  //----------------------------------------------------------------------------
+  bool isEnabled() const
+  {
+    return (mMaxEntries.load() != 0);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Build the canonical path made of the given chunks
+  //!
+  //! @param chunks path components
+  //! @param path output path e.g. "/a/b"
+  //!
+  //! @return false if the path is empty or contains "." or ".." components
+  //----------------------------------------------------------------------------
+  static bool buildPath(const std::deque<std::string>& chunks,
+                        std::string& path);
+
+  //----------------------------------------------------------------------------
+  //! Append a name to a canonical path
+  //----------------------------------------------------------------------------
+  static std::string join(const std::string& path, const std::string& name);
+
+  //----------------------------------------------------------------------------
+  //! Find the longest cached prefix of a canonical path
+  //!
+  //! @param path canonical path, other than "/"
+  //!
+  //! @return result, with depth 0 if nothing is cached
+  //----------------------------------------------------------------------------
+  Result lookup(const std::string& path);
+
+  //----------------------------------------------------------------------------
+  //! Get the token to use for inserting the given name, must be called before
+  //! reading the container map
+  //----------------------------------------------------------------------------
+  Token getToken(IContainerMD::id_t parent_id, const std::string& name) const;
+
+  //----------------------------------------------------------------------------
+  //! Insert the result of looking up a name in a cached container
+  //!
+  //! @param path canonical path of the entry
+  //! @param parent_id id of the parent container
+  //! @param id id of the container at the given path, 0 if nothing exists
+  //!        there
+  //! @param token token taken before looking up the name
+  //!
+  //! @return true if inserted, false if the parent is not cached or an
+  //!         invalidation raced with the lookup
+  //----------------------------------------------------------------------------
+  bool insert(const std::string& path, IContainerMD::id_t parent_id,
+              IContainerMD::id_t id, const Token& token);
+
+  //----------------------------------------------------------------------------
+  //! Invalidate a name added to or removed from a container
+  //----------------------------------------------------------------------------
+  void invalidateName(IContainerMD::id_t parent_id, const std::string& name);
+
+  //----------------------------------------------------------------------------
+  //! Invalidate a container and everything cached below it
+  //----------------------------------------------------------------------------
+  void invalidateContainer(IContainerMD::id_t id);
+
+  //----------------------------------------------------------------------------
+  //! Drop all the entries
+  //----------------------------------------------------------------------------
+  void clear();
+
+  //----------------------------------------------------------------------------
+  //! Get statistics
+  //----------------------------------------------------------------------------
+  PathCacheStatistics getStatistics() const;
+
+private:
+  static constexpr size_t kNumShards = 64;
+  static constexpr size_t kNumNameStripes = 1024;
+
+  //----------------------------------------------------------------------------
+  //! Cached path
+  //----------------------------------------------------------------------------
+  struct Entry {
+    IContainerMD::id_t id; ///< 0 for a negative entry
+    IContainerMD::id_t parent;
+  };
+
+  struct Shard {
+    std::mutex mMutex;
+    std::unordered_map<std::string, Entry> mEntries;
+  };
+
+  //----------------------------------------------------------------------------
+  //! Cached container
+  //----------------------------------------------------------------------------
+  struct Node {
+    std::string mPath;
+    std::unordered_set<std::string> mChildren; ///< Cached names below it
+  };
+
+  Shard& getShard(const std::string& path)
+  {
+    return mShards[std::hash<std::string>()(path) % kNumShards];
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get the stripe of the generation counter of a name
+  //----------------------------------------------------------------------------
+  static size_t getNameStripe(IContainerMD::id_t parent_id,
+                              const std::string& name);
+
+  //----------------------------------------------------------------------------
+  //! Erase an entry from its shard, return its container id
+  //----------------------------------------------------------------------------
+  IContainerMD::id_t eraseEntry(const std::string& path);
+
+  //----------------------------------------------------------------------------
+  //! Erase the entries below a container and the container from the index
+  //----------------------------------------------------------------------------
+  void eraseSubtree(IContainerMD::id_t id);
+
+  //----------------------------------------------------------------------------
+  //! Drop all the entries, the index mutex must be locked
+  //----------------------------------------------------------------------------
+  void clearLocked();
+
+  Shard mShards[kNumShards];
+  std::mutex mIndexMutex; ///< Serializes inserts and invalidations
+  std::unordered_map<IContainerMD::id_t, Node> mIndex;
+  //! Bumped when containers are invalidated
+  std::atomic<uint64_t> mGlobalGeneration {0};
+  //! Bumped when names hashing to the stripe are invalidated
+  std::atomic<uint64_t> mNameGenerations[kNumNameStripes];
+  std::atomic<uint64_t> mMaxEntries {kDefaultMaxEntries};
+  std::atomic<uint64_t> mNumEntries {0};
+  std::atomic<uint64_t> mNumNegative {0};
+  std::atomic<uint64_t> mHits {0};
+  std::atomic<uint64_t> mNegativeHits {0};
+  std::atomic<uint64_t> mMisses {0};
+  std::atomic<uint64_t> mInvalidations {0};
+};
+
+EOSNSNAMESPACE_END
@@ -17,7 +17,9 @@
  ************************************************************************/
 
 #include "namespace/ns_quarkdb/accounting/ContainerAccounting.hh"
-#include <iostream>
+#include "namespace/utils/HierarchicalLockManager.hh"
+#include <folly/futures/Future.h>
+#include <algorithm>
 #include <chrono>
 
 EOSNSNAMESPACE_BEGIN
@@ -26,13 +28,11 @@ EOSNSNAMESPACE_BEGIN
 // Constructor
 //----------------------------------------------------------------------------
 QuarkContainerAccounting::QuarkContainerAccounting(IContainerMDSvc* svc,
-    eos::common::RWMutex* ns_mutex, int32_t update_interval)
-  : mAccumulateIndx(0), mCommitIndx(1), mShutdown(false),
-    mUpdateIntervalSec(update_interval), mContainerMDSvc(svc),
-    gNsRwMutex(ns_mutex)
+    eos::common::RWMutex* ns_mutex, int32_t update_interval,
+    HierarchicalLockManager* cont_locks)
+  : mShutdown(false), mUpdateIntervalSec(update_interval),
+    mContainerMDSvc(svc), mNsRwMutex(ns_mutex), mContainerLocks(cont_locks)
 {
-  mBatch.resize(2);
-
   // If update interval is 0 then we disable async updates
   if (mUpdateIntervalSec) {
     mThread.reset(&QuarkContainerAccounting::AssistedPropagateUpdates, this);
@@ -100,30 +100,69 @@ QuarkContainerAccounting::RemoveTree(IContainerMD* obj, int64_t dsize)
 void
 QuarkContainerAccounting::QueueForUpdate(IContainerMD::id_t id, int64_t dsize)
 {
-  uint16_t deepness = 0;
-  std::shared_ptr<IContainerMD> cont;
-  std::lock_guard<std::mutex> scope_lock(mMutexBatch);
-  auto& batch = mBatch[mAccumulateIndx];
+  // The root container is never updated
+  if ((id <= 1) || (dsize == 0)) {
+    return;
+  }
 
-  while ((id > 1) && (deepness < 255)) {
-    try {
-      cont = mContainerMDSvc->getContainerMD(id);
-    } catch (const MDException& e) {
-      // TODO (esindril): error message using default logging
-      break;
-    }
+  Buffer& buffer = GetBuffer();
+  std::lock_guard<std::mutex> scope_lock(buffer.mMutex);
 
-    auto it_map = batch.mMap.find(id);
+  if (buffer.mDeltas.empty()) {
+    buffer.mOldest = std::chrono::steady_clock::now();
+  }
 
-    if (it_map != batch.mMap.end()) {
-      it_map->second += dsize;
-    } else {
-      batch.mMap.emplace(id, dsize);
-    }
+  auto res = buffer.mDeltas.emplace(id, dsize);
+
+  if (res.second) {
+    ++mQueueDepth;
+  } else {
+    res.first->second += dsize;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Record the removal of a container
+//------------------------------------------------------------------------------
+void
+QuarkContainerAccounting::ContainerRemoved(IContainerMD::id_t id,
+    IContainerMD::id_t parent_id)
+{
+  RemovedShard& shard = GetRemovedShard(id);
+  std::lock_guard<std::mutex> scope_lock(shard.mMutex);
+  Removed& removed = shard.mRemoved[id];
+  removed.mParent = parent_id;
+  removed.mRound = mRound;
+}
+
+//------------------------------------------------------------------------------
+// Get the parent a container was removed from
+//------------------------------------------------------------------------------
+IContainerMD::id_t
+QuarkContainerAccounting::GetRemovedParent(IContainerMD::id_t id)
+{
+  RemovedShard& shard = GetRemovedShard(id);
+  std::lock_guard<std::mutex> scope_lock(shard.mMutex);
+  auto it = shard.mRemoved.find(id);
+  return ((it == shard.mRemoved.end()) ? 0 : it->second.mParent);
+}
 
-    id = cont->getParentId();
-    ++deepness;
+//------------------------------------------------------------------------------
+// Start a new propagation round
+//------------------------------------------------------------------------------
+uint64_t
+QuarkContainerAccounting::NextRound()
+{
+  // A removal is recorded either before the round changes, and then its
+  // queued changes are drained in the new round, or with the new round
+  std::vector<std::unique_lock<std::mutex>> locks;
+  locks.reserve(kNumRemovedShards);
+
+  for (auto& shard : mRemovedShards) {
+    locks.emplace_back(shard.mMutex);
   }
+
+  return ++mRound;
 }
 
 //------------------------------------------------------------------------------
@@ -148,31 +187,38 @@ QuarkContainerAccounting::PropagateUpdates(ThreadAssistant* assistant)
       break;
     }
 
-    {
-      // Update the indexes to have the async thread working on the batch to
-      // commit and the incoming updates to go to the batch to update
-      std::lock_guard<std::mutex> scope_lock(mMutexBatch);
-      std::swap(mAccumulateIndx, mCommitIndx);
+    uint64_t round = NextRound();
+    std::unordered_map<IContainerMD::id_t, int64_t> deltas;
+    auto oldest = DrainBuffers(deltas);
+
+    if (!deltas.empty()) {
+      std::unordered_map<IContainerMD::id_t, Update> updates;
+      Aggregate(std::move(deltas), updates);
+      Apply(updates);
+      uint64_t lag_ms = std::chrono::duration_cast<std::chrono::milliseconds>
+                        (std::chrono::steady_clock::now() - oldest).count();
+      mLastLagMs = lag_ms;
+
+      if (lag_ms > mMaxLagMs) {
+        mMaxLagMs = lag_ms;
+      }
     }
 
-    auto& batch = mBatch[mCommitIndx];
     {
-      // Need to lock the namespace
-      eos::common::RWMutexWriteLock wr_lock(*gNsRwMutex);
-      std::shared_ptr<IContainerMD> cont;
+      // Changes queued before a removal are drained at the latest in the
+      // round following the one during which the removal was recorded
+      for (auto& shard : mRemovedShards) {
+        std::lock_guard<std::mutex> scope_lock(shard.mMutex);
 
-      for (auto const& elem : batch.mMap) {
-        try {
-          cont = mContainerMDSvc->getContainerMD(elem.first);
-          cont->updateTreeSize(elem.second);
-          mContainerMDSvc->updateStore(cont.get());
-        } catch (const MDException& e) {
-          // TODO: (esindril) error message using default logging
-          continue;
+        for (auto it = shard.mRemoved.begin(); it != shard.mRemoved.end();) {
+          if (it->second.mRound < round) {
+            it = shard.mRemoved.erase(it);
+          } else {
+            ++it;
+          }
         }
       }
     }
-    batch.mMap.clear();
 
     if (mUpdateIntervalSec) {
       if (assistant) {
@@ -186,4 +232,190 @@ QuarkContainerAccounting::PropagateUpdates(ThreadAssistant* assistant)
   }
 }
 
+//------------------------------------------------------------------------------
+// Get propagation statistics
+//------------------------------------------------------------------------------
+QuarkContainerAccounting::Stats
+QuarkContainerAccounting::GetStats() const
+{
+  Stats stats;
+  stats.queueDepth = mQueueDepth;
+  stats.pending = mPending;
+  stats.lastLagMs = mLastLagMs;
+  stats.maxLagMs = mMaxLagMs;
+  stats.applied = mApplied;
+  return stats;
+}
+
+//------------------------------------------------------------------------------
+// Get the buffer used by the calling thread
+//------------------------------------------------------------------------------
+QuarkContainerAccounting::Buffer&
+QuarkContainerAccounting::GetBuffer()
+{
+  static std::atomic<size_t> sNextThread {0};
+  static thread_local size_t sThreadIndex = sNextThread++;
+  return mBuffers[sThreadIndex % kNumBuffers];
+}
+
+//------------------------------------------------------------------------------
+// Move the queued size changes out of the buffers
+//------------------------------------------------------------------------------
+std::chrono::steady_clock::time_point
+QuarkContainerAccounting::DrainBuffers(
+  std::unordered_map<IContainerMD::id_t, int64_t>& deltas)
+{
+  auto oldest = std::chrono::steady_clock::now();
+
+  for (auto& buffer : mBuffers) {
+    std::unordered_map<IContainerMD::id_t, int64_t> drained;
+    {
+      std::lock_guard<std::mutex> scope_lock(buffer.mMutex);
+
+      if (buffer.mDeltas.empty()) {
+        continue;
+      }
+
+      drained.swap(buffer.mDeltas);
+      oldest = std::min(oldest, buffer.mOldest);
+    }
+    mQueueDepth -= drained.size();
+
+    for (const auto& elem : drained) {
+      deltas[elem.first] += elem.second;
+    }
+  }
+
+  return oldest;
+}
+
+//------------------------------------------------------------------------------
+// Resolve the parents of the containers and add up the size changes of every
+// container on the way to the root
+//------------------------------------------------------------------------------
+void
+QuarkContainerAccounting::Aggregate(
+  std::unordered_map<IContainerMD::id_t, int64_t>&& deltas,
+  std::unordered_map<IContainerMD::id_t, Update>& updates)
+{
+  std::unordered_map<IContainerMD::id_t, int64_t> level = std::move(deltas);
+
+  // Every round moves the deltas one level up. A container reached from
+  // several children gets the sum of their deltas, possibly over several
+  // rounds if they are at different depths.
+  for (size_t depth = 0; !level.empty() && (depth < kMaxDepth); ++depth) {
+    std::vector<std::pair<IContainerMD::id_t, int64_t>> items;
+    std::vector<folly::Future<IContainerMDPtr>> futs;
+    items.reserve(level.size());
+    futs.reserve(level.size());
+
+    for (const auto& elem : level) {
+      if (elem.second == 0) {
+        continue;
+      }
+
+      items.push_back(elem);
+      futs.push_back(mContainerMDSvc->getContainerMDFut(elem.first));
+    }
+
+    std::unordered_map<IContainerMD::id_t, int64_t> next;
+
+    for (size_t i = 0; i < futs.size(); ++i) {
+      IContainerMDPtr cont;
+
+      try {
+        cont = std::move(futs[i]).get();
+      } catch (const MDException& e) {
+        cont.reset();
+      }
+
+      // Container removed in the meantime, the change still applies to the
+      // parent it was removed from. The removal might not be flushed to the
+      // backend yet, so the lookup alone can not tell.
+      IContainerMD::id_t parent_id = GetRemovedParent(items[i].first);
+
+      if (parent_id || !cont || cont->isDeleted()) {
+        if ((parent_id == 0) && cont) {
+          parent_id = cont->getParentId();
+        }
+
+        if ((parent_id > 1) && (parent_id != items[i].first)) {
+          next[parent_id] += items[i].second;
+        }
+
+        continue;
+      }
+
+      Update& update = updates[items[i].first];
+
+      if (!update.mCont) {
+        update.mCont = cont;
+      }
+
+      update.mDelta += items[i].second;
+      IContainerMD::id_t parent_id = cont->getParentId();
+
+      if ((parent_id > 1) && (parent_id != items[i].first)) {
+        next[parent_id] += items[i].second;
+      }
+    }
+
+    level.swap(next);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Apply the aggregated size changes
+//------------------------------------------------------------------------------
+void
+QuarkContainerAccounting::Apply(
+  std::unordered_map<IContainerMD::id_t, Update>& updates)
+{
+  mPending = updates.size();
+  auto it = updates.begin();
+
+  while (it != updates.end()) {
+    // The store updates have to be ordered with the ones of the other
+    // writers. These hold either the namespace write lock or the namespace
+    // read lock together with the lock of the container they modify, the
+    // same is done here. Without per-container locks the namespace write
+    // lock is taken. Writers get through in between the slices.
+    eos::common::RWMutexWriteLock ns_wr_lock;
+    eos::common::RWMutexReadLock ns_rd_lock;
+
+    if (mNsRwMutex) {
+      if (mContainerLocks) {
+        ns_rd_lock.Grab(*mNsRwMutex, __FUNCTION__, __LINE__, __FILE__);
+      } else {
+        ns_wr_lock.Grab(*mNsRwMutex, __FUNCTION__, __LINE__, __FILE__);
+      }
+    }
+
+    for (size_t in_slice = 0; (it != updates.end()) && (in_slice < kSliceSize);
+         ++it, ++in_slice) {
+      Update& update = it->second;
+      HierarchicalLockManager::PathLock cont_lock;
+
+      if (mContainerLocks) {
+        cont_lock = mContainerLocks->writeLock(it->first);
+      }
+
+      if ((update.mDelta != 0) && !update.mCont->isDeleted()) {
+        try {
+          update.mCont->updateTreeSize(update.mDelta);
+          mContainerMDSvc->updateStore(update.mCont.get());
+        } catch (const MDException& e) {
+          // Container removed in the meantime
+        }
+
+        ++mApplied;
+      }
+
+      --mPending;
+    }
+  }
+
+  updates.clear();
+}
+
 EOSNSNAMESPACE_END
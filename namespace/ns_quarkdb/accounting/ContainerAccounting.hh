@@ -25,8 +25,9 @@
 #include "namespace/Namespace.hh"
 #include "namespace/interface/IContainerMDSvc.hh"
 #include "namespace/interface/IFileMDSvc.hh"
-#include "common/RWMutex.hh"
 #include "common/AssistedThread.hh"
+#include "common/RWMutex.hh"
+#include <chrono>
 #include <mutex>
 #include <thread>
 #include <vector>
@@ -36,21 +37,47 @@
 
 EOSNSNAMESPACE_BEGIN
 
+class HierarchicalLockManager;
+
 //------------------------------------------------------------------------------
 //! Container subtree accounting listener
+//!
+//! Size changes are queued per container in buffers picked by the calling
+//! thread, without any metadata lookups. The propagation stage drains the
+//! buffers, resolves the parents of the queued containers level by level
+//! with asynchronous fetches, merging the deltas on the way up, and then
+//! applies the aggregated deltas in bounded slices. Every container is
+//! updated under its own lock, the namespace lock is only held for reading
+//! once per slice. The deltas of containers removed before they got
+//! propagated are handed over to the parent recorded at removal time.
 //------------------------------------------------------------------------------
 class QuarkContainerAccounting : public IFileMDChangeListener
 {
 public:
+  //----------------------------------------------------------------------------
+  //! Propagation statistics
+  //----------------------------------------------------------------------------
+  struct Stats {
+    uint64_t queueDepth = 0; ///< Containers with queued size changes
+    uint64_t pending = 0; ///< Aggregated updates not applied yet
+    uint64_t lastLagMs = 0; ///< Queueing to apply delay of the last batch
+    uint64_t maxLagMs = 0; ///< Max delay over all batches
+    uint64_t applied = 0; ///< Total number of container updates
+  };
+
   //----------------------------------------------------------------------------
   //! Constructor
   //!
   //! @param svc container metadata service
-  //! @param ns_mutex global (MGM) namespace mutex
+  //! @param ns_mutex global namespace view mutex, can be null
   //! @param update_interval interval in seconds when updates are propagated
+  //! @param cont_locks per-container locks, can be null in which case the
+  //!        namespace mutex is taken for writing
   //----------------------------------------------------------------------------
-  QuarkContainerAccounting(IContainerMDSvc* svc, eos::common::RWMutex* ns_mutex,
-                           int32_t update_interval = 5);
+  QuarkContainerAccounting(IContainerMDSvc* svc,
+                           eos::common::RWMutex* ns_mutex,
+                           int32_t update_interval = 5,
+                           HierarchicalLockManager* cont_locks = nullptr);
 
   //----------------------------------------------------------------------------
   //! Destructor
@@ -108,13 +135,22 @@ public:
   void RemoveTree(IContainerMD* obj, int64_t dsize);
 
   //----------------------------------------------------------------------------
-  //! Queue info for update
+  //! Queue info for update, the change is propagated to all the parents
   //!
   //! @param pid container id
   //! @param dsize size change
   //----------------------------------------------------------------------------
   void QueueForUpdate(IContainerMD::id_t pid, int64_t dsize);
 
+  //----------------------------------------------------------------------------
+  //! Record the removal of a container so that its size changes which are
+  //! not propagated yet still reach its parent
+  //!
+  //! @param id removed container id
+  //! @param parent_id id of the parent it was removed from
+  //----------------------------------------------------------------------------
+  void ContainerRemoved(IContainerMD::id_t id, IContainerMD::id_t parent_id);
+
   //----------------------------------------------------------------------------
   //! Propagate updates in the hierarchical structure
   //!
@@ -123,7 +159,108 @@ public:
   //----------------------------------------------------------------------------
   void PropagateUpdates(ThreadAssistant* assistant = nullptr);
 
+  //----------------------------------------------------------------------------
+  //! Get propagation statistics
+  //----------------------------------------------------------------------------
+  Stats GetStats() const;
+
 private:
+  //! Number of buffers collecting the size changes
+  static constexpr size_t kNumBuffers = 32;
+  //! Max number of containers updated in one slice
+  static constexpr size_t kSliceSize = 256;
+  //! Max depth of the propagation
+  static constexpr size_t kMaxDepth = 255;
+  //! Number of shards of the removed containers map
+  static constexpr size_t kNumRemovedShards = 16;
+
+  //----------------------------------------------------------------------------
+  //! Size changes queued by a subset of the threads
+  //----------------------------------------------------------------------------
+  struct Buffer {
+    std::mutex mMutex;
+    std::unordered_map<IContainerMD::id_t, int64_t> mDeltas;
+    //! Time when the oldest queued change was added
+    std::chrono::steady_clock::time_point mOldest;
+  };
+
+  //----------------------------------------------------------------------------
+  //! Aggregated size change of a container
+  //----------------------------------------------------------------------------
+  struct Update {
+    IContainerMDPtr mCont;
+    int64_t mDelta = 0;
+  };
+
+  //----------------------------------------------------------------------------
+  //! Container removed while it might still have queued size changes
+  //----------------------------------------------------------------------------
+  struct Removed {
+    IContainerMD::id_t mParent = 0;
+    uint64_t mRound = 0; ///< Propagation round during which it was removed
+  };
+
+  //----------------------------------------------------------------------------
+  //! Subset of the recently removed containers
+  //----------------------------------------------------------------------------
+  struct RemovedShard {
+    std::mutex mMutex;
+    std::unordered_map<IContainerMD::id_t, Removed> mRemoved;
+  };
+
+  //----------------------------------------------------------------------------
+  //! Get the shard of the removed containers map holding the given id
+  //----------------------------------------------------------------------------
+  RemovedShard& GetRemovedShard(IContainerMD::id_t id)
+  {
+    return mRemovedShards[id % kNumRemovedShards];
+  }
+
+  //----------------------------------------------------------------------------
+  //! Start a new propagation round
+  //!
+  //! @return new round number
+  //----------------------------------------------------------------------------
+  uint64_t NextRound();
+
+  //----------------------------------------------------------------------------
+  //! Get the buffer used by the calling thread
+  //----------------------------------------------------------------------------
+  Buffer& GetBuffer();
+
+  //----------------------------------------------------------------------------
+  //! Move the queued size changes out of the buffers
+  //!
+  //! @param deltas map collecting the size changes
+  //!
+  //! @return time when the oldest drained change was queued
+  //----------------------------------------------------------------------------
+  std::chrono::steady_clock::time_point
+  DrainBuffers(std::unordered_map<IContainerMD::id_t, int64_t>& deltas);
+
+  //----------------------------------------------------------------------------
+  //! Resolve the parents of the containers and add up the size changes of
+  //! every container on the way to the root
+  //!
+  //! @param deltas size changes of the containers
+  //! @param updates aggregated change of each container, root excluded
+  //----------------------------------------------------------------------------
+  void Aggregate(std::unordered_map<IContainerMD::id_t, int64_t>&& deltas,
+                 std::unordered_map<IContainerMD::id_t, Update>& updates);
+
+  //----------------------------------------------------------------------------
+  //! Get the parent a container was removed from
+  //!
+  //! @param id container id
+  //!
+  //! @return parent id or 0 if the container was not removed recently
+  //----------------------------------------------------------------------------
+  IContainerMD::id_t GetRemovedParent(IContainerMD::id_t id);
+
+  //----------------------------------------------------------------------------
+  //! Apply the aggregated size changes
+  //----------------------------------------------------------------------------
+  void Apply(std::unordered_map<IContainerMD::id_t, Update>& updates);
 
   //----------------------------------------------------------------------------
   //! Propagate updates in the hierarchical structure. Method ran by the
@@ -133,25 +270,22 @@ private:
   //----------------------------------------------------------------------------
   void AssistedPropagateUpdates(ThreadAssistant& assistant) noexcept;
 
-  //! Update structure containing the nodes that need an update. We try to
-  //! optimise the number of updates to the backend by computing the final
-  //! size deltas from a number of individual updates.
-  struct UpdateT {
-    std::unordered_map<IContainerMD::id_t, int64_t> mMap; ///< Map updates
-  };
-
-  //! Vector of two elements containing the batch which is currently being
-  //! accumulated and the batch which is being committed to the namespace by
-  //! the asynchronous thread
-  std::vector<UpdateT> mBatch;
-  std::mutex mMutexBatch; ///< Mutex protecting access to the updates batch
-  uint8_t mAccumulateIndx; ///< Index of the batch accumulating updates
-  uint8_t mCommitIndx; ///< Index o the batch committing updates
+  Buffer mBuffers[kNumBuffers];
   AssistedThread mThread; ///< Thread updating the namespace
   std::atomic<bool> mShutdown; ///< Flag to shutdown the async thread
   uint32_t mUpdateIntervalSec; ///< Interval in seconds when updates are pushed
   IContainerMDSvc* mContainerMDSvc; ///< container MD service
-  eos::common::RWMutex* gNsRwMutex; ///< Global (MGM) name RW mutex
+  eos::common::RWMutex* mNsRwMutex; ///< Global namespace mutex
+  HierarchicalLockManager* mContainerLocks; ///< Per-container locks
+  //! Recently removed containers, kept for one more round than their deltas
+  RemovedShard mRemovedShards[kNumRemovedShards];
+  //! Current propagation round, changed with all the removed shards locked
+  uint64_t mRound = 0;
+  std::atomic<uint64_t> mQueueDepth {0};
+  std::atomic<uint64_t> mPending {0};
+  std::atomic<uint64_t> mLastLagMs {0};
+  std::atomic<uint64_t> mMaxLagMs {0};
+  std::atomic<uint64_t> mApplied {0};
 };
 
 EOSNSNAMESPACE_END
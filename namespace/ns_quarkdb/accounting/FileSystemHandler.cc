@@ -39,9 +39,6 @@ FileSystemHandler::FileSystemHandler(IFileMD::location_t loc,
   } else {
     target = Target::kRegular;
   }
-
-  mContents.set_deleted_key(0);
-  mContents.set_empty_key(0xffffffffffffffffll);
 }
 
 //------------------------------------------------------------------------------
@@ -54,8 +51,6 @@ FileSystemHandler::FileSystemHandler(folly::Executor* executor,
   : location(0), pExecutor(executor), pQcl(qcl), pFlusher(flusher)
 {
   target = Target::kNoReplicaList;
-  mContents.set_deleted_key(0);
-  mContents.set_empty_key(0xffffffffffffffffll);
 }
 
 //------------------------------------------------------------------------------
@@ -111,9 +106,7 @@ std::string FileSystemHandler::getRedisKey() const
 FileSystemHandler* FileSystemHandler::triggerCacheLoad()
 {
   pFlusher->synchronize();
-  IFsView::FileList temporaryContents;
-  temporaryContents.set_deleted_key(0);
-  temporaryContents.set_empty_key(0xffffffffffffffffll);
+  FileIdSet temporaryContents;
 
   for (auto it = getStreamingFileList(); it->valid(); it->next()) {
     temporaryContents.insert(it->getElement());
@@ -127,7 +120,7 @@ FileSystemHandler* FileSystemHandler::triggerCacheLoad()
   mChangeList.apply(mContents);
   mChangeList.clear();
   mCacheStatus = CacheStatus::kLoaded;
-  mContents.resize(0);
+  mContents.shrink();
   return this;
 }
 
@@ -173,7 +166,6 @@ void FileSystemHandler::erase(FileIdentifier identifier)
     eos_assert(mCacheStatus == CacheStatus::kLoaded);
     // Write directly into mContents
     mContents.erase(identifier.getUnderlyingUInt64());
-    mContents.resize(0);
   }
 
   lock.unlock();
@@ -219,7 +211,6 @@ void FileSystemHandler::nuke()
 {
   std::unique_lock<std::shared_timed_mutex> lock(mMutex);
   mContents.clear();
-  mContents.resize(0);
   pFlusher->del(getRedisKey());
 }
 
@@ -240,7 +231,7 @@ bool FileSystemHandler::hasFileId(IFileMD::id_t file)
 {
   ensureContentsLoaded();
   std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-  return mContents.find(file) != mContents.end();
+  return mContents.contains(file);
 }
 
 EOSNSNAMESPACE_END
@@ -28,6 +28,7 @@
 #include "namespace/interface/IFsView.hh"
 #include "namespace/interface/IFileMD.hh"
 #include "namespace/ns_quarkdb/accounting/SetChangeList.hh"
+#include "namespace/utils/FileIdSet.hh"
 #include "qclient/structures/QSet.hh"
 #include <folly/futures/FutureSplitter.h>
 #include <folly/executors/Async.h>
@@ -44,8 +45,8 @@ class MetadataFlusher;
 struct IsNoReplicaListTag {};
 
 //------------------------------------------------------------------------------
-//! Iterator to go through the contents of a FileSystemHandler. Keeps
-//! the corresponding list read-locked during its lifetime.
+//! Iterator to go through the contents of a FileSystemHandler in ascending
+//! id order. Keeps the corresponding list read-locked during its lifetime.
 //------------------------------------------------------------------------------
 class FileListIterator : public ICollectionIterator<IFileMD::id_t>
 {
@@ -54,7 +55,7 @@ public:
   //----------------------------------------------------------------------------
   //! Constructor.
   //----------------------------------------------------------------------------
-  FileListIterator(const IFsView::FileList& fileList,
+  FileListIterator(const FileIdSet& fileList,
                    std::shared_timed_mutex& mtx)
     : pFileList(fileList), mLock(mtx)
   {
@@ -91,9 +92,9 @@ public:
   }
 
 private:
-  const IFsView::FileList& pFileList;
+  const FileIdSet& pFileList;
   std::shared_lock<std::shared_timed_mutex> mLock;
-  IFsView::FileList::const_iterator mIterator;
+  FileIdSet::const_iterator mIterator;
 };
 
 //------------------------------------------------------------------------------
@@ -210,8 +211,9 @@ public:
   std::string getRedisKey() const;
 
   //----------------------------------------------------------------------------
-  //! Return iterator for this file system. Note that the iterator keeps
-  //! this filesystem read-locked during its entire lifetime.
+  //! Return iterator for this file system, going through the ids in ascending
+  //! order. Note that the iterator keeps this filesystem read-locked during
+  //! its entire lifetime.
   //----------------------------------------------------------------------------
   std::shared_ptr<ICollectionIterator<IFileMD::id_t>>
       getFileList();
@@ -271,8 +273,7 @@ private:
   qclient::QClient* pQcl;                   ///< QClient object
   MetadataFlusher *pFlusher;                ///< Metadata flusher object
   std::shared_timed_mutex mMutex;           ///< Object mutex
-  IFsView::FileList
-  mContents;              ///< Actual contents. May be incomplete if mCacheStatus != kLoaded.
+  FileIdSet mContents;                      ///< Actual contents. May be incomplete if mCacheStatus != kLoaded.
   SetChangeList<IFileMD::id_t>
   mChangeList; ///< ChangeList for what happens when cache loading is in progress.
 
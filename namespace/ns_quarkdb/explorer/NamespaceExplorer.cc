@@ -17,6 +17,7 @@
  ************************************************************************/
 
 #include "namespace/ns_quarkdb/explorer/NamespaceExplorer.hh"
+#include "namespace/ns_quarkdb/explorer/ParallelExplorer.hh"
 #include "namespace/utils/PathProcessor.hh"
 #include "namespace/ns_quarkdb/persistency/MetadataFetcher.hh"
 #include "namespace/utils/Attributes.hh"
@@ -206,7 +207,8 @@ NamespaceExplorer::NamespaceExplorer(const std::string& pth,
                                      const ExplorationOptions& opts,
                                      qclient::QClient& qclient,
                                      folly::Executor* exec)
-  : path(pth), options(opts), qcl(qclient), executor(exec)
+  : path(pth), options(opts), qcl(qclient), executor(exec),
+    startTime(std::chrono::steady_clock::now())
 {
   if (options.populateLinkedAttributes && !opts.view) {
     throw_mdexception(EINVAL,
@@ -221,8 +223,7 @@ NamespaceExplorer::NamespaceExplorer(const std::string& pth,
 
   if (pathParts.empty()) {
     // We're running a search on the root node, expand.
-    dfsPath.emplace_back(new SearchNode(*this, ContainerIdentifier(1),
-                                        ContainerIdentifier(1), nullptr, executor, opts.ignoreFiles));
+    startSearch(ContainerIdentifier(1), ContainerIdentifier(1), "");
   }
 
   // TODO: This for loop looks like a useful primitive for MetadataFetcher,
@@ -268,13 +269,40 @@ NamespaceExplorer::NamespaceExplorer(const std::string& pth,
         staticPath.emplace_back(MetadataFetcher::getContainerFromId(qcl, nextId).get());
       } else {
         // Final node, expand
-        dfsPath.emplace_back(new SearchNode(*this, parentID, nextId, nullptr, executor,
-                                            opts.ignoreFiles));
+        startSearch(parentID, nextId, pathParts[i]);
       }
     }
   }
 }
 
+//------------------------------------------------------------------------------
+// Destructor
+//------------------------------------------------------------------------------
+NamespaceExplorer::~NamespaceExplorer() = default;
+
+//------------------------------------------------------------------------------
+// Start the exploration of the subtree below the given container
+//------------------------------------------------------------------------------
+void NamespaceExplorer::startSearch(ContainerIdentifier expectedParent,
+                                    ContainerIdentifier id,
+                                    const std::string& name)
+{
+  if (options.numWorkers == 0) {
+    dfsPath.emplace_back(new SearchNode(*this, expectedParent, id, nullptr,
+                                        executor, options.ignoreFiles));
+    return;
+  }
+
+  std::string rootPath = buildStaticPath();
+
+  if (!name.empty()) {
+    rootPath += name + "/";
+  }
+
+  parallelSearch.reset(new ParallelExplorer(*this, expectedParent, id,
+                       rootPath));
+}
+
 //------------------------------------------------------------------------------
 // Build static path
 //------------------------------------------------------------------------------
@@ -360,6 +388,7 @@ void NamespaceExplorer::handleLinkedAttrs(NamespaceItem& result)
   //----------------------------------------------------------------------------
   // Cached entry exists?
   //----------------------------------------------------------------------------
+  std::unique_lock<std::mutex> lock(cachedAttrsMutex);
   auto cached = cachedAttrs.find(link->second);
 
   if (cached != cachedAttrs.end()) {
@@ -370,6 +399,8 @@ void NamespaceExplorer::handleLinkedAttrs(NamespaceItem& result)
     return;
   }
 
+  lock.unlock();
+
   //----------------------------------------------------------------------------
   // Cache miss
   //----------------------------------------------------------------------------
@@ -387,7 +418,9 @@ void NamespaceExplorer::handleLinkedAttrs(NamespaceItem& result)
     // toStoreIntoCache remains empty
   }
 
+  lock.lock();
   cachedAttrs[link->second] = toStoreIntoCache;
+  lock.unlock();
   populateLinkedAttributes(toStoreIntoCache, result.attrs, options.prefixLinks);
 }
 
@@ -406,9 +439,14 @@ bool NamespaceExplorer::fetch(NamespaceItem& item)
     item.isFile = true;
     item.fileMd = lastChunk;
     searchOnFileEnded = true;
+    numFiles++;
     return true;
   }
 
+  if (parallelSearch) {
+    return parallelSearch->fetch(item);
+  }
+
   while (!dfsPath.empty()) {
     dfsPath.back()->handleAsync();
 
@@ -430,6 +468,7 @@ bool NamespaceExplorer::fetch(NamespaceItem& item)
       }
 
       dfsPath.back()->expansionFilteredOut = item.expansionFilteredOut;
+      numContainers++;
       return true;
     }
 
@@ -440,6 +479,7 @@ bool NamespaceExplorer::fetch(NamespaceItem& item)
       item.fullPath = buildDfsPath() + item.fileMd.name();
       item.expansionFilteredOut = false;
       handleLinkedAttrs(item);
+      numFiles++;
       return true;
     }
 
@@ -456,7 +496,31 @@ bool NamespaceExplorer::fetch(NamespaceItem& item)
   }
 
   // Search is over.
+  if (!searchEnded) {
+    searchEnded = true;
+    endTime = std::chrono::steady_clock::now();
+  }
+
   return false;
 }
 
+//------------------------------------------------------------------------------
+// Get statistics of the exploration so far
+//------------------------------------------------------------------------------
+ExplorationStats NamespaceExplorer::getStats() const
+{
+  if (parallelSearch) {
+    return parallelSearch->getStats();
+  }
+
+  ExplorationStats stats;
+  stats.containers = numContainers;
+  stats.files = numFiles;
+  // Fetching and returning items are interleaved
+  stats.totalSeconds = std::chrono::duration<double>((searchEnded ? endTime :
+                       std::chrono::steady_clock::now()) - startTime).count();
+  stats.fetchSeconds = stats.totalSeconds;
+  return stats;
+}
+
 EOSNSNAMESPACE_END
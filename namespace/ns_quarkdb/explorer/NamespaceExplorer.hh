@@ -30,9 +30,12 @@
 #include "namespace/interface/IContainerMD.hh"
 #include "namespace/interface/Identifiers.hh"
 #include "namespace/ns_quarkdb/utils/FutureVectorIterator.hh"
+#include <chrono>
+#include <map>
 #include <string>
 #include <vector>
 #include <deque>
+#include <mutex>
 #include <folly/futures/Future.h>
 
 namespace folly {
@@ -47,6 +50,7 @@ class QClient;
 EOSNSNAMESPACE_BEGIN
 
 class IView;
+class ParallelExplorer;
 
 class ExpansionDecider {
 public:
@@ -75,6 +79,44 @@ struct ExplorationOptions {
   // Ignore files?
   //----------------------------------------------------------------------------
   bool ignoreFiles = false;
+
+  //----------------------------------------------------------------------------
+  // Number of threads expanding containers in parallel, 0 runs the single
+  // threaded search. With threads, the expansion decider must be thread-safe.
+  //----------------------------------------------------------------------------
+  uint32_t numWorkers = 0;
+
+  //----------------------------------------------------------------------------
+  // Max number of outstanding QDB requests of all threads together
+  //----------------------------------------------------------------------------
+  uint32_t maxInFlight = 1000;
+
+  //----------------------------------------------------------------------------
+  // With threads: return items in the same depth-first order as the single
+  // threaded search. Otherwise, containers and their files are returned as
+  // soon as they are fetched.
+  //----------------------------------------------------------------------------
+  bool orderedOutput = true;
+};
+
+//------------------------------------------------------------------------------
+//! Exploration statistics
+//------------------------------------------------------------------------------
+struct ExplorationStats {
+  uint64_t containers = 0; ///< Containers fetched
+  uint64_t files = 0; ///< Files fetched
+  double fetchSeconds = 0; ///< Time spent until all metadata was fetched
+  double totalSeconds = 0; ///< Time spent until the last item was returned
+
+  double containerRate() const
+  {
+    return (fetchSeconds > 0) ? containers / fetchSeconds : 0;
+  }
+
+  double fileRate() const
+  {
+    return (fetchSeconds > 0) ? files / fetchSeconds : 0;
+  }
 };
 
 struct NamespaceItem {
@@ -179,7 +221,8 @@ private:
 //! Useful for "Find" commands - no consistency guarantees, if a write is in
 //! the flusher, it might not be seen here.
 //!
-//! Implemented by simple DFS on the namespace.
+//! Implemented by simple DFS on the namespace, or by a pool of threads when
+//! ExplorationOptions::numWorkers is set.
 //------------------------------------------------------------------------------
 class NamespaceExplorer
 {
@@ -191,21 +234,38 @@ public:
   NamespaceExplorer(const std::string& path, const ExplorationOptions& options,
                     qclient::QClient& qcl, folly::Executor *exec);
 
+  //----------------------------------------------------------------------------
+  //! Destructor
+  //----------------------------------------------------------------------------
+  ~NamespaceExplorer();
+
   //----------------------------------------------------------------------------
   //! Fetch next item.
   //----------------------------------------------------------------------------
   bool fetch(NamespaceItem& result);
 
+  //----------------------------------------------------------------------------
+  //! Get statistics of the exploration so far
+  //----------------------------------------------------------------------------
+  ExplorationStats getStats() const;
+
 private:
   friend class SearchNode;
+  friend class ParallelExplorer;
   std::string buildStaticPath();
   std::string buildDfsPath();
 
   //----------------------------------------------------------------------------
-  // Handle linked attributes
+  // Handle linked attributes, thread-safe
   //----------------------------------------------------------------------------
   void handleLinkedAttrs(NamespaceItem& result);
 
+  //----------------------------------------------------------------------------
+  // Start the exploration of the subtree below the given container
+  //----------------------------------------------------------------------------
+  void startSearch(ContainerIdentifier expectedParent, ContainerIdentifier id,
+                   const std::string& name);
+
   //----------------------------------------------------------------------------
   // Retrieve linked container for  Handle linked attributes
   //----------------------------------------------------------------------------
@@ -220,7 +280,15 @@ private:
   bool searchOnFileEnded = false;
 
   std::vector<std::unique_ptr<SearchNode>> dfsPath;
+  std::unique_ptr<ParallelExplorer> parallelSearch;
+  std::mutex cachedAttrsMutex;
   std::map<std::string, eos::IContainerMD::XAttrMap> cachedAttrs;
+
+  std::chrono::steady_clock::time_point startTime;
+  std::chrono::steady_clock::time_point endTime;
+  bool searchEnded = false;
+  uint64_t numContainers = 0;
+  uint64_t numFiles = 0;
 };
 
 EOSNSNAMESPACE_END
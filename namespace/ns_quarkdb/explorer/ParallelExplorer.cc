@@ -0,0 +1,448 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2021 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "namespace/ns_quarkdb/explorer/ParallelExplorer.hh"
+#include "namespace/ns_quarkdb/persistency/MetadataFetcher.hh"
+#include <algorithm>
+#include <iostream>
+#include <map>
+
+EOSNSNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+// Reserve slots of outstanding QDB requests
+//------------------------------------------------------------------------------
+ParallelExplorer::InFlightGuard::InFlightGuard(ParallelExplorer& owner,
+    uint64_t count)
+  : mOwner(owner), mCount(std::min(count, owner.mMaxInFlight))
+{
+  std::unique_lock<std::mutex> lock(mOwner.mInFlightMutex);
+  mOwner.mInFlightCv.wait(lock, [this]() {
+    return (mOwner.mInFlight + mCount <= mOwner.mMaxInFlight);
+  });
+  mOwner.mInFlight += mCount;
+}
+
+ParallelExplorer::InFlightGuard::~InFlightGuard()
+{
+  {
+    std::lock_guard<std::mutex> lock(mOwner.mInFlightMutex);
+    mOwner.mInFlight -= mCount;
+  }
+  mOwner.mInFlightCv.notify_all();
+}
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+ParallelExplorer::ParallelExplorer(NamespaceExplorer& explorer,
+                                   ContainerIdentifier expected_parent,
+                                   ContainerIdentifier id,
+                                   const std::string& path)
+  : mExplorer(explorer), mOrdered(explorer.options.orderedOutput),
+    mMaxInFlight(std::max(explorer.options.maxInFlight, 3u)),
+    mFileBatch(std::max<uint64_t>(mMaxInFlight /
+                                  (explorer.options.numWorkers + 1), 1)),
+    mStart(std::chrono::steady_clock::now())
+{
+  size_t num_workers = std::max(explorer.options.numWorkers, 1u);
+
+  for (size_t i = 0; i < num_workers; ++i) {
+    mQueues.emplace_back(new WorkQueue());
+  }
+
+  auto root = std::make_shared<Node>(expected_parent, id, std::string(path));
+
+  if (mOrdered) {
+    mStack.push_back(root);
+  }
+
+  pushWork(0, {root});
+
+  for (size_t i = 0; i < num_workers; ++i) {
+    mWorkers.emplace_back(&ParallelExplorer::workerLoop, this, i);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Destructor
+//------------------------------------------------------------------------------
+ParallelExplorer::~ParallelExplorer()
+{
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mStop = true;
+  }
+  mWorkCv.notify_all();
+
+  for (auto& worker : mWorkers) {
+    worker.join();
+  }
+}
+
+//------------------------------------------------------------------------------
+// Worker loop
+//------------------------------------------------------------------------------
+void
+ParallelExplorer::workerLoop(size_t index)
+{
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mMutex);
+      mWorkCv.wait(lock, [this]() {
+        return mStop || (mOutstanding == 0) ||
+               ((mQueued.load() > 0) && (mBuffered < kMaxBuffered));
+      });
+
+      if (mStop || (mOutstanding == 0)) {
+        return;
+      }
+    }
+
+    std::shared_ptr<Node> node = popWork(index);
+
+    // Nodes already expanded by the consumer are simply dropped
+    if (node && claim(*node)) {
+      expand(node, index);
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Take a node from our own queue or steal one from another queue
+//------------------------------------------------------------------------------
+std::shared_ptr<ParallelExplorer::Node>
+ParallelExplorer::popWork(size_t index)
+{
+  std::shared_ptr<Node> node;
+
+  for (size_t i = 0; i < mQueues.size(); ++i) {
+    WorkQueue& queue = *mQueues[(index + i) % mQueues.size()];
+    std::lock_guard<std::mutex> lock(queue.mMutex);
+
+    if (queue.mNodes.empty()) {
+      continue;
+    }
+
+    if (i == 0) {
+      node = std::move(queue.mNodes.back());
+      queue.mNodes.pop_back();
+    } else {
+      node = std::move(queue.mNodes.front());
+      queue.mNodes.pop_front();
+    }
+
+    --mQueued;
+    break;
+  }
+
+  return node;
+}
+
+//------------------------------------------------------------------------------
+// Push nodes to the given queue so that the first one is taken first
+//------------------------------------------------------------------------------
+void
+ParallelExplorer::pushWork(size_t index,
+                           const std::vector<std::shared_ptr<Node>>& nodes)
+{
+  if (nodes.empty()) {
+    return;
+  }
+
+  WorkQueue& queue = *mQueues[index % mQueues.size()];
+  std::lock_guard<std::mutex> lock(queue.mMutex);
+
+  for (auto it = nodes.rbegin(); it != nodes.rend(); ++it) {
+    queue.mNodes.push_back(*it);
+  }
+
+  mQueued += nodes.size();
+}
+
+//------------------------------------------------------------------------------
+// Expand a claimed node and publish it
+//------------------------------------------------------------------------------
+void
+ParallelExplorer::expand(const std::shared_ptr<Node>& node, size_t index)
+{
+  std::vector<std::shared_ptr<Node>> children = fetchContents(*node);
+  {
+    // Account for the children before they can be taken by other workers
+    std::lock_guard<std::mutex> lock(mMutex);
+    mOutstanding += children.size();
+  }
+  pushWork(index, children);
+
+  if (mOrdered) {
+    node->children = std::move(children);
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    node->state = State::kDone;
+    ++mBuffered;
+
+    if (!mOrdered) {
+      mExpanded.push_back(node);
+    }
+
+    if (--mOutstanding == 0) {
+      mFetchEnd = std::chrono::steady_clock::now();
+    }
+  }
+  mWorkCv.notify_all();
+  mOutputCv.notify_all();
+}
+
+//------------------------------------------------------------------------------
+// Fetch the metadata of the container and of its files
+//------------------------------------------------------------------------------
+std::vector<std::shared_ptr<ParallelExplorer::Node>>
+ParallelExplorer::fetchContents(Node& node)
+{
+  const ExplorationOptions& options = mExplorer.options;
+  std::vector<std::shared_ptr<Node>> children;
+  eos::ns::ContainerMdProto md;
+  IContainerMD::ContainerMap container_map;
+  IContainerMD::FileMap file_map;
+
+  try {
+    InFlightGuard guard(*this, options.ignoreFiles ? 2 : 3);
+    auto md_fut = MetadataFetcher::getContainerFromId(mExplorer.qcl, node.id);
+    auto container_map_fut = MetadataFetcher::getContainerMap(mExplorer.qcl,
+                             node.id);
+    auto file_map_fut = options.ignoreFiles ?
+                        folly::makeFuture<IContainerMD::FileMap>(IContainerMD::FileMap()) :
+                        MetadataFetcher::getFileMap(mExplorer.qcl, node.id);
+    md = std::move(md_fut).get();
+    container_map = std::move(container_map_fut).get();
+    file_map = std::move(file_map_fut).get();
+  } catch (...) {
+    // Same as the sequential search, containers which can't be fetched are
+    // skipped together with their contents
+    return children;
+  }
+
+  if (md.parent_id() != node.expectedParent.getUnderlyingUInt64()) {
+    std::cerr << "WARNING: Container #" << md.id() <<
+              " was expected to have #" <<
+              node.expectedParent.getUnderlyingUInt64() <<
+              " as parent; instead it has #" << md.parent_id() << std::endl;
+  }
+
+  ++mNumContainers;
+  node.items.emplace_back();
+  NamespaceItem& cont_item = node.items.back();
+  cont_item.isFile = false;
+  cont_item.fullPath = node.path;
+  cont_item.containerMd = std::move(md);
+  cont_item.numFiles = file_map.size();
+  cont_item.numContainers = container_map.size();
+  mExplorer.handleLinkedAttrs(cont_item);
+  cont_item.expansionFilteredOut = options.expansionDecider &&
+                                   !options.expansionDecider->shouldExpandContainer(cont_item.containerMd,
+                                       cont_item.attrs);
+
+  if (cont_item.expansionFilteredOut) {
+    return children;
+  }
+
+  // Files sorted by name, fetched in batches. The map is only initialized
+  // if the files were requested.
+  std::map<std::string, IFileMD::id_t> sorted_files;
+
+  if (!options.ignoreFiles) {
+    sorted_files.insert(file_map.begin(), file_map.end());
+  }
+
+  auto it = sorted_files.begin();
+
+  while (it != sorted_files.end()) {
+    std::vector<folly::Future<eos::ns::FileMdProto>> batch;
+    InFlightGuard guard(*this, std::min<uint64_t>(mFileBatch,
+                        std::distance(it, sorted_files.end())));
+
+    for (; (it != sorted_files.end()) && (batch.size() < mFileBatch); ++it) {
+      batch.emplace_back(MetadataFetcher::getFileFromId(mExplorer.qcl,
+                         FileIdentifier(it->second)));
+    }
+
+    for (auto& fut : batch) {
+      NamespaceItem file_item;
+
+      try {
+        file_item.fileMd = std::move(fut).get();
+      } catch (const MDException& e) {
+        // File is gone or broken, skip it like the sequential search does
+        continue;
+      }
+
+      ++mNumFiles;
+      file_item.isFile = true;
+      file_item.expansionFilteredOut = false;
+      file_item.fullPath = node.path + file_item.fileMd.name();
+      mExplorer.handleLinkedAttrs(file_item);
+      node.items.push_back(std::move(file_item));
+    }
+  }
+
+  std::vector<std::pair<std::string, IContainerMD::id_t>>
+      sorted_containers(container_map.begin(), container_map.end());
+  std::sort(sorted_containers.begin(), sorted_containers.end());
+  children.reserve(sorted_containers.size());
+
+  for (auto& entry : sorted_containers) {
+    children.push_back(std::make_shared<Node>(node.id,
+                       ContainerIdentifier(entry.second),
+                       node.path + entry.first + "/"));
+  }
+
+  return children;
+}
+
+//------------------------------------------------------------------------------
+// Wait until a node is expanded, expanding it here if still queued
+//------------------------------------------------------------------------------
+void
+ParallelExplorer::waitExpanded(const std::shared_ptr<Node>& node)
+{
+  if (claim(*node)) {
+    expand(node, 0);
+    return;
+  }
+
+  std::unique_lock<std::mutex> lock(mMutex);
+  mOutputCv.wait(lock, [&node]() {
+    return (node->state == State::kDone);
+  });
+}
+
+//------------------------------------------------------------------------------
+// Drop a consumed node from the buffer
+//------------------------------------------------------------------------------
+void
+ParallelExplorer::release(Node& node)
+{
+  std::vector<NamespaceItem>().swap(node.items);
+  std::vector<std::shared_ptr<Node>>().swap(node.children);
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    --mBuffered;
+  }
+  mWorkCv.notify_all();
+}
+
+//------------------------------------------------------------------------------
+// Fetch next item
+//------------------------------------------------------------------------------
+bool
+ParallelExplorer::fetch(NamespaceItem& item)
+{
+  if (mFinished) {
+    return false;
+  }
+
+  if (mOrdered ? fetchOrdered(item) : fetchUnordered(item)) {
+    return true;
+  }
+
+  mEnd = std::chrono::steady_clock::now();
+  mFinished = true;
+  return false;
+}
+
+//------------------------------------------------------------------------------
+// Fetch next item in depth-first order
+//------------------------------------------------------------------------------
+bool
+ParallelExplorer::fetchOrdered(NamespaceItem& item)
+{
+  while (!mStack.empty()) {
+    std::shared_ptr<Node> top = mStack.back();
+    waitExpanded(top);
+
+    if (top->nextItem < top->items.size()) {
+      item = std::move(top->items[top->nextItem++]);
+      return true;
+    }
+
+    if (top->nextChild < top->children.size()) {
+      mStack.push_back(std::move(top->children[top->nextChild++]));
+      continue;
+    }
+
+    mStack.pop_back();
+    release(*top);
+  }
+
+  return false;
+}
+
+//------------------------------------------------------------------------------
+// Fetch next item of whichever container got expanded first
+//------------------------------------------------------------------------------
+bool
+ParallelExplorer::fetchUnordered(NamespaceItem& item)
+{
+  while (true) {
+    if (mCurrent) {
+      if (mCurrent->nextItem < mCurrent->items.size()) {
+        item = std::move(mCurrent->items[mCurrent->nextItem++]);
+        return true;
+      }
+
+      release(*mCurrent);
+      mCurrent.reset();
+    }
+
+    std::unique_lock<std::mutex> lock(mMutex);
+    mOutputCv.wait(lock, [this]() {
+      return !mExpanded.empty() || (mOutstanding == 0);
+    });
+
+    if (mExpanded.empty()) {
+      return false;
+    }
+
+    mCurrent = std::move(mExpanded.front());
+    mExpanded.pop_front();
+  }
+}
+
+//------------------------------------------------------------------------------
+// Get exploration statistics
+//------------------------------------------------------------------------------
+ExplorationStats
+ParallelExplorer::getStats() const
+{
+  auto now = std::chrono::steady_clock::now();
+  ExplorationStats stats;
+  stats.containers = mNumContainers.load();
+  stats.files = mNumFiles.load();
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    stats.fetchSeconds = std::chrono::duration<double>
+                         (((mOutstanding == 0) ? mFetchEnd : now) - mStart).count();
+  }
+  stats.totalSeconds = std::chrono::duration<double>
+                       ((mFinished ? mEnd : now) - mStart).count();
+  return stats;
+}
+
+EOSNSNAMESPACE_END
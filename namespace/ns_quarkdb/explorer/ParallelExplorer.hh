@@ -0,0 +1,221 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2021 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+//------------------------------------------------------------------------------
+//! @brief Multi-threaded exploration of a namespace subtree
+//------------------------------------------------------------------------------
+
+#pragma once
+#include "namespace/Namespace.hh"
+#include "namespace/interface/Identifiers.hh"
+#include "namespace/ns_quarkdb/explorer/NamespaceExplorer.hh"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+EOSNSNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Expands the containers of a subtree using a pool of workers. Every worker
+//! owns a deque of pending containers: it pushes the subcontainers it finds
+//! and takes work from the back of its own deque, so that it goes depth
+//! first, or steals from the front of the others' when its own is empty.
+//! The number of outstanding QDB requests is capped across all workers.
+//!
+//! Expanded containers are buffered together with their files until they
+//! are consumed, workers pause once kMaxBuffered containers are waiting. In
+//! ordered mode the output follows the same depth-first order as the single
+//! threaded search: the consumer waits for the container it needs, or
+//! expands it itself if no worker got to it yet. In unordered mode the
+//! containers come out as soon as they are expanded.
+//------------------------------------------------------------------------------
+class ParallelExplorer
+{
+public:
+  static constexpr uint64_t kMaxBuffered = 10000;
+
+  //----------------------------------------------------------------------------
+  //! Constructor, starts the workers
+  //!
+  //! @param explorer explorer providing the options and the linked attributes
+  //! @param expected_parent expected parent of the root container
+  //! @param id root container
+  //! @param path full path of the root container, ending with "/"
+  //----------------------------------------------------------------------------
+  ParallelExplorer(NamespaceExplorer& explorer,
+                   ContainerIdentifier expected_parent, ContainerIdentifier id,
+                   const std::string& path);
+
+  //----------------------------------------------------------------------------
+  //! Destructor, stops the workers
+  //----------------------------------------------------------------------------
+  ~ParallelExplorer();
+
+  //----------------------------------------------------------------------------
+  //! Fetch next item
+  //----------------------------------------------------------------------------
+  bool fetch(NamespaceItem& item);
+
+  //----------------------------------------------------------------------------
+  //! Get exploration statistics
+  //----------------------------------------------------------------------------
+  ExplorationStats getStats() const;
+
+private:
+  enum class State {
+    kQueued,
+    kRunning,
+    kDone
+  };
+
+  //----------------------------------------------------------------------------
+  //! Container to expand
+  //----------------------------------------------------------------------------
+  struct Node {
+    Node(ContainerIdentifier parent, ContainerIdentifier cid,
+         std::string&& cpath)
+      : expectedParent(parent), id(cid), path(std::move(cpath)) {}
+
+    ContainerIdentifier expectedParent;
+    ContainerIdentifier id;
+    std::string path; ///< Full path, ending with "/"
+    std::atomic<State> state {State::kQueued};
+    //! Container followed by its files, empty if fetching failed
+    std::vector<NamespaceItem> items;
+    //! Subcontainers sorted by name, only kept in ordered mode
+    std::vector<std::shared_ptr<Node>> children;
+    size_t nextItem = 0; ///< Consumer position in items
+    size_t nextChild = 0; ///< Consumer position in children
+  };
+
+  //----------------------------------------------------------------------------
+  //! Containers pending expansion, owned by a worker
+  //----------------------------------------------------------------------------
+  struct WorkQueue {
+    std::mutex mMutex;
+    std::deque<std::shared_ptr<Node>> mNodes;
+  };
+
+  //----------------------------------------------------------------------------
+  //! Reserves slots of outstanding QDB requests
+  //----------------------------------------------------------------------------
+  class InFlightGuard
+  {
+  public:
+    InFlightGuard(ParallelExplorer& owner, uint64_t count);
+    ~InFlightGuard();
+
+  private:
+    ParallelExplorer& mOwner;
+    uint64_t mCount;
+  };
+
+  //----------------------------------------------------------------------------
+  //! Worker loop
+  //----------------------------------------------------------------------------
+  void workerLoop(size_t index);
+
+  //----------------------------------------------------------------------------
+  //! Take a node from the back of our own queue or steal one from the front
+  //! of another queue
+  //----------------------------------------------------------------------------
+  std::shared_ptr<Node> popWork(size_t index);
+
+  //----------------------------------------------------------------------------
+  //! Push nodes to the given queue so that the first one is taken first
+  //----------------------------------------------------------------------------
+  void pushWork(size_t index, const std::vector<std::shared_ptr<Node>>& nodes);
+
+  //----------------------------------------------------------------------------
+  //! Claim a queued node for expansion
+  //----------------------------------------------------------------------------
+  static bool claim(Node& node)
+  {
+    State expected = State::kQueued;
+    return node.state.compare_exchange_strong(expected, State::kRunning);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Fetch the metadata of a claimed node, queue its subcontainers and
+  //! publish it
+  //!
+  //! @param node node to expand
+  //! @param index queue receiving the subcontainers
+  //----------------------------------------------------------------------------
+  void expand(const std::shared_ptr<Node>& node, size_t index);
+
+  //----------------------------------------------------------------------------
+  //! Fetch the metadata of the container and of its files
+  //!
+  //! @return subcontainers to expand, sorted by name
+  //----------------------------------------------------------------------------
+  std::vector<std::shared_ptr<Node>> fetchContents(Node& node);
+
+  //----------------------------------------------------------------------------
+  //! Wait until a node is expanded, expanding it here if still queued
+  //----------------------------------------------------------------------------
+  void waitExpanded(const std::shared_ptr<Node>& node);
+
+  //----------------------------------------------------------------------------
+  //! Drop a consumed node from the buffer
+  //----------------------------------------------------------------------------
+  void release(Node& node);
+
+  bool fetchOrdered(NamespaceItem& item);
+  bool fetchUnordered(NamespaceItem& item);
+
+  NamespaceExplorer& mExplorer;
+  const bool mOrdered;
+  const uint64_t mMaxInFlight;
+  const uint64_t mFileBatch; ///< Max file requests issued at once
+  std::vector<std::unique_ptr<WorkQueue>> mQueues;
+  std::vector<std::thread> mWorkers;
+  std::atomic<uint64_t> mQueued {0}; ///< Entries in the queues
+
+  //! Protects the counters below, signals progress through the two
+  //! condition variables
+  mutable std::mutex mMutex;
+  std::condition_variable mWorkCv;
+  std::condition_variable mOutputCv;
+  bool mStop = false;
+  uint64_t mOutstanding = 1; ///< Nodes created but not expanded yet
+  uint64_t mBuffered = 0; ///< Nodes expanded but not consumed yet
+  std::deque<std::shared_ptr<Node>> mExpanded; ///< Unordered mode output
+
+  std::mutex mInFlightMutex;
+  std::condition_variable mInFlightCv;
+  uint64_t mInFlight = 0;
+
+  //! Consumer side, only accessed by fetch
+  std::vector<std::shared_ptr<Node>> mStack; ///< Ordered mode DFS path
+  std::shared_ptr<Node> mCurrent; ///< Unordered mode current node
+
+  std::chrono::steady_clock::time_point mStart;
+  std::chrono::steady_clock::time_point mFetchEnd; ///< Guarded by mMutex
+  std::chrono::steady_clock::time_point mEnd;
+  std::atomic<bool> mFinished {false};
+  std::atomic<uint64_t> mNumContainers {0};
+  std::atomic<uint64_t> mNumFiles {0};
+};
+
+EOSNSNAMESPACE_END
@@ -35,17 +35,26 @@
 
 EOSNSNAMESPACE_BEGIN
 
+//! Number of pending updates after which the coalescer is drained early
+static constexpr size_t sMaxCoalesced = 100000;
+
 //------------------------------------------------------------------------------
 // Constructor
 //------------------------------------------------------------------------------
 MetadataFlusher::MetadataFlusher(const std::string& path,
-                                 const QdbContactDetails& contactDetails) :
+                                 const QdbContactDetails& contactDetails,
+                                 std::chrono::milliseconds coalesceWindow) :
   id(basename(path.c_str())),
   notifier(*this),
   backgroundFlusher(contactDetails.members, contactDetails.constructOptions(),
                     notifier, new qclient::RocksDBPersistency(path)),
+  mCoalesceWindow(coalesceWindow),
   sizePrinter(&MetadataFlusher::queueSizeMonitoring, this)
 {
+  if (mCoalesceWindow.count() > 0) {
+    coalesceFlusher.reset(&MetadataFlusher::coalesceWindowFlushing, this);
+  }
+
   synchronize();
 }
 
@@ -54,6 +63,7 @@ MetadataFlusher::MetadataFlusher(const std::string& path,
 //------------------------------------------------------------------------------
 MetadataFlusher::~MetadataFlusher()
 {
+  coalesceFlusher.join();
   sizePrinter.join();
   synchronize();
 }
@@ -63,6 +73,8 @@ MetadataFlusher::~MetadataFlusher()
 //------------------------------------------------------------------------------
 void MetadataFlusher::queueSizeMonitoring(qclient::ThreadAssistant& assistant)
 {
+  CoalescingStats last;
+
   while (!assistant.terminationRequested()) {
     if (backgroundFlusher.size()) {
       eos_static_info("id=%s total-pending=%" PRId64 " enqueued=%" PRId64
@@ -72,17 +84,104 @@ void MetadataFlusher::queueSizeMonitoring(qclient::ThreadAssistant& assistant)
                       backgroundFlusher.getAcknowledgedAndClear());
     }
 
+    CoalescingStats current = getCoalescingStats();
+
+    if (current.mIncoming != last.mIncoming) {
+      uint64_t incoming = current.mIncoming - last.mIncoming;
+      uint64_t outgoing = current.mOutgoing - last.mOutgoing;
+      eos_static_info("id=%s coalesced-incoming=%" PRId64 " coalesced-outgoing=%"
+                      PRId64 " coalescing-ratio=%.2f", id.c_str(), incoming,
+                      outgoing, outgoing ? (double) incoming / outgoing : 0.0);
+      last = current;
+    }
+
     assistant.wait_for(std::chrono::seconds(10));
   }
 }
 
+//------------------------------------------------------------------------------
+// Regularly drain the coalesced updates
+//------------------------------------------------------------------------------
+void MetadataFlusher::coalesceWindowFlushing(qclient::ThreadAssistant&
+    assistant)
+{
+  while (!assistant.terminationRequested()) {
+    flushCoalesced();
+    assistant.wait_for(mCoalesceWindow);
+  }
+
+  flushCoalesced();
+}
+
+//------------------------------------------------------------------------------
+// Coalesce request or, if not possible, push it after the pending ones
+//------------------------------------------------------------------------------
+void MetadataFlusher::stage(const std::vector<std::string>& req)
+{
+  ++mIncoming;
+  std::lock_guard<std::mutex> lock(mCoalesceMutex);
+
+  if (mCoalesceWindow.count() > 0) {
+    if (mCoalescer.push(req)) {
+      if (mCoalescer.size() >= sMaxCoalesced) {
+        drainCoalescer();
+      }
+
+      return;
+    }
+
+    // Keep the order with respect to the updates already coalesced
+    drainCoalescer();
+  }
+
+  backgroundFlusher.pushRequest(req);
+  ++mOutgoing;
+}
+
+//------------------------------------------------------------------------------
+// Push coalesced updates to the background flusher
+//------------------------------------------------------------------------------
+void MetadataFlusher::drainCoalescer()
+{
+  if (mCoalescer.empty()) {
+    return;
+  }
+
+  std::vector<std::vector<std::string>> requests;
+  mOutgoing += mCoalescer.drain(requests);
+
+  for (const auto& req : requests) {
+    backgroundFlusher.pushRequest(req);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Hand over all coalesced updates to the background flusher
+//------------------------------------------------------------------------------
+void MetadataFlusher::flushCoalesced()
+{
+  std::lock_guard<std::mutex> lock(mCoalesceMutex);
+  drainCoalescer();
+}
+
+//------------------------------------------------------------------------------
+// Get coalescing counters
+//------------------------------------------------------------------------------
+MetadataFlusher::CoalescingStats MetadataFlusher::getCoalescingStats() const
+{
+  CoalescingStats stats;
+  stats.mIncoming = mIncoming;
+  stats.mOutgoing = mOutgoing;
+  return stats;
+}
+
 //------------------------------------------------------------------------------
 // Queue an hset command
 //------------------------------------------------------------------------------
 void MetadataFlusher::hset(const std::string& key, const std::string& field,
                            const std::string& value)
 {
-  backgroundFlusher.pushRequest({"HSET", key, field, value});
+  stage({"HSET", key, field, value});
 }
 
 //------------------------------------------------------------------------------
@@ -91,7 +190,7 @@ void MetadataFlusher::hset(const std::string& key, const std::string& field,
 void MetadataFlusher::hincrby(const std::string& key, const std::string& field,
                               int64_t value)
 {
-  backgroundFlusher.pushRequest({"HINCRBY", key, field, std::to_string(value)});
+  stage({"HINCRBY", key, field, std::to_string(value)});
 }
 
 //------------------------------------------------------------------------------
@@ -99,7 +198,7 @@ void MetadataFlusher::hincrby(const std::string& key, const std::string& field,
 //------------------------------------------------------------------------------
 void MetadataFlusher::del(const std::string& key)
 {
-  backgroundFlusher.pushRequest({"DEL", key});
+  stage({"DEL", key});
 }
 
 //------------------------------------------------------------------------------
@@ -107,7 +206,7 @@ void MetadataFlusher::del(const std::string& key)
 //------------------------------------------------------------------------------
 void MetadataFlusher::hdel(const std::string& key, const std::string& field)
 {
-  backgroundFlusher.pushRequest({"HDEL", key, field});
+  stage({"HDEL", key, field});
 }
 
 //------------------------------------------------------------------------------
@@ -115,7 +214,7 @@ void MetadataFlusher::hdel(const std::string& key, const std::string& field)
 //------------------------------------------------------------------------------
 void MetadataFlusher::sadd(const std::string& key, const std::string& field)
 {
-  backgroundFlusher.pushRequest({"SADD", key, field});
+  stage({"SADD", key, field});
 }
 
 //------------------------------------------------------------------------------
@@ -123,7 +222,7 @@ void MetadataFlusher::sadd(const std::string& key, const std::string& field)
 //------------------------------------------------------------------------------
 void MetadataFlusher::srem(const std::string& key, const std::string& field)
 {
-  backgroundFlusher.pushRequest({"SREM", key, field});
+  stage({"SREM", key, field});
 }
 
 //------------------------------------------------------------------------------
@@ -138,7 +237,7 @@ void MetadataFlusher::srem(const std::string& key,
     req.emplace_back(*it);
   }
 
-  backgroundFlusher.pushRequest(req);
+  stage(req);
 }
 
 //------------------------------------------------------------------------------
@@ -146,6 +245,9 @@ void MetadataFlusher::srem(const std::string& key,
 //------------------------------------------------------------------------------
 void MetadataFlusher::synchronize(ItemIndex targetIndex)
 {
+  // Everything staged before this call has to be part of the wait
+  flushCoalesced();
+
   if (targetIndex < 0) {
     targetIndex = backgroundFlusher.getEndingIndex() - 1;
   }
@@ -25,10 +25,14 @@
 #include "namespace/interface/IContainerMDSvc.hh"
 #include "namespace/interface/IContainerMD.hh"
 #include "namespace/ns_quarkdb/Constants.hh"
+#include "namespace/ns_quarkdb/flusher/WriteCoalescer.hh"
 #include "qclient/BackgroundFlusher.hh"
 #include "qclient/AssistedThread.hh"
+#include <atomic>
+#include <chrono>
 #include <list>
 #include <map>
+#include <mutex>
 
 EOSNSNAMESPACE_BEGIN
 
@@ -50,16 +54,38 @@ private:
 
 //------------------------------------------------------------------------------
 //! Metadata flushing towards QuarkDB
+//!
+//! Field level updates are kept for a short window in a WriteCoalescer so that
+//! repeated updates of the same field, e.g. the metadata of a file being
+//! written, reach the background flusher and its local journal only once.
+//! Requests which can not be coalesced drain the window first, so the order
+//! of the updates on any given field is preserved. Updates still in the
+//! window are not persisted locally yet.
 //------------------------------------------------------------------------------
 using ItemIndex = int64_t;
 class MetadataFlusher
 {
 public:
+  //----------------------------------------------------------------------------
+  //! Coalescing counters
+  //----------------------------------------------------------------------------
+  struct CoalescingStats {
+    uint64_t mIncoming = 0; ///< Requests received
+    uint64_t mOutgoing = 0; ///< Requests handed to the background flusher
+  };
+
   //----------------------------------------------------------------------------
   //! Constructor
+  //!
+  //! @param path path of the local queue
+  //! @param contactDetails QuarkDB cluster details
+  //! @param coalesceWindow time updates are kept for coalescing, 0 disables
+  //!        coalescing
   //----------------------------------------------------------------------------
   MetadataFlusher(const std::string& path,
-                  const QdbContactDetails& contactDetails);
+                  const QdbContactDetails& contactDetails,
+                  std::chrono::milliseconds coalesceWindow =
+                    std::chrono::milliseconds(10));
 
   //----------------------------------------------------------------------------
   //! Destructor
@@ -72,7 +98,7 @@ public:
   template<typename... Args>
   void exec(const Args... args)
   {
-    backgroundFlusher.pushRequest(std::vector<std::string> {args...});
+    stage(std::vector<std::string> {args...});
   }
 
   void del(const std::string& key);
@@ -87,7 +113,7 @@ public:
 
   void execute(const std::vector<std::string>& req)
   {
-    backgroundFlusher.pushRequest(req);
+    stage(req);
   }
 
   //----------------------------------------------------------------------------
@@ -99,13 +125,43 @@ public:
   //----------------------------------------------------------------------------
   void synchronize(ItemIndex targetIndex = -1);
 
+  //----------------------------------------------------------------------------
+  //! Hand over all coalesced updates to the background flusher
+  //----------------------------------------------------------------------------
+  void flushCoalesced();
+
+  //----------------------------------------------------------------------------
+  //! Get coalescing counters
+  //----------------------------------------------------------------------------
+  CoalescingStats getCoalescingStats() const;
+
 private:
+  //----------------------------------------------------------------------------
+  //! Coalesce request or, if not possible, push it after the pending ones
+  //----------------------------------------------------------------------------
+  void stage(const std::vector<std::string>& req);
+
+  //----------------------------------------------------------------------------
+  //! Push coalesced updates to the background flusher
+  //!
+  //! @note Must be called with mCoalesceMutex locked.
+  //----------------------------------------------------------------------------
+  void drainCoalescer();
+
   void queueSizeMonitoring(qclient::ThreadAssistant& assistant);
+  void coalesceWindowFlushing(qclient::ThreadAssistant& assistant);
   std::string id;
 
   FlusherNotifier notifier;
   qclient::BackgroundFlusher backgroundFlusher;
+  std::chrono::milliseconds mCoalesceWindow;
+  //! Protects the coalescer and the order of the pushes to the flusher
+  std::mutex mCoalesceMutex;
+  WriteCoalescer mCoalescer;
+  std::atomic<uint64_t> mIncoming {0};
+  std::atomic<uint64_t> mOutgoing {0};
   qclient::AssistedThread sizePrinter;
+  qclient::AssistedThread coalesceFlusher;
 };
 
 EOSNSNAMESPACE_END
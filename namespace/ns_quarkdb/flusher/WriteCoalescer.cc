@@ -0,0 +1,217 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2021 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "namespace/ns_quarkdb/flusher/WriteCoalescer.hh"
+#include "common/ParseUtils.hh"
+#include <map>
+
+EOSNSNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+// Add request
+//------------------------------------------------------------------------------
+bool
+WriteCoalescer::push(const Request& req)
+{
+  if (req.size() < 3) {
+    return false;
+  }
+
+  const std::string& cmd = req[0];
+  const std::string& key = req[1];
+
+  if ((cmd == "HSET") && (req.size() == 4)) {
+    add(Op::kHset, key, req[2], req[3]);
+  } else if ((cmd == "HDEL") && (req.size() == 3)) {
+    add(Op::kHdel, key, req[2]);
+  } else if ((cmd == "LHSET") && (req.size() == 5)) {
+    add(Op::kLhset, key, req[2], req[4], req[3]);
+  } else if ((cmd == "LHDEL") && (req.size() == 3)) {
+    add(Op::kLhdel, key, req[2]);
+  } else if ((cmd == "HINCRBY" && req.size() == 4) ||
+             (cmd == "HINCRBYMULTI" && (req.size() - 1) % 3 == 0)) {
+    // Validate all the increments before adding any of them
+    std::vector<int64_t> deltas;
+
+    for (size_t i = 3; i < req.size(); i += 3) {
+      int64_t delta;
+
+      if (!eos::common::ParseInt64(req[i], delta)) {
+        return false;
+      }
+
+      deltas.push_back(delta);
+    }
+
+    for (size_t i = 1; i < req.size(); i += 3) {
+      add(Op::kHincrby, req[i], req[i + 1], "", "", deltas[i / 3]);
+    }
+  } else if (cmd == "SADD" || cmd == "SREM") {
+    Op op = (cmd == "SADD") ? Op::kSadd : Op::kSrem;
+
+    for (size_t i = 2; i < req.size(); ++i) {
+      add(op, key, req[i]);
+    }
+  } else {
+    return false;
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Move the merged requests, in order, to the given vector
+//------------------------------------------------------------------------------
+size_t
+WriteCoalescer::drain(std::vector<Request>& out)
+{
+  size_t initial = out.size();
+  // Set updates of the same key are sent as a single request placed where
+  // the first of them was. They touch distinct members, so the order among
+  // them does not matter.
+  std::map<std::pair<Op, std::string>, size_t> set_requests;
+
+  for (size_t i = 0; i < mSlots.size(); ++i) {
+    Slot& slot = mSlots[i];
+
+    switch (slot.mOp) {
+    case Op::kHset:
+      out.push_back({"HSET", std::move(slot.mKey), std::move(slot.mField),
+                     std::move(slot.mValue)});
+      break;
+
+    case Op::kHdel:
+      out.push_back({"HDEL", std::move(slot.mKey), std::move(slot.mField)});
+      break;
+
+    case Op::kLhset:
+      out.push_back({"LHSET", std::move(slot.mKey), std::move(slot.mField),
+                     std::move(slot.mHint), std::move(slot.mValue)});
+      break;
+
+    case Op::kLhdel:
+      out.push_back({"LHDEL", std::move(slot.mKey), std::move(slot.mField)});
+      break;
+
+    case Op::kHincrby: {
+      // Consecutive increments are sent as one HINCRBYMULTI
+      Request req {"HINCRBYMULTI"};
+
+      while (true) {
+        req.push_back(std::move(mSlots[i].mKey));
+        req.push_back(std::move(mSlots[i].mField));
+        req.push_back(std::to_string(mSlots[i].mDelta));
+
+        if ((i + 1 == mSlots.size()) || (mSlots[i + 1].mOp != Op::kHincrby)) {
+          break;
+        }
+
+        ++i;
+      }
+
+      if (req.size() == 4) {
+        req[0] = "HINCRBY";
+      }
+
+      out.push_back(std::move(req));
+      break;
+    }
+
+    case Op::kSadd:
+    case Op::kSrem: {
+      auto it = set_requests.find({slot.mOp, slot.mKey});
+
+      if (it == set_requests.end()) {
+        set_requests[ {slot.mOp, slot.mKey}] = out.size();
+        out.push_back({(slot.mOp == Op::kSadd) ? "SADD" : "SREM",
+                       std::move(slot.mKey), std::move(slot.mField)
+                      });
+      } else {
+        out[it->second].push_back(std::move(slot.mField));
+      }
+
+      break;
+    }
+    }
+  }
+
+  mSlots.clear();
+  mIndex.clear();
+  return out.size() - initial;
+}
+
+//------------------------------------------------------------------------------
+// Get family of an operation
+//------------------------------------------------------------------------------
+int
+WriteCoalescer::family(Op op)
+{
+  switch (op) {
+  case Op::kHset:
+  case Op::kHdel:
+    return 0;
+
+  case Op::kLhset:
+  case Op::kLhdel:
+    return 1;
+
+  case Op::kHincrby:
+    return 2;
+
+  default:
+    return 3;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Merge update into the pending ones
+//------------------------------------------------------------------------------
+void
+WriteCoalescer::add(Op op, const std::string& key, const std::string& field,
+                    const std::string& value, const std::string& hint,
+                    int64_t delta)
+{
+  std::string id;
+  id.reserve(key.size() + field.size() + 1);
+  id.append(key).append(1, '\0').append(field);
+  auto it = mIndex.find(id);
+
+  if (it != mIndex.end()) {
+    Slot& slot = mSlots[it->second];
+
+    if (op == Op::kHincrby) {
+      // Increments can only be merged with previous increments
+      if (slot.mOp == Op::kHincrby) {
+        slot.mDelta += delta;
+        return;
+      }
+    } else if ((family(slot.mOp) == family(op)) ||
+               (slot.mOp == Op::kHincrby && family(op) == 0)) {
+      // Absolute writes replace whatever happened before to the field
+      slot.mOp = op;
+      slot.mValue = value;
+      slot.mHint = hint;
+      return;
+    }
+  }
+
+  mIndex[id] = mSlots.size();
+  mSlots.push_back(Slot{op, key, field, value, hint, delta});
+}
+
+EOSNSNAMESPACE_END
@@ -0,0 +1,116 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2021 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+//------------------------------------------------------------------------------
+//! @brief Merging of redundant metadata updates before they are flushed
+//------------------------------------------------------------------------------
+
+#pragma once
+#include "namespace/Namespace.hh"
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+EOSNSNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Collects field level updates and merges the ones touching the same field
+//! of the same key:
+//!  - HSET/HDEL and LHSET/LHDEL: the last write wins
+//!  - HINCRBY/HINCRBYMULTI: the increments are added up
+//!  - SADD/SREM: the last operation on a member wins
+//!
+//! A merged update keeps the position of the first update of its field, so
+//! the final state of every field is the same as if the requests were sent
+//! one by one. Requests which can not be merged e.g. DEL must be sent only
+//! after draining the coalescer. The class is not thread-safe.
+//------------------------------------------------------------------------------
+class WriteCoalescer
+{
+public:
+  using Request = std::vector<std::string>;
+
+  //----------------------------------------------------------------------------
+  //! Add request
+  //!
+  //! @param req redis request
+  //!
+  //! @return false if the request can not be coalesced, in which case nothing
+  //!         was added
+  //----------------------------------------------------------------------------
+  bool push(const Request& req);
+
+  //----------------------------------------------------------------------------
+  //! Move the merged requests, in order, to the given vector
+  //!
+  //! @param out vector to which the requests are appended
+  //!
+  //! @return number of requests appended
+  //----------------------------------------------------------------------------
+  size_t drain(std::vector<Request>& out);
+
+  //----------------------------------------------------------------------------
+  //! Number of pending field updates
+  //----------------------------------------------------------------------------
+  size_t size() const
+  {
+    return mSlots.size();
+  }
+
+  bool empty() const
+  {
+    return mSlots.empty();
+  }
+
+private:
+  //! Update types, the ones of the same family replace each other
+  enum class Op : uint8_t {
+    kHset, kHdel, kLhset, kLhdel, kHincrby, kSadd, kSrem
+  };
+
+  //----------------------------------------------------------------------------
+  //! Pending update of a single field or set member
+  //----------------------------------------------------------------------------
+  struct Slot {
+    Op mOp;
+    std::string mKey;
+    std::string mField;
+    std::string mValue;
+    std::string mHint; ///< Locality hint for LHSET
+    int64_t mDelta; ///< Increment for HINCRBY
+  };
+
+  //----------------------------------------------------------------------------
+  //! Get family of an operation
+  //----------------------------------------------------------------------------
+  static int family(Op op);
+
+  //----------------------------------------------------------------------------
+  //! Merge update into the pending ones
+  //----------------------------------------------------------------------------
+  void add(Op op, const std::string& key, const std::string& field,
+           const std::string& value = "", const std::string& hint = "",
+           int64_t delta = 0);
+
+  std::vector<Slot> mSlots; ///< Pending updates in order
+  //! Key and field to the index of the last slot updating them
+  std::unordered_map<std::string, size_t> mIndex;
+};
+
+EOSNSNAMESPACE_END
@@ -27,7 +27,13 @@ EOSNSNAMESPACE_BEGIN
 // Constructor
 //------------------------------------------------------------------------------
 ContainerScannerPrimitive::ContainerScannerPrimitive(qclient::QClient &qcl)
-: mIterator(&qcl, "eos-container-md") { }
+: mIterator(new qclient::QLocalityHash::Iterator(&qcl, "eos-container-md")) { }
+
+//------------------------------------------------------------------------------
+// Constructor, only go through the given range of ids
+//------------------------------------------------------------------------------
+ContainerScannerPrimitive::ContainerScannerPrimitive(qclient::QClient &qcl, const IdRange &range)
+: mRangeIterator(new IdRangeIterator(qcl, "eos-container-md", range)) { }
 
 //------------------------------------------------------------------------------
 // Is the iterator valid?
@@ -37,14 +43,23 @@ bool ContainerScannerPrimitive::valid() const {
     return false;
   }
 
-  return mIterator.valid();
+  if(mRangeIterator) {
+    return mRangeIterator->valid();
+  }
+
+  return mIterator->valid();
 }
 
 //----------------------------------------------------------------------------
 // Advance iterator - only call when valid() == true
 //----------------------------------------------------------------------------
 void ContainerScannerPrimitive::next() {
-  mIterator.next();
+  if(mRangeIterator) {
+    mRangeIterator->next();
+  }
+  else {
+    mIterator->next();
+  }
 }
 
 //------------------------------------------------------------------------------
@@ -56,7 +71,11 @@ bool ContainerScannerPrimitive::hasError(std::string &err) const {
     return true;
   }
 
-  return mIterator.hasError(err);
+  if(mRangeIterator) {
+    return mRangeIterator->hasError(err);
+  }
+
+  return mIterator->hasError(err);
 }
 
 //------------------------------------------------------------------------------
@@ -67,7 +86,7 @@ bool ContainerScannerPrimitive::getItem(eos::ns::ContainerMdProto &item) {
     return false;
   }
 
-  std::string currentValue = mIterator.getValue();
+  std::string currentValue = getValue();
   eos::MDStatus status = Serialization::deserialize(currentValue.c_str(), currentValue.size(), item);
 
   if(!status.ok()) {
@@ -79,6 +98,17 @@ bool ContainerScannerPrimitive::getItem(eos::ns::ContainerMdProto &item) {
   return true;
 }
 
+//------------------------------------------------------------------------------
+// Get serialized metadata of the current element
+//------------------------------------------------------------------------------
+std::string ContainerScannerPrimitive::getValue() const {
+  if(mRangeIterator) {
+    return mRangeIterator->getValue();
+  }
+
+  return mIterator->getValue();
+}
+
 //------------------------------------------------------------------------------
 // Get number of elements scanned so far
 //------------------------------------------------------------------------------
@@ -99,6 +129,19 @@ ContainerScanner::ContainerScanner(qclient::QClient &qcl, bool fullPaths, bool c
   }
 }
 
+//------------------------------------------------------------------------------
+// Constructor, only go through the given range of ids
+//------------------------------------------------------------------------------
+ContainerScanner::ContainerScanner(qclient::QClient &qcl, const IdRange &range, bool fullPaths, bool counts)
+: mScanner(qcl, range), mQcl(qcl), mFullPaths(fullPaths), mCounts(counts) {
+
+  mActive = mFullPaths || mCounts;
+
+  if(mActive) {
+    ensureItemDequeFull();
+  }
+}
+
 //------------------------------------------------------------------------------
 // Is the iterator valid?
 //------------------------------------------------------------------------------
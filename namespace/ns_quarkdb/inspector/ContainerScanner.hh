@@ -23,9 +23,11 @@
 
 #pragma once
 #include "namespace/Namespace.hh"
+#include "namespace/ns_quarkdb/inspector/IdRangeIterator.hh"
 #include "proto/ContainerMd.pb.h"
 #include <qclient/structures/QLocalityHash.hh>
 #include <folly/futures/Future.h>
+#include <memory>
 
 namespace qclient {
   class QClient;
@@ -43,6 +45,12 @@ public:
   //----------------------------------------------------------------------------
   ContainerScannerPrimitive(qclient::QClient &qcl);
 
+  //----------------------------------------------------------------------------
+  //! Constructor, only go through the given range of ids - the items come
+  //! out in ascending id order
+  //----------------------------------------------------------------------------
+  ContainerScannerPrimitive(qclient::QClient &qcl, const IdRange &range);
+
   //----------------------------------------------------------------------------
   //! Is the iterator valid?
   //----------------------------------------------------------------------------
@@ -69,7 +77,13 @@ public:
   uint64_t getScannedSoFar() const;
 
 private:
-  qclient::QLocalityHash::Iterator mIterator;
+  //----------------------------------------------------------------------------
+  //! Get serialized metadata of the current element
+  //----------------------------------------------------------------------------
+  std::string getValue() const;
+
+  std::unique_ptr<qclient::QLocalityHash::Iterator> mIterator;
+  std::unique_ptr<IdRangeIterator> mRangeIterator;
   std::string mError;
   uint64_t mScanned = 0;
 };
@@ -84,6 +98,11 @@ public:
   //----------------------------------------------------------------------------
   ContainerScanner(qclient::QClient &qcl, bool fullPaths = false, bool counts = false);
 
+  //----------------------------------------------------------------------------
+  //! Constructor, only go through the given range of ids
+  //----------------------------------------------------------------------------
+  ContainerScanner(qclient::QClient &qcl, const IdRange &range, bool fullPaths = false, bool counts = false);
+
   //----------------------------------------------------------------------------
   //! Is the iterator valid?
   //----------------------------------------------------------------------------
@@ -26,7 +26,13 @@ EOSNSNAMESPACE_BEGIN
 // Constructor
 //------------------------------------------------------------------------------
 FileScannerPrimitive::FileScannerPrimitive(qclient::QClient &qcl)
-: mIterator(&qcl, "eos-file-md") { }
+: mIterator(new qclient::QLocalityHash::Iterator(&qcl, "eos-file-md")) { }
+
+//------------------------------------------------------------------------------
+// Constructor, only go through the given range of ids
+//------------------------------------------------------------------------------
+FileScannerPrimitive::FileScannerPrimitive(qclient::QClient &qcl, const IdRange &range)
+: mRangeIterator(new IdRangeIterator(qcl, "eos-file-md", range)) { }
 
 //------------------------------------------------------------------------------
 // Is the iterator valid?
@@ -36,14 +42,23 @@ bool FileScannerPrimitive::valid() const {
     return false;
   }
 
-  return mIterator.valid();
+  if(mRangeIterator) {
+    return mRangeIterator->valid();
+  }
+
+  return mIterator->valid();
 }
 
 //----------------------------------------------------------------------------
 // Advance iterator - only call when valid() == true
 //----------------------------------------------------------------------------
 void FileScannerPrimitive::next() {
-  mIterator.next();
+  if(mRangeIterator) {
+    mRangeIterator->next();
+  }
+  else {
+    mIterator->next();
+  }
 }
 
 //------------------------------------------------------------------------------
@@ -55,7 +70,11 @@ bool FileScannerPrimitive::hasError(std::string &err) const {
     return true;
   }
 
-  return mIterator.hasError(err);
+  if(mRangeIterator) {
+    return mRangeIterator->hasError(err);
+  }
+
+  return mIterator->hasError(err);
 }
 
 //------------------------------------------------------------------------------
@@ -66,7 +85,7 @@ bool FileScannerPrimitive::getItem(eos::ns::FileMdProto &item) {
     return false;
   }
 
-  std::string currentValue = mIterator.getValue();
+  std::string currentValue = getValue();
   eos::MDStatus status = Serialization::deserialize(currentValue.c_str(), currentValue.size(), item);
 
   if(!status.ok()) {
@@ -78,6 +97,17 @@ bool FileScannerPrimitive::getItem(eos::ns::FileMdProto &item) {
   return true;
 }
 
+//------------------------------------------------------------------------------
+// Get serialized metadata of the current element
+//------------------------------------------------------------------------------
+std::string FileScannerPrimitive::getValue() const {
+  if(mRangeIterator) {
+    return mRangeIterator->getValue();
+  }
+
+  return mIterator->getValue();
+}
+
 //------------------------------------------------------------------------------
 // Get number of elements scanned so far
 //------------------------------------------------------------------------------
@@ -98,6 +128,19 @@ FileScanner::FileScanner(qclient::QClient &qcl, bool fullPaths)
   }
 }
 
+//------------------------------------------------------------------------------
+// Constructor, only go through the given range of ids
+//------------------------------------------------------------------------------
+FileScanner::FileScanner(qclient::QClient &qcl, const IdRange &range, bool fullPaths)
+: mScanner(qcl, range), mQcl(qcl), mFullPaths(fullPaths) {
+
+  mActive = mFullPaths;
+
+  if(mActive) {
+    ensureItemDequeFull();
+  }
+}
+
 //------------------------------------------------------------------------------
 // Is the iterator valid?
 //------------------------------------------------------------------------------
@@ -0,0 +1,141 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2021 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "namespace/ns_quarkdb/inspector/IdRangeIterator.hh"
+#include "namespace/ns_quarkdb/persistency/RequestBuilder.hh"
+#include "namespace/MDException.hh"
+#include <qclient/ResponseParsing.hh>
+
+EOSNSNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+// Split the ids in [1, maxId] into at most count contiguous ranges
+//------------------------------------------------------------------------------
+std::vector<IdRange> splitIdRange(uint64_t maxId, size_t count)
+{
+  std::vector<IdRange> ranges;
+
+  if ((maxId == 0) || (count == 0)) {
+    return ranges;
+  }
+
+  if (count > maxId) {
+    count = maxId;
+  }
+
+  // The first (maxId % count) ranges get one extra id
+  uint64_t size = maxId / count;
+  uint64_t extra = maxId % count;
+  uint64_t start = 1;
+
+  for (size_t i = 0; i < count; ++i) {
+    uint64_t end = start + size + (i < extra ? 1 : 0);
+    ranges.push_back(IdRange{start, end});
+    start = end;
+  }
+
+  return ranges;
+}
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+IdRangeIterator::IdRangeIterator(qclient::QClient& qcl,
+                                 const std::string& key, const IdRange& range)
+  : mQcl(qcl), mKey(key), mNextId(range.start), mEnd(range.end)
+{
+  seek();
+}
+
+//------------------------------------------------------------------------------
+// Is the iterator valid?
+//------------------------------------------------------------------------------
+bool IdRangeIterator::valid() const
+{
+  return mError.empty() && mHasValue;
+}
+
+//------------------------------------------------------------------------------
+// Advance iterator - only call when valid() == true
+//------------------------------------------------------------------------------
+void IdRangeIterator::next()
+{
+  seek();
+}
+
+//------------------------------------------------------------------------------
+// Is there an error?
+//------------------------------------------------------------------------------
+bool IdRangeIterator::hasError(std::string& err) const
+{
+  if (!mError.empty()) {
+    err = mError;
+    return true;
+  }
+
+  return false;
+}
+
+//------------------------------------------------------------------------------
+// Move to the next id with an entry
+//------------------------------------------------------------------------------
+void IdRangeIterator::seek()
+{
+  mHasValue = false;
+
+  while (mError.empty()) {
+    // Keep the pipeline full
+    while ((mNextId < mEnd) && (mPending.size() < kMaxPending)) {
+      mPending.emplace_back(mNextId, mQcl.follyExec(RedisRequest{
+        "LHGET", mKey, std::to_string(mNextId)}));
+      ++mNextId;
+    }
+
+    if (mPending.empty()) {
+      return;
+    }
+
+    uint64_t id = mPending.front().first;
+    qclient::redisReplyPtr reply = std::move(mPending.front().second).get();
+    mPending.pop_front();
+
+    if (!reply) {
+      mError = "QuarkDB backend not available!";
+      return;
+    }
+
+    // Deleted or never allocated id
+    if ((reply->type == REDIS_REPLY_NIL) ||
+        (reply->type == REDIS_REPLY_STRING && reply->len == 0)) {
+      continue;
+    }
+
+    if (reply->type != REDIS_REPLY_STRING) {
+      mError = SSTR("Unexpected response while fetching " << mKey << " #" << id
+                    << ": " << qclient::describeRedisReply(reply));
+      return;
+    }
+
+    mId = id;
+    mValue.assign(reply->str, reply->len);
+    mHasValue = true;
+    return;
+  }
+}
+
+EOSNSNAMESPACE_END
@@ -0,0 +1,125 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2021 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+//------------------------------------------------------------------------------
+//! @brief Iterate through the metadata of a contiguous range of ids
+//------------------------------------------------------------------------------
+
+#pragma once
+#include "namespace/Namespace.hh"
+#include <qclient/QClient.hh>
+#include <folly/futures/Future.h>
+#include <deque>
+#include <string>
+#include <utility>
+#include <vector>
+
+EOSNSNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Range of ids [start, end)
+//------------------------------------------------------------------------------
+struct IdRange {
+  uint64_t start = 0;
+  uint64_t end = 0;
+
+  bool operator==(const IdRange& other) const
+  {
+    return (start == other.start) && (end == other.end);
+  }
+};
+
+//------------------------------------------------------------------------------
+//! Split the ids in [1, maxId] into at most count contiguous ranges of
+//! (almost) equal size, in ascending order
+//------------------------------------------------------------------------------
+std::vector<IdRange> splitIdRange(uint64_t maxId, size_t count);
+
+//------------------------------------------------------------------------------
+//! Goes through the entries of a locality hash whose fields are the ids in
+//! the given range, in ascending id order. The entries are fetched with
+//! pipelined point lookups, up to kMaxPending at a time, and the ids with no
+//! entry are skipped. Unlike a scan of the whole locality hash, which goes
+//! through the entries in locality order, a range can be scanned
+//! independently of the others.
+//------------------------------------------------------------------------------
+class IdRangeIterator
+{
+public:
+  static constexpr size_t kMaxPending = 500;
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param qcl client to use, only accessed by this object
+  //! @param key locality hash to read, eos-file-md or eos-container-md
+  //! @param range ids to go through
+  //----------------------------------------------------------------------------
+  IdRangeIterator(qclient::QClient& qcl, const std::string& key,
+                  const IdRange& range);
+
+  //----------------------------------------------------------------------------
+  //! Is the iterator valid?
+  //----------------------------------------------------------------------------
+  bool valid() const;
+
+  //----------------------------------------------------------------------------
+  //! Advance iterator - only call when valid() == true
+  //----------------------------------------------------------------------------
+  void next();
+
+  //----------------------------------------------------------------------------
+  //! Is there an error?
+  //----------------------------------------------------------------------------
+  bool hasError(std::string& err) const;
+
+  //----------------------------------------------------------------------------
+  //! Get serialized metadata of the current element
+  //----------------------------------------------------------------------------
+  const std::string& getValue() const
+  {
+    return mValue;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get id of the current element
+  //----------------------------------------------------------------------------
+  uint64_t getId() const
+  {
+    return mId;
+  }
+
+private:
+  //----------------------------------------------------------------------------
+  //! Move to the next id with an entry
+  //----------------------------------------------------------------------------
+  void seek();
+
+  qclient::QClient& mQcl;
+  std::string mKey;
+  uint64_t mNextId; ///< Next id to request
+  uint64_t mEnd;
+  std::deque<std::pair<uint64_t, folly::Future<qclient::redisReplyPtr>>>
+      mPending;
+  bool mHasValue = false;
+  uint64_t mId = 0;
+  std::string mValue;
+  std::string mError;
+};
+
+EOSNSNAMESPACE_END
@@ -24,6 +24,7 @@
 #include "namespace/ns_quarkdb/inspector/Printing.hh"
 #include "namespace/ns_quarkdb/inspector/OutputSink.hh"
 #include "namespace/ns_quarkdb/inspector/FileMetadataFilter.hh"
+#include "namespace/ns_quarkdb/inspector/ShardedScan.hh"
 #include "namespace/ns_quarkdb/FileMD.hh"
 #include "namespace/ns_quarkdb/ContainerMD.hh"
 #include "namespace/ns_quarkdb/persistency/RequestBuilder.hh"
@@ -42,6 +43,7 @@
 #include <qclient/QClient.hh>
 #include <qclient/ResponseParsing.hh>
 #include <google/protobuf/util/json_util.h>
+#include <iostream>
 
 EOSNSNAMESPACE_BEGIN
 
@@ -85,6 +87,11 @@ static std::string toYesOrNo(bool val)
 Inspector::Inspector(qclient::QClient& qcl, OutputSink& sink)
   : mQcl(qcl), mOutputSink(sink) { }
 
+//------------------------------------------------------------------------------
+// Destructor
+//------------------------------------------------------------------------------
+Inspector::~Inspector() { }
+
 //------------------------------------------------------------------------------
 // Load configuration
 //------------------------------------------------------------------------------
@@ -126,6 +133,21 @@ void Inspector::setMetadataFilter(std::unique_ptr<FileMetadataFilter> filter)
   mMetadataFilter = std::move(filter);
 }
 
+//------------------------------------------------------------------------------
+// Use the given number of workers, each with its own connection
+//------------------------------------------------------------------------------
+void Inspector::setWorkers(const QdbContactDetails& cd, size_t workers,
+                           bool sorted)
+{
+  mWorkers = std::max<size_t>(workers, 1);
+  mSorted = sorted;
+  mShardedScan.reset();
+
+  if (mWorkers > 1) {
+    mShardedScan.reset(new ShardedScan(cd, mWorkers, mSorted));
+  }
+}
+
 //------------------------------------------------------------------------------
 // Is the connection to QDB ok? If not, pointless to run anything else.
 //------------------------------------------------------------------------------
@@ -171,6 +193,12 @@ int Inspector::scan(const std::string& rootPath, bool relative, bool rawPaths,
   ContainerPrintingOptions containerPrintingOpts;
   ExplorationOptions explorerOpts;
   explorerOpts.ignoreFiles = noFiles;
+
+  if (mWorkers > 1) {
+    explorerOpts.numWorkers = mWorkers;
+    explorerOpts.orderedOutput = mSorted;
+  }
+
   std::unique_ptr<folly::Executor> executor(new folly::IOThreadPoolExecutor(4));
   NamespaceExplorer explorer(rootPath, explorerOpts, mQcl, executor.get());
   NamespaceItem item;
@@ -212,6 +240,12 @@ int Inspector::dump(const std::string& dumpPath, bool relative, bool rawPaths,
 {
   ExplorationOptions explorerOpts;
   explorerOpts.ignoreFiles = noFiles;
+
+  if (mWorkers > 1) {
+    explorerOpts.numWorkers = mWorkers;
+    explorerOpts.orderedOutput = mSorted;
+  }
+
   std::unique_ptr<folly::Executor> executor(new folly::IOThreadPoolExecutor(4));
   NamespaceExplorer explorer(dumpPath, explorerOpts, mQcl, executor.get());
   NamespaceItem item;
@@ -310,18 +344,13 @@ uint64_t safeGet(folly::Future<uint64_t>& fut)
 }
 
 //------------------------------------------------------------------------------
-// Scan all directories in the namespace, and print out some information
-// about each one. (even potentially unreachable directories)
+// Print out the containers of the given scanner, for scanDirs
 //------------------------------------------------------------------------------
-int Inspector::scanDirs(bool onlyNoAttrs, bool fullPaths, bool countContents,
-                        size_t countThreshold)
+static int scanDirsWith(ContainerScanner& containerScanner, bool onlyNoAttrs,
+                        bool countContents, size_t countThreshold,
+                        OutputSink& sink)
 {
-  if (countThreshold > 0) {
-    countContents = true;
-  }
-
   ContainerPrintingOptions opts;
-  ContainerScanner containerScanner(mQcl, fullPaths, countContents);
 
   while (containerScanner.valid()) {
     eos::ns::ContainerMdProto proto;
@@ -342,20 +371,46 @@ int Inspector::scanDirs(bool onlyNoAttrs, bool fullPaths, bool countContents,
       continue;
     }
 
-    mOutputSink.print(proto, opts, item, countContents);
+    sink.print(proto, opts, item, countContents);
     containerScanner.next();
   }
 
   std::string errorString;
 
   if (containerScanner.hasError(errorString)) {
-    mOutputSink.err(errorString);
+    sink.err(errorString);
     return 1;
   }
 
   return 0;
 }
 
+//------------------------------------------------------------------------------
+// Scan all directories in the namespace, and print out some information
+// about each one. (even potentially unreachable directories)
+//------------------------------------------------------------------------------
+int Inspector::scanDirs(bool onlyNoAttrs, bool fullPaths, bool countContents,
+                        size_t countThreshold)
+{
+  if (countThreshold > 0) {
+    countContents = true;
+  }
+
+  if (mShardedScan) {
+    return mShardedScan->run(ShardedScan::getMaxId(mQcl), [&](ScanShard & shard) {
+      ContainerScanner containerScanner(shard.qcl, shard.range, fullPaths,
+                                        countContents);
+      shard.retval = scanDirsWith(containerScanner, onlyNoAttrs, countContents,
+                                  countThreshold, shard.sink);
+      shard.scanned = containerScanner.getScannedSoFar();
+    }, mOutputSink, std::cout, std::cerr, "containers");
+  }
+
+  ContainerScanner containerScanner(mQcl, fullPaths, countContents);
+  return scanDirsWith(containerScanner, onlyNoAttrs, countContents,
+                      countThreshold, mOutputSink);
+}
+
 //------------------------------------------------------------------------------
 // Fetch path or name from a combination of FileMdProto +
 // FileScanner::Item, return as much information as is available
@@ -418,7 +473,27 @@ int Inspector::scanFileMetadata(bool onlySizes, bool fullPaths,
     return -1;
   }
 
+  if (mShardedScan) {
+    return mShardedScan->run(ShardedScan::getMaxId(mQcl), [&](ScanShard & shard) {
+      FileScanner fileScanner(shard.qcl, shard.range, fullPaths);
+      shard.retval = scanFileMetadataWith(fileScanner, onlySizes,
+                                          findUnknownFsids, shard.sink);
+      shard.scanned = fileScanner.getScannedSoFar();
+    }, mOutputSink, std::cout, std::cerr, "files");
+  }
+
   FileScanner fileScanner(mQcl, fullPaths);
+  return scanFileMetadataWith(fileScanner, onlySizes, findUnknownFsids,
+                              mOutputSink);
+}
+
+//------------------------------------------------------------------------------
+// Print out the files of the given scanner, for scanFileMetadata. Only reads
+// the configuration and the filter, so it can run on several shards at once.
+//------------------------------------------------------------------------------
+int Inspector::scanFileMetadataWith(FileScanner& fileScanner, bool onlySizes,
+                                    bool findUnknownFsids, OutputSink& sink)
+{
   FilePrintingOptions opts;
 
   while (fileScanner.valid()) {
@@ -440,9 +515,9 @@ int Inspector::scanFileMetadata(bool onlySizes, bool fullPaths,
     }
 
     if (onlySizes) {
-      mOutputSink.print(std::to_string(proto.size()));
+      sink.print(std::to_string(proto.size()));
     } else {
-      mOutputSink.print(proto, opts, item);
+      sink.print(proto, opts, item);
     }
 
     fileScanner.next();
@@ -451,7 +526,7 @@ int Inspector::scanFileMetadata(bool onlySizes, bool fullPaths,
   std::string errorString;
 
   if (fileScanner.hasError(errorString)) {
-    mOutputSink.err(errorString);
+    sink.err(errorString);
     return 1;
   }
 
@@ -576,12 +651,13 @@ bool shouldPrint(bool filterInternal, const std::string& fullPath)
 }
 
 //------------------------------------------------------------------------------
-// Find files with layout = 1 replica
+// Find files with layout = 1 replica among the files of the given scanner
 //------------------------------------------------------------------------------
-int Inspector::oneReplicaLayout(bool showName, bool showPaths,
-                                bool filterInternal, std::ostream& out, std::ostream& err)
+static int oneReplicaLayoutWith(FileScanner& fileScanner, bool showName,
+                                bool showPaths, bool filterInternal,
+                                std::ostream& out, std::ostream& err,
+                                bool showProgress)
 {
-  FileScanner fileScanner(mQcl, showPaths | filterInternal);
   common::IntervalStopwatch stopwatch(std::chrono::seconds(10));
 
   while (fileScanner.valid()) {
@@ -624,7 +700,7 @@ int Inspector::oneReplicaLayout(bool showName, bool showPaths,
 
     fileScanner.next();
 
-    if (stopwatch.restartIfExpired()) {
+    if (showProgress && stopwatch.restartIfExpired()) {
       err << "Progress: Processed " << fileScanner.getScannedSoFar() <<
           " files so far..." << std::endl;
     }
@@ -640,13 +716,33 @@ int Inspector::oneReplicaLayout(bool showName, bool showPaths,
   return 0;
 }
 
+//------------------------------------------------------------------------------
+// Find files with layout = 1 replica
+//------------------------------------------------------------------------------
+int Inspector::oneReplicaLayout(bool showName, bool showPaths,
+                                bool filterInternal, std::ostream& out, std::ostream& err)
+{
+  if (mShardedScan) {
+    return mShardedScan->run(ShardedScan::getMaxId(mQcl), [&](ScanShard & shard) {
+      FileScanner fileScanner(shard.qcl, shard.range, showPaths | filterInternal);
+      shard.retval = oneReplicaLayoutWith(fileScanner, showName, showPaths,
+                                          filterInternal, shard.out, shard.err, false);
+      shard.scanned = fileScanner.getScannedSoFar();
+    }, mOutputSink, out, err, "files");
+  }
+
+  FileScanner fileScanner(mQcl, showPaths | filterInternal);
+  return oneReplicaLayoutWith(fileScanner, showName, showPaths, filterInternal,
+                              out, err, true);
+}
+
 //----------------------------------------------------------------------------
-// Find files with non-nominal number of stripes (replicas)
+// Find files with non-nominal number of stripes (replicas) among the files
+// of the given scanner
 //----------------------------------------------------------------------------
-int Inspector::stripediff(bool printTime, std::ostream& out, std::ostream& err)
+static int stripediffWith(FileScanner& fileScanner, bool printTime,
+                          std::ostream& out, std::ostream& err)
 {
-  FileScanner fileScanner(mQcl);
-
   while (fileScanner.valid()) {
     eos::ns::FileMdProto proto;
 
@@ -694,6 +790,23 @@ int Inspector::stripediff(bool printTime, std::ostream& out, std::ostream& err)
   return 0;
 }
 
+//----------------------------------------------------------------------------
+// Find files with non-nominal number of stripes (replicas)
+//----------------------------------------------------------------------------
+int Inspector::stripediff(bool printTime, std::ostream& out, std::ostream& err)
+{
+  if (mShardedScan) {
+    return mShardedScan->run(ShardedScan::getMaxId(mQcl), [&](ScanShard & shard) {
+      FileScanner fileScanner(shard.qcl, shard.range);
+      shard.retval = stripediffWith(fileScanner, printTime, shard.out, shard.err);
+      shard.scanned = fileScanner.getScannedSoFar();
+    }, mOutputSink, out, err, "files");
+  }
+
+  FileScanner fileScanner(mQcl);
+  return stripediffWith(fileScanner, printTime, out, err);
+}
+
 class ConflictSet
 {
 public:
@@ -918,9 +1031,11 @@ struct PendingFile {
     : validParent(std::move(f)), proto(p) {}
 };
 
-void consumePendingEntries(std::deque<PendingFile>& futs, bool unconditional,
-                           std::ostream& out)
+uint64_t consumePendingEntries(std::deque<PendingFile>& futs,
+                               bool unconditional, std::ostream& out)
 {
+  uint64_t orphans = 0;
+
   while (!futs.empty() && (unconditional || futs.front().validParent.isReady())) {
     PendingFile& entry = futs.front();
     entry.validParent.wait();
@@ -935,10 +1050,13 @@ void consumePendingEntries(std::deque<PendingFile>& futs, bool unconditional,
           entry.proto.cont_id() << " size=" << entry.proto.size() << " locations=" <<
           serializeLocations(entry.proto.locations()) << " unlinked-locations=" <<
           serializeLocations(entry.proto.unlink_locations()) << std::endl;
+      orphans++;
     }
 
     futs.pop_front();
   }
+
+  return orphans;
 }
 
 struct PendingContainer {
@@ -949,9 +1067,11 @@ struct PendingContainer {
     : validParent(std::move(f)), proto(p) {}
 };
 
-void consumePendingEntries(std::deque<PendingContainer>& futs,
-                           bool unconditional, std::ostream& out)
+uint64_t consumePendingEntries(std::deque<PendingContainer>& futs,
+                               bool unconditional, std::ostream& out)
 {
+  uint64_t orphans = 0;
+
   while (!futs.empty() && (unconditional || futs.front().validParent.isReady())) {
     PendingContainer& entry = futs.front();
     entry.validParent.wait();
@@ -964,27 +1084,29 @@ void consumePendingEntries(std::deque<PendingContainer>& futs,
     } else if (std::move(entry.validParent).get() == false) {
       out << "container-id=" << entry.proto.id() << " invalid-parent-id=" <<
           entry.proto.parent_id() << std::endl;
+      orphans++;
     }
 
     futs.pop_front();
   }
+
+  return orphans;
 }
 
 //------------------------------------------------------------------------------
-// Find orphan files and orphan directories
+// Find orphan directories among the containers of the given scanner
 //------------------------------------------------------------------------------
-int Inspector::checkOrphans(std::ostream& out, std::ostream& err)
+static int checkOrphanContainers(qclient::QClient& qcl,
+                                 ContainerScanner& containerScanner,
+                                 std::ostream& out, std::ostream& err,
+                                 bool showProgress, uint64_t& orphans)
 {
-  //----------------------------------------------------------------------------
-  // Look for orphan containers..
-  //----------------------------------------------------------------------------
   std::string errorString;
-  ContainerScanner containerScanner(mQcl);
   common::IntervalStopwatch stopwatch(std::chrono::seconds(10));
   std::deque<PendingContainer> containers;
 
   while (containerScanner.valid()) {
-    consumePendingEntries(containers, false, out);
+    orphans += consumePendingEntries(containers, false, out);
     eos::ns::ContainerMdProto proto;
 
     if (!containerScanner.getItem(proto)) {
@@ -992,12 +1114,12 @@ int Inspector::checkOrphans(std::ostream& out, std::ostream& err)
     }
 
     containers.emplace_back(
-      MetadataFetcher::doesContainerMdExist(mQcl,
+      MetadataFetcher::doesContainerMdExist(qcl,
                                             ContainerIdentifier(proto.parent_id())),
       proto
     );
 
-    if (stopwatch.restartIfExpired()) {
+    if (showProgress && stopwatch.restartIfExpired()) {
       err << "Progress: Processed " << containerScanner.getScannedSoFar() <<
           " containers so far..." << std::endl;
     }
@@ -1005,22 +1127,29 @@ int Inspector::checkOrphans(std::ostream& out, std::ostream& err)
     containerScanner.next();
   }
 
-  consumePendingEntries(containers, true, out);
+  orphans += consumePendingEntries(containers, true, out);
 
   if (containerScanner.hasError(errorString)) {
     err << errorString;
     return 1;
   }
 
-  err << "All containers processed, checking files..." << std::endl;
-  //----------------------------------------------------------------------------
-  // Look for orphan files..
-  //----------------------------------------------------------------------------
-  FileScanner fileScanner(mQcl);
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+// Find orphan files among the files of the given scanner
+//------------------------------------------------------------------------------
+static int checkOrphanFiles(qclient::QClient& qcl, FileScanner& fileScanner,
+                            std::ostream& out, std::ostream& err,
+                            bool showProgress, uint64_t& orphans)
+{
+  std::string errorString;
+  common::IntervalStopwatch stopwatch(std::chrono::seconds(10));
   std::deque<PendingFile> files;
 
   while (fileScanner.valid()) {
-    consumePendingEntries(files, false, out);
+    orphans += consumePendingEntries(files, false, out);
     eos::ns::FileMdProto proto;
 
     if (!fileScanner.getItem(proto)) {
@@ -1028,12 +1157,12 @@ int Inspector::checkOrphans(std::ostream& out, std::ostream& err)
     }
 
     files.emplace_back(
-      MetadataFetcher::doesContainerMdExist(mQcl,
+      MetadataFetcher::doesContainerMdExist(qcl,
                                             ContainerIdentifier(proto.cont_id())),
       proto
     );
 
-    if (stopwatch.restartIfExpired()) {
+    if (showProgress && stopwatch.restartIfExpired()) {
       err << "Progress: Processed " << fileScanner.getScannedSoFar() <<
           " files so far..." << std::endl;
     }
@@ -1041,7 +1170,7 @@ int Inspector::checkOrphans(std::ostream& out, std::ostream& err)
     fileScanner.next();
   }
 
-  consumePendingEntries(files, true, out);
+  orphans += consumePendingEntries(files, true, out);
 
   if (fileScanner.hasError(errorString)) {
     err << errorString;
@@ -1051,6 +1180,64 @@ int Inspector::checkOrphans(std::ostream& out, std::ostream& err)
   return 0;
 }
 
+//------------------------------------------------------------------------------
+// Find orphan files and orphan directories
+//------------------------------------------------------------------------------
+int Inspector::checkOrphans(std::ostream& out, std::ostream& err)
+{
+  uint64_t orphanContainers = 0;
+  uint64_t orphanFiles = 0;
+
+  if (mShardedScan) {
+    //--------------------------------------------------------------------------
+    // Every shard counts its own orphans, summed up once all are done
+    //--------------------------------------------------------------------------
+    uint64_t maxId = ShardedScan::getMaxId(mQcl);
+    int retval = mShardedScan->run(maxId, [&](ScanShard & shard) {
+      ContainerScanner containerScanner(shard.qcl, shard.range);
+      shard.retval = checkOrphanContainers(shard.qcl, containerScanner, shard.out,
+                                           shard.err, false, shard.counters["orphans"]);
+      shard.scanned = containerScanner.getScannedSoFar();
+    }, mOutputSink, out, err, "containers");
+
+    if (retval != 0) {
+      return retval;
+    }
+
+    orphanContainers = mShardedScan->getCounters().count("orphans") ?
+                       mShardedScan->getCounters().at("orphans") : 0;
+    err << "All containers processed, checking files..." << std::endl;
+    retval = mShardedScan->run(maxId, [&](ScanShard & shard) {
+      FileScanner fileScanner(shard.qcl, shard.range);
+      shard.retval = checkOrphanFiles(shard.qcl, fileScanner, shard.out,
+                                      shard.err, false, shard.counters["orphans"]);
+      shard.scanned = fileScanner.getScannedSoFar();
+    }, mOutputSink, out, err, "files");
+    orphanFiles = mShardedScan->getCounters().count("orphans") ?
+                  mShardedScan->getCounters().at("orphans") : 0;
+    err << "Found " << orphanContainers << " orphan containers and " <<
+        orphanFiles << " orphan files" << std::endl;
+    return retval;
+  }
+
+  //----------------------------------------------------------------------------
+  // Look for orphan containers..
+  //----------------------------------------------------------------------------
+  ContainerScanner containerScanner(mQcl);
+
+  if (checkOrphanContainers(mQcl, containerScanner, out, err, true,
+                            orphanContainers) != 0) {
+    return 1;
+  }
+
+  err << "All containers processed, checking files..." << std::endl;
+  //----------------------------------------------------------------------------
+  // Look for orphan files..
+  //----------------------------------------------------------------------------
+  FileScanner fileScanner(mQcl);
+  return checkOrphanFiles(mQcl, fileScanner, out, err, true, orphanFiles);
+}
+
 //------------------------------------------------------------------------------
 // Helper struct for checkFsViewMissing
 //------------------------------------------------------------------------------
@@ -1065,9 +1252,11 @@ struct FsViewItemExists {
     : valid(std::move(v)), proto(pr), location(loc), unlinked(unl) {}
 };
 
-void consumeFsViewQueue(std::deque<FsViewItemExists>& futs, bool unconditional,
-                        std::ostream& out)
+uint64_t consumeFsViewQueue(std::deque<FsViewItemExists>& futs,
+                            bool unconditional, std::ostream& out)
 {
+  uint64_t missing = 0;
+
   while (!futs.empty() && (unconditional || futs.front().valid.isReady())) {
     FsViewItemExists& entry = futs.front();
     entry.valid.wait();
@@ -1090,27 +1279,29 @@ void consumeFsViewQueue(std::deque<FsViewItemExists>& futs, bool unconditional,
               entry.proto.unlink_locations()) << " missing-location=" << entry.location <<
             std::endl;
       }
+
+      missing++;
     }
 
     futs.pop_front();
   }
+
+  return missing;
 }
 
 //------------------------------------------------------------------------------
-// Search for holes in FsView: Items which should be in FsView according to
-// FMD locations / unlinked locations, but are not there.
+// Search for holes in FsView among the files of the given scanner
 //------------------------------------------------------------------------------
-int Inspector::checkFsViewMissing(std::ostream& out, std::ostream& err)
+static int checkFsViewMissingWith(qclient::QClient& qcl,
+                                  FileScanner& fileScanner, std::ostream& out,
+                                  std::ostream& err, bool showProgress,
+                                  uint64_t& missing)
 {
-  //----------------------------------------------------------------------------
-  // Search through all FileMDs..
-  //----------------------------------------------------------------------------
   std::deque<FsViewItemExists> queue;
-  FileScanner fileScanner(mQcl);
   common::IntervalStopwatch stopwatch(std::chrono::seconds(10));
 
   while (fileScanner.valid()) {
-    consumeFsViewQueue(queue, false, out);
+    missing += consumeFsViewQueue(queue, false, out);
     eos::ns::FileMdProto proto;
 
     if (!fileScanner.getItem(proto)) {
@@ -1119,19 +1310,19 @@ int Inspector::checkFsViewMissing(std::ostream& out, std::ostream& err)
 
     for (auto it = proto.locations().cbegin(); it != proto.locations().cend();
          it++) {
-      queue.emplace_back(MetadataFetcher::locationExistsInFsView(mQcl,
+      queue.emplace_back(MetadataFetcher::locationExistsInFsView(qcl,
                          FileIdentifier(proto.id()),
                          *it, false), proto, *it, false);
     }
 
     for (auto it = proto.unlink_locations().cbegin();
          it != proto.unlink_locations().cend(); it++) {
-      queue.emplace_back(MetadataFetcher::locationExistsInFsView(mQcl,
+      queue.emplace_back(MetadataFetcher::locationExistsInFsView(qcl,
                          FileIdentifier(proto.id()),
                          *it, true), proto, *it, true);
     }
 
-    if (stopwatch.restartIfExpired()) {
+    if (showProgress && stopwatch.restartIfExpired()) {
       err << "Progress: Processed " << fileScanner.getScannedSoFar() <<
           " files so far" << std::endl;
     }
@@ -1139,7 +1330,7 @@ int Inspector::checkFsViewMissing(std::ostream& out, std::ostream& err)
     fileScanner.next();
   }
 
-  consumeFsViewQueue(queue, true, out);
+  missing += consumeFsViewQueue(queue, true, out);
   std::string errorString;
 
   if (fileScanner.hasError(errorString)) {
@@ -1150,6 +1341,35 @@ int Inspector::checkFsViewMissing(std::ostream& out, std::ostream& err)
   return 0;
 }
 
+//------------------------------------------------------------------------------
+// Search for holes in FsView: Items which should be in FsView according to
+// FMD locations / unlinked locations, but are not there.
+//------------------------------------------------------------------------------
+int Inspector::checkFsViewMissing(std::ostream& out, std::ostream& err)
+{
+  uint64_t missing = 0;
+
+  if (mShardedScan) {
+    int retval = mShardedScan->run(ShardedScan::getMaxId(mQcl),
+    [&](ScanShard & shard) {
+      FileScanner fileScanner(shard.qcl, shard.range);
+      shard.retval = checkFsViewMissingWith(shard.qcl, fileScanner, shard.out,
+                                            shard.err, false, shard.counters["missing"]);
+      shard.scanned = fileScanner.getScannedSoFar();
+    }, mOutputSink, out, err, "files");
+    missing = mShardedScan->getCounters().count("missing") ?
+              mShardedScan->getCounters().at("missing") : 0;
+    err << "Found " << missing << " locations missing from FsView" << std::endl;
+    return retval;
+  }
+
+  //----------------------------------------------------------------------------
+  // Search through all FileMDs..
+  //----------------------------------------------------------------------------
+  FileScanner fileScanner(mQcl);
+  return checkFsViewMissingWith(mQcl, fileScanner, out, err, true, missing);
+}
+
 struct FsViewExpectInLocations {
   folly::Future<eos::ns::FileMdProto> proto;
   int64_t futureFid;
@@ -29,6 +29,7 @@
 #include <map>
 #include <vector>
 #include <set>
+#include <memory>
 
 namespace qclient {
   class QClient;
@@ -40,6 +41,8 @@ class ContainerScanner;
 class FileScanner;
 class OutputSink;
 class FileMetadataFilter;
+class QdbContactDetails;
+class ShardedScan;
 
 struct CacheNotifications {
   CacheNotifications() {}
@@ -58,6 +61,11 @@ public:
   //----------------------------------------------------------------------------
   Inspector(qclient::QClient &qcl, OutputSink &sink);
 
+  //----------------------------------------------------------------------------
+  //! Destructor
+  //----------------------------------------------------------------------------
+  ~Inspector();
+
   //----------------------------------------------------------------------------
   //! Is the connection to QDB ok? If not, pointless to run anything else.
   //----------------------------------------------------------------------------
@@ -200,7 +208,24 @@ public:
   //----------------------------------------------------------------------------
   void setMetadataFilter(std::unique_ptr<FileMetadataFilter> filter);
 
+  //----------------------------------------------------------------------------
+  //! Use the given number of workers, each with its own connection. The
+  //! scans going through all file or container metadata then split the id
+  //! space into ranges scanned in parallel, the output goes by ascending id
+  //! instead of by parent container. scan explores the tree in parallel.
+  //!
+  //! @param cd contact details used for the connections of the workers
+  //! @param workers number of workers, 1 means no parallelism
+  //! @param sorted keep the output in a deterministic order
+  //----------------------------------------------------------------------------
+  void setWorkers(const QdbContactDetails &cd, size_t workers, bool sorted);
+
 private:
+  //----------------------------------------------------------------------------
+  //! Print out the files of the given scanner, for scanFileMetadata
+  //----------------------------------------------------------------------------
+  int scanFileMetadataWith(FileScanner &fileScanner, bool onlySizes, bool findUnknownFsids, OutputSink &sink);
+
   std::map<std::string, std::string> mgmConfiguration;
   std::set<int64_t> validFsIds;
 
@@ -209,6 +234,10 @@ private:
 
   std::unique_ptr<FileMetadataFilter> mMetadataFilter;
 
+  size_t mWorkers = 1;
+  bool mSorted = true;
+  std::unique_ptr<ShardedScan> mShardedScan; ///< Set if mWorkers > 1
+
   //----------------------------------------------------------------------------
   //! Check if given path is a good choice as a destination for repaired
   //! files / containers
@@ -396,4 +396,49 @@ void JsonStreamSink::err(const std::string &str) {
   mErr << str << std::endl;
 }
 
+//------------------------------------------------------------------------------
+// Print implementation
+//------------------------------------------------------------------------------
+void BufferedSink::print(const std::map<std::string, std::string> &line) {
+  mEntries.push_back(Entry{EntryType::kMap, line, {}});
+}
+
+//------------------------------------------------------------------------------
+// Print interface, single string implementation
+//------------------------------------------------------------------------------
+void BufferedSink::print(const std::string &out) {
+  mEntries.push_back(Entry{EntryType::kString, {}, out});
+}
+
+//------------------------------------------------------------------------------
+// Debug output
+//------------------------------------------------------------------------------
+void BufferedSink::err(const std::string &str) {
+  mEntries.push_back(Entry{EntryType::kErr, {}, str});
+}
+
+//------------------------------------------------------------------------------
+// Send everything collected so far to the given sink
+//------------------------------------------------------------------------------
+void BufferedSink::replay(OutputSink &target) {
+  for(auto it = mEntries.begin(); it != mEntries.end(); it++) {
+    switch(it->type) {
+      case EntryType::kMap: {
+        target.print(it->line);
+        break;
+      }
+      case EntryType::kString: {
+        target.print(it->str);
+        break;
+      }
+      case EntryType::kErr: {
+        target.err(it->str);
+        break;
+      }
+    }
+  }
+
+  std::vector<Entry>().swap(mEntries);
+}
+
 EOSNSNAMESPACE_END
@@ -28,6 +28,7 @@
 #include "proto/ContainerMd.pb.h"
 #include "proto/FileMd.pb.h"
 #include <map>
+#include <vector>
 
 EOSNSNAMESPACE_BEGIN
 
@@ -165,5 +166,54 @@ private:
   bool mFirst;
 };
 
+//------------------------------------------------------------------------------
+//! OutputSink implementation keeping everything in memory, to be replayed
+//! into another sink later on. Used by sharded scans, where every shard
+//! collects its own output.
+//------------------------------------------------------------------------------
+class BufferedSink : public OutputSink {
+public:
+  //----------------------------------------------------------------------------
+  //! Print implementation
+  //----------------------------------------------------------------------------
+  virtual void print(const std::map<std::string, std::string> &line) override;
+
+  //----------------------------------------------------------------------------
+  //! Print interface, single string implementation
+  //----------------------------------------------------------------------------
+  virtual void print(const std::string &out) override;
+
+  //----------------------------------------------------------------------------
+  //! Debug output
+  //----------------------------------------------------------------------------
+  virtual void err(const std::string &str) override;
+
+  //----------------------------------------------------------------------------
+  //! Send everything collected so far to the given sink, in the original
+  //! order, and clear the buffer
+  //----------------------------------------------------------------------------
+  void replay(OutputSink &target);
+
+  //----------------------------------------------------------------------------
+  //! Is the buffer empty?
+  //----------------------------------------------------------------------------
+  bool empty() const {
+    return mEntries.empty();
+  }
+
+private:
+  enum class EntryType {
+    kMap, kString, kErr
+  };
+
+  struct Entry {
+    EntryType type;
+    std::map<std::string, std::string> line;
+    std::string str;
+  };
+
+  std::vector<Entry> mEntries;
+};
+
 
 EOSNSNAMESPACE_END
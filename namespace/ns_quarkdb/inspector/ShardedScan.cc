@@ -0,0 +1,199 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2021 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "namespace/ns_quarkdb/inspector/ShardedScan.hh"
+#include "namespace/ns_quarkdb/Constants.hh"
+#include "common/IntervalStopwatch.hh"
+#include "common/ParseUtils.hh"
+#include <qclient/QClient.hh>
+#include <algorithm>
+#include <thread>
+
+EOSNSNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+ShardedScan::ShardedScan(const QdbContactDetails& cd, size_t workers,
+                         bool sorted)
+  : mContactDetails(cd), mWorkers(std::max<size_t>(workers, 1)),
+    mSorted(sorted) {}
+
+//------------------------------------------------------------------------------
+// Get the largest id handed out so far for either files or containers
+//------------------------------------------------------------------------------
+uint64_t ShardedScan::getMaxId(qclient::QClient& qcl)
+{
+  uint64_t maxId = 0;
+
+  // Containers take their ids from the file counter when inodes are shared
+  for (const auto& field : {
+         constants::sLastUsedFid, constants::sLastUsedCid
+       }) {
+    qclient::redisReplyPtr reply = qcl.exec("HGET", constants::sMapMetaInfoKey,
+                                            field).get();
+    uint64_t value = 0;
+
+    if (reply && (reply->type == REDIS_REPLY_STRING) &&
+        common::ParseUInt64(std::string(reply->str, reply->len), value)) {
+      maxId = std::max(maxId, value);
+    }
+  }
+
+  return maxId;
+}
+
+//------------------------------------------------------------------------------
+// Split the id space into shards and run the given function on each one
+//------------------------------------------------------------------------------
+int ShardedScan::run(uint64_t maxId, const ShardFunction& fn,
+                     OutputSink& sink, std::ostream& out, std::ostream& err,
+                     const std::string& what)
+{
+  size_t numShards = std::max<uint64_t>(mWorkers * 4,
+                                        (maxId + kIdsPerShard - 1) / kIdsPerShard);
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mRanges = splitIdRange(maxId, numShards);
+    mNextShard = 0;
+    mFlushed = 0;
+    mDone.clear();
+    mDone.resize(mRanges.size());
+    mDoneOrder.clear();
+    mScanned = 0;
+    mCounters.clear();
+  }
+  std::vector<std::thread> workers;
+
+  for (size_t i = 0; i < mWorkers; ++i) {
+    workers.emplace_back(&ShardedScan::workerLoop, this, std::cref(fn));
+  }
+
+  int retval = 0;
+  common::IntervalStopwatch stopwatch(std::chrono::seconds(10));
+  std::unique_lock<std::mutex> lock(mMutex);
+
+  while (mFlushed < mRanges.size()) {
+    std::unique_ptr<ScanShard> shard;
+
+    if (mSorted) {
+      shard = std::move(mDone[mFlushed]);
+    } else if (!mDoneOrder.empty()) {
+      shard = std::move(mDone[mDoneOrder.front()]);
+      mDoneOrder.pop_front();
+    }
+
+    if (!shard) {
+      mDoneCv.wait_for(lock, std::chrono::seconds(1));
+
+      if (stopwatch.restartIfExpired()) {
+        err << "Progress: Processed " << mScanned << " " << what <<
+            " so far..." << std::endl;
+      }
+
+      continue;
+    }
+
+    // Write out without holding the lock, the workers keep going
+    lock.unlock();
+    flush(*shard, sink, out, err);
+
+    if ((retval == 0) && (shard->retval != 0)) {
+      retval = shard->retval;
+    }
+
+    shard.reset();
+    lock.lock();
+    ++mFlushed;
+    mWorkCv.notify_all();
+  }
+
+  lock.unlock();
+
+  for (auto& worker : workers) {
+    worker.join();
+  }
+
+  return retval;
+}
+
+//------------------------------------------------------------------------------
+// Worker loop, scans shards until none is left
+//------------------------------------------------------------------------------
+void ShardedScan::workerLoop(const ShardFunction& fn)
+{
+  qclient::QClient qcl(mContactDetails.members,
+                       mContactDetails.constructOptions());
+
+  while (true) {
+    size_t index;
+    {
+      std::unique_lock<std::mutex> lock(mMutex);
+
+      if (mSorted) {
+        mWorkCv.wait(lock, [&]() {
+          return (mNextShard >= mRanges.size()) ||
+                 (mNextShard < mFlushed + kWindow * mWorkers);
+        });
+      }
+
+      if (mNextShard >= mRanges.size()) {
+        return;
+      }
+
+      index = mNextShard++;
+    }
+    std::unique_ptr<ScanShard> shard(new ScanShard(index, mRanges[index], qcl));
+
+    try {
+      fn(*shard);
+    } catch (const std::exception& e) {
+      shard->err << "Exception while scanning ids [" << shard->range.start <<
+                 ", " << shard->range.end << "): " << e.what() << std::endl;
+      shard->retval = 1;
+    }
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    mScanned += shard->scanned;
+    mDone[index] = std::move(shard);
+
+    if (!mSorted) {
+      mDoneOrder.push_back(index);
+    }
+
+    mDoneCv.notify_all();
+  }
+}
+
+//------------------------------------------------------------------------------
+// Write out the output of a shard and merge its partial results
+//------------------------------------------------------------------------------
+void ShardedScan::flush(ScanShard& shard, OutputSink& sink, std::ostream& out,
+                        std::ostream& err)
+{
+  shard.sink.replay(sink);
+  out << shard.out.str();
+  err << shard.err.str();
+  std::lock_guard<std::mutex> lock(mMutex);
+
+  for (auto it = shard.counters.begin(); it != shard.counters.end(); ++it) {
+    mCounters[it->first] += it->second;
+  }
+}
+
+EOSNSNAMESPACE_END
@@ -0,0 +1,165 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2021 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+//------------------------------------------------------------------------------
+//! @brief Scan the namespace metadata in parallel, one id range per shard
+//------------------------------------------------------------------------------
+
+#pragma once
+#include "namespace/Namespace.hh"
+#include "namespace/ns_quarkdb/QdbContactDetails.hh"
+#include "namespace/ns_quarkdb/inspector/IdRangeIterator.hh"
+#include "namespace/ns_quarkdb/inspector/OutputSink.hh"
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace qclient {
+  class QClient;
+}
+
+EOSNSNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! A shard of a sharded scan: the range of ids to go through, the connection
+//! to use and everything the shard produces. Output is collected here and
+//! only written out once the shard is done, so the shards never interleave.
+//------------------------------------------------------------------------------
+struct ScanShard {
+  ScanShard(size_t idx, const IdRange& r, qclient::QClient& q)
+    : index(idx), range(r), qcl(q) {}
+
+  size_t index;
+  IdRange range;
+  qclient::QClient& qcl; ///< Connection of the worker running the shard
+
+  std::ostringstream out; ///< Results, for checks writing to a stream
+  std::ostringstream err; ///< Errors
+  BufferedSink sink; ///< Results, for scans writing to the output sink
+  int retval = 0; ///< ERRNO-like, 0 means no error
+  uint64_t scanned = 0; ///< Number of items scanned, for progress reports
+  //! Partial results, summed over all shards at the end
+  std::map<std::string, uint64_t> counters;
+};
+
+//------------------------------------------------------------------------------
+//! Splits the id space into contiguous ranges and scans them with a pool of
+//! workers, each with its own QClient. There are many more shards than
+//! workers so that they get balanced, and so that the output of a single
+//! shard stays small.
+//!
+//! The output of the shards is written from the calling thread. With sorted
+//! output it comes in shard order, i.e. ascending id order, no matter how
+//! many workers are used - workers don't run ahead of the output by more
+//! than kWindow shards per worker to bound the memory. Otherwise it comes
+//! as soon as a shard is done.
+//------------------------------------------------------------------------------
+class ShardedScan
+{
+public:
+  //! Target number of ids per shard
+  static constexpr uint64_t kIdsPerShard = 1 << 16;
+  //! Max number of shards per worker running ahead of the sorted output
+  static constexpr size_t kWindow = 2;
+
+  using ShardFunction = std::function<void(ScanShard&)>;
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param cd contact details used for the connections of the workers
+  //! @param workers number of parallel workers
+  //! @param sorted keep the output in id order
+  //----------------------------------------------------------------------------
+  ShardedScan(const QdbContactDetails& cd, size_t workers, bool sorted);
+
+  //----------------------------------------------------------------------------
+  //! Get the largest id handed out so far for either files or containers,
+  //! i.e. the upper bound of the id space to scan
+  //----------------------------------------------------------------------------
+  static uint64_t getMaxId(qclient::QClient& qcl);
+
+  //----------------------------------------------------------------------------
+  //! Split the id space into shards and run the given function on each one
+  //!
+  //! @param maxId upper bound of the id space
+  //! @param fn function scanning a shard, called from the workers
+  //! @param sink receives the output collected through ScanShard::sink
+  //! @param out receives the output collected through ScanShard::out
+  //! @param err receives errors and progress reports
+  //! @param what name of the scanned items for progress reports
+  //!
+  //! @return 0 if all shards succeeded, otherwise the error code of the
+  //!         first failed shard
+  //----------------------------------------------------------------------------
+  int run(uint64_t maxId, const ShardFunction& fn, OutputSink& sink,
+          std::ostream& out, std::ostream& err, const std::string& what);
+
+  //----------------------------------------------------------------------------
+  //! Get the counters of the last run, summed over all shards
+  //----------------------------------------------------------------------------
+  const std::map<std::string, uint64_t>& getCounters() const
+  {
+    return mCounters;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get number of items scanned in the last run
+  //----------------------------------------------------------------------------
+  uint64_t getScanned() const
+  {
+    return mScanned;
+  }
+
+private:
+  //----------------------------------------------------------------------------
+  //! Worker loop, scans shards until none is left
+  //----------------------------------------------------------------------------
+  void workerLoop(const ShardFunction& fn);
+
+  //----------------------------------------------------------------------------
+  //! Write out the output of a shard and merge its partial results
+  //----------------------------------------------------------------------------
+  void flush(ScanShard& shard, OutputSink& sink, std::ostream& out,
+             std::ostream& err);
+
+  QdbContactDetails mContactDetails;
+  size_t mWorkers;
+  bool mSorted;
+
+  //! Protects everything below
+  std::mutex mMutex;
+  std::condition_variable mWorkCv; ///< Signals shards being written out
+  std::condition_variable mDoneCv; ///< Signals shards being done
+  std::vector<IdRange> mRanges;
+  size_t mNextShard = 0; ///< Next shard to hand out to a worker
+  size_t mFlushed = 0; ///< Number of shards written out
+  //! Finished shards waiting to be written out, indexed by shard
+  std::vector<std::unique_ptr<ScanShard>> mDone;
+  std::deque<size_t> mDoneOrder; ///< Finished shards in completion order
+  uint64_t mScanned = 0;
+  std::map<std::string, uint64_t> mCounters;
+};
+
+EOSNSNAMESPACE_END
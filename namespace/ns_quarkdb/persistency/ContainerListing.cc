@@ -0,0 +1,196 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2021 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "namespace/ns_quarkdb/persistency/ContainerListing.hh"
+#include "namespace/ns_quarkdb/ContainerMD.hh"
+#include "namespace/MDException.hh"
+#include <folly/futures/Future.h>
+
+EOSNSNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+// Fetch a page of the entries of a container
+//------------------------------------------------------------------------------
+folly::Future<ContainerListing::Page>
+ContainerListing::getPage(qclient::QClient& qcl, ContainerIdentifier id,
+                          const std::string& cursor, size_t max_entries,
+                          bool files, bool containers)
+{
+  std::string after;
+
+  if (!decodeCursor(cursor, after)) {
+    return folly::makeFuture<Page>(make_mdexception(EINVAL,
+                                   "Invalid listing cursor for container #"
+                                   << id.getUnderlyingUInt64()));
+  }
+
+  // Each map can contribute the whole page
+  folly::Future<MetadataFetcher::MapPage> files_fut = files ?
+      MetadataFetcher::getFileMapPage(qcl, id, after, max_entries) :
+      folly::makeFuture<MetadataFetcher::MapPage>(MetadataFetcher::MapPage());
+  folly::Future<MetadataFetcher::MapPage> containers_fut = containers ?
+      MetadataFetcher::getContainerMapPage(qcl, id, after, max_entries) :
+      folly::makeFuture<MetadataFetcher::MapPage>(MetadataFetcher::MapPage());
+  return folly::collect(files_fut, containers_fut)
+  .thenValue([max_entries](std::tuple<MetadataFetcher::MapPage,
+  MetadataFetcher::MapPage> tup) {
+    return mergePages(std::move(std::get<0>(tup)), std::move(std::get<1>(tup)),
+                      max_entries);
+  });
+}
+
+//------------------------------------------------------------------------------
+// Fetch the metadata of a large container without its entries
+//------------------------------------------------------------------------------
+folly::Future<ContainerListing::LargeContainer>
+ContainerListing::getLargeContainer(qclient::QClient& qcl,
+                                    ContainerIdentifier id, uint64_t threshold)
+{
+  auto counts = MetadataFetcher::countContents(qcl, id);
+  return folly::collect(counts.first, counts.second)
+  .thenValue([&qcl, id, threshold](std::tuple<uint64_t, uint64_t> tup) {
+    LargeContainer result;
+    result.numFiles = std::get<0>(tup);
+    result.numContainers = std::get<1>(tup);
+
+    if (result.numFiles + result.numContainers < threshold) {
+      return folly::makeFuture<LargeContainer>(std::move(result));
+    }
+
+    return MetadataFetcher::getContainerFromId(qcl, id)
+    .thenValue([result](eos::ns::ContainerMdProto proto) mutable {
+      auto cont = std::make_shared<QuarkContainerMD>();
+      cont->initializeWithoutChildren(std::move(proto));
+      result.container = std::move(cont);
+      return result;
+    });
+  });
+}
+
+//------------------------------------------------------------------------------
+// Merge pages of the file and subcontainer maps into a listing page
+//------------------------------------------------------------------------------
+ContainerListing::Page
+ContainerListing::mergePages(MetadataFetcher::MapPage&& files,
+                             MetadataFetcher::MapPage&& containers,
+                             size_t max_entries)
+{
+  Page page;
+  auto it_file = files.entries.begin();
+  auto it_cont = containers.entries.begin();
+  page.entries.reserve(std::min(max_entries, files.entries.size() +
+                                containers.entries.size()));
+
+  while (page.entries.size() < max_entries) {
+    bool take_file;
+
+    if (it_file == files.entries.end()) {
+      if (it_cont == containers.entries.end()) {
+        break;
+      }
+
+      take_file = false;
+    } else if (it_cont == containers.entries.end()) {
+      take_file = true;
+    } else {
+      take_file = (it_file->first < it_cont->first);
+    }
+
+    if (take_file) {
+      page.entries.push_back(Entry{std::move(it_file->first),
+                                   FileIdentifier(it_file->second)});
+      ++it_file;
+    } else {
+      page.entries.push_back(Entry{std::move(it_cont->first),
+                                   ContainerIdentifier(it_cont->second)});
+      ++it_cont;
+    }
+  }
+
+  // Entries of either map following the last one taken are fetched again with
+  // the next page. None of them can sort before it, since every map page holds
+  // at most max_entries entries.
+  if (files.more || containers.more ||
+      (it_file != files.entries.end()) ||
+      (it_cont != containers.entries.end())) {
+    if (!page.entries.empty()) {
+      page.cursor = encodeCursor(page.entries.back().name);
+    }
+  }
+
+  return page;
+}
+
+//------------------------------------------------------------------------------
+// Build the cursor of the page following the given name
+//------------------------------------------------------------------------------
+std::string
+ContainerListing::encodeCursor(const std::string& name)
+{
+  static const char* sHex = "0123456789abcdef";
+  std::string cursor;
+  cursor.reserve(2 * name.size());
+
+  for (unsigned char c : name) {
+    cursor.push_back(sHex[c >> 4]);
+    cursor.push_back(sHex[c & 0xf]);
+  }
+
+  return cursor;
+}
+
+//------------------------------------------------------------------------------
+// Extract the name after which the page starts from the given cursor
+//------------------------------------------------------------------------------
+bool
+ContainerListing::decodeCursor(const std::string& cursor, std::string& name)
+{
+  auto nibble = [](char c) -> int {
+    if (c >= '0' && c <= '9') {
+      return c - '0';
+    }
+
+    if (c >= 'a' && c <= 'f') {
+      return c - 'a' + 10;
+    }
+
+    return -1;
+  };
+
+  if (cursor.size() % 2) {
+    return false;
+  }
+
+  name.clear();
+  name.reserve(cursor.size() / 2);
+
+  for (size_t i = 0; i < cursor.size(); i += 2) {
+    int high = nibble(cursor[i]);
+    int low = nibble(cursor[i + 1]);
+
+    if ((high < 0) || (low < 0)) {
+      return false;
+    }
+
+    name.push_back((char)((high << 4) | low));
+  }
+
+  return true;
+}
+
+EOSNSNAMESPACE_END
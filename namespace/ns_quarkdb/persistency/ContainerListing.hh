@@ -0,0 +1,153 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2021 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+//------------------------------------------------------------------------------
+//! @brief Paged listing of containers stored in QuarkDB - no caching!
+//------------------------------------------------------------------------------
+
+#pragma once
+#include "namespace/Namespace.hh"
+#include "namespace/interface/IContainerMD.hh"
+#include "namespace/interface/Identifiers.hh"
+#include "namespace/ns_quarkdb/persistency/MetadataFetcher.hh"
+#include <folly/futures/Future.h>
+#include <string>
+#include <vector>
+
+//! Forward declaration
+namespace qclient
+{
+class QClient;
+}
+
+EOSNSNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Lists the files and subcontainers of a container in pages sorted by name,
+//! fetching from QuarkDB only the entries of the requested page. Meant for
+//! containers too large to be loaded with all their entries into the
+//! metadata cache.
+//!
+//! A page is identified by an opaque cursor encoding the name of the last
+//! entry of the previous page. Entries added or removed while a listing is
+//! in progress don't make the following pages skip or repeat other entries.
+//! Updates which are still in the flusher queue are not visible.
+//------------------------------------------------------------------------------
+class ContainerListing
+{
+public:
+  static constexpr size_t kDefaultPageSize = 10000;
+
+  //----------------------------------------------------------------------------
+  //! Container entry
+  //----------------------------------------------------------------------------
+  struct Entry {
+    std::string name;
+    FileOrContainerIdentifier id;
+  };
+
+  //----------------------------------------------------------------------------
+  //! Page of container entries sorted by name
+  //----------------------------------------------------------------------------
+  struct Page {
+    std::vector<Entry> entries;
+    //! Cursor of the following page, empty if this is the last one
+    std::string cursor;
+  };
+
+  //----------------------------------------------------------------------------
+  //! Container metadata loaded without its entries
+  //----------------------------------------------------------------------------
+  struct LargeContainer {
+    //! Container without file and subcontainer maps, null if the container
+    //! is not large
+    IContainerMDPtr container;
+    uint64_t numFiles = 0;
+    uint64_t numContainers = 0;
+  };
+
+  //----------------------------------------------------------------------------
+  //! Fetch a page of the entries of a container
+  //!
+  //! @param qcl qclient object
+  //! @param id container id
+  //! @param cursor cursor returned with the previous page, empty to start
+  //!        from the beginning
+  //! @param max_entries max number of entries in the page
+  //! @param files include files
+  //! @param containers include subcontainers
+  //!
+  //! @return future holding the page, fails with EINVAL if the cursor is
+  //!         not valid
+  //----------------------------------------------------------------------------
+  static folly::Future<Page>
+  getPage(qclient::QClient& qcl, ContainerIdentifier id,
+          const std::string& cursor, size_t max_entries = kDefaultPageSize,
+          bool files = true, bool containers = true);
+
+  //----------------------------------------------------------------------------
+  //! Count the entries of a container and, if they are at least the given
+  //! threshold, fetch its metadata without the entries. The returned object
+  //! is detached from the metadata services and must only be used to read
+  //! the container attributes e.g. for permission checks.
+  //!
+  //! @param qcl qclient object
+  //! @param id container id
+  //! @param threshold min number of entries of a large container
+  //!
+  //! @return future holding the container, if large, and its counters
+  //----------------------------------------------------------------------------
+  static folly::Future<LargeContainer>
+  getLargeContainer(qclient::QClient& qcl, ContainerIdentifier id,
+                    uint64_t threshold);
+
+  //----------------------------------------------------------------------------
+  //! Merge pages of the file and subcontainer maps into a listing page
+  //!
+  //! @param files page of files following the previous listing page
+  //! @param containers page of subcontainers following the previous listing
+  //!        page
+  //! @param max_entries max number of entries in the page
+  //!
+  //! @return listing page
+  //----------------------------------------------------------------------------
+  static Page mergePages(MetadataFetcher::MapPage&& files,
+                         MetadataFetcher::MapPage&& containers,
+                         size_t max_entries);
+
+  //----------------------------------------------------------------------------
+  //! Build the cursor of the page following the given name
+  //!
+  //! @param name entry name, not necessarily existing
+  //!
+  //! @return cursor
+  //----------------------------------------------------------------------------
+  static std::string encodeCursor(const std::string& name);
+
+  //----------------------------------------------------------------------------
+  //! Extract the name after which the page starts from the given cursor
+  //!
+  //! @param cursor cursor as returned by encodeCursor
+  //! @param name extracted name
+  //!
+  //! @return true if cursor is valid, otherwise false
+  //----------------------------------------------------------------------------
+  static bool decodeCursor(const std::string& cursor, std::string& name);
+};
+
+EOSNSNAMESPACE_END
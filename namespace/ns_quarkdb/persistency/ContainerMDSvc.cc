@@ -25,10 +25,12 @@
 #include "namespace/ns_quarkdb/persistency/MetadataProvider.hh"
 #include "namespace/utils/StringConvertion.hh"
 #include "namespace/ns_quarkdb/persistency/RequestBuilder.hh"
+#include "namespace/ns_quarkdb/accounting/ContainerAccounting.hh"
 #include "namespace/ns_quarkdb/ConfigurationParser.hh"
 #include "common/Assert.hh"
 #include "common/Logging.hh"
 #include "common/StacktraceHere.hh"
+#include <algorithm>
 #include <memory>
 #include <numeric>
 
@@ -39,7 +41,8 @@ EOSNSNAMESPACE_BEGIN
 //------------------------------------------------------------------------------
 QuarkContainerMDSvc::QuarkContainerMDSvc(qclient::QClient* qcl,
     MetadataFlusher* flusher)
-  : pQuotaStats(nullptr), pFileSvc(nullptr), pQcl(qcl), pFlusher(flusher),
+  : pQuotaStats(nullptr), pFileSvc(nullptr), mContainerAccounting(nullptr),
+    pQcl(qcl), pFlusher(flusher),
     mMetaMap(), mMetadataProvider(nullptr), mNumConts(0ull) {}
 
 //------------------------------------------------------------------------------
@@ -68,6 +71,20 @@ QuarkContainerMDSvc::configure(const std::map<std::string, std::string>& config)
     if (mMetadataProvider) {
       mMetadataProvider->setContainerMDCacheNum(std::stoull(mCacheNum));
     }
+
+    // Paths are cached only as long as their containers are, which is not
+    // the case on a slave where nothing invalidates them
+    uint64_t max_paths = std::stoull(mCacheNum);
+    mPathCache.setMaxEntries(std::min(max_paths,
+                                      PathLookupCache::kDefaultMaxEntries));
+  }
+
+  if (config.find(constants::sMaxSizeCacheDirs) != config.end()) {
+    mCacheSize = config.at(constants::sMaxSizeCacheDirs);
+
+    if (mMetadataProvider) {
+      mMetadataProvider->setContainerMDCacheSize(std::stoull(mCacheSize));
+    }
   }
 }
 
@@ -109,6 +126,10 @@ QuarkContainerMDSvc::initialize()
     mMetadataProvider->setContainerMDCacheNum(std::stoull(mCacheNum));
   }
 
+  if (!mCacheSize.empty()) {
+    mMetadataProvider->setContainerMDCacheSize(std::stoull(mCacheSize));
+  }
+
   SafetyCheck();
   mNumConts.store(pQcl->execute(RequestBuilder::getNumberOfContainers())
                   .get()->integer);
@@ -191,9 +212,19 @@ QuarkContainerMDSvc::getContainerMD(IContainerMD::id_t id, uint64_t* clock)
 bool
 QuarkContainerMDSvc::dropCachedContainerMD(ContainerIdentifier id)
 {
+  mPathCache.invalidateContainer(id.getUnderlyingUInt64());
   return mMetadataProvider->dropCachedContainerID(id);
 }
 
+//------------------------------------------------------------------------------
+// Check if a ContainerMD is in the cache or being fetched
+//------------------------------------------------------------------------------
+bool
+QuarkContainerMDSvc::isContainerMDCached(ContainerIdentifier id)
+{
+  return mMetadataProvider->isContainerMDCached(id);
+}
+
 //------------------------------------------------------------------------------
 // Create a new container metadata object
 //------------------------------------------------------------------------------
@@ -255,13 +286,30 @@ QuarkContainerMDSvc::removeContainer(IContainerMD* obj)
     pFlusher->del(constants::sMapMetaInfoKey);
   }
 
+  // Size changes queued for this container still have to reach its parent
+  if (mContainerAccounting) {
+    mContainerAccounting->ContainerRemoved(obj->getId(), obj->getParentId());
+  }
+
   obj->setDeleted();
+  mPathCache.invalidateContainer(obj->getId());
 
   if (mNumConts) {
     --mNumConts;
   }
 }
 
+//------------------------------------------------------------------------------
+// Set container accounting
+//------------------------------------------------------------------------------
+void
+QuarkContainerMDSvc::setContainerAccounting(IFileMDChangeListener*
+    containerAccounting)
+{
+  mContainerAccounting =
+    dynamic_cast<QuarkContainerAccounting*>(containerAccounting);
+}
+
 //------------------------------------------------------------------------------
 // Add change listener
 //------------------------------------------------------------------------------
@@ -27,6 +27,7 @@
 #include "namespace/interface/IContainerMD.hh"
 #include "namespace/interface/IContainerMDSvc.hh"
 #include "namespace/ns_quarkdb/Constants.hh"
+#include "namespace/ns_quarkdb/PathLookupCache.hh"
 #include "namespace/ns_quarkdb/persistency/NextInodeProvider.hh"
 #include "namespace/ns_quarkdb/persistency/UnifiedInodeProvider.hh"
 #include "namespace/ns_quarkdb/accounting/QuotaStats.hh"
@@ -43,6 +44,7 @@ EOSNSNAMESPACE_BEGIN
 
 class QuarkContainerMD;
 class MetadataProvider;
+class QuarkContainerAccounting;
 
 //------------------------------------------------------------------------------
 //! Container metadata service based on Redis
@@ -105,6 +107,12 @@ public:
   virtual bool
   dropCachedContainerMD(ContainerIdentifier id) override;
 
+  //----------------------------------------------------------------------------
+  //! Check if a ContainerMD is in the cache or being fetched, without
+  //! fetching it
+  //----------------------------------------------------------------------------
+  bool isContainerMDCached(ContainerIdentifier id);
+
   //----------------------------------------------------------------------------
   //! Create new container metadata object with an assigned id, the user has
   //! to fill all the remaining fields
@@ -196,6 +204,22 @@ public:
   //----------------------------------------------------------------------------
   virtual CacheStatistics getCacheStatistics() override;
 
+  //----------------------------------------------------------------------------
+  //! Retrieve path lookup cache statistics
+  //----------------------------------------------------------------------------
+  virtual PathCacheStatistics getPathCacheStatistics() override
+  {
+    return mPathCache.getStatistics();
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get the cache of path to container id translations
+  //----------------------------------------------------------------------------
+  PathLookupCache& getPathLookupCache()
+  {
+    return mPathCache;
+  }
+
   //----------------------------------------------------------------------------
   //! Blacklist IDs below the given threshold
   //----------------------------------------------------------------------------
@@ -205,14 +229,12 @@ private:
   typedef std::list<IContainerMDChangeListener*> ListenerList;
 
   //----------------------------------------------------------------------------
-  //! Set container accounting - no-op for this type of object since any type
-  //! of size accounting in done when manipulating files or using the
-  //! AddTree/RemoveTree interface of the continaer accounting view.
+  //! Set container accounting - size accounting is done when manipulating
+  //! files or using the AddTree/RemoveTree interface of the container
+  //! accounting view, here it only needs to know about removed containers.
   //----------------------------------------------------------------------------
-  void setContainerAccounting(IFileMDChangeListener* containerAccounting) override
-  {
-    return;
-  }
+  void setContainerAccounting(IFileMDChangeListener* containerAccounting)
+  override;
 
   //----------------------------------------------------------------------------
   //! Notify the listeners about the change
@@ -230,6 +252,7 @@ private:
   ListenerList pListeners;              ///< List of listeners to be notified
   IQuotaStats* pQuotaStats;             ///< Quota view
   IFileMDSvc* pFileSvc;                 ///< File metadata service
+  QuarkContainerAccounting* mContainerAccounting; ///< Container accounting
   qclient::QClient* pQcl;               ///< QClient object
   MetadataFlusher* pFlusher;            ///< Metadata flusher object
   //! Map holding metainfo about the namespace
@@ -239,6 +262,8 @@ private:
   std::atomic<uint64_t> mNumConts;      ///< Total number of containers
   std::string
   mCacheNum;                ///< Temporary workaround to store cache size
+  std::string mCacheSize;   ///< Same for the cache size limit in bytes
+  PathLookupCache mPathCache; ///< Path to container id translations
 };
 
 EOSNSNAMESPACE_END
@@ -81,6 +81,11 @@ QuarkFileMDSvc::configure(const std::map<std::string, std::string>& config)
     std::string val = config.at(constants::sMaxNumCacheFiles);
     mMetadataProvider->setFileMDCacheNum(std::stoull(val));
   }
+
+  if (config.find(constants::sMaxSizeCacheFiles) != config.end()) {
+    std::string val = config.at(constants::sMaxSizeCacheFiles);
+    mMetadataProvider->setFileMDCacheSize(std::stoull(val));
+  }
 }
 
 //------------------------------------------------------------------------------
@@ -271,6 +271,155 @@ private:
   folly::Promise<ContainerType> mPromise;
 };
 
+//------------------------------------------------------------------------------
+//! Class MapPageFetcher - fetches a sorted part of the maps (ContainerMap,
+//! FileMap) of a particular container.
+//!
+//! QuarkDB scans hashes in lexicographic order of the fields and its cursors
+//! have the form "next:<field>", so a scan can start right at a given name
+//! without going through the entries before it.
+//------------------------------------------------------------------------------
+template<typename Trait>
+class MapPageFetcher : public qclient::QCallback
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Initialize
+  //!
+  //! @param qcl qclient object
+  //! @param trg target container id
+  //! @param after name after which the page starts, empty for the beginning
+  //! @param count max number of entries
+  //----------------------------------------------------------------------------
+  folly::Future<MetadataFetcher::MapPage>
+  initialize(qclient::QClient& qcl, ContainerIdentifier trg,
+             const std::string& after, size_t count)
+  {
+    mQcl = &qcl;
+    mTarget = trg;
+    mAfter = after;
+    mCount = count;
+    folly::Future<MetadataFetcher::MapPage> fut = mPromise.getFuture();
+
+    if (mCount == 0) {
+      mPromise.setValue(std::move(mPage));
+      delete this;
+      return fut;
+    }
+
+    // Not safe to access member variables after execCB, see MapFetcher
+    mQcl->execCB(this, "HSCAN", Trait::getKey(mTarget.getUnderlyingUInt64()),
+                 mAfter.empty() ? std::string("0") : "next:" + mAfter,
+                 "COUNT", SSTR(mCount + 1));
+    return fut;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Handle response
+  //!
+  //! @param reply holds a redis reply object
+  //----------------------------------------------------------------------------
+  virtual void handleResponse(redisReplyPtr&& reply) override
+  {
+    if (!reply) {
+      return set_exception(EFAULT, "QuarkDB backend not available!");
+    }
+
+    if (reply->type != REDIS_REPLY_ARRAY || reply->elements != 2 ||
+        (reply->element[0]->type != REDIS_REPLY_STRING) ||
+        (reply->element[1]->type != REDIS_REPLY_ARRAY) ||
+        ((reply->element[1]->elements % 2) != 0)) {
+      return set_exception(EFAULT, SSTR("Received unexpected response: "
+                                        << qclient::describeRedisReply(reply)));
+    }
+
+    std::string cursor = std::string(reply->element[0]->str,
+                                     reply->element[0]->len);
+
+    for (size_t i = 0; i < reply->element[1]->elements; i += 2) {
+      redisReply* element = reply->element[1]->element[i];
+      redisReply* value_element = reply->element[1]->element[i + 1];
+
+      if ((element->type != REDIS_REPLY_STRING) ||
+          (value_element->type != REDIS_REPLY_STRING)) {
+        return set_exception(EFAULT, SSTR("Received unexpected response: "
+                                          << qclient::describeRedisReply(reply)));
+      }
+
+      std::string name = std::string(element->str, element->len);
+
+      // The first scan starts at the given name itself
+      if (name <= mAfter) {
+        continue;
+      }
+
+      if (mPage.entries.size() == mCount) {
+        mPage.more = true;
+        break;
+      }
+
+      int64_t value;
+      MDStatus st = Serialization::deserialize(value_element->str,
+                    value_element->len, value);
+
+      if (!st.ok()) {
+        return set_exception(st);
+      }
+
+      mPage.entries.emplace_back(std::move(name), value);
+    }
+
+    if ((cursor == "0") || mPage.more) {
+      mPromise.setValue(std::move(mPage));
+      delete this;
+      return;
+    }
+
+    if (mPage.entries.size() == mCount) {
+      // Page is full, the scan has not reached the end of the map yet
+      mPage.more = true;
+      mPromise.setValue(std::move(mPage));
+      delete this;
+      return;
+    }
+
+    mQcl->execCB(this, "HSCAN", Trait::getKey(mTarget.getUnderlyingUInt64()),
+                 cursor, "COUNT", SSTR(mCount - mPage.entries.size() + 1));
+  }
+
+private:
+  //----------------------------------------------------------------------------
+  //! Return exception by passing it to the promise
+  //!
+  //! @param status error return status
+  //----------------------------------------------------------------------------
+  void set_exception(const MDStatus& status)
+  {
+    return set_exception(status.getErrno(), status.getError());
+  }
+
+  //----------------------------------------------------------------------------
+  //! Return exception by passing it to the promise
+  //!
+  //! @param status error return status
+  //----------------------------------------------------------------------------
+  void set_exception(int err, const std::string& msg)
+  {
+    mPromise.setException(
+      make_mdexception(err, SSTR("Error while fetching file/container map page "
+                                 "for container #" << mTarget.getUnderlyingUInt64()
+                                 << " from QDB: " << msg)));
+    delete this; // harakiri
+  }
+
+  qclient::QClient* mQcl;
+  ContainerIdentifier mTarget;
+  std::string mAfter;
+  size_t mCount;
+  MetadataFetcher::MapPage mPage;
+  folly::Promise<MetadataFetcher::MapPage> mPromise;
+};
+
 //------------------------------------------------------------------------------
 // Parse FileMDProto from a redis response, throw on error.
 //------------------------------------------------------------------------------
@@ -524,6 +673,32 @@ MetadataFetcher::getContainerMap(qclient::QClient& qcl,
   return fetcher->initialize(qcl, container);
 }
 
+//------------------------------------------------------------------------------
+// Fetch part of the file map of a container
+//------------------------------------------------------------------------------
+folly::Future<MetadataFetcher::MapPage>
+MetadataFetcher::getFileMapPage(qclient::QClient& qcl,
+                                ContainerIdentifier container,
+                                const std::string& after, size_t count)
+{
+  MapPageFetcher<MapFetcherFileTrait>* fetcher =
+    new MapPageFetcher<MapFetcherFileTrait>();
+  return fetcher->initialize(qcl, container, after, count);
+}
+
+//------------------------------------------------------------------------------
+// Fetch part of the subcontainer map of a container
+//------------------------------------------------------------------------------
+folly::Future<MetadataFetcher::MapPage>
+MetadataFetcher::getContainerMapPage(qclient::QClient& qcl,
+                                     ContainerIdentifier container,
+                                     const std::string& after, size_t count)
+{
+  MapPageFetcher<MapFetcherContainerTrait>* fetcher =
+    new MapPageFetcher<MapFetcherContainerTrait>();
+  return fetcher->initialize(qcl, container, after, count);
+}
+
 //------------------------------------------------------------------------------
 // Parse response when looking up a ContainerID / FileID from (parent id, name)
 //------------------------------------------------------------------------------
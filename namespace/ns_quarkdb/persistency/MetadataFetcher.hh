@@ -104,6 +104,30 @@ public:
   static folly::Future<IContainerMD::FileMap>
   getFileMap(qclient::QClient& qcl, ContainerIdentifier container);
 
+  //----------------------------------------------------------------------------
+  //! Sorted part of the file or subcontainer map of a container
+  //----------------------------------------------------------------------------
+  struct MapPage {
+    //! Names and ids sorted by name
+    std::vector<std::pair<std::string, uint64_t>> entries;
+    bool more = false; ///< There are entries following the ones in the page
+  };
+
+  //----------------------------------------------------------------------------
+  //! Fetch part of the file map of a container, without loading the rest
+  //!
+  //! @param qcl qclient object
+  //! @param container container id
+  //! @param after only entries with names sorting after this one are returned,
+  //!        empty to start from the beginning
+  //! @param count max number of entries to return
+  //!
+  //! @return future holding the page of files
+  //----------------------------------------------------------------------------
+  static folly::Future<MapPage>
+  getFileMapPage(qclient::QClient& qcl, ContainerIdentifier container,
+                 const std::string& after, size_t count);
+
   //----------------------------------------------------------------------------
   //! Fetch all FileMDs contained within the given FileMap. Vector is sorted
   //! by filename.
@@ -142,6 +166,22 @@ public:
   static folly::Future<IContainerMD::ContainerMap>
   getContainerMap(qclient::QClient& qcl, ContainerIdentifier container);
 
+  //----------------------------------------------------------------------------
+  //! Fetch part of the subcontainer map of a container, without loading the
+  //! rest
+  //!
+  //! @param qcl qclient object
+  //! @param container container id
+  //! @param after only entries with names sorting after this one are returned,
+  //!        empty to start from the beginning
+  //! @param count max number of entries to return
+  //!
+  //! @return future holding the page of subcontainers
+  //----------------------------------------------------------------------------
+  static folly::Future<MapPage>
+  getContainerMapPage(qclient::QClient& qcl, ContainerIdentifier container,
+                      const std::string& after, size_t count);
+
   //----------------------------------------------------------------------------
   //! Fetch all ContainerMDs contained within the given ContainerMap.
   //! Vector is sorted by filename.
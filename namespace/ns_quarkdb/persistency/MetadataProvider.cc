@@ -47,18 +47,18 @@ MetadataProvider::MetadataProvider(const QdbContactDetails& contactDetails,
 // Retrieve ContainerMD by ID.
 //------------------------------------------------------------------------------
 folly::Future<IContainerMDPtr>
-MetadataProvider::retrieveContainerMD(ContainerIdentifier id)
+MetadataProvider::retrieveContainerMD(ContainerIdentifier id, bool countStats)
 {
-  return pickShard(id)->retrieveContainerMD(id);
+  return pickShard(id)->retrieveContainerMD(id, countStats);
 }
 
 //------------------------------------------------------------------------------
 // Retrieve FileMD by ID.
 //------------------------------------------------------------------------------
 folly::Future<IFileMDPtr>
-MetadataProvider::retrieveFileMD(FileIdentifier id)
+MetadataProvider::retrieveFileMD(FileIdentifier id, bool countStats)
 {
-  return pickShard(id)->retrieveFileMD(id);
+  return pickShard(id)->retrieveFileMD(id, countStats);
 }
 
 //------------------------------------------------------------------------------
@@ -79,6 +79,15 @@ MetadataProvider::dropCachedContainerID(ContainerIdentifier id)
   return pickShard(id)->dropCachedContainerID(id);
 }
 
+//------------------------------------------------------------------------------
+// Check if a ContainerMD is in the cache or being fetched
+//------------------------------------------------------------------------------
+bool
+MetadataProvider::isContainerMDCached(ContainerIdentifier id)
+{
+  return pickShard(id)->isContainerMDCached(id);
+}
+
 //----------------------------------------------------------------------------
 // Check if a FileMD exists with the given id
 //----------------------------------------------------------------------------
@@ -139,6 +148,38 @@ void MetadataProvider::setContainerMDCacheNum(uint64_t max_num)
   }
 }
 
+//------------------------------------------------------------------------------
+// Change file cache size limit in bytes
+//------------------------------------------------------------------------------
+void MetadataProvider::setFileMDCacheSize(uint64_t max_size)
+{
+  uint64_t max_size_per_shard = max_size / kShards;
+
+  if(max_size == UINT64_MAX) {
+    max_size_per_shard = UINT64_MAX;
+  }
+
+  for(size_t i = 0; i < mShards.size(); i++) {
+    mShards[i]->setFileMDCacheSize(max_size_per_shard);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Change container cache size limit in bytes
+//------------------------------------------------------------------------------
+void MetadataProvider::setContainerMDCacheSize(uint64_t max_size)
+{
+  uint64_t max_size_per_shard = max_size / kShards;
+
+  if(max_size == UINT64_MAX) {
+    max_size_per_shard = UINT64_MAX;
+  }
+
+  for(size_t i = 0; i < mShards.size(); i++) {
+    mShards[i]->setContainerMDCacheSize(max_size_per_shard);
+  }
+}
+
 //------------------------------------------------------------------------------
 // Add a CacheStatistics object into another
 //------------------------------------------------------------------------------
@@ -146,6 +187,33 @@ void aggregateStatistics(CacheStatistics &global, const CacheStatistics local) {
   global.occupancy += local.occupancy;
   global.maxNum += local.maxNum;
   global.inFlight += local.inFlight;
+  global.maxSize += local.maxSize;
+  global.sizeBytes += local.sizeBytes;
+  global.hits += local.hits;
+  global.misses += local.misses;
+  global.evictions += local.evictions;
+}
+
+//------------------------------------------------------------------------------
+// Fill in the lookup rate since the previous query
+//------------------------------------------------------------------------------
+void MetadataProvider::updateLookupRate(CacheStatistics& stats,
+                                        LookupCounter& counter)
+{
+  std::lock_guard<std::mutex> lock(counter.mMutex);
+  auto now = std::chrono::steady_clock::now();
+  uint64_t lookups = stats.hits + stats.misses;
+
+  if (counter.mTimestamp != std::chrono::steady_clock::time_point()) {
+    double elapsed = std::chrono::duration<double>(now - counter.mTimestamp).count();
+
+    if (elapsed > 0 && lookups >= counter.mLookups) {
+      stats.lookupRate = (lookups - counter.mLookups) / elapsed;
+    }
+  }
+
+  counter.mLookups = lookups;
+  counter.mTimestamp = now;
 }
 
 //------------------------------------------------------------------------------
@@ -160,6 +228,8 @@ CacheStatistics MetadataProvider::getFileMDCacheStats()
     aggregateStatistics(globalStats, mShards[i]->getFileMDCacheStats());
   }
 
+  updateLookupRate(globalStats, mFileLookups);
+
   return globalStats;
 }
 
@@ -175,9 +245,44 @@ CacheStatistics MetadataProvider::getContainerMDCacheStats()
     aggregateStatistics(globalStats, mShards[i]->getContainerMDCacheStats());
   }
 
+  updateLookupRate(globalStats, mContainerLookups);
+
   return globalStats;
 }
 
+//------------------------------------------------------------------------------
+// Get the ids of the hottest cached files with their score
+//------------------------------------------------------------------------------
+std::vector<std::pair<FileIdentifier, uint8_t>>
+MetadataProvider::getHotFileIds(uint64_t max_num)
+{
+  std::vector<std::pair<FileIdentifier, uint8_t>> hot;
+
+  // Ids are spread evenly over the shards, so are the hot ones
+  for(size_t i = 0; i < mShards.size(); i++) {
+    auto shard_hot = mShards[i]->getHotFileIds(max_num / kShards);
+    hot.insert(hot.end(), shard_hot.begin(), shard_hot.end());
+  }
+
+  return hot;
+}
+
+//------------------------------------------------------------------------------
+// Get the ids of the hottest cached containers with their score
+//------------------------------------------------------------------------------
+std::vector<std::pair<ContainerIdentifier, uint8_t>>
+MetadataProvider::getHotContainerIds(uint64_t max_num)
+{
+  std::vector<std::pair<ContainerIdentifier, uint8_t>> hot;
+
+  for(size_t i = 0; i < mShards.size(); i++) {
+    auto shard_hot = mShards[i]->getHotContainerIds(max_num / kShards);
+    hot.insert(hot.end(), shard_hot.begin(), shard_hot.end());
+  }
+
+  return hot;
+}
+
 //------------------------------------------------------------------------------
 //! Pick shard based on FileIdentifier
 //------------------------------------------------------------------------------
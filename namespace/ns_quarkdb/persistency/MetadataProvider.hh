@@ -29,6 +29,10 @@
 #include "namespace/Namespace.hh"
 #include <folly/futures/Future.h>
 #include <folly/futures/FutureSplitter.h>
+#include <chrono>
+#include <mutex>
+#include <utility>
+#include <vector>
 
 namespace folly
 {
@@ -55,13 +59,21 @@ public:
 
   //----------------------------------------------------------------------------
   //! Retrieve ContainerMD by ID
+  //!
+  //! @param countStats if false, the lookup is not accounted in the cache
+  //!        statistics e.g. when prefetching
   //----------------------------------------------------------------------------
-  folly::Future<IContainerMDPtr> retrieveContainerMD(ContainerIdentifier id);
+  folly::Future<IContainerMDPtr> retrieveContainerMD(ContainerIdentifier id,
+      bool countStats = true);
 
   //----------------------------------------------------------------------------
   //! Retrieve FileMD by ID
+  //!
+  //! @param countStats if false, the lookup is not accounted in the cache
+  //!        statistics e.g. when prefetching
   //----------------------------------------------------------------------------
-  folly::Future<IFileMDPtr> retrieveFileMD(FileIdentifier id);
+  folly::Future<IFileMDPtr> retrieveFileMD(FileIdentifier id,
+      bool countStats = true);
 
   //----------------------------------------------------------------------------
   //! Drop cached FileID - return true if found
@@ -73,6 +85,12 @@ public:
   //----------------------------------------------------------------------------
   bool dropCachedContainerID(ContainerIdentifier id);
 
+  //----------------------------------------------------------------------------
+  //! Check if a ContainerMD is in the cache or being fetched, without
+  //! fetching it
+  //----------------------------------------------------------------------------
+  bool isContainerMDCached(ContainerIdentifier id);
+
   //----------------------------------------------------------------------------
   //! Check if a FileMD exists with the given id
   //----------------------------------------------------------------------------
@@ -98,6 +116,16 @@ public:
   //----------------------------------------------------------------------------
   void setContainerMDCacheNum(uint64_t max_num);
 
+  //----------------------------------------------------------------------------
+  //! Change file cache size limit in bytes
+  //----------------------------------------------------------------------------
+  void setFileMDCacheSize(uint64_t max_size);
+
+  //----------------------------------------------------------------------------
+  //! Change container cache size limit in bytes
+  //----------------------------------------------------------------------------
+  void setContainerMDCacheSize(uint64_t max_size);
+
   //----------------------------------------------------------------------------
   //! Get file cache statistics
   //----------------------------------------------------------------------------
@@ -108,7 +136,37 @@ public:
   //----------------------------------------------------------------------------
   CacheStatistics getContainerMDCacheStats();
 
+  //----------------------------------------------------------------------------
+  //! Get the ids of the hottest cached files with their score, see LRU
+  //!
+  //! @param max_num maximum number of ids to return
+  //----------------------------------------------------------------------------
+  std::vector<std::pair<FileIdentifier, uint8_t>>
+  getHotFileIds(uint64_t max_num);
+
+  //----------------------------------------------------------------------------
+  //! Get the ids of the hottest cached containers with their score, see LRU
+  //!
+  //! @param max_num maximum number of ids to return
+  //----------------------------------------------------------------------------
+  std::vector<std::pair<ContainerIdentifier, uint8_t>>
+  getHotContainerIds(uint64_t max_num);
+
 private:
+  //----------------------------------------------------------------------------
+  //! Number of lookups seen at the previous statistics query
+  //----------------------------------------------------------------------------
+  struct LookupCounter {
+    std::mutex mMutex;
+    uint64_t mLookups = 0;
+    std::chrono::steady_clock::time_point mTimestamp;
+  };
+
+  //----------------------------------------------------------------------------
+  //! Fill in the lookup rate since the previous query
+  //----------------------------------------------------------------------------
+  static void updateLookupRate(CacheStatistics& stats, LookupCounter& counter);
+
   //----------------------------------------------------------------------------
   //! Pick shard based on FileIdentifier
   //----------------------------------------------------------------------------
@@ -135,6 +193,8 @@ private:
   std::vector<std::unique_ptr<qclient::QClient>> mQcl;
 
   std::vector<std::unique_ptr<MetadataProviderShard>> mShards;
+  LookupCounter mFileLookups;
+  LookupCounter mContainerLookups;
 };
 
 EOSNSNAMESPACE_END
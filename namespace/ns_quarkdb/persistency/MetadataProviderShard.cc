@@ -35,12 +35,45 @@ using std::placeholders::_1;
 
 EOSNSNAMESPACE_BEGIN
 
+namespace
+{
+//! Number of independently locked stripes of each cache
+constexpr uint32_t kCacheStripes = 8;
+//! Average out-of-line memory of a file: strings, locations, extended
+//! attributes and the shared pointer control block
+constexpr uint64_t kFileHeapCost = 256;
+//! Approximate memory of one entry in the file or subcontainer map
+constexpr uint64_t kMapEntryCost = 64;
+
+//------------------------------------------------------------------------------
+// Estimate the memory used by a cached file
+//------------------------------------------------------------------------------
+uint64_t EstimateFileCost(const IFileMD&)
+{
+  return sizeof(QuarkFileMD) + kFileHeapCost;
+}
+
+//------------------------------------------------------------------------------
+// Estimate the memory used by a cached container, dominated by the maps of
+// its children. Containers are only inserted right after being constructed,
+// so taking their lock here can not deadlock.
+//------------------------------------------------------------------------------
+uint64_t EstimateContainerCost(const IContainerMD& cont)
+{
+  IContainerMD& mcont = const_cast<IContainerMD&>(cont);
+  return sizeof(QuarkContainerMD) +
+         (mcont.getNumFiles() + mcont.getNumContainers()) * kMapEntryCost;
+}
+}
+
 //------------------------------------------------------------------------------
 // Constructor
 //------------------------------------------------------------------------------
 MetadataProviderShard::MetadataProviderShard(qclient::QClient *qcl,
   IContainerMDSvc* contsvc, IFileMDSvc* filesvc, folly::Executor *exec)
-  : mContSvc(contsvc), mFileSvc(filesvc), mContainerCache(312500), mFileCache(2500000)
+  : mContSvc(contsvc), mFileSvc(filesvc),
+    mContainerCache(312500, kCacheStripes, &EstimateContainerCost),
+    mFileCache(2500000, kCacheStripes, &EstimateFileCost)
 {
   mExecutor = exec;
   mQcl = qcl;
@@ -50,13 +83,15 @@ MetadataProviderShard::MetadataProviderShard(qclient::QClient *qcl,
 // Retrieve ContainerMD by ID.
 //------------------------------------------------------------------------------
 folly::Future<IContainerMDPtr>
-MetadataProviderShard::retrieveContainerMD(ContainerIdentifier id)
+MetadataProviderShard::retrieveContainerMD(ContainerIdentifier id,
+    bool countStats)
 {
   // Quick check without lock on the long-lived cache. LRU is locked internally,
   // so this is thread-safe.
   //
-  // If we get no hit, we have to check again under lock.
-  IContainerMDPtr result = mContainerCache.get(id);
+  // If we get no hit, we have to check again under lock. The second lookup is
+  // not accounted in the cache statistics.
+  IContainerMDPtr result = mContainerCache.get(id, countStats);
 
   if (result) {
     // Handle special case where we're dealing with a tombstone.
@@ -82,7 +117,7 @@ MetadataProviderShard::retrieveContainerMD(ContainerIdentifier id)
   }
 
   // Nope.. is it inside the long-lived cache?
-  result = mContainerCache.get(id);
+  result = mContainerCache.get(id, false);
 
   if (result) {
     lock.unlock();
@@ -124,15 +159,16 @@ MetadataProviderShard::retrieveContainerMD(ContainerIdentifier id)
 // Retrieve FileMD by ID.
 //------------------------------------------------------------------------------
 folly::Future<IFileMDPtr>
-MetadataProviderShard::retrieveFileMD(FileIdentifier id)
+MetadataProviderShard::retrieveFileMD(FileIdentifier id, bool countStats)
 {
   // Quick check without lock on the long-lived cache. LRU is locked internally,
   // so this is thread-safe.
   //
-  // If we get no hit, we have to check again under lock.
+  // If we get no hit, we have to check again under lock. The second lookup is
+  // not accounted in the cache statistics.
 
   // Nope.. is it inside the long-lived cache?
-  IFileMDPtr result = mFileCache.get(id);
+  IFileMDPtr result = mFileCache.get(id, countStats);
 
   if (result) {
     // Handle special case where we're dealing with a tombstone.
@@ -168,7 +204,7 @@ MetadataProviderShard::retrieveFileMD(FileIdentifier id)
   }
 
   // Nope.. is it inside the long-lived cache?
-  result = mFileCache.get(id);
+  result = mFileCache.get(id, false);
 
   if (result) {
     lock.unlock();
@@ -217,6 +253,17 @@ MetadataProviderShard::dropCachedContainerID(ContainerIdentifier id)
   return mContainerCache.remove(id);
 }
 
+//------------------------------------------------------------------------------
+// Check if a ContainerMD is in the cache or being fetched
+//------------------------------------------------------------------------------
+bool
+MetadataProviderShard::isContainerMDCached(ContainerIdentifier id)
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  return (mInFlightContainers.find(id) != mInFlightContainers.end()) ||
+         (mContainerCache.get(id, false) != nullptr);
+}
+
 //----------------------------------------------------------------------------
 // Check if a FileMD exists with the given id
 //----------------------------------------------------------------------------
@@ -265,6 +312,24 @@ void MetadataProviderShard::setContainerMDCacheNum(uint64_t max_num)
   mContainerCache.set_max_num(max_num);
 }
 
+//------------------------------------------------------------------------------
+// Change file cache size limit in bytes
+//------------------------------------------------------------------------------
+void MetadataProviderShard::setFileMDCacheSize(uint64_t max_size)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  mFileCache.set_max_size(max_size);
+}
+
+//------------------------------------------------------------------------------
+// Change container cache size limit in bytes
+//------------------------------------------------------------------------------
+void MetadataProviderShard::setContainerMDCacheSize(uint64_t max_size)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  mContainerCache.set_max_size(max_size);
+}
+
 //------------------------------------------------------------------------------
 // Turn a (ContainerMDProto, FileMap, ContainerMap) triplet into a
 // ContainerMDPtr, and insert into the cache.
@@ -331,6 +396,12 @@ CacheStatistics MetadataProviderShard::getFileMDCacheStats()
   stats.enabled = true;
   stats.occupancy = mFileCache.size();
   stats.maxNum = mFileCache.get_max_num();
+  stats.maxSize = mFileCache.get_max_size();
+  auto lru_stats = mFileCache.get_stats();
+  stats.sizeBytes = lru_stats.mBytes;
+  stats.hits = lru_stats.mHits;
+  stats.misses = lru_stats.mMisses;
+  stats.evictions = lru_stats.mEvictions;
 
   std::lock_guard<std::mutex> lock(mMutex);
   stats.inFlight = mInFlightFiles.size();
@@ -346,10 +417,34 @@ CacheStatistics MetadataProviderShard::getContainerMDCacheStats()
   stats.enabled = true;
   stats.occupancy = mContainerCache.size();
   stats.maxNum = mContainerCache.get_max_num();
+  stats.maxSize = mContainerCache.get_max_size();
+  auto lru_stats = mContainerCache.get_stats();
+  stats.sizeBytes = lru_stats.mBytes;
+  stats.hits = lru_stats.mHits;
+  stats.misses = lru_stats.mMisses;
+  stats.evictions = lru_stats.mEvictions;
 
   std::lock_guard<std::mutex> lock(mMutex);
   stats.inFlight = mInFlightContainers.size();
   return stats;
 }
 
+//------------------------------------------------------------------------------
+// Get the ids of the hot cached files with their score
+//------------------------------------------------------------------------------
+std::vector<std::pair<FileIdentifier, uint8_t>>
+MetadataProviderShard::getHotFileIds(uint64_t max_num)
+{
+  return mFileCache.get_hot_ids(max_num);
+}
+
+//------------------------------------------------------------------------------
+// Get the ids of the hot cached containers with their score
+//------------------------------------------------------------------------------
+std::vector<std::pair<ContainerIdentifier, uint8_t>>
+MetadataProviderShard::getHotContainerIds(uint64_t max_num)
+{
+  return mContainerCache.get_hot_ids(max_num);
+}
+
 EOSNSNAMESPACE_END
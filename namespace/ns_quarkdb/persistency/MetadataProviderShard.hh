@@ -59,13 +59,21 @@ public:
 
   //----------------------------------------------------------------------------
   //! Retrieve ContainerMD by ID
+  //!
+  //! @param countStats if false, the lookup is not accounted in the cache
+  //!        statistics e.g. when prefetching
   //----------------------------------------------------------------------------
-  folly::Future<IContainerMDPtr> retrieveContainerMD(ContainerIdentifier id);
+  folly::Future<IContainerMDPtr> retrieveContainerMD(ContainerIdentifier id,
+      bool countStats = true);
 
   //----------------------------------------------------------------------------
   //! Retrieve FileMD by ID
+  //!
+  //! @param countStats if false, the lookup is not accounted in the cache
+  //!        statistics e.g. when prefetching
   //----------------------------------------------------------------------------
-  folly::Future<IFileMDPtr> retrieveFileMD(FileIdentifier id);
+  folly::Future<IFileMDPtr> retrieveFileMD(FileIdentifier id,
+      bool countStats = true);
 
   //----------------------------------------------------------------------------
   //! Drop cached FileID - return true if found
@@ -77,6 +85,12 @@ public:
   //----------------------------------------------------------------------------
   bool dropCachedContainerID(ContainerIdentifier id);
 
+  //----------------------------------------------------------------------------
+  //! Check if a ContainerMD is in the cache or being fetched, without
+  //! fetching it
+  //----------------------------------------------------------------------------
+  bool isContainerMDCached(ContainerIdentifier id);
+
   //----------------------------------------------------------------------------
   //! Check if a FileMD exists with the given id
   //----------------------------------------------------------------------------
@@ -102,6 +116,16 @@ public:
   //----------------------------------------------------------------------------
   void setContainerMDCacheNum(uint64_t max_num);
 
+  //----------------------------------------------------------------------------
+  //! Change file cache size limit in bytes
+  //----------------------------------------------------------------------------
+  void setFileMDCacheSize(uint64_t max_size);
+
+  //----------------------------------------------------------------------------
+  //! Change container cache size limit in bytes
+  //----------------------------------------------------------------------------
+  void setContainerMDCacheSize(uint64_t max_size);
+
   //----------------------------------------------------------------------------
   //! Get file cache statistics
   //----------------------------------------------------------------------------
@@ -112,6 +136,18 @@ public:
   //----------------------------------------------------------------------------
   CacheStatistics getContainerMDCacheStats();
 
+  //----------------------------------------------------------------------------
+  //! Get the ids of the hot cached files with their score, see LRU
+  //----------------------------------------------------------------------------
+  std::vector<std::pair<FileIdentifier, uint8_t>>
+  getHotFileIds(uint64_t max_num);
+
+  //----------------------------------------------------------------------------
+  //! Get the ids of the hot cached containers with their score, see LRU
+  //----------------------------------------------------------------------------
+  std::vector<std::pair<ContainerIdentifier, uint8_t>>
+  getHotContainerIds(uint64_t max_num);
+
 private:
   //----------------------------------------------------------------------------
   //! Turn an incoming FileMDProto into FileMD, removing from the inFlight
@@ -0,0 +1,141 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2021 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "common/CLI11.hpp"
+#include "namespace/interface/IFsView.hh"
+#include "namespace/utils/FileIdSet.hh"
+#include <malloc.h>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+//------------------------------------------------------------------------------
+//! Get number of bytes currently allocated on the heap
+//------------------------------------------------------------------------------
+static size_t HeapInUse()
+{
+#if defined(__GLIBC__) && __GLIBC_PREREQ(2, 33)
+  return mallinfo2().uordblks;
+#else
+  return (unsigned int) mallinfo().uordblks;
+#endif
+}
+
+//------------------------------------------------------------------------------
+//! Get the ids of the replicas stored on one filesystem: every file gets
+//! num_replicas replicas on num_fs filesystems picked at random
+//------------------------------------------------------------------------------
+static std::vector<uint64_t> MakeIds(uint64_t num_files, uint32_t num_fs,
+                                     uint32_t num_replicas)
+{
+  std::mt19937_64 gen(42);
+  std::vector<uint64_t> ids;
+
+  for (uint64_t id = 1; id <= num_files; ++id) {
+    if (gen() % num_fs < num_replicas) {
+      ids.push_back(id);
+    }
+  }
+
+  // Files are loaded from QuarkDB in no particular order
+  std::shuffle(ids.begin(), ids.end(), gen);
+  return ids;
+}
+
+//------------------------------------------------------------------------------
+//! Fill the set, then measure iteration and lookups
+//------------------------------------------------------------------------------
+template <typename SetT, typename ContainsT>
+static void Run(const std::string& name, SetT& set,
+                const std::vector<uint64_t>& ids, uint64_t max_id,
+                ContainsT contains)
+{
+  using Clock = std::chrono::steady_clock;
+  size_t heap = HeapInUse();
+  auto start = Clock::now();
+
+  for (auto id : ids) {
+    set.insert(id);
+  }
+
+  double insert_ms = std::chrono::duration<double, std::milli>
+                     (Clock::now() - start).count();
+  size_t bytes = HeapInUse() - heap;
+  start = Clock::now();
+  uint64_t sum = 0;
+
+  for (auto it = set.begin(); it != set.end(); ++it) {
+    sum += *it;
+  }
+
+  double iterate_ms = std::chrono::duration<double, std::milli>
+                      (Clock::now() - start).count();
+  std::mt19937_64 gen(7);
+  uint64_t hits = 0;
+  start = Clock::now();
+
+  for (size_t i = 0; i < ids.size(); ++i) {
+    hits += contains(set, gen() % max_id + 1);
+  }
+
+  double lookup_ms = std::chrono::duration<double, std::milli>
+                     (Clock::now() - start).count();
+  std::cout << name << "\t"
+            << (double) bytes / ids.size() << "\t"
+            << ids.size() / insert_ms / 1000 << "\t"
+            << ids.size() / iterate_ms / 1000 << "\t"
+            << ids.size() / lookup_ms / 1000 << "\t"
+            << "(" << sum % 1000 << "/" << hits << ")\n";
+}
+
+//------------------------------------------------------------------------------
+// Main programm
+//------------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+  CLI::App app{"Filesystem file list benchmark - hash set vs compressed set"};
+  uint64_t num_files = 100000000;
+  uint32_t num_fs = 100;
+  uint32_t num_replicas = 2;
+  app.add_option("-n,--num_files", num_files, "number of files in namespace");
+  app.add_option("-f,--num_fs", num_fs, "number of filesystems");
+  app.add_option("-r,--replicas", num_replicas, "number of replicas per file");
+  CLI11_PARSE(app, argc, argv);
+  std::vector<uint64_t> ids = MakeIds(num_files, num_fs, num_replicas);
+  std::cout << "ids on filesystem: " << ids.size() << "\n"
+            << "set\tbytes/id\tinsert[MHz]\titerate[MHz]\tlookup[MHz]\n";
+  {
+    eos::IFsView::FileList hash_set;
+    hash_set.set_deleted_key(0);
+    hash_set.set_empty_key(0xffffffffffffffffll);
+    Run("hash", hash_set, ids, num_files,
+    [](const eos::IFsView::FileList & set, uint64_t id) {
+      return set.find(id) != set.end();
+    });
+  }
+  {
+    eos::FileIdSet id_set;
+    Run("compressed", id_set, ids, num_files,
+    [](const eos::FileIdSet & set, uint64_t id) {
+      return set.contains(id);
+    });
+  }
+  return 0;
+}
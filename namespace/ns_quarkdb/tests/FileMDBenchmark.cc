@@ -0,0 +1,246 @@
+//------------------------------------------------------------------------------
+// @file FileMDBenchmark.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2021 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "common/CLI11.hpp"
+#include "namespace/ns_quarkdb/FileMD.hh"
+#include "proto/FileMd.pb.h"
+#include <malloc.h>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <shared_mutex>
+#include <thread>
+#include <vector>
+
+//------------------------------------------------------------------------------
+//! Reference representation: the protobuf object guarded by a reader-writer
+//! lock, as QuarkFileMD used to store it.
+//------------------------------------------------------------------------------
+struct ProtoFileMD {
+  mutable std::shared_timed_mutex mMutex;
+  eos::ns::FileMdProto mFile;
+
+  uint64_t getSize() const
+  {
+    std::shared_lock<std::shared_timed_mutex> lock(mMutex);
+    return mFile.size();
+  }
+
+  uint16_t getFlags() const
+  {
+    std::shared_lock<std::shared_timed_mutex> lock(mMutex);
+    return mFile.flags();
+  }
+
+  uint64_t getId() const
+  {
+    std::shared_lock<std::shared_timed_mutex> lock(mMutex);
+    return mFile.id();
+  }
+
+  void getMTime(eos::IFileMD::ctime_t& mtime) const
+  {
+    std::shared_lock<std::shared_timed_mutex> lock(mMutex);
+    (void) memcpy(&mtime, mFile.mtime().data(), sizeof(mtime));
+  }
+
+  std::string getName() const
+  {
+    std::shared_lock<std::shared_timed_mutex> lock(mMutex);
+    return mFile.name();
+  }
+
+  void setFlags(uint16_t flags)
+  {
+    std::unique_lock<std::shared_timed_mutex> lock(mMutex);
+    mFile.set_flags(flags);
+  }
+
+  void setMTime(eos::IFileMD::ctime_t mtime)
+  {
+    std::unique_lock<std::shared_timed_mutex> lock(mMutex);
+    mFile.set_mtime(&mtime, sizeof(mtime));
+  }
+};
+
+//------------------------------------------------------------------------------
+//! Get number of bytes currently allocated on the heap
+//------------------------------------------------------------------------------
+static size_t HeapInUse()
+{
+#if defined(__GLIBC__) && __GLIBC_PREREQ(2, 33)
+  return mallinfo2().uordblks;
+#else
+  return (unsigned int) mallinfo().uordblks;
+#endif
+}
+
+//------------------------------------------------------------------------------
+//! Build the protobuf of a typical file
+//------------------------------------------------------------------------------
+static eos::ns::FileMdProto MakeProto(uint64_t id)
+{
+  eos::ns::FileMdProto proto;
+  eos::IFileMD::ctime_t ts {1600000000, 123456789};
+  proto.set_id(id);
+  proto.set_cont_id(id / 100 + 1);
+  proto.set_uid(1000);
+  proto.set_gid(1000);
+  proto.set_size(id * 4096);
+  proto.set_layout_id(0x00100112);
+  proto.set_name("run_" + std::to_string(id) + ".root");
+  proto.set_checksum("\x12\x34\x56\x78", 4);
+  proto.set_ctime(&ts, sizeof(ts));
+  proto.set_mtime(&ts, sizeof(ts));
+  proto.add_locations(id % 100 + 1);
+  proto.add_locations(id % 100 + 101);
+  (*proto.mutable_xattrs())["sys.eos.btime"] = "1600000000.123456789";
+  (*proto.mutable_xattrs())["sys.fs.tracking"] = "+1+101";
+  return proto;
+}
+
+//------------------------------------------------------------------------------
+//! Run readers and writers over the given files, the writers only use
+//! setters which don't notify the file service
+//!
+//! @return reader rate in kHz
+//------------------------------------------------------------------------------
+template <typename FileT>
+static double Run(std::vector<std::unique_ptr<FileT>>& files,
+                  uint32_t num_readers, uint32_t num_writers,
+                  uint64_t num_requests)
+{
+  std::atomic<bool> start {false};
+  std::atomic<bool> stop {false};
+  std::atomic<uint64_t> checksum {0};
+  std::vector<std::thread> readers;
+  std::vector<std::thread> writers;
+
+  for (uint32_t i = 0; i < num_writers; ++i) {
+    writers.emplace_back([&, i]() {
+      std::mt19937_64 gen(1000 + i);
+      std::uniform_int_distribution<size_t> dist(0, files.size() - 1);
+
+      while (!start) {}
+
+      while (!stop) {
+        auto& file = files[dist(gen)];
+        file->setFlags(gen() & 0xffff);
+        eos::IFileMD::ctime_t ts {(time_t) gen() & 0xffffffff, 0};
+        file->setMTime(ts);
+      }
+    });
+  }
+
+  for (uint32_t i = 0; i < num_readers; ++i) {
+    readers.emplace_back([&, i]() {
+      std::mt19937_64 gen(i);
+      std::uniform_int_distribution<size_t> dist(0, files.size() - 1);
+      uint64_t sum = 0;
+      eos::IFileMD::ctime_t mtime;
+
+      while (!start) {}
+
+      for (uint64_t req = 0; req < num_requests; ++req) {
+        auto& file = files[dist(gen)];
+        sum += file->getId() + file->getSize() + file->getFlags();
+        file->getMTime(mtime);
+        sum += mtime.tv_sec;
+
+        if ((req & 0xf) == 0) {
+          sum += file->getName().size();
+        }
+      }
+
+      checksum += sum;
+    });
+  }
+
+  auto start_ts = std::chrono::steady_clock::now();
+  start = true;
+
+  for (auto& th : readers) {
+    th.join();
+  }
+
+  auto duration = std::chrono::duration_cast<std::chrono::microseconds>
+                  (std::chrono::steady_clock::now() - start_ts);
+  stop = true;
+
+  for (auto& th : writers) {
+    th.join();
+  }
+
+  return (double)(num_readers * num_requests) * 1000.0 / duration.count();
+}
+
+//------------------------------------------------------------------------------
+// Main programm
+//------------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+  CLI::App app{"File metadata benchmark - protobuf vs compact representation"};
+  uint64_t num_files = 1000000;
+  uint32_t max_threads = std::thread::hardware_concurrency();
+  uint32_t num_writers = 1;
+  uint64_t num_requests = 1000000;
+  app.add_option("-n,--num_files", num_files, "number of files in memory");
+  app.add_option("-t,--max_threads", max_threads, "max number of readers");
+  app.add_option("-w,--writers", num_writers, "number of concurrent writers");
+  app.add_option("-r,--num_requests", num_requests,
+                 "number of requests per reader");
+  CLI11_PARSE(app, argc, argv);
+  std::vector<std::unique_ptr<ProtoFileMD>> proto_files;
+  std::vector<std::unique_ptr<eos::QuarkFileMD>> compact_files;
+  proto_files.reserve(num_files);
+  compact_files.reserve(num_files);
+  size_t heap = HeapInUse();
+
+  for (uint64_t id = 1; id <= num_files; ++id) {
+    proto_files.emplace_back(new ProtoFileMD());
+    proto_files.back()->mFile = MakeProto(id);
+  }
+
+  size_t proto_bytes = HeapInUse() - heap;
+  heap = HeapInUse();
+
+  for (uint64_t id = 1; id <= num_files; ++id) {
+    compact_files.emplace_back(new eos::QuarkFileMD());
+    compact_files.back()->initialize(MakeProto(id));
+  }
+
+  size_t compact_bytes = HeapInUse() - heap;
+  std::cout << "sizeof(QuarkFileMD): " << sizeof(eos::QuarkFileMD) << "\n"
+            << "bytes per file protobuf: " << proto_bytes / num_files << "\n"
+            << "bytes per file compact: " << compact_bytes / num_files << "\n"
+            << "readers\tprotobuf[kHz]\tcompact[kHz]\n";
+
+  for (uint32_t th = 1; th <= max_threads; th *= 2) {
+    double rate_proto = Run(proto_files, th, num_writers, num_requests);
+    double rate_compact = Run(compact_files, th, num_writers, num_requests);
+    std::cout << th << "\t" << rate_proto << "\t" << rate_compact << "\n";
+  }
+
+  return 0;
+}
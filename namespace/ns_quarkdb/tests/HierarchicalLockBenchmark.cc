@@ -0,0 +1,146 @@
+//------------------------------------------------------------------------------
+// @file HierarchicalLockBenchmark.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2021 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "common/CLI11.hpp"
+#include "namespace/utils/HierarchicalLockManager.hh"
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <shared_mutex>
+#include <thread>
+#include <vector>
+
+//------------------------------------------------------------------------------
+//! Simulated namespace tree: directory d lives at /top/<d % fanout>/<d>
+//! so a path is made of the root (1), one of the top level containers and
+//! the leaf container.
+//------------------------------------------------------------------------------
+struct Workload {
+  std::uint64_t num_dirs;
+  std::uint64_t fanout;
+  std::uint32_t pct_create; // write lock on the leaf container
+  std::uint32_t pct_readdir; // read lock held for a longer time
+  std::uint64_t work_ns;    // work done while holding the locks
+};
+
+//------------------------------------------------------------------------------
+//! Busy loop simulating the in-memory work done under the lock
+//------------------------------------------------------------------------------
+static void DoWork(std::uint64_t ns)
+{
+  auto deadline = std::chrono::steady_clock::now() +
+                  std::chrono::nanoseconds(ns);
+
+  while (std::chrono::steady_clock::now() < deadline) {}
+}
+
+//------------------------------------------------------------------------------
+//! Run the given workload with num_threads threads, use the global mutex if
+//! global is true otherwise the hierarchical lock manager.
+//!
+//! @return rate in kHz
+//------------------------------------------------------------------------------
+static double Run(const Workload& wl, std::uint32_t num_threads,
+                  std::uint64_t num_requests, bool global)
+{
+  std::shared_timed_mutex global_mtx;
+  eos::HierarchicalLockManager mgr;
+  std::atomic<bool> start {false};
+  std::vector<std::thread> workers;
+
+  for (std::uint32_t i = 0; i < num_threads; ++i) {
+    workers.emplace_back([&, i]() {
+      std::mt19937_64 gen(i);
+      std::uniform_int_distribution<std::uint64_t> dir_dist(1, wl.num_dirs);
+      std::uniform_int_distribution<std::uint32_t> op_dist(0, 99);
+
+      while (!start) {}
+
+      for (std::uint64_t req = 0; req < num_requests; ++req) {
+        std::uint64_t leaf = 1000 + dir_dist(gen);
+        std::uint64_t top = 2 + (leaf % wl.fanout);
+        std::uint32_t op = op_dist(gen);
+        bool create = (op < wl.pct_create);
+        std::uint64_t work = wl.work_ns;
+
+        if (!create && (op < wl.pct_create + wl.pct_readdir)) {
+          work *= 10;
+        }
+
+        if (global) {
+          if (create) {
+            std::unique_lock<std::shared_timed_mutex> lock(global_mtx);
+            DoWork(work);
+          } else {
+            std::shared_lock<std::shared_timed_mutex> lock(global_mtx);
+            DoWork(work);
+          }
+        } else {
+          auto plock = create ? mgr.lock({1, top}, {leaf}) :
+                       mgr.lock({1, top, leaf}, {});
+          DoWork(work);
+        }
+      }
+    });
+  }
+
+  auto start_ts = std::chrono::steady_clock::now();
+  start = true;
+
+  for (auto& th : workers) {
+    th.join();
+  }
+
+  auto duration = std::chrono::duration_cast<std::chrono::microseconds>
+                  (std::chrono::steady_clock::now() - start_ts);
+  return (double)(num_threads * num_requests) * 1000.0 / duration.count();
+}
+
+//------------------------------------------------------------------------------
+// Main programm
+//------------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+  CLI::App app{"Namespace lock benchmark - global mutex vs per-container locks"};
+  Workload wl {100000, 1000, 10, 10, 1000};
+  std::uint32_t max_threads = std::thread::hardware_concurrency();
+  std::uint64_t num_requests = 100000;
+  app.add_option("-d,--num_dirs", wl.num_dirs, "number of leaf containers");
+  app.add_option("-c,--create", wl.pct_create, "percentage of create ops");
+  app.add_option("-l,--readdir", wl.pct_readdir, "percentage of readdir ops");
+  app.add_option("-w,--work_ns", wl.work_ns, "work done under the lock [ns]");
+  app.add_option("-t,--max_threads", max_threads, "max number of threads");
+  app.add_option("-r,--num_requests", num_requests,
+                 "number of requests per thread");
+  CLI11_PARSE(app, argc, argv);
+  std::cout << "threads\tglobal[kHz]\tper-container[kHz]\n";
+
+  for (std::uint32_t th = 1; th <= max_threads; th *= 2) {
+    double rate_global = Run(wl, th, num_requests, true);
+    double rate_fine = Run(wl, th, num_requests, false);
+    std::cout << th << "\t" << rate_global << "\t" << rate_fine << "\n";
+  }
+
+  return 0;
+}
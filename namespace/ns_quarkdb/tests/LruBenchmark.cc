@@ -24,6 +24,9 @@
 #include "common/CLI11.hpp"
 #include "namespace/ns_quarkdb/LRU.hh"
 #include <experimental/random>
+#include <list>
+#include <random>
+#include <unordered_map>
 
 //! Global synchronization primitives
 std::mutex gMutex;
@@ -82,6 +85,104 @@ void WokerThread(eos::LRU<std::uint64_t, Entry>& lru, std::uint64_t num_req,
   gCondVar.notify_one();
 }
 
+//------------------------------------------------------------------------------
+//! Strict LRU, moving entries on every hit, as reference for the scan workload
+//------------------------------------------------------------------------------
+class StrictLRU
+{
+public:
+  explicit StrictLRU(std::uint64_t max_num): mMaxNum(max_num) {}
+
+  std::shared_ptr<Entry> get(std::uint64_t id)
+  {
+    std::unique_lock<std::mutex> lock(mMutex);
+    auto it = mMap.find(id);
+
+    if (it == mMap.end()) {
+      return nullptr;
+    }
+
+    mList.splice(mList.end(), mList, it->second);
+    return *it->second;
+  }
+
+  std::shared_ptr<Entry> put(std::uint64_t id, std::shared_ptr<Entry> obj)
+  {
+    std::unique_lock<std::mutex> lock(mMutex);
+
+    if (mMap.size() >= mMaxNum) {
+      mMap.erase(mList.front()->getId());
+      mList.pop_front();
+    }
+
+    mMap[id] = mList.insert(mList.end(), obj);
+    return obj;
+  }
+
+private:
+  std::mutex mMutex;
+  std::uint64_t mMaxNum;
+  std::list<std::shared_ptr<Entry>> mList;
+  std::unordered_map<std::uint64_t,
+      std::list<std::shared_ptr<Entry>>::iterator,
+      Murmur3::MurmurHasher<std::uint64_t>> mMap;
+};
+
+//------------------------------------------------------------------------------
+//! Replay a workload mixing lookups in a hot set with a scan over ids which
+//! are accessed only once, inserting the entry on each miss
+//!
+//! @param cache cache under test
+//! @param num_threads number of threads doing lookups
+//! @param num_req number of requests per thread
+//! @param hot_size number of entries in the hot set
+//! @param scan_pct percentage of requests belonging to the scan
+//! @param hit_rate returns the percentage of lookups which were hits
+//!
+//! @return rate in kHz
+//------------------------------------------------------------------------------
+template <typename CacheT>
+double ReplayScan(CacheT& cache, std::uint32_t num_threads,
+                  std::uint64_t num_req, std::uint64_t hot_size,
+                  std::uint32_t scan_pct, double& hit_rate)
+{
+  std::atomic<std::uint64_t> scan_id {hot_size + 1};
+  std::atomic<std::uint64_t> hits {0};
+  std::list<std::thread> workers;
+  auto start_ts = std::chrono::steady_clock::now();
+
+  for (auto i = 0ull; i < num_threads; ++i) {
+    workers.emplace_back([&, i]() {
+      std::mt19937_64 gen(i);
+      std::uniform_int_distribution<std::uint64_t> hot_dist(1, hot_size);
+      std::uint64_t local_hits = 0;
+
+      for (std::uint64_t req = 0; req < num_req; ++req) {
+        std::uint64_t id = ((gen() % 100) < scan_pct) ? scan_id++ :
+                           hot_dist(gen);
+
+        if (cache.get(id)) {
+          ++local_hits;
+        } else {
+          cache.put(id, std::make_shared<Entry>(id));
+        }
+      }
+
+      hits += local_hits;
+    });
+  }
+
+  for (auto& thread : workers) {
+    thread.join();
+  }
+
+  auto duration = std::chrono::duration_cast<std::chrono::microseconds>
+                  (std::chrono::steady_clock::now() - start_ts);
+  std::uint64_t total_req = num_threads * num_req;
+  hit_rate = 100.0 * hits / total_req;
+  return (total_req * 1000.0) / duration.count();
+}
+
 //------------------------------------------------------------------------------
 // Main programm
 //------------------------------------------------------------------------------
@@ -91,13 +192,42 @@ int main(int argc, char* argv[])
   std::uint64_t max_size = 1000000;
   std::uint32_t num_threads = 1;
   std::uint64_t num_requests = max_size / 10;
+  std::uint32_t num_stripes = 1;
+  std::uint32_t scan_pct = 0;
+  std::uint64_t hot_size = 0;
   app.add_option("-s,--size", max_size, "max size of the LRU");
   app.add_option("-t,--num_threads", num_threads,
                  "number of threads for access operations");
   app.add_option("-r,--num_requests", num_requests,
                  "number of requests per thread");
+  app.add_option("--stripes", num_stripes, "number of cache stripes");
+  app.add_option("--scan", scan_pct, "percentage of requests scanning "
+                 "through ids accessed only once, enables the scan workload");
+  app.add_option("--hot_size", hot_size, "size of the hot set for the scan "
+                 "workload, default 80% of the LRU size");
   CLI11_PARSE(app, argc, argv);
-  eos::LRU<std::uint64_t, Entry> lru{max_size + 10};
+
+  if (scan_pct) {
+    if (hot_size == 0) {
+      hot_size = max_size * 8 / 10;
+    }
+
+    double hit_rate = 0;
+    StrictLRU ref_cache{max_size};
+    double rate = ReplayScan(ref_cache, num_threads, num_requests, hot_size,
+                             scan_pct, hit_rate);
+    std::cout << "Strict LRU : " << hit_rate << "% hits, " << rate
+              << " kHz\n";
+    eos::LRU<std::uint64_t, Entry> cache{max_size, num_stripes};
+    rate = ReplayScan(cache, num_threads, num_requests, hot_size, scan_pct,
+                      hit_rate);
+    auto stats = cache.get_stats();
+    std::cout << "Cache      : " << hit_rate << "% hits, " << rate
+              << " kHz, " << stats.mEvictions << " evictions\n";
+    return 0;
+  }
+
+  eos::LRU<std::uint64_t, Entry> lru{max_size + 10, num_stripes};
   Populate(lru, max_size);
   std::list<std::thread> workers;
 
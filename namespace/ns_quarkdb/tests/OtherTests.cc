@@ -22,13 +22,27 @@
 //------------------------------------------------------------------------------
 
 #include <vector>
+#include "namespace/ns_quarkdb/CacheWarmer.hh"
 #include "namespace/ns_quarkdb/ConfigurationParser.hh"
 #include "namespace/ns_quarkdb/QdbContactDetails.hh"
+#include "namespace/ns_quarkdb/FileMD.hh"
 #include "namespace/ns_quarkdb/LRU.hh"
+#include "namespace/ns_quarkdb/PathLookupCache.hh"
+#include "namespace/ns_quarkdb/flusher/WriteCoalescer.hh"
+#include "namespace/ns_quarkdb/inspector/IdRangeIterator.hh"
+#include "namespace/utils/FileIdSet.hh"
 #include "namespace/utils/PathProcessor.hh"
+#include "namespace/utils/HierarchicalLockManager.hh"
+#include "namespace/utils/InlineVector.hh"
+#include "namespace/utils/PackedStrings.hh"
+#include "namespace/utils/StringInterner.hh"
 #include "namespace/utils/TestHelpers.hh"
+#include <google/protobuf/util/message_differencer.h>
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <set>
 #include <sstream>
+#include <thread>
 
 //------------------------------------------------------------------------------
 // Check the path
@@ -128,6 +142,307 @@ TEST(LRU, BasicSanity)
   ASSERT_TRUE(!cache.get(100));
 }
 
+TEST(LRU, ScanResistance)
+{
+  struct Entry {
+    explicit Entry(std::uint64_t id) : id_(id) {}
+
+    std::uint64_t
+    getId() const
+    {
+      return id_;
+    }
+
+    std::uint64_t id_;
+  };
+  std::uint64_t max_size = 1000;
+  std::uint64_t hot_size = 500;
+  eos::LRU<std::uint64_t, Entry> cache{max_size};
+
+  // Hot set accessed repeatedly
+  for (std::uint64_t id = 0; id < hot_size; ++id) {
+    ASSERT_TRUE(cache.put(id, std::make_shared<Entry>(id)));
+    ASSERT_TRUE(cache.get(id));
+  }
+
+  // A scan touching each entry only once must not flush the hot set
+  for (std::uint64_t id = max_size; id < 20 * max_size; ++id) {
+    ASSERT_TRUE(cache.put(id, std::make_shared<Entry>(id)));
+  }
+
+  ASSERT_LE(cache.size(), max_size);
+  std::uint64_t hits = 0;
+
+  for (std::uint64_t id = 0; id < hot_size; ++id) {
+    if (cache.get(id)) {
+      ++hits;
+    }
+  }
+
+  ASSERT_EQ(hot_size, hits);
+  auto stats = cache.get_stats();
+  ASSERT_EQ(2 * hot_size, stats.mHits);
+  ASSERT_EQ(0u, stats.mMisses);
+  ASSERT_EQ(19 * max_size + hot_size - cache.size(), stats.mEvictions);
+  ASSERT_FALSE(cache.get(max_size));
+  ASSERT_FALSE(cache.get(max_size, false));
+  ASSERT_EQ(1u, cache.get_stats().mMisses);
+}
+
+TEST(LRU, SizeLimit)
+{
+  struct Entry {
+    explicit Entry(std::uint64_t id) : id_(id) {}
+
+    std::uint64_t
+    getId() const
+    {
+      return id_;
+    }
+
+    std::uint64_t id_;
+  };
+  eos::LRU<std::uint64_t, Entry> cache{1000, 4, [](const Entry&)
+  {
+    return 100ull;
+  }};
+
+  for (std::uint64_t id = 0; id < 1000; ++id) {
+    ASSERT_TRUE(cache.put(id, std::make_shared<Entry>(id)));
+  }
+
+  ASSERT_LE(cache.size(), 1000u);
+  ASSERT_EQ(100 * cache.size(), cache.get_stats().mBytes);
+  // Lowering the byte limit purges the cache right away
+  cache.set_max_size(20000);
+  ASSERT_EQ(20000u, cache.get_max_size());
+  ASSERT_LE(cache.get_stats().mBytes, 20000u);
+  ASSERT_LE(cache.size(), 200u);
+
+  for (std::uint64_t id = 1000; id < 2000; ++id) {
+    ASSERT_TRUE(cache.put(id, std::make_shared<Entry>(id)));
+    ASSERT_LE(cache.get_stats().mBytes, 20000u);
+  }
+
+  // Referenced entries are never evicted
+  std::shared_ptr<Entry> pinned = cache.get(1999);
+  ASSERT_TRUE(pinned);
+
+  for (std::uint64_t id = 2000; id < 3000; ++id) {
+    ASSERT_TRUE(cache.put(id, std::make_shared<Entry>(id)));
+  }
+
+  ASSERT_TRUE(cache.get(1999));
+  // Removing the limit and flushing the cache
+  cache.set_max_size(0);
+  cache.set_max_num(UINT64_MAX);
+  ASSERT_EQ(1u, cache.size());
+  ASSERT_EQ(100u, cache.get_stats().mBytes);
+}
+
+TEST(LRU, HotIds)
+{
+  struct Entry {
+    explicit Entry(std::uint64_t id) : id_(id) {}
+
+    std::uint64_t
+    getId() const
+    {
+      return id_;
+    }
+
+    std::uint64_t id_;
+  };
+  eos::LRU<std::uint64_t, Entry> cache{100};
+
+  for (std::uint64_t id = 0; id < 100; ++id) {
+    ASSERT_TRUE(cache.put(id, std::make_shared<Entry>(id)));
+  }
+
+  // Entries never accessed are not hot
+  ASSERT_TRUE(cache.get_hot_ids(100).empty());
+
+  for (std::uint64_t id = 0; id < 10; ++id) {
+    for (std::uint64_t i = 0; i <= id % 3; ++i) {
+      ASSERT_TRUE(cache.get(id));
+    }
+  }
+
+  auto hot = cache.get_hot_ids(100);
+  std::sort(hot.begin(), hot.end());
+  ASSERT_EQ(10u, hot.size());
+
+  for (std::uint64_t id = 0; id < 10; ++id) {
+    ASSERT_EQ(id, hot[id].first);
+    ASSERT_EQ(id % 3 + 1, hot[id].second);
+  }
+
+  // The best scored ones are kept
+  hot = cache.get_hot_ids(3);
+  ASSERT_EQ(3u, hot.size());
+
+  for (const auto& entry : hot) {
+    ASSERT_EQ(3u, entry.second);
+  }
+}
+
+TEST(PathLookupCache, BasicSanity)
+{
+  eos::PathLookupCache cache;
+  std::string path;
+  ASSERT_TRUE(eos::PathLookupCache::buildPath({"eos", "user"}, path));
+  ASSERT_EQ("/eos/user", path);
+  ASSERT_FALSE(eos::PathLookupCache::buildPath({"eos", "..", "user"}, path));
+  ASSERT_FALSE(eos::PathLookupCache::buildPath({}, path));
+  ASSERT_EQ(0u, cache.lookup("/eos/user/a").depth);
+  // Inserts need a cached parent
+  ASSERT_FALSE(cache.insert("/eos/user", 2, 3, cache.getToken(2, "user")));
+  ASSERT_TRUE(cache.insert("/eos", 1, 2, cache.getToken(1, "eos")));
+  ASSERT_TRUE(cache.insert("/eos/user", 2, 3, cache.getToken(2, "user")));
+  ASSERT_TRUE(cache.insert("/eos/user/a", 3, 4, cache.getToken(3, "a")));
+  ASSERT_TRUE(cache.insert("/eos/missing", 2, 0, cache.getToken(2, "missing")));
+  // Longest prefix
+  eos::PathLookupCache::Result res = cache.lookup("/eos/user/a/file");
+  ASSERT_EQ(4u, res.id);
+  ASSERT_EQ(3u, res.depth);
+  ASSERT_EQ(strlen("/eos/user/a"), res.length);
+  res = cache.lookup("/eos/missing/x/y");
+  ASSERT_TRUE(res.negative);
+  ASSERT_EQ(2u, res.depth);
+  // Creating the missing name drops the negative entry
+  cache.invalidateName(2, "missing");
+  ASSERT_EQ(1u, cache.lookup("/eos/missing/x/y").depth);
+  // Removing a container drops its subtree
+  cache.invalidateContainer(3);
+  ASSERT_EQ(1u, cache.lookup("/eos/user/a/file").depth);
+  ASSERT_FALSE(cache.insert("/eos/user/a", 3, 4, cache.getToken(3, "a")));
+  // Racing invalidations reject the insert
+  eos::PathLookupCache::Token token = cache.getToken(2, "user");
+  cache.invalidateName(2, "user");
+  ASSERT_FALSE(cache.insert("/eos/user", 2, 3, token));
+  token = cache.getToken(2, "other");
+  cache.invalidateContainer(42);
+  ASSERT_FALSE(cache.insert("/eos/other", 2, 0, token));
+  eos::PathCacheStatistics stats = cache.getStatistics();
+  ASSERT_EQ(1u, stats.occupancy);
+  ASSERT_EQ(0u, stats.negative);
+  ASSERT_EQ(3u, stats.hits);
+  ASSERT_EQ(1u, stats.negativeHits);
+  // Exceeding the size limit drops everything
+  cache.setMaxEntries(1);
+  ASSERT_FALSE(cache.insert("/other", 1, 5, cache.getToken(1, "other")));
+  ASSERT_EQ(0u, cache.getStatistics().occupancy);
+  cache.setMaxEntries(0);
+  ASSERT_FALSE(cache.isEnabled());
+  ASSERT_FALSE(cache.insert("/eos", 1, 2, cache.getToken(1, "eos")));
+}
+
+TEST(WriteCoalescer, BasicSanity)
+{
+  using Request = eos::WriteCoalescer::Request;
+  eos::WriteCoalescer coalescer;
+  ASSERT_TRUE(coalescer.push({"LHSET", "eos-file-md", "1", "10", "a"}));
+  ASSERT_TRUE(coalescer.push({"HSET", "k1", "f1", "v1"}));
+  ASSERT_TRUE(coalescer.push({"LHSET", "eos-file-md", "1", "10", "b"}));
+  ASSERT_TRUE(coalescer.push({"HINCRBY", "k2", "f1", "5"}));
+  ASSERT_TRUE(coalescer.push({"HINCRBYMULTI", "k2", "f1", "-2", "k2", "f2",
+                              "7"
+                             }));
+  ASSERT_TRUE(coalescer.push({"SADD", "s1", "m1"}));
+  ASSERT_TRUE(coalescer.push({"HDEL", "k1", "f1"}));
+  ASSERT_TRUE(coalescer.push({"SADD", "s1", "m2"}));
+  ASSERT_TRUE(coalescer.push({"SREM", "s1", "m1", "m3"}));
+  // An increment after an absolute write can't be merged into it
+  ASSERT_TRUE(coalescer.push({"HSET", "k3", "f1", "1"}));
+  ASSERT_TRUE(coalescer.push({"HINCRBY", "k3", "f1", "1"}));
+  // Requests which must be ordered by the caller
+  ASSERT_FALSE(coalescer.push({"DEL", "k1"}));
+  ASSERT_FALSE(coalescer.push({"HINCRBY", "k2", "f1", "x"}));
+  ASSERT_FALSE(coalescer.push({"HINCRBYMULTI", "k2", "f1", "1", "k2", "f2",
+                               "y"
+                              }));
+  ASSERT_EQ(9u, coalescer.size());
+  std::vector<Request> out;
+  ASSERT_EQ(7u, coalescer.drain(out));
+  ASSERT_TRUE(coalescer.empty());
+  std::vector<Request> expected {
+    {"LHSET", "eos-file-md", "1", "10", "b"},
+    {"HDEL", "k1", "f1"},
+    {"HINCRBYMULTI", "k2", "f1", "3", "k2", "f2", "7"},
+    {"SREM", "s1", "m1", "m3"},
+    {"SADD", "s1", "m2"},
+    {"HSET", "k3", "f1", "1"},
+    {"HINCRBY", "k3", "f1", "1"}
+  };
+  ASSERT_EQ(expected, out);
+}
+
+TEST(HierarchicalLockManager, BasicSanity)
+{
+  eos::HierarchicalLockManager mgr(4);
+  ASSERT_EQ(16u, mgr.getNumStripes());
+  {
+    // Read locks on the path plus a write lock on the same id collapse into
+    // a single exclusive stripe lock
+    auto plock = mgr.lock({1, 2, 3}, {3});
+    ASSERT_LE(plock.size(), 3u);
+    // A disjoint stripe can still be taken concurrently
+    uint64_t other = 4;
+
+    while (mgr.getStripe(other) == mgr.getStripe(1) ||
+           mgr.getStripe(other) == mgr.getStripe(2) ||
+           mgr.getStripe(other) == mgr.getStripe(3)) {
+      ++other;
+    }
+
+    std::thread th([&]() {
+      auto wlock = mgr.writeLock(other);
+      ASSERT_EQ(1u, wlock.size());
+    });
+    th.join();
+    // Shared locks on the path components do not block other readers
+    if (mgr.getStripe(1) != mgr.getStripe(3)) {
+      std::thread rd([&]() {
+        auto rlock = mgr.readLock(1);
+        ASSERT_EQ(1u, rlock.size());
+      });
+      rd.join();
+    }
+  }
+  // Everything released, exclusive lock on the whole path must succeed
+  auto wlock = mgr.lock({}, {1, 2, 3});
+  wlock.release();
+  ASSERT_EQ(0u, wlock.size());
+}
+
+TEST(HierarchicalLockManager, NoDeadlock)
+{
+  eos::HierarchicalLockManager mgr(2);
+  std::atomic<uint64_t> counter {0};
+  std::vector<std::thread> workers;
+
+  // Threads locking overlapping sets in opposite orders must not deadlock
+  for (int i = 0; i < 8; ++i) {
+    workers.emplace_back([&, i]() {
+      for (int j = 0; j < 10000; ++j) {
+        if (i % 2) {
+          auto plock = mgr.lock({1, 5}, {9, 13});
+        } else {
+          auto plock = mgr.lock({13, 9}, {5, 1});
+        }
+
+        ++counter;
+      }
+    });
+  }
+
+  for (auto& th : workers) {
+    th.join();
+  }
+
+  ASSERT_EQ(80000u, counter.load());
+}
+
 TEST(PathProcessor, AbsPathTest)
 {
   std::string path = "/a/b/c/d/";
@@ -168,3 +483,256 @@ TEST(QdbContactDetails, BasicSanity)
   ASSERT_EQ(cd.members.toString(), "example1.cern.ch:1234,example2.cern.ch:2345,example3.cern.ch:3456");
   ASSERT_EQ(cd.password, "turtles_turtles_etc");
 }
+
+TEST(InlineVector, BasicSanity)
+{
+  eos::InlineVector<uint32_t, 2> vec;
+  ASSERT_TRUE(vec.empty());
+
+  for (uint32_t i = 1; i <= 5; ++i) {
+    vec.push_back(i);
+  }
+
+  ASSERT_EQ(5u, vec.size());
+  vec.erase(vec.begin() + 1);
+  ASSERT_EQ(std::vector<uint32_t>({1, 3, 4, 5}),
+            std::vector<uint32_t>(vec.begin(), vec.end()));
+  eos::InlineVector<uint32_t, 2> copy(vec);
+  eos::InlineVector<uint32_t, 2> moved(std::move(vec));
+  ASSERT_TRUE(vec.empty());
+  ASSERT_EQ(4u, moved.size());
+  ASSERT_EQ(moved[3], copy[3]);
+  copy.clear();
+  copy.push_back(7);
+  ASSERT_EQ(1u, copy.size());
+  ASSERT_EQ(7u, copy[0]);
+}
+
+TEST(PackedStrings, BasicSanity)
+{
+  eos::PackedStrings<3> strings;
+  ASSERT_EQ("", strings.get(1));
+  strings.set(1, "middle");
+  strings.set(0, "first");
+  strings.set(2, std::string("la\0st", 5));
+  ASSERT_EQ("first", strings.get(0));
+  ASSERT_EQ("middle", strings.get(1));
+  ASSERT_EQ(std::string("la\0st", 5), strings.get(2));
+  eos::PackedStrings<3> copy(strings);
+  strings.set(1, "");
+  ASSERT_EQ("", strings.get(1));
+  ASSERT_EQ("first", strings.get(0));
+  ASSERT_EQ("middle", copy.get(1));
+}
+
+TEST(StringInterner, BasicSanity)
+{
+  eos::StringInterner interner(32);
+  ASSERT_EQ(interner.intern("sys.acl").get(), interner.intern("sys.acl").get());
+
+  for (int i = 0; i < 1000; ++i) {
+    ASSERT_EQ(std::to_string(i), *interner.intern(std::to_string(i)));
+  }
+
+  // Bounded, strings beyond the capacity are not remembered
+  ASSERT_LE(interner.size(), 32u);
+}
+
+TEST(FileIdSet, BasicSanity)
+{
+  eos::FileIdSet ids;
+  std::set<uint64_t> expected;
+  ASSERT_TRUE(ids.empty());
+  ASSERT_TRUE(ids.begin() == ids.end());
+
+  // Dense chunk turning into a bitmap, plus sparse ids in other chunks
+  for (uint64_t id = 1; id <= 3 * eos::FileIdSet::kArrayMax; ++id) {
+    ASSERT_TRUE(ids.insert(id));
+    expected.insert(id);
+  }
+
+  for (uint64_t id = 1ull << 40; id < (1ull << 40) + 1000000; id += 997) {
+    ASSERT_TRUE(ids.insert(id));
+    expected.insert(id);
+  }
+
+  ASSERT_FALSE(ids.insert(5));
+  ASSERT_TRUE(ids.insert(0xffffffffffffffffull));
+  expected.insert(0xffffffffffffffffull);
+  ASSERT_EQ(expected.size(), ids.size());
+  ASSERT_TRUE(std::equal(expected.begin(), expected.end(), ids.begin()));
+  ASSERT_TRUE(ids.contains(1));
+  ASSERT_FALSE(ids.contains(0));
+  ASSERT_FALSE(ids.contains((1ull << 40) + 1));
+  ASSERT_EQ(1u, ids.select(0));
+  ASSERT_EQ(1ull << 40, ids.select(3 * eos::FileIdSet::kArrayMax));
+  ASSERT_EQ(0xffffffffffffffffull, ids.select(ids.size() - 1));
+
+  // Bitmap chunk going back to an array
+  for (uint64_t id = 1; id <= 3 * eos::FileIdSet::kArrayMax; id += 2) {
+    ASSERT_EQ(1u, ids.erase(id));
+    expected.erase(id);
+  }
+
+  ASSERT_EQ(0u, ids.erase(1));
+  ASSERT_EQ(expected.size(), ids.size());
+  ASSERT_TRUE(std::equal(expected.begin(), expected.end(), ids.begin()));
+  ASSERT_EQ(2u, ids.select(0));
+
+  for (uint64_t id = 2; id <= 3 * eos::FileIdSet::kArrayMax; id += 2) {
+    ASSERT_EQ(1u, ids.erase(id));
+    expected.erase(id);
+  }
+
+  ASSERT_EQ(expected.size(), ids.size());
+  ASSERT_TRUE(std::equal(expected.begin(), expected.end(), ids.begin()));
+  ids.clear();
+  ASSERT_TRUE(ids.empty());
+  ASSERT_TRUE(ids.begin() == ids.end());
+  ASSERT_EQ(0u, ids.getMemoryUsage());
+
+  // Sequential ids take about a bit each
+  for (uint64_t id = 1; id <= 1000000; ++id) {
+    ids.insert(id);
+  }
+
+  ids.shrink();
+  ASSERT_LT(ids.getMemoryUsage(), 1000000u / 4);
+}
+
+TEST(IdRange, Split)
+{
+  ASSERT_TRUE(eos::splitIdRange(0, 4).empty());
+  ASSERT_TRUE(eos::splitIdRange(10, 0).empty());
+  std::vector<eos::IdRange> ranges = eos::splitIdRange(10, 4);
+  ASSERT_EQ(4u, ranges.size());
+  ASSERT_EQ((eos::IdRange{1, 4}), ranges[0]);
+  ASSERT_EQ((eos::IdRange{4, 7}), ranges[1]);
+  ASSERT_EQ((eos::IdRange{7, 9}), ranges[2]);
+  ASSERT_EQ((eos::IdRange{9, 11}), ranges[3]);
+  // Never more ranges than ids
+  ranges = eos::splitIdRange(3, 8);
+  ASSERT_EQ(3u, ranges.size());
+  ASSERT_EQ((eos::IdRange{3, 4}), ranges[2]);
+  // Contiguous and covering [1, maxId]
+  ranges = eos::splitIdRange(1000003, 64);
+  ASSERT_EQ(64u, ranges.size());
+  ASSERT_EQ(1u, ranges.front().start);
+  ASSERT_EQ(1000004u, ranges.back().end);
+
+  for (size_t i = 1; i < ranges.size(); i++) {
+    ASSERT_EQ(ranges[i - 1].end, ranges[i].start);
+    ASSERT_LE(ranges[i].end - ranges[i].start, 1000003u / 64 + 1);
+  }
+}
+
+TEST(CacheWarmer, Serialization)
+{
+  eos::HotSet hot;
+  hot.containers = {{1, 5}, {7, 1}, {3, 7}};
+
+  for (uint64_t id = 1000000; id < 1010000; ++id) {
+    hot.files.emplace_back(id, (id % 7) + 1);
+  }
+
+  hot.files.emplace_back(UINT64_MAX, 2);
+  std::string data = eos::CacheWarmer::serialize(hot);
+  // Consecutive ids take 2 bytes each
+  ASSERT_LT(data.size(), 2 * hot.size() + 32);
+  eos::HotSet parsed;
+  ASSERT_TRUE(eos::CacheWarmer::deserialize(data, parsed));
+  // Hottest first, ascending ids for the same score
+  ASSERT_EQ((std::vector<std::pair<uint64_t, uint8_t>> {{3, 7}, {1, 5}, {7, 1}}),
+            parsed.containers);
+  ASSERT_EQ(hot.files.size(), parsed.files.size());
+
+  for (size_t i = 1; i < parsed.files.size(); ++i) {
+    ASSERT_TRUE((parsed.files[i - 1].second > parsed.files[i].second) ||
+                ((parsed.files[i - 1].second == parsed.files[i].second) &&
+                 (parsed.files[i - 1].first < parsed.files[i].first)));
+  }
+
+  std::sort(parsed.files.begin(), parsed.files.end());
+  std::sort(hot.files.begin(), hot.files.end());
+  ASSERT_EQ(hot.files, parsed.files);
+  // Corrupted or truncated data is rejected
+  ASSERT_FALSE(eos::CacheWarmer::deserialize("", parsed));
+  ASSERT_FALSE(eos::CacheWarmer::deserialize("EOSHOT00" + data.substr(8),
+               parsed));
+  ASSERT_FALSE(eos::CacheWarmer::deserialize(data.substr(0, data.size() - 1),
+               parsed));
+  ASSERT_FALSE(eos::CacheWarmer::deserialize(data + "x", parsed));
+  ASSERT_TRUE(eos::CacheWarmer::deserialize(
+                eos::CacheWarmer::serialize(eos::HotSet()), parsed));
+  ASSERT_EQ(0u, parsed.size());
+}
+
+TEST(QuarkFileMD, ProtoRoundTrip)
+{
+  eos::ns::FileMdProto proto;
+  eos::IFileMD::ctime_t ts {1600000000, 123};
+  proto.set_id(42);
+  proto.set_cont_id(7);
+  proto.set_uid(1000);
+  proto.set_gid(2000);
+  proto.set_size(4096);
+  proto.set_layout_id(0x00100112);
+  proto.set_flags(3);
+  proto.set_name("file.dat");
+  proto.set_checksum("\x12\x34\x00\x78", 4);
+  proto.set_ctime(&ts, sizeof(ts));
+  proto.set_mtime(&ts, sizeof(ts));
+  proto.add_locations(1);
+  proto.add_locations(2);
+  proto.add_unlink_locations(3);
+  (*proto.mutable_xattrs())["user.b"] = "2";
+  (*proto.mutable_xattrs())["user.a"] = "1";
+  eos::QuarkFileMD file;
+  file.initialize(eos::ns::FileMdProto(proto));
+  ASSERT_TRUE(google::protobuf::util::MessageDifferencer::Equals(proto,
+              file.getProto()));
+  ASSERT_EQ(42u, file.getId());
+  ASSERT_EQ("file.dat", file.getName());
+  ASSERT_EQ(4u, file.getChecksum().getSize());
+  ASSERT_EQ(2u, file.getNumLocation());
+  ASSERT_TRUE(file.hasUnlinkedLocation(3));
+  eos::IFileMD::ctime_t stime;
+  file.getSyncTime(stime);
+  ASSERT_EQ(ts.tv_sec, stime.tv_sec);
+  ASSERT_EQ(ts.tv_nsec, stime.tv_nsec);
+  // Attributes are kept sorted
+  file.setAttribute("user.0", "0");
+  file.removeAttribute("user.b");
+  eos::IFileMD::XAttrMap expected {{"user.0", "0"}, {"user.a", "1"}};
+  ASSERT_EQ(expected, file.getAttributes());
+  ASSERT_THROW(file.getAttribute("user.b"), eos::MDException);
+  // Copies are deep
+  std::unique_ptr<eos::QuarkFileMD> copy(file.clone());
+  file.setName("other.dat");
+  file.clearAttributes();
+  ASSERT_EQ("file.dat", copy->getName());
+  ASSERT_EQ("1", copy->getAttribute("user.a"));
+  ASSERT_EQ(0u, file.numAttributes());
+}
+
+TEST(QuarkFileMD, ConcurrentTimes)
+{
+  eos::QuarkFileMD file;
+  std::atomic<bool> stop {false};
+  std::thread writer([&]() {
+    for (int64_t i = 1; !stop; ++i) {
+      eos::IFileMD::ctime_t ts {(time_t) i, i % 1000000000};
+      file.setMTime(ts);
+    }
+  });
+  eos::IFileMD::ctime_t mtime;
+
+  // Readers never observe a torn timestamp
+  for (int i = 0; i < 100000; ++i) {
+    file.getMTime(mtime);
+    ASSERT_EQ(mtime.tv_sec % 1000000000, mtime.tv_nsec);
+  }
+
+  stop = true;
+  writer.join();
+}
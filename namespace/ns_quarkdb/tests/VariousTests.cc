@@ -21,18 +21,26 @@
 //! @brief Various namespace tests
 //------------------------------------------------------------------------------
 
+#include <algorithm>
+#include <iomanip>
 #include <memory>
+#include <thread>
+#include <unistd.h>
 #include <gtest/gtest.h>
 
 #include "namespace/interface/ContainerIterators.hh"
 #include "namespace/ns_quarkdb/explorer/NamespaceExplorer.hh"
+#include "namespace/ns_quarkdb/persistency/ContainerListing.hh"
 #include "namespace/ns_quarkdb/persistency/ContainerMDSvc.hh"
 #include "namespace/ns_quarkdb/persistency/FileMDSvc.hh"
+#include "namespace/ns_quarkdb/persistency/MetadataProvider.hh"
 #include "namespace/ns_quarkdb/persistency/MetadataFetcher.hh"
 #include "namespace/ns_quarkdb/persistency/RequestBuilder.hh"
 #include "namespace/ns_quarkdb/views/HierarchicalView.hh"
+#include "namespace/ns_quarkdb/accounting/ContainerAccounting.hh"
 #include "namespace/ns_quarkdb/accounting/FileSystemView.hh"
 #include "namespace/ns_quarkdb/flusher/MetadataFlusher.hh"
+#include "namespace/ns_quarkdb/CacheWarmer.hh"
 #include "namespace/ns_quarkdb/FileMD.hh"
 #include "namespace/ns_quarkdb/ContainerMD.hh"
 #include "namespace/ns_quarkdb/utils/FutureVectorIterator.hh"
@@ -40,10 +48,13 @@
 #include "namespace/ns_quarkdb/persistency/FileSystemIterator.hh"
 #include "namespace/ns_quarkdb/inspector/AttributeExtraction.hh"
 #include "namespace/ns_quarkdb/inspector/FileMetadataFilter.hh"
+#include "namespace/ns_quarkdb/inspector/FileScanner.hh"
+#include "namespace/ns_quarkdb/inspector/ShardedScan.hh"
 #include "namespace/common/QuotaNodeCore.hh"
 #include "namespace/utils/Checksum.hh"
 #include "namespace/utils/Etag.hh"
 #include "namespace/utils/Attributes.hh"
+#include "namespace/utils/HierarchicalLockManager.hh"
 #include "namespace/PermissionHandler.hh"
 #include "namespace/Resolver.hh"
 #include "TestUtils.hh"
@@ -690,7 +701,7 @@ TEST_F(VariousTests, EtagFormatting)
   mtime.tv_nsec = 0;
   file1->setCTime(mtime);
   eos::QuarkFileMD* file1f = reinterpret_cast<QuarkFileMD*>(file1.get());
-  file1f->mFile.set_id(4697755903ull);
+  file1f->mId.store(4697755903ull);
   // File has no checksum, using inode + modification time.
   std::string outcome;
   eos::calculateEtag(file1.get(), outcome);
@@ -708,7 +719,7 @@ TEST_F(VariousTests, EtagFormatting)
   buff[2] = 0x99;
   buff[3] = 0x97;
   file1->setChecksum(buff, 4);
-  file1f->mFile.set_id(4697755939ull);
+  file1f->mId.store(4697755939ull);
   unsigned long layout = eos::common::LayoutId::GetId(
                            eos::common::LayoutId::kReplica,
                            eos::common::LayoutId::kAdler,
@@ -1134,6 +1145,52 @@ TEST_F(NamespaceExplorerF, ExpansionDecider)
   ASSERT_FALSE(explorer.fetch(item));
 }
 
+TEST_F(NamespaceExplorerF, Parallel)
+{
+  populateDummyData1();
+  auto explore = [this](const std::string & path, ExplorationOptions options) {
+    std::vector<std::pair<std::string, bool>> items;
+    NamespaceExplorer explorer(path, options, qcl(), executor());
+    NamespaceItem item;
+
+    while (explorer.fetch(item)) {
+      items.emplace_back(item.fullPath, item.expansionFilteredOut);
+    }
+
+    ExplorationStats stats = explorer.getStats();
+    EXPECT_EQ(items.size(), stats.containers + stats.files);
+    return items;
+  };
+  ExplorationOptions options;
+  options.depthLimit = 999;
+
+  for (auto decider : {
+         false, true
+       }) {
+    if (decider) {
+      options.expansionDecider.reset(new ContainerFilter());
+    }
+
+    for (auto path : {
+           "/", "/eos/d2"
+         }) {
+      options.numWorkers = 0;
+      auto expected = explore(path, options);
+      ASSERT_FALSE(expected.empty());
+      options.numWorkers = 4;
+      options.maxInFlight = 5;
+      options.orderedOutput = true;
+      ASSERT_EQ(expected, explore(path, options));
+      options.orderedOutput = false;
+      auto unordered = explore(path, options);
+      ASSERT_EQ(expected.size(), unordered.size());
+      std::sort(expected.begin(), expected.end());
+      std::sort(unordered.begin(), unordered.end());
+      ASSERT_EQ(expected, unordered);
+    }
+  }
+}
+
 TEST_F(VariousTests, LinkedExtendedAttributes)
 {
   IContainerMDPtr cont1 = view()->createContainer("/eos/dir1", true);
@@ -1175,6 +1232,88 @@ TEST_F(VariousTests, LinkedExtendedAttributes)
   ASSERT_EQ(out["user.qwerty"], "asdf");
 }
 
+TEST_F(VariousTests, ShardedScan)
+{
+  populateDummyData1();
+  std::vector<uint64_t> expected;
+  FileScanner fileScanner(qcl());
+
+  while (fileScanner.valid()) {
+    eos::ns::FileMdProto proto;
+    ASSERT_TRUE(fileScanner.getItem(proto));
+    expected.emplace_back(proto.id());
+    fileScanner.next();
+  }
+
+  std::sort(expected.begin(), expected.end());
+  ASSERT_FALSE(expected.empty());
+  uint64_t maxId = ShardedScan::getMaxId(qcl());
+  ASSERT_GE(maxId, expected.back());
+  // Ranges cover every file exactly once, in ascending order
+  std::vector<uint64_t> ranged;
+
+  for (const auto& range : splitIdRange(maxId, 7)) {
+    FileScanner rangeScanner(qcl(), range);
+
+    while (rangeScanner.valid()) {
+      eos::ns::FileMdProto proto;
+      ASSERT_TRUE(rangeScanner.getItem(proto));
+      ranged.emplace_back(proto.id());
+      rangeScanner.next();
+    }
+  }
+
+  ASSERT_EQ(expected, ranged);
+  std::ostringstream expectedOut;
+
+  for (auto id : expected) {
+    expectedOut << id << std::endl;
+  }
+
+  auto scanShard = [](ScanShard & shard) {
+    FileScanner rangeScanner(shard.qcl, shard.range);
+
+    while (rangeScanner.valid()) {
+      eos::ns::FileMdProto proto;
+      rangeScanner.getItem(proto);
+      shard.out << proto.id() << std::endl;
+      shard.counters["files"]++;
+      rangeScanner.next();
+    }
+
+    shard.scanned = rangeScanner.getScannedSoFar();
+  };
+
+  // Sorted output does not depend on the number of workers
+  for (size_t workers : {
+         1, 3, 8
+       }) {
+    std::ostringstream out, err;
+    StreamSink sink(out, err);
+    ShardedScan scan(getContactDetails(), workers, true);
+    ASSERT_EQ(0, scan.run(maxId, scanShard, sink, out, err, "files"));
+    ASSERT_EQ(expectedOut.str(), out.str());
+    ASSERT_EQ(expected.size(), scan.getCounters().at("files"));
+    ASSERT_EQ(expected.size(), scan.getScanned());
+  }
+
+  // Unsorted output has the same lines, in any order
+  std::ostringstream out, err;
+  StreamSink sink(out, err);
+  ShardedScan scan(getContactDetails(), 4, false);
+  ASSERT_EQ(0, scan.run(maxId, scanShard, sink, out, err, "files"));
+  std::vector<uint64_t> unsorted;
+  std::istringstream in(out.str());
+  uint64_t id;
+
+  while (in >> id) {
+    unsorted.emplace_back(id);
+  }
+
+  std::sort(unsorted.begin(), unsorted.end());
+  ASSERT_EQ(expected, unsorted);
+}
+
 TEST(OctalParsing, BasicSanity)
 {
   mode_t mode;
@@ -1423,6 +1562,224 @@ TEST_F(VariousTests, CountContents)
   ASSERT_EQ(std::move(counts.second).get(), 0u);
 }
 
+TEST_F(VariousTests, PagedListing)
+{
+  eos::IContainerMDPtr cont = view()->createContainer("/dir-1/");
+  ASSERT_EQ(cont->getId(), 2);
+  std::map<std::string, bool> expected;
+
+  for (size_t i = 0; i < 25; ++i) {
+    std::string name = SSTR("entry-" << std::setw(2) << std::setfill('0') << i);
+
+    if (i % 3 == 0) {
+      view()->createContainer("/dir-1/" + name + "/");
+      expected[name] = false;
+    } else {
+      view()->createFile("/dir-1/" + name);
+      expected[name] = true;
+    }
+  }
+
+  mdFlusher()->synchronize();
+  std::map<std::string, bool> listed;
+  std::string cursor;
+  size_t num_pages = 0;
+
+  do {
+    ContainerListing::Page page = ContainerListing::getPage(qcl(),
+                                  ContainerIdentifier(2), cursor, 7).get();
+    ASSERT_LE(page.entries.size(), 7u);
+
+    for (const auto& entry : page.entries) {
+      ASSERT_TRUE(listed.empty() || (entry.name > listed.rbegin()->first));
+      ASSERT_FALSE(entry.id.empty());
+      listed[entry.name] = entry.id.isFile();
+    }
+
+    cursor = page.cursor;
+    ++num_pages;
+  } while (!cursor.empty());
+
+  ASSERT_EQ(listed, expected);
+  ASSERT_EQ(num_pages, 4u);
+  // Files or subcontainers only, starting after a given name
+  ContainerListing::Page page = ContainerListing::getPage(qcl(),
+                                ContainerIdentifier(2),
+                                ContainerListing::encodeCursor("entry-10"), 100, false, true).get();
+  ASSERT_EQ(page.entries.size(), 5u);
+  ASSERT_EQ(page.entries[0].name, "entry-12");
+  ASSERT_TRUE(page.entries[0].id.isContainer());
+  ASSERT_TRUE(page.cursor.empty());
+  page = ContainerListing::getPage(qcl(), ContainerIdentifier(2), "",
+                                   100, true, false).get();
+  ASSERT_EQ(page.entries.size(), 16u);
+  ASSERT_TRUE(page.entries[0].id.isFile());
+  ASSERT_THROW(ContainerListing::getPage(qcl(), ContainerIdentifier(2),
+                                         "xyz").get(), eos::MDException);
+  // Metadata of a large container without its entries
+  ContainerListing::LargeContainer large = ContainerListing::getLargeContainer(
+        qcl(), ContainerIdentifier(2), 100).get();
+  ASSERT_FALSE(large.container);
+  ASSERT_EQ(large.numFiles, 16u);
+  ASSERT_EQ(large.numContainers, 9u);
+  large = ContainerListing::getLargeContainer(qcl(), ContainerIdentifier(2),
+          25).get();
+  ASSERT_TRUE(large.container);
+  ASSERT_EQ(large.container->getName(), "dir-1");
+  ASSERT_EQ(large.container->getNumFiles(), 0u);
+}
+
+TEST_F(VariousTests, LargeContainerPointLookup)
+{
+  eos::QuarkHierarchicalView* quark_view =
+    dynamic_cast<eos::QuarkHierarchicalView*>(view());
+  eos::QuarkContainerMDSvc* cont_svc =
+    dynamic_cast<eos::QuarkContainerMDSvc*>(containerSvc());
+  ASSERT_NE(quark_view, nullptr);
+  ASSERT_NE(cont_svc, nullptr);
+  ASSERT_EQ(view()->createContainer("/dir-1/")->getId(), 2);
+
+  for (size_t i = 0; i < 10; ++i) {
+    view()->createFile(SSTR("/dir-1/file-" << i));
+  }
+
+  view()->createContainer("/dir-1/sub/");
+  mdFlusher()->synchronize();
+  quark_view->setLargeContainerThreshold(10);
+  ASSERT_TRUE(cont_svc->dropCachedContainerMD(ContainerIdentifier(2)));
+  ASSERT_FALSE(cont_svc->isContainerMDCached(ContainerIdentifier(2)));
+  // Entries are found by name without loading their parent
+  ASSERT_EQ(view()->getFile("/dir-1/file-3")->getName(), "file-3");
+  ASSERT_EQ(view()->getContainer("/dir-1/sub")->getName(), "sub");
+  ASSERT_THROW(view()->getFile("/dir-1/missing"), eos::MDException);
+  ASSERT_THROW(view()->getFile("/dir-1/sub"), eos::MDException);
+  ASSERT_THROW(view()->getContainer("/dir-1/file-3"), eos::MDException);
+  ASSERT_FALSE(cont_svc->isContainerMDCached(ContainerIdentifier(2)));
+  // Below the threshold the parent is loaded
+  quark_view->setLargeContainerThreshold(12);
+  ASSERT_EQ(view()->getFile("/dir-1/file-4")->getName(), "file-4");
+  ASSERT_TRUE(cont_svc->isContainerMDCached(ContainerIdentifier(2)));
+}
+
+TEST_F(VariousTests, TreeSizeAccounting)
+{
+  eos::common::RWMutex ns_mutex;
+  eos::QuarkContainerAccounting accounting(containerSvc(), &ns_mutex, 0);
+  eos::IContainerMDPtr c = view()->createContainer("/a/b/c/", true);
+  eos::IContainerMDPtr d = view()->createContainer("/a/d/", true);
+  accounting.QueueForUpdate(c->getId(), 10);
+  accounting.QueueForUpdate(d->getId(), 5);
+  accounting.QueueForUpdate(1, 100);
+  std::thread writer([&]() {
+    accounting.QueueForUpdate(c->getId(), -3);
+  });
+  writer.join();
+  ASSERT_GE(accounting.GetStats().queueDepth, 2u);
+  // Nothing is applied before the propagation
+  ASSERT_EQ(c->getTreeSize(), 0u);
+  accounting.PropagateUpdates();
+  ASSERT_EQ(view()->getContainer("/a/b/c")->getTreeSize(), 7u);
+  ASSERT_EQ(view()->getContainer("/a/b")->getTreeSize(), 7u);
+  ASSERT_EQ(view()->getContainer("/a/d")->getTreeSize(), 5u);
+  ASSERT_EQ(view()->getContainer("/a")->getTreeSize(), 12u);
+  ASSERT_EQ(view()->getContainer("/")->getTreeSize(), 0u);
+  eos::QuarkContainerAccounting::Stats stats = accounting.GetStats();
+  ASSERT_EQ(stats.queueDepth, 0u);
+  ASSERT_EQ(stats.pending, 0u);
+  ASSERT_EQ(stats.applied, 4u);
+  // Subtree moves
+  accounting.RemoveTree(view()->getContainer("/a/b").get(), 7);
+  accounting.AddTree(d.get(), 7);
+  accounting.PropagateUpdates();
+  ASSERT_EQ(view()->getContainer("/a/b")->getTreeSize(), 0u);
+  ASSERT_EQ(view()->getContainer("/a/d")->getTreeSize(), 12u);
+  ASSERT_EQ(view()->getContainer("/a")->getTreeSize(), 12u);
+  // Changes queued for containers removed before the propagation still
+  // reach the surviving parents, whether the removed ones are cached or not
+  containerSvc()->setContainerAccounting(&accounting);
+  eos::IContainerMDPtr f = view()->createContainer("/a/d/e/f/", true);
+  accounting.QueueForUpdate(f->getId(), -2);
+  view()->removeContainer("/a/d/e/f");
+  view()->removeContainer("/a/d/e");
+  mdFlusher()->synchronize();
+  containerSvc()->dropCachedContainerMD(ContainerIdentifier(f->getId()));
+  accounting.PropagateUpdates();
+  containerSvc()->setContainerAccounting(nullptr);
+  ASSERT_EQ(view()->getContainer("/a/d")->getTreeSize(), 10u);
+  ASSERT_EQ(view()->getContainer("/a")->getTreeSize(), 10u);
+}
+
+TEST_F(VariousTests, TreeSizeAccountingContainerLocks)
+{
+  eos::common::RWMutex ns_mutex;
+  eos::HierarchicalLockManager cont_locks;
+  eos::QuarkContainerAccounting accounting(containerSvc(), &ns_mutex, 0,
+      &cont_locks);
+  eos::IContainerMDPtr c = view()->createContainer("/a/b/", true);
+  accounting.QueueForUpdate(c->getId(), 10);
+  // The update waits for the writer holding the container lock, readers of
+  // the namespace are not blocked
+  eos::HierarchicalLockManager::PathLock writer =
+    cont_locks.writeLock(c->getId());
+  std::thread propagation([&]() {
+    accounting.PropagateUpdates();
+  });
+  {
+    eos::common::RWMutexReadLock ns_rd_lock(ns_mutex);
+    ASSERT_EQ(c->getTreeSize(), 0u);
+  }
+  writer.release();
+  propagation.join();
+  ASSERT_EQ(view()->getContainer("/a/b")->getTreeSize(), 10u);
+  ASSERT_EQ(view()->getContainer("/a")->getTreeSize(), 10u);
+  ASSERT_EQ(accounting.GetStats().applied, 2u);
+}
+
+TEST_F(VariousTests, PathLookupCache)
+{
+  eos::PathLookupCache& cache = static_cast<eos::QuarkContainerMDSvc*>
+                                (containerSvc())->getPathLookupCache();
+  view()->createContainer("/eos/user/a/", true);
+  view()->createFile("/eos/user/a/file");
+  ASSERT_EQ(view()->getFile("/eos/user/a/file")->getName(), "file");
+  ASSERT_EQ(cache.lookup("/eos/user/a/file").depth, 3u);
+  // Negative entries are dropped when the name is created
+  ASSERT_THROW(view()->getContainer("/eos/user/b/c"), eos::MDException);
+  ASSERT_TRUE(cache.lookup("/eos/user/b/c").negative);
+  ASSERT_THROW(view()->getContainer("/eos/user/b/c"), eos::MDException);
+  ASSERT_EQ(cache.getStatistics().negativeHits, 2u);
+  view()->createContainer("/eos/user/b/", false);
+  ASSERT_EQ(view()->getContainer("/eos/user/b")->getName(), "b");
+  ASSERT_THROW(view()->getFile("/eos/user/a/other"), eos::MDException);
+  view()->createFile("/eos/user/a/other");
+  ASSERT_EQ(view()->getFile("/eos/user/a/other")->getName(), "other");
+  // Renames drop the subtree
+  view()->renameContainer(view()->getContainer("/eos/user/a").get(), "a2");
+  ASSERT_THROW(view()->getFile("/eos/user/a/file"), eos::MDException);
+  ASSERT_EQ(view()->getFile("/eos/user/a2/file")->getName(), "file");
+  // Moves done directly on the containers are seen as well
+  eos::IContainerMDPtr a2 = view()->getContainer("/eos/user/a2");
+  eos::IContainerMDPtr user = view()->getContainer("/eos/user");
+  eos::IContainerMDPtr b = view()->getContainer("/eos/user/b");
+  user->removeContainer("a2");
+  b->addContainer(a2.get());
+  ASSERT_THROW(view()->getFile("/eos/user/a2/file"), eos::MDException);
+  ASSERT_EQ(view()->getFile("/eos/user/b/a2/file")->getName(), "file");
+  // Removals
+  view()->unlinkFile("/eos/user/b/a2/file");
+  view()->unlinkFile("/eos/user/b/a2/other");
+  view()->removeContainer("/eos/user/b/a2");
+  ASSERT_THROW(view()->getContainer("/eos/user/b/a2"), eos::MDException);
+  view()->createContainer("/eos/user/b/a2/", false);
+  ASSERT_EQ(view()->getContainer("/eos/user/b/a2")->getNumFiles(), 0u);
+  // Symlinks and relative components are resolved without the cache
+  view()->createLink("/eos/link", "/eos/user/b");
+  ASSERT_EQ(view()->getContainer("/eos/link/a2")->getName(), "a2");
+  ASSERT_EQ(cache.lookup("/eos/link/a2").depth, 1u);
+  ASSERT_EQ(view()->getContainer("/eos/user/b/../b/a2")->getName(), "a2");
+  ASSERT_GT(cache.getStatistics().invalidations, 0u);
+}
+
 TEST_F(VariousTests, ContainerIterator)
 {
   eos::IContainerMDPtr cont1 = view()->createContainer("/dir-1/");
@@ -1571,3 +1928,68 @@ TEST_F(NamespaceExplorerF, MissingFile)
   ASSERT_TRUE(explorer.fetch(item));
   ASSERT_EQ(item.fullPath, "/dir-1/file-5");
 }
+
+TEST_F(VariousTests, CacheWarmUp)
+{
+  populateDummyData1();
+  std::string path = "/tmp/eos-ns-tests-cache-snapshot";
+  unlink(path.c_str());
+  eos::IFileMDPtr file = view()->getFile("/eos/d1/f1");
+  eos::IContainerMDPtr cont = view()->getContainer("/eos/d1/d2/d3-1/");
+  eos::FileIdentifier fid = file->getIdentifier();
+  eos::ContainerIdentifier cid = cont->getIdentifier();
+  file.reset();
+  cont.reset();
+  eos::MetadataProvider* provider = static_cast<eos::QuarkFileMDSvc*>
+                                    (fileSvc())->getMetadataProvider();
+  {
+    // Nothing to warm up from, and nothing to save if nothing is hot
+    eos::CacheWarmer warmer(provider, path, std::chrono::seconds(3600));
+    eos::HotSet hot;
+    std::string err;
+    ASSERT_TRUE(warmer.loadSnapshot(hot, err));
+    ASSERT_EQ(0u, hot.size());
+    // Make sure our entries are hot
+    ASSERT_TRUE(provider->retrieveFileMD(fid).get());
+    ASSERT_TRUE(provider->retrieveContainerMD(cid).get());
+    ASSERT_TRUE(warmer.saveSnapshot(err));
+    ASSERT_GT(warmer.getStatistics().snapshotEntries, 0u);
+  }
+  // Start from empty caches
+  shut_down_everything();
+  provider = static_cast<eos::QuarkFileMDSvc*>
+             (fileSvc())->getMetadataProvider();
+  eos::CacheWarmer warmer(provider, path, std::chrono::seconds(3600));
+  eos::HotSet hot;
+  std::string err;
+  ASSERT_TRUE(warmer.loadSnapshot(hot, err));
+  auto hasId = [](const std::vector<std::pair<uint64_t, uint8_t>>& ids,
+  uint64_t id) {
+    return std::find_if(ids.begin(), ids.end(),
+    [&](const std::pair<uint64_t, uint8_t>& entry) {
+      return entry.first == id;
+    }) != ids.end();
+  };
+  ASSERT_TRUE(hasId(hot.files, fid.getUnderlyingUInt64()));
+  ASSERT_TRUE(hasId(hot.containers, cid.getUnderlyingUInt64()));
+  // A deleted file can not be prefetched
+  hot.files.emplace_back(999999, 1);
+  AssistedThread warmUpThread([&](ThreadAssistant & assistant) {
+    warmer.warmUp(hot, assistant);
+  });
+  warmUpThread.blockUntilThreadJoins();
+  eos::CacheWarmUpStatistics stats = warmer.getStatistics();
+  ASSERT_EQ("done", stats.status);
+  ASSERT_EQ(hot.size(), stats.total);
+  ASSERT_EQ(hot.size() - 1, stats.loaded);
+  ASSERT_EQ(1u, stats.failed);
+  // The warm-up lookups are not accounted, the next ones are all hits
+  eos::CacheStatistics before = provider->getFileMDCacheStats();
+  ASSERT_EQ(stats.startHits, before.hits +
+            provider->getContainerMDCacheStats().hits);
+  ASSERT_TRUE(provider->retrieveFileMD(fid).get());
+  eos::CacheStatistics after = provider->getFileMDCacheStats();
+  ASSERT_EQ(before.hits + 1, after.hits);
+  ASSERT_EQ(before.misses, after.misses);
+  unlink(path.c_str());
+}
@@ -91,6 +91,18 @@ void addDryRun(CLI::App* subcmd, bool& noDryRun)
                    "Execute changes for real.\nIf not supplied, planned changes are only shown and not applied.");
 }
 
+//------------------------------------------------------------------------------
+// Parallelism, common to all commands going through the entire namespace
+//----------------------------------------------------------------------------
+void addWorkerOptions(CLI::App* subcmd, size_t& workers, bool& unsorted)
+{
+  subcmd->add_option("--workers", workers,
+                     "Number of parallel workers, each with its own connection to QDB.\nWith more than one worker the metadata is scanned in ranges of ids, and the output comes in ascending id order.")
+  ->check(CLI::Range(1, 256));
+  subcmd->add_flag("--unsorted", unsorted,
+                   "With more than one worker, print the output of each range as soon as it is done instead of in id order");
+}
+
 int main(int argc, char* argv[])
 {
   CLI::App app("Tool to inspect contents of the QuarkDB-based EOS namespace.");
@@ -104,6 +116,8 @@ int main(int argc, char* argv[])
   std::string password;
   std::string passwordFile;
   bool noDryRun = false;
+  size_t workers = 1;
+  bool unsorted = false;
 
   std::unique_ptr<FileMetadataFilter> metadataFilter;
   std::string filterExpression;
@@ -158,6 +172,7 @@ int main(int argc, char* argv[])
   scanSubcommand->add_flag("--no-files", noFiles,
                            "Don't print files, only directories");
   scanSubcommand->add_flag("--json", json, "Use json output");
+  addWorkerOptions(scanSubcommand, workers, unsorted);
   //----------------------------------------------------------------------------
   // Set-up print subcommand..
   //----------------------------------------------------------------------------
@@ -185,6 +200,7 @@ int main(int argc, char* argv[])
   bool printTime = false;
   stripediffSubcommand->add_flag("--time", printTime,
                                  "Print mtime and ctime of found files");
+  addWorkerOptions(stripediffSubcommand, workers, unsorted);
   //----------------------------------------------------------------------------
   // Set-up one-replica-layout subcommand..
   //----------------------------------------------------------------------------
@@ -200,6 +216,7 @@ int main(int argc, char* argv[])
                                        "Show full paths, if possible");
   oneReplicaLayoutSubcommand->add_flag("--filter-internal", filterInternal,
                                        "Filter internal entries, such as versioning, aborted atomic uploads, etc");
+  addWorkerOptions(oneReplicaLayoutSubcommand, workers, unsorted);
   //----------------------------------------------------------------------------
   // Set-up scan-dirs subcommand..
   //----------------------------------------------------------------------------
@@ -219,6 +236,7 @@ int main(int argc, char* argv[])
   scanDirsSubcommand->add_option("--count-threshold", countThreshold,
                                  "Only print containers which contain more than the specified number of items. Useful for detecting huge containers on which 'ls' might hang");
   scanDirsSubcommand->add_flag("--json", json, "Use json output");
+  addWorkerOptions(scanDirsSubcommand, workers, unsorted);
   //----------------------------------------------------------------------------
   // Set-up scan-files subcommand..
   //----------------------------------------------------------------------------
@@ -237,6 +255,7 @@ int main(int argc, char* argv[])
                                 "Only print files for which there is one or more unrecognized fsids in location vector.");
   scanFilesSubcommand->add_flag("--json", json, "Use json output");
   scanFilesSubcommand->add_option("--where", filterExpression, "Filter results using the given expression.\nNOTE: Filtering is done client side! All results still have to be streamed -- performance is the same.");
+  addWorkerOptions(scanFilesSubcommand, workers, unsorted);
 
   //----------------------------------------------------------------------------
   // Set-up scan-deathrow subcommand..
@@ -269,6 +288,7 @@ int main(int argc, char* argv[])
                                 "Find files and directories with invalid parents");
   addClusterOptions(checkOrphansSubcommand, membersStr, memberValidator, password,
                     passwordFile);
+  addWorkerOptions(checkOrphansSubcommand, workers, unsorted);
   //----------------------------------------------------------------------------
   // Set-up check-fsview-missing subcommand..
   //----------------------------------------------------------------------------
@@ -276,6 +296,7 @@ int main(int argc, char* argv[])
                                       "Check which FileMDs have locations / unlinked locations not present in the filesystem view");
   addClusterOptions(checkFsViewMissingSubcommand, membersStr, memberValidator,
                     password, passwordFile);
+  addWorkerOptions(checkFsViewMissingSubcommand, workers, unsorted);
   //----------------------------------------------------------------------------
   // Set-up check-fsview-extra subcommand..
   //----------------------------------------------------------------------------
@@ -486,6 +507,7 @@ int main(int argc, char* argv[])
   }
 
   inspector.setMetadataFilter(std::move(metadataFilter));
+  inspector.setWorkers(contactDetails, workers, !unsorted);
 
   //----------------------------------------------------------------------------
   // Dispatch subcommand
@@ -23,6 +23,7 @@
 #include "namespace/interface/IContainerMDSvc.hh"
 #include "namespace/interface/IFileMDSvc.hh"
 #include "namespace/ns_quarkdb/persistency/ContainerMDSvc.hh"
+#include "namespace/ns_quarkdb/persistency/MetadataFetcher.hh"
 #include "namespace/utils/PathProcessor.hh"
 #include <cerrno>
 #include <ctime>
@@ -42,7 +43,8 @@ EOSNSNAMESPACE_BEGIN
 //------------------------------------------------------------------------------
 QuarkHierarchicalView::QuarkHierarchicalView(qclient::QClient *qcl, MetadataFlusher *flusher)
   : pQcl(qcl), pQuotaFlusher(flusher), pContainerSvc(nullptr), pFileSvc(nullptr),
-    pQuotaStats(new QuarkQuotaStats(pQcl, pQuotaFlusher)), pRoot(nullptr)
+    pQuotaStats(new QuarkQuotaStats(pQcl, pQuotaFlusher)), pRoot(nullptr),
+    mPathCache(nullptr), mQuarkContSvc(nullptr), mLargeContainerThreshold(0)
 {
   pExecutor.reset(new folly::IOThreadPoolExecutor(32));
 }
@@ -93,6 +95,10 @@ void
 QuarkHierarchicalView::initialize1()
 {
   pContainerSvc->initialize();
+  QuarkContainerMDSvc* impl_cont_svc =
+    dynamic_cast<QuarkContainerMDSvc*>(pContainerSvc);
+  mPathCache = (impl_cont_svc ? &impl_cont_svc->getPathLookupCache() : nullptr);
+  mQuarkContSvc = impl_cont_svc;
 
   // Get root container
   try {
@@ -184,11 +190,53 @@ QuarkHierarchicalView::getItem(const std::string& uri, bool follow)
   //----------------------------------------------------------------------------
   std::deque<std::string> pendingChunks;
   eos::PathProcessor::insertChunksIntoDeque(pendingChunks, uri);
+  return getPathCached(std::move(pendingChunks), follow);
+}
+
+//------------------------------------------------------------------------------
+// Lookup the given path chunks, using the path lookup cache
+//------------------------------------------------------------------------------
+folly::Future<FileOrContainerMD>
+QuarkHierarchicalView::getPathCached(std::deque<std::string> chunks,
+                                     bool follow)
+{
   //----------------------------------------------------------------------------
   // Initial state: We're at "/", and have to look up all chunks.
   //----------------------------------------------------------------------------
   FileOrContainerMD initialState {nullptr, pRoot};
-  return getPathInternal(initialState, pendingChunks, follow, 0);
+  std::string path;
+
+  if (!mPathCache || !mPathCache->isEnabled() ||
+      !PathLookupCache::buildPath(chunks, path)) {
+    return getPathInternal(initialState, std::move(chunks), follow, 0);
+  }
+
+  PathLookupCache::Result cached = mPathCache->lookup(path);
+
+  if (cached.negative) {
+    return folly::makeFuture<FileOrContainerMD>(make_mdexception(ENOENT,
+           "No such file or directory"));
+  }
+
+  if (cached.depth == 0) {
+    return getPathInternal(initialState, std::move(chunks), follow, 0, "/");
+  }
+
+  //----------------------------------------------------------------------------
+  // Skip the chunks of the cached prefix, continue from its container.
+  //----------------------------------------------------------------------------
+  chunks.erase(chunks.begin(), chunks.begin() + cached.depth);
+  path.resize(cached.length);
+  folly::Future<IContainerMDPtr> fut = pContainerSvc->getContainerMDFut(
+                                         cached.id);
+
+  if (!fut.isReady() || fut.hasException()) {
+    return getPathDeferred(std::move(fut), std::move(chunks), follow, 0,
+                           std::move(path));
+  }
+
+  return getPathInternal(FileOrContainerMD {nullptr, std::move(fut).get()},
+                         std::move(chunks), follow, 0, std::move(path));
 }
 
 //------------------------------------------------------------------------------
@@ -205,7 +253,8 @@ static FileOrContainerMD toFileOrContainerMD(IContainerMDPtr ptr)
 folly::Future<FileOrContainerMD>
 QuarkHierarchicalView::getPathDeferred(folly::Future<FileOrContainerMD> fut,
                                   std::deque<std::string> pendingChunks,
-                                  bool follow, size_t expendedEffort)
+                                  bool follow, size_t expendedEffort,
+                                  std::string cachedPath)
 {
   //----------------------------------------------------------------------------
   // We're blocked on a network request. "Pause" execution of getPathInternal
@@ -216,7 +265,7 @@ QuarkHierarchicalView::getPathDeferred(folly::Future<FileOrContainerMD> fut,
   //----------------------------------------------------------------------------
   return fut.via(pExecutor.get())
          .thenValue(std::bind(&QuarkHierarchicalView::getPathInternal, this, _1, pendingChunks,
-                         follow, expendedEffort));
+                         follow, expendedEffort, cachedPath));
 }
 
 //------------------------------------------------------------------------------
@@ -225,7 +274,8 @@ QuarkHierarchicalView::getPathDeferred(folly::Future<FileOrContainerMD> fut,
 folly::Future<FileOrContainerMD>
 QuarkHierarchicalView::getPathDeferred(folly::Future<IContainerMDPtr> fut,
                                   std::deque<std::string> pendingChunks,
-                                  bool follow, size_t expendedEffort)
+                                  bool follow, size_t expendedEffort,
+                                  std::string cachedPath)
 {
   //----------------------------------------------------------------------------
   // Same as getPathDeferred taking FileOrContainerMD.
@@ -233,7 +283,7 @@ QuarkHierarchicalView::getPathDeferred(folly::Future<IContainerMDPtr> fut,
   return fut.via(pExecutor.get())
          .thenValue(toFileOrContainerMD)
          .thenValue(std::bind(&QuarkHierarchicalView::getPathInternal, this, _1, pendingChunks,
-                         follow, expendedEffort));
+                         follow, expendedEffort, cachedPath));
 }
 
 //------------------------------------------------------------------------------
@@ -242,7 +292,8 @@ QuarkHierarchicalView::getPathDeferred(folly::Future<IContainerMDPtr> fut,
 folly::Future<FileOrContainerMD>
 QuarkHierarchicalView::getPathInternal(FileOrContainerMD state,
                                   std::deque<std::string> pendingChunks,
-                                  bool follow, size_t expendedEffort)
+                                  bool follow, size_t expendedEffort,
+                                  std::string cachedPath)
 {
   //----------------------------------------------------------------------------
   // Our goal is to consume pendingChunks until it's empty.
@@ -291,11 +342,13 @@ QuarkHierarchicalView::getPathInternal(FileOrContainerMD state,
       //------------------------------------------------------------------------
       if (pendingChunks.front() == ".") {
         pendingChunks.pop_front();
+        cachedPath.clear();
         continue;
       }
 
       if (pendingChunks.front() == "..") {
         pendingChunks.pop_front();
+        cachedPath.clear();
         folly::Future<IContainerMDPtr> fut = pContainerSvc->getContainerMDFut(
                                                state.container->getParentId());
 
@@ -314,9 +367,17 @@ QuarkHierarchicalView::getPathInternal(FileOrContainerMD state,
       // Normal case: Our current state contains a container, and we're simply
       // looking up the next chunk.
       //------------------------------------------------------------------------
-      folly::Future<FileOrContainerMD> next = state.container->findItem(
-          pendingChunks.front());
+      std::string chunk = std::move(pendingChunks.front());
       pendingChunks.pop_front();
+      IContainerMD::id_t parentId = state.container->getId();
+      PathLookupCache::Token token;
+
+      if (!cachedPath.empty()) {
+        cachedPath = PathLookupCache::join(cachedPath, chunk);
+        token = mPathCache->getToken(parentId, chunk);
+      }
+
+      folly::Future<FileOrContainerMD> next = state.container->findItem(chunk);
 
       //------------------------------------------------------------------------
       // If we're lucky, the result is ready immediately. Update state, and
@@ -324,12 +385,26 @@ QuarkHierarchicalView::getPathInternal(FileOrContainerMD state,
       //------------------------------------------------------------------------
       if (next.isReady() && !next.hasException()) {
         state = std::move(next).get();
+
+        if (!cachedPath.empty()) {
+          cachePathItem(cachedPath, parentId, state, token);
+        }
+
         continue;
       } else {
         //----------------------------------------------------------------------
         // We're blocked, "pause" execution, unblock caller.
         //----------------------------------------------------------------------
-        return getPathDeferred(std::move(next), pendingChunks, follow, expendedEffort);
+        if (!cachedPath.empty()) {
+          next = std::move(next).thenValue([this, cachedPath, parentId,
+          token](FileOrContainerMD item) {
+            cachePathItem(cachedPath, parentId, item, token);
+            return item;
+          });
+        }
+
+        return getPathDeferred(std::move(next), pendingChunks, follow,
+                               expendedEffort, cachedPath);
       }
     }
 
@@ -340,7 +415,11 @@ QuarkHierarchicalView::getPathInternal(FileOrContainerMD state,
       //
       // 1. We've hit a symlink.
       // 2. Caller is drunk, and doing "ls /eos/dir1/file1/not/existing".
+      //
+      // Paths going through symlinks are not cached.
       //------------------------------------------------------------------------
+      cachedPath.clear();
+
       if (!state.file->isLink()) {
         return folly::makeFuture<FileOrContainerMD>(make_mdexception(ENOTDIR,
                "Not a directory"));
@@ -390,6 +469,112 @@ QuarkHierarchicalView::getPathInternal(FileOrContainerMD state,
   }
 }
 
+//------------------------------------------------------------------------------
+// Add the result of looking up a name to the path lookup cache
+//------------------------------------------------------------------------------
+void
+QuarkHierarchicalView::cachePathItem(const std::string& path,
+                                     IContainerMD::id_t parentId,
+                                     const FileOrContainerMD& item,
+                                     const PathLookupCache::Token& token)
+{
+  // Only containers and missing names are cached, files are looked up in
+  // their cached parent
+  if (item.container) {
+    mPathCache->insert(path, parentId, item.container->getId(), token);
+  } else if (!item.file) {
+    mPathCache->insert(path, parentId, 0, token);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Look up the last chunk of a path in a large container with point queries
+//------------------------------------------------------------------------------
+bool
+QuarkHierarchicalView::lookupInLargeContainer(const std::string& uri,
+    bool follow, FileOrContainerMD& item)
+{
+  if (!mLargeContainerThreshold || !mQuarkContSvc || !pQcl) {
+    return false;
+  }
+
+  std::deque<std::string> chunks;
+  eos::PathProcessor::insertChunksIntoDeque(chunks, uri);
+
+  if (chunks.size() < 2u) {
+    return false;
+  }
+
+  std::string name = std::move(chunks.back());
+  chunks.pop_back();
+  std::string parentName = std::move(chunks.back());
+  chunks.pop_back();
+
+  if ((name == ".") || (name == "..") || (parentName == ".") ||
+      (parentName == "..")) {
+    return false;
+  }
+
+  ContainerIdentifier parentId;
+
+  try {
+    IContainerMDPtr grandParent = getPathExpectContainer(chunks).get();
+    parentId = MetadataFetcher::getContainerIDFromName(*pQcl,
+               ContainerIdentifier(grandParent->getId()), parentName).get();
+  } catch (const MDException&) {
+    // Let the regular lookup handle e.g. symbolic links and report errors
+    return false;
+  }
+
+  //----------------------------------------------------------------------------
+  // A cached parent answers from memory, a small one is cheap to load.
+  //----------------------------------------------------------------------------
+  if (mQuarkContSvc->isContainerMDCached(parentId)) {
+    return false;
+  }
+
+  auto counts = MetadataFetcher::countContents(*pQcl, parentId);
+
+  if (std::move(counts.first).get() + std::move(counts.second).get() <
+      mLargeContainerThreshold) {
+    return false;
+  }
+
+  //----------------------------------------------------------------------------
+  // Files and subcontainers can't share a name, query both maps at once.
+  //----------------------------------------------------------------------------
+  folly::Future<FileIdentifier> fileFut =
+    MetadataFetcher::getFileIDFromName(*pQcl, parentId, name);
+  folly::Future<ContainerIdentifier> contFut =
+    MetadataFetcher::getContainerIDFromName(*pQcl, parentId, name);
+  item = FileOrContainerMD {nullptr, nullptr};
+
+  try {
+    item.file = pFileSvc->getFileMDFut(
+                  std::move(fileFut).get().getUnderlyingUInt64()).get();
+  } catch (const MDException& e) {
+    if (e.getErrno() != ENOENT) {
+      throw;
+    }
+  }
+
+  if (item.file) {
+    // A symbolic link to follow goes through the regular lookup
+    return !(follow && item.file->isLink());
+  }
+
+  try {
+    item.container = pContainerSvc->getContainerMDFut(
+                       std::move(contFut).get().getUnderlyingUInt64()).get();
+  } catch (const MDException& e) {
+    if (e.getErrno() != ENOENT) {
+      throw;
+    }
+  }
+
+  return true;
+}
+
 //------------------------------------------------------------------------------
 // Retrieve a file for given uri, asynchronously
 //------------------------------------------------------------------------------
@@ -406,6 +591,12 @@ std::shared_ptr<IFileMD>
 QuarkHierarchicalView::getFile(const std::string& uri, bool follow,
                           size_t* link_depths)
 {
+  FileOrContainerMD item;
+
+  if (lookupInLargeContainer(uri, follow, item)) {
+    return extractFileMD(item).get();
+  }
+
   return getFileFut(uri, follow).get();
 }
 
@@ -429,8 +620,7 @@ QuarkHierarchicalView::createFile(const std::string& uri, uid_t uid, gid_t gid,
 
   std::string lastChunk = chunks.back();
   chunks.pop_back();
-  FileOrContainerMD item = getPathInternal(FileOrContainerMD {nullptr, pRoot},
-                           chunks, true, 0).get();
+  FileOrContainerMD item = getPathCached(chunks, true).get();
 
   if (item.file) {
     throw_mdexception(ENOTDIR, "Not a directory");
@@ -572,6 +762,12 @@ IContainerMDPtr
 QuarkHierarchicalView::getContainer(const std::string& uri, bool follow,
                                size_t* link_depth)
 {
+  FileOrContainerMD item;
+
+  if (lookupInLargeContainer(uri, follow, item)) {
+    return extractContainerMD(item).get();
+  }
+
   return getContainerFut(uri, follow).get();
 }
 
@@ -682,8 +878,7 @@ QuarkHierarchicalView::getPathExpectContainer(const std::deque<std::string>& chu
     return pRoot;
   }
 
-  return getPathInternal(FileOrContainerMD {nullptr, pRoot}, chunks, true, 0)
-         .thenValue(extractContainerMD);
+  return getPathCached(chunks, true).thenValue(extractContainerMD);
 }
 
 //------------------------------------------------------------------------------
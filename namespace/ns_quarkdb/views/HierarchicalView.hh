@@ -28,6 +28,7 @@
 #include "namespace/interface/IContainerMDSvc.hh"
 #include "namespace/interface/IFileMDSvc.hh"
 #include "namespace/interface/IView.hh"
+#include "namespace/ns_quarkdb/PathLookupCache.hh"
 #include "namespace/ns_quarkdb/accounting/QuotaStats.hh"
 
 #ifdef __clang__
@@ -37,6 +38,7 @@
 EOSNSNAMESPACE_BEGIN
 
 class MetadataFlusher;
+class QuarkContainerMDSvc;
 
 //------------------------------------------------------------------------------
 //! Implementation of the hierarchical namespace
@@ -299,27 +301,68 @@ public:
   virtual folly::Future<IContainerMDPtr> getParentContainer(
     IFileMD *file) override;
 
+  //----------------------------------------------------------------------------
+  //! Set the number of entries from which a container which is not in the
+  //! cache is not loaded to look up one of its entries by name, 0 disables it
+  //----------------------------------------------------------------------------
+  void setLargeContainerThreshold(uint64_t threshold)
+  {
+    mLargeContainerThreshold = threshold;
+  }
+
 private:
+  //----------------------------------------------------------------------------
+  //! Lookup the given path chunks starting from the root, using the longest
+  //! prefix found in the path lookup cache.
+  //----------------------------------------------------------------------------
+  folly::Future<FileOrContainerMD>
+  getPathCached(std::deque<std::string> chunks, bool follow);
+
   //----------------------------------------------------------------------------
   //! Lookup a given path - internal function.
+  //!
+  //! @param cachedPath canonical path of the container in state, if the
+  //!        containers found below it are to be added to the path lookup
+  //!        cache, otherwise empty
   //----------------------------------------------------------------------------
   folly::Future<FileOrContainerMD>
   getPathInternal(FileOrContainerMD state, std::deque<std::string> pendingChunks,
-    bool follow, size_t expendedEffort);
+    bool follow, size_t expendedEffort, std::string cachedPath = "");
 
   //----------------------------------------------------------------------------
   //! Lookup a given path - deferred function.
   //----------------------------------------------------------------------------
   folly::Future<FileOrContainerMD>
   getPathDeferred(folly::Future<FileOrContainerMD> fut, std::deque<std::string> pendingChunks,
-    bool follow, size_t expendedEffort);
+    bool follow, size_t expendedEffort, std::string cachedPath = "");
 
   //----------------------------------------------------------------------------
   //! Lookup a given path - deferred function.
   //----------------------------------------------------------------------------
   folly::Future<FileOrContainerMD>
   getPathDeferred(folly::Future<IContainerMDPtr> fut, std::deque<std::string> pendingChunks,
-    bool follow, size_t expendedEffort);
+    bool follow, size_t expendedEffort, std::string cachedPath = "");
+
+  //----------------------------------------------------------------------------
+  //! Add the result of looking up a name to the path lookup cache
+  //----------------------------------------------------------------------------
+  void cachePathItem(const std::string& path, IContainerMD::id_t parentId,
+    const FileOrContainerMD& item, const PathLookupCache::Token& token);
+
+  //----------------------------------------------------------------------------
+  //! Look up the last chunk of the given path with point queries (HGET) if
+  //! its parent is a large container which is not in the cache, instead of
+  //! loading all the entries of the parent.
+  //!
+  //! @param uri path to look up
+  //! @param follow if true a symbolic link found as last chunk is followed
+  //! @param item found item, empty if no such entry exists
+  //!
+  //! @return true if the lookup was done, false if the path has to go through
+  //!         the regular lookup
+  //----------------------------------------------------------------------------
+  bool lookupInLargeContainer(const std::string& uri, bool follow,
+    FileOrContainerMD& item);
 
   //----------------------------------------------------------------------------
   //! Lookup a given path, expect a container there.
@@ -368,6 +411,10 @@ private:
   IQuotaStats* pQuotaStats;
   std::shared_ptr<IContainerMD> pRoot;
   std::unique_ptr<folly::Executor> pExecutor;
+  PathLookupCache* mPathCache; ///< Owned by the container service
+  QuarkContainerMDSvc* mQuarkContSvc; ///< Container service implementation
+  //! Min number of entries of a container looked up with point queries
+  uint64_t mLargeContainerThreshold;
 };
 
 EOSNSNAMESPACE_END
@@ -0,0 +1,280 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2021 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "namespace/utils/FileIdSet.hh"
+#include <algorithm>
+
+EOSNSNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+// Insert id
+//------------------------------------------------------------------------------
+bool
+FileIdSet::insert(uint64_t id)
+{
+  uint64_t key = id >> 16;
+  uint16_t low = id & 0xffff;
+  auto it = lowerBound(key);
+
+  if ((it == mChunks.end()) || (it->mKey != key)) {
+    it = mChunks.insert(it, Chunk{key, 0, {}, {}});
+  }
+
+  Chunk& chunk = *it;
+
+  if (chunk.isBitmap()) {
+    uint64_t& word = chunk.mBitmap[low >> 6];
+    uint64_t mask = 1ull << (low & 63);
+
+    if (word & mask) {
+      return false;
+    }
+
+    word |= mask;
+  } else {
+    auto pos = std::lower_bound(chunk.mArray.begin(), chunk.mArray.end(), low);
+
+    if ((pos != chunk.mArray.end()) && (*pos == low)) {
+      return false;
+    }
+
+    if (chunk.mArray.size() < kArrayMax) {
+      chunk.mArray.insert(pos, low);
+    } else {
+      toBitmap(chunk);
+      chunk.mBitmap[low >> 6] |= 1ull << (low & 63);
+    }
+  }
+
+  ++chunk.mCount;
+  ++mSize;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Erase id
+//------------------------------------------------------------------------------
+size_t
+FileIdSet::erase(uint64_t id)
+{
+  uint64_t key = id >> 16;
+  uint16_t low = id & 0xffff;
+  auto it = lowerBound(key);
+
+  if ((it == mChunks.end()) || (it->mKey != key)) {
+    return 0;
+  }
+
+  Chunk& chunk = *it;
+
+  if (chunk.isBitmap()) {
+    uint64_t& word = chunk.mBitmap[low >> 6];
+    uint64_t mask = 1ull << (low & 63);
+
+    if ((word & mask) == 0) {
+      return 0;
+    }
+
+    word &= ~mask;
+  } else {
+    auto pos = std::lower_bound(chunk.mArray.begin(), chunk.mArray.end(), low);
+
+    if ((pos == chunk.mArray.end()) || (*pos != low)) {
+      return 0;
+    }
+
+    chunk.mArray.erase(pos);
+  }
+
+  --chunk.mCount;
+  --mSize;
+
+  if (chunk.mCount == 0) {
+    mChunks.erase(it);
+  } else if (chunk.isBitmap() && (chunk.mCount < kArrayMin)) {
+    toArray(chunk);
+  }
+
+  return 1;
+}
+
+//------------------------------------------------------------------------------
+// Check whether the given id is in the set
+//------------------------------------------------------------------------------
+bool
+FileIdSet::contains(uint64_t id) const
+{
+  uint64_t key = id >> 16;
+  uint16_t low = id & 0xffff;
+  auto it = lowerBound(key);
+
+  if ((it == mChunks.end()) || (it->mKey != key)) {
+    return false;
+  }
+
+  if (it->isBitmap()) {
+    return (it->mBitmap[low >> 6] >> (low & 63)) & 1;
+  }
+
+  return std::binary_search(it->mArray.begin(), it->mArray.end(), low);
+}
+
+//------------------------------------------------------------------------------
+// Get the id with the given rank
+//------------------------------------------------------------------------------
+uint64_t
+FileIdSet::select(uint64_t rank) const
+{
+  for (const auto& chunk : mChunks) {
+    if (rank >= chunk.mCount) {
+      rank -= chunk.mCount;
+      continue;
+    }
+
+    if (!chunk.isBitmap()) {
+      return (chunk.mKey << 16) | chunk.mArray[rank];
+    }
+
+    for (uint32_t word = 0; word < kBitmapWords; ++word) {
+      uint64_t bits = chunk.mBitmap[word];
+      uint64_t count = __builtin_popcountll(bits);
+
+      if (rank >= count) {
+        rank -= count;
+        continue;
+      }
+
+      // Drop the lower set bits until the wanted one is the lowest
+      for (; rank > 0; --rank) {
+        bits &= bits - 1;
+      }
+
+      return (chunk.mKey << 16) | (word << 6) | __builtin_ctzll(bits);
+    }
+  }
+
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+// Drop all ids and release the memory
+//------------------------------------------------------------------------------
+void
+FileIdSet::clear()
+{
+  std::vector<Chunk>().swap(mChunks);
+  mSize = 0;
+}
+
+//------------------------------------------------------------------------------
+// Swap contents with another set
+//------------------------------------------------------------------------------
+void
+FileIdSet::swap(FileIdSet& other)
+{
+  mChunks.swap(other.mChunks);
+  std::swap(mSize, other.mSize);
+}
+
+//------------------------------------------------------------------------------
+// Release the spare capacity left over by inserts
+//------------------------------------------------------------------------------
+void
+FileIdSet::shrink()
+{
+  for (auto& chunk : mChunks) {
+    chunk.mArray.shrink_to_fit();
+  }
+
+  mChunks.shrink_to_fit();
+}
+
+//------------------------------------------------------------------------------
+// Get number of heap bytes used by the set
+//------------------------------------------------------------------------------
+size_t
+FileIdSet::getMemoryUsage() const
+{
+  size_t bytes = mChunks.capacity() * sizeof(Chunk);
+
+  for (const auto& chunk : mChunks) {
+    bytes += chunk.mArray.capacity() * sizeof(uint16_t);
+    bytes += chunk.mBitmap.capacity() * sizeof(uint64_t);
+  }
+
+  return bytes;
+}
+
+//------------------------------------------------------------------------------
+// Find the chunk with the given key, or the position where to insert it
+//------------------------------------------------------------------------------
+std::vector<FileIdSet::Chunk>::iterator
+FileIdSet::lowerBound(uint64_t key)
+{
+  // Sequential ids mostly hit the last chunk
+  if (!mChunks.empty() && (mChunks.back().mKey <= key)) {
+    return (mChunks.back().mKey == key) ? mChunks.end() - 1 : mChunks.end();
+  }
+
+  return std::lower_bound(mChunks.begin(), mChunks.end(), key,
+  [](const Chunk & chunk, uint64_t k) {
+    return chunk.mKey < k;
+  });
+}
+
+std::vector<FileIdSet::Chunk>::const_iterator
+FileIdSet::lowerBound(uint64_t key) const
+{
+  return const_cast<FileIdSet*>(this)->lowerBound(key);
+}
+
+//------------------------------------------------------------------------------
+// Convert an array chunk into a bitmap one
+//------------------------------------------------------------------------------
+void
+FileIdSet::toBitmap(Chunk& chunk)
+{
+  chunk.mBitmap.assign(kBitmapWords, 0);
+
+  for (uint16_t low : chunk.mArray) {
+    chunk.mBitmap[low >> 6] |= 1ull << (low & 63);
+  }
+
+  std::vector<uint16_t>().swap(chunk.mArray);
+}
+
+//------------------------------------------------------------------------------
+// Convert a bitmap chunk into an array one
+//------------------------------------------------------------------------------
+void
+FileIdSet::toArray(Chunk& chunk)
+{
+  std::vector<uint16_t> array;
+  array.reserve(chunk.mCount);
+
+  for (uint32_t word = 0; word < kBitmapWords; ++word) {
+    for (uint64_t bits = chunk.mBitmap[word]; bits != 0; bits &= bits - 1) {
+      array.push_back((word << 6) | __builtin_ctzll(bits));
+    }
+  }
+
+  chunk.mArray.swap(array);
+  std::vector<uint64_t>().swap(chunk.mBitmap);
+}
+
+EOSNSNAMESPACE_END
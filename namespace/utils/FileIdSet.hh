@@ -0,0 +1,263 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2021 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+//------------------------------------------------------------------------------
+//! @brief Compressed set of file ids
+//------------------------------------------------------------------------------
+
+#pragma once
+#include "namespace/Namespace.hh"
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
+EOSNSNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Sorted set of 64-bit ids laid out like a roaring bitmap. Ids are grouped
+//! in chunks by their upper 48 bits and each chunk stores the lower 16 bits
+//! either as a sorted array, while sparse, or as a 64 Kbit bitmap, once it
+//! holds more than kArrayMax ids. File ids are allocated sequentially so the
+//! replicas of a filesystem end up in dense chunks costing a bit or two
+//! bytes per id, compared to the 16 to 32 bytes per id of a hash set.
+//!
+//! Iteration is in ascending order. Not thread-safe, the owner is expected
+//! to provide the locking.
+//------------------------------------------------------------------------------
+class FileIdSet
+{
+public:
+  //! Max number of ids of a chunk stored as an array
+  static constexpr uint32_t kArrayMax = 4096;
+  //! Number of ids below which a bitmap chunk is turned back into an array
+  static constexpr uint32_t kArrayMin = 2048;
+
+private:
+  static constexpr uint32_t kBitmapWords = 1024;
+
+  //----------------------------------------------------------------------------
+  //! Ids sharing the upper 48 bits
+  //----------------------------------------------------------------------------
+  struct Chunk {
+    uint64_t mKey; ///< Upper 48 bits of the ids
+    uint32_t mCount; ///< Number of ids
+    std::vector<uint16_t> mArray; ///< Sorted lower bits, if not a bitmap
+    std::vector<uint64_t> mBitmap; ///< Empty, or kBitmapWords long
+
+    bool isBitmap() const
+    {
+      return !mBitmap.empty();
+    }
+  };
+
+public:
+  //----------------------------------------------------------------------------
+  //! Forward iterator going through the ids in ascending order
+  //----------------------------------------------------------------------------
+  class const_iterator
+  {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = uint64_t;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const uint64_t*;
+    using reference = uint64_t;
+
+    const_iterator() = default;
+
+    uint64_t operator*() const
+    {
+      return mValue;
+    }
+
+    const_iterator& operator++()
+    {
+      ++mPos;
+      seek();
+      return *this;
+    }
+
+    const_iterator operator++(int)
+    {
+      const_iterator tmp = *this;
+      ++(*this);
+      return tmp;
+    }
+
+    bool operator==(const const_iterator& other) const
+    {
+      return (mChunk == other.mChunk) && (mPos == other.mPos);
+    }
+
+    bool operator!=(const const_iterator& other) const
+    {
+      return !(*this == other);
+    }
+
+  private:
+    friend class FileIdSet;
+
+    const_iterator(const std::vector<Chunk>* chunks, size_t chunk)
+      : mChunks(chunks), mChunk(chunk)
+    {
+      seek();
+    }
+
+    //--------------------------------------------------------------------------
+    //! Move to the first id at or after the current position
+    //--------------------------------------------------------------------------
+    void seek();
+
+    const std::vector<Chunk>* mChunks = nullptr;
+    size_t mChunk = 0;
+    uint32_t mPos = 0; ///< Array index or bit number in the current chunk
+    uint64_t mValue = 0;
+  };
+
+  //----------------------------------------------------------------------------
+  //! Insert id
+  //!
+  //! @return true if inserted, false if already present
+  //----------------------------------------------------------------------------
+  bool insert(uint64_t id);
+
+  //----------------------------------------------------------------------------
+  //! Erase id
+  //!
+  //! @return number of ids erased i.e. 0 or 1
+  //----------------------------------------------------------------------------
+  size_t erase(uint64_t id);
+
+  //----------------------------------------------------------------------------
+  //! Check whether the given id is in the set
+  //----------------------------------------------------------------------------
+  bool contains(uint64_t id) const;
+
+  //----------------------------------------------------------------------------
+  //! Get the id with the given rank i.e. position in ascending order
+  //!
+  //! @param rank position, must be smaller than size()
+  //----------------------------------------------------------------------------
+  uint64_t select(uint64_t rank) const;
+
+  //----------------------------------------------------------------------------
+  //! Get number of ids
+  //----------------------------------------------------------------------------
+  size_t size() const
+  {
+    return mSize;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Check whether the set is empty
+  //----------------------------------------------------------------------------
+  bool empty() const
+  {
+    return (mSize == 0);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Drop all ids and release the memory
+  //----------------------------------------------------------------------------
+  void clear();
+
+  //----------------------------------------------------------------------------
+  //! Swap contents with another set
+  //----------------------------------------------------------------------------
+  void swap(FileIdSet& other);
+
+  //----------------------------------------------------------------------------
+  //! Release the spare capacity left over by inserts, meant to be called
+  //! once after a bulk load
+  //----------------------------------------------------------------------------
+  void shrink();
+
+  //----------------------------------------------------------------------------
+  //! Get number of heap bytes used by the set
+  //----------------------------------------------------------------------------
+  size_t getMemoryUsage() const;
+
+  const_iterator begin() const
+  {
+    return const_iterator(&mChunks, 0);
+  }
+
+  const_iterator end() const
+  {
+    return const_iterator(&mChunks, mChunks.size());
+  }
+
+private:
+  //----------------------------------------------------------------------------
+  //! Find the chunk with the given key, or the position where to insert it
+  //----------------------------------------------------------------------------
+  std::vector<Chunk>::iterator lowerBound(uint64_t key);
+  std::vector<Chunk>::const_iterator lowerBound(uint64_t key) const;
+
+  //----------------------------------------------------------------------------
+  //! Convert an array chunk into a bitmap one and vice versa
+  //----------------------------------------------------------------------------
+  static void toBitmap(Chunk& chunk);
+  static void toArray(Chunk& chunk);
+
+  std::vector<Chunk> mChunks; ///< Sorted by key
+  size_t mSize = 0;
+};
+
+//------------------------------------------------------------------------------
+// Move to the first id at or after the current position
+//------------------------------------------------------------------------------
+inline void
+FileIdSet::const_iterator::seek()
+{
+  while (mChunk < mChunks->size()) {
+    const Chunk& chunk = (*mChunks)[mChunk];
+
+    if (!chunk.isBitmap()) {
+      if (mPos < chunk.mArray.size()) {
+        mValue = (chunk.mKey << 16) | chunk.mArray[mPos];
+        return;
+      }
+    } else {
+      uint32_t word = mPos >> 6;
+
+      if (word < kBitmapWords) {
+        // Mask out the bits before the current position
+        uint64_t bits = chunk.mBitmap[word] & (~0ull << (mPos & 63));
+
+        while ((bits == 0) && (++word < kBitmapWords)) {
+          bits = chunk.mBitmap[word];
+        }
+
+        if (bits != 0) {
+          mPos = (word << 6) | __builtin_ctzll(bits);
+          mValue = (chunk.mKey << 16) | mPos;
+          return;
+        }
+      }
+    }
+
+    ++mChunk;
+    mPos = 0;
+  }
+
+  mPos = 0;
+}
+
+EOSNSNAMESPACE_END
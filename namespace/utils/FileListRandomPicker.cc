@@ -57,4 +57,17 @@ bool pickRandomFile(const IFsView::FileList &filelist, eos::IFileMD::id_t &retva
   }
 }
 
+bool pickRandomFile(const FileIdSet &filelist, eos::IFileMD::id_t &retval) {
+  if(filelist.empty()) {
+    return false;
+  }
+
+  std::uniform_int_distribution<uint64_t> distribution(0, filelist.size() - 1);
+  std::unique_lock<std::mutex> lock(generatorMtx);
+  uint64_t rank = distribution(generator);
+  lock.unlock();
+  retval = filelist.select(rank);
+  return true;
+}
+
 EOSNSNAMESPACE_END
@@ -22,9 +22,12 @@
 //------------------------------------------------------------------------------
 
 #include "namespace/Namespace.hh"
+#include "namespace/utils/FileIdSet.hh"
 
 EOSNSNAMESPACE_BEGIN
 
 bool pickRandomFile(const IFsView::FileList &filelist, eos::IFileMD::id_t &retval);
 
+bool pickRandomFile(const FileIdSet &filelist, eos::IFileMD::id_t &retval);
+
 EOSNSNAMESPACE_END
@@ -0,0 +1,123 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2021 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "namespace/utils/HierarchicalLockManager.hh"
+#include <algorithm>
+#include <map>
+
+EOSNSNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+// Move constructor
+//------------------------------------------------------------------------------
+HierarchicalLockManager::PathLock::PathLock(PathLock&& other) noexcept
+  : mHeld(std::move(other.mHeld))
+{
+  other.mHeld.clear();
+}
+
+//------------------------------------------------------------------------------
+// Move assignment
+//------------------------------------------------------------------------------
+HierarchicalLockManager::PathLock&
+HierarchicalLockManager::PathLock::operator=(PathLock&& other) noexcept
+{
+  if (this != &other) {
+    release();
+    mHeld = std::move(other.mHeld);
+    other.mHeld.clear();
+  }
+
+  return *this;
+}
+
+//------------------------------------------------------------------------------
+// Release all held locks
+//------------------------------------------------------------------------------
+void
+HierarchicalLockManager::PathLock::release()
+{
+  for (auto it = mHeld.rbegin(); it != mHeld.rend(); ++it) {
+    if (it->write) {
+      it->mtx->unlock();
+    } else {
+      it->mtx->unlock_shared();
+    }
+  }
+
+  mHeld.clear();
+}
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+HierarchicalLockManager::HierarchicalLockManager(size_t shard_bits)
+  : mStripes(1ull << shard_bits), mMask((1ull << shard_bits) - 1)
+{}
+
+//------------------------------------------------------------------------------
+// Get the stripe index for the given id
+//------------------------------------------------------------------------------
+size_t
+HierarchicalLockManager::getStripe(uint64_t id) const
+{
+  // Fibonacci hashing - consecutive ids (siblings created one after the
+  // other) end up on different stripes
+  return ((id * 11400714819323198485ull) >> 32) & mMask;
+}
+
+//------------------------------------------------------------------------------
+// Lock a set of ids
+//------------------------------------------------------------------------------
+HierarchicalLockManager::PathLock
+HierarchicalLockManager::lock(const std::vector<uint64_t>& read_ids,
+                              const std::vector<uint64_t>& write_ids)
+{
+  // Stripe index to exclusive flag, ordered by stripe index
+  std::map<size_t, bool> stripes;
+
+  for (const auto id : read_ids) {
+    stripes.emplace(getStripe(id), false);
+  }
+
+  for (const auto id : write_ids) {
+    stripes[getStripe(id)] = true;
+  }
+
+  PathLock plock;
+  plock.mHeld.reserve(stripes.size());
+
+  for (const auto& elem : stripes) {
+    std::shared_timed_mutex* mtx = &mStripes[elem.first].mtx;
+
+    if (elem.second) {
+      if (!mtx->try_lock()) {
+        mNumContended.fetch_add(1, std::memory_order_relaxed);
+        mtx->lock();
+      }
+    } else {
+      mtx->lock_shared();
+    }
+
+    plock.mHeld.push_back({mtx, elem.second});
+  }
+
+  return plock;
+}
+
+EOSNSNAMESPACE_END
@@ -0,0 +1,156 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2021 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+//------------------------------------------------------------------------------
+//! @brief Fine-grained, id-keyed lock manager for namespace containers
+//------------------------------------------------------------------------------
+
+#pragma once
+#include "namespace/Namespace.hh"
+#include <atomic>
+#include <cstdint>
+#include <shared_mutex>
+#include <vector>
+
+EOSNSNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Lock manager handing out read/write locks keyed by container (or file) id.
+//!
+//! Ids are mapped onto a fixed array of lock stripes. A caller describes the
+//! whole set of ids it needs - typically read locks on every component of a
+//! path, from the root down, and write locks only on the containers it
+//! modifies - and the manager acquires the corresponding stripes in ascending
+//! stripe order. Since every caller uses the same global order, any mix of
+//! path locks is deadlock free, which also covers the parent-then-child
+//! ordering of a path walk. If the same stripe is requested both for reading
+//! and writing, the write lock wins.
+//------------------------------------------------------------------------------
+class HierarchicalLockManager
+{
+public:
+  //----------------------------------------------------------------------------
+  //! RAII object holding a set of stripe locks, released on destruction
+  //----------------------------------------------------------------------------
+  class PathLock
+  {
+  public:
+    PathLock() = default;
+    PathLock(PathLock&& other) noexcept;
+    PathLock& operator=(PathLock&& other) noexcept;
+    PathLock(const PathLock&) = delete;
+    PathLock& operator=(const PathLock&) = delete;
+
+    //--------------------------------------------------------------------------
+    //! Destructor - releases all held locks
+    //--------------------------------------------------------------------------
+    ~PathLock()
+    {
+      release();
+    }
+
+    //--------------------------------------------------------------------------
+    //! Release all held locks, can be called multiple times
+    //--------------------------------------------------------------------------
+    void release();
+
+    //--------------------------------------------------------------------------
+    //! Number of stripes currently held
+    //--------------------------------------------------------------------------
+    size_t size() const
+    {
+      return mHeld.size();
+    }
+
+  private:
+    friend class HierarchicalLockManager;
+
+    struct Held {
+      std::shared_timed_mutex* mtx;
+      bool write;
+    };
+
+    //! Locks in acquisition order, released in reverse order
+    std::vector<Held> mHeld;
+  };
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param shard_bits log2 of the number of lock stripes
+  //----------------------------------------------------------------------------
+  explicit HierarchicalLockManager(size_t shard_bits = 12);
+
+  //----------------------------------------------------------------------------
+  //! Lock a set of ids
+  //!
+  //! @param read_ids ids to be locked in shared mode e.g. path components
+  //! @param write_ids ids to be locked in exclusive mode e.g. the parent
+  //!        container which is modified
+  //!
+  //! @return RAII object holding the locks
+  //----------------------------------------------------------------------------
+  PathLock lock(const std::vector<uint64_t>& read_ids,
+                const std::vector<uint64_t>& write_ids);
+
+  //----------------------------------------------------------------------------
+  //! Convenience helpers for a single id
+  //----------------------------------------------------------------------------
+  PathLock readLock(uint64_t id)
+  {
+    return lock({id}, {});
+  }
+
+  PathLock writeLock(uint64_t id)
+  {
+    return lock({}, {id});
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get number of lock stripes
+  //----------------------------------------------------------------------------
+  size_t getNumStripes() const
+  {
+    return mStripes.size();
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get the stripe index for the given id
+  //----------------------------------------------------------------------------
+  size_t getStripe(uint64_t id) const;
+
+  //----------------------------------------------------------------------------
+  //! Get number of exclusive acquisitions which had to wait for the stripe
+  //----------------------------------------------------------------------------
+  uint64_t getNumContended() const
+  {
+    return mNumContended.load(std::memory_order_relaxed);
+  }
+
+private:
+  //! Stripe padded to a cache line to avoid false sharing between neighbours
+  struct alignas(64) Stripe {
+    std::shared_timed_mutex mtx;
+  };
+
+  std::vector<Stripe> mStripes;
+  uint64_t mMask;
+  std::atomic<uint64_t> mNumContended {0};
+};
+
+EOSNSNAMESPACE_END
@@ -0,0 +1,244 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2021 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+//------------------------------------------------------------------------------
+//! @brief Vector of trivially copyable elements with inline storage
+//------------------------------------------------------------------------------
+
+#pragma once
+#include "namespace/Namespace.hh"
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+EOSNSNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Vector keeping up to N elements inside the object itself and only moving
+//! them to the heap when it grows beyond that. Meant for short lists which
+//! are stored in very large numbers, e.g. the locations of a file, where a
+//! std::vector would cost an extra allocation per object.
+//------------------------------------------------------------------------------
+template <typename T, uint32_t N>
+class InlineVector
+{
+  static_assert(std::is_trivially_copyable<T>::value,
+                "InlineVector only supports trivially copyable types");
+  static_assert(N > 0, "InlineVector needs some inline capacity");
+
+public:
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //----------------------------------------------------------------------------
+  InlineVector():
+    mSize(0), mCapacity(N)
+  {}
+
+  //----------------------------------------------------------------------------
+  //! Destructor
+  //----------------------------------------------------------------------------
+  ~InlineVector()
+  {
+    release();
+  }
+
+  //----------------------------------------------------------------------------
+  //! Copy constructor
+  //----------------------------------------------------------------------------
+  InlineVector(const InlineVector& other):
+    InlineVector()
+  {
+    assign(other.begin(), other.end());
+  }
+
+  //----------------------------------------------------------------------------
+  //! Copy assignment
+  //----------------------------------------------------------------------------
+  InlineVector& operator=(const InlineVector& other)
+  {
+    if (this != &other) {
+      assign(other.begin(), other.end());
+    }
+
+    return *this;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Move constructor
+  //----------------------------------------------------------------------------
+  InlineVector(InlineVector&& other) noexcept:
+    InlineVector()
+  {
+    *this = std::move(other);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Move assignment
+  //----------------------------------------------------------------------------
+  InlineVector& operator=(InlineVector&& other) noexcept
+  {
+    if (this != &other) {
+      release();
+
+      if (other.isInline()) {
+        memcpy(mInline, other.mInline, other.mSize * sizeof(T));
+      } else {
+        mHeap = other.mHeap;
+      }
+
+      mSize = other.mSize;
+      mCapacity = other.mCapacity;
+      other.mSize = 0;
+      other.mCapacity = N;
+    }
+
+    return *this;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Replace content with the given range
+  //----------------------------------------------------------------------------
+  template <typename Iterator>
+  void assign(Iterator first, Iterator last)
+  {
+    clear();
+
+    for (; first != last; ++first) {
+      push_back(*first);
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  //! Number of elements
+  //----------------------------------------------------------------------------
+  uint32_t size() const
+  {
+    return mSize;
+  }
+
+  bool empty() const
+  {
+    return (mSize == 0);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Element access
+  //----------------------------------------------------------------------------
+  const T& operator[](uint32_t idx) const
+  {
+    return data()[idx];
+  }
+
+  T* begin()
+  {
+    return data();
+  }
+
+  T* end()
+  {
+    return data() + mSize;
+  }
+
+  const T* begin() const
+  {
+    return data();
+  }
+
+  const T* end() const
+  {
+    return data() + mSize;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Append element
+  //----------------------------------------------------------------------------
+  void push_back(const T& value)
+  {
+    if (mSize == mCapacity) {
+      grow();
+    }
+
+    data()[mSize++] = value;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Remove element, keeping the order of the remaining ones
+  //!
+  //! @return iterator to the element following the removed one
+  //----------------------------------------------------------------------------
+  T* erase(T* pos)
+  {
+    memmove(pos, pos + 1, (end() - pos - 1) * sizeof(T));
+    --mSize;
+    return pos;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Remove all elements and give back heap memory
+  //----------------------------------------------------------------------------
+  void clear()
+  {
+    release();
+    mSize = 0;
+    mCapacity = N;
+  }
+
+private:
+  bool isInline() const
+  {
+    return (mCapacity == N);
+  }
+
+  T* data()
+  {
+    return isInline() ? mInline : mHeap;
+  }
+
+  const T* data() const
+  {
+    return isInline() ? mInline : mHeap;
+  }
+
+  void grow()
+  {
+    uint32_t capacity = 2 * mCapacity;
+    T* heap = new T[capacity];
+    memcpy(heap, data(), mSize * sizeof(T));
+    release();
+    mHeap = heap;
+    mCapacity = capacity;
+  }
+
+  void release()
+  {
+    if (!isInline()) {
+      delete[] mHeap;
+    }
+  }
+
+  union {
+    T mInline[N];
+    T* mHeap;
+  };
+
+  uint32_t mSize; ///< Number of elements
+  uint32_t mCapacity; ///< N while the elements are stored inline
+};
+
+EOSNSNAMESPACE_END
@@ -0,0 +1,174 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2021 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+//------------------------------------------------------------------------------
+//! @brief Fixed number of strings stored in a single allocation
+//------------------------------------------------------------------------------
+
+#pragma once
+#include "namespace/Namespace.hh"
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+
+EOSNSNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Holds N strings in one heap block made of the N lengths followed by the
+//! concatenated characters. Compared to N std::string members this costs a
+//! single pointer per object and one allocation for all the strings. Setting
+//! a string rebuilds the block, so it's meant for rarely modified values
+//! like names.
+//------------------------------------------------------------------------------
+template <uint32_t N>
+class PackedStrings
+{
+public:
+  PackedStrings() = default;
+  PackedStrings(PackedStrings&& other) noexcept = default;
+  PackedStrings& operator=(PackedStrings&& other) noexcept = default;
+
+  //----------------------------------------------------------------------------
+  //! Copy constructor
+  //----------------------------------------------------------------------------
+  PackedStrings(const PackedStrings& other)
+  {
+    *this = other;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Copy assignment
+  //----------------------------------------------------------------------------
+  PackedStrings& operator=(const PackedStrings& other)
+  {
+    if (this != &other) {
+      if (other.mBlock) {
+        size_t sz = other.blockSize();
+        mBlock.reset(new char[sz]);
+        memcpy(mBlock.get(), other.mBlock.get(), sz);
+      } else {
+        mBlock.reset();
+      }
+    }
+
+    return *this;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get length of the given string
+  //----------------------------------------------------------------------------
+  uint32_t length(uint32_t idx) const
+  {
+    return mBlock ? lengths()[idx] : 0;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get pointer to the characters of the given string, valid until the next
+  //! modification
+  //----------------------------------------------------------------------------
+  const char* data(uint32_t idx) const
+  {
+    if (!mBlock) {
+      return "";
+    }
+
+    const char* ptr = mBlock.get() + N * sizeof(uint32_t);
+
+    for (uint32_t i = 0; i < idx; ++i) {
+      ptr += lengths()[i];
+    }
+
+    return ptr;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get copy of the given string
+  //----------------------------------------------------------------------------
+  std::string get(uint32_t idx) const
+  {
+    return std::string(data(idx), length(idx));
+  }
+
+  //----------------------------------------------------------------------------
+  //! Set the given string
+  //----------------------------------------------------------------------------
+  void set(uint32_t idx, const char* value, size_t len)
+  {
+    uint32_t lens[N];
+    size_t total = 0;
+
+    for (uint32_t i = 0; i < N; ++i) {
+      lens[i] = (i == idx) ? len : length(i);
+      total += lens[i];
+    }
+
+    if (total == 0) {
+      mBlock.reset();
+      return;
+    }
+
+    std::unique_ptr<char[]> block(new char[N * sizeof(uint32_t) + total]);
+    memcpy(block.get(), lens, sizeof(lens));
+    char* ptr = block.get() + N * sizeof(uint32_t);
+
+    for (uint32_t i = 0; i < N; ++i) {
+      if (lens[i]) {
+        memcpy(ptr, (i == idx) ? value : data(i), lens[i]);
+        ptr += lens[i];
+      }
+    }
+
+    mBlock = std::move(block);
+  }
+
+  void set(uint32_t idx, const std::string& value)
+  {
+    set(idx, value.data(), value.size());
+  }
+
+  //----------------------------------------------------------------------------
+  //! Clear all strings
+  //----------------------------------------------------------------------------
+  void clear()
+  {
+    mBlock.reset();
+  }
+
+private:
+  const uint32_t* lengths() const
+  {
+    return reinterpret_cast<const uint32_t*>(mBlock.get());
+  }
+
+  size_t blockSize() const
+  {
+    size_t sz = N * sizeof(uint32_t);
+
+    for (uint32_t i = 0; i < N; ++i) {
+      sz += lengths()[i];
+    }
+
+    return sz;
+  }
+
+  //! Lengths followed by the characters, null if all strings are empty
+  std::unique_ptr<char[]> mBlock;
+};
+
+EOSNSNAMESPACE_END
@@ -0,0 +1,115 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2021 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+//------------------------------------------------------------------------------
+//! @brief Sequence lock for optimistic reads of small groups of fields
+//------------------------------------------------------------------------------
+
+#pragma once
+#include "namespace/Namespace.hh"
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+EOSNSNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Sequence lock: writers, which have to be serialized by some other means,
+//! make the counter odd while they modify the protected fields. Readers never
+//! write to shared memory, they read the fields and retry if the counter
+//! changed in the meantime. The protected fields must be std::atomic and
+//! accessed with relaxed ordering, the fences are provided by this class.
+//------------------------------------------------------------------------------
+class SeqLock
+{
+public:
+  //----------------------------------------------------------------------------
+  //! RAII helper marking a write section
+  //----------------------------------------------------------------------------
+  class WriteGuard
+  {
+  public:
+    explicit WriteGuard(SeqLock& lock):
+      mLock(lock)
+    {
+      mLock.beginWrite();
+    }
+
+    ~WriteGuard()
+    {
+      mLock.endWrite();
+    }
+
+    WriteGuard(const WriteGuard&) = delete;
+    WriteGuard& operator=(const WriteGuard&) = delete;
+
+  private:
+    SeqLock& mLock;
+  };
+
+  //----------------------------------------------------------------------------
+  //! Run the given reader until it observes a consistent state
+  //!
+  //! @param reader callable loading the protected fields
+  //!
+  //! @return value returned by the last run of the reader
+  //----------------------------------------------------------------------------
+  template <typename Reader>
+  auto read(Reader&& reader) const -> decltype(reader())
+  {
+    while (true) {
+      uint32_t seq = mSeq.load(std::memory_order_acquire);
+
+      if (seq & 1) {
+        std::this_thread::yield();
+        continue;
+      }
+
+      auto value = reader();
+      std::atomic_thread_fence(std::memory_order_acquire);
+
+      if (mSeq.load(std::memory_order_relaxed) == seq) {
+        return value;
+      }
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  //! Start write section, writers must be serialized by the caller
+  //----------------------------------------------------------------------------
+  void beginWrite()
+  {
+    mSeq.store(mSeq.load(std::memory_order_relaxed) + 1,
+               std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+  }
+
+  //----------------------------------------------------------------------------
+  //! End write section
+  //----------------------------------------------------------------------------
+  void endWrite()
+  {
+    mSeq.store(mSeq.load(std::memory_order_relaxed) + 1,
+               std::memory_order_release);
+  }
+
+private:
+  std::atomic<uint32_t> mSeq {0}; ///< Odd while a write is in progress
+};
+
+EOSNSNAMESPACE_END
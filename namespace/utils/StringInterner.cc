@@ -0,0 +1,79 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2021 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "namespace/utils/StringInterner.hh"
+
+EOSNSNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+StringInterner::StringInterner(size_t capacity):
+  mShardCapacity((capacity + kNumShards - 1) / kNumShards)
+{}
+
+//------------------------------------------------------------------------------
+// Get shared copy of the given string
+//------------------------------------------------------------------------------
+StringInterner::Ptr
+StringInterner::intern(const std::string& value)
+{
+  Shard& shard = mShards[std::hash<std::string>()(value) % kNumShards];
+  std::lock_guard<std::mutex> lock(shard.mMutex);
+  auto it = shard.mStrings.find(value);
+
+  if (it != shard.mStrings.end()) {
+    return it->second;
+  }
+
+  Ptr ptr = std::make_shared<const std::string>(value);
+
+  if (shard.mStrings.size() < mShardCapacity) {
+    shard.mStrings.emplace(value, ptr);
+  }
+
+  return ptr;
+}
+
+//------------------------------------------------------------------------------
+// Get number of strings in the pool
+//------------------------------------------------------------------------------
+size_t
+StringInterner::size() const
+{
+  size_t total = 0;
+
+  for (const auto& shard : mShards) {
+    std::lock_guard<std::mutex> lock(shard.mMutex);
+    total += shard.mStrings.size();
+  }
+
+  return total;
+}
+
+//------------------------------------------------------------------------------
+// Pool used for the extended attribute names of the metadata objects
+//------------------------------------------------------------------------------
+StringInterner&
+StringInterner::attributeNames()
+{
+  static StringInterner sInterner(65536);
+  return sInterner;
+}
+
+EOSNSNAMESPACE_END
@@ -0,0 +1,78 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2021 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+//------------------------------------------------------------------------------
+//! @brief Bounded pool of shared immutable strings
+//------------------------------------------------------------------------------
+
+#pragma once
+#include "namespace/Namespace.hh"
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+EOSNSNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Pool handing out one shared copy per distinct string. Used for values
+//! which repeat across millions of metadata objects, like extended attribute
+//! names. Once the pool reaches its capacity new strings are no longer
+//! remembered and simply get their own copy, so a workload with unique keys
+//! can not make it grow without bounds.
+//------------------------------------------------------------------------------
+class StringInterner
+{
+public:
+  using Ptr = std::shared_ptr<const std::string>;
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param capacity maximum number of strings kept in the pool
+  //----------------------------------------------------------------------------
+  explicit StringInterner(size_t capacity);
+
+  //----------------------------------------------------------------------------
+  //! Get shared copy of the given string
+  //----------------------------------------------------------------------------
+  Ptr intern(const std::string& value);
+
+  //----------------------------------------------------------------------------
+  //! Get number of strings in the pool
+  //----------------------------------------------------------------------------
+  size_t size() const;
+
+  //----------------------------------------------------------------------------
+  //! Pool used for the extended attribute names of the metadata objects
+  //----------------------------------------------------------------------------
+  static StringInterner& attributeNames();
+
+private:
+  static constexpr size_t kNumShards = 16;
+
+  struct Shard {
+    mutable std::mutex mMutex;
+    std::unordered_map<std::string, Ptr> mStrings;
+  };
+
+  size_t mShardCapacity; ///< Maximum number of strings per shard
+  Shard mShards[kNumShards];
+};
+
+EOSNSNAMESPACE_END
@@ -30,16 +30,127 @@
 #include "common/Timing.hh"
 #include "common/StringConversion.hh"
 #include "fst/checksum/ChecksumPlugins.hh"
+#include "fst/checksum/ChecksumKernels.hh"
 /*-----------------------------------------------------------------------------*/
 #include <XrdPosix/XrdPosixXrootd.hh>
 #include <XrdOuc/XrdOucString.hh>
 /*-----------------------------------------------------------------------------*/
+#include <chrono>
+#include <unistd.h>
+#if defined(__x86_64__)
+#include <x86intrin.h>
+#endif
+/*-----------------------------------------------------------------------------*/
 
 XrdPosixXrootd posixXrootd;
 
 // 1GB mem buffer
 #define MEMORYBUFFERSIZE 256ll*1024ll*1024ll
 
+//------------------------------------------------------------------------------
+// Read the CPU cycle counter, nanoseconds on platforms without one
+//------------------------------------------------------------------------------
+static inline uint64_t
+GetCycles()
+{
+#if defined(__x86_64__)
+  return __rdtsc();
+#else
+  return std::chrono::duration_cast<std::chrono::nanoseconds>
+         (std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+//------------------------------------------------------------------------------
+// Measure the bytes/cycle of each file checksum combined with a block
+// checksum, once with separate passes over every write buffer and once with
+// the fused single pass
+//------------------------------------------------------------------------------
+static void
+BenchmarkCombinations(const char* buffer)
+{
+  std::vector<std::pair<std::string, unsigned long>> file_xs {
+    {"adler32", eos::common::LayoutId::kAdler},
+    {"crc32c", eos::common::LayoutId::kCRC32C},
+    {"md5", eos::common::LayoutId::kMD5},
+    {"xxhash64", eos::common::LayoutId::kXXHASH64}
+  };
+  std::vector<std::pair<std::string, unsigned long>> block_xs {
+    {"adler32", eos::common::LayoutId::kAdler},
+    {"crc32c", eos::common::LayoutId::kCRC32C}
+  };
+  const size_t block_sz = 4096;
+  std::string map_path = "/tmp/eoschecksumbenchmark.";
+  map_path += std::to_string(getpid());
+  map_path += ".xsmap";
+  eos_static_info("checksum kernels %s",
+                  eos::fst::GetChecksumKernelImplementation());
+
+  for (size_t write_sz : {
+         1024 * 1024, 4 * 1024 * 1024
+       }) {
+    for (const auto& bxs : block_xs) {
+      for (const auto& fxs : file_xs) {
+        uint64_t cycles[2] = {0, 0};
+        std::string hex[2];
+
+        for (int fused = 0; fused < 2; ++fused) {
+          std::unique_ptr<eos::fst::CheckSum> block(
+            eos::fst::ChecksumPlugins::GetXsObj(bxs.second));
+          std::unique_ptr<eos::fst::CheckSum> file(
+            eos::fst::ChecksumPlugins::GetXsObj(fxs.second));
+
+          if (!block || !file) {
+            break;
+          }
+
+          if (!block->OpenMap(map_path.c_str(), MEMORYBUFFERSIZE, block_sz, true)) {
+            eos_static_err("failed to open block checksum map %s", map_path.c_str());
+            return;
+          }
+
+          uint64_t start = GetCycles();
+
+          for (off_t offset = 0; offset < MEMORYBUFFERSIZE; offset += write_sz) {
+            if (fused) {
+              block->AddBlockSum(offset, buffer + offset, write_sz, file.get());
+            } else {
+              block->AddBlockSum(offset, buffer + offset, write_sz);
+              file->Add(buffer + offset, write_sz, offset);
+            }
+          }
+
+          file->Finalize();
+          cycles[fused] = std::max<uint64_t>(1, GetCycles() - start);
+          hex[fused] = file->GetHexChecksum();
+          block->CloseMap();
+          (void) unlink(map_path.c_str());
+        }
+
+        if (!cycles[0] || !cycles[1]) {
+          eos_static_err("failed to get checksum algorithm %s or %s",
+                         fxs.first.c_str(), bxs.first.c_str());
+          continue;
+        }
+
+        if (hex[0] != hex[1]) {
+          eos_static_err("fused checksum differs %s != %s", hex[0].c_str(),
+                         hex[1].c_str());
+        }
+
+        XrdOucString sizestring;
+        eos::common::StringConversion::GetReadableSizeString(sizestring, write_sz,
+            "B");
+        eos_static_info("checksum( %-10s + blockxs %-10s ) write=%s "
+                        "separate=%.03f [B/cycle] fused=%.03f [B/cycle]",
+                        fxs.first.c_str(), bxs.first.c_str(), sizestring.c_str(),
+                        1.0 * MEMORYBUFFERSIZE / cycles[0],
+                        1.0 * MEMORYBUFFERSIZE / cycles[1]);
+      }
+    }
+  }
+}
+
 int main(int argc, char* argv[])
 {
   eos::common::VirtualIdentity vid = eos::common::VirtualIdentity::Root();
@@ -117,6 +228,7 @@ int main(int argc, char* argv[])
           } else {
             eos::common::Timing tm("Checksumming");
             COMMONTIMING("START", &tm);
+            uint64_t start_cycles = GetCycles();
             char*  ptr = buffer;
             off_t offset = 0;
 
@@ -127,17 +239,21 @@ int main(int argc, char* argv[])
             }
 
             checksum->Finalize();
+            uint64_t cycles = std::max<uint64_t>(1, GetCycles() - start_cycles);
             COMMONTIMING("STOP", &tm);
             XrdOucString sizestring;
             eos::common::StringConversion::GetReadableSizeString(sizestring, blocksize[bs],
                 "B");
-            eos_static_info("checksum( %-10s ) = %s realtime=%.02f [ms] blocksize=%s rate=%.02f",
+            eos_static_info("checksum( %-10s ) = %s realtime=%.02f [ms] blocksize=%s rate=%.02f bytes/cycle=%.03f",
                             checksumnames[i].c_str(), checksum->GetHexChecksum(), tm.RealTime(),
-                            sizestring.c_str(), MEMORYBUFFERSIZE / tm.RealTime() / 1000.0);
+                            sizestring.c_str(), MEMORYBUFFERSIZE / tm.RealTime() / 1000.0,
+                            1.0 * MEMORYBUFFERSIZE / cycles);
           }
         }
       }
 
+      BenchmarkCombinations(buffer);
+
       exit(0);
     }
   }
@@ -29,6 +29,7 @@
 #include <random>
 #include <thread>
 #include <chrono>
+#include <list>
 
 TEST(BufferManager, MatchingSizes)
 {
@@ -188,3 +189,64 @@ TEST(BufferManager, MultipleThreads)
     ASSERT_EQ(sorted_slots.rbegin()->first, slot);
   }
 }
+
+TEST(BufferManager, SmallBaseSize)
+{
+  using namespace eos::common;
+  eos::common::BufferManager buff_mgr(16 * KB, 1, 4 * KB);
+  auto buffer = buff_mgr.GetBuffer(4 * KB);
+  ASSERT_NE(buffer, nullptr);
+  ASSERT_EQ(buffer->mCapacity, 4 * KB);
+  ASSERT_EQ((uint64_t)buffer->GetDataPtr() % Buffer::sPageSize, 0);
+  buff_mgr.Recycle(buffer);
+  buffer = buff_mgr.GetBuffer(5 * KB);
+  ASSERT_NE(buffer, nullptr);
+  ASSERT_EQ(buffer->mCapacity, 8 * KB);
+  ASSERT_EQ(buff_mgr.GetBuffer(8 * KB + 1), nullptr);
+  buff_mgr.Recycle(buffer);
+  // Both buffers are cached and reused
+  ASSERT_EQ(buff_mgr.GetTotalSize(), 12 * KB);
+  buffer = buff_mgr.GetBuffer(1 * KB);
+  ASSERT_EQ(buff_mgr.GetTotalSize(), 12 * KB);
+  // Buffers not allocated by the buffer manager are ignored
+  buff_mgr.Recycle(std::make_shared<eos::common::Buffer>(6 * KB));
+  ASSERT_EQ(buff_mgr.GetTotalSize(), 12 * KB);
+}
+
+TEST(BufferManager, MultipleThreadsThroughput)
+{
+  using namespace eos::common;
+  eos::common::BufferManager buff_mgr(64 * MB, 2);
+  int num_ops = 20000;
+  uint32_t max_threads = std::max(4u, std::thread::hardware_concurrency());
+
+  for (uint32_t num_threads = 1; num_threads <= max_threads; num_threads *= 2) {
+    std::list<std::thread> lst_threads;
+    auto start = std::chrono::steady_clock::now();
+
+    for (uint32_t i = 0; i < num_threads; ++i) {
+      lst_threads.emplace_back([&buff_mgr, num_ops, i]() {
+        for (int j = 0; j < num_ops; ++j) {
+          auto buffer = buff_mgr.GetBuffer(((i + j) % 4 + 1) * MB);
+          ASSERT_NE(buffer, nullptr);
+          buffer->GetDataPtr()[0] = 'x';
+          buff_mgr.Recycle(buffer);
+        }
+      });
+    }
+
+    for (auto& job : lst_threads) {
+      job.join();
+    }
+
+    auto duration = std::chrono::duration_cast<std::chrono::microseconds>
+                    (std::chrono::steady_clock::now() - start).count();
+    std::cout << "threads=" << num_threads << " rate="
+              << (num_threads * num_ops * 1000ull) / (duration ? duration : 1)
+              << " kHz" << std::endl;
+    uint64_t total_size {0ull};
+    (void) buff_mgr.GetSortedSlotSizes(total_size);
+    ASSERT_EQ(total_size, buff_mgr.GetTotalSize());
+    ASSERT_LE(total_size, buff_mgr.GetMaxSize());
+  }
+}
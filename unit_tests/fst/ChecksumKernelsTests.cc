@@ -0,0 +1,334 @@
+//------------------------------------------------------------------------------
+// File: ChecksumKernelsTests.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2021 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "fst/checksum/ChecksumKernels.hh"
+#include "fst/checksum/ChecksumPlugins.hh"
+#include "common/crc32c/crc32c.h"
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <stdlib.h>
+#include <unistd.h>
+#include <vector>
+#include <zlib.h>
+
+using eos::common::LayoutId;
+using eos::fst::CheckSum;
+using eos::fst::ChecksumPlugins;
+
+namespace
+{
+//------------------------------------------------------------------------------
+//! Generate buffer with random data
+//------------------------------------------------------------------------------
+std::vector<char>
+MakeBuffer(size_t size, unsigned int seed)
+{
+  std::mt19937 gen(seed);
+  std::vector<char> buffer(size);
+
+  for (auto& elem : buffer) {
+    elem = static_cast<char>(gen());
+  }
+
+  return buffer;
+}
+
+//------------------------------------------------------------------------------
+//! Read the whole content of a file
+//------------------------------------------------------------------------------
+std::vector<char>
+ReadFile(const std::string& path)
+{
+  std::ifstream file(path, std::ios::binary);
+  return std::vector<char>((std::istreambuf_iterator<char>(file)),
+                           std::istreambuf_iterator<char>());
+}
+}
+
+//------------------------------------------------------------------------------
+// Vectorized kernels against the reference implementations for odd lengths,
+// offsets and chained updates
+//------------------------------------------------------------------------------
+TEST(ChecksumKernels, MatchReference)
+{
+  auto buffer = MakeBuffer(1024 * 1024 + 64, 1);
+
+  for (size_t len : {
+         0ul, 1ul, 7ul, 31ul, 32ul, 33ul, 383ul, 1000ul, 3072ul, 3073ul,
+         4096ul, 5552ul, 5600ul, 100000ul, 1024ul * 1024
+       }) {
+    for (size_t off : {
+           0ul, 1ul, 13ul
+         }) {
+      const char* ptr = buffer.data() + off;
+      ASSERT_EQ(adler32(1, (const Bytef*) ptr, len),
+                eos::fst::Adler32Update(1, ptr, len))
+          << "impl=" << eos::fst::GetChecksumKernelImplementation()
+          << " len=" << len << " off=" << off;
+      ASSERT_EQ(checksum::crc32cSlicingBy8(checksum::crc32cInit(), ptr, len),
+                eos::fst::Crc32cUpdate(checksum::crc32cInit(), ptr, len))
+          << "impl=" << eos::fst::GetChecksumKernelImplementation()
+          << " len=" << len << " off=" << off;
+    }
+  }
+
+  uint32_t adler = 1;
+  uint32_t crc = checksum::crc32cInit();
+
+  for (size_t pos = 0; pos < buffer.size(); pos += 777) {
+    size_t len = std::min<size_t>(777, buffer.size() - pos);
+    adler = eos::fst::Adler32Update(adler, buffer.data() + pos, len);
+    crc = eos::fst::Crc32cUpdate(crc, buffer.data() + pos, len);
+  }
+
+  ASSERT_EQ(adler32(1, (const Bytef*) buffer.data(), buffer.size()), adler);
+  ASSERT_EQ(checksum::crc32cSlicingBy8(checksum::crc32cInit(), buffer.data(),
+                                       buffer.size()), crc);
+}
+
+//------------------------------------------------------------------------------
+// The fused block and file checksum pass must give the same block map and
+// file checksum as the separate passes
+//------------------------------------------------------------------------------
+TEST(ChecksumKernels, FusedBlockSum)
+{
+  char tmp_dir[] = "/tmp/eos.fusedxs.XXXXXX";
+  ASSERT_NE(nullptr, mkdtemp(tmp_dir));
+  const size_t block_sz = 4096;
+  const size_t file_sz = 3 * 1024 * 1024 + 123;
+  auto buffer = MakeBuffer(file_sz, 2);
+  std::string sep_path = std::string(tmp_dir) + "/separate.xsmap";
+  std::string fused_path = std::string(tmp_dir) + "/fused.xsmap";
+  std::unique_ptr<CheckSum> sep_block {ChecksumPlugins::GetXsObj(LayoutId::kCRC32C)};
+  std::unique_ptr<CheckSum> fused_block {ChecksumPlugins::GetXsObj(LayoutId::kCRC32C)};
+
+  if (!sep_block->OpenMap(sep_path.c_str(), file_sz, block_sz, true) ||
+      !fused_block->OpenMap(fused_path.c_str(), file_sz, block_sz, true)) {
+    (void) unlink(sep_path.c_str());
+    (void) unlink(fused_path.c_str());
+    (void) rmdir(tmp_dir);
+    GTEST_SKIP() << "block checksum map can not be created in " << tmp_dir;
+  }
+
+  for (auto xs_type : {
+         LayoutId::kAdler, LayoutId::kCRC32C, LayoutId::kMD5
+       }) {
+    std::unique_ptr<CheckSum> sep_file {ChecksumPlugins::GetXsObj(xs_type)};
+    std::unique_ptr<CheckSum> fused_file {ChecksumPlugins::GetXsObj(xs_type)};
+    // Writes not aligned to the block size
+    const size_t write_sz = 1024 * 1024 + 1000;
+
+    for (size_t off = 0; off < file_sz; off += write_sz) {
+      size_t len = std::min(write_sz, file_sz - off);
+      ASSERT_TRUE(sep_block->AddBlockSum(off, buffer.data() + off, len));
+      sep_file->Add(buffer.data() + off, len, off);
+      ASSERT_TRUE(fused_block->AddBlockSum(off, buffer.data() + off, len,
+                                           fused_file.get()));
+    }
+
+    sep_file->Finalize();
+    fused_file->Finalize();
+    ASSERT_STREQ(sep_file->GetHexChecksum(), fused_file->GetHexChecksum());
+    ASSERT_EQ(sep_block->GetXSBlocksWritten(),
+              fused_block->GetXSBlocksWritten());
+    // Verification in one pass also updates the file checksum
+    std::unique_ptr<CheckSum> check_file {ChecksumPlugins::GetXsObj(xs_type)};
+    ASSERT_TRUE(fused_block->CheckBlockSum(0, buffer.data(), file_sz,
+                                           check_file.get()));
+    check_file->Finalize();
+    ASSERT_STREQ(sep_file->GetHexChecksum(), check_file->GetHexChecksum());
+    // A corrupted block is detected and the whole buffer is still added
+    auto corrupted = buffer;
+    corrupted[5 * block_sz + 7] ^= 0x1;
+    check_file.reset(ChecksumPlugins::GetXsObj(xs_type));
+    ASSERT_FALSE(fused_block->CheckBlockSum(0, corrupted.data(), file_sz,
+                                            check_file.get()));
+    check_file->Finalize();
+    ASSERT_STRNE(sep_file->GetHexChecksum(), check_file->GetHexChecksum());
+    ASSERT_EQ(check_file->GetLastOffset(), (off_t) file_sz);
+  }
+
+  ASSERT_TRUE(sep_block->CloseMap());
+  ASSERT_TRUE(fused_block->CloseMap());
+  ASSERT_EQ(ReadFile(sep_path), ReadFile(fused_path));
+  (void) unlink(sep_path.c_str());
+  (void) unlink(fused_path.c_str());
+  (void) rmdir(tmp_dir);
+}
+
+//------------------------------------------------------------------------------
+// The write scope only fuses the Oss block checksum with the file checksum of
+// the very same write
+//------------------------------------------------------------------------------
+TEST(ChecksumKernels, FusedWriteScope)
+{
+  char tmp_dir[] = "/tmp/eos.fusedwr.XXXXXX";
+  ASSERT_NE(nullptr, mkdtemp(tmp_dir));
+  const size_t block_sz = 4096;
+  const size_t file_sz = 1024 * 1024 + 17;
+  auto buffer = MakeBuffer(file_sz, 3);
+  std::string map_path = std::string(tmp_dir) + "/scope.xsmap";
+  std::unique_ptr<CheckSum> block_xs {ChecksumPlugins::GetXsObj(LayoutId::kCRC32C)};
+
+  if (!block_xs->OpenMap(map_path.c_str(), file_sz, block_sz, true)) {
+    (void) unlink(map_path.c_str());
+    (void) rmdir(tmp_dir);
+    GTEST_SKIP() << "block checksum map can not be created in " << tmp_dir;
+  }
+
+  XrdSysMutex mutex;
+  std::unique_ptr<CheckSum> ref_xs {ChecksumPlugins::GetXsObj(LayoutId::kAdler)};
+  std::unique_ptr<CheckSum> file_xs {ChecksumPlugins::GetXsObj(LayoutId::kAdler)};
+  ref_xs->Add(buffer.data(), file_sz, 0);
+  ref_xs->Finalize();
+  {
+    // A different write in the same thread is not fused
+    ChecksumPlugins::FusedWriteScope scope(file_xs.get(), &mutex, 0,
+                                           buffer.data(), file_sz);
+    ASSERT_TRUE(ChecksumPlugins::FusedWriteScope::AddBlockSum(block_xs.get(),
+                0, buffer.data(), file_sz - 1));
+    ASSERT_FALSE(scope.Used());
+    ASSERT_EQ(0, file_xs->GetLastOffset());
+  }
+  {
+    ChecksumPlugins::FusedWriteScope scope(file_xs.get(), &mutex, 0,
+                                           buffer.data(), file_sz);
+    ASSERT_TRUE(ChecksumPlugins::FusedWriteScope::AddBlockSum(block_xs.get(),
+                0, buffer.data(), file_sz));
+    ASSERT_TRUE(scope.Used());
+  }
+  file_xs->Finalize();
+  ASSERT_STREQ(ref_xs->GetHexChecksum(), file_xs->GetHexChecksum());
+  // Outside of a scope only the block checksum is computed
+  ChecksumPlugins::FusedWriteScope inactive(nullptr, &mutex, 0, buffer.data(),
+      file_sz);
+  ASSERT_TRUE(ChecksumPlugins::FusedWriteScope::AddBlockSum(block_xs.get(), 0,
+              buffer.data(), file_sz));
+  ASSERT_FALSE(inactive.Used());
+  ASSERT_TRUE(block_xs->CloseMap());
+  (void) unlink(map_path.c_str());
+  (void) rmdir(tmp_dir);
+}
+
+//------------------------------------------------------------------------------
+// Combined checksums of two pieces against the checksum of the concatenation
+//------------------------------------------------------------------------------
+TEST(ChecksumKernels, Combine)
+{
+  auto buffer = MakeBuffer(300000, 3);
+
+  for (size_t split : {
+         0ul, 1ul, 100ul, 4096ul, 123457ul, 299999ul, 300000ul
+       }) {
+    const char* second = buffer.data() + split;
+    size_t len2 = buffer.size() - split;
+    ASSERT_EQ(adler32(1, (const Bytef*) buffer.data(), buffer.size()),
+              eos::fst::Adler32Combine(eos::fst::Adler32Update(1, buffer.data(),
+                                       split), eos::fst::Adler32Update(1, second, len2), len2));
+    ASSERT_EQ(checksum::crc32c(0, buffer.data(), buffer.size()),
+              eos::fst::Crc32cCombine(checksum::crc32c(0, buffer.data(), split),
+                                      checksum::crc32c(0, second, len2), len2))
+        << "split=" << split;
+  }
+
+  // Shift by a length which does not fit in 32 bits
+  const uint64_t len2 = (1ull << 33) + 5;
+  uint32_t crc1 = checksum::crc32c(0, buffer.data(), 1000);
+  uint32_t shifted = eos::fst::Crc32cCombine(crc1, 0, len2);
+  ASSERT_EQ(eos::fst::Crc32cCombine(eos::fst::Crc32cCombine(crc1, 0, len2 - 5),
+                                    0, 5), shifted);
+}
+
+//------------------------------------------------------------------------------
+// File checksums built from pieces added out of order, resumed from a known
+// checksum or with overlapping pieces
+//------------------------------------------------------------------------------
+TEST(ChecksumKernels, OutOfOrder)
+{
+  const size_t file_sz = 2 * 1024 * 1024 + 77;
+  const size_t piece_sz = 64 * 1024 + 3;
+  auto buffer = MakeBuffer(file_sz, 4);
+  std::vector<size_t> offsets;
+
+  for (size_t off = 0; off < file_sz; off += piece_sz) {
+    offsets.push_back(off);
+  }
+
+  std::mt19937 gen(5);
+  std::shuffle(offsets.begin(), offsets.end(), gen);
+
+  for (auto xs_type : {
+         LayoutId::kAdler, LayoutId::kCRC32C
+       }) {
+    std::unique_ptr<CheckSum> ref {ChecksumPlugins::GetXsObj(xs_type)};
+    ASSERT_TRUE(ref->Add(buffer.data(), file_sz, 0));
+    ref->Finalize();
+    std::string ref_hex = ref->GetHexChecksum();
+    // Shuffled pieces
+    std::unique_ptr<CheckSum> xs {ChecksumPlugins::GetXsObj(xs_type)};
+    ASSERT_TRUE(xs->SupportsOutOfOrder());
+
+    for (auto off : offsets) {
+      size_t len = std::min(piece_sz, file_sz - off);
+      xs->Add(buffer.data() + off, len, off);
+    }
+
+    xs->Finalize();
+    ASSERT_FALSE(xs->NeedsRecalculation());
+    ASSERT_EQ((off_t) file_sz, xs->GetMaxOffset());
+    ASSERT_EQ(ref_hex, xs->GetHexChecksum());
+    // Missing piece
+    xs.reset(ChecksumPlugins::GetXsObj(xs_type));
+
+    for (size_t i = 1; i < offsets.size(); ++i) {
+      size_t len = std::min(piece_sz, file_sz - offsets[i]);
+      xs->Add(buffer.data() + offsets[i], len, offsets[i]);
+    }
+
+    xs->Finalize();
+    ASSERT_TRUE(xs->NeedsRecalculation());
+    // Overlapping pieces can not be combined
+    xs.reset(ChecksumPlugins::GetXsObj(xs_type));
+    xs->Add(buffer.data(), 1000, 0);
+    xs->Add(buffer.data() + 2000, file_sz - 2000, 2000);
+    xs->Add(buffer.data() + 500, 1500, 500);
+    xs->Finalize();
+    ASSERT_TRUE(xs->NeedsRecalculation());
+    // Resume from the checksum of the first part and append the rest
+    const size_t init_sz = 1024 * 1024 + 11;
+    std::unique_ptr<CheckSum> head {ChecksumPlugins::GetXsObj(xs_type)};
+    head->Add(buffer.data(), init_sz, 0);
+    head->Finalize();
+    xs.reset(ChecksumPlugins::GetXsObj(xs_type));
+    xs->ResetInit(0, init_sz, head->GetHexChecksum());
+    xs->Add(buffer.data() + init_sz + 4096, file_sz - init_sz - 4096,
+            init_sz + 4096);
+    xs->Add(buffer.data() + init_sz, 4096, init_sz);
+    xs->Finalize();
+    ASSERT_FALSE(xs->NeedsRecalculation());
+    ASSERT_EQ(ref_hex, xs->GetHexChecksum());
+  }
+}
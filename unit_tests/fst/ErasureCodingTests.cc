@@ -0,0 +1,282 @@
+//------------------------------------------------------------------------------
+// File: ErasureCodingTests.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2021 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "fst/layout/ErasureCoding.hh"
+#include "fst/layout/jerasure/include/jerasure.h"
+#include "fst/layout/jerasure/include/cauchy.h"
+#include "gtest/gtest.h"
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <future>
+#include <numeric>
+#include <random>
+#include <thread>
+#include <vector>
+
+using eos::fst::RecoverGroupsPipelined;
+using eos::fst::ReedSCodec;
+using eos::fst::XorRegions;
+
+namespace
+{
+//------------------------------------------------------------------------------
+//! Allocate and fill blocks with random data
+//------------------------------------------------------------------------------
+std::vector<std::vector<char>>
+MakeBlocks(unsigned int num, size_t size, unsigned int seed)
+{
+  std::mt19937 gen(seed);
+  std::vector<std::vector<char>> blocks(num, std::vector<char>(size));
+
+  for (auto& block : blocks) {
+    for (auto& elem : block) {
+      elem = static_cast<char>(gen());
+    }
+  }
+
+  return blocks;
+}
+
+//------------------------------------------------------------------------------
+//! Get raw pointers to the given range of blocks
+//------------------------------------------------------------------------------
+std::vector<char*>
+GetPtrs(std::vector<std::vector<char>>& blocks, unsigned int first,
+        unsigned int num)
+{
+  std::vector<char*> ptrs;
+
+  for (unsigned int i = first; i < first + num; ++i) {
+    ptrs.push_back(blocks[i].data());
+  }
+
+  return ptrs;
+}
+}
+
+//------------------------------------------------------------------------------
+// XorRegions against a byte by byte reference for odd lengths and offsets
+//------------------------------------------------------------------------------
+TEST(ErasureCoding, XorRegions)
+{
+  auto blocks = MakeBlocks(6, 4096 + 64, 1);
+
+  for (size_t len : {
+         0ul, 1ul, 7ul, 63ul, 129ul, 1000ul, 4096ul
+       }) {
+    for (size_t off : {
+           0ul, 1ul, 13ul
+         }) {
+      for (bool accumulate : {
+             false, true
+           }) {
+        std::vector<const char*> srcs;
+
+        for (unsigned int i = 1; i < blocks.size(); ++i) {
+          srcs.push_back(blocks[i].data() + off);
+        }
+
+        std::vector<char> expected(blocks[0].begin() + off,
+                                   blocks[0].begin() + off + len);
+
+        for (size_t pos = 0; pos < len; ++pos) {
+          char acc = (accumulate ? expected[pos] : 0);
+
+          for (auto src : srcs) {
+            acc ^= src[pos];
+          }
+
+          expected[pos] = acc;
+        }
+
+        std::vector<char> dst(blocks[0]);
+        XorRegions(dst.data() + off, srcs.data(), srcs.size(), len, accumulate);
+        ASSERT_EQ(0, memcmp(expected.data(), dst.data() + off, len))
+            << "impl=" << eos::fst::GetXorImplementation() << " len=" << len
+            << " off=" << off << " accumulate=" << accumulate;
+        // Nothing outside the region is touched
+        ASSERT_EQ(0, memcmp(dst.data() + off + len, blocks[0].data() + off + len,
+                            dst.size() - off - len));
+      }
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Encoding and decoding must be byte-identical to the Jerasure implementation
+//------------------------------------------------------------------------------
+TEST(ErasureCoding, ReedSolomonMatchesJerasure)
+{
+  const int w = 8;
+
+  for (auto km : std::vector<std::pair<int, int>> {{4, 2}, {6, 3}, {10, 4}}) {
+    int k = km.first;
+    int m = km.second;
+    // Same parameters as the ReedSLayout for 64KB stripes
+    size_t size = 64 * 1024;
+    size_t packet_size = (k * size) / (k * w * sizeof(int));
+    auto blocks = MakeBlocks(k + m, size, k);
+    auto ref_blocks = blocks;
+    auto codec = ReedSCodec::Get(k, m, w);
+    ASSERT_EQ(codec, ReedSCodec::Get(k, m, w));
+    std::vector<char*> data = GetPtrs(blocks, 0, k);
+    std::vector<char*> coding = GetPtrs(blocks, k, m);
+    codec->Encode(data.data(), coding.data(), size, packet_size);
+    // Reference encoding
+    int* matrix = cauchy_good_general_coding_matrix(k, m, w);
+    int* bitmatrix = jerasure_matrix_to_bitmatrix(k, m, w, matrix);
+    int** schedule = jerasure_smart_bitmatrix_to_schedule(k, m, w, bitmatrix);
+    std::vector<char*> ref_data = GetPtrs(ref_blocks, 0, k);
+    std::vector<char*> ref_coding = GetPtrs(ref_blocks, k, m);
+    jerasure_schedule_encode(k, m, w, schedule, ref_data.data(),
+                             ref_coding.data(), size, packet_size);
+
+    for (int i = 0; i < k + m; ++i) {
+      ASSERT_EQ(ref_blocks[i], blocks[i]) << "k=" << k << " m=" << m
+                                          << " block=" << i;
+    }
+
+    // Erase m blocks, mixing data and parity, and recover them
+    for (int first = 0; first + m <= k + m; first += m) {
+      std::vector<int> erasures;
+
+      for (int i = first; i < first + m; ++i) {
+        erasures.push_back(i);
+        memset(blocks[i].data(), 0, size);
+      }
+
+      erasures.push_back(-1);
+      ASSERT_TRUE(codec->Decode(erasures.data(), data.data(), coding.data(),
+                                size, packet_size));
+
+      for (int i = 0; i < k + m; ++i) {
+        ASSERT_EQ(ref_blocks[i], blocks[i]) << "k=" << k << " m=" << m
+                                            << " first_erasure=" << first
+                                            << " block=" << i;
+      }
+    }
+
+    jerasure_free_schedule(schedule);
+    free(bitmatrix);
+    free(matrix);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Groups are recovered in order while the reads of the groups in flight
+// complete in reverse order
+//------------------------------------------------------------------------------
+TEST(ErasureCoding, PipelinedRecoveryOutOfOrder)
+{
+  const size_t num_grps = 11;
+  const size_t window = 4;
+  std::vector<size_t> grps(num_grps);
+  std::iota(grps.begin(), grps.end(), 0);
+  std::vector<std::promise<bool>> reads(num_grps);
+  std::atomic<size_t> num_fetched {0};
+  std::atomic<size_t> num_recovered {0};
+  size_t max_in_flight = 0;
+  size_t num_drained = 0;
+  std::vector<size_t> recovered;
+  // Complete the reads of a window only once all of them are in flight
+  std::thread completer([&]() {
+    for (size_t start = 0; start < num_grps; start += window) {
+      size_t end = std::min(start + window, num_grps);
+
+      while (num_fetched < end) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+
+      for (size_t i = end; i > start; --i) {
+        reads[i - 1].set_value(true);
+      }
+    }
+  });
+  bool success = RecoverGroupsPipelined(grps.begin(), grps.end(), window,
+  [&](std::vector<size_t>::iterator it) {
+    ++num_fetched;
+    max_in_flight = std::max(max_in_flight, num_fetched - num_recovered);
+    return reads[*it].get_future().share();
+  }, [&](std::vector<size_t>::iterator it, std::shared_future<bool>& read) {
+    bool ok = read.get();
+    recovered.push_back(*it);
+    ++num_recovered;
+    return ok;
+  }, [&](std::shared_future<bool>&) {
+    ++num_drained;
+  });
+  completer.join();
+  ASSERT_TRUE(success);
+  ASSERT_EQ(grps, recovered);
+  ASSERT_EQ(num_grps, num_fetched);
+  ASSERT_EQ(window, max_in_flight);
+  ASSERT_EQ(0u, num_drained);
+}
+
+//------------------------------------------------------------------------------
+// A failed group stops the fetching, the groups already in flight are drained
+// and none of the following groups is recovered
+//------------------------------------------------------------------------------
+TEST(ErasureCoding, PipelinedRecoveryFailure)
+{
+  const size_t num_grps = 10;
+  const size_t window = 4;
+  const size_t failed_grp = 3;
+  std::vector<size_t> grps(num_grps);
+  std::iota(grps.begin(), grps.end(), 0);
+  std::vector<size_t> fetched;
+  std::vector<size_t> recovered;
+  std::vector<size_t> drained;
+  bool success = RecoverGroupsPipelined(grps.begin(), grps.end(), window,
+  [&](std::vector<size_t>::iterator it) {
+    fetched.push_back(*it);
+    return *it;
+  }, [&](std::vector<size_t>::iterator it, size_t& grp) {
+    EXPECT_EQ(*it, grp);
+    recovered.push_back(grp);
+    return (grp != failed_grp);
+  }, [&](size_t& grp) {
+    drained.push_back(grp);
+  });
+  ASSERT_FALSE(success);
+  ASSERT_EQ(std::vector<size_t>({0, 1, 2, 3, 4, 5, 6}), fetched);
+  ASSERT_EQ(std::vector<size_t>({0, 1, 2, 3}), recovered);
+  ASSERT_EQ(std::vector<size_t>({4, 5, 6}), drained);
+  // Failure of the last group in flight leaves nothing to drain
+  fetched.clear();
+  recovered.clear();
+  drained.clear();
+  success = RecoverGroupsPipelined(grps.begin(), grps.begin() + failed_grp + 1,
+  window, [&](std::vector<size_t>::iterator it) {
+    fetched.push_back(*it);
+    return *it;
+  }, [&](std::vector<size_t>::iterator, size_t& grp) {
+    recovered.push_back(grp);
+    return (grp != failed_grp);
+  }, [&](size_t& grp) {
+    drained.push_back(grp);
+  });
+  ASSERT_FALSE(success);
+  ASSERT_EQ(fetched, recovered);
+  ASSERT_TRUE(drained.empty());
+}
@@ -0,0 +1,86 @@
+//------------------------------------------------------------------------------
+// File: LoadTest.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2021 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "gtest/gtest.h"
+#define IN_TEST_HARNESS
+#include "fst/Load.hh"
+#undef IN_TEST_HARNESS
+#include <fstream>
+#include <stdlib.h>
+#include <unistd.h>
+
+using eos::fst::SysStat;
+
+TEST(SysStatTest, ParseSockstat)
+{
+  unsigned long long sockets = 0;
+  ASSERT_TRUE(SysStat::ParseSockstat("sockets: used 571\n"
+                                     "TCP: inuse 27 orphan 1 tw 3 alloc 31 mem 2\n"
+                                     "UDP: inuse 4 mem 1\n", sockets));
+  ASSERT_EQ(30ull, sockets);
+  ASSERT_TRUE(SysStat::ParseSockstat("TCP: inuse 100000 orphan 0 tw 0 alloc 1 "
+                                     "mem 2\n", sockets));
+  ASSERT_EQ(100000ull, sockets);
+  ASSERT_FALSE(SysStat::ParseSockstat("sockets: used 571\nUDP: inuse 4\n",
+                                      sockets));
+}
+
+TEST(SysStatTest, ParseDefaultRoute)
+{
+  const std::string routes =
+    "Iface\tDestination\tGateway \tFlags\tRefCnt\tUse\tMetric\tMask\n"
+    "eth1\t0010A8C0\t00000000\t0001\t0\t0\t0\t00FFFFFF\n"
+    "eth0\t00000000\t0100A8C0\t0003\t0\t0\t100\t00000000\n";
+  ASSERT_EQ("eth0", SysStat::ParseDefaultRoute(routes));
+  ASSERT_EQ("", SysStat::ParseDefaultRoute(routes.substr(0,
+            routes.find("eth0"))));
+}
+
+TEST(SysStatTest, FormatUptime)
+{
+  const double load[3] = {0.5, 1.25, 12.0};
+  std::string uptime = SysStat::FormatUptime(0, 3 * 86400 + 2 * 3600 + 3 * 60,
+                       2, load);
+  ASSERT_NE(std::string::npos, uptime.find(" up 3 days,  2:03,  2 users,  "
+                                           "load average: 0.50, 1.25, 12.00"));
+  uptime = SysStat::FormatUptime(0, 86400 + 59, 1, load);
+  ASSERT_NE(std::string::npos, uptime.find(" up 1 day, 0 min,  1 user,"));
+}
+
+TEST(SysStatTest, ReadFile)
+{
+  char tmp_path[] = "/tmp/eos.sysstat.XXXXXX";
+  int fd = mkstemp(tmp_path);
+  ASSERT_NE(-1, fd);
+  ASSERT_EQ(0, close(fd));
+  // Content larger than the initial buffer capacity
+  std::string content(10000, 'x');
+  std::ofstream(tmp_path) << content;
+  std::string buffer;
+  ASSERT_TRUE(SysStat::ReadFile(tmp_path, buffer));
+  ASSERT_EQ(content, buffer);
+  std::ofstream(tmp_path) << "short";
+  ASSERT_TRUE(SysStat::ReadFile(tmp_path, buffer));
+  ASSERT_EQ("short", buffer);
+  ASSERT_EQ(0, unlink(tmp_path));
+  ASSERT_FALSE(SysStat::ReadFile(tmp_path, buffer));
+}
@@ -0,0 +1,231 @@
+//------------------------------------------------------------------------------
+// File: UringQueueTests.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2021 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "fst/io/local/UringQueue.hh"
+#include "gtest/gtest.h"
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using eos::fst::UringQueue;
+
+namespace
+{
+//------------------------------------------------------------------------------
+//! Fixture providing a temporary file opened for reading and writing
+//------------------------------------------------------------------------------
+class UringQueueTest : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    char path[] = "/tmp/eos_uring_test_XXXXXX";
+    mFd = mkstemp(path);
+    ASSERT_NE(-1, mFd);
+    mPath = path;
+  }
+
+  void TearDown() override
+  {
+    if (mFd != -1) {
+      (void) close(mFd);
+      (void) unlink(mPath.c_str());
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  //! Write and read back blocks of data through the given queue
+  //----------------------------------------------------------------------------
+  void WriteAndReadBack(UringQueue& queue)
+  {
+    const uint32_t block_sz = 4096;
+    const uint32_t num_blocks = 64;
+    std::vector<char> wr_buff(block_sz * num_blocks);
+
+    for (size_t i = 0; i < wr_buff.size(); ++i) {
+      wr_buff[i] = static_cast<char>(i % 251);
+    }
+
+    // Blocks are submitted as one batch, in reverse offset order
+    std::atomic<uint32_t> num_done {0};
+    std::atomic<int64_t> num_bytes {0};
+    std::vector<UringQueue::Request> batch;
+
+    for (uint32_t i = num_blocks; i > 0; --i) {
+      batch.push_back(UringQueue::Request{
+        true, mFd, wr_buff.data() + (i - 1) * block_sz, block_sz,
+        static_cast<off_t>((i - 1) * block_sz),
+        [&](int64_t retc) {
+          num_bytes += retc;
+          ++num_done;
+        }
+      });
+    }
+
+    queue.Submit(batch);
+
+    while (num_done < num_blocks) {
+      std::this_thread::yield();
+    }
+
+    ASSERT_EQ(wr_buff.size(), num_bytes);
+    std::vector<char> rd_buff(wr_buff.size());
+    std::vector<std::future<int64_t>> futures;
+
+    for (uint32_t i = 0; i < num_blocks; ++i) {
+      futures.push_back(queue.Read(mFd, rd_buff.data() + i * block_sz, block_sz,
+                                   i * block_sz));
+    }
+
+    for (auto& fut : futures) {
+      ASSERT_EQ(block_sz, fut.get());
+    }
+
+    ASSERT_EQ(0, memcmp(wr_buff.data(), rd_buff.data(), wr_buff.size()));
+  }
+
+  int mFd {-1};
+  std::string mPath;
+};
+}
+
+//------------------------------------------------------------------------------
+// Synchronous fallback when io_uring is not used
+//------------------------------------------------------------------------------
+TEST_F(UringQueueTest, FallbackSync)
+{
+  UringQueue queue(8, false);
+  ASSERT_FALSE(queue.IsAvailable());
+  // There are no registered buffers without a ring
+  char* fixed_buff = nullptr;
+  ASSERT_EQ(-1, queue.AcquireFixedBuffer(4096, fixed_buff));
+  ASSERT_EQ(nullptr, fixed_buff);
+  // The callback runs in the caller's thread before Submit returns
+  std::thread::id cb_thread;
+  bool done = false;
+  char data[] = "fallback";
+  queue.Submit(UringQueue::Request{true, mFd, data, sizeof(data), 0,
+                                   [&](int64_t retc) {
+                                     ASSERT_EQ((int64_t) sizeof(data), retc);
+                                     cb_thread = std::this_thread::get_id();
+                                     done = true;
+                                   }
+                                  });
+  ASSERT_TRUE(done);
+  ASSERT_EQ(std::this_thread::get_id(), cb_thread);
+  ASSERT_EQ(0u, queue.GetNumSubmitCalls());
+  ASSERT_EQ(0u, queue.GetInFlight());
+  WriteAndReadBack(queue);
+}
+
+//------------------------------------------------------------------------------
+// Batched requests through the ring, or the fallback if it can't be set up
+//------------------------------------------------------------------------------
+TEST_F(UringQueueTest, BatchWriteRead)
+{
+  UringQueue queue(16);
+  WriteAndReadBack(queue);
+  ASSERT_EQ(0u, queue.GetInFlight());
+
+  if (queue.IsAvailable()) {
+    // More requests than ring slots, each batch needs at least one submit
+    ASSERT_GE(queue.GetNumSubmitCalls(), 64u / 16u);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Short read at the end of the file and failed requests
+//------------------------------------------------------------------------------
+TEST_F(UringQueueTest, ShortReadAndErrors)
+{
+  for (bool use_uring : {
+         false, true
+       }) {
+    UringQueue queue(8, use_uring);
+    char data[100];
+    memset(data, 'a', sizeof(data));
+    ASSERT_EQ(100, queue.Write(mFd, data, sizeof(data), 0).get());
+    char buff[4096];
+    ASSERT_EQ(100, queue.Read(mFd, buff, sizeof(buff), 0).get());
+    ASSERT_EQ(0, queue.Read(mFd, buff, sizeof(buff), 1000).get());
+    ASSERT_EQ(-EBADF, queue.Read(-1, buff, sizeof(buff), 0).get());
+    ASSERT_EQ(-EBADF, queue.Write(-1, data, sizeof(data), 0).get());
+  }
+}
+
+//------------------------------------------------------------------------------
+// Requests staged in the registered buffers
+//------------------------------------------------------------------------------
+TEST_F(UringQueueTest, FixedBuffers)
+{
+  UringQueue queue(8);
+  char* fixed_buff = nullptr;
+  int index = queue.AcquireFixedBuffer(UringQueue::kFixedBufferSize + 1,
+                                       fixed_buff);
+  ASSERT_EQ(-1, index);
+  index = queue.AcquireFixedBuffer(4096, fixed_buff);
+
+  if (index == -1) {
+    GTEST_SKIP() << "no io_uring buffers registered";
+  }
+
+  memset(fixed_buff, 'x', 4096);
+  std::atomic<int64_t> result {-1};
+  queue.Submit(UringQueue::Request{true, mFd, fixed_buff, 4096, 0,
+                                   [&](int64_t retc) {
+                                     result = retc;
+                                   }, index
+                                  });
+
+  while (result == -1) {
+    std::this_thread::yield();
+  }
+
+  ASSERT_EQ(4096, result);
+  char buff[4096];
+  ASSERT_EQ(4096, pread(mFd, buff, sizeof(buff), 0));
+  ASSERT_EQ(0, memcmp(buff, std::string(4096, 'x').c_str(), sizeof(buff)));
+
+  // The buffer is given back once the request completed, wait for the
+  // in-flight counter which drops after the release
+  while (queue.GetInFlight()) {
+    std::this_thread::yield();
+  }
+
+  std::vector<int> indices;
+
+  for (uint32_t i = 0; i < UringQueue::kNumFixedBuffers; ++i) {
+    indices.push_back(queue.AcquireFixedBuffer(4096, fixed_buff));
+    ASSERT_NE(-1, indices.back());
+  }
+
+  ASSERT_EQ(-1, queue.AcquireFixedBuffer(4096, fixed_buff));
+
+  for (auto idx : indices) {
+    queue.ReleaseFixedBuffer(idx);
+  }
+}
@@ -59,6 +59,91 @@ TEST(Access, SetRule)
   ASSERT_EQ(old_stall.mIsGlobal, Access::gStallGlobal);
 }
 
+//------------------------------------------------------------------------------
+// Test compilation of the rate stall rules
+//------------------------------------------------------------------------------
+TEST(Access, CompileRateLimitRules)
+{
+  using namespace eos::mgm;
+  Access::StallInfo old_stall;
+  Access::SetStallRule(Access::StallInfo("rate:user:*:OpenRead", "100",
+                                         "all users"), old_stall);
+  Access::SetStallRule(Access::StallInfo("rate:user:1001:Stat", "10",
+                                         "user 1001"), old_stall);
+  Access::SetStallRule(Access::StallInfo("rate:user:10012:Stat", "20"),
+                       old_stall);
+  Access::SetStallRule(Access::StallInfo("rate:group:2001:Eosxd::ext::LS",
+                                         "5"), old_stall);
+  auto state = Access::GetStallState();
+  const auto& rules = state->mRateRules;
+  // Exact user match, no prefix matching of 10012. The rules are evaluated
+  // in gStallRules order, the wildcard comes first.
+  auto applicable = rules.GetRules(1001, 100);
+  ASSERT_EQ(2u, applicable.size());
+  ASSERT_EQ("OpenRead", applicable[0]->mCmd);
+  ASSERT_EQ("Stall::OpenRead", applicable[0]->mStallId);
+  ASSERT_TRUE(applicable[0]->mIsUser);
+  ASSERT_TRUE(applicable[0]->mIsWildcard);
+  ASSERT_EQ("Stat", applicable[1]->mCmd);
+  ASSERT_STREQ("user 1001", applicable[1]->mComment.c_str());
+  ASSERT_DOUBLE_EQ(10 * 1.33, applicable[1]->mCutoff);
+  // Group rules are evaluated before user ones as in gStallRules order
+  applicable = rules.GetRules(1002, 2001);
+  ASSERT_EQ(2u, applicable.size());
+  ASSERT_FALSE(applicable[0]->mIsUser);
+  ASSERT_TRUE(applicable[0]->mIsEosxd);
+  ASSERT_EQ("Eosxd::ext::LS", applicable[0]->mCmd);
+  // Rules are also indexed by the tag they limit
+  ASSERT_EQ(2u, rules.mByCmd.at("Stat").size());
+  // Removing the rules drops them from the compiled form
+  Access::RemoveStallRule("rate:user:*:OpenRead");
+  Access::RemoveStallRule("rate:user:1001:Stat");
+  Access::RemoveStallRule("rate:user:10012:Stat");
+  Access::RemoveStallRule("rate:group:2001:Eosxd::ext::LS");
+  ASSERT_TRUE(Access::GetStallState()->mRateRules.GetRules(1001,
+              2001).empty());
+  // The state read by ShouldStall follows the banned users
+  {
+    eos::common::RWMutexWriteLock wr_lock(Access::gAccessMutex);
+    Access::gBannedUsers.insert(1003);
+    Access::CompileStallState();
+  }
+  ASSERT_EQ(1u, Access::GetStallState()->mBannedUsers.count(1003));
+  Access::Reset();
+  ASSERT_TRUE(Access::GetStallState()->mBannedUsers.empty());
+}
+
+//------------------------------------------------------------------------------
+// Test the token buckets of the rate stall rules
+//------------------------------------------------------------------------------
+TEST(Access, RateLimitBuckets)
+{
+  using namespace eos::mgm;
+  Access::StallInfo old_stall;
+  Access::SetStallRule(Access::StallInfo("rate:user:*:OpenRead", "100"),
+                       old_stall);
+  auto state = Access::GetStallState();
+  const auto& rule = *state->mRateRules.mByCmd.at("OpenRead").front();
+  const int64_t now = Access::RateClockNs();
+  // A burst of 5 seconds worth of requests is absorbed
+  rule.Charge(1001, 5 * 133, now);
+  ASSERT_FALSE(rule.Exceeded(1001, now));
+  // Other users have their own bucket
+  rule.Charge(1001, 100, now);
+  ASSERT_TRUE(rule.Exceeded(1001, now));
+  ASSERT_FALSE(rule.Exceeded(1002, now));
+  // The bucket drains at the rate, the debt is capped at one more window
+  rule.Charge(1001, 1000000, now);
+  ASSERT_TRUE(rule.Exceeded(1001, now + 4000000000ll));
+  ASSERT_FALSE(rule.Exceeded(1001, now + 5000000001ll));
+  // Requests accounted through the statistics go to the matching rules
+  Access::ChargeRateLimits("OpenRead", 1004, 100, 1000);
+  ASSERT_TRUE(rule.Exceeded(1004, Access::RateClockNs()));
+  Access::ChargeRateLimits("OpenWrite", 1005, 100, 1000);
+  ASSERT_FALSE(rule.Exceeded(1005, Access::RateClockNs()));
+  Access::RemoveStallRule("rate:user:*:OpenRead");
+}
+
 IContainerMDPtr makeContainer(uid_t uid, gid_t gid, int mode)
 {
   IContainerMDPtr cont(new eos::QuarkContainerMD());